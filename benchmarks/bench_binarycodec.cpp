@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2012, 2013 Aldebaran Robotics. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the COPYING file.
+ */
+
+/*
+ * Serialization throughput: encodeBinary/decodeBinary of typical payloads
+ * (integer vectors of several sizes, a string, a string-keyed map).
+ */
+
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <boost/program_options.hpp>
+
+#include <qi/anyvalue.hpp>
+#include <qi/binarycodec.hpp>
+#include <qi/buffer.hpp>
+#include <qi/perf/dataperfsuite.hpp>
+
+namespace po = boost::program_options;
+
+namespace
+{
+  template<typename T>
+  void benchCodec(qi::DataPerfSuite& out, const std::string& name,
+                  const T& payload, unsigned long loopCount)
+  {
+    qi::DataPerf dp;
+
+    // Encoded size, to report throughput in MB/s.
+    qi::Buffer sized;
+    qi::encodeBinary(&sized, payload);
+    const unsigned long msgSize = static_cast<unsigned long>(sized.totalSize());
+
+    dp.start(name + "_encode", loopCount, msgSize);
+    for (unsigned long i = 0; i < loopCount; ++i)
+    {
+      qi::Buffer buf;
+      qi::encodeBinary(&buf, payload);
+    }
+    dp.stop();
+    out << dp;
+
+    dp.start(name + "_decode", loopCount, msgSize);
+    for (unsigned long i = 0; i < loopCount; ++i)
+    {
+      qi::BufferReader reader(sized);
+      T value;
+      qi::decodeBinary(&reader, &value);
+    }
+    dp.stop();
+    out << dp;
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  po::options_description desc;
+  desc.add_options()
+    ("help,h", "Print this help.");
+  desc.add(qi::detail::getPerfOptions());
+
+  po::variables_map vm;
+  po::store(po::command_line_parser(argc, argv).options(desc).run(), vm);
+  po::notify(vm);
+
+  if (vm.count("help")) {
+    std::cout << desc << std::endl;
+    return EXIT_SUCCESS;
+  }
+
+  qi::DataPerfSuite out("qi", "bench_binarycodec",
+                        qi::DataPerfSuite::OutputData_MsgMBPerSecond,
+                        vm["output"].as<std::string>());
+
+  std::vector<int> smallVector(10, 42);
+  std::vector<int> bigVector(100000, 42);
+  std::string text(1024, 'x');
+  std::map<std::string, double> table;
+  for (int i = 0; i < 100; ++i)
+    table["key_" + std::to_string(i)] = i * 0.5;
+
+  benchCodec(out, "vector_int_10", smallVector, 200000);
+  benchCodec(out, "vector_int_100k", bigVector, 500);
+  benchCodec(out, "string_1k", text, 200000);
+  benchCodec(out, "map_string_double_100", table, 10000);
+
+  out.close();
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2012, 2013 Aldebaran Robotics. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the COPYING file.
+ */
+
+/*
+ * Future continuation cost: build an andThen chain of a given depth with
+ * synchronous callbacks, fulfill the promise and wait for the tail.
+ * Synchronous callbacks keep the event loop out of the measurement.
+ */
+
+#include <iostream>
+#include <string>
+
+#include <boost/program_options.hpp>
+
+#include <qi/future.hpp>
+#include <qi/perf/dataperfsuite.hpp>
+
+namespace po = boost::program_options;
+
+namespace
+{
+  void benchChain(qi::DataPerfSuite& out, unsigned int depth,
+                  unsigned long loopCount)
+  {
+    qi::DataPerf dp;
+    dp.start("future_andthen_chain_" + std::to_string(depth), loopCount);
+    for (unsigned long i = 0; i < loopCount; ++i)
+    {
+      qi::Promise<int> promise;
+      qi::Future<int> future = promise.future();
+      for (unsigned int d = 0; d < depth; ++d)
+        future = future.andThen(qi::FutureCallbackType_Sync,
+                                [](int v) { return v + 1; });
+      promise.setValue(0);
+      future.wait();
+    }
+    dp.stop();
+    out << dp;
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  po::options_description desc;
+  desc.add_options()
+    ("help,h", "Print this help.");
+  desc.add(qi::detail::getPerfOptions());
+
+  po::variables_map vm;
+  po::store(po::command_line_parser(argc, argv).options(desc).run(), vm);
+  po::notify(vm);
+
+  if (vm.count("help")) {
+    std::cout << desc << std::endl;
+    return EXIT_SUCCESS;
+  }
+
+  qi::DataPerfSuite out("qi", "bench_future",
+                        qi::DataPerfSuite::OutputData_Period,
+                        vm["output"].as<std::string>());
+
+  benchChain(out, 1, 500000);
+  benchChain(out, 8, 100000);
+  benchChain(out, 32, 20000);
+
+  out.close();
+  return EXIT_SUCCESS;
+}
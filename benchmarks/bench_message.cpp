@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2012, 2013 Aldebaran Robotics. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the COPYING file.
+ */
+
+/*
+ * Message round trip over loopback: a standalone session serves an echo
+ * method, a second session connects over TCP and calls it with payloads of
+ * several sizes. Per-call samples feed the DataPerf histogram so the tail
+ * (p99) is reported next to the mean.
+ */
+
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+#include <boost/program_options.hpp>
+
+#include <qi/anyobject.hpp>
+#include <qi/application.hpp>
+#include <qi/perf/dataperfsuite.hpp>
+#include <qi/session.hpp>
+#include <qi/type/dynamicobjectbuilder.hpp>
+
+namespace po = boost::program_options;
+
+namespace
+{
+  std::string echo(const std::string& payload)
+  {
+    return payload;
+  }
+
+  void benchRoundTrip(qi::DataPerfSuite& out, qi::AnyObject service,
+                      unsigned long payloadSize, unsigned long loopCount)
+  {
+    const std::string payload(payloadSize, 'x');
+    qi::DataPerf dp;
+    dp.setWarmupCount(loopCount / 10);
+    dp.start("message_roundtrip_" + std::to_string(payloadSize),
+             loopCount, payloadSize);
+    for (unsigned long i = 0; i < loopCount; ++i)
+    {
+      service.call<std::string>("echo", payload);
+      dp.recordSample();
+    }
+    dp.stop();
+    out << dp;
+    std::cout << "  p50: " << std::fixed << std::setprecision(0)
+              << dp.getPercentile(50) << " us, p99: "
+              << dp.getPercentile(99) << " us, max: "
+              << dp.getMaxSample() << " us" << std::endl;
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  qi::Application app(argc, argv);
+
+  po::options_description desc;
+  desc.add_options()
+    ("help,h", "Print this help.");
+  desc.add(qi::detail::getPerfOptions());
+
+  po::variables_map vm;
+  po::store(po::command_line_parser(argc, argv).options(desc).run(), vm);
+  po::notify(vm);
+
+  if (vm.count("help")) {
+    std::cout << desc << std::endl;
+    return EXIT_SUCCESS;
+  }
+
+  qi::DataPerfSuite out("qi", "bench_message",
+                        qi::DataPerfSuite::OutputData_MsgMBPerSecond,
+                        vm["output"].as<std::string>());
+
+  qi::Session server;
+  server.listenStandalone("tcp://127.0.0.1:0").wait();
+
+  qi::DynamicObjectBuilder builder;
+  builder.advertiseMethod("echo", &echo);
+  server.registerService("BenchEcho", builder.object()).wait();
+
+  qi::Session client;
+  client.connect(server.endpoints()[0]).wait();
+  qi::AnyObject service = client.service("BenchEcho").value();
+
+  benchRoundTrip(out, service, 4, 20000);
+  benchRoundTrip(out, service, 4096, 20000);
+  benchRoundTrip(out, service, 1048576, 1000);
+
+  client.close();
+  server.close();
+  out.close();
+  return EXIT_SUCCESS;
+}
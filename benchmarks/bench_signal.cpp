@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2012, 2013 Aldebaran Robotics. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the COPYING file.
+ */
+
+/*
+ * Signal emission cost: trigger with a varying number of synchronous
+ * subscribers. Subscribers are connected with MetaCallType_Direct so the
+ * benchmark measures the emission path itself, not the event loop.
+ */
+
+#include <iostream>
+#include <string>
+
+#include <boost/program_options.hpp>
+
+#include <qi/perf/dataperfsuite.hpp>
+#include <qi/signal.hpp>
+
+namespace po = boost::program_options;
+
+namespace
+{
+  void benchTrigger(qi::DataPerfSuite& out, unsigned int subscriberCount,
+                    unsigned long loopCount)
+  {
+    qi::Signal<int> signal;
+    // volatile: keep the callback from being optimized to nothing.
+    static volatile int sink = 0;
+    for (unsigned int i = 0; i < subscriberCount; ++i)
+      signal.connect([](int v) { sink += v; }).setCallType(qi::MetaCallType_Direct);
+
+    qi::DataPerf dp;
+    dp.start("signal_trigger_" + std::to_string(subscriberCount) + "_direct",
+             loopCount);
+    for (unsigned long i = 0; i < loopCount; ++i)
+      signal(static_cast<int>(i));
+    dp.stop();
+    out << dp;
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  po::options_description desc;
+  desc.add_options()
+    ("help,h", "Print this help.");
+  desc.add(qi::detail::getPerfOptions());
+
+  po::variables_map vm;
+  po::store(po::command_line_parser(argc, argv).options(desc).run(), vm);
+  po::notify(vm);
+
+  if (vm.count("help")) {
+    std::cout << desc << std::endl;
+    return EXIT_SUCCESS;
+  }
+
+  qi::DataPerfSuite out("qi", "bench_signal",
+                        qi::DataPerfSuite::OutputData_Period,
+                        vm["output"].as<std::string>());
+
+  benchTrigger(out, 0, 2000000);
+  benchTrigger(out, 1, 1000000);
+  benchTrigger(out, 4, 500000);
+  benchTrigger(out, 16, 200000);
+
+  out.close();
+  return EXIT_SUCCESS;
+}
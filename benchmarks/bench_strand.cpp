@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2012, 2013 Aldebaran Robotics. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the COPYING file.
+ */
+
+/*
+ * Strand post throughput: enqueue a burst of small tasks on one strand and
+ * wait for the last one to run. Tasks are serialized by the strand, so this
+ * measures queueing plus ordered execution, the pattern used by actors.
+ */
+
+#include <atomic>
+#include <iostream>
+#include <string>
+
+#include <boost/program_options.hpp>
+
+#include <qi/application.hpp>
+#include <qi/future.hpp>
+#include <qi/perf/dataperfsuite.hpp>
+#include <qi/strand.hpp>
+
+namespace po = boost::program_options;
+
+namespace
+{
+  void benchPost(qi::DataPerfSuite& out, unsigned long taskCount,
+                 unsigned long runCount)
+  {
+    qi::DataPerf dp;
+    dp.start("strand_post_burst_" + std::to_string(taskCount),
+             taskCount * runCount);
+    for (unsigned long run = 0; run < runCount; ++run)
+    {
+      qi::Strand strand;
+      std::atomic<unsigned long> counter(0);
+      qi::Promise<void> done;
+      for (unsigned long i = 0; i < taskCount; ++i)
+        strand.post([&] { ++counter; });
+      // The strand runs tasks in order: this one runs after the burst.
+      strand.post([&] { done.setValue(0); });
+      done.future().wait();
+    }
+    dp.stop();
+    out << dp;
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  qi::Application app(argc, argv);
+
+  po::options_description desc;
+  desc.add_options()
+    ("help,h", "Print this help.");
+  desc.add(qi::detail::getPerfOptions());
+
+  po::variables_map vm;
+  po::store(po::command_line_parser(argc, argv).options(desc).run(), vm);
+  po::notify(vm);
+
+  if (vm.count("help")) {
+    std::cout << desc << std::endl;
+    return EXIT_SUCCESS;
+  }
+
+  qi::DataPerfSuite out("qi", "bench_strand",
+                        qi::DataPerfSuite::OutputData_Period,
+                        vm["output"].as<std::string>());
+
+  benchPost(out, 1000, 200);
+  benchPost(out, 100000, 5);
+
+  out.close();
+  return EXIT_SUCCESS;
+}
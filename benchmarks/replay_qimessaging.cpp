@@ -0,0 +1,313 @@
+/*
+ * Copyright (c) 2026 Softbank Robotics. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the COPYING file.
+ */
+
+/*
+ * Replays a message capture written by a process run with
+ * QI_MESSAGE_CAPTURE (see src/messaging/messagecapture.hpp), so a traffic
+ * pattern seen in production can be re-run in the lab as a benchmark.
+ *
+ * --mode dispatch (the default) rebuilds the received messages and feeds
+ * them through a MessageDispatcher with no-op handlers, measuring the
+ * dispatch path through DataPerf like the other benchmarks. --mode server
+ * writes the sent side of one captured socket, raw, to a live endpoint;
+ * this needs the capture to hold full payloads (QI_MESSAGE_CAPTURE_PAYLOAD_BYTES
+ * large enough, sampling at 1), and the target to accept the captured
+ * session as-is (e.g. no authentication).
+ *
+ * --speed divides the captured pacing (1: as captured, 2: twice as fast,
+ * 0: as fast as possible).
+ */
+
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <boost/asio.hpp>
+#include <boost/optional.hpp>
+#include <boost/program_options.hpp>
+
+#include <qi/application.hpp>
+#include <qi/buffer.hpp>
+#include <qi/clock.hpp>
+#include <qi/os.hpp>
+#include <qi/perf/dataperfsuite.hpp>
+#include <qi/url.hpp>
+
+#include "../src/messaging/messagecapture.hpp"
+#include "../src/messaging/messagedispatcher.hpp"
+
+namespace po = boost::program_options;
+
+namespace
+{
+  struct Record
+  {
+    qi::MessageCapture::RecordHeader info;
+    qi::Message::Header header;
+    std::vector<char> payload; ///< Stored bytes only, maybe truncated.
+  };
+
+  std::vector<Record> loadCapture(const std::string& path)
+  {
+    std::ifstream file(path.c_str(), std::ios::binary);
+    if (!file)
+      throw std::runtime_error("cannot open capture file " + path);
+    char magic[sizeof(qi::MessageCapture::magic)];
+    file.read(magic, sizeof(magic));
+    if (!file ||
+        std::memcmp(magic, qi::MessageCapture::magic, sizeof(magic)) != 0)
+      throw std::runtime_error(path + " is not a message capture file");
+
+    std::vector<Record> records;
+    for (;;)
+    {
+      Record record;
+      file.read(reinterpret_cast<char*>(&record.info), sizeof(record.info));
+      if (!file)
+        break; // Regular end of capture.
+      file.read(reinterpret_cast<char*>(&record.header), sizeof(record.header));
+      record.payload.resize(record.info.payloadBytes);
+      if (!record.payload.empty())
+        file.read(record.payload.data(), record.payload.size());
+      if (!file)
+      { // The writer flushes by blocks, so a crashed capture can end
+        // mid-record: keep what is complete.
+        std::cerr << "warning: capture ends mid-record, last one dropped"
+                  << std::endl;
+        break;
+      }
+      records.push_back(std::move(record));
+    }
+    return records;
+  }
+
+  /// Sleeps so that each record is replayed at its captured offset from the
+  /// first one, divided by `speed`. No-op when speed is 0.
+  class Pacer
+  {
+  public:
+    Pacer(int64_t firstTimestampUs, double speed)
+      : _start(qi::SteadyClock::now())
+      , _firstUs(firstTimestampUs)
+      , _speed(speed)
+    {
+    }
+    void waitFor(int64_t timestampUs)
+    {
+      if (_speed <= 0)
+        return;
+      const int64_t dueUs =
+          static_cast<int64_t>((timestampUs - _firstUs) / _speed);
+      qi::sleepUntil(_start + qi::MicroSeconds(dueUs));
+    }
+  private:
+    const qi::SteadyClockTimePoint _start;
+    const int64_t _firstUs;
+    const double _speed;
+  };
+
+  bool matchesSocket(const Record& record, unsigned int socketId)
+  {
+    return socketId == 0 || record.info.socketId == socketId;
+  }
+
+  /// Feeds the received messages back through a MessageDispatcher, the same
+  /// handler-lookup-and-invoke path every inbound message takes in a real
+  /// process.
+  int replayDispatch(const std::vector<Record>& records, unsigned int socketId,
+                     double speed, qi::DataPerfSuite& out)
+  {
+    qi::MessageDispatcher dispatcher;
+    std::map<std::pair<unsigned int, unsigned int>, qi::SignalLink> handlers;
+    uint64_t handled = 0;
+
+    std::vector<qi::Message> messages;
+    std::vector<int64_t> timestamps;
+    uint64_t payloadBytes = 0;
+    for (const auto& record: records)
+    {
+      if (record.info.sent || !matchesSocket(record, socketId))
+        continue;
+      const auto target =
+          std::make_pair(record.header.service, record.header.object);
+      if (handlers.find(target) == handlers.end())
+      {
+        handlers[target] = dispatcher.messagePendingConnect(
+            target.first, target.second,
+            [&handled](const qi::Message&) { ++handled; });
+      }
+      qi::Message msg;
+      qi::Buffer buffer;
+      if (!record.payload.empty())
+        buffer.write(record.payload.data(), record.payload.size());
+      msg.setBuffer(buffer);
+      msg.header() = record.header;
+      messages.push_back(std::move(msg));
+      timestamps.push_back(record.info.timestampUs);
+      payloadBytes += record.header.size;
+    }
+    if (messages.empty())
+    {
+      std::cerr << "no received message to replay" << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    qi::DataPerf dp;
+    dp.start("replay_dispatch", messages.size(),
+             payloadBytes / messages.size());
+    Pacer pacer(timestamps.front(), speed);
+    for (size_t i = 0; i < messages.size(); ++i)
+    {
+      pacer.waitFor(timestamps[i]);
+      dispatcher.dispatch(messages[i]);
+      dp.recordSample();
+    }
+    dp.stop();
+    out << dp;
+    std::cout << messages.size() << " messages dispatched, " << handled
+              << " handled, p50: " << std::fixed << std::setprecision(0)
+              << dp.getPercentile(50) << " us, p99: " << dp.getPercentile(99)
+              << " us, max: " << dp.getMaxSample() << " us" << std::endl;
+    return EXIT_SUCCESS;
+  }
+
+  /// Writes the sent side of one captured socket, raw, to a live endpoint.
+  /// Only records whose payload was stored in full can go on the wire.
+  int replayServer(const std::vector<Record>& records, unsigned int socketId,
+                   double speed, const qi::Url& url)
+  {
+    using boost::asio::ip::tcp;
+    boost::asio::io_service io;
+    tcp::resolver resolver(io);
+    tcp::resolver::query query(url.host(), qi::os::to_string(url.port()));
+    tcp::socket socket(io);
+    boost::asio::connect(socket, resolver.resolve(query));
+
+    // Drain the replies so the target never blocks on its send buffer; what
+    // it answers is not this tool's concern.
+    std::thread drain([&socket] {
+      try
+      {
+        std::vector<char> scratch(64 * 1024);
+        for (;;)
+          socket.read_some(boost::asio::buffer(scratch));
+      }
+      catch (const std::exception&)
+      { // Closed: replay is over.
+      }
+    });
+
+    uint64_t sent = 0, bytes = 0, skipped = 0;
+    const auto start = qi::SteadyClock::now();
+    boost::optional<Pacer> pacer;
+    for (const auto& record: records)
+    {
+      if (!record.info.sent || !matchesSocket(record, socketId))
+        continue;
+      if (record.payload.size() != record.header.size)
+      {
+        ++skipped;
+        continue;
+      }
+      if (!pacer)
+        pacer.emplace(record.info.timestampUs, speed);
+      pacer->waitFor(record.info.timestampUs);
+      std::vector<boost::asio::const_buffer> buffers;
+      buffers.push_back(
+          boost::asio::buffer(&record.header, sizeof(record.header)));
+      if (!record.payload.empty())
+        buffers.push_back(
+            boost::asio::buffer(record.payload.data(), record.payload.size()));
+      boost::asio::write(socket, buffers);
+      ++sent;
+      bytes += sizeof(record.header) + record.payload.size();
+    }
+    const auto elapsed = boost::chrono::duration_cast<qi::MicroSeconds>(
+        qi::SteadyClock::now() - start).count();
+    socket.shutdown(tcp::socket::shutdown_both);
+    socket.close();
+    drain.join();
+
+    if (skipped > 0)
+      std::cerr << skipped << " messages skipped: payload not captured in "
+                   "full (raise QI_MESSAGE_CAPTURE_PAYLOAD_BYTES)"
+                << std::endl;
+    if (sent == 0)
+    {
+      std::cerr << "no sent message to replay" << std::endl;
+      return EXIT_FAILURE;
+    }
+    const double seconds = elapsed / 1e6;
+    std::cout << sent << " messages, " << bytes << " bytes in " << std::fixed
+              << std::setprecision(2) << seconds << " s: "
+              << static_cast<uint64_t>(sent / seconds) << " msg/s, "
+              << bytes / seconds / (1024 * 1024) << " MB/s" << std::endl;
+    return EXIT_SUCCESS;
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  qi::Application app(argc, argv);
+
+  std::string mode, captureFile, url;
+  unsigned int socketId = 0;
+  double speed = 1.0;
+  po::options_description desc("Options");
+  desc.add_options()
+    ("help,h", "Print this help.")
+    ("capture", po::value<std::string>(&captureFile), "Capture file to replay.")
+    ("mode", po::value<std::string>(&mode)->default_value("dispatch"),
+     "dispatch: replay through the dispatch layer; server: replay raw "
+     "against --url.")
+    ("url", po::value<std::string>(&url)->default_value("tcp://127.0.0.1:9559"),
+     "Target endpoint for --mode server.")
+    ("socket", po::value<unsigned int>(&socketId)->default_value(0),
+     "Replay only this captured socket (0: all; server mode should pick one).")
+    ("speed", po::value<double>(&speed)->default_value(1.0),
+     "Pacing divisor: 1 replays at the captured rhythm, 0 as fast as "
+     "possible.");
+  desc.add(qi::detail::getPerfOptions());
+  po::positional_options_description positional;
+  positional.add("capture", 1);
+
+  po::variables_map vm;
+  po::store(po::command_line_parser(argc, argv)
+                .options(desc).positional(positional).run(), vm);
+  po::notify(vm);
+
+  if (vm.count("help") || captureFile.empty())
+  {
+    std::cout << "Usage: replay_qimessaging [options] <capture-file>\n"
+              << desc << std::endl;
+    return vm.count("help") ? EXIT_SUCCESS : EXIT_FAILURE;
+  }
+
+  try
+  {
+    const std::vector<Record> records = loadCapture(captureFile);
+    std::cout << records.size() << " records loaded from " << captureFile
+              << std::endl;
+    if (mode == "server")
+      return replayServer(records, socketId, speed, qi::Url(url));
+    qi::DataPerfSuite out("qi", "replay_qimessaging",
+                          qi::DataPerfSuite::OutputData_MsgMBPerSecond,
+                          vm["output"].as<std::string>());
+    const int status = replayDispatch(records, socketId, speed, out);
+    out.close();
+    return status;
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << "error: " << e.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+}
@@ -0,0 +1,268 @@
+/*
+ * Copyright (c) 2026 Softbank Robotics. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the COPYING file.
+ */
+
+/*
+ * Two-node soak and throughput harness. Unlike the microbenchmarks in this
+ * directory, this binary is meant to run across a real network: start it in
+ * server mode on one node, then in client mode on another, and the client
+ * drives a mix of scenarios against the server and reports each one through
+ * DataPerfSuite, with latency percentiles where per-call samples exist.
+ *
+ *   soak_qimessaging --mode server --listen tcp://0.0.0.0:9559
+ *   soak_qimessaging --mode client --url tcp://server:9559 [--scenario all]
+ *
+ * Scenarios: rpc (small-call flood), transfer (large pulls and pushes),
+ * fanout (one emit delivered to many subscribers), reconnect (connection
+ * churn). --loops scales every scenario, so a soak run is just a large
+ * loop count or an outer shell loop.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <boost/make_shared.hpp>
+#include <boost/program_options.hpp>
+
+#include <qi/anyobject.hpp>
+#include <qi/application.hpp>
+#include <qi/perf/dataperfsuite.hpp>
+#include <qi/session.hpp>
+#include <qi/type/dynamicobjectbuilder.hpp>
+
+namespace po = boost::program_options;
+
+namespace
+{
+  const char* const serviceName = "SoakService";
+
+  // ----- server side -------------------------------------------------------
+
+  class SoakService
+  {
+  public:
+    int ping(int value)
+    {
+      return value;
+    }
+    std::string pull(unsigned int size)
+    {
+      return std::string(size, 'x');
+    }
+    unsigned int push(const std::string& payload)
+    {
+      return static_cast<unsigned int>(payload.size());
+    }
+    /// Emit `tick` count times with a payload of the given size, so clients
+    /// can measure fanout to however many subscriptions they hold.
+    void burst(unsigned int count, unsigned int payloadSize)
+    {
+      const std::string payload(payloadSize, 'x');
+      for (unsigned int i = 0; i < count; ++i)
+        QI_EMIT tick(payload);
+    }
+    qi::Signal<std::string> tick;
+  };
+
+  int runServer(const std::string& listenUrl)
+  {
+    qi::Session session;
+    session.listenStandalone(listenUrl).wait();
+
+    auto service = boost::make_shared<SoakService>();
+    qi::DynamicObjectBuilder builder;
+    builder.advertiseMethod("ping", service.get(), &SoakService::ping);
+    builder.advertiseMethod("pull", service.get(), &SoakService::pull);
+    builder.advertiseMethod("push", service.get(), &SoakService::push);
+    builder.advertiseMethod("burst", service.get(), &SoakService::burst);
+    builder.advertiseSignal("tick", &service->tick);
+    session.registerService(serviceName, builder.object()).wait();
+
+    std::cout << "Serving " << serviceName << " on:" << std::endl;
+    for (const auto& ep: session.endpoints())
+      std::cout << "  " << ep.str() << std::endl;
+    qi::Application::run(); // until interrupted
+    session.close();
+    return EXIT_SUCCESS;
+  }
+
+  // ----- client side -------------------------------------------------------
+
+  void printTail(const qi::DataPerf& dp)
+  {
+    std::cout << "  p50: " << std::fixed << std::setprecision(0)
+              << dp.getPercentile(50) << " us, p99: "
+              << dp.getPercentile(99) << " us, max: "
+              << dp.getMaxSample() << " us" << std::endl;
+  }
+
+  void scenarioRpcFlood(qi::DataPerfSuite& out, qi::AnyObject service,
+                        unsigned long loopCount)
+  {
+    std::cout << "rpc: " << loopCount << " small calls" << std::endl;
+    qi::DataPerf dp;
+    dp.setWarmupCount(loopCount / 10);
+    dp.start("soak_rpc_flood", loopCount, sizeof(int));
+    for (unsigned long i = 0; i < loopCount; ++i)
+    {
+      service.call<int>("ping", 42);
+      dp.recordSample();
+    }
+    dp.stop();
+    out << dp;
+    printTail(dp);
+  }
+
+  void scenarioTransfer(qi::DataPerfSuite& out, qi::AnyObject service,
+                        unsigned long loopCount, unsigned int transferSize)
+  {
+    std::cout << "transfer: " << loopCount << " pulls and pushes of "
+              << transferSize << " bytes" << std::endl;
+    {
+      qi::DataPerf dp;
+      dp.start("soak_transfer_pull", loopCount, transferSize);
+      for (unsigned long i = 0; i < loopCount; ++i)
+      {
+        service.call<std::string>("pull", transferSize);
+        dp.recordSample();
+      }
+      dp.stop();
+      out << dp;
+      printTail(dp);
+    }
+    {
+      const std::string payload(transferSize, 'x');
+      qi::DataPerf dp;
+      dp.start("soak_transfer_push", loopCount, transferSize);
+      for (unsigned long i = 0; i < loopCount; ++i)
+      {
+        service.call<unsigned int>("push", payload);
+        dp.recordSample();
+      }
+      dp.stop();
+      out << dp;
+      printTail(dp);
+    }
+  }
+
+  void scenarioFanout(qi::DataPerfSuite& out, qi::AnyObject service,
+                      unsigned long loopCount, unsigned int subscriberCount,
+                      unsigned int payloadSize)
+  {
+    std::cout << "fanout: " << loopCount << " events to " << subscriberCount
+              << " subscribers" << std::endl;
+    std::atomic<unsigned long> received{0};
+    const unsigned long expected = loopCount * subscriberCount;
+    qi::Promise<void> done;
+    std::vector<qi::SignalLink> links;
+    for (unsigned int i = 0; i < subscriberCount; ++i)
+    {
+      links.push_back(service.connect("tick",
+        boost::function<void(const std::string&)>(
+          [&received, expected, done](const std::string&) mutable {
+            if (++received == expected)
+              done.setValue(0);
+          })).value());
+    }
+
+    qi::DataPerf dp;
+    dp.start("soak_signal_fanout", expected, payloadSize);
+    service.call<void>("burst", static_cast<unsigned int>(loopCount), payloadSize);
+    done.future().wait();
+    dp.stop();
+    out << dp;
+
+    for (const auto link: links)
+      service.disconnect(link).wait();
+  }
+
+  void scenarioReconnect(qi::DataPerfSuite& out, const qi::Url& url,
+                         unsigned long loopCount)
+  {
+    std::cout << "reconnect: " << loopCount << " connect/call/close cycles"
+              << std::endl;
+    qi::DataPerf dp;
+    dp.start("soak_reconnect_churn", loopCount);
+    for (unsigned long i = 0; i < loopCount; ++i)
+    {
+      qi::Session session;
+      session.connect(url).wait();
+      qi::AnyObject service = session.service(serviceName).value();
+      service.call<int>("ping", 42);
+      session.close().wait();
+      dp.recordSample();
+    }
+    dp.stop();
+    out << dp;
+    printTail(dp);
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  qi::Application app(argc, argv);
+
+  po::options_description desc;
+  desc.add_options()
+    ("help,h", "Print this help.")
+    ("mode", po::value<std::string>()->default_value("client"),
+     "server or client.")
+    ("listen", po::value<std::string>()->default_value("tcp://0.0.0.0:9559"),
+     "Server mode: URL to listen on.")
+    ("url", po::value<std::string>()->default_value("tcp://127.0.0.1:9559"),
+     "Client mode: URL of the server node.")
+    ("scenario", po::value<std::string>()->default_value("all"),
+     "all, rpc, transfer, fanout or reconnect.")
+    ("loops", po::value<unsigned long>()->default_value(10000),
+     "Iterations for rpc; other scenarios use a scaled-down share.")
+    ("transfer-size", po::value<unsigned int>()->default_value(1048576),
+     "Payload size in bytes for the transfer scenario.")
+    ("subscribers", po::value<unsigned int>()->default_value(16),
+     "Subscription count for the fanout scenario.");
+  desc.add(qi::detail::getPerfOptions());
+
+  po::variables_map vm;
+  po::store(po::command_line_parser(argc, argv).options(desc).run(), vm);
+  po::notify(vm);
+
+  if (vm.count("help")) {
+    std::cout << desc << std::endl;
+    return EXIT_SUCCESS;
+  }
+
+  if (vm["mode"].as<std::string>() == "server")
+    return runServer(vm["listen"].as<std::string>());
+
+  const qi::Url url(vm["url"].as<std::string>());
+  const std::string scenario = vm["scenario"].as<std::string>();
+  const unsigned long loops = vm["loops"].as<unsigned long>();
+
+  qi::DataPerfSuite out("qi", "soak_qimessaging",
+                        qi::DataPerfSuite::OutputData_MsgMBPerSecond,
+                        vm["output"].as<std::string>());
+
+  qi::Session session;
+  session.connect(url).wait();
+  qi::AnyObject service = session.service(serviceName).value();
+
+  if (scenario == "all" || scenario == "rpc")
+    scenarioRpcFlood(out, service, loops);
+  if (scenario == "all" || scenario == "transfer")
+    scenarioTransfer(out, service, std::max<unsigned long>(loops / 100, 1),
+                     vm["transfer-size"].as<unsigned int>());
+  if (scenario == "all" || scenario == "fanout")
+    scenarioFanout(out, service, std::max<unsigned long>(loops / 10, 1),
+                   vm["subscribers"].as<unsigned int>(), 128);
+  if (scenario == "all" || scenario == "reconnect")
+    scenarioReconnect(out, url, std::max<unsigned long>(loops / 100, 1));
+
+  session.close();
+  out.close();
+  return EXIT_SUCCESS;
+}
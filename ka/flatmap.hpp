@@ -0,0 +1,177 @@
+#ifndef KA_FLATMAP_HPP
+#define KA_FLATMAP_HPP
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <utility>
+#include <vector>
+#include "macroregular.hpp"
+
+/// @file
+/// Contains a sorted-vector associative container for tables that are built
+/// once and then read many times.
+
+namespace ka {
+
+  /// Associative container over a sorted contiguous array.
+  ///
+  /// Implements the subset of `std::map`'s interface needed to act as a
+  /// drop-in replacement for read-mostly tables: ordered iteration, lookup,
+  /// `operator[]`, plain, hinted and ranged insertion, and erasure. The
+  /// elements live in one `std::vector` sorted by key, so a lookup is a
+  /// binary search over contiguous memory and iteration walks consecutive
+  /// cache lines instead of one heap node per element.
+  ///
+  /// The trade-off is mutation: inserting or erasing in the middle shifts the
+  /// following elements, and any insertion may invalidate iterators,
+  /// references and pointers to elements (as for any vector). This container
+  /// is therefore meant for associations built in one go and read forever,
+  /// not for tables mutated while being traversed.
+  ///
+  /// Contrary to `std::map`, `value_type` is `std::pair<K, T>` with a
+  /// non-const key, as elements must be movable within the storage.
+  ///
+  /// Regular K, Regular T, StrictWeakOrdering<K> C
+  template<typename K, typename T, typename C = std::less<K>>
+  class flat_map_t {
+  public:
+    using key_type = K;
+    using mapped_type = T;
+    using value_type = std::pair<K, T>;
+    using key_compare = C;
+  private:
+    using storage_type = std::vector<value_type>;
+    storage_type entries;
+    key_compare cmp;
+  public:
+    using iterator = typename storage_type::iterator;
+    using const_iterator = typename storage_type::const_iterator;
+    using size_type = typename storage_type::size_type;
+
+    flat_map_t() = default;
+
+    explicit flat_map_t(key_compare c)
+      : cmp(std::move(c)) {
+    }
+
+    /// Range constructor. The input needs not be sorted: each element is
+    /// inserted in turn, so as with successive `insert` calls the first
+    /// occurrence of a key wins.
+    ///
+    /// InputIterator<std::pair<K, T>> I (a const key, as in std::map's
+    /// value_type, is accepted too)
+    template<typename I>
+    flat_map_t(I b, I e) {
+      insert(b, e);
+    }
+
+  // Regular (if K and T are):
+    KA_GENERATE_FRIEND_REGULAR_OPS_1(flat_map_t, entries)
+
+    iterator begin() { return entries.begin(); }
+    const_iterator begin() const { return entries.begin(); }
+    const_iterator cbegin() const { return entries.cbegin(); }
+    iterator end() { return entries.end(); }
+    const_iterator end() const { return entries.end(); }
+    const_iterator cend() const { return entries.cend(); }
+
+    size_type size() const { return entries.size(); }
+    bool empty() const { return entries.empty(); }
+    void clear() { entries.clear(); }
+    void reserve(size_type n) { entries.reserve(n); }
+    void swap(flat_map_t& x) {
+      entries.swap(x.entries);
+      std::swap(cmp, x.cmp);
+    }
+
+    /// First position whose key does not sort before `k`.
+    iterator lower_bound(key_type const& k) {
+      return std::lower_bound(entries.begin(), entries.end(), k, value_key_less_t{cmp});
+    }
+
+    const_iterator lower_bound(key_type const& k) const {
+      return std::lower_bound(entries.begin(), entries.end(), k, value_key_less_t{cmp});
+    }
+
+    iterator find(key_type const& k) {
+      iterator const it = lower_bound(k);
+      return (it != entries.end() && !cmp(k, it->first)) ? it : entries.end();
+    }
+
+    const_iterator find(key_type const& k) const {
+      const_iterator const it = lower_bound(k);
+      return (it != entries.end() && !cmp(k, it->first)) ? it : entries.end();
+    }
+
+    size_type count(key_type const& k) const {
+      return find(k) == end() ? 0u : 1u;
+    }
+
+    /// Value associated to `k`, default-constructing and inserting it first
+    /// if the key is not present.
+    mapped_type& operator[](key_type const& k) {
+      iterator it = lower_bound(k);
+      if (it == entries.end() || cmp(k, it->first))
+        it = entries.insert(it, value_type(k, mapped_type()));
+      return it->second;
+    }
+
+    /// Inserts `v` if no element has an equal key. Returns the position of
+    /// the element with that key and whether the insertion took place.
+    std::pair<iterator, bool> insert(value_type const& v) {
+      iterator const it = lower_bound(v.first);
+      if (it != entries.end() && !cmp(v.first, it->first))
+        return std::make_pair(it, false);
+      return std::make_pair(entries.insert(it, v), true);
+    }
+
+    /// Hinted insertion. An end hint for a key sorting after every element
+    /// is a constant-time append, which makes inserting elements in key
+    /// order linear overall; any other hint degrades to a plain insert. As
+    /// for `std::map`, an existing key is not overwritten and its position
+    /// is returned.
+    iterator insert(const_iterator hint, value_type const& v) {
+      if (hint == entries.cend()
+          && (entries.empty() || cmp(entries.back().first, v.first))) {
+        entries.push_back(v);
+        return entries.end() - 1;
+      }
+      return insert(v).first;
+    }
+
+    /// Inserts a range of key/value pairs; keys already present are
+    /// skipped.
+    ///
+    /// InputIterator<std::pair<K, T>> I
+    template<typename I>
+    void insert(I b, I e) {
+      for (; b != e; ++b)
+        insert(entries.cend(), value_type(b->first, b->second));
+    }
+
+    iterator erase(iterator pos) {
+      return entries.erase(pos);
+    }
+
+    size_type erase(key_type const& k) {
+      iterator const it = find(k);
+      if (it == entries.end())
+        return 0u;
+      entries.erase(it);
+      return 1u;
+    }
+
+  private:
+    // Heterogeneous comparison for the binary searches.
+    struct value_key_less_t {
+      key_compare const& c;
+      bool operator()(value_type const& v, key_type const& k) const {
+        return c(v.first, k);
+      }
+    };
+  };
+
+} // namespace ka
+
+#endif // KA_FLATMAP_HPP
@@ -1,6 +1,10 @@
 #ifndef KA_FUNCTIONAL_HPP
 #define KA_FUNCTIONAL_HPP
 #pragma once
+#include <array>
+#include <cstddef>
+#include <tuple>
+#include <utility>
 #include <boost/config.hpp>
 #include <boost/optional.hpp>
 #include "integersequence.hpp"
@@ -137,11 +141,128 @@ namespace ka {
 
 #undef KA_FWD_ARGS
 
+  namespace detail {
+    template<std::size_t I, std::size_t Remaining>
+    struct pipe_invoke_t;
+
+    /// Feeds the result of a stage to the remaining ones. The `void` case is
+    /// handled as in `composition_t`: the next stage is called with no
+    /// argument.
+    template<typename Ret, std::size_t I, std::size_t Remaining>
+    struct pipe_step_t {
+      template<typename Tuple, typename F, typename... Args>
+      auto operator()(Tuple& t, F& f, Args&&... args) const
+          -> decltype(pipe_invoke_t<I, Remaining>{}(t, f(fwd<Args>(args)...))) {
+        return pipe_invoke_t<I, Remaining>{}(t, f(fwd<Args>(args)...));
+      }
+    };
+
+    template<std::size_t I, std::size_t Remaining>
+    struct pipe_step_t<void, I, Remaining> {
+      template<typename Tuple, typename F, typename... Args>
+      auto operator()(Tuple& t, F& f, Args&&... args) const
+          -> decltype(pipe_invoke_t<I, Remaining>{}(t)) {
+        return f(fwd<Args>(args)...), pipe_invoke_t<I, Remaining>{}(t);
+      }
+    };
+
+    /// Invokes the `Remaining` stages starting at index `I`, in order, on the
+    /// arguments. Being index-based, the recursion is in the types only: once
+    /// instantiated it is a straight chain of calls the compiler can inline.
+    template<std::size_t I, std::size_t Remaining>
+    struct pipe_invoke_t {
+      template<typename Tuple, typename... Args>
+      auto operator()(Tuple& t, Args&&... args) const
+          -> decltype(pipe_step_t<decltype(std::get<I>(t)(fwd<Args>(args)...)),
+                I + 1, Remaining - 1>{}(t, std::get<I>(t), fwd<Args>(args)...)) {
+        return pipe_step_t<decltype(std::get<I>(t)(fwd<Args>(args)...)),
+          I + 1, Remaining - 1>{}(t, std::get<I>(t), fwd<Args>(args)...);
+      }
+    };
+
+    template<std::size_t I>
+    struct pipe_invoke_t<I, 1> {
+      template<typename Tuple, typename... Args>
+      auto operator()(Tuple& t, Args&&... args) const
+          -> decltype(std::get<I>(t)(fwd<Args>(args)...)) {
+        return std::get<I>(t)(fwd<Args>(args)...);
+      }
+    };
+  } // namespace detail
+
+  /// Flattened function composition.
+  ///
+  /// Stores its stages side by side in a tuple, in application order (the
+  /// stage at index 0 is applied first), instead of nesting binary
+  /// `composition_t`. A deep chain of compositions is therefore one object of
+  /// one type whose whole pipeline is visible at once, instead of a tower of
+  /// wrappers each adding a call frame for the optimizer to peel.
+  ///
+  /// Instances are produced by `compose` when one of the operands is already
+  /// a composition; there is no reason to build one directly.
+  ///
+  /// Procedure<T1 (Args...)> P0, Procedure<T2 (T1)> P1, ...
+  template<typename... Procs>
+  struct flat_composition_t {
+    std::tuple<Procs...> procs;
+  // Regular (if all Procs are):
+    KA_GENERATE_FRIEND_REGULAR_OPS_1(flat_composition_t, procs)
+  // Procedure:
+    template<typename... Args>
+    auto operator()(Args&&... args)
+        -> decltype(detail::pipe_invoke_t<0, sizeof...(Procs)>{}(procs, fwd<Args>(args)...)) {
+      return detail::pipe_invoke_t<0, sizeof...(Procs)>{}(procs, fwd<Args>(args)...);
+    }
+
+    template<typename... Args>
+    auto operator()(Args&&... args) const
+        -> decltype(detail::pipe_invoke_t<0, sizeof...(Procs)>{}(procs, fwd<Args>(args)...)) {
+      return detail::pipe_invoke_t<0, sizeof...(Procs)>{}(procs, fwd<Args>(args)...);
+    }
+  };
+
   namespace detail {
     template<typename G, typename F>
     using IsCompositionIdentity = Conjunction<
       std::is_empty<G>,
       ka::IsRetract<G, F>>;
+
+    template<typename T>
+    struct IsComposition : false_t {};
+
+    // Qualified: unqualified `composition_t` would name the unrelated
+    // `detail::composition_t<Ret>` helper above.
+    template<typename G, typename F>
+    struct IsComposition<ka::composition_t<G, F>> : true_t {};
+
+    template<typename... P>
+    struct IsComposition<flat_composition_t<P...>> : true_t {};
+
+    /// Stages of a procedure as a tuple in application order: a composition
+    /// is spliced recursively, anything else is a single stage.
+    template<typename F>
+    std::tuple<Decay<F>> flat_procs(F&& f) {
+      return std::tuple<Decay<F>>(fwd<F>(f));
+    }
+
+    template<typename... P>
+    std::tuple<P...> flat_procs(flat_composition_t<P...> c) {
+      return std::move(c.procs);
+    }
+
+    template<typename G, typename F>
+    auto flat_procs(ka::composition_t<G, F> c)
+        -> decltype(std::tuple_cat(flat_procs(std::move(c.f)), flat_procs(std::move(c.g)))) {
+      return std::tuple_cat(flat_procs(std::move(c.f)), flat_procs(std::move(c.g)));
+    }
+
+    template<typename Tuple>
+    struct FlatCompositionOf;
+
+    template<typename... P>
+    struct FlatCompositionOf<std::tuple<P...>> {
+      using type = flat_composition_t<P...>;
+    };
   } // namespace detail
 
   /// Performs a mathematical function composition.
@@ -183,7 +304,9 @@ namespace ka {
   }
 #else
   template<typename G, typename F, typename =
-    EnableIf<!detail::IsCompositionIdentity<Decay<G>, Decay<F>>::value>>
+    EnableIf<!detail::IsCompositionIdentity<Decay<G>, Decay<F>>::value
+          && !detail::IsComposition<Decay<G>>::value
+          && !detail::IsComposition<Decay<F>>::value>>
   composition_t<Decay<G>, Decay<F>> compose(G&& g, F&& f) {
     return {fwd<G>(g), fwd<F>(f)};
   }
@@ -192,6 +315,18 @@ namespace ka {
   id_transfo_t compose(Retract<Decay<F>> const&, F const&) {
     return {};
   }
+
+  /// Flattening overload: when an operand is already a composition, its
+  /// stages are spliced in instead of being nested, so
+  /// `compose(f, compose(g, h))` yields one `flat_composition_t` holding
+  /// `h`, `g` and `f` side by side. See `flat_composition_t`.
+  template<typename G, typename F>
+  auto compose(G&& g, F&& f) -> EnableIf<
+      detail::IsComposition<Decay<G>>::value || detail::IsComposition<Decay<F>>::value,
+      typename detail::FlatCompositionOf<decltype(std::tuple_cat(
+        detail::flat_procs(fwd<F>(f)), detail::flat_procs(fwd<G>(g))))>::type> {
+    return {std::tuple_cat(detail::flat_procs(fwd<F>(f)), detail::flat_procs(fwd<G>(g)))};
+  }
 #endif
 
   template<typename F>
@@ -849,6 +984,94 @@ namespace ka {
     return {fwd<Proc>(proc)};
   }
 
+  /// Bounded cache policy for `memoize_t` remembering the last `N` results.
+  ///
+  /// Lookup is a linear scan over a contiguous array: for the small
+  /// capacities this is meant for, that is cheaper than hashing and has no
+  /// allocation at all. When full, the oldest entry is overwritten.
+  ///
+  /// Regular Arg, Regular Ret
+  template<typename Arg, typename Ret, std::size_t N = 8>
+  struct memo_cache_t {
+    std::array<boost::optional<std::pair<Arg, Ret>>, N> entries;
+    std::size_t next = 0;
+  // Regular:
+    KA_GENERATE_FRIEND_REGULAR_OPS_2(memo_cache_t, entries, next)
+  // MemoCache<Arg, Ret>:
+    /// Address of the result cached for `arg`, or nullptr if there is none.
+    Ret const* find(Arg const& arg) const {
+      for (auto const& entry : entries) {
+        if (entry && entry->first == arg)
+          return &entry->second;
+      }
+      return nullptr;
+    }
+
+    /// Remembers that `arg` maps to `ret`, evicting the oldest entry if full.
+    void store(Arg const& arg, Ret const& ret) {
+      entries[next] = std::pair<Arg, Ret>(arg, ret);
+      next = (next + 1) % N;
+    }
+  };
+
+  /// Procedure wrapper that caches the results of a pure unary procedure.
+  ///
+  /// The cache is consulted first: an argument equal to an already seen one
+  /// yields the cached result without invoking the procedure again. The cache
+  /// policy decides what is retained; see `memo_cache_t` for the default
+  /// bounded one.
+  ///
+  /// Precondition: the procedure is pure, i.e. equal inputs always produce
+  ///   equal outputs and calls have no relied-upon side effect.
+  ///
+  /// Warning: calls mutate the cache, so instances must not be shared between
+  ///   threads without synchronization (see `scope_lock_proc_t`).
+  ///
+  /// Note: For an n-ary procedure, combine with `apply` and pass the
+  ///   arguments as a tuple.
+  ///
+  /// Function<Ret (Arg)> Proc, MemoCache<Arg, Ret> C
+  template<typename Proc, typename C>
+  struct memoize_t {
+    Proc proc;
+    C cache;
+  // Regular (if members are):
+    KA_GENERATE_FRIEND_REGULAR_OPS_2(memoize_t, proc, cache)
+  // Procedure<Ret (Arg)>:
+    template<typename Arg>
+    auto operator()(Arg const& arg) -> Decay<decltype(proc(arg))> {
+      using Ret = Decay<decltype(proc(arg))>;
+      if (Ret const* hit = cache.find(arg))
+        return *hit;
+      Ret ret = proc(arg);
+      cache.store(arg, ret);
+      return ret;
+    }
+  };
+
+  /// Helper function to construct a `memoize_t`. The argument and result
+  /// types cannot be deduced from the procedure alone, so they are explicit:
+  ///
+  /// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+  /// // `parse` takes a `std::string` and returns a `signature_t`.
+  /// auto cached_parse = memoize<std::string, signature_t>(parse);
+  /// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+  ///
+  /// Procedure<Ret (Arg)> Proc
+  template<typename Arg, typename Ret, typename Proc>
+  memoize_t<Decay<Proc>, memo_cache_t<Arg, Ret>> memoize(Proc&& p) {
+    return {fwd<Proc>(p), {}};
+  }
+
+  /// Overload taking an explicit cache, e.g. a larger `memo_cache_t` or a
+  /// custom policy providing `find` and `store`.
+  ///
+  /// Procedure<Ret (Arg)> Proc, MemoCache<Arg, Ret> C
+  template<typename Proc, typename C>
+  memoize_t<Decay<Proc>, Decay<C>> memoize(Proc&& p, C&& c) {
+    return {fwd<Proc>(p), fwd<C>(c)};
+  }
+
   namespace detail {
     template<typename Ret>
     struct scope_lock_proc_t {
@@ -75,6 +75,21 @@ public:
     return _strand.asyncAt(std::forward<Args>(args)...);
   }
 
+  /// Bounds the actor's mailbox: messages received beyond the capacity are
+  /// handled according to the policy, instead of piling up until the process
+  /// runs out of memory. @see Strand::setMaxPendingTasks
+  void setMailboxCapacity(size_t capacity,
+                          Strand::OverflowPolicy policy = Strand::OverflowPolicy::Fail)
+  {
+    _strand.setMaxPendingTasks(capacity, policy);
+  }
+
+  /// Number of messages queued on the actor and not yet processed.
+  size_t mailboxSize() const
+  {
+    return _strand.pendingTaskCount();
+  }
+
   void joinTasks()
   {
     _strand.join();
@@ -153,6 +153,11 @@ namespace qi {
      * \brief Return the current program full path according to argv[0]
      * \return full path to the current running program, symbolic links are not
      * resolved.
+     *
+     * Unless a path was given to the constructor, the full path is guessed
+     * (probing the filesystem and $PATH) on the first call rather than at
+     * construction. Set QI_APPLICATION_EAGER_PATHS=1 in the environment to
+     * resolve it, and the SDK layout, at construction as before.
      * \see realProgram
      */
     static const char* program();
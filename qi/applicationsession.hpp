@@ -148,6 +148,25 @@ public:
    */
   void run();
 
+  /**
+   * Registers several services with the service directory at once. All the
+   * registrations are sent without waiting for one another, so the directory
+   * round trips overlap instead of being serialized.
+   * @param services The services to register, as (name, object) pairs.
+   * @return A future set once every service is registered, or set with an
+   * error naming the services that could not be registered.
+   */
+  qi::FutureSync<void> registerServices(
+      const std::vector<std::pair<std::string, AnyObject>>& services);
+
+  /**
+   * Waits for several services to become available, concurrently.
+   * @param services The names of the services to wait for.
+   * @return A future set once every service is available, or set with an
+   * error naming the services that could not be resolved.
+   */
+  qi::FutureSync<void> waitForServices(const std::vector<std::string>& services);
+
   /**
    * Returns whether the ApplicationSession runs in standalone mode.
    */
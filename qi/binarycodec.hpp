@@ -7,12 +7,21 @@
 #ifndef _QI_TYPE_BINARYCODEC_HPP_
 #define _QI_TYPE_BINARYCODEC_HPP_
 
+#include <cstdint>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
 #include <qi/atomic.hpp>
 
 #include <qi/api.hpp>
 #include <boost/function.hpp>
 #include <qi/buffer.hpp>
 #include <qi/anyvalue.hpp>
+#include <qi/numeric.hpp>
 #include <qi/type/metaobject.hpp>
 #include <qi/ptruid.hpp>
 
@@ -74,6 +83,169 @@ namespace qi {
   AnyReference decodeBinary(qi::BufferReader *buf, T* value, DeserializeObjectCallback onObject, StreamContext* ctx) {
     return decodeBinary(buf, AnyReference::fromPtr(value), onObject, ctx);
   }
+
+  namespace detail {
+
+    /// \return whether \p ctx negotiated the compact integer encoding for
+    /// sending. False for a null context.
+    QI_API bool compactValuesSendEnabled(StreamContext* ctx);
+
+    /// Throws like the generic encoder does when the buffer refuses the write.
+    inline void staticEncodeRaw(Buffer& buf, const void* data, size_t size)
+    {
+      if (!buf.write(data, size))
+        throw std::runtime_error("OSerialization error Status Write Error");
+    }
+
+    /** Compile-time serializer for statically-known types.
+     *
+     * The generic encoder walks values through qi::typeDispatch and pays a
+     * virtual TypeInterface call at every node. When the C++ type of the
+     * value is known at the encodeBinary call site the whole layout is known
+     * at compile time: these specializations resolve the dispatch statically
+     * and inline the leaf writers, so encoding a supported type compiles
+     * down to straight-line buffer writes.
+     *
+     * Every specialization must produce exactly the wire image of the
+     * generic visitor in fixed-width (non compact) mode; the entry point
+     * falls back to the visitor when the compact encoding is negotiated.
+     */
+    template<typename T, typename Enable = void>
+    struct StaticEncode
+    {
+      static const bool is_supported = false;
+    };
+
+    /// The numeric types the type system registers: the native integral
+    /// types, bool, float and double. long double and the wide character
+    /// types have no registered TypeInterface, so the generic path does not
+    /// handle them either.
+    template<typename T>
+    struct IsStaticEncodableNumber
+      : std::integral_constant<bool,
+            std::is_arithmetic<T>::value &&
+            !std::is_same<T, long double>::value &&
+            !std::is_same<T, wchar_t>::value &&
+            !std::is_same<T, char16_t>::value &&
+            !std::is_same<T, char32_t>::value>
+    {};
+
+    /// Numbers are their host representation, as visitInt and visitFloat
+    /// emit them in fixed-width mode.
+    template<typename T>
+    struct StaticEncode<T, typename std::enable_if<IsStaticEncodableNumber<T>::value>::type>
+    {
+      static const bool is_supported = true;
+      static void write(Buffer& buf, T value)
+      {
+        staticEncodeRaw(buf, &value, sizeof(value));
+      }
+    };
+
+    /// A string is its byte count followed by its bytes.
+    template<>
+    struct StaticEncode<std::string>
+    {
+      static const bool is_supported = true;
+      static void write(Buffer& buf, const std::string& value)
+      {
+        const std::uint32_t size = numericConvert<std::uint32_t>(value.size());
+        staticEncodeRaw(buf, &size, sizeof(size));
+        if (size)
+          staticEncodeRaw(buf, value.data(), size);
+      }
+    };
+
+    /// A list is its element count followed by its elements. std::vector<bool>
+    /// is left to the generic path: its packed storage has no addressable
+    /// elements.
+    template<typename E, typename A>
+    struct StaticEncode<std::vector<E, A>,
+        typename std::enable_if<StaticEncode<E>::is_supported &&
+                                !std::is_same<E, bool>::value>::type>
+    {
+      static const bool is_supported = true;
+      static void write(Buffer& buf, const std::vector<E, A>& value)
+      {
+        const std::uint32_t size = numericConvert<std::uint32_t>(value.size());
+        staticEncodeRaw(buf, &size, sizeof(size));
+        writeElements(buf, value, std::is_arithmetic<E>());
+      }
+
+    private:
+      // Numeric elements share the layout of their wire image: emit them in
+      // one bulk copy, as the runtime bulk fast path does.
+      static void writeElements(Buffer& buf, const std::vector<E, A>& value, std::true_type)
+      {
+        if (!value.empty())
+          staticEncodeRaw(buf, value.data(), value.size() * sizeof(E));
+      }
+      static void writeElements(Buffer& buf, const std::vector<E, A>& value, std::false_type)
+      {
+        for (typename std::vector<E, A>::const_iterator it = value.begin();
+             it != value.end(); ++it)
+          StaticEncode<E>::write(buf, *it);
+      }
+    };
+
+    /// A map is its element count followed by its key/value pairs.
+    template<typename K, typename V, typename C, typename A>
+    struct StaticEncode<std::map<K, V, C, A>,
+        typename std::enable_if<StaticEncode<K>::is_supported &&
+                                StaticEncode<V>::is_supported>::type>
+    {
+      static const bool is_supported = true;
+      static void write(Buffer& buf, const std::map<K, V, C, A>& value)
+      {
+        const std::uint32_t size = numericConvert<std::uint32_t>(value.size());
+        staticEncodeRaw(buf, &size, sizeof(size));
+        for (typename std::map<K, V, C, A>::const_iterator it = value.begin();
+             it != value.end(); ++it)
+        {
+          StaticEncode<K>::write(buf, it->first);
+          StaticEncode<V>::write(buf, it->second);
+        }
+      }
+    };
+
+    /// Tuples add no framing of their own: members follow each other.
+    template<typename F, typename S>
+    struct StaticEncode<std::pair<F, S>,
+        typename std::enable_if<StaticEncode<F>::is_supported &&
+                                StaticEncode<S>::is_supported>::type>
+    {
+      static const bool is_supported = true;
+      static void write(Buffer& buf, const std::pair<F, S>& value)
+      {
+        StaticEncode<F>::write(buf, value.first);
+        StaticEncode<S>::write(buf, value.second);
+      }
+    };
+  }
+
+  /** Compile-time fast path of encodeBinary.
+   *
+   * Selected by overload resolution when the static type of \p value has a
+   * detail::StaticEncode specialization (numbers, strings, and vectors,
+   * maps and pairs of supported types): the dispatch is resolved at compile
+   * time and the leaf writers are inlined, producing exactly the wire image
+   * of the generic overload. Falls back to the runtime visitor when the
+   * connection negotiated the compact integer encoding, which the static
+   * writers do not implement.
+   */
+  template <typename T>
+  typename std::enable_if<detail::StaticEncode<T>::is_supported>::type
+  encodeBinary(qi::Buffer* buf, const T& value,
+               SerializeObjectCallback onObject = SerializeObjectCallback(),
+               StreamContext* ctx = nullptr)
+  {
+    if (detail::compactValuesSendEnabled(ctx))
+    {
+      encodeBinary(buf, AutoAnyReference(value), onObject, ctx);
+      return;
+    }
+    detail::StaticEncode<T>::write(*buf, value);
+  }
 }
 
 #endif  // _QITYPE_BINARYCODEC_HPP_
@@ -0,0 +1,54 @@
+#pragma once
+/*
+**  Copyright (C) 2018 Softbank Robotics
+**  See COPYING for the license
+*/
+
+#ifndef _QI_BLOB_HPP_
+#define _QI_BLOB_HPP_
+
+#include <qi/api.hpp>
+#include <qi/anyobject.hpp>
+#include <qi/buffer.hpp>
+#include <qi/future.hpp>
+
+namespace qi
+{
+  /// Out-of-band handle for a large binary payload.
+  ///
+  /// A method returning qi::Object<Blob> sends only a small object
+  /// descriptor in its reply, through the usual object-passing machinery
+  /// of the binary codec; the bytes stay on the emitting side until the
+  /// receiver pulls them with fetchBlob(), in bounded chunks. The control
+  /// plane therefore never queues behind a hundred-megabyte reply.
+  class QI_API Blob
+  {
+  public:
+    Blob();
+    explicit Blob(Buffer data);
+
+    uint64_t size() const;
+    /// One chunk of the payload: at most `length` bytes from `offset`,
+    /// empty when `offset` is past the end.
+    Buffer fetch(uint64_t offset, uint32_t length) const;
+    /// The whole payload, for local users holding the handle directly.
+    const Buffer& data() const;
+
+  private:
+    Buffer _data;
+  };
+
+  /// Wraps a buffer into a blob handle ready to be returned by a bound
+  /// method.
+  QI_API Object<Blob> makeBlob(Buffer data);
+
+  /// Pulls the whole payload behind a blob handle received from a remote
+  /// method. Chunks of QI_BLOB_CHUNK_SIZE bytes (default 1MiB) are
+  /// requested with at most QI_BLOB_FETCH_WINDOW (default 4) of them in
+  /// flight: the window is the flow control, and the bounded chunk size
+  /// keeps any single message small enough not to stall unrelated
+  /// traffic on the socket.
+  QI_API Future<Buffer> fetchBlob(AnyObject blob);
+}
+
+#endif  // _QI_BLOB_HPP_
@@ -9,6 +9,7 @@
 
 # include <qi/api.hpp>
 # include <qi/types.hpp>
+# include <boost/function.hpp>
 # include <boost/shared_ptr.hpp>
 # include <vector>
 # include <cstddef>
@@ -111,6 +112,61 @@ namespace qi
      */
     Buffer& operator = (Buffer&& buffer);
 
+    /**
+     * \brief Make a buffer sharing the storage of another buffer.
+     *
+     * Contrary to the copy constructor, the returned buffer aliases the
+     * storage of \a buffer instead of duplicating it: reading through the
+     * view costs nothing regardless of the payload size.
+     * The storage is kept alive as long as any sharing buffer exists.
+     * By convention a shared view is read-only: writing through either
+     * buffer while the other is in use is a race on the common storage.
+     * \param buffer The buffer to share storage with.
+     */
+    static Buffer makeShared(const Buffer& buffer);
+
+    /**
+     * \brief Make a buffer that adopts externally owned memory without copying.
+     *
+     * The returned buffer aliases \a data directly, so a large payload (a
+     * camera frame in a DMA buffer, an mmap'd file...) can be serialized,
+     * typically through addSubBuffer, without being copied first.
+     * \param data Start of the memory region to adopt.
+     * \param size Size of the region in bytes; it is also the buffer content
+     * size, as if the region had been written into the buffer.
+     * \param deleter Invoked once with \a data when the last buffer sharing
+     * the storage releases it. Pass an empty function for memory the caller
+     * keeps owning; the region must then outlive the buffer and every
+     * makeShared view of it.
+     *
+     * The adopted memory is never written through: mutating operations
+     * (write, reserve) first detach into an owned copy, and clear releases
+     * the region immediately. Copying the buffer also copies into owned
+     * storage; use makeShared to share the region without a copy.
+     */
+    static Buffer fromExternal(void* data, size_t size,
+                               boost::function<void(void*)> deleter =
+                                   boost::function<void(void*)>());
+
+    /**
+     * \brief Make a buffer backed by the content of a file, without reading
+     * it into heap memory.
+     *
+     * On platforms with mmap, the file is mapped read-only and the buffer
+     * adopts the mapping (see fromExternal); the mapping is released when
+     * the last buffer sharing it is destroyed. Sending such a buffer as a
+     * sub-buffer streams the file from the page cache straight into the
+     * socket's gathered write, so a large asset transfer never holds a heap
+     * copy of the file. Platforms without mmap fall back to reading the
+     * file into an ordinary buffer.
+     * \param filePath Path to the file, in UTF-8.
+     * \return The buffer, or an empty buffer if the file could not be
+     * opened or mapped.
+     * \warning The file must not shrink while any buffer maps it: accessing
+     * truncated pages is undefined behavior.
+     */
+    static Buffer fromFile(const std::string& filePath);
+
     /**
      * \brief Write data in the buffer.
      * \param data The data to write
@@ -170,6 +226,19 @@ namespace qi
      * \warning The return value is valid until the next non-const operation.
      */
     void* reserve(size_t size);
+
+    /**
+     * \brief Hint the expected total size of the buffer content.
+     *
+     * Grows the underlying storage so that at least \a size bytes can be
+     * written without any further allocation, without changing the content
+     * or the size of the buffer. Use it before serializing a payload whose
+     * size is known (or well estimated) in advance so that filling the
+     * buffer does at most one allocation instead of a geometric growth
+     * sequence.
+     * \param size Expected total content size in bytes.
+     */
+    void reserveCapacity(size_t size);
     /**
      * \brief Erase content of buffer and remove sub-buffers whithout clearing them.
      */
@@ -247,9 +316,30 @@ namespace qi
     /**
      * \brief read data from buffer.
      * \param offset Number of bytes to read.
-     * \return a pointer to data at the given
+     * \return a pointer to data at the given position, contiguous for the
+     * whole span, or nullptr when fewer than \a offset bytes remain.
      */
     void  *read(size_t offset);
+
+    /**
+     * \brief Read \a length bytes as a buffer aliasing the storage in place.
+     *
+     * The span is not copied: the returned buffer adopts it where it lies
+     * (see Buffer::fromExternal) and keeps the underlying storage alive as
+     * long as the view exists, so a codec can hand an embedded payload over
+     * to its consumer without duplicating it. A buffer's own payload is
+     * stored in one contiguous block — sub-buffers are separate buffers
+     * reachable through subBuffer(), not interleaved chunks — so a span
+     * that fits in the remaining payload is always contiguous and never
+     * needs to be assembled.
+     * \param length Number of bytes to extract.
+     * \return A read-only buffer aliasing the span, and the cursor moves
+     * past it; or an empty buffer (cursor unchanged) when fewer than
+     * \a length bytes remain.
+     * \warning As with the pointers returned by read() and peek(), mutating
+     * the source buffer afterwards invalidates the view.
+     */
+    Buffer readBufferView(size_t length);
     /**
      * \brief Move forward the buffer cursor by the given offset.
      * \param offset Value for move forward the cursor.
@@ -291,6 +381,22 @@ namespace qi
 
   namespace detail {
     QI_API void printBuffer(std::ostream& stream, const Buffer& buffer);
+
+    /// Occupancy counters of the calling thread's Buffer storage pool.
+    /// Buffer storage is recycled through a per-thread pool; these counters
+    /// are meant to size it (a high miss count on a messaging thread means
+    /// the pool capacity is too small for the message rate).
+    struct BufferPoolStats
+    {
+      size_t poolSize = 0;     ///< instances currently held by the pool
+      size_t poolCapacity = 0; ///< maximum instances the pool retains
+      uint64_t hits = 0;       ///< creations served from the pool
+      uint64_t misses = 0;     ///< creations that had to allocate
+      uint64_t dropped = 0;    ///< releases deleted because the pool was full
+    };
+
+    /// Return the Buffer pool counters of the calling thread.
+    QI_API BufferPoolStats bufferPoolStats();
   }
 
 }
@@ -71,6 +71,19 @@ namespace qi
 
     /// Returns a time_point representing the current value of the clock.
     static time_point now();
+
+    /**
+     * \brief Cheap, low-resolution variant of now().
+     *
+     * On Linux this reads CLOCK_MONOTONIC_COARSE, which is served from the
+     * vDSO without entering the kernel and is only updated at the kernel
+     * tick: expect a resolution of one to ten milliseconds, and values
+     * lagging now() by up to one tick. On other platforms it is now().
+     * Use it for timestamps taken on every message or log record, where
+     * sub-millisecond precision is wasted; never use it to measure short
+     * intervals.
+     */
+    static time_point nowCoarse();
   };
 
 
@@ -112,6 +125,9 @@ namespace qi
     /// Returns a time_point representing the current value of the clock.
     static time_point now();
 
+    /// \copydoc SteadyClock::nowCoarse()
+    static time_point nowCoarse();
+
     /**
      * \brief Convert the time point to a number of milliseconds on 32 bits.
      *
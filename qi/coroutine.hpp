@@ -0,0 +1,227 @@
+#pragma once
+/*
+**  Copyright (C) 2018 Aldebaran Robotics
+**  See COPYING for the license
+*/
+
+#ifndef _QI_COROUTINE_HPP_
+#define _QI_COROUTINE_HPP_
+
+// Opt-in coroutine (co_await) adapters for qi::Future and qi::Strand.
+//
+// libqi itself still builds as C++11, but its headers are consumed by service
+// code that may be compiled with coroutine support enabled. When that is the
+// case this header lets such code write
+//
+//   qi::Future<int> doWork(qi::AnyObject object, qi::Strand& strand)
+//   {
+//     int value = co_await qi::resumeIn(strand, object.async<int>("method"));
+//     co_return value + 1;
+//   }
+//
+// instead of chains of andThen() lambdas, each of which costs a
+// boost::function allocation; the compiler merges the whole pipeline into a
+// single coroutine frame. Without coroutine support this header is inert.
+
+#if defined(__cpp_impl_coroutine) || (defined(__cpp_coroutines) && __cpp_coroutines >= 201703L)
+#define QI_HAS_COROUTINES 1
+
+#include <exception>
+#include <type_traits>
+#include <utility>
+
+#if defined(__cpp_impl_coroutine)
+# include <coroutine>
+#else
+# include <experimental/coroutine>
+#endif
+
+#include <qi/future.hpp>
+#include <qi/strand.hpp>
+
+namespace qi
+{
+namespace detail
+{
+#if defined(__cpp_impl_coroutine)
+  using std::coroutine_handle;
+  using std::suspend_never;
+#else
+  using std::experimental::coroutine_handle;
+  using std::experimental::suspend_never;
+#endif
+}
+
+/** Awaiter suspending a coroutine until a qi::Future finishes.
+ *
+ * The coroutine resumes in the context that completed the future, i.e. where
+ * a then() callback would have run; pass a strand (see qi::resumeIn) to
+ * resume on it instead. await_resume rethrows future errors and cancellation
+ * as the usual FutureException/FutureUserException.
+ *
+ * \includename{qi/coroutine.hpp}
+ */
+template <typename T>
+class FutureAwaiter
+{
+public:
+  explicit FutureAwaiter(Future<T> future, Strand* strand = nullptr)
+    : _future(std::move(future))
+    , _strand(strand)
+  {}
+
+  bool await_ready() const
+  {
+    return _future.isFinished();
+  }
+
+  void await_suspend(detail::coroutine_handle<> handle)
+  {
+    Strand* strand = _strand;
+    // SyncIfReady: if the future finished between await_ready() and here, the
+    // coroutine resumes right away in this thread instead of being posted to
+    // the event loop.
+    _future.connect([handle, strand](Future<T>) mutable {
+        // No extra post when the completion already runs on the target
+        // strand.
+        if (!strand || strand->isInThisContext())
+          handle.resume();
+        else
+          strand->post([handle]{ handle.resume(); });
+      },
+      FutureCallbackType_SyncIfReady);
+  }
+
+  T await_resume()
+  {
+    if constexpr (std::is_void<T>::value)
+      _future.value(); // throws on error or cancellation
+    else
+      return _future.value();
+  }
+
+private:
+  Future<T> _future;
+  Strand* _strand;
+};
+
+template <typename T>
+FutureAwaiter<T> operator co_await(Future<T> future)
+{
+  return FutureAwaiter<T>(std::move(future));
+}
+
+template <typename T>
+FutureAwaiter<T> operator co_await(FutureSync<T> future)
+{
+  return FutureAwaiter<T>(future.async());
+}
+
+/// Awaits the future but resumes the coroutine on the given strand, unless
+/// the completion callback already runs on it.
+template <typename T>
+FutureAwaiter<T> resumeIn(Strand& strand, Future<T> future)
+{
+  return FutureAwaiter<T>(std::move(future), &strand);
+}
+
+/** Awaiter hopping a coroutine onto a strand: `co_await strand;` continues
+ * execution inside the strand. Ready immediately when already there.
+ *
+ * \includename{qi/coroutine.hpp}
+ */
+class StrandAwaiter
+{
+public:
+  explicit StrandAwaiter(Strand& strand)
+    : _strand(strand)
+  {}
+
+  bool await_ready() const
+  {
+    return _strand.isInThisContext();
+  }
+
+  void await_suspend(detail::coroutine_handle<> handle)
+  {
+    _strand.post([handle]{ handle.resume(); });
+  }
+
+  void await_resume() const
+  {}
+
+private:
+  Strand& _strand;
+};
+
+inline StrandAwaiter operator co_await(Strand& strand)
+{
+  return StrandAwaiter(strand);
+}
+
+namespace detail
+{
+  /// Coroutine promise bridging co_return/exceptions to a qi::Promise, so
+  /// that coroutines can simply return qi::Future<T>.
+  template <typename T>
+  struct FutureCoroutinePromiseBase
+  {
+    qi::Promise<T> _promise;
+
+    detail::suspend_never initial_suspend() const noexcept { return {}; }
+    detail::suspend_never final_suspend() const noexcept { return {}; }
+
+    qi::Future<T> get_return_object() { return _promise.future(); }
+
+    void unhandled_exception()
+    {
+      try
+      {
+        throw;
+      }
+      catch (const std::exception& e)
+      {
+        _promise.setError(e.what());
+      }
+      catch (...)
+      {
+        _promise.setError("Unknown exception in coroutine");
+      }
+    }
+  };
+
+  template <typename T>
+  struct FutureCoroutinePromise : FutureCoroutinePromiseBase<T>
+  {
+    void return_value(T value) { this->_promise.setValue(std::move(value)); }
+  };
+
+  template <>
+  struct FutureCoroutinePromise<void> : FutureCoroutinePromiseBase<void>
+  {
+    void return_void() { this->_promise.setValue(nullptr); }
+  };
+}
+}
+
+#if defined(__cpp_impl_coroutine)
+namespace std
+{
+#else
+namespace std { namespace experimental
+{
+#endif
+  template <typename T, typename... Args>
+  struct coroutine_traits<qi::Future<T>, Args...>
+  {
+    using promise_type = qi::detail::FutureCoroutinePromise<T>;
+  };
+#if defined(__cpp_impl_coroutine)
+}
+#else
+}}
+#endif
+
+#endif // coroutine support
+
+#endif  // _QI_COROUTINE_HPP_
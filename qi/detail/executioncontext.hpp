@@ -51,12 +51,25 @@ struct ExecutionOptions
       and it have been marked as cancel-requested.
   */
   CancelOption onCancelRequested;
+
+  /** Origin tag for per-tag CPU accounting, obtained from
+      qi::registerTaskTag(). 0 (the default) means untagged: the task runs
+      without any timing overhead. \see qi::taskTagStats
+  */
+  unsigned int taskTag;
 };
 
 BOOST_CONSTEXPR
 inline ExecutionOptions defaultExecutionOptions() BOOST_NOEXCEPT
 {
-  return { CancelOption::AllowSkipExecution };
+  return { CancelOption::AllowSkipExecution, 0 };
+}
+
+/// Default options carrying a task tag, for per-tag CPU accounting.
+BOOST_CONSTEXPR
+inline ExecutionOptions taggedExecutionOptions(unsigned int taskTag) BOOST_NOEXCEPT
+{
+  return { CancelOption::AllowSkipExecution, taskTag };
 }
 
 
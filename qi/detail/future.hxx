@@ -51,6 +51,40 @@ namespace detail {
       p.setError("unknown exception");
     }
   }
+
+  // Whether F can be called with a const lvalue of V. Continuations that
+  // cannot (they declared a `V&&` parameter) opt in to receiving the value
+  // moved out of the future's shared state.
+  template <typename F, typename V, typename = void>
+  struct ContinuationAcceptsConstRef : std::false_type {};
+  template <typename F, typename V>
+  struct ContinuationAcceptsConstRef<F, V,
+      decltype(void(std::declval<F&>()(std::declval<const V&>())))> : std::true_type {};
+
+  template <typename F, typename T>
+  auto invokeContinuation(F& continuation, Future<T>& future, std::true_type /*constRef*/)
+      -> decltype(continuation(future.value()))
+  {
+    return continuation(future.value());
+  }
+
+  template <typename F, typename T>
+  auto invokeContinuation(F& continuation, Future<T>& future, std::false_type /*constRef*/)
+      -> decltype(continuation(future.moveValue()))
+  {
+    // The continuation asserted sole consumption by taking an rvalue
+    // reference: hand the value over without a copy.
+    return continuation(future.moveValue());
+  }
+
+  template <typename F, typename T>
+  auto invokeContinuation(F& continuation, Future<T>& future)
+      -> decltype(invokeContinuation(continuation, future,
+            ContinuationAcceptsConstRef<F, typename Future<T>::ValueType>{}))
+  {
+    return invokeContinuation(continuation, future,
+        ContinuationAcceptsConstRef<F, typename Future<T>::ValueType>{});
+  }
 } // namespace detail
 
   template <typename T>
@@ -105,7 +139,7 @@ namespace detail {
     if (callbackType == FutureCallbackType_Auto && isAsync::value)
       callbackType = FutureCallbackType_Sync;
 
-    auto adaptedContinuation = [promise, continuation](const Future<T>& future) mutable
+    auto adaptedContinuation = [promise, continuation](Future<T> future) mutable
     {
       if (future.isCanceled())
         promise.setCanceled();
@@ -115,7 +149,8 @@ namespace detail {
         promise.setCanceled();
       else
         detail::setPromiseFromCallWithExceptionSupport(
-              promise, [&continuation, &future]() mutable { return continuation(future.value()); });
+              promise, [&continuation, &future]() mutable {
+                return detail::invokeContinuation(continuation, future); });
     };
 
     _p->connect(*this, adaptedContinuation, callbackType);
@@ -160,6 +195,7 @@ namespace detail {
     template <typename T>
     FutureBaseTyped<T>::FutureBaseTyped()
       : _value()
+      , _cancelForward(nullptr)
       , _async(FutureCallbackType_Auto)
     {
     }
@@ -176,18 +212,24 @@ namespace detail {
     void FutureBaseTyped<T>::cancel(qi::Future<T>& future)
     {
       CancelCallback onCancel;
+      CancelForwardFn cancelForward = nullptr;
+      boost::weak_ptr<FutureBase> cancelTarget;
       {
         boost::recursive_mutex::scoped_lock lock(mutex());
         if (isFinished())
           return;
         requestCancel();
         std::swap(onCancel, _onCancel);
+        std::swap(cancelForward, _cancelForward);
+        cancelTarget.swap(_cancelForwardTarget);
       }
       if (onCancel)
       {
         qi::Promise<T> prom(future);
         onCancel(prom);
       }
+      if (cancelForward)
+        cancelForward(cancelTarget);
     }
 
     template <typename T>
@@ -197,6 +239,37 @@ namespace detail {
       {
         boost::recursive_mutex::scoped_lock lock(mutex());
         _onCancel = onCancel;
+        _cancelForward = nullptr;
+        _cancelForwardTarget.reset();
+        doCancel = isCancelRequested();
+      }
+      qi::Future<T> fut = promise.future();
+      if (doCancel)
+        cancel(fut);
+    }
+
+    /// Type-restoring thunk stored in the cancel-forwarding slot: recovers
+    /// the source future's concrete type and cancels it.
+    template <typename FT>
+    void forwardCancelToFuture(const boost::weak_ptr<FutureBase>& target)
+    {
+      if (boost::shared_ptr<FutureBase> base = target.lock())
+        futureCancelAdapter<FT>(
+            boost::weak_ptr<FutureBaseTyped<FT> >(
+                boost::static_pointer_cast<FutureBaseTyped<FT> >(base)));
+    }
+
+    template <typename T>
+    template <typename FT>
+    void FutureBaseTyped<T>::setCancelForward(const qi::Promise<T>& promise,
+        const boost::weak_ptr<FutureBaseTyped<FT> >& source)
+    {
+      bool doCancel = false;
+      {
+        boost::recursive_mutex::scoped_lock lock(mutex());
+        _onCancel.clear();
+        _cancelForwardTarget = source;
+        _cancelForward = &forwardCancelToFuture<FT>;
         doCancel = isCancelRequested();
       }
       qi::Future<T> fut = promise.future();
@@ -209,6 +282,10 @@ namespace detail {
     {
       for (const auto& callback : callbacks)
       {
+        // Note that FutureCallbackType_SyncIfReady lands in the async branch
+        // here: the future was not ready when the callback was attached, so
+        // it keeps the regular asynchronous behavior and does not run in the
+        // completer's thread.
         const bool async = [&]{
           if (callback.callType != FutureCallbackType_Auto)
             return callback.callType != FutureCallbackType_Sync;
@@ -332,9 +409,9 @@ namespace detail {
       {
         const bool async = [&]{
           if (type != FutureCallbackType_Auto)
-            return type != FutureCallbackType_Sync;
+            return type != FutureCallbackType_Sync && type != FutureCallbackType_SyncIfReady;
           else
-            return _async != FutureCallbackType_Sync;
+            return _async != FutureCallbackType_Sync && _async != FutureCallbackType_SyncIfReady;
         }();
 
         auto soCalledEventLoop = getEventLoop();
@@ -370,6 +447,14 @@ namespace detail {
       return _value;
     }
 
+    template <typename T>
+    typename FutureBaseTyped<T>::ValueType FutureBaseTyped<T>::takeValue(int msecs)
+    {
+      value(msecs); // waits and throws on invalid state, timeout, cancel or error
+      boost::recursive_mutex::scoped_lock lock(mutex());
+      return std::move(_value);
+    }
+
     template <typename T>
     auto FutureBaseTyped<T>::takeOutResultCallbacks() -> Callbacks
     {
@@ -383,6 +468,8 @@ namespace detail {
     void FutureBaseTyped<T>::clearCancelCallback()
     {
       _onCancel.clear();
+      _cancelForward = nullptr;
+      _cancelForwardTarget.reset();
     }
 
     template <typename T>
@@ -426,38 +513,33 @@ namespace detail {
       {
         Future<Future<T> >* self = static_cast<Future<Future<T> >*>(this);
 
-        Promise<T> promise(boost::bind(&AddUnwrap<Future<T> >::_cancel, _1,
-              boost::weak_ptr<FutureBaseTyped<Future<T> > >(self->_p)));
+        // Cancel-forwarding goes through the native slot of the shared state
+        // and the continuation carries only the promise, so the whole
+        // unwrapping glue costs a single closure allocation.
+        Promise<T> promise;
+        promise.setupCancelForward(
+            boost::weak_ptr<FutureBaseTyped<Future<T> > >(self->_p));
 
-        self->connect(
-            boost::bind(&AddUnwrap<Future<T> >::_forward, _1, promise),
-            FutureCallbackType_Sync);
+        self->connect(Forwarder{promise}, FutureCallbackType_Sync);
 
         return promise.future();
       }
 
     private:
-      static void _forward(const Future<Future<T> >& future,
-          Promise<T>& promise)
+      struct Forwarder
       {
-        if (future.isCanceled())
-          promise.setCanceled();
-        else if (future.hasError())
-          promise.setError(future.error());
-        else
-          adaptFuture(future.value(), promise);
-      }
+        Promise<T> promise;
 
-      static void _cancel(Promise<T>& promise,
-          const boost::weak_ptr<FutureBaseTyped<Future<T> > >& wfuture)
-      {
-        if (boost::shared_ptr<FutureBaseTyped<Future<T> > > fbt =
-            wfuture.lock())
+        void operator()(const Future<Future<T> >& future)
         {
-          Future<Future<T> > future(fbt);
-          future.cancel();
+          if (future.isCanceled())
+            promise.setCanceled();
+          else if (future.hasError())
+            promise.setError(future.error());
+          else
+            adaptFuture(future.value(), promise);
         }
-      }
+      };
     };
 
   } // namespace detail
@@ -498,6 +580,35 @@ namespace detail {
       if (boost::shared_ptr<FutureBaseTyped<FT> > f = wf.lock())
         Future<FT>(f).cancel();
     }
+
+    /* Continuation functors of adaptFuture()/adaptFutureUnwrap(): the target
+     * promise and the converter are stored inline instead of inside a bind
+     * expression, keeping the closure cloned into the callback list as small
+     * as possible.
+     */
+    template<typename FT, typename PT, typename CONV>
+    struct FutureAdapterContinuation
+    {
+      Promise<PT> promise;
+      CONV converter;
+
+      void operator()(const qi::Future<FT>& future)
+      {
+        futureAdapter<FT, PT, CONV>(future, promise, converter);
+      }
+    };
+
+    template<typename R>
+    struct FutureUnwrapContinuation
+    {
+      Promise<R> promise;
+      void (*adapter)(const qi::Future<AnyReference>&, qi::Promise<R>);
+
+      void operator()(const qi::Future<AnyReference>& future)
+      {
+        adapter(future, promise);
+      }
+    };
   }
 
   template <>
@@ -527,29 +638,28 @@ namespace detail {
   template<typename R>
   void adaptFutureUnwrap(Future<AnyReference>& f, Promise<R>& p)
   {
-    p.setup(boost::bind(&detail::futureCancelAdapter<AnyReference>,
-          boost::weak_ptr<detail::FutureBaseTyped<AnyReference> >(f._p)));
-    f.connect(boost::function<void(const qi::Future<AnyReference>&)>(
-          boost::bind(&detail::futureAdapter<R>, _1, p)));
+    p.setupCancelForward(
+        boost::weak_ptr<detail::FutureBaseTyped<AnyReference> >(f._p));
+    f.connect(detail::FutureUnwrapContinuation<R>{p, &detail::futureAdapter<R>});
   }
 
   template<typename FT, typename PT>
   void adaptFuture(const Future<FT>& f, Promise<PT>& p, AdaptFutureOption option)
   {
     if (option == AdaptFutureOption_ForwardCancel)
-      p.setup(boost::bind(&detail::futureCancelAdapter<FT>,
-            boost::weak_ptr<detail::FutureBaseTyped<FT> >(f._p)));
-    const_cast<Future<FT>&>(f).connect(boost::bind(detail::futureAdapter<FT, PT, FutureValueConverter<FT, PT> >, _1, p,
-      FutureValueConverter<FT, PT>()));
+      p.setupCancelForward(boost::weak_ptr<detail::FutureBaseTyped<FT> >(f._p));
+    const_cast<Future<FT>&>(f).connect(
+        detail::FutureAdapterContinuation<FT, PT, FutureValueConverter<FT, PT> >{
+            p, FutureValueConverter<FT, PT>()});
   }
 
   template<typename FT, typename PT, typename CONV>
   void adaptFuture(const Future<FT>& f, Promise<PT>& p, CONV converter, AdaptFutureOption option)
   {
     if (option == AdaptFutureOption_ForwardCancel)
-      p.setup(boost::bind(&detail::futureCancelAdapter<FT>,
-            boost::weak_ptr<detail::FutureBaseTyped<FT> >(f._p)));
-    const_cast<Future<FT>&>(f).connect(boost::bind(detail::futureAdapter<FT, PT, CONV>, _1, p, converter));
+      p.setupCancelForward(boost::weak_ptr<detail::FutureBaseTyped<FT> >(f._p));
+    const_cast<Future<FT>&>(f).connect(
+        detail::FutureAdapterContinuation<FT, PT, CONV>{p, converter});
   }
 
   template <typename T>
@@ -23,6 +23,7 @@
 # include <qi/os.hpp>
 # include <qi/tag.hpp>
 
+# include <boost/container/small_vector.hpp>
 # include <boost/shared_ptr.hpp>
 # include <boost/make_shared.hpp>
 # include <boost/function.hpp>
@@ -75,6 +76,54 @@ namespace qi {
 
     template<typename FT>
     void futureCancelAdapter(boost::weak_ptr<detail::FutureBaseTyped<FT> > wf);
+
+    /** Size-bucketed per-thread pool backing the future/promise shared state.
+     *
+     * Promise/future pairs are created at a very high rate by the messaging
+     * dispatcher, and each one used to cost a heap allocation for the shared
+     * state. These functions recycle the blocks through small thread-local
+     * free lists instead; sizes above the pooled range fall back to the
+     * global allocator. Blocks may be freed from a different thread than the
+     * one that allocated them, they just land in the freeing thread's pool.
+     */
+    QI_API void* allocFutureState(std::size_t size);
+    QI_API void freeFutureState(void* ptr, std::size_t size);
+
+    /// Minimal allocator routing through the future state pool, suitable for
+    /// boost::allocate_shared so the object and its control block come from a
+    /// single pooled allocation.
+    template <typename U>
+    struct FutureStateAllocator
+    {
+      using value_type = U;
+
+      FutureStateAllocator() = default;
+      template <typename V>
+      FutureStateAllocator(const FutureStateAllocator<V>&)
+      {}
+
+      U* allocate(std::size_t n)
+      {
+        return static_cast<U*>(allocFutureState(n * sizeof(U)));
+      }
+
+      void deallocate(U* ptr, std::size_t n)
+      {
+        freeFutureState(ptr, n * sizeof(U));
+      }
+    };
+
+    template <typename U, typename V>
+    bool operator==(const FutureStateAllocator<U>&, const FutureStateAllocator<V>&)
+    {
+      return true;
+    }
+
+    template <typename U, typename V>
+    bool operator!=(const FutureStateAllocator<U>&, const FutureStateAllocator<V>&)
+    {
+      return false;
+    }
   }
 
   /** State of the future.
@@ -104,7 +153,14 @@ namespace qi {
   enum FutureCallbackType {
     FutureCallbackType_Sync  = 0,
     FutureCallbackType_Async = 1,
-    FutureCallbackType_Auto  = 2
+    FutureCallbackType_Auto  = 2,
+    /// Like FutureCallbackType_Async, except that if the future is already
+    /// finished when the callback is attached, the callback runs
+    /// immediately in the attaching thread instead of being posted to the
+    /// event loop. Continuation chains on ready futures thus collapse
+    /// inline without paying a cross-thread hop per link, while a future
+    /// completed later never runs the callback in the completer's thread.
+    FutureCallbackType_SyncIfReady = 3
   };
 
   enum FutureTimeout {
@@ -190,7 +246,8 @@ namespace qi {
 
   public:
     Future()
-      : _p(boost::make_shared<detail::FutureBaseTyped<T> >())
+      : _p(boost::allocate_shared<detail::FutureBaseTyped<T> >(
+            detail::FutureStateAllocator<detail::FutureBaseTyped<T> >()))
     {
     }
 
@@ -265,6 +322,39 @@ namespace qi {
       return value(static_cast<int>(visit(detail::VisitTimeout{}, timeout)));
     }
 
+    /**
+     * @brief Return the value associated to a Future, moved out when possible.
+     *
+     * Same contract as value(), but when this object holds the last reference
+     * to the shared state the value is moved out instead of copied, which
+     * avoids duplicating large payloads (message buffers, vectors) that no
+     * one else can observe anymore. When the state is still shared (other
+     * Future, FutureSync or Promise objects alive), this falls back to a
+     * copy so the other owners keep seeing an intact value.
+     */
+    ValueType takeValue(Either<MilliSeconds, Infinity> timeout = Infinity{})
+    {
+      const int msecs = static_cast<int>(visit(detail::VisitTimeout{}, timeout));
+      if (_p.use_count() == 1)
+        return _p->takeValue(msecs);
+      return _p->value(msecs);
+    }
+
+    /**
+     * @brief Return the value associated to a Future, always moved out.
+     *
+     * Unchecked variant of takeValue(): the value is moved out of the shared
+     * state even when other handles still reference it, leaving a moved-from
+     * value behind for them. Only call this when this consumer is known to
+     * be the last one reading the value; andThen() continuations declaring
+     * an rvalue-reference parameter use it to receive their argument without
+     * a copy.
+     */
+    ValueType moveValue(Either<MilliSeconds, Infinity> timeout = Infinity{})
+    {
+      return _p->takeValue(static_cast<int>(visit(detail::VisitTimeout{}, timeout)));
+    }
+
     /**
      * @brief Return a shared pointer to the value associated to a Future.
      */
@@ -633,6 +723,30 @@ namespace qi {
     static void _weakCancelCb(const boost::weak_ptr<detail::FutureBaseTyped<T> >& wfuture);
   };
 
+  /** Control the process-wide FutureSync destruction policy.
+   *
+   * When enabled, a synchronous FutureSync destroyed on an event-loop thread
+   * does not block: the wait is handed off to a continuation that logs
+   * errors, and a diagnostic counter is incremented. Blocking in an
+   * event-loop thread can starve the loop, or deadlock the process when
+   * completing the future needs that same thread. Disabled by default; can
+   * also be enabled by setting QI_FUTURESYNC_HANDOFF=1 in the environment.
+   */
+  QI_API void setFutureSyncHandOffEnabled(bool enabled);
+  /// \return whether the FutureSync hand-off policy is enabled.
+  QI_API bool futureSyncHandOffEnabled();
+  /// \return how many FutureSync destructions were handed off so far.
+  QI_API uint64_t futureSyncHandOffCount();
+
+  namespace detail
+  {
+    /// \return true when the calling FutureSync destructor must hand the
+    /// wait off instead of blocking: the policy is enabled and the current
+    /// thread belongs to an event loop. Increments the hand-off counter
+    /// when returning true.
+    QI_API bool handOffFutureSyncWait();
+  }
+
   /** This class allow throwing on error and being synchronous
    *  when the future is not handled by the client.
    *
@@ -694,6 +808,15 @@ namespace qi {
     {
       if (_sync)
       {
+        if (!_future.isFinished() && detail::handOffFutureSyncWait())
+        {
+          qiLogWarning("qi.FutureSync")
+            << "Synchronous future destroyed on an event-loop thread: "
+               "handing the wait off instead of blocking.";
+          _future.connect(&FutureSync<T>::_onHandedOff);
+          return;
+        }
+
         static const auto logKnownError = [](const char* message)
         {
           qiLogWarning("qi.FutureSync")
@@ -788,6 +911,13 @@ namespace qi {
     }
 
   protected:
+    static void _onHandedOff(Future<T> future)
+    {
+      if (future.hasError())
+        qiLogWarning("qi.FutureSync")
+          << "Error in handed-off future: '" << future.error() << "'";
+    }
+
     mutable bool _sync;
     Future<T> _future;
     friend class Future<T>;
@@ -918,10 +1048,22 @@ namespace qi {
       this->_f._p->setOnCancel(*this, cancelCallback);
       this->_f._p->_async = async;
     }
+    /// Like setup() for the "cancel forwards to that future" case: the
+    /// target is stored natively in the shared state instead of a
+    /// boost::function closure, saving an allocation per adapted future.
+    template <typename FT>
+    void setupCancelForward(const boost::weak_ptr<detail::FutureBaseTyped<FT> >& source,
+                            FutureCallbackType async = FutureCallbackType_Auto)
+    {
+      this->_f._p->reportStart();
+      this->_f._p->setCancelForward(*this, source);
+      this->_f._p->_async = async;
+    }
     explicit Promise(Future<T>& f) : _f(f) {
       ++_f._p->_promiseCount;
     }
     template<typename> friend class ::qi::detail::FutureBaseTyped;
+    template<typename> friend class ::qi::detail::AddUnwrap;
     Future<T> _f;
 
     template<typename R>
@@ -1001,6 +1143,17 @@ namespace qi {
       void setCanceled(qi::Future<T>& future);
 
       void setOnCancel(const qi::Promise<T>& promise, CancelCallback onCancel);
+
+      /// Native counterpart of setOnCancel() for the very common "cancel
+      /// forwards to that other future" pattern used by the adapters: the
+      /// target and a type-restoring thunk are stored inline in the shared
+      /// state instead of a boost::function closure, which saves the closure
+      /// allocation on every adapted or unwrapped future. The last call to
+      /// either setter wins.
+      template <typename FT>
+      void setCancelForward(const qi::Promise<T>& promise,
+                            const boost::weak_ptr<FutureBaseTyped<FT> >& source);
+
       void setOnDestroyed(boost::function<void (ValueType)> f);
 
       void connect(qi::Future<T> future,
@@ -1009,6 +1162,11 @@ namespace qi {
 
       const ValueType& value(int msecs) const;
 
+      /// Same as value() but transfers the value out of the shared state,
+      /// leaving a moved-from value behind. The caller is responsible for
+      /// ensuring no other owner reads the value afterwards.
+      ValueType takeValue(int msecs);
+
     private:
       friend class Promise<T>;
       using CallbackType = boost::function<void(qi::Future<T>)>;
@@ -1022,10 +1180,17 @@ namespace qi {
           , callType(callType)
         {}
       };
-      using Callbacks = std::vector<Callback>;
+      // Most futures get at most one or two continuations: keep them inline
+      // so the common round trip does not touch the heap for the list.
+      using Callbacks = boost::container::small_vector<Callback, 2>;
+      using CancelForwardFn = void(*)(const boost::weak_ptr<FutureBase>&);
       Callbacks                _onResult;
       ValueType                _value;
       CancelCallback           _onCancel;
+      // Cancel-forwarding slot (see setCancelForward); checked in cancel()
+      // like _onCancel.
+      boost::weak_ptr<FutureBase> _cancelForwardTarget;
+      CancelForwardFn          _cancelForward;
       boost::function<void (ValueType)> _onDestroyed;
       std::atomic<FutureCallbackType> _async;
       qi::Atomic<unsigned int> _promiseCount;
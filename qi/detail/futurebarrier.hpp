@@ -47,6 +47,88 @@ public:
 
 };
 
+/// Flat shared state for the move-in overload of waitForAll: the futures,
+/// the result promise and the countdown live in a single heap block, and
+/// each completion costs one atomic decrement. The count is seeded with one
+/// extra unit owned by the setup loop, so the state cannot complete (and
+/// delete itself) while futures are still being connected.
+template<typename T>
+struct FlatBarrierAllState
+{
+  using ValueType = T;
+
+  explicit FlatBarrierAllState(std::vector<Future<T>>&& futures)
+    : _futures(std::move(futures))
+    , _remaining(static_cast<int>(_futures.size()) + 1)
+  {}
+
+  void onFutureFinish(const Future<T>&)
+  {
+    release();
+  }
+
+  void release()
+  {
+    if (--_remaining == 0)
+    {
+      _promise.setValue(_futures);
+      delete this;
+    }
+  }
+
+  std::vector<Future<T>> _futures;
+  Atomic<int> _remaining;
+  Promise<std::vector<Future<T>>> _promise;
+};
+
+/// Flat shared state for the move-in overload of waitForFirst. Same layout
+/// and lifetime as FlatBarrierAllState, plus a flag resolving the race
+/// between two futures finishing successfully at the same time.
+template<typename T>
+struct FlatBarrierFirstState
+{
+  using ValueType = T;
+
+  explicit FlatBarrierFirstState(size_t futureCount)
+    : _remaining(static_cast<int>(futureCount) + 1)
+  {}
+
+  void onFutureFinish(const Future<T>& future)
+  {
+    if (!future.hasError() && !_done.swap(true))
+      _promise.setValue(future);
+    release();
+  }
+
+  void release()
+  {
+    if (--_remaining == 0)
+    {
+      if (!_done.swap(true))
+        _promise.setValue(makeFutureError<T>("No future returned successfully."));
+      delete this;
+    }
+  }
+
+  Atomic<bool> _done;
+  Atomic<int> _remaining;
+  Promise<Future<T>> _promise;
+};
+
+/// Completion callback of the flat barriers. Pointer-sized and trivially
+/// copyable on purpose: it fits in boost::function's small buffer, so
+/// connecting it to a future does not allocate.
+template<typename State>
+struct FlatBarrierCallback
+{
+  State* state;
+
+  void operator()(const Future<typename State::ValueType>& future) const
+  {
+    state->onFutureFinish(future);
+  }
+};
+
 }
 
 /**
@@ -224,6 +306,74 @@ private:
   }
 };
 
+/**
+ * \brief Cancellation scope shared by a batch of futures.
+ *
+ * \verbatim
+ * Linking cancellations through setOnCancel costs one callback allocation
+ * per link, which adds up when whole batches of speculative operations are
+ * cancelled at once. A CancelGroup instead keeps the futures themselves in
+ * one vector per batch (reserve it upfront with `expectedCount`) and cancels
+ * them in a single sweep.
+ *
+ * Thread-safe: a future added concurrently with cancelAll() is either part
+ * of the sweep or cancelled immediately by add(), it cannot slip through.
+ * The group only keeps futures alive until cancelAll(), so a long-lived
+ * group does not retain finished results.
+ * \endverbatim
+ */
+template <typename T>
+class CancelGroup : boost::noncopyable {
+public:
+  explicit CancelGroup(size_t expectedCount = 0) {
+    if (expectedCount > 0)
+      _futures.reserve(expectedCount);
+  }
+
+  /// Links a future to the group; if the group is already cancelled, the
+  /// future is cancelled right away.
+  void add(qi::Future<T> future) {
+    {
+      boost::mutex::scoped_lock lock(_mutex);
+      if (!_cancelled)
+      {
+        _futures.push_back(std::move(future));
+        return;
+      }
+    }
+    future.cancel();
+  }
+
+  /// Cancels every future added so far and puts the group in the cancelled
+  /// state: later add() calls cancel their future immediately.
+  void cancelAll() {
+    std::vector<qi::Future<T> > futures;
+    {
+      boost::mutex::scoped_lock lock(_mutex);
+      _cancelled = true;
+      futures.swap(_futures);
+    }
+    for (typename std::vector<qi::Future<T> >::iterator it = futures.begin();
+         it != futures.end(); ++it)
+      it->cancel();
+  }
+
+  bool cancelled() const {
+    boost::mutex::scoped_lock lock(_mutex);
+    return _cancelled;
+  }
+
+  size_t pendingCount() const {
+    boost::mutex::scoped_lock lock(_mutex);
+    return _futures.size();
+  }
+
+private:
+  mutable boost::mutex _mutex;
+  std::vector<qi::Future<T> > _futures;
+  bool _cancelled = false;
+};
+
 /**
  * \brief Helper function that creates a future waiting on a vector of futures.
  * \param vect The vector of futures to wait on.
@@ -246,6 +396,42 @@ qi::FutureSync<std::vector<Future<T> > > waitForAll(std::vector<Future<T> >& vec
   return barrier.future();
 }
 
+/**
+ * \brief Overload of waitForAll taking ownership of the futures.
+ * \param vect The vector of futures to wait on, consumed by the call.
+ *
+ * \verbatim
+ * Flat-storage variant for large fan-outs: a single heap block holds the
+ * futures, the result promise and the countdown, completions are counted
+ * with one atomic decrement each, and the vector is delivered back as the
+ * result without per-future bookkeeping.
+ *
+ * Note: Cancelling the returned future cancels all underlying futures.
+ * \endverbatim
+ */
+template <typename T>
+qi::FutureSync<std::vector<Future<T> > > waitForAll(std::vector<Future<T> >&& vect) {
+  auto state = new detail::FlatBarrierAllState<T>(std::move(vect));
+  qi::Future<std::vector<Future<T> > > result = state->_promise.future();
+  {
+    // The state dies with its last count, so cancellation works on copies of
+    // the handles rather than through the state.
+    std::vector<Future<T> > handles = state->_futures;
+    state->_promise.setOnCancel(
+        [handles](qi::Promise<std::vector<Future<T> > >&) mutable {
+          for (auto& future: handles)
+            future.cancel();
+        });
+  }
+  for (auto& future: state->_futures)
+    future.connect(detail::FlatBarrierCallback<detail::FlatBarrierAllState<T> >{state},
+                   FutureCallbackType_Sync);
+  // Release the count owned by this setup loop; this resolves the result
+  // right away when the vector is empty or everything already finished.
+  state->release();
+  return result;
+}
+
 /**
  * \brief Helper function to wait for the first valid future.
  * \param vect The vector of futures to wait on.
@@ -269,6 +455,27 @@ qi::FutureSync< qi::Future<T> > waitForFirst(std::vector< Future<T> >& vect) {
   return prom.future();
 }
 
+/**
+ * \brief Overload of waitForFirst taking ownership of the futures.
+ * \param vect The vector of futures to wait on, consumed by the call.
+ *
+ * \verbatim
+ * Flat-storage variant for large fan-outs: one heap block, one atomic
+ * countdown, no per-future bookkeeping. Unlike the lvalue overload, an empty
+ * vector yields an immediate error instead of a future that never finishes.
+ * \endverbatim
+ */
+template <typename T>
+qi::FutureSync< qi::Future<T> > waitForFirst(std::vector< Future<T> >&& vect) {
+  auto state = new detail::FlatBarrierFirstState<T>(vect.size());
+  qi::Future< qi::Future<T> > result = state->_promise.future();
+  for (auto& future: vect)
+    future.connect(detail::FlatBarrierCallback<detail::FlatBarrierFirstState<T> >{state},
+                   FutureCallbackType_Sync);
+  state->release();
+  return result;
+}
+
 }
 
 #endif
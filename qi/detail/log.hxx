@@ -16,6 +16,11 @@
 
 // #include <locale>  TODO: Use these includes when they become available on all platforms,
 // #include <codecvt> instead of replaced by boost.locale
+#include <atomic>
+#include <cstring>
+#include <ostream>
+#include <streambuf>
+#include <string>
 #include <type_traits>
 
 #include <ka/typetraits.hpp>
@@ -105,6 +110,35 @@
   while (false)
 #endif
 
+/* Deferred variant: no message is built here, the format string and the
+ * argument values are captured into a DeferredLogRecord and the consumer
+ * side formats. Arguments must be small trivially copyable values (see
+ * makeDeferredLog below).
+ */
+#if defined(NO_QI_LOG_DETAILED_CONTEXT) || defined(NDEBUG)
+#  define _QI_LOG_MESSAGE_DEFERRED(Type, Msg, ...)                       \
+  do                                                                     \
+  {                                                                      \
+    if (::qi::log::isVisible(_QI_LOG_CATEGORY_GET(), ::qi::Type))        \
+      ::qi::log::log(::qi::Type,                                         \
+                     _QI_LOG_CATEGORY_GET(),                             \
+                     ::qi::log::detail::makeDeferredLog(Msg, ##__VA_ARGS__), \
+                     "", __FUNCTION__, 0);                               \
+  }                                                                      \
+  while (false)
+#else
+#  define _QI_LOG_MESSAGE_DEFERRED(Type, Msg, ...)                       \
+  do                                                                     \
+  {                                                                      \
+    if (::qi::log::isVisible(_QI_LOG_CATEGORY_GET(), ::qi::Type))        \
+      ::qi::log::log(::qi::Type,                                         \
+                     _QI_LOG_CATEGORY_GET(),                             \
+                     ::qi::log::detail::makeDeferredLog(Msg, ##__VA_ARGS__), \
+                     __FILE__, __FUNCTION__, __LINE__);                  \
+  }                                                                      \
+  while (false)
+#endif
+
 /* Tricky, we do not want to hit category_get if a category is specified
 * Usual glitch of off-by-one list size: put argument 'TypeCased' in the vaargs
 * Basically we want variadic macro, but it does not exist, so emulate it using _QI_LOG_EMPTY.
@@ -219,7 +253,9 @@ namespace qi {
         {}
 
         std::string               name;
-        qi::LogLevel              maxLevel; //max level among all subscribers
+        // max level among all subscribers; atomic so that the hot-path
+        // visibility check is a single relaxed load with no lock
+        std::atomic<qi::LogLevel> maxLevel; //max level among all subscribers
         std::vector<qi::LogLevel> levels;   //level by subscribers
 
         void setLevel(SubscriberId sub, qi::LogLevel level);
@@ -227,6 +263,99 @@ namespace qi {
 
       QI_API boost::format getFormat(const std::string& s);
 
+      /// Feeds the value stored in `storage` back to the format object;
+      /// instantiated per argument type by captureDeferredLogArg.
+      template <typename T>
+      void applyDeferredLogArg(boost::format& fmt, const void* storage)
+      {
+        T value;
+        memcpy(&value, storage, sizeof(T));
+        fmt % value;
+      }
+
+      template <typename T>
+      void captureDeferredLogArg(DeferredLogRecord& record, const T& value)
+      {
+        static_assert(std::is_trivially_copyable<T>::value,
+                      "deferred log arguments must be trivially copyable, "
+                      "use the qiLog*F macros for anything else");
+        static_assert(sizeof(T) <= sizeof(DeferredLogArg::storage),
+                      "deferred log arguments must fit the inline storage, "
+                      "use the qiLog*F macros for bigger values");
+        DeferredLogArg& arg = record.args[record.argCount++];
+        arg.apply = &applyDeferredLogArg<T>;
+        memcpy(arg.storage, &value, sizeof(T));
+      }
+
+      /// String literals decay to a captured const char*: safe because a
+      /// literal outlives the record, which is all the deferred API allows.
+      template <size_t N>
+      void captureDeferredLogArg(DeferredLogRecord& record, const char (&value)[N])
+      {
+        const char* pointer = value;
+        captureDeferredLogArg(record, pointer);
+      }
+
+      inline void fillDeferredLog(DeferredLogRecord&)
+      {
+      }
+
+      template <typename T, typename... Args>
+      void fillDeferredLog(DeferredLogRecord& record, const T& value, const Args&... rest)
+      {
+        captureDeferredLogArg(record, value);
+        fillDeferredLog(record, rest...);
+      }
+
+      /// Builds the record handed to qi::log::log() by the qiLog*D macros.
+      /// The format string is captured by pointer and must be a literal.
+      template <typename... Args>
+      DeferredLogRecord makeDeferredLog(const char* format, const Args&... args)
+      {
+        static_assert(sizeof...(Args) <= DeferredLogRecord::maxArgs,
+                      "too many arguments for a deferred log statement");
+        DeferredLogRecord record;
+        record.format = format;
+        record.argCount = 0;
+        fillDeferredLog(record, args...);
+        return record;
+      }
+
+      /// Formatting buffer borrowed from a per-thread pool, so building a
+      /// log statement reuses warm capacity instead of allocating. The
+      /// buffer comes back empty and must be returned with
+      /// releaseLogBuffer() (nesting is fine: a log issued while another
+      /// statement is being built simply borrows the next buffer).
+      QI_API std::string* acquireLogBuffer();
+      QI_API void releaseLogBuffer(std::string* buffer);
+
+      /// Minimal streambuf appending straight into a reusable std::string,
+      /// which is all LogStream needs from an ostringstream.
+      class AppendStreamBuf : public std::streambuf
+      {
+      public:
+        explicit AppendStreamBuf(std::string& out)
+          : _out(out)
+        {}
+
+      protected:
+        int_type overflow(int_type c) override
+        {
+          if (!traits_type::eq_int_type(c, traits_type::eof()))
+            _out.push_back(traits_type::to_char_type(c));
+          return traits_type::not_eof(c);
+        }
+
+        std::streamsize xsputn(const char* s, std::streamsize n) override
+        {
+          _out.append(s, static_cast<size_t>(n));
+          return n;
+        }
+
+      private:
+        std::string& _out;
+      };
+
       // given a set of rules in the format documented in the public header,
       // return a list of (category name, LogLevel) tuples.
       QI_API std::vector<std::tuple<std::string, qi::LogLevel>> parseFilterRules(
@@ -249,7 +378,9 @@ namespace qi {
     //inlined for perf
     inline bool isVisible(CategoryType category, qi::LogLevel level)
     {
-      return category && level <= category->maxLevel;
+      // One relaxed load: qiLogCategory caches the category pointer per
+      // callsite, so disabled statements in hot loops cost just this check.
+      return category && level <= category->maxLevel.load(std::memory_order_relaxed);
     }
 
     using CategoryType = detail::Category*;
@@ -266,7 +397,10 @@ namespace qi {
                 const char         *function,
                 const int          line,
                 const char         *category)
-        : _logLevel(level)
+        : _buffer(detail::acquireLogBuffer())
+        , _streambuf(*_buffer)
+        , _os(&_streambuf)
+        , _logLevel(level)
         , _category(category)
         , _categoryType(0)
         , _file(file)
@@ -279,7 +413,10 @@ namespace qi {
                 const char         *function,
                 const int          line,
                 CategoryType       category)
-        : _logLevel(level)
+        : _buffer(detail::acquireLogBuffer())
+        , _streambuf(*_buffer)
+        , _os(&_streambuf)
+        , _logLevel(level)
         , _category(0)
         , _categoryType(category)
         , _file(file)
@@ -293,7 +430,10 @@ namespace qi {
                 const int           line,
                 const char         *category,
                 const std::string&  message)
-        : _logLevel(level)
+        : _buffer(detail::acquireLogBuffer())
+        , _streambuf(*_buffer)
+        , _os(&_streambuf)
+        , _logLevel(level)
         , _category(category)
         , _categoryType(0)
         , _file(file)
@@ -306,9 +446,10 @@ namespace qi {
       ~LogStream()
       {
         if (_category)
-          qi::log::log(_logLevel, _category, this->str().c_str(), _file, _function, _line);
+          qi::log::log(_logLevel, _category, _buffer->c_str(), _file, _function, _line);
         else
-          qi::log::log(_logLevel, _categoryType, this->str(), _file, _function, _line);
+          qi::log::log(_logLevel, _categoryType, *_buffer, _file, _function, _line);
+        detail::releaseLogBuffer(_buffer);
       }
 
       LogStream& self() { return *this; }
@@ -320,12 +461,12 @@ namespace qi {
        */
       inline std::string str() const
       {
-        return _oss.str();
+        return *_buffer;
       }
 
       explicit inline operator bool() const
       {
-        return static_cast<bool>(_oss);
+        return static_cast<bool>(_os);
       }
 
       template <typename T>
@@ -335,20 +476,24 @@ namespace qi {
         // defined in the global namespace to be used in this function, declare that we use the
         // overload in the global namespace.
         using ::operator<<;
-        l._oss << detail::narrow(std::forward<T>(t));
+        l._os << detail::narrow(std::forward<T>(t));
         return l;
       }
 
       /* overload for std::endl and other manipulators */
       friend inline LogStream& operator<<(LogStream& l, std::ostream& (*pf) (std::ostream&))
       {
-        l._oss << pf;
+        l._os << pf;
         return l;
       }
 
     private:
 
-      std::ostringstream _oss;
+      // The statement is built in a pooled per-thread buffer, so the
+      // steady-state cost of a log statement has no allocation in it.
+      std::string*  _buffer;
+      detail::AppendStreamBuf _streambuf;
+      std::ostream  _os;
       qi::LogLevel  _logLevel;
       const char   *_category;
       CategoryType  _categoryType;
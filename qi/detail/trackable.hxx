@@ -11,6 +11,7 @@
 #include <type_traits>
 #include <boost/function.hpp>
 #include <boost/bind.hpp>
+#include <boost/make_shared.hpp>
 #include <boost/weak_ptr.hpp>
 #include <boost/function_types/result_type.hpp>
 
@@ -21,6 +22,7 @@ namespace qi
   template<typename T>
   inline Trackable<T>::Trackable()
   : _wasDestroyed(false)
+  , _trackState(boost::make_shared<detail::TrackState>())
   {
     T* thisAsT = static_cast<T*>(this);
     _ptr = boost::shared_ptr<T>(thisAsT, boost::bind(&Trackable::_destroyed, _1));
@@ -29,13 +31,21 @@ namespace qi
   template<typename T>
   inline Trackable<T>::Trackable(T* ptr)
     : _wasDestroyed(false)
+    , _trackState(boost::make_shared<detail::TrackState>())
   {
     _ptr = boost::shared_ptr<T>(ptr, boost::bind(&Trackable::_destroyed, _1));
   }
 
+  template<typename T>
+  inline boost::shared_ptr<detail::TrackState> Trackable<T>::trackState() const
+  {
+    return _trackState;
+  }
+
   template<typename T>
   inline void Trackable<T>::destroy()
   {
+    _trackState->beginDestroy();
     _ptr.reset();
     wait();
   }
@@ -126,6 +136,48 @@ namespace qi
       }
     };
 
+    // Functor that guards a call with the shared tracking state of a
+    // Trackable: entering is one atomic increment, where locking a weak
+    // pointer loops on a compare-and-swap of the use count. The pointee
+    // stays alive for the duration of the call because destroy() drains
+    // the calls in flight; the state itself is co-owned, so invocations
+    // arriving after the object died remain a safe, failing check.
+    template <typename F>
+    class EnterAndCall
+    {
+      boost::shared_ptr<TrackState> _state;
+      F _f;
+      boost::function<void()> _onFail;
+
+      struct CallScope
+      {
+        TrackState* state;
+        ~CallScope() { state->endCall(); }
+      };
+
+    public:
+      EnterAndCall(boost::shared_ptr<TrackState> state, F func,
+                   boost::function<void()> onFail)
+        : _state(std::move(state))
+        , _f(std::move(func))
+        , _onFail(std::move(onFail))
+      {}
+
+      template <typename... Args>
+      auto operator()(Args&&... args)
+        -> decltype(std::declval<F>()(std::forward<Args>(args)...))
+      {
+        if (_state->tryBeginCall())
+        {
+          CallScope scope{_state.get()};
+          return _f(std::forward<Args>(args)...);
+        }
+        if (_onFail)
+          _onFail();
+        return defaultConstruct<decltype(this->_f(std::forward<Args>(args)...))>();
+      }
+    };
+
     template <typename T, bool IsActor>
     struct ObjectWrap;
 
@@ -215,21 +267,18 @@ namespace qi
     struct BindTransformImpl<T*, true>
     {
       template <typename F>
-      using wrap_type = LockAndCall<boost::weak_ptr<T>, typename std::decay<F>::type>;
+      using wrap_type = EnterAndCall<typename std::decay<F>::type>;
 
       static T* transform(T* arg)
       {
-        // Note that we assume that lock if successful always return the same pointer
+        // Note that we assume that the pointee does not move while tracked
         return arg;
       }
 
       template <typename F>
       static wrap_type<F> wrap(T* arg, F&& func, boost::function<void()> onFail)
       {
-        return LockAndCall<boost::weak_ptr<T>, typename std::decay<F>::type>(
-            arg->weakPtr(),
-            std::forward<F>(func),
-            onFail);
+        return wrap_type<F>(arg->trackState(), std::forward<F>(func), std::move(onFail));
       }
     };
 
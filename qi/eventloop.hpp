@@ -11,6 +11,9 @@
 #  pragma warning( disable: 4503 ) // decorated name length
 # endif
 
+# include <string>
+# include <vector>
+
 # include <boost/thread/synchronized_value.hpp>
 # include <boost/function.hpp>
 
@@ -29,6 +32,43 @@ namespace qi
 {
   template<typename T> class Future;
 
+  /**
+   * \brief Attributes applied to every worker thread of an event loop.
+   *
+   * Meant for real-time deployments where the I/O threads must stay off
+   * the isolated control-loop cores and run at elevated priority, instead
+   * of patching the threads from outside after they spawn.
+   */
+  struct EventLoopThreadAttributes
+  {
+    /// CPU indexes the workers are allowed to run on; empty keeps the
+    /// system default. \see qi::os::setCurrentThreadCPUAffinity
+    std::vector<int> cpuAffinity;
+    /// Real-time priority of the workers; 0 keeps the default scheduling
+    /// policy. \see qi::os::setCurrentThreadRealtimePriority
+    int realtimePriority = 0;
+  };
+
+  /**
+   * \brief Snapshot of the queue-delay statistics of an event loop.
+   *
+   * The loop timestamps one posted task out of N (QI_EVENTLOOP_LAG_SAMPLE_RATE,
+   * 64 by default, 0 disables sampling) and records how long it sat in the
+   * queue before starting to execute. The histogram buckets are log-scaled:
+   * <100us, <1ms, <10ms, <100ms, <1s, and the rest.
+   */
+  struct EventLoopLagStats
+  {
+    static const unsigned bucketCount = 6;
+    /// Number of sampled tasks.
+    uint64_t samples = 0;
+    /// Cumulated and worst sampled queue delay.
+    Duration totalLag = Duration(0);
+    Duration maxLag = Duration(0);
+    /// Queue-delay histogram (see the struct documentation).
+    uint64_t buckets[bucketCount] = {};
+  };
+
   class EventLoopPrivate;
   /**
    * \brief Class to handle eventloop.
@@ -44,8 +84,12 @@ namespace qi
      *   - the value of the environment variable QI_EVENTLOOP_THREAD_COUNT if it's set,
      *   - the value returned by std::thread::hardware_concurrency() if it's greater than 3,
      *   - the fixed value of 3.
+     * \param spawnOnOverload Spawn extra threads when the pool is blocked.
+     * \param threadAttributes Scheduling attributes applied to every worker
+     *        thread of the pool, including the ones spawned on overload.
      */
-    explicit EventLoop(std::string name = "eventloop", int nthreads = 0, bool spawnOnOverload = true);
+    explicit EventLoop(std::string name = "eventloop", int nthreads = 0, bool spawnOnOverload = true,
+                       EventLoopThreadAttributes threadAttributes = EventLoopThreadAttributes());
 
     /// \brief Default destructor.
     ~EventLoop();
@@ -91,6 +135,21 @@ namespace qi
      */
     void setMaxThreads(unsigned int max);
 
+    /**
+     * \brief Number of worker threads currently running in the pool.
+     * \note It is safe to call this method concurrently. The value is a
+     *       snapshot: pools spawning threads on overload may grow after it
+     *       is read. Used for instance by qi::parallelFor to size its chunks.
+     */
+    unsigned int workerCount() const;
+
+    /**
+     * \brief Snapshot of the passive queue-delay sampling statistics.
+     * \note It is safe to call this method concurrently.
+     * \see EventLoopLagStats
+     */
+    EventLoopLagStats lagStats() const;
+
     /// \brief Internal function.
     void *nativeHandle();
 
@@ -148,12 +207,17 @@ namespace qi
     using ExecutionContext::post;
 
     /**
-     * \brief Monitors event loop to detect deadlocks.
-     * \param helper an other event loop used for monitoring.
-     * \param maxUsDelay maximum expected delay between an async() and its execution.
+     * \brief Monitors event loop responsiveness.
+     * \param helper unused, kept for source compatibility. The lag is now
+     *        sampled passively on the monitored loop itself, so no helper
+     *        loop and no ping tasks are needed anymore.
+     * \param maxUsDelay maximum expected delay between a post and its execution.
      * \return A canceleable future. Invoke cancel() to terminate monitoring.
-     *         In case an async() call does not execute in time, the
-     *         future's error will be set.
+     *         The future's error is set the first time a sampled queue delay
+     *         exceeds maxUsDelay.
+     * \note Detection relies on the sampling controlled by
+     *       QI_EVENTLOOP_LAG_SAMPLE_RATE: a short spike can fall between two
+     *       samples, and disabling sampling disables monitoring.
      */
     Future<void> monitorEventLoop(EventLoop* helper, uint64_t maxUsDelay);
 
@@ -180,15 +244,52 @@ namespace qi
     ) override;
   };
 
+  /**
+   * \brief Accumulated execution time of the tasks carrying one tag.
+   * \see qi::registerTaskTag
+   */
+  struct TaskTagStats
+  {
+    /// Name given to registerTaskTag().
+    std::string name;
+    /// Number of tagged tasks that ran to completion or threw.
+    uint64_t taskCount = 0;
+    /// Cumulated execution (wall) time of those tasks, in microseconds.
+    uint64_t totalTimeUs = 0;
+  };
+
+  /**
+   * \brief Registers a task-origin name and returns its tag.
+   *
+   * Put the tag in ExecutionOptions::taskTag (see taggedExecutionOptions)
+   * when posting to an event loop, and the loop accumulates the execution
+   * time of those tasks under the name, so saturation can be attributed to
+   * its origins with qi::taskTagStats(). Registering the same name twice
+   * returns the same tag. The registry is process-wide and bounded; once
+   * full, 0 (untagged) is returned and a warning is logged.
+   */
+  QI_API unsigned int registerTaskTag(const std::string& name);
+
+  /// \brief Snapshot of the per-tag execution time table, one row per
+  /// registered tag, in registration order.
+  QI_API std::vector<TaskTagStats> taskTagStats();
+
   /// \brief Returns the global eventloop, created on demand on first call.
   QI_API EventLoop* getEventLoop();
 
   /// \brief Returns the global network eventloop, created on demand on first call.
+  ///
+  /// This pool only services socket I/O and timers; user callbacks run on the
+  /// global eventloop. Its size defaults to one thread and can be changed
+  /// with QI_EVENTLOOP_NETWORK_THREAD_COUNT.
   QI_API EventLoop* getNetworkEventLoop();
 
   /**
    * \brief Starts the eventloop with nthread threads. Does nothing if already started.
    * \param nthread Set the minimum number of worker threads in the pool.
+   *
+   * Also starts the network eventloop, so that both pools are up before the
+   * first connection.
    */
   QI_API void startEventLoop(int nthread);
 
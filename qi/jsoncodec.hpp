@@ -7,8 +7,11 @@
 #ifndef _QI_TYPE_JSONCODEC_HPP_
 #define _QI_TYPE_JSONCODEC_HPP_
 
+#include <boost/function.hpp>
+
 #include <qi/api.hpp>
 #include <qi/anyvalue.hpp>
+#include <qi/buffer.hpp>
 
 namespace qi {
 
@@ -24,6 +27,32 @@ namespace qi {
    */
   QI_API std::string encodeJSON(const qi::AutoAnyReference &val, JsonOption jsonPrintOption = JsonOption_None);
 
+  /// Receives successive chunks of an encoded JSON document.
+  using JsonSink = boost::function<void(const char* data, size_t size)>;
+
+  /** Encode \p val in JSON, streaming the output to \p sink.
+   *
+   * The document is handed to \p sink in successive in-order chunks as it
+   * is produced instead of being accumulated in one string, so a large
+   * value (a multi-megabyte diagnostic dump...) is encoded with bounded
+   * memory and can go straight to a socket or a file. The concatenation of
+   * the chunks is exactly the document the string-returning overload
+   * produces.
+   * @param val Value to encode
+   * @param sink Callback invoked with each output chunk.
+   * @param jsonPrintOption Option to change JSON output
+   */
+  QI_API void encodeJSON(const qi::AutoAnyReference &val, const JsonSink& sink,
+                         JsonOption jsonPrintOption = JsonOption_None);
+
+  /** Encode \p val in JSON appended to \p out, chunk by chunk.
+   * @param val Value to encode
+   * @param out Buffer receiving the document.
+   * @param jsonPrintOption Option to change JSON output
+   */
+  QI_API void encodeJSON(const qi::AutoAnyReference &val, Buffer& out,
+                         JsonOption jsonPrintOption = JsonOption_None);
+
   /**
     * creates a GV representing a JSON string or throw on parse error.
     * @param in JSON string to decode.
@@ -42,7 +71,28 @@ namespace qi {
                                          const std::string::const_iterator &end,
                                          AnyValue &target);
 
+  /**
+    * decode a JSON string directly into an existing typed value, or throw
+    * std::runtime_error on parse error or type mismatch.
+    *
+    * Unlike the AnyValue overloads above, no intermediate dynamic tree is
+    * built: the parser writes straight into \a target, guided by its
+    * TypeInterface, which is considerably faster on large documents with a
+    * known schema. Dynamic members of \a target still go through the
+    * dynamic parser. Objects may list their keys in any order; keys that
+    * do not name a struct member are skipped.
+    * @param in JSON string to decode.
+    * @param target reference to the typed value to fill.
+    */
+  QI_API void decodeJSON(const std::string &in, AnyReference target);
 
+  /** Typed helper in the style of decodeBinary: decode \a in into \a value.
+    */
+  template <typename T>
+  void decodeJSON(const std::string &in, T* value)
+  {
+    decodeJSON(in, AnyReference::fromPtr(value));
+  }
 
 }
 
@@ -54,6 +54,37 @@
   static ::qi::log::CategoryType _QI_LOG_CATEGORY_GET() QI_ATTR_UNUSED = \
     ::qi::log::addCategory(Cat)
 
+/**
+ * \verbatim
+ * Compile-time maximum log level: statements above QI_LOG_MAX_LEVEL are
+ * removed from codegen entirely, like the per-level NO_QI_* switches.
+ * Levels are numeric: 0 silent, 1 fatal, 2 error, 3 warning, 4 info,
+ * 5 verbose, 6 debug. For instance build a release robot image with
+ * -DQI_LOG_MAX_LEVEL=4 to strip every qiLogDebug/qiLogVerbose statement,
+ * including the evaluation of their operands.
+ * \endverbatim
+ */
+#ifdef QI_LOG_MAX_LEVEL
+# if QI_LOG_MAX_LEVEL < 6 && !defined(NO_QI_DEBUG)
+#  define NO_QI_DEBUG
+# endif
+# if QI_LOG_MAX_LEVEL < 5 && !defined(NO_QI_VERBOSE)
+#  define NO_QI_VERBOSE
+# endif
+# if QI_LOG_MAX_LEVEL < 4 && !defined(NO_QI_INFO)
+#  define NO_QI_INFO
+# endif
+# if QI_LOG_MAX_LEVEL < 3 && !defined(NO_QI_WARNING)
+#  define NO_QI_WARNING
+# endif
+# if QI_LOG_MAX_LEVEL < 2 && !defined(NO_QI_ERROR)
+#  define NO_QI_ERROR
+# endif
+# if QI_LOG_MAX_LEVEL < 1 && !defined(NO_QI_FATAL)
+#  define NO_QI_FATAL
+# endif
+#endif
+
 
 /**
  * \verbatim
@@ -72,9 +103,11 @@
 #if defined(NO_QI_DEBUG) || defined(NDEBUG)
 # define qiLogDebug(...) ::qi::log::detail::qiFalse() && false < qi::log::detail::NullStream().self()
 # define qiLogDebugF(Msg, ...) do {} while(0)
+# define qiLogDebugD(Msg, ...) do {} while(0)
 #else
 # define qiLogDebug(...)   _QI_LOG_MESSAGE_STREAM(LogLevel_Debug,   Debug ,  __VA_ARGS__)
 # define qiLogDebugF(Msg, ...)   _QI_LOG_MESSAGE(LogLevel_Debug,   _QI_LOG_FORMAT(Msg, __VA_ARGS__))
+# define qiLogDebugD(Msg, ...)   _QI_LOG_MESSAGE_DEFERRED(LogLevel_Debug, Msg, ##__VA_ARGS__)
 #endif
 
 /**
@@ -83,9 +116,11 @@
 #if defined(NO_QI_VERBOSE)
 # define qiLogVerbose(...) ::qi::log::detail::qiFalse() && false < qi::log::detail::NullStream().self()
 # define qiLogVerboseF(Msg, ...) do {} while(0)
+# define qiLogVerboseD(Msg, ...) do {} while(0)
 #else
 # define qiLogVerbose(...) _QI_LOG_MESSAGE_STREAM(LogLevel_Verbose, Verbose, __VA_ARGS__)
 # define qiLogVerboseF(Msg, ...)   _QI_LOG_MESSAGE(LogLevel_Verbose,   _QI_LOG_FORMAT(Msg, __VA_ARGS__))
+# define qiLogVerboseD(Msg, ...)   _QI_LOG_MESSAGE_DEFERRED(LogLevel_Verbose, Msg, ##__VA_ARGS__)
 #endif
 
 /**
@@ -94,9 +129,11 @@
 #if defined(NO_QI_INFO)
 # define qiLogInfo(...) ::qi::log::detail::qiFalse() && false < qi::log::detail::NullStream().self()
 # define qiLogInfoF(Msg, ...) do {} while(0)
+# define qiLogInfoD(Msg, ...) do {} while(0)
 #else
 # define qiLogInfo(...)    _QI_LOG_MESSAGE_STREAM(LogLevel_Info,    Info,    __VA_ARGS__)
 # define qiLogInfoF(Msg, ...)   _QI_LOG_MESSAGE(LogLevel_Info,   _QI_LOG_FORMAT(Msg, __VA_ARGS__))
+# define qiLogInfoD(Msg, ...)   _QI_LOG_MESSAGE_DEFERRED(LogLevel_Info, Msg, ##__VA_ARGS__)
 #endif
 
 /**
@@ -105,9 +142,11 @@
 #if defined(NO_QI_WARNING)
 # define qiLogWarning(...) ::qi::log::detail::qiFalse() && false < qi::log::detail::NullStream().self()
 # define qiLogWarningF(Msg, ...) do {} while(0)
+# define qiLogWarningD(Msg, ...) do {} while(0)
 #else
 # define qiLogWarning(...) _QI_LOG_MESSAGE_STREAM(LogLevel_Warning, Warning, __VA_ARGS__)
 # define qiLogWarningF(Msg, ...)   _QI_LOG_MESSAGE(LogLevel_Warning,   _QI_LOG_FORMAT(Msg, __VA_ARGS__))
+# define qiLogWarningD(Msg, ...)   _QI_LOG_MESSAGE_DEFERRED(LogLevel_Warning, Msg, ##__VA_ARGS__)
 #endif
 
 /**
@@ -116,9 +155,11 @@
 #if defined(NO_QI_ERROR)
 # define qiLogError(...)   ::qi::log::detail::qiFalse() && false < qi::log::detail::NullStream().self()
 # define qiLogErrorF(Msg, ...) do {} while(0)
+# define qiLogErrorD(Msg, ...) do {} while(0)
 #else
 # define qiLogError(...)   _QI_LOG_MESSAGE_STREAM(LogLevel_Error,   Error,   __VA_ARGS__)
 # define qiLogErrorF(Msg, ...)   _QI_LOG_MESSAGE(LogLevel_Error,   _QI_LOG_FORMAT(Msg, __VA_ARGS__))
+# define qiLogErrorD(Msg, ...)   _QI_LOG_MESSAGE_DEFERRED(LogLevel_Error, Msg, ##__VA_ARGS__)
 #endif
 
 /**
@@ -127,9 +168,11 @@
 #if defined(NO_QI_FATAL)
 # define qiLogFatal(...)  ::qi::log::detail::qiFalse() && false < qi::log::detail::NullStream().self()
 # define qiLogFatalF(Msg, ...) do {} while(0)
+# define qiLogFatalD(Msg, ...) do {} while(0)
 #else
 # define qiLogFatal(...)   _QI_LOG_MESSAGE_STREAM(LogLevel_Fatal,   Fatal,   __VA_ARGS__)
 # define qiLogFatalF(Msg, ...)   _QI_LOG_MESSAGE(LogLevel_Fatal,   _QI_LOG_FORMAT(Msg, __VA_ARGS__))
+# define qiLogFatalD(Msg, ...)   _QI_LOG_MESSAGE_DEFERRED(LogLevel_Fatal, Msg, ##__VA_ARGS__)
 #endif
 
 
@@ -206,6 +249,31 @@ namespace qi {
   namespace log {
     namespace detail {
       struct Category;
+
+      /// Type-erased capture of one argument of a deferred log statement:
+      /// the value lives inline in `storage` and `apply` feeds it to the
+      /// record's boost::format when the consumer side builds the message.
+      struct DeferredLogArg
+      {
+        void (*apply)(boost::format& fmt, const void* storage);
+        char storage[16];
+      };
+
+      /// A log record whose message is not formatted yet: the qiLog*D
+      /// macros capture the format string and the argument values here and
+      /// the asynchronous log thread does the formatting, so the calling
+      /// thread only pays for the copy of a few scalar values.
+      ///
+      /// The format string and any const char* argument are captured by
+      /// pointer: they must outlive the record, so only pass literals or
+      /// static strings. Use the qiLog*F macros for anything dynamic.
+      struct DeferredLogRecord
+      {
+        static const unsigned int maxArgs = 4;
+        const char* format;
+        unsigned int argCount;
+        DeferredLogArg args[maxArgs];
+      };
     }
 
     using SubscriberId = unsigned int; ///< Subscriber Identifier.
@@ -364,6 +432,20 @@ namespace qi {
                     const char*        fct = "",
                     const int          line = 0);
 
+    /**
+     * \brief Deferred-formatting log function, used by the qiLog*D macros.
+     *
+     * The record's format string and arguments are copied into the log
+     * queue as-is and the message is only formatted by the consumer
+     * thread (or immediately when synchronous logging is enabled).
+     */
+    QI_API void log(const qi::LogLevel              verb,
+                    CategoryType                    category,
+                    const detail::DeferredLogRecord& record,
+                    const char*                     file = "",
+                    const char*                     fct = "",
+                    const int                       line = 0);
+
 
     /**
      * \brief Convert log verbosity to a readable string.
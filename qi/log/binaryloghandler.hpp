@@ -0,0 +1,94 @@
+#pragma once
+/*
+ * Copyright (c) 2012 Aldebaran Robotics. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the COPYING file.
+ */
+
+#ifndef _QI_LOG_BINARYLOGHANDLER_HPP_
+#define _QI_LOG_BINARYLOGHANDLER_HPP_
+
+#include <boost/noncopyable.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <qi/log.hpp>
+
+namespace qi
+{
+namespace log
+{
+  struct PrivateBinaryLogHandler;
+
+  /**
+   * \includename{qi/log/binaryloghandler.hpp}
+   *
+   * This class writes all logs to a file as fixed-layout binary records
+   * instead of formatting text at log time: numeric timestamps, a category
+   * id (the category name is written once, the first time it is seen), the
+   * thread id, the line number and the raw message bytes. Writing a record
+   * is a couple of memcpy and one unformatted write, which is an order of
+   * magnitude cheaper than text formatting and shrinks on-device writes.
+   *
+   * The file starts with the magic "QILG" followed by a format version;
+   * records are written in the host's byte order. Use
+   * tools/qilog-bin2txt.py to render such a file as text offline.
+   *
+   * Register it through the normal API:
+   * \code
+   * qi::log::BinaryLogHandler handler("/var/log/naoqi.qilog");
+   * qi::log::addLogHandler("binarylog",
+   *     boost::bind(&qi::log::BinaryLogHandler::log, &handler,
+   *                 _1, _2, _3, _4, _5, _6, _7, _8));
+   * \endcode
+   */
+  class QI_API BinaryLogHandler : private boost::noncopyable
+  {
+  public:
+    /**
+     * \brief Initialize the handler on the file. File is opened directly on construction.
+     * \param filePath the path to the file where log records will be written.
+     *
+     * \verbatim
+     * .. warning::
+     *
+     *      If the file could not be opened, it logs a warning and every log call
+     *      will silently fail.
+     * \endverbatim
+     */
+    explicit BinaryLogHandler(const std::string& filePath);
+
+    /**
+     * \brief Flushes and closes the file.
+     */
+    ~BinaryLogHandler();
+
+    /**
+     * \brief Write one binary log record to the file.
+     * \param verb verbosity of the log message.
+     * \param date qi::Clock date at which the log message was issued.
+     * \param systemDate qi::SystemClock date at which the log message was issued.
+     * \param category will be used in future for filtering
+     * \param msg actual message to log.
+     * \param file filename from which this log message was issued (not recorded).
+     * \param fct function name from which this log message was issued (not recorded).
+     * \param line line number in the issuer file.
+     *
+     * Unlike the text handlers, records are not flushed one by one; the file
+     * is flushed when the handler is destroyed.
+     */
+    void log(const qi::LogLevel verb,
+             const qi::Clock::time_point date,
+             const qi::SystemClock::time_point systemDate,
+             const char* category,
+             const char* msg,
+             const char* file,
+             const char* fct,
+             const int line);
+
+  private:
+    boost::scoped_ptr<PrivateBinaryLogHandler> _p;
+  }; // !BinaryLogHandler
+
+}; // !log
+}; // !qi
+
+#endif // _QI_LOG_BINARYLOGHANDLER_HPP_
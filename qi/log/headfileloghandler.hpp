@@ -24,6 +24,15 @@ namespace log
    *
    * This class writes the logs to a file, providing they are part of the first
    * ``length`` lines.
+   *
+   * On platforms with mmap, the file is written through memory-mapped
+   * segments of QI_LOG_MMAP_SEGMENT_KB kilobytes (default 256): records are
+   * appended with a bump pointer and synced in the background with
+   * msync(MS_ASYNC), so the log consumer thread pays no write syscall per
+   * record and a crash or power cut loses little. The trailing zero padding
+   * of the last segment is trimmed when the handler closes the file; after
+   * a hard crash the file may keep that padding. Platforms without mmap,
+   * or a failed mapping, fall back to buffered FILE I/O as before.
    */
   class QI_API HeadFileLogHandler : private boost::noncopyable
   {
@@ -30,6 +30,14 @@ namespace log
      *   environment variable
      *   (only if QI_SYSLOG_IDENTIFIER is defined and not empty).
      *
+     * When the native journald socket is reachable, records are serialized
+     * in the journal wire format and submitted in batches (one sendmmsg
+     * call for up to QI_JOURNALD_BATCH records, default 64), instead of one
+     * sd_journal_send round trip per record. A batch is flushed when full,
+     * when a record of level Error or Fatal arrives, or when its oldest
+     * record is older than QI_JOURNALD_FLUSH_MS (default 100). Set
+     * QI_JOURNALD_BATCH to 0 or 1 to disable batching.
+     *
      * The returned handler is not thread-safe, which is fine: libqi does not
      * call its log handlers concurrently.
      */
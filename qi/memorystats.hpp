@@ -0,0 +1,61 @@
+#pragma once
+/*
+**  Copyright (C) 2018 Aldebaran Robotics
+**  See COPYING for the license
+*/
+
+#ifndef _QI_MEMORYSTATS_HPP_
+#define _QI_MEMORYSTATS_HPP_
+
+#include <qi/api.hpp>
+#include <qi/anyobject.hpp>
+#include <qi/types.hpp>
+
+namespace qi
+{
+  /// Point-in-time snapshot of the memory held by libqi's main dynamic
+  /// pools and queues (see qi::memoryStats()).
+  ///
+  /// The counters are maintained with relaxed atomics on the allocation
+  /// paths, so they are cheap enough to stay always-on. A snapshot is taken
+  /// counter by counter and is therefore not a consistent cut; it tells
+  /// buffers from leaks and sizes pools, it does not balance books to the
+  /// byte.
+  struct QI_API MemoryStats
+  {
+    /// Live qi::Buffer backing stores, and the heap bytes they own. The
+    /// inline small-buffer storage and adopted external memory are not
+    /// counted: the former is part of the instance, the latter is not ours.
+    qi::uint64_t bufferCount = 0;
+    qi::uint64_t bufferHeapBytes = 0;
+    /// Buffer backing stores parked in the per-thread recycling pools,
+    /// summed over all threads.
+    qi::uint64_t pooledBufferCount = 0;
+    /// Open messaging sockets, and the bytes waiting in their send queues.
+    qi::uint64_t socketCount = 0;
+    qi::uint64_t sendQueueBytes = 0;
+    /// Live future/promise shared states, and the ones parked in the
+    /// per-thread recycling pools.
+    qi::uint64_t futureCount = 0;
+    qi::uint64_t pooledFutureCount = 0;
+  };
+
+  /// Snapshot of the process-wide memory accounting. Cheap enough to poll
+  /// periodically from a watchdog; also reachable through
+  /// Session::memoryStats() for code that already holds a session.
+  QI_API MemoryStats memoryStats();
+
+  namespace detail
+  {
+    /// Per-subsystem probes combined by qi::memoryStats(); each one is
+    /// defined next to the counters it reads.
+    QI_API void bufferMemoryStats(MemoryStats& stats); // src/buffer.cpp
+    QI_API void futureMemoryStats(MemoryStats& stats); // src/future.cpp
+    QI_API void socketMemoryStats(MemoryStats& stats); // src/messaging/messagesocket.cpp
+  }
+}
+
+QI_TYPE_STRUCT(qi::MemoryStats, bufferCount, bufferHeapBytes, pooledBufferCount,
+               socketCount, sendQueueBytes, futureCount, pooledFutureCount);
+
+#endif  // _QI_MEMORYSTATS_HPP_
@@ -0,0 +1,50 @@
+#pragma once
+/*
+**  Copyright (C) 2018 Softbank Robotics
+**  See COPYING for the license
+*/
+
+#ifndef _QIMESSAGING_CALLDEADLINE_HPP_
+#define _QIMESSAGING_CALLDEADLINE_HPP_
+
+#include <qi/api.hpp>
+#include <qi/clock.hpp>
+
+namespace qi
+{
+  /// Give the calls issued by the current thread a completion deadline
+  /// while this object is alive.
+  ///
+  /// A call that has not completed when its budget runs out fails with a
+  /// "call deadline expired" error on the caller side. The budget also
+  /// travels with the call, so a server that dequeues the request after
+  /// the deadline replies with the same error instead of doing the work.
+  ///
+  /// Typical use, on a node where stale answers are worthless:
+  /// ~~~
+  /// qi::ScopedCallDeadline deadline{qi::MilliSeconds(50)};
+  /// auto pose = localization.async<Pose>("estimatePose");
+  /// ~~~
+  ///
+  /// The marker is per-thread and the previous budget is restored on
+  /// destruction, so scopes can nest.
+  class QI_API ScopedCallDeadline
+  {
+  public:
+    explicit ScopedCallDeadline(qi::Duration budget);
+    ~ScopedCallDeadline();
+    ScopedCallDeadline(const ScopedCallDeadline&) = delete;
+    ScopedCallDeadline& operator=(const ScopedCallDeadline&) = delete;
+  private:
+    qi::Duration _previous;
+  };
+
+  namespace detail
+  {
+    /// Budget the calls issued by the current thread are given,
+    /// Duration::zero() when they have none.
+    QI_API qi::Duration currentCallDeadline();
+  }
+}
+
+#endif  // _QIMESSAGING_CALLDEADLINE_HPP_
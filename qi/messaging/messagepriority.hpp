@@ -0,0 +1,55 @@
+#pragma once
+/*
+**  Copyright (C) 2018 Aldebaran Robotics
+**  See COPYING for the license
+*/
+
+#ifndef _QIMESSAGING_MESSAGEPRIORITY_HPP_
+#define _QIMESSAGING_MESSAGEPRIORITY_HPP_
+
+#include <qi/api.hpp>
+
+namespace qi
+{
+  /// Transport priority of the messages produced by outgoing calls.
+  ///
+  /// High-priority messages are placed in a latency-critical lane of the
+  /// socket send queue: they go out before queued normal-priority traffic
+  /// (bulk transfers, telemetry, logs) sharing the same session, without
+  /// preempting the write already in progress.
+  enum class MessagePriority
+  {
+    Normal = 0,
+    High = 1,
+  };
+
+  /// Mark the calls and posts issued by the current thread as
+  /// latency-critical while this object is alive.
+  ///
+  /// Typical use, in a control loop sharing a session with bulk traffic:
+  /// ~~~
+  /// qi::ScopedMessagePriority priority{qi::MessagePriority::High};
+  /// motion.async<void>("setStiffnesses", names, stiffnesses);
+  /// ~~~
+  ///
+  /// The marker is per-thread and the previous priority is restored on
+  /// destruction, so scopes can nest.
+  class QI_API ScopedMessagePriority
+  {
+  public:
+    explicit ScopedMessagePriority(MessagePriority priority);
+    ~ScopedMessagePriority();
+    ScopedMessagePriority(const ScopedMessagePriority&) = delete;
+    ScopedMessagePriority& operator=(const ScopedMessagePriority&) = delete;
+  private:
+    MessagePriority _previous;
+  };
+
+  namespace detail
+  {
+    /// Priority that messages produced by the current thread are marked with.
+    QI_API MessagePriority currentMessagePriority();
+  }
+}
+
+#endif  // _QIMESSAGING_MESSAGEPRIORITY_HPP_
@@ -0,0 +1,59 @@
+#pragma once
+/*
+**  Copyright (C) 2018 Aldebaran Robotics
+**  See COPYING for the license
+*/
+
+#ifndef _QIMESSAGING_REPLYDELIVERY_HPP_
+#define _QIMESSAGING_REPLYDELIVERY_HPP_
+
+#include <qi/api.hpp>
+
+namespace qi
+{
+  /// How reply futures of outgoing calls complete their continuations.
+  ///
+  /// By default a reply coming back from the network completes the call
+  /// future through the event loop, and a continuation bound to a strand
+  /// is then re-posted to that strand: two scheduler hops per call. With
+  /// inline delivery the future completes directly on the network thread,
+  /// so plain continuations run there immediately and strand-bound
+  /// continuations are posted to their strand in a single hop.
+  enum class ReplyDelivery
+  {
+    Scheduled = 0,
+    Inline = 1,
+  };
+
+  /// Deliver the replies of the calls issued by the current thread inline
+  /// while this object is alive.
+  ///
+  /// Typical use, for a latency-sensitive call:
+  /// ~~~
+  /// qi::ScopedReplyDelivery delivery{qi::ReplyDelivery::Inline};
+  /// motion.async<float>("getStiffness", name).connect(...);
+  /// ~~~
+  ///
+  /// Continuations of inline replies run on the network thread: they must
+  /// not block, or they stall every message of the socket they share.
+  /// The marker is per-thread and the previous mode is restored on
+  /// destruction, so scopes can nest.
+  class QI_API ScopedReplyDelivery
+  {
+  public:
+    explicit ScopedReplyDelivery(ReplyDelivery delivery);
+    ~ScopedReplyDelivery();
+    ScopedReplyDelivery(const ScopedReplyDelivery&) = delete;
+    ScopedReplyDelivery& operator=(const ScopedReplyDelivery&) = delete;
+  private:
+    ReplyDelivery _previous;
+  };
+
+  namespace detail
+  {
+    /// Delivery mode of the replies to calls issued by the current thread.
+    QI_API ReplyDelivery currentReplyDelivery();
+  }
+}
+
+#endif  // _QIMESSAGING_REPLYDELIVERY_HPP_
@@ -121,6 +121,22 @@ public:
   /// @returns The previous filter
   Future<ServiceFilter> setServiceFilter(ServiceFilter filter
      = ka::constant_function(false));
+
+  /// Builds a service filter from an allow-list of service names. A name may
+  /// contain '*' wildcards, each matching any sequence of characters.
+  /// Services matching none of the patterns are filtered out. Meant to be
+  /// passed to setServiceFilter() by perimeter proxies that expose only a
+  /// few services out of a large directory.
+  static ServiceFilter allowListServiceFilter(std::vector<std::string> allowedPatterns);
+
+  /// Enables or disables lazy mirroring of the services coming from the
+  /// service directory. When enabled, a service is not mirrored when it
+  /// appears on the directory: the connection to the service and its
+  /// registration on the proxy only happen the first time a client asks for
+  /// it by name, so unused services cost neither an upstream connection nor
+  /// a bound object. Deferred services do not appear in the proxy's service
+  /// list until then. Disabling it mirrors the deferred services right away.
+  Future<void> setLazyMirroring(bool enabled);
 };
 
 QI_API std::ostream& operator<<(std::ostream&, ServiceDirectoryProxy::IdValidationStatus);
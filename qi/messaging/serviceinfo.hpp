@@ -11,6 +11,7 @@
 #include <vector>
 
 #include <qi/api.hpp>
+#include <qi/types.hpp>
 #include <qi/url.hpp>
 #include <qi/type/typeinterface.hpp>
 
@@ -48,6 +49,22 @@ namespace qi
   };
 
   using ServiceInfoVector = std::vector<qi::ServiceInfo>;
+
+  /// One entry of a batched directory notification
+  /// (ServiceDirectory::servicesChanged). `sequence` grows by one per
+  /// change; watchers keep the last value they saw and pass it to
+  /// changesSince() to fetch one delta after a reconnection instead of
+  /// replaying individual events.
+  struct ServiceDirectoryChange
+  {
+    unsigned int serviceId = 0;
+    std::string  name;
+    bool         added = false; ///< false: service removed
+    qi::uint64_t sequence = 0;
+  };
+  using ServiceDirectoryChangeVector = std::vector<qi::ServiceDirectoryChange>;
 } // !qi
 
+QI_TYPE_STRUCT(qi::ServiceDirectoryChange, serviceId, name, added, sequence);
+
 #endif  // _QIMESSAGING_SERVICEINFO_HPP_
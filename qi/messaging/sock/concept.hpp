@@ -170,6 +170,10 @@ namespace qi { namespace sock {
 ///     proc2(procArgs...);
 ///     which means that `wrap` returns a procedure accepting the same parameters
 ///     as `proc` but returning `void`.
+///   With Procedure<void ()> proc3 the following is valid:
+///     io.post(proc3);
+///     which schedules `proc3` to be called later by the io service, never
+///     from inside `post` itself.
 /// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 /// An io service wrap a procedure (typically a network handler) to strand it.
 ///
@@ -296,12 +300,18 @@ namespace qi { namespace sock {
 ///     && N::setSocketNativeOptionsWindows(handle, i) if compiled on Windows
 ///     && N::setSocketNativeOptionsLinux(handle, i) if compiled on Linux
 ///     && N::setSocketNativeOptionsMacOs(handle) if compiled on MacOs
+///     && bool b = N::trySetFastOpenConnect(lowest);
+///         (asks the platform to defer the TCP handshake to the first write
+///          and merge both; false when unsupported, which is not an error)
 ///     && MutableBufferSequence mutable_bufs = N::buffer(data, maxSizeInBytes);
 ///         (MutableBufferSequence only constrained by the following)
 ///     && ConstBufferSequence const_bufs = N::buffer(const_data, maxSizeInBytes);
 ///         (ConstBufferSequence only constrained by the following)
 ///     && N::async_read(sslSocketLValue, mutable_bufs, transferHandler)
 ///     && N::async_read(sslSocketLValue.next_layer(), mutable_bufs, transferHandler)
+///     && N::async_read_some(sslSocketLValue.next_layer(), mutable_bufs, transferHandler)
+///         (completes after one transfer of at least one byte, instead of
+///          filling the whole buffer)
 ///     && N::async_write(sslSocketLValue, const_bufs, transferHandler)
 ///     && N::async_write(sslSocketLValue.next_layer(), const_bufs, transferHandler)
 /// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -315,6 +325,22 @@ namespace qi { namespace sock {
 /// It has been designed to closely fit Boost.Asio, so as to incur no performance
 /// overhead.
 /// Another model is a mock for unit tests.
+///
+/// # Non-IP protocol families
+///
+/// The concept as stated assumes an IP protocol family: endpoints expose
+/// `address().is_v6()`, resolver queries are built from a host and a port,
+/// and the SSL socket wraps a TCP stream. A model for a local protocol
+/// family (Unix domain sockets, for instance, for a "uds://" or "local://"
+/// scheme) must additionally provide:
+/// - an endpoint type constructible from a filesystem path, with the
+///   IpV6Enabled option and the v6-filtering in resolve.hpp bypassed;
+/// - a trivial resolver whose single entry is the path endpoint, since
+///   there is no name resolution step;
+/// - an acceptor bound to the path, with stale-socket-file cleanup where
+///   reuse_address would be used for TCP.
+/// The states in connectingstate.hpp and connectedstate.hpp are otherwise
+/// protocol-agnostic: they only use the operations listed above.
 namespace concept // To allow doc tools to extract this documentation.
 {
 }
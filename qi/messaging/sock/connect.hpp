@@ -2,6 +2,9 @@
 #ifndef _QI_SOCK_CONNECT_HPP
 #define _QI_SOCK_CONNECT_HPP
 #include <string>
+#include <vector>
+#include <boost/make_shared.hpp>
+#include <boost/thread/mutex.hpp>
 #include <qi/messaging/sock/concept.hpp>
 #include <qi/messaging/sock/traits.hpp>
 #include <qi/messaging/sock/error.hpp>
@@ -11,6 +14,7 @@
 #include <ka/src.hpp>
 #include <qi/url.hpp>
 #include <qi/future.hpp>
+#include <qi/async.hpp>
 #include <qi/clock.hpp>
 #include <ka/macroregular.hpp>
 #include <ka/moveoncopy.hpp>
@@ -66,6 +70,12 @@ namespace qi { namespace sock {
   /// If present and connection is not ssl, a tcp ping timeout will be set.
   /// For ssl connections, a "no delay" option is set.
   ///
+  /// When TCP Fast Open is enabled (see `tcpFastOpenEnabledFromEnv`), the
+  /// socket is opened by hand beforehand so the fast-open option can be set:
+  /// the kernel then defers the TCP handshake to the first write and, on a
+  /// warm reconnection to a peer it holds a fast-open cookie for, carries
+  /// that write's data in the SYN, saving a round trip.
+  ///
   /// Network N,
   /// With NetSslSocket S and Mutable<S> M:
   ///   S is compatible with N,
@@ -75,8 +85,22 @@ namespace qi { namespace sock {
   template<typename N, typename M, typename H,
            typename Proc, typename Proc1 = ka::constant_function_t<void>>
   void connect(M socket, const Entry<Resolver<N>>& entry, Proc onComplete, SslEnabled ssl, H side,
-               const boost::optional<Seconds>& tcpPingTimeout, Proc1 setupStop = Proc1{})
+               const boost::optional<Seconds>& tcpPingTimeout,
+               const UrlSocketOptions& urlOptions = UrlSocketOptions{},
+               Proc1 setupStop = Proc1{})
   {
+    if (tcpFastOpenEnabledFromEnv())
+    {
+      auto& lowestLayer = (*socket).lowest_layer();
+      ErrorCode<N> openErc;
+      lowestLayer.open(entry.endpoint().protocol(), openErc);
+      if (!openErc)
+      {
+        N::trySetFastOpenConnect(lowestLayer);
+      }
+      // If opening failed, `async_connect` opens the socket itself and
+      // reports any error, as it always did.
+    }
     (*socket).lowest_layer().async_connect(entry,
       [=](ErrorCode<N> erc) mutable { // onConnectDone
         if (erc)
@@ -85,7 +109,7 @@ namespace qi { namespace sock {
           return;
         }
         // Options can be set only once the socket is connected.
-        setSocketOptions<N>(socket, tcpPingTimeout);
+        setSocketOptions<N>(socket, tcpPingTimeout, urlOptions);
         if (*ssl)
         {
           sslHandshake<N>(socket, side, onComplete, setupStop);
@@ -99,6 +123,147 @@ namespace qi { namespace sock {
     setupStop(socket);
   }
 
+  namespace detail
+  {
+    /// Delay between the starts of two consecutive connection attempts when
+    /// racing several resolved endpoints (see connectFirstOf). The default
+    /// follows the happy-eyeballs recommendation (RFC 8305) and can be tuned
+    /// with the QI_CONNECT_ATTEMPT_DELAY environment variable (milliseconds).
+    inline MilliSeconds connectAttemptDelay()
+    {
+      static const int ms = os::getEnvParam<int>("QI_CONNECT_ATTEMPT_DELAY", 250);
+      return MilliSeconds{ms};
+    }
+
+    /// Shared state of a race between several connection attempts: the first
+    /// attempt to complete wins and cancels the others by closing their
+    /// sockets; the race fails only once every attempt has failed.
+    ///
+    /// Network N,
+    /// With NetSslSocket S and Mutable<S> M:
+    ///   S is compatible with N,
+    ///   Procedure<void (ErrorCode<N>, M)> Proc
+    template<typename N, typename M, typename Proc>
+    struct ConnectRace
+    {
+      Proc onComplete;
+      std::size_t remaining;   ///< Attempts that have not completed yet.
+      bool done = false;       ///< The winner, or the final error, was signaled.
+      std::vector<M> inFlight; ///< Sockets of started attempts, for cancelation.
+      ErrorCode<N> lastError;
+      boost::mutex mutex;
+
+      ConnectRace(Proc onComplete, std::size_t count)
+        : onComplete(onComplete)
+        , remaining(count)
+      {
+      }
+    };
+  } // namespace detail
+
+  /// Starts one connection attempt per given endpoint, each delayed by
+  /// `detail::connectAttemptDelay()` relatively to the previous one, and
+  /// completes with the first socket that connects (and handshakes, for ssl)
+  /// successfully. This is the happy-eyeballs scheme: endpoints are tried in
+  /// resolver order and the stagger only costs something when an earlier
+  /// endpoint is unresponsive — exactly the case where serializing the
+  /// attempts would burn a full TCP timeout per stale endpoint.
+  ///
+  /// Losing sockets are closed as soon as a winner is known. If every attempt
+  /// fails, the last error is reported.
+  ///
+  /// Precondition: !entries.empty()
+  ///
+  /// Network N,
+  /// With NetSslSocket S and Mutable<S> M:
+  ///   S is compatible with N,
+  ///   HandshakeSide<S> H,
+  ///   Procedure<M ()> Proc0,
+  ///   Procedure<void (ErrorCode<N>, M)> Proc1,
+  ///   Procedure<void (M)> Proc2
+  template<typename N, typename H, typename Proc0, typename Proc1,
+           typename Proc2 = ka::constant_function_t<void>>
+  void connectFirstOf(const std::vector<Entry<Resolver<N>>>& entries, SslEnabled ssl,
+                      Proc0 makeSocket, H side, Proc1 onComplete,
+                      const boost::optional<Seconds>& tcpPingTimeout,
+                      const UrlSocketOptions& urlOptions = UrlSocketOptions{},
+                      Proc2 setupStop = Proc2{})
+  {
+    using M = decltype(createSocket<N>(ssl, makeSocket));
+    auto race = boost::make_shared<detail::ConnectRace<N, M, Proc1>>(onComplete, entries.size());
+    for (std::size_t i = 0u; i != entries.size(); ++i)
+    {
+      const Entry<Resolver<N>> entry = entries[i];
+      auto startAttempt = [=]() mutable {
+        M socket;
+        {
+          boost::mutex::scoped_lock lock(race->mutex);
+          // An earlier attempt already completed the race: nothing to do.
+          // Skipped attempts need no accounting because the race outcome was
+          // already signaled.
+          if (race->done)
+            return;
+          socket = createSocket<N>(ssl, makeSocket);
+          race->inFlight.push_back(socket);
+        }
+        connect<N>(socket, entry,
+          [=](ErrorCode<N> erc, M s) mutable { // onAttemptDone
+            std::vector<M> toClose;
+            bool won = false, failedAll = false;
+            {
+              boost::mutex::scoped_lock lock(race->mutex);
+              if (race->done)
+              {
+                // Lost against an attempt that already completed the race
+                // (typically: the winner closed this socket, which surfaced
+                // here as an "operation aborted" error).
+                if (!erc)
+                  toClose.push_back(s);
+              }
+              else
+              {
+                --race->remaining;
+                if (erc)
+                {
+                  race->lastError = erc;
+                  if (race->remaining == 0u)
+                  { // Every attempt has failed: report the last error.
+                    race->done = true;
+                    failedAll = true;
+                  }
+                }
+                else
+                {
+                  race->done = true;
+                  won = true;
+                  for (const M& m: race->inFlight)
+                    if (m != s)
+                      toClose.push_back(m);
+                  race->inFlight.clear();
+                }
+              }
+            }
+            // Closing a pending attempt makes its handler run with an error
+            // and find the race done.
+            for (M& m: toClose)
+            {
+              ErrorCode<N> ignored;
+              (*m).lowest_layer().close(ignored);
+            }
+            if (won)
+              race->onComplete(success<ErrorCode<N>>(), s);
+            else if (failedAll)
+              race->onComplete(race->lastError, M{});
+          },
+          ssl, side, tcpPingTimeout, urlOptions, setupStop);
+      };
+      if (i == 0u)
+        startAttempt();
+      else
+        asyncDelay(startAttempt, detail::connectAttemptDelay() * static_cast<int>(i));
+    }
+  }
+
   /// Connects to a URL and gives the created socket by calling a handler.
   ///
   /// See `ResolveUrl` for the URL format.
@@ -142,7 +307,9 @@ namespace qi { namespace sock {
   /// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
   ///
   /// From a more technical point of view, the different connecting steps
-  /// are: URL resolving, socket connecting and SSL handshake if needed.
+  /// are: URL resolving (served by a process-wide cache when enabled, see
+  /// detail::ResolveCache), socket connecting (all resolved endpoints are
+  /// raced, see connectFirstOf) and SSL handshake if needed.
   ///
   /// Network N,
   /// With NetSslSocket S:
@@ -150,11 +317,10 @@ namespace qi { namespace sock {
   template<typename N, typename S>
   class ConnectSocket
   {
-    using OptionalEntry = boost::optional<Entry<Resolver<N>>>;
     using Handshake = HandshakeSide<S>;
-    ResolveUrl<N> _resolve;
+    ResolveUrlList<N> _resolve;
   public:
-  // QuasiRegular (if ResolveUrl<N> is QuasiRegular):
+  // QuasiRegular (if ResolveUrlList<N> is QuasiRegular):
     KA_GENERATE_FRIEND_REGULAR_OPS_1(ConnectSocket, _resolve)
   // Custom:
     explicit ConnectSocket(IoService<N>& io)
@@ -173,21 +339,66 @@ namespace qi { namespace sock {
         Proc2 setupStop = Proc2{})
     {
       using namespace ka;
-      auto& io = _resolve.getIoService();
-      _resolve(url, ipV6,
-        [=, &io](const ErrorCode<N>& erc, const OptionalEntry& entry) mutable { // onResolved
-          if (erc)
+      // Socket options can be carried by the URL query; its keep-alive
+      // timeout takes precedence over the configured ping timeout.
+      const auto urlOptions = urlSocketOptions(url);
+      const auto pingTimeout =
+          urlOptions.keepAliveTimeout ? urlOptions.keepAliveTimeout : tcpPingTimeout;
+
+      // Starts the connection attempts from an unfiltered resolution result.
+      auto connectWithEntries = [=](const std::vector<Entry<Resolver<N>>>& allEntries) mutable {
+        const auto entries =
+            detail::allValidEntries(allEntries.begin(), allEntries.end(), ipV6);
+        if (entries.empty())
+        {
+          onComplete(hostNotFound<ErrorCode<N>>(), {});
+          return;
+        }
+        connectFirstOf<N>(entries, ssl, makeSocket, side, onComplete, pingTimeout,
+                          urlOptions, setupStop);
+      };
+
+      const bool useCache = url.isValid() && detail::resolveCacheTtl().count() > 0;
+      const std::string cacheKey = useCache ? detail::resolveCacheKey(url) : std::string{};
+      if (useCache)
+      {
+        const auto hit = detail::ResolveCache<N>::instance().find(
+            cacheKey, detail::resolveCacheTtl());
+        if (hit)
+        {
+          if (hit->revalidate)
           {
-            onComplete(erc, {});
-            return;
+            // Serve the stale result right away, but refresh the cache in
+            // the background so later connections get up-to-date endpoints.
+            _resolve(url, [cacheKey](const ErrorCode<N>& erc, Iterator<Resolver<N>> it) {
+              detail::ResolveCache<N>::instance().endRevalidation(cacheKey, erc,
+                erc ? std::vector<Entry<Resolver<N>>>{}
+                    : detail::allValidEntries(it, Iterator<Resolver<N>>{}, IpV6Enabled{true}));
+            });
           }
-          if (!entry)
+          if (hit->negative)
+            onComplete(hit->error, {});
+          else
+            connectWithEntries(hit->entries);
+          return;
+        }
+      }
+      _resolve(url,
+        [=](const ErrorCode<N>& erc, Iterator<Resolver<N>> it) mutable { // onResolved
+          if (erc)
           {
-            onComplete(hostNotFound<ErrorCode<N>>(), {});
+            // An aborted resolution says nothing about the name: do not
+            // cache it.
+            if (useCache && erc != operationAborted<ErrorCode<N>>())
+              detail::ResolveCache<N>::instance().storeFailure(cacheKey, erc);
+            onComplete(erc, {});
             return;
           }
-          auto socket = createSocket<N>(ssl, makeSocket);
-          connect<N>(socket, entry.value(), onComplete, ssl, side, tcpPingTimeout, setupStop);
+          const auto allEntries =
+              detail::allValidEntries(it, Iterator<Resolver<N>>{}, IpV6Enabled{true});
+          if (useCache)
+            detail::ResolveCache<N>::instance().store(cacheKey, allEntries);
+          connectWithEntries(allEntries);
         },
         setupStop
       );
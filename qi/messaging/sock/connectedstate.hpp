@@ -219,6 +219,11 @@ namespace qi
       {
         return _impl->send(std::forward<Msg>(msg), ssl, onSent);
       }
+      /// Bytes currently waiting in the send queue (headers included).
+      std::size_t sendQueueBytes() const
+      {
+        return _impl->_sendMsg.queuedBytes();
+      }
       Future<SyncConnectedResultPtr<N, S>> complete() const
       {
         return _impl->_completePromise->future();
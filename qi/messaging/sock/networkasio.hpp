@@ -22,6 +22,8 @@ namespace qi { namespace sock {
     using ssl_context_type = boost::asio::ssl::context;
     using ssl_socket_type = boost::asio::ssl::stream<boost::asio::ip::tcp::socket>;
     using socket_option_no_delay_type = boost::asio::ip::tcp::no_delay;
+    using socket_option_receive_buffer_size_type = boost::asio::socket_base::receive_buffer_size;
+    using socket_option_send_buffer_size_type = boost::asio::socket_base::send_buffer_size;
     using accept_option_reuse_address_type = boost::asio::ip::tcp::acceptor::reuse_address;
     using error_code_type = boost::system::error_code;
     using io_service_type = boost::asio::io_service;
@@ -42,12 +44,68 @@ namespace qi { namespace sock {
     /// Warning: On some platform (e.g. MacOs), timeout might be ignored.
     static void setSocketNativeOptions(boost::asio::ip::tcp::socket::native_handle_type h, int timeoutInSeconds);
 
+    /// Asks the kernel to defer the TCP handshake of this (open, not yet
+    /// connected) socket to its first write (TCP_FASTOPEN_CONNECT): when a
+    /// fast-open cookie from a previous connection to the peer is cached, the
+    /// SYN then carries that first write's data, saving a round trip on
+    /// reconnection. Returns false where the platform or the kernel refuses,
+    /// in which case the connection simply pays the usual handshake.
+    ///
+    /// Lowest<SslSocket<N>> L
+    template<typename L>
+    static bool trySetFastOpenConnect(L& lowestLayer)
+    {
+#ifdef TCP_FASTOPEN_CONNECT
+      boost::system::error_code erc;
+      boost::asio::detail::socket_option::boolean<IPPROTO_TCP, TCP_FASTOPEN_CONNECT> option(true);
+      lowestLayer.set_option(option, erc);
+      return !erc;
+#else
+      static_cast<void>(lowestLayer);
+      return false;
+#endif
+    }
+
+    /// Configures a client-side ssl context: captures negotiated TLS sessions
+    /// for later resumption and applies the cipher preferences given by the
+    /// QI_SSL_CIPHERS environment variable, if any.
+    static void setClientSslContextOptions(ssl_context_type& context);
+
+    /// Configures a server-side ssl context: session cache and session
+    /// tickets stay enabled so that reconnecting clients get an abbreviated
+    /// handshake, and QI_SSL_CIPHERS cipher preferences are applied.
+    static void setServerSslContextOptions(ssl_context_type& context);
+
+    /// Installs on the given socket the TLS session previously negotiated
+    /// with this endpoint, if any, so that the coming handshake tries an
+    /// abbreviated (one round trip, symmetric crypto only) resumption.
+    /// Also tags the socket so that the session negotiated on this
+    /// connection is captured for the next one.
+    ///
+    /// NetSslSocket S
+    template<typename S>
+    static void prepareClientSession(S& socket, const std::string& endpoint)
+    {
+      clientSessionPrepare(socket.native_handle(), endpoint);
+    }
+    static void clientSessionPrepare(ssl_socket_type::native_handle_type sslHandle,
+                                     const std::string& endpoint);
+
     /// NetSslSocket S, MutableBufferSequence B, ReadHandler H
     template<typename S, typename B, typename H>
     static void async_read(S& s, const B& b, H h)
     {
       boost::asio::async_read(s, b, h);
     }
+    /// Unlike `async_read`, completes after a single underlying transfer:
+    /// at least one byte and at most the buffer size are read.
+    ///
+    /// NetStream S, MutableBufferSequence B, ReadHandler H
+    template<typename S, typename B, typename H>
+    static void async_read_some(S& s, const B& b, H h)
+    {
+      s.async_read_some(b, h);
+    }
     /// NetSslSocket S, ConstBufferSequence B, WriteHandler H
     template<typename S, typename B, typename H>
     static void async_write(S& s, const B& b, H h)
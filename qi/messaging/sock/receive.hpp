@@ -8,7 +8,12 @@
 #include <qi/messaging/sock/common.hpp>
 #include <ka/src.hpp>
 #include "src/messaging/message.hpp"
+#include "src/messaging/streamcontext.hpp"
 #include <qi/trackable.hpp>
+#include <qi/os.hpp>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
 #include <qi/log.hpp>
 #include <ka/macroregular.hpp>
 #include <boost/shared_ptr.hpp>
@@ -51,6 +56,10 @@
 /// where the next message is to be received, or nothing if reception must stop
 /// (this is done by using an optional pointer).
 ///
+/// The two reads of the loop need not each hit the network: when a read-ahead
+/// buffer is provided (see `ReadAhead`), headers and payloads are served from
+/// bytes read in advance by larger socket reads.
+///
 ///
 /// ## Lifetime and synchronization mechanisms
 ///
@@ -141,6 +150,53 @@
 /// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 namespace qi { namespace sock {
+  /// Capacity in bytes of the receive-side read-ahead buffer.
+  ///
+  /// Read once from the QI_RECEIVE_READ_AHEAD_BYTES environment variable.
+  /// Zero (the default) disables read-ahead and keeps the historical
+  /// two-reads-per-message behavior.
+  inline std::size_t receiveReadAheadBytesFromEnv()
+  {
+    static const std::string value = os::getenv("QI_RECEIVE_READ_AHEAD_BYTES");
+    static const std::size_t bytes = value.empty()
+      ? std::size_t{0}
+      : static_cast<std::size_t>(strtoul(value.c_str(), nullptr, 0));
+    return bytes;
+  }
+
+  /// Bytes already read from the socket but not consumed yet by the message
+  /// decoding.
+  ///
+  /// Historically each message costs two system reads: one sized exactly for
+  /// the header, one sized exactly for the payload. When a read-ahead buffer
+  /// is used instead, the socket is read by chunks of up to the buffer
+  /// capacity and the header and payload reads are served from the buffered
+  /// bytes, so a single system read can cover many small messages.
+  struct ReadAhead
+  {
+    std::vector<char> buffer;
+    std::size_t begin = 0u; ///< Index of the first unconsumed byte.
+    std::size_t end = 0u;   ///< Index one past the last valid byte.
+
+    std::size_t available() const
+    {
+      return end - begin;
+    }
+    /// Precondition: byteCount <= available()
+    void take(void* dest, std::size_t byteCount)
+    {
+      std::memcpy(dest, buffer.data() + begin, byteCount);
+      begin += byteCount;
+    }
+    /// Allocates the buffer on first use and forgets bytes left over from a
+    /// previous connection.
+    void reset(std::size_t capacity)
+    {
+      buffer.resize(capacity);
+      begin = end = 0u;
+    }
+  };
+
   /// Receive a message through the socket and call the handler when the
   /// operation is complete, successfully or not.
   ///
@@ -189,6 +245,10 @@ namespace qi { namespace sock {
   ///   auto msg = promise.future().value();
   /// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
   ///
+  /// The optional read-ahead buffer, when given on a non-SSL socket, is used
+  /// to serve the header and payload reads with fewer system reads. The
+  /// buffer must remain valid as long as the socket, like the message.
+  ///
   /// Network N,
   /// Mutable<SslSocket<N>> S,
   /// Mutable<Message> M,
@@ -197,10 +257,102 @@ namespace qi { namespace sock {
   /// Transformation<Procedure<void (Args...)>> F1
   template<typename N, typename S, typename M, typename Proc, typename F0 = ka::id_transfo_t, typename F1 = ka::id_transfo_t>
   void receiveMessage(const S& socket, M ptrMsg, SslEnabled ssl, size_t maxPayload,
-    const Proc& onReceive, F0 lifetimeTransfo = F0{}, F1 syncTransfo = F1{});
+    const Proc& onReceive, F0 lifetimeTransfo = F0{}, F1 syncTransfo = F1{},
+    ReadAhead* readAhead = nullptr);
+
+  /// True when this process advertises the CompactHeader capability, in which
+  /// case peers may send either header format and the header must be read in
+  /// two parts (compact size first, completed to a full header if the first
+  /// byte says so). When false - the default - the header is read in one go,
+  /// exactly as it always was.
+  ///
+  /// Process-wide on purpose: the receive loop starts before any capability
+  /// exchange, so only the default capabilities (environment-driven, see
+  /// QI_TRANSPORT_CAPABILITIES) can decide the read layout.
+  inline bool compactHeadersLocallyEnabled()
+  {
+    static const bool enabled = [] {
+      const CapabilityMap& caps = StreamContext::defaultCapabilities();
+      const auto it = caps.find(capabilityname::compactHeader);
+      return it != caps.end() && it->second.to<bool>();
+    }();
+    return enabled;
+  }
 
   namespace detail
   {
+    /// Reads exactly `byteCount` bytes into `data`, then calls the handler
+    /// with an error code and the number of bytes delivered.
+    ///
+    /// Without a read-ahead buffer, or on an SSL socket (where the raw socket
+    /// bytes belong to the TLS layer), this is an exact-size asynchronous
+    /// read, as it has always been. With one, the bytes are taken from the
+    /// buffer, which is refilled when empty by a single `async_read_some` of
+    /// up to its capacity.
+    ///
+    /// The handler is never invoked from inside this function, even when the
+    /// bytes are already buffered: it is then posted to the socket's io
+    /// service. This keeps the guarantee asynchronous reads give and bounds
+    /// the stack depth when draining a buffer holding many small messages.
+    ///
+    /// Network N,
+    /// Mutable<SslSocket<N>> S,
+    /// Procedure<void (ErrorCode<N>, std::size_t)> Proc,
+    /// Transformation<Procedure> F0,
+    /// Transformation<Procedure<void (Args...)>> F1
+    template<typename N, typename S, typename Proc, typename F0, typename F1>
+    void readExact(const S& socket, SslEnabled ssl, void* data, std::size_t byteCount,
+      ReadAhead* readAhead, Proc handler, F0 lifetimeTransfo, F1 syncTransfo)
+    {
+      if (*ssl || !readAhead)
+      {
+        auto wrappedHandler = syncTransfo(lifetimeTransfo(handler));
+        if (*ssl)
+        {
+          N::async_read(*socket, N::buffer(data, byteCount), wrappedHandler);
+        }
+        else
+        {
+          N::async_read((*socket).next_layer(), N::buffer(data, byteCount), wrappedHandler);
+        }
+        return;
+      }
+      const std::size_t available = readAhead->available();
+      if (available >= byteCount)
+      {
+        readAhead->take(data, byteCount);
+        (*socket).get_io_service().post(syncTransfo(lifetimeTransfo([=]() mutable {
+          handler(success<ErrorCode<N>>(), byteCount);
+        })));
+        return;
+      }
+      if (available > 0u)
+      {
+        // Consume the buffered bytes and read the rest exactly.
+        readAhead->take(data, available);
+        auto readRest = syncTransfo(lifetimeTransfo([=](ErrorCode<N> erc, std::size_t) mutable {
+          handler(erc, byteCount);
+        }));
+        N::async_read((*socket).next_layer(),
+          N::buffer(static_cast<char*>(data) + available, byteCount - available), readRest);
+        return;
+      }
+      // The buffer is empty: refill it with whatever the socket has (at least
+      // one byte), then serve the read from it.
+      auto refill = syncTransfo(lifetimeTransfo([=](ErrorCode<N> erc, std::size_t len) mutable {
+        if (erc)
+        {
+          handler(erc, 0u);
+          return;
+        }
+        readAhead->begin = 0u;
+        readAhead->end = len;
+        readExact<N>(socket, ssl, data, byteCount, readAhead, handler, lifetimeTransfo, syncTransfo);
+      }));
+      N::async_read_some((*socket).next_layer(),
+        N::buffer(readAhead->buffer.data(), readAhead->buffer.size()), refill);
+    }
+
     /// Network N,
     /// Mutable<SslSocket<N>> S,
     /// Mutable<Message> M,
@@ -209,7 +361,8 @@ namespace qi { namespace sock {
     /// Transformation<Procedure<void (Args...)>> F1
     template<typename N, typename S, typename M, typename Proc, typename F0, typename F1>
     void onReadData(const ErrorCode<N>& erc, const S& socket, M ptrMsg, SslEnabled ssl,
-      size_t maxPayload, Proc onReceive, const F0& lifetimeTransfo, const F1& syncTransfo)
+      size_t maxPayload, Proc onReceive, const F0& lifetimeTransfo, const F1& syncTransfo,
+      ReadAhead* readAhead)
     {
       // We inform the upper layer that we received a message (or an error
       // occurred). The upper layer returns an optional containing a pointer to
@@ -217,7 +370,8 @@ namespace qi { namespace sock {
       // receiving messages.
       if (auto optionalPtrNextMsg = onReceive(erc, ptrMsg))
       {
-        receiveMessage<N>(socket, *optionalPtrNextMsg, ssl, maxPayload, onReceive, lifetimeTransfo, syncTransfo);
+        receiveMessage<N>(socket, *optionalPtrNextMsg, ssl, maxPayload, onReceive, lifetimeTransfo, syncTransfo,
+          readAhead);
       }
     }
 
@@ -235,13 +389,14 @@ namespace qi { namespace sock {
     template<typename N, typename S, typename M, typename Proc, typename F0, typename F1>
     void onReadHeader(const ErrorCode<N>& erc, std::size_t len,
       const S& socket, M ptrMsg, SslEnabled ssl,
-      size_t maxPayload, Proc onReceive, F0 lifetimeTransfo, F1 syncTransfo)
+      size_t maxPayload, Proc onReceive, F0 lifetimeTransfo, F1 syncTransfo,
+      ReadAhead* readAhead)
     {
       auto receiveErrorAndMaybeReceiveNext = [&](ErrorCode<N> erc) {
         if (auto optionalPtrMsg = onReceive(erc, M{}))
         {
           receiveMessage<N>(socket, *optionalPtrMsg, ssl, maxPayload, onReceive,
-            lifetimeTransfo, syncTransfo);
+            lifetimeTransfo, syncTransfo, readAhead);
         }
       };
       if (erc)
@@ -254,7 +409,7 @@ namespace qi { namespace sock {
       if (*ssl && len == 0)
       {
         receiveMessage<N>(socket, ptrMsg, ssl, maxPayload, onReceive,
-          lifetimeTransfo, syncTransfo);
+          lifetimeTransfo, syncTransfo, readAhead);
         return;
       }
       auto& msg = *ptrMsg;
@@ -272,7 +427,7 @@ namespace qi { namespace sock {
       if (payload == 0u)
       {
         onReadData<N>(success<ErrorCode<N>>(), socket, ptrMsg, ssl, maxPayload,
-          onReceive, lifetimeTransfo, syncTransfo);
+          onReceive, lifetimeTransfo, syncTransfo, readAhead);
         return;
       }
       if (payload > maxPayload)
@@ -285,21 +440,63 @@ namespace qi { namespace sock {
       }
       auto messageBuffer = msg.extractBuffer();
       void* ptr = messageBuffer.reserve(payload);
-      auto buffer = N::buffer(ptr, payload);
       msg.setBuffer(std::move(messageBuffer));
-      auto readData = lifetimeTransfo([=](ErrorCode<N> error, std::size_t /*len*/) {
-        onReadData<N>(error, socket, ptrMsg, ssl, maxPayload, onReceive, lifetimeTransfo, syncTransfo);
-      });
 
       // We received the header, we now wait to receive the data.
-      if (*ssl)
+      readExact<N>(socket, ssl, ptr, payload, readAhead,
+        [=](ErrorCode<N> error, std::size_t /*len*/) {
+          onReadData<N>(error, socket, ptrMsg, ssl, maxPayload, onReceive, lifetimeTransfo, syncTransfo,
+            readAhead);
+        }, lifetimeTransfo, syncTransfo);
+    }
+
+    /// Called once the first part of the header has been read. When compact
+    /// headers are locally enabled that part is only CompactHeader::size
+    /// bytes: the first byte then tells the format apart, and either the
+    /// compact form is decoded in place or the remaining full-header bytes
+    /// are read before resuming the regular handling. Otherwise the whole
+    /// header has been read and this forwards to `onReadHeader` untouched.
+    ///
+    /// Network N,
+    /// Mutable<SslSocket<N>> S,
+    /// Mutable<Message> M,
+    /// Procedure<Optional<M> (ErrorCode<N>, M)> Proc,
+    /// Transformation<Procedure> F0,
+    /// Transformation<Procedure<void (Args...)>> F1
+    template<typename N, typename S, typename M, typename Proc, typename F0, typename F1>
+    void onReadHeaderStart(const ErrorCode<N>& erc, std::size_t len,
+      const S& socket, M ptrMsg, SslEnabled ssl,
+      size_t maxPayload, Proc onReceive, F0 lifetimeTransfo, F1 syncTransfo,
+      ReadAhead* readAhead)
+    {
+      // Errors and the spurious SSL zero-length reads are handled by
+      // `onReadHeader` before it looks at the header content.
+      if (!compactHeadersLocallyEnabled() || erc || (*ssl && len == 0))
       {
-        N::async_read(*socket, buffer, syncTransfo(readData));
+        onReadHeader<N>(erc, len, socket, ptrMsg, ssl, maxPayload, onReceive,
+          lifetimeTransfo, syncTransfo, readAhead);
+        return;
       }
-      else
+      auto& header = ptrMsg->header();
+      auto* headerBytes = reinterpret_cast<qi::uint8_t*>(&header);
+      if (headerBytes[0] == Message::CompactHeader::marker)
       {
-        N::async_read((*socket).next_layer(), buffer, syncTransfo(readData));
+        // Decode from a copy: the rebuilt header overlaps its wire form.
+        qi::uint8_t wire[Message::CompactHeader::size];
+        std::memcpy(wire, headerBytes, Message::CompactHeader::size);
+        Message::CompactHeader::decode(wire, header);
+        onReadHeader<N>(erc, len, socket, ptrMsg, ssl, maxPayload, onReceive,
+          lifetimeTransfo, syncTransfo, readAhead);
+        return;
       }
+      // A full header (or garbage, which the magic check in `onReadHeader`
+      // will diagnose): read the bytes the compact-sized read left out.
+      readExact<N>(socket, ssl, headerBytes + Message::CompactHeader::size,
+        sizeof(Message::Header) - Message::CompactHeader::size, readAhead,
+        [=](ErrorCode<N> error, std::size_t restLen) {
+          onReadHeader<N>(error, len + restLen, socket, ptrMsg, ssl, maxPayload,
+            onReceive, lifetimeTransfo, syncTransfo, readAhead);
+        }, lifetimeTransfo, syncTransfo);
     }
   } // namespace detail
 
@@ -311,29 +508,24 @@ namespace qi { namespace sock {
   /// Transformation<Procedure<void (Args...)>> F1
   template<typename N, typename S, typename M, typename Proc, typename F0, typename F1>
   void receiveMessage(const S& socket, M ptrMsg, SslEnabled ssl, size_t maxPayload,
-      const Proc& onReceive, F0 lifetimeTransfo, F1 syncTransfo)
+      const Proc& onReceive, F0 lifetimeTransfo, F1 syncTransfo, ReadAhead* readAhead)
   {
     // Receiving a message is done in two parts:
     // 1) receiving the header
     // 2) receiving the data (aka payload)
 
-    auto makeHeaderBuffer = [&] {
-      return N::buffer(&ptrMsg->header(), sizeof(Message::Header));
-    };
-    auto readHeader = syncTransfo(lifetimeTransfo([=](ErrorCode<N> erc, std::size_t len) {
-      detail::onReadHeader<N>(erc, len, socket, ptrMsg, ssl, maxPayload, onReceive,
-        lifetimeTransfo, syncTransfo);
-    }));
+    // When compact headers are locally enabled, only their size is read
+    // first; `onReadHeaderStart` completes the read for full headers.
+    const std::size_t firstReadSize = compactHeadersLocallyEnabled()
+      ? Message::CompactHeader::size
+      : sizeof(Message::Header);
 
     // First, we wait to receive the header.
-    if (*ssl)
-    {
-      N::async_read(*socket, makeHeaderBuffer(), readHeader);
-    }
-    else
-    {
-      N::async_read((*socket).next_layer(), makeHeaderBuffer(), readHeader);
-    }
+    detail::readExact<N>(socket, ssl, &ptrMsg->header(), firstReadSize, readAhead,
+      [=](ErrorCode<N> erc, std::size_t len) {
+        detail::onReadHeaderStart<N>(erc, len, socket, ptrMsg, ssl, maxPayload, onReceive,
+          lifetimeTransfo, syncTransfo, readAhead);
+      }, lifetimeTransfo, syncTransfo);
   }
 
   /// Receive continuously messages until told to stop.
@@ -372,6 +564,7 @@ namespace qi { namespace sock {
   class ReceiveMessageContinuous
   {
     Message _msg;
+    ReadAhead _readAhead;
   public:
   // QuasiRegular:
     ReceiveMessageContinuous() = default;
@@ -386,6 +579,15 @@ namespace qi { namespace sock {
     void operator()(const S& socket, SslEnabled ssl, size_t maxPayload,
         Proc onReceive, const F0& lifetimeTransfo = {}, const F1& syncTransfo = {})
     {
+      // Read-ahead is opt-in (see `receiveReadAheadBytesFromEnv`) and only
+      // makes sense on the raw socket, so not with SSL.
+      ReadAhead* readAhead = nullptr;
+      const std::size_t readAheadBytes = receiveReadAheadBytesFromEnv();
+      if (!*ssl && readAheadBytes > 0u)
+      {
+        _readAhead.reset(readAheadBytes);
+        readAhead = &_readAhead;
+      }
       receiveMessage<N>(socket, &_msg, ssl, maxPayload,
 
         // This callback will be called when a message has been received.
@@ -407,7 +609,8 @@ namespace qi { namespace sock {
           return {};
         },
         lifetimeTransfo,
-        syncTransfo
+        syncTransfo,
+        readAhead
       );
     }
   };
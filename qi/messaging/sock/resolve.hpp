@@ -1,7 +1,12 @@
 #pragma once
 #ifndef _QI_SOCK_RESOLVE_HPP
 #define _QI_SOCK_RESOLVE_HPP
+#include <map>
 #include <string>
+#include <vector>
+#include <boost/optional.hpp>
+#include <boost/thread/mutex.hpp>
+#include <qi/clock.hpp>
 #include <qi/messaging/sock/concept.hpp>
 #include <ka/typetraits.hpp>
 #include <qi/messaging/sock/traits.hpp>
@@ -108,6 +113,163 @@ namespace qi { namespace sock {
       using O = boost::optional<Entry>;
       return b == e ? O{} : O{*b};
     }
+
+    /// Returns all the entries usable for a connection attempt, in resolver
+    /// order, skipping ipV6 entries if asked for.
+    ///
+    /// Precondition: readableBoundedRange(b, e)
+    ///
+    /// Iterator<Entry<Resolver<N>>> I
+    template<typename I>
+    auto allValidEntries(I b, const I& e, IpV6Enabled ipV6)
+        -> std::vector<ka::Decay<decltype(*b)>>
+    {
+      using Entry = ka::Decay<decltype(*b)>;
+      std::vector<Entry> entries;
+      for (; b != e; ++b)
+      {
+        const Entry entry = *b;
+        if (!(*ipV6) && entry.endpoint().address().is_v6())
+          continue;
+        entries.push_back(entry);
+      }
+      return entries;
+    }
+
+    /// TTL of cached name resolutions.
+    ///
+    /// Read once from the QI_RESOLVE_CACHE_TTL environment variable, in
+    /// seconds. Zero (the default) disables the cache and keeps the
+    /// historical behavior of resolving on every connection.
+    inline Seconds resolveCacheTtl()
+    {
+      static const int seconds = os::getEnvParam<int>("QI_RESOLVE_CACHE_TTL", 0);
+      return Seconds{seconds};
+    }
+
+    /// Cache key of the resolutions for the given URL.
+    inline std::string resolveCacheKey(const Url& url)
+    {
+      return url.host() + ":" + os::to_string(url.port());
+    }
+
+    /// Process-wide cache of name resolution results, keyed by "host:port".
+    ///
+    /// Within the TTL the cached endpoints are served without asking the
+    /// resolver at all. Past it they are not dropped: a connection is served
+    /// the stale endpoints right away, so it never stalls on a slow resolver,
+    /// and one caller at a time is asked to refresh them in the background
+    /// (serve stale while revalidate).
+    ///
+    /// Failed resolutions are cached too, so an unknown host does not pay a
+    /// full resolution timeout on every attempt, but only briefly (see
+    /// `negativeTtl`), to recover fast once the name appears.
+    ///
+    /// Entries are stored unfiltered: callers apply their own ipV6 filtering
+    /// when using them (see `allValidEntries`).
+    ///
+    /// Network N
+    template<typename N>
+    class ResolveCache
+    {
+    public:
+      using Entries = std::vector<Entry<Resolver<N>>>;
+
+      struct Hit
+      {
+        Entries entries;    ///< Empty for a negative hit.
+        ErrorCode<N> error; ///< Meaningful for a negative hit only.
+        bool negative;      ///< The cached resolution had failed.
+        bool revalidate;    ///< Stale: serve it, but refresh in the background.
+      };
+
+      static ResolveCache& instance()
+      {
+        static ResolveCache cache;
+        return cache;
+      }
+
+      /// How long a failed resolution keeps being served before resolving
+      /// again for real.
+      static Seconds negativeTtl()
+      {
+        return Seconds{1};
+      }
+
+      boost::optional<Hit> find(const std::string& key, Seconds ttl)
+      {
+        boost::mutex::scoped_lock lock(_mutex);
+        const auto it = _results.find(key);
+        if (it == _results.end())
+          return {};
+        auto& cached = it->second;
+        const auto age = SteadyClock::now() - cached.time;
+        if (cached.negative)
+        {
+          // A failure past its short TTL is forgotten, not revalidated: the
+          // next caller resolves for real and waits for the outcome.
+          if (age >= negativeTtl())
+          {
+            _results.erase(it);
+            return {};
+          }
+          return Hit{Entries{}, cached.error, true, false};
+        }
+        const bool stale = age >= ttl;
+        // Ask only one caller to revalidate, so identical resolutions do not
+        // pile up while the refresh is in flight.
+        const bool revalidate = stale && !cached.revalidating;
+        if (revalidate)
+          cached.revalidating = true;
+        return Hit{cached.entries, ErrorCode<N>{}, false, revalidate};
+      }
+
+      void store(const std::string& key, Entries entries)
+      {
+        boost::mutex::scoped_lock lock(_mutex);
+        _results[key] = Cached{std::move(entries), ErrorCode<N>{}, false, false,
+          SteadyClock::now()};
+      }
+
+      void storeFailure(const std::string& key, const ErrorCode<N>& error)
+      {
+        boost::mutex::scoped_lock lock(_mutex);
+        // Never overwrite endpoints that resolved successfully once: they
+        // keep being served stale, which is the point of this cache.
+        const auto it = _results.find(key);
+        if (it != _results.end() && !it->second.negative)
+          return;
+        _results[key] = Cached{Entries{}, error, true, false, SteadyClock::now()};
+      }
+
+      /// Outcome of a background revalidation: a success replaces the stale
+      /// entries, a failure keeps them and only rearms the revalidation.
+      void endRevalidation(const std::string& key, const ErrorCode<N>& error,
+        Entries entries)
+      {
+        if (!error)
+        {
+          store(key, std::move(entries));
+          return;
+        }
+        boost::mutex::scoped_lock lock(_mutex);
+        const auto it = _results.find(key);
+        if (it != _results.end())
+          it->second.revalidating = false;
+      }
+
+    private:
+      struct Cached
+      {
+        Entries entries;
+        ErrorCode<N> error;
+        bool negative;
+        bool revalidating; ///< A caller is refreshing this entry.
+        SteadyClockTimePoint time;
+      };
+      boost::mutex _mutex;
+      std::map<std::string, Cached> _results;
+    };
   } // namespace detail
 
   /// Resolve the given url and give back the first endpoint, if any, skipping
@@ -2,10 +2,14 @@
 #ifndef _QI_SOCK_SEND_HPP
 #define _QI_SOCK_SEND_HPP
 #include <atomic>
+#include <cstdlib>
 #include <vector>
 #include <list>
+#include <boost/container/small_vector.hpp>
 #include <stdexcept>
 #include <sstream>
+#include <tuple>
+#include <utility>
 #include <boost/thread/synchronized_value.hpp>
 #include <boost/core/ignore_unused.hpp>
 #include <qi/messaging/sock/concept.hpp>
@@ -14,6 +18,7 @@
 #include <qi/messaging/sock/error.hpp>
 #include <qi/messaging/sock/common.hpp>
 #include <ka/src.hpp>
+#include <qi/os.hpp>
 #include <qi/trackable.hpp>
 #include <qi/future.hpp>
 #include <ka/scoped.hpp>
@@ -64,10 +69,11 @@
 /// The memory for the messages can be for example maintained by an instance of
 /// `SendMessageEnqueue`. As `sendMessage`, it implements a message
 /// send loop, but being an object it can have a state and takes leverage
-/// of this to maintain a message queue. It passes the first message of the queue to
-/// `sendMessage` and removes it from the queue when sending is done. In this
+/// of this to maintain a message queue. It passes the front of the queue to
+/// `sendMessageBatch` (a batch is a single message unless coalescing is
+/// enabled) and removes it from the queue when sending is done. In this
 /// case, `SendMessageEnqueue` effectively constitutes the upper layer of
-/// `sendMessage`.
+/// `sendMessageBatch`.
 ///
 /// `SendMessageEnqueue` has itself an upper layer: it passes it the
 /// sent message though a callback. This callback returns a boolean to
@@ -80,15 +86,15 @@
 ///  SendMessageEnqueue start
 ///             |
 ///             v
-///   sendMessage(_msgQueue.begin()) <--
-///             | message sent          |
-///             v                       |
-/// pass msg/error to upper layer*      |
-///             |                       |
-///             v                       |
-///   remove msg from queue             |
-///             |                       |
-///       must continue? ---------------
+///   sendMessageBatch(front of _msgQueue) <--
+///             | batch sent                  |
+///             v                             |
+/// pass each msg/error to upper layer*       |
+///             |                             |
+///             v                             |
+///   remove batch from queue                 |
+///             |                             |
+///       must continue? ---------------------
 ///             | no         yes
 ///             v
 ///            stop
@@ -105,25 +111,47 @@
 ///                         ^ | bool
 ///         (Error, IterMsg)| v
 /// Layer 1:         SendMessageEnqueue
-///                         ^ | optional<IterMsg>
-///         (Error, IterMsg)| v
-/// Layer 0:            sendMessage
+///                         ^ | optional<pair<IterMsg, IterMsg>>
+/// (Error, IterMsg, IterMsg)| v
+/// Layer 0:         sendMessageBatch
 /// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 namespace qi { namespace sock {
 
-  /// Make network buffers for the given message.
+  /// Number of scatter-gather buffers we can describe without a heap
+  /// allocation. A message with up to 3 sub-buffers fits (1 header buffer,
+  /// plus interleaved main buffer chunks), which covers the typical case of
+  /// a call carrying at most one large raw payload.
+  static const std::size_t inlineBufferCountHint = 8;
+
+  /// Sequence of network buffers describing a message for a gathered write.
   ///
-  /// One buffer is for the header and the other one is for data.
+  /// Small-buffer optimized so that building the sequence for a typical
+  /// message does not allocate.
   ///
   /// Network N
   template<typename N>
-  std::vector<ConstBuffer<N>> makeBuffers(const Message& msg)
+  using ConstBufferSequence = boost::container::small_vector<ConstBuffer<N>, inlineBufferCountHint>;
+
+  /// Append to the given sequence the network buffers describing one message.
+  ///
+  /// One buffer is for the header and the other ones are for data.
+  ///
+  /// The sequence is meant to be handed as-is to the network's gathered write,
+  /// so the header, the main buffer chunks and the sub-buffers reach the
+  /// kernel in a single writev-style operation, without being coalesced into
+  /// a contiguous stream first. Several messages may be appended to the same
+  /// sequence to send them in one write.
+  ///
+  /// Network N
+  template<typename N>
+  void appendBuffers(ConstBufferSequence<N>& buffers, const Message& msg)
   {
-    // header buffer
-    ConstBuffer<N> headerBuffer = N::buffer(static_cast<const void*>(&msg.header()),
-      sizeof(Message::Header));
-    std::vector<ConstBuffer<N>> buffers;
+    // header buffer: the compact wire form when the message was marked for
+    // it (see Message::enableCompactHeader), the regular header otherwise
+    ConstBuffer<N> headerBuffer = msg.compactOnWire()
+      ? N::buffer(static_cast<const void*>(msg.compactWireHeader()), Message::CompactHeader::size)
+      : N::buffer(static_cast<const void*>(&msg.header()), sizeof(Message::Header));
     const auto& msgBuffer = msg.buffer();
 
     // A buffer has a header and data.
@@ -139,7 +167,7 @@ namespace qi { namespace sock {
     // Memory layout for a buffer with 2 subbuffers:
     // (low address)                                                         (high address)
     // |header|buffer_part_0|size_subbuffer_0|buffer_part_1|size_subbuffer_1|buffer_part_2|
-    buffers.reserve(1 + 2 * msgBuffer.subBuffers().size() + 1);
+    buffers.reserve(buffers.size() + 1 + 2 * msgBuffer.subBuffers().size() + 1);
     buffers.push_back(headerBuffer);
 
     decltype(msgBuffer.size()) beginOffset = 0;
@@ -160,9 +188,33 @@ namespace qi { namespace sock {
     // end of main buffer
     buffers.push_back(N::buffer(
       static_cast<const char*>(msgBuffer.data()) + beginOffset, msgBuffer.size() - beginOffset));
+  }
+
+  /// Make network buffers for the given message.
+  ///
+  /// Network N
+  template<typename N>
+  ConstBufferSequence<N> makeBuffers(const Message& msg)
+  {
+    ConstBufferSequence<N> buffers;
+    appendBuffers<N>(buffers, msg);
     return buffers;
   }
 
+  /// Byte budget for coalescing queued messages into a single gathered write.
+  ///
+  /// Read once from the QI_SEND_COALESCING_BYTES environment variable.
+  /// Zero (the default) disables coalescing and keeps the historical
+  /// one-write-per-message behavior.
+  inline std::size_t sendCoalescingBytesFromEnv()
+  {
+    static const std::string value = os::getenv("QI_SEND_COALESCING_BYTES");
+    static const std::size_t bytes = value.empty()
+      ? std::size_t{0}
+      : static_cast<std::size_t>(strtoul(value.c_str(), nullptr, 0));
+    return bytes;
+  }
+
   /// Send a message through the socket and call the handler when the operation
   /// is complete, successfully or not.
   ///
@@ -217,15 +269,71 @@ namespace qi { namespace sock {
     }
   }
 
+  /// Send a batch of messages through the socket in one gathered write and
+  /// call the handler when the operation is complete, successfully or not.
+  ///
+  /// The batch is the range [itBegin, itEnd) of a message queue. All its
+  /// buffers are chained into a single write, so tiny messages cost one
+  /// system call per batch instead of one each. If the handler returns a new
+  /// range, it is immediately sent.
+  ///
+  /// Precondition: The range must not be empty and the messages it refers to
+  ///   must be valid until the handler has been called.
+  ///
+  /// Precondition: This function must not be called while a batch is already
+  ///   being sent. It is possible to call it again only once the handler has
+  ///   been called.
+  ///
+  /// Network N,
+  /// Mutable<SslSocket<N>> S,
+  /// Iterator<Message> I,
+  /// Procedure<Optional<std::pair<I, I>> (ErrorCode<N>, I, I)> Proc,
+  /// Transformation<Procedure> F0,
+  /// Transformation<Procedure<void (Args...)>> F1
+  template<typename N, typename S, typename I, typename Proc, typename F0 = ka::id_transfo_t, typename F1 = ka::id_transfo_t>
+  void sendMessageBatch(const S& socket, I itBegin, I itEnd, Proc onSent, SslEnabled ssl,
+      F0 lifetimeTransfo = {}, F1 syncTransfo = {})
+  {
+    ConstBufferSequence<N> buffers;
+    for (I it = itBegin; it != itEnd; ++it)
+      appendBuffers<N>(buffers, *it);
+    auto writeCont = syncTransfo(lifetimeTransfo([=](ErrorCode<N> erc, size_t /*len*/) mutable {
+      if (auto optionalNextBatch = onSent(erc, itBegin, itEnd))
+      {
+        sendMessageBatch<N>(socket, optionalNextBatch->first, optionalNextBatch->second,
+          onSent, ssl, lifetimeTransfo, syncTransfo);
+      }
+    }));
+    if (*ssl)
+    {
+      N::async_write(*socket, std::move(buffers), writeCont);
+    }
+    else
+    {
+      N::async_write((*socket).next_layer(), std::move(buffers), writeCont);
+    }
+  }
+
   /// Functor that sends messages through a socket.
   ///
   /// The role of this type is to provide a queue for messages.
   /// You can therefore ask to send a message before the current one has
   /// actually been sent. The message will simply be enqueued and sent ASAP.
-  /// The messages will be sent in a FIFO manner.
+  /// The messages will be sent in a FIFO manner, with one exception: the
+  /// queue has a latency-critical lane. A message carrying
+  /// Message::TypeFlag_HighPriority is inserted ahead of queued
+  /// normal-priority messages (but behind the batch being written and
+  /// behind earlier high-priority messages), so control traffic does not
+  /// wait behind queued bulk transfers.
   /// Sending messages is thread-safe.
   ///
-  /// The actual sending is done by `sendMessage`.
+  /// The actual sending is done by `sendMessageBatch`: messages that were
+  /// enqueued while a write was in flight can be coalesced into the next
+  /// gathered write, up to the byte budget given by
+  /// `sendCoalescingBytesFromEnv()` (coalescing is opt-in and disabled by
+  /// default). A message is never delayed waiting for company: the queue is
+  /// drained as fast as the socket accepts writes, so coalescing adds no
+  /// latency and no explicit flush is needed.
   ///
   /// When a message has been sent, a callback is called. This callback return
   /// a boolean to decide if the queue, if not empty, must continue to be processed.
@@ -266,12 +374,92 @@ namespace qi { namespace sock {
              typename F0 = ka::id_transfo_t, typename F1 = ka::id_transfo_t>
     void operator()(Msg&&, SslEnabled, Proc onSent = Proc{true},
       const F0& lifetimeTransfo = F0{}, const F1& syncTransfo = F1{});
+
+    /// Bytes currently enqueued (headers included), the batch being written
+    /// excluded as soon as its write completes. Used by the upper layer for
+    /// send-queue backpressure.
+    std::size_t queuedBytes() const
+    {
+      return _queuedBytes.load(std::memory_order_relaxed);
+    }
   private:
+    using I = std::list<Message>::iterator;
+
+    static std::size_t messageBytes(const Message& msg)
+    {
+      return (msg.compactOnWire() ? Message::CompactHeader::size : sizeof(Message::Header))
+        + msg.buffer().totalSize();
+    }
+
+    /// Insert in the lane matching the message's priority: a high-priority
+    /// message goes ahead of queued normal-priority messages, but behind
+    /// already queued high-priority messages (FIFO within a lane). The batch
+    /// currently being written is not in _sendQueue anymore (it has been
+    /// spliced into _inFlight), so it cannot be overtaken.
+    ///
+    /// Precondition: _sendMutex is held.
+    template<typename Msg>
+    void insertMessage(Msg&& msg)
+    {
+      _queuedBytes.fetch_add(messageBytes(msg), std::memory_order_relaxed);
+      if (!(msg.flags() & Message::TypeFlag_HighPriority))
+      {
+        _sendQueue.emplace_back(std::forward<Msg>(msg));
+        return;
+      }
+      I it = _sendQueue.begin();
+      while (it != _sendQueue.end() && (it->flags() & Message::TypeFlag_HighPriority))
+        ++it;
+      _sendQueue.emplace(it, std::forward<Msg>(msg));
+    }
+
+    /// First element past the batch of messages starting at `it` that fits
+    /// in one gathered write.
+    ///
+    /// The first message is always sent whatever its size; the coalescing
+    /// budget only decides whether the following ones ride along in the same
+    /// write.
+    ///
+    /// Precondition: _sendMutex is held and `it` is dereferenceable.
+    I batchEnd(I it)
+    {
+      const std::size_t maxBytes = sendCoalescingBytesFromEnv();
+      std::size_t bytes = messageBytes(*it);
+      ++it;
+      while (maxBytes != 0 && it != _sendQueue.end())
+      {
+        bytes += messageBytes(*it);
+        if (bytes > maxBytes)
+          break;
+        ++it;
+      }
+      return it;
+    }
+
+    /// Move the next batch out of the send queue into the in-flight list and
+    /// return it as a range. Once spliced, the batch belongs to the send loop
+    /// alone: enqueuing threads only touch _sendQueue, so the range can be
+    /// traversed without holding the lock and concurrently enqueued messages
+    /// can never be mistaken for part of it.
+    ///
+    /// Precondition: _sendMutex is held, _sendQueue is not empty and
+    ///   _inFlight is empty.
+    std::pair<I, I> spliceNextBatch()
+    {
+      _inFlight.splice(_inFlight.end(), _sendQueue,
+        _sendQueue.begin(), batchEnd(_sendQueue.begin()));
+      return std::make_pair(_inFlight.begin(), _inFlight.end());
+    }
+
     S _socket;
     /// A list is used because we need the iterators not to be invalidated by
     /// insertions at begin or end, which is not the case with deque.
     /// See [23.3.3.4 deque modifiers].
     std::list<Message> _sendQueue;
+    /// The batch being written, spliced out of _sendQueue (see
+    /// spliceNextBatch). Empty whenever _sending is false.
+    std::list<Message> _inFlight;
+    std::atomic<std::size_t> _queuedBytes{0};
     bool _sending;
     std::mutex _sendMutex;
   };
@@ -280,66 +468,70 @@ namespace qi { namespace sock {
   //  If a message is already being sent, the message is queued without
   //  invalidating the one being sent.
   // Proof:
-  //  All messages are put in the send queue, including the one being sent.
-  //  The send queue is a list so adding an element doesn't invalidate the other ones.
+  //  Messages being sent live in the in-flight list; enqueuing only inserts
+  //  into the send queue, a distinct list, under the lock.
   template<typename N, typename S>
   template<typename Msg, typename Proc, typename F0, typename F1>
   void SendMessageEnqueue<N, S>::operator()(Msg&& msg, SslEnabled ssl, Proc onSent,
       const F0& lifetimeTransfo, const F1& syncTransfo)
   {
     qiLogDebug(logCategory()) << _socket.get() << " SendMessageEnqueue()(" << msg.type() << ": " << msg.address() << ", ssl=" << *ssl << ")";
-    using I = decltype(_sendQueue.begin());
-    I itMsg;
+    I itMsg, itMsgEnd;
     bool mustStartSendLoop = false;
     {
       std::lock_guard<std::mutex> lock{_sendMutex};
-      _sendQueue.emplace_back(std::forward<Msg>(msg));
-      itMsg = _sendQueue.begin();
+      insertMessage(std::forward<Msg>(msg));
       // We've just added a message to the queue, so if we are not currently sending,
       // we must (re)start the send loop.
       if (!_sending)
       {
         _sending = true;
         mustStartSendLoop = true;
+        std::tie(itMsg, itMsgEnd) = spliceNextBatch();
       }
     }
     if (mustStartSendLoop)
     {
       // Lemma SendMessageEnqueue.1:
-      //  When calling sendMessage, itMsg is still valid.
+      //  When calling sendMessageBatch, the [itMsg, itMsgEnd) range is still valid.
       // Proof:
-      //  The send queue is a std::list, so inserting or erasing other elements
-      //  doesn't invalidate the iterator.
-      //  Each thread adds a message to the send queue. But only one at a time
-      //  can enter this branch (by tryRaiseAtomicFlag.0).
-      //  Also, the sending flag is only modified while the queue is locked, so
-      //  the scenario where a thread B adds a message to the queue, is suspended
-      //  just before evaluating the condition of this branch, then the send loop
-      //  thread A clears the queue, and then the thread B resumes, is correctly handled.
-      //  Moreover, this branch results in exactly one message being removed from
-      //  the send queue (by SendMessageEnqueue.2).
-      //  Therefore, at this point the number of messages in the send queue is
-      //  always at least 1.
+      //  The range delimits the _inFlight list, which enqueuing threads never
+      //  touch: they only insert into _sendQueue. Only one thread at a time
+      //  can enter this branch (the sending flag is only modified while the
+      //  queue is locked), and the in-flight batch is cleared exactly once,
+      //  by the completion callback of the write it was handed to (by
+      //  SendMessageEnqueue.2).
 
       // Lemma SendMessageEnqueue.2:
-      //  eraseAndReturnNextMessage erases from the send queue the element pointed
-      //  by the given iterator, even if an exception is thrown.
+      //  eraseAndReturnNextBatch empties the in-flight list, even if an
+      //  exception is thrown.
 
-      // This callback will be called when a message has been sent, or an error
-      // occurred. It passes an iterator on the sent message to the upper layer,
-      // which in return decides whether sending of the enqueued messaged must
-      // continue. Then, the callback erase the message.
-      auto eraseAndReturnNextMessage =
-        [&, onSent](ErrorCode<N> erc, I itSent) mutable -> boost::optional<I> {
+      // This callback will be called when a batch of messages has been sent, or
+      // an error occurred. It passes an iterator on each sent message to the
+      // upper layer, which in return decides whether sending of the enqueued
+      // messages must continue. Then, the callback erases the batch.
+      auto eraseAndReturnNextBatch =
+        [&, onSent](ErrorCode<N> erc, I itSent, I itSentEnd) mutable
+            -> boost::optional<std::pair<I, I>> {
           // It's ok to allow new sendings once the current one is complete.
           bool mustContinue = false;
-          boost::optional<I> itNext;
+          boost::optional<std::pair<I, I>> nextBatch;
+          {
+            // Account the batch as dequeued before notifying the upper layer,
+            // so that a backpressure check made from `onSent` sees the
+            // post-write queue size. The range is the in-flight list, owned
+            // by the send loop, so no lock is needed to traverse it.
+            std::size_t batchBytes = 0;
+            for (I it = itSent; it != itSentEnd; ++it)
+              batchBytes += messageBytes(*it);
+            _queuedBytes.fetch_sub(batchBytes, std::memory_order_relaxed);
+          }
           try
           {
             // A scoped is used to cope with potential exception thrown by onSent.
             auto scopedErase = ka::scoped([&] {
               std::lock_guard<std::mutex> lock{_sendMutex};
-              _sendQueue.erase(itSent);
+              _inFlight.clear();
               if (!mustContinue || _sendQueue.empty())
               {
                 QI_ASSERT(_sending);
@@ -348,19 +540,21 @@ namespace qi { namespace sock {
                 _sending = false;
                 return;
               }
-              itNext = _sendQueue.begin();
+              nextBatch = spliceNextBatch();
             });
-            mustContinue = onSent(erc, itSent);
+            mustContinue = true;
+            for (I it = itSent; it != itSentEnd; ++it)
+              mustContinue = onSent(erc, it) && mustContinue;
           }
           catch (const std::exception& e)
           {
             qiLogError(logCategory()) << "Error in post-send phase: " << e.what();
             throw;
           }
-          return itNext;
+          return nextBatch;
         };
 
-      sendMessage<N>(_socket, itMsg, std::move(eraseAndReturnNextMessage), ssl,
+      sendMessageBatch<N>(_socket, itMsg, itMsgEnd, std::move(eraseAndReturnNextBatch), ssl,
         lifetimeTransfo, syncTransfo);
     }
   }
@@ -387,6 +581,10 @@ namespace qi { namespace sock {
     {
       destroy();
     }
+    std::size_t queuedBytes() const
+    {
+      return _sendMsg.queuedBytes();
+    }
   // Procedure:
     /// Message Msg, Procedure<void (ErrorCode<N>, Readable<Message>)> Proc, Transformation<Procedure<void (Args...)>> F
     template<typename Msg, typename Proc = ka::constant_function_t<void>, typename F = ka::id_transfo_t>
@@ -1,6 +1,7 @@
 #pragma once
 #ifndef _QI_SOCK_SOCKETWITHCONTEXT_HPP
 #define _QI_SOCK_SOCKETWITHCONTEXT_HPP
+#include <utility>
 #include <qi/messaging/sock/traits.hpp>
 #include <ka/src.hpp>
 #include <ka/mutablestore.hpp>
@@ -62,6 +63,16 @@ namespace qi { namespace sock {
     }
 
   // Custom:
+    /// Gives access to the implementation-defined ssl handle of the
+    /// underlying socket (for example to configure TLS session resumption).
+    /// Template so that it is only instantiated on networks whose socket
+    /// actually exposes a native handle.
+    template<typename T = socket_t>
+    auto native_handle() -> decltype(std::declval<T&>().native_handle())
+    {
+      return socket.native_handle();
+    }
+
     template<typename T, typename U>
     void async_read_some(const T& buffers, const U& handler)
     {
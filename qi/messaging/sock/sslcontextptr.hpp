@@ -23,6 +23,27 @@ namespace qi { namespace sock {
   {
     return boost::make_shared<SslContext<N>>(ka::fwd<Args>(args)...);
   }
+
+  /// Returns the ssl context shared by every client socket of this process.
+  ///
+  /// Sharing one context is what allows TLS session resumption across
+  /// reconnections: the sessions (and session tickets) negotiated on one
+  /// connection are cached at the context level and installed on the next
+  /// connection to the same endpoint (see N::prepareClientSession), so a
+  /// reconnect completes with an abbreviated handshake instead of redoing
+  /// the asymmetric crypto of a full one.
+  ///
+  /// Network N
+  template<typename N>
+  SslContextPtr<N> clientSslContextPtr()
+  {
+    static const SslContextPtr<N> context = [] {
+      auto ctx = makeSslContextPtr<N>(Method<SslContext<N>>::sslv23);
+      N::setClientSslContextOptions(*ctx);
+      return ctx;
+    }();
+    return context;
+  }
 }} // namespace qi::sock
 
 #endif // _QI_SOCK_SSLCONTEXTPTR_HPP
@@ -0,0 +1,51 @@
+#pragma once
+/*
+**  Copyright (C) 2018 Aldebaran Robotics
+**  See COPYING for the license
+*/
+
+#ifndef _QIMESSAGING_SOCKETSTATS_HPP_
+#define _QIMESSAGING_SOCKETSTATS_HPP_
+
+#include <string>
+
+#include <qi/api.hpp>
+#include <qi/anyobject.hpp>
+#include <qi/types.hpp>
+
+namespace qi
+{
+  /// Point-in-time snapshot of one messaging socket's activity counters
+  /// (see Session::socketsStats()).
+  ///
+  /// The counters are maintained with relaxed atomics on the messaging hot
+  /// paths, so they are cheap enough to stay always-on. A snapshot is taken
+  /// counter by counter and is therefore not a consistent cut: a message can
+  /// already show in `messagesSent` while its bytes do not yet show in
+  /// `bytesSent`.
+  struct QI_API SocketStats
+  {
+    /// Remote endpoint of the socket.
+    std::string url;
+    /// Messages and wire bytes (headers included) enqueued for sending.
+    /// Fragments of a split message count individually.
+    qi::uint64_t messagesSent = 0;
+    qi::uint64_t bytesSent = 0;
+    /// Messages and wire bytes handed to message handling. Headers are
+    /// counted at the full-header size even when received in compact form.
+    qi::uint64_t messagesReceived = 0;
+    qi::uint64_t bytesReceived = 0;
+    /// Bytes currently waiting in the send queue.
+    qi::uint64_t sendQueueBytes = 0;
+    /// Largest send-queue depth observed since the socket was created.
+    qi::uint64_t sendQueuePeakBytes = 0;
+    /// Time from connect() to the connected state, in microseconds;
+    /// -1 on sockets this end did not connect (accepted server-side).
+    qi::int64_t handshakeDurationUs = -1;
+  };
+}
+
+QI_TYPE_STRUCT(qi::SocketStats, url, messagesSent, bytesSent, messagesReceived,
+               bytesReceived, sendQueueBytes, sendQueuePeakBytes, handshakeDurationUs);
+
+#endif  // _QIMESSAGING_SOCKETSTATS_HPP_
@@ -0,0 +1,70 @@
+#pragma once
+/*
+**  Copyright (C) 2018 Aldebaran Robotics
+**  See COPYING for the license
+*/
+
+#ifndef _QIMESSAGING_STREAMSOURCE_HPP_
+#define _QIMESSAGING_STREAMSOURCE_HPP_
+
+#include <boost/function.hpp>
+
+#include <qi/api.hpp>
+#include <qi/anyobject.hpp>
+#include <qi/buffer.hpp>
+#include <qi/future.hpp>
+
+namespace qi
+{
+  /// One chunk of a streamed transfer. An empty `data` is allowed (for
+  /// instance to terminate a stream whose size is a multiple of the chunk
+  /// size); `last` set means no further chunk follows.
+  struct QI_API StreamChunk
+  {
+    qi::Buffer data;
+    bool last = false;
+  };
+
+  /// Server side of a streaming call: wraps a chunk producer into an object
+  /// that a method can return instead of a fully materialized value. The
+  /// object travels through the regular object-passing machinery, so the
+  /// remote end pulls chunks one by one and only one chunk needs to exist in
+  /// memory at a time on either side. The pull itself is the flow control:
+  /// `producer` is invoked once per remote read, never ahead of the consumer.
+  ///
+  /// `producer` must set `last` on the final chunk. It is invoked from the
+  /// messaging thread pool; producers that block should return a future set
+  /// from their own execution context instead.
+  QI_API AnyObject makeStreamSource(boost::function<Future<StreamChunk>()> producer);
+
+  /// Client side of a streaming call: asynchronous chunk source over the
+  /// object returned by a streaming method.
+  ///
+  /// Typical use:
+  /// ~~~
+  /// qi::StreamReader reader(service.call<qi::AnyObject>("fetchMapStream"));
+  /// reader.readAll([](const qi::Buffer& chunk) { file.write(chunk); });
+  /// ~~~
+  class QI_API StreamReader
+  {
+  public:
+    explicit StreamReader(AnyObject source);
+
+    /// Pull the next chunk from the remote producer.
+    Future<StreamChunk> read();
+
+    /// Pull chunks one after the other until the last one, feeding each
+    /// payload to `consumer`. The next chunk is only requested once
+    /// `consumer` returned, so a slow consumer naturally throttles the
+    /// producer. The returned future is set when the stream ends, or in
+    /// error if a read fails.
+    Future<void> readAll(boost::function<void(const Buffer&)> consumer);
+
+  private:
+    AnyObject _source;
+  };
+}
+
+QI_TYPE_STRUCT(qi::StreamChunk, data, last);
+
+#endif  // _QIMESSAGING_STREAMSOURCE_HPP_
@@ -9,6 +9,7 @@
 # define _QI_OS_HPP_
 
 # include <cstdio>
+# include <functional>
 # include <string>
 # include <map>
 # include <vector>
@@ -61,6 +62,8 @@ struct stat;
 
 namespace qi {
 
+  template <typename T> class Future;
+
   /**
    * \brief OS abstraction layer.
    * \includename{qi/os.hpp}
@@ -435,6 +438,20 @@ namespace qi {
      * \endverbatim
      */
     QI_API int spawnvp(char *const argv[]);
+    /**
+     * \brief Create and execute a new process without blocking the caller.
+     * \param args The command line of the new process, executable first.
+     * \return A future set to the child pid, or set in error if the process
+     *         could not be spawned.
+     *
+     * \verbatim
+     * Asynchronous variant of :cpp:func:`qi::os::spawnvp(char* const[])`: the
+     * spawn runs on the global eventloop thread pool, so callers holding a
+     * latency budget (typically event-loop callbacks) are not stalled by the
+     * cost of the spawn itself.
+     * \endverbatim
+     */
+    QI_API qi::Future<int> spawnvpAsync(const std::vector<std::string>& args);
     /**
      * \brief Create and execute a new process.
      * \param argv Path to the file to be executed.
@@ -553,6 +570,26 @@ namespace qi {
      */
     QI_API std::map<std::string, std::vector<std::string> > hostIPAddrs(bool ipv6Addr = false);
 
+    /**
+     * \brief Register a callback invoked when the addresses returned by
+     * hostIPAddrs() may have changed (an interface or an address appeared
+     * or disappeared).
+     * \param callback Invoked from an internal watcher thread; it must not
+     * block and should reschedule any real work elsewhere.
+     * \return An id to pass to removeHostIPAddrsObserver().
+     *
+     * On Linux the notification comes from a netlink address watcher, which
+     * also lets hostIPAddrs() serve a cached enumeration between changes.
+     * On platforms without such a watcher the callback is never invoked and
+     * callers should keep polling.
+     */
+    QI_API int addHostIPAddrsObserver(std::function<void()> callback);
+    /**
+     * \brief Unregister a callback added with addHostIPAddrsObserver().
+     * \param id The id returned by addHostIPAddrsObserver().
+     */
+    QI_API void removeHostIPAddrsObserver(int id);
+
     /**
      * \brief Set the current thread name to the string in parameter.
      * \param name The new name of the current thread.
@@ -603,6 +640,21 @@ namespace qi {
      * \endverbatim
      */
     QI_API bool setCurrentThreadCPUAffinity(const std::vector<int> &cpus);
+    /**
+     *  \brief Switch the current thread to real-time scheduling.
+     *  \param priority Real-time priority, in the range given by the system
+     *         (1 to 99 on Linux). Values lower or equal to 0 fail.
+     *  \return true on success
+     *  \warning Usually requires elevated privileges, and a misbehaving
+     *  real-time thread can starve the system.
+     *
+     * \verbatim
+     * On POSIX systems the thread is moved to the SCHED_FIFO policy with
+     * the given priority. On Windows the thread priority is raised to
+     * THREAD_PRIORITY_TIME_CRITICAL, whatever the value.
+     * \endverbatim
+     */
+    QI_API bool setCurrentThreadRealtimePriority(int priority);
     /**
      *  \brief Get the number of CPUs on the local machin
      *  \return Number of CPUs
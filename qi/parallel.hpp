@@ -0,0 +1,268 @@
+#pragma once
+/*
+**  Copyright (C) 2018 Softbank Robotics
+**  See COPYING for the license
+*/
+
+#ifndef _QI_PARALLEL_HPP_
+#define _QI_PARALLEL_HPP_
+
+#include <algorithm>
+#include <atomic>
+#include <string>
+
+#include <boost/make_shared.hpp>
+#include <boost/optional.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/weak_ptr.hpp>
+
+#include <qi/eventloop.hpp>
+#include <qi/future.hpp>
+
+namespace qi
+{
+  namespace detail
+  {
+    /// Shared bookkeeping of one parallelFor/parallelReduce run. Workers
+    /// claim chunks of the index range by bumping `next`, so a worker stuck
+    /// on a slow chunk does not leave the others idle: the remaining indexes
+    /// are naturally stolen by whoever is free.
+    struct ParallelRunBase
+    {
+      std::atomic<size_t> next;
+      size_t end;
+      size_t chunk;
+      std::atomic<int> activeWorkers;
+      // Set on first error or on cancel: the other workers finish their
+      // current chunk and stop claiming new ones.
+      std::atomic<bool> stopped{false};
+      std::atomic<bool> cancelRequested{false};
+      boost::mutex mergeMutex;
+      std::string error; // protected by mergeMutex, first error wins
+
+      bool claim(size_t& first, size_t& last)
+      {
+        if (stopped.load(std::memory_order_relaxed))
+          return false;
+        first = next.fetch_add(chunk, std::memory_order_relaxed);
+        if (first >= end)
+          return false;
+        last = (std::min)(first + chunk, end);
+        return true;
+      }
+
+      void fail(const std::string& message)
+      {
+        {
+          boost::mutex::scoped_lock lock(mergeMutex);
+          if (error.empty())
+            error = message;
+        }
+        stopped.store(true, std::memory_order_relaxed);
+      }
+    };
+
+    /// Chunks sized for about 4 claims per worker: big enough that the
+    /// atomic claims are noise, small enough that an uneven workload still
+    /// spreads over the pool.
+    inline size_t parallelChunkSize(size_t rangeSize, unsigned int workers)
+    {
+      const size_t target = static_cast<size_t>(workers) * 4;
+      return (std::max)(static_cast<size_t>(1), rangeSize / (std::max)(target, static_cast<size_t>(1)));
+    }
+
+    /// Workers to post for the given range: never more than there are
+    /// chunks, so tiny ranges do not wake the whole pool.
+    inline unsigned int parallelWorkerCount(size_t rangeSize, size_t chunk, EventLoop* pool)
+    {
+      const unsigned int poolWorkers = (std::max)(pool->workerCount(), 1u);
+      const size_t chunks = (rangeSize + chunk - 1) / chunk;
+      return static_cast<unsigned int>(
+          (std::min)(static_cast<size_t>(poolWorkers), chunks));
+    }
+  }
+
+  /** Runs `process(i)` for every i in [begin, end) on the workers of an
+   * event loop, and returns a future set when the whole range has been
+   * processed.
+   *
+   * The range is split in chunks claimed dynamically by the workers, so the
+   * load balances itself even when iterations have uneven costs, and the
+   * parallelism is bounded by the pool size: no threads are spawned and qi's
+   * own pool is not oversubscribed.
+   *
+   * `process` is called concurrently from several threads and must be
+   * thread-safe with itself. If a call throws, the remaining chunks are
+   * abandoned (workers still finish the chunk they are on) and the future is
+   * set in error with the first exception's message. Cancelling the future
+   * abandons the remaining chunks the same way and ends in a canceled state.
+   *
+   * \includename{qi/parallel.hpp}
+   */
+  template <typename Proc>
+  Future<void> parallelFor(size_t begin, size_t end, Proc process,
+                           EventLoop* pool = getEventLoop(),
+                           ExecutionOptions options = defaultExecutionOptions())
+  {
+    if (begin >= end)
+      return futurize();
+
+    struct Run : detail::ParallelRunBase
+    {
+      Proc process;
+      Promise<void> promise;
+      Run(Proc p) : process(std::move(p)) {}
+    };
+    auto run = boost::make_shared<Run>(std::move(process));
+    run->next.store(begin);
+    run->end = end;
+    run->chunk = detail::parallelChunkSize(end - begin, (std::max)(pool->workerCount(), 1u));
+    const unsigned int workers = detail::parallelWorkerCount(end - begin, run->chunk, pool);
+    run->activeWorkers.store(static_cast<int>(workers));
+
+    boost::weak_ptr<Run> weakRun = run; // the promise must not keep the run alive
+    run->promise.setOnCancel([weakRun](Promise<void>&) {
+      if (auto r = weakRun.lock())
+      {
+        r->cancelRequested.store(true, std::memory_order_relaxed);
+        r->stopped.store(true, std::memory_order_relaxed);
+      }
+    });
+
+    const auto work = [run] {
+      size_t first, last;
+      while (run->claim(first, last))
+      {
+        try
+        {
+          for (; first != last; ++first)
+            run->process(first);
+        }
+        catch (const std::exception& e)
+        {
+          run->fail(e.what());
+        }
+        catch (...)
+        {
+          run->fail("unknown error");
+        }
+      }
+      if (run->activeWorkers.fetch_sub(1) != 1)
+        return;
+      // Last worker out reports the outcome.
+      boost::mutex::scoped_lock lock(run->mergeMutex);
+      if (!run->error.empty())
+        run->promise.setError(run->error);
+      else if (run->cancelRequested.load(std::memory_order_relaxed))
+        run->promise.setCanceled();
+      else
+        run->promise.setValue(nullptr);
+    };
+    for (unsigned int i = 0; i < workers; ++i)
+      pool->post(work, options);
+    return run->promise.future();
+  }
+
+  /** Parallel map-reduce over [begin, end): computes `transform(i)` for
+   * every index on the workers of an event loop, combines the results with
+   * `combine` and returns a future holding
+   * `combine(init, ...all transformed values...)`.
+   *
+   * `combine` must be associative and commutative: each worker folds the
+   * chunks it claimed locally and the per-worker results are merged in
+   * completion order, so nothing else is guaranteed about the combining
+   * order. `init` is used exactly once, as the seed of the final merge.
+   *
+   * Errors and cancellation behave as in parallelFor.
+   *
+   * \includename{qi/parallel.hpp}
+   */
+  template <typename T, typename Transfo, typename Combine>
+  Future<T> parallelReduce(size_t begin, size_t end, T init,
+                           Transfo transform, Combine combine,
+                           EventLoop* pool = getEventLoop(),
+                           ExecutionOptions options = defaultExecutionOptions())
+  {
+    if (begin >= end)
+      return futurize(std::move(init));
+
+    struct Run : detail::ParallelRunBase
+    {
+      Transfo transform;
+      Combine combine;
+      T result; // protected by mergeMutex
+      Promise<T> promise;
+      Run(Transfo t, Combine c, T i)
+        : transform(std::move(t)), combine(std::move(c)), result(std::move(i)) {}
+    };
+    auto run = boost::make_shared<Run>(std::move(transform), std::move(combine), std::move(init));
+    run->next.store(begin);
+    run->end = end;
+    run->chunk = detail::parallelChunkSize(end - begin, (std::max)(pool->workerCount(), 1u));
+    const unsigned int workers = detail::parallelWorkerCount(end - begin, run->chunk, pool);
+    run->activeWorkers.store(static_cast<int>(workers));
+
+    boost::weak_ptr<Run> weakRun = run;
+    run->promise.setOnCancel([weakRun](Promise<T>&) {
+      if (auto r = weakRun.lock())
+      {
+        r->cancelRequested.store(true, std::memory_order_relaxed);
+        r->stopped.store(true, std::memory_order_relaxed);
+      }
+    });
+
+    const auto work = [run] {
+      // Folding locally and merging once per worker keeps the mutex out of
+      // the per-index path. The local fold is seeded with the first value,
+      // not with `init`, so `init` is counted exactly once overall.
+      boost::optional<T> local;
+      size_t first, last;
+      while (run->claim(first, last))
+      {
+        try
+        {
+          for (; first != last; ++first)
+          {
+            if (local)
+              local = run->combine(std::move(*local), run->transform(first));
+            else
+              local = run->transform(first);
+          }
+        }
+        catch (const std::exception& e)
+        {
+          run->fail(e.what());
+        }
+        catch (...)
+        {
+          run->fail("unknown error");
+        }
+      }
+      boost::mutex::scoped_lock lock(run->mergeMutex);
+      try
+      {
+        if (local && run->error.empty())
+          run->result = run->combine(std::move(run->result), std::move(*local));
+      }
+      catch (const std::exception& e)
+      {
+        if (run->error.empty())
+          run->error = e.what();
+      }
+      if (run->activeWorkers.fetch_sub(1) != 1)
+        return;
+      if (!run->error.empty())
+        run->promise.setError(run->error);
+      else if (run->cancelRequested.load(std::memory_order_relaxed))
+        run->promise.setCanceled();
+      else
+        run->promise.setValue(std::move(run->result));
+    };
+    for (unsigned int i = 0; i < workers; ++i)
+      pool->post(work, options);
+    return run->promise.future();
+  }
+}
+
+#endif  // _QI_PARALLEL_HPP_
@@ -225,6 +225,16 @@ namespace qi
        */
       QI_API void clearOptionalSdkPrefix();
 
+      /**
+       * \brief Drop the cached directory listings used by the find* functions.
+       *
+       * The SDK layout caches the content of the directories it probes, so
+       * files created after a lookup are not seen until the cache is
+       * invalidated. Prefix and writable-path changes invalidate it
+       * automatically.
+       */
+      QI_API void invalidateSdkLayoutCache();
+
       /**
        * \brief Set the writable files path for users.
        * \param path Path to the new writable data path
@@ -12,6 +12,7 @@
 #include <string>
 
 #include <qi/api.hpp>
+#include <qi/perf/measure.hpp>
 
 namespace qi
 {
@@ -31,6 +32,29 @@ namespace qi
     /// Stop measuring time
     void stop();
 
+    /// Record the end of one benchmark iteration.
+    ///
+    /// The time elapsed since start() or since the previous recordSample()
+    /// call is stored as one latency sample in a log-linear histogram
+    /// (64 sub-buckets per power of two, under 2% relative error), so the
+    /// distribution getters below can report percentiles. Call it once per
+    /// iteration inside the benchmarked loop; the histogram adds a few
+    /// nanoseconds per call and never allocates after start().
+    void recordSample();
+    /// Discard the first \a count samples of the next run as warm-up.
+    /// Must be called before start(); 0 (the default) keeps every sample.
+    void setWarmupCount(unsigned long count);
+
+    /// Return the given percentile (e.g. 50, 90, 99, 99.9) of the recorded
+    /// samples, in microseconds, or -1 if no sample was recorded.
+    double getPercentile(double percentile) const;
+    /// Return the smallest recorded sample in microseconds, or -1 if none.
+    double getMinSample() const;
+    /// Return the largest recorded sample in microseconds, or -1 if none.
+    double getMaxSample() const;
+    /// Return the number of samples recorded, warm-up excluded.
+    unsigned long getSampleCount() const;
+
     /// Return the name of the benchmark.
     std::string getBenchmarkName() const;
     /// Return the variable of the benchmark
@@ -46,6 +70,12 @@ namespace qi
     /// Return the MB transmitted in a single second.
     double getMegaBytePerSecond() const;
 
+    /// Return the perf_event counters (cycles, instructions, cache misses,
+    /// context switches) and the resident-set growth sampled between
+    /// start() and stop(). Counters unavailable on this platform or
+    /// configuration are -1 (see qi::measure::PerfCounters).
+    measure::CounterValues getCounters() const;
+
   private:
     DataPerfPrivate *_p;
   };
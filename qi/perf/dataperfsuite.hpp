@@ -40,6 +40,30 @@ namespace qi
       /// Overloading used to print data out.
       DataPerfSuite& operator<<(const DataPerf& data);
 
+      /// Load the XML output of a previous run as a comparison baseline.
+      ///
+      /// Every benchmark printed afterwards is compared against the entry
+      /// with the same name (and variable) in the baseline, and the delta is
+      /// reported next to the result. A benchmark whose selected metric is
+      /// worse than the baseline by more than the regression threshold is
+      /// counted as a regression.
+      /// \param filename A file produced by this class on a previous run.
+      /// \return false if the file cannot be read, true otherwise.
+      bool loadBaseline(const std::string& filename);
+
+      /// Set the tolerated degradation before a benchmark counts as a
+      /// regression, as a percentage of the baseline value (default: 5).
+      void setRegressionThreshold(double percent);
+
+      /// Number of benchmarks worse than the baseline beyond the threshold.
+      ///
+      /// Meant to be used as (part of) the process exit code so releases can
+      /// be gated on it:
+      /// \code
+      /// return static_cast<int>(suite.regressionCount());
+      /// \endcode
+      unsigned int regressionCount() const;
+
       /// Print end of file and close it.
       void close();
 
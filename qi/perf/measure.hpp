@@ -10,6 +10,7 @@
 #define _QI_PERF_UTILS_HPP_
 
 #include <qi/api.hpp>
+#include <qi/types.hpp>
 
 namespace qi
 {
@@ -17,6 +18,49 @@ namespace qi
   {
     // Get the number of fd currently open. Works only for linux.
     QI_API int getNumFD();
+
+    /// Resident set size of the process in bytes, or -1 where unavailable
+    /// (read from /proc/self/statm, so Linux only).
+    QI_API qi::int64_t getResidentSetSize();
+
+    /// Counter values sampled over a measured section. -1 means the
+    /// counter could not be collected on this platform or configuration.
+    struct QI_API CounterValues
+    {
+      qi::int64_t cycles = -1;
+      qi::int64_t instructions = -1;
+      qi::int64_t cacheMisses = -1;
+      qi::int64_t contextSwitches = -1;
+      /// Growth of the resident set between start() and stop(), in bytes.
+      qi::int64_t residentSetDelta = -1;
+    };
+
+    class PerfCountersPrivate;
+
+    /// Hardware and software counters around a measured section
+    /// (perf_event on Linux, plus a resident-set snapshot).
+    ///
+    /// Degradation is graceful and per counter: when the platform, the
+    /// kernel configuration (perf_event_paranoid) or the hardware does not
+    /// expose one, its value simply stays -1 and the others are still
+    /// collected. DataPerf samples one of these around start()/stop(); it
+    /// can also be used standalone around any code section.
+    class QI_API PerfCounters
+    {
+    public:
+      PerfCounters();
+      ~PerfCounters();
+
+      /// True if at least one perf_event counter could be opened.
+      bool available() const;
+      /// Reset and enable the counters.
+      void start();
+      /// Disable the counters and return their values since start().
+      CounterValues stop();
+
+    private:
+      PerfCountersPrivate* _p;
+    };
   }
 }
 
@@ -30,6 +30,32 @@ namespace qi
     /// \brief Callback is a boost::function.
     using Callback = boost::function<void()>;
 
+    /**
+     * \brief Snapshot of the scheduling statistics of a periodic task.
+     *
+     * Collected at trigger time for every activation since start() (or the
+     * last resetStats() call). Jitter is how late an activation started
+     * compared to its due time; the histogram buckets are log-scaled:
+     * <100us, <1ms, <10ms, <100ms, <1s, and the rest.
+     */
+    struct Stats
+    {
+      static const unsigned jitterBucketCount = 6;
+      /// Number of completed activations.
+      uint64_t activations = 0;
+      /// Activations whose callback ran longer than the period, i.e. the
+      /// call-time compensation could not keep the pace.
+      uint64_t overruns = 0;
+      /// Cumulated and worst callback wall time.
+      Duration totalCallbackTime = Duration(0);
+      Duration maxCallbackTime = Duration(0);
+      /// Cumulated and worst activation jitter.
+      Duration totalJitter = Duration(0);
+      Duration maxJitter = Duration(0);
+      /// Activation jitter histogram (see the class documentation).
+      uint64_t jitterBuckets[jitterBucketCount] = {};
+    };
+
     /// \brief Default constructor.
     PeriodicTask();
 
@@ -136,6 +162,13 @@ namespace qi
      */
     bool isStopping() const;
 
+    /// \return a snapshot of the scheduling statistics accumulated since
+    ///         start() or the last resetStats() call.
+    Stats stats() const;
+
+    /// \brief Reset the scheduling statistics.
+    void resetStats();
+
   private:
     boost::shared_ptr<PeriodicTaskPrivate> _p;
 
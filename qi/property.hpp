@@ -98,20 +98,76 @@ namespace qi
       Getter getter = Getter(), Setter setter = Setter(),
       SignalBase::OnSubscribers onsubscribe = SignalBase::OnSubscribers());
 
+    ~PropertyImpl() override;
+
     virtual FutureSync<T> get() const = 0;
     virtual FutureSync<void> set(const T& v) = 0;
 
+    /** Reads the value synchronously, in the calling thread: no strand hop,
+     * no future allocation, no boxing. The stored value is copied (or the
+     * getter run) under an internal lock that writes also take, so the read
+     * sees the last completed write; unlike get() it does not wait behind
+     * writes still queued on the strand.
+     *
+     * With a custom getter this runs it in the calling thread instead of
+     * the property's execution context; a getter that is not a pure
+     * function of the stored value (e.g. a ProxyProperty fetching from its
+     * backend) keeps its own cost and threading here.
+     */
+    T getNow() const;
+
+    /** Calls \p f with the current value under the same lock, avoiding even
+     * the copy of getNow(). \p f receives a `const T&` only valid during
+     * the call, and must not touch the property from within.
+     */
+    template<typename F>
+    void readNow(F f) const;
+
     PropertyImpl<T>& operator=(const T& v) { this->set(v); return *this; }
 
     SignalBase* signal() override { return this; }
 
+    /** Enable latest-value-wins notification coalescing: rapid successive
+     * sets collapse into a single notification carrying the latest value,
+     * delivered at most \p maxDelay after the first set of a burst. A zero
+     * delay (the default) notifies every set, as before.
+     *
+     * Coalescing happens in the property's signal path, so both local
+     * subscribers and remote ProxyProperty subscribers see fewer events.
+     * Call this before the property is used; with coalescing enabled,
+     * direct-connected subscribers are invoked with an internal lock held
+     * and must not set the property from within their callback.
+     */
+    void setNotifyCoalescing(qi::Duration maxDelay);
+
   protected:
     Getter _getter;
     Setter _setter;
     T      _value;
+    /// Guards _value against getNow()/readNow() readers, which do not go
+    /// through the property's execution context.
+    mutable boost::mutex _valueMutex;
 
     T getImpl() const;
     void setImpl(const T& v);
+    /// Notifies subscribers of a new value, immediately or through the
+    /// coalescing window (see setNotifyCoalescing).
+    void notify(const T& v);
+
+  private:
+    // Shared with the delayed notification task so that it can outlive a
+    // property destroyed mid-burst; `alive` is cleared by the destructor
+    // under the lock, which the task also holds while notifying.
+    struct CoalesceState
+    {
+      boost::mutex mutex;
+      qi::Duration maxDelay{0};
+      bool pending = false;
+      bool alive = true;
+      T value{};
+      PropertyImpl* owner = nullptr;
+    };
+    boost::shared_ptr<CoalesceState> _coalesceState;
   };
 
   /** Povide access to a stored value and signal to connected callbacks when the value changed.
@@ -9,7 +9,9 @@
 
 #include <qi/api.hpp>
 #include <qi/clock.hpp>
+#include <qi/memorystats.hpp>
 #include <qi/messaging/serviceinfo.hpp>
+#include <qi/messaging/socketstats.hpp>
 #include <qi/messaging/authproviderfactory.hpp>
 #include <qi/messaging/clientauthenticatorfactory.hpp>
 #include <qi/future.hpp>
@@ -60,6 +62,25 @@ namespace qi {
 
     qi::FutureSync< std::vector<ServiceInfo> > services(ServiceLocality locality = ServiceLocality_All);
 
+    /// Activity counters of every messaging socket this session currently
+    /// holds: the service directory connection, the client connections to
+    /// services and the connections accepted by the server side. The
+    /// counters are always-on (see SocketStats), so this is cheap enough to
+    /// poll periodically in production.
+    std::vector<SocketStats> socketsStats();
+
+    /// Process-wide memory accounting of libqi's pools and queues, see
+    /// qi::memoryStats(). Exposed here too so monitoring code holding a
+    /// session gets sockets and memory from the same place.
+    MemoryStats memoryStats();
+
+    /// Dumps the session's flight recorder to the log: the headers of the
+    /// last messages sent and received on this session's sockets (ring size
+    /// from QI_FLIGHT_RECORDER_SIZE, default 256). Recording is always on
+    /// and the dump also happens automatically when the connection to the
+    /// service directory is lost.
+    void dumpMessageHistory();
+
     static qi::MilliSeconds defaultServiceTimeout()
     {
       return qi::Minutes{1};
@@ -100,6 +121,14 @@ namespace qi {
     qi::FutureSync<void> listenStandalone(const qi::Url &address);
     qi::FutureSync<void> listenStandalone(const std::vector<qi::Url> &addresses);
 
+    /// Sets the handler that the standalone service directory of this session
+    /// invokes when a client asks for a service name that is not registered.
+    /// The handler may register the missing service on the fly (used by
+    /// ServiceDirectoryProxy for lazy mirroring) and returns true to make the
+    /// directory retry the lookup once. Only meaningful on sessions used with
+    /// listenStandalone().
+    void setDirectoryMissingServiceHandler(boost::function<bool(const std::string&)> handler);
+
     qi::FutureSync<unsigned int> registerService(const std::string &name, AnyObject object);
     qi::FutureSync<void>         unregisterService(unsigned int serviceId);
 
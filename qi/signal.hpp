@@ -7,6 +7,8 @@
 #ifndef _QI_SIGNAL_HPP_
 #define _QI_SIGNAL_HPP_
 
+#include <typeinfo>
+
 #include <boost/function.hpp>
 #include <boost/scoped_ptr.hpp>
 #include <qi/atomic.hpp>
@@ -145,10 +147,22 @@ namespace qi {
 
     /// Set a function to call when the number of subscribers go between 1 and 0.
     /// You can use this to avoid computing if no one has subscribed to the signal.
+    /// This also works for signals exposed through a session: the messaging
+    /// layer subscribes to the signal when the first remote client registers to
+    /// it and unsubscribes when the last one unregisters (or its socket dies),
+    /// so the callback reports a true zero even for remote-only subscribers.
     void setOnSubscribers(OnSubscribers onSubscribers);
 
     static const SignalLink invalidSignalLink;
     void _setSignature(const Signature &s);
+
+    /// Internal. Typed fast path for in-process emission: when the signal has
+    /// no trigger override and every subscriber holds a typed handler of
+    /// exactly `type` and would be called synchronously, calls `invoke` with
+    /// each handler (a boost::function of that type) and returns true. Returns
+    /// false without calling anything when the type-erased path is required.
+    bool _tryTriggerTyped(const std::type_info& type,
+                          const boost::function<void(void*)>& invoke);
   protected:
     using Trigger = boost::function<void(const GenericFunctionParameters& params, MetaCallType callType)>;
     void callSubscribers(const GenericFunctionParameters& params, MetaCallType callType = MetaCallType_Auto);
@@ -296,6 +310,51 @@ QI_WARNING_POP()
 
     SignalSubscriber setCallType(MetaCallType ct);
 
+    /** Request a direct connection: the callback runs synchronously in the
+     * emitter's thread, bypassing any execution context (including the
+     * signal's own). This removes the scheduler round trip and is meant for
+     * latency-critical in-process pipelines.
+     *
+     * The callback must be fast and non-blocking, must not disconnect itself
+     * or destroy the signal, and must tolerate being invoked concurrently
+     * from several emitter threads.
+     */
+    SignalSubscriber setDirectConnection();
+
+    /** Request at most maxRateHz events per second for this subscriber;
+     * events beyond that rate are dropped, not delayed. 0 (the default)
+     * means unlimited.
+     *
+     * Only enforced end to end for remote signals whose server understands
+     * the registerEventWithRate bound method: the emitter then skips the
+     * excess events before serializing them, so a slow dashboard costs its
+     * own rate instead of the signal's. Several local subscribers share one
+     * remote registration; the shared rate is lifted when a subscriber
+     * requests more.
+     */
+    SignalSubscriber setMaxEventRate(float maxRateHz);
+    /// Requested event rate ceiling in Hz, 0 when unlimited.
+    float maxEventRate() const;
+
+    /** Request windowed delivery for this subscriber: the emitter stops
+     * serializing events after `window` unacknowledged ones and resumes as
+     * acknowledgments flow back, so a dead-slow consumer costs bounded
+     * producer memory instead of filling the socket queue. With
+     * coalesceLatest (the default) the newest event held back is delivered
+     * when the window reopens; otherwise held-back events are dropped.
+     * 0 (the default) means unwindowed.
+     *
+     * Like setMaxEventRate this is only enforced for remote signals whose
+     * server understands the setEventWindow bound method, and the shared
+     * remote registration keeps the least restrictive request among its
+     * local subscribers.
+     */
+    SignalSubscriber setAckWindow(int window, bool coalesceLatest = true);
+    /// Requested delivery window in events, 0 when unwindowed.
+    int ackWindow() const;
+    /// Whether held-back events coalesce to the newest one, see setAckWindow.
+    bool ackCoalesce() const;
+
     /// @return the identifier of the subscription (aka link)
     SignalLink link() const;
     operator SignalLink() const;
@@ -305,6 +364,11 @@ QI_WARNING_POP()
     */
     Signature signature() const;
 
+    /// Internal. Attaches the original typed functor so that emission can skip
+    /// AnyReference boxing (see SignalBase::_tryTriggerTyped). Must be called
+    /// before the subscriber is connected.
+    void _setTypedHandler(boost::shared_ptr<void> handler, const std::type_info& type);
+
   private:
     std::shared_ptr<SignalSubscriberPrivate> _p;
 
@@ -345,6 +409,14 @@ QI_WARNING_POP()
     AnyFunction handler;
     MetaCallType threadingModel = MetaCallType_Direct;
 
+    // Original typed functor (really a boost::function of the type designated
+    // by typedHandlerType), kept alongside handler when the subscriber was
+    // connected with a typed callback. Lets the emission fast path invoke it
+    // directly, without going through AnyReference boxing. Set before the
+    // subscriber is connected, immutable afterwards.
+    boost::shared_ptr<void> typedHandler;
+    const std::type_info* typedHandlerType = nullptr;
+
     //   Mode 2: metaCall
     boost::scoped_ptr<AnyWeakObject> target;
     unsigned int method = 0;
@@ -352,6 +424,20 @@ QI_WARNING_POP()
     // If enabled is set to false, no more callback will trigger
     std::atomic<bool> enabled{true};
 
+    // Requested event rate ceiling in Hz, 0 for unlimited. Only meaningful
+    // for remote signals, see SignalSubscriber::setMaxEventRate().
+    float maxEventRate = 0.0f;
+
+    // Requested delivery window in events, 0 for unwindowed, and whether
+    // held-back events coalesce to the newest one. Only meaningful for
+    // remote signals, see SignalSubscriber::setAckWindow().
+    int ackWindow = 0;
+    bool ackCoalesce = true;
+
+    // Direct connection: always call synchronously in the emitter's thread,
+    // ignoring threadingModel and executionContext. See setDirectConnection().
+    std::atomic<bool> directConnection{false};
+
     // ExecutionContext on which to schedule the call
     std::atomic<ExecutionContext*> executionContext{nullptr};
   };
@@ -3,6 +3,9 @@
 #ifndef _QI_SIGNALSPY_HPP_
 #define _QI_SIGNALSPY_HPP_
 
+#include <atomic>
+#include <memory>
+
 #include <qi/actor.hpp>
 #include <qi/anyobject.hpp>
 #include <qi/api.hpp>
@@ -39,6 +42,38 @@ public:
   /// Constructor taking a type-erased signal.
   SignalSpy(AnyObject& object, const std::string& signalOrPropertyName);
 
+  /**
+   * @brief Ring-buffer recording mode, for spying on high-rate signals.
+   * Records go into a preallocated ring of `slots` entries appended to
+   * lock-free from the emitter's own context (no strand hop), the ring
+   * overwriting its oldest entries once full. With keepValues false only
+   * the emission count and timestamps are recorded, so attaching the spy
+   * does not even copy the arguments.
+   */
+  struct RingRecording
+  {
+    size_t slots;
+    bool keepValues = true;
+  };
+
+  /// Constructor taking a signal instance, recording into a ring buffer.
+  /// The signal instance must outlive the signal spy.
+  template<typename... Args>
+  SignalSpy(SignalF<void(Args...)>& signal, RingRecording ring)
+  {
+    initRing(ring);
+    SignalLink link = signal.connect([this](const Args&... args)
+    {
+      ringAppend(_ringKeepValues ?
+          std::vector<AnyValue>{AnyValue::from<Args>(args)...} :
+          std::vector<AnyValue>{});
+    }).setCallType(MetaCallType_Direct);
+    _disconnect = [link, &signal]{ signal.disconnect(link); };
+  }
+
+  /// Constructor taking a type-erased signal, recording into a ring buffer.
+  SignalSpy(AnyObject& object, const std::string& signalOrPropertyName, RingRecording ring);
+
   // Non-copyable
   SignalSpy(const SignalSpy&) = delete;
   SignalSpy& operator=(const SignalSpy&) = delete;
@@ -49,8 +84,12 @@ public:
   struct Record
   {
     /// Signal arguments are stored here, in a type-erased way for compatibility.
+    /// Empty in ring-buffer mode when values are dropped (RingRecording).
     std::vector<qi::AnyValue> args;
 
+    /// When the emission was recorded.
+    SteadyClockTimePoint timestamp;
+
     /// Use this to access an argument in the type you expect it.
     template<typename T>
     const T& arg(int index) const
@@ -84,6 +123,24 @@ private:
   /// The signal records.
   std::vector<Record> _records;
 
+  /// One preallocated entry of the ring buffer (RingRecording). The
+  /// sequence number makes the slot a seqlock: 0 while never written, odd
+  /// while the writer is in the slot, 2n+2 once emission n is complete, so
+  /// readers can detect and drop entries they raced with.
+  struct RingSlot
+  {
+    std::atomic<uint64_t> seq{0};
+    SteadyClockTimePoint timestamp;
+    std::vector<AnyValue> args;
+  };
+
+  /// The ring, null in (default) strand-recording mode.
+  std::unique_ptr<RingSlot[]> _ring;
+  size_t _ringSize = 0;
+  bool _ringKeepValues = true;
+  /// Total emissions seen, also indexing the next slot to write.
+  std::atomic<uint64_t> _ringEmissions{0};
+
   /// Emitted for internal synchronization.
   mutable Signal<void> recorded;
 
@@ -92,12 +149,25 @@ private:
   void recordCallback(const Args&... args)
   {
     QI_ASSERT(strand()->isInThisContext());
-    _records.emplace_back(Record{{AnyValue::from<Args>(args)...}});
+    _records.emplace_back(Record{{AnyValue::from<Args>(args)...}, SteadyClock::now()});
     recorded();
   }
 
   /// Internal type-erased callback for type-erased signals.
   AnyReference recordAnyCallback(const AnyReferenceVector& args);
+
+  /// Allocates the ring (RingRecording constructors).
+  void initRing(const RingRecording& ring);
+  /// Lock-free append to the ring, called from the emitter's context.
+  void ringAppend(std::vector<AnyValue> values);
+  /// Consistent snapshot of the retained ring entries, oldest first.
+  std::vector<Record> ringRecords() const;
+  /// Emission count, readable from any context.
+  size_t currentCount() const
+  {
+    return _ring ? static_cast<size_t>(_ringEmissions.load(std::memory_order_acquire))
+                 : _records.size();
+  }
 };
 }
 
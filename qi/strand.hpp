@@ -36,6 +36,16 @@ namespace detail
   struct StrandedUnwrapped;
 }
 
+/// Policy applied to a task scheduled on a strand whose pending-task limit is
+/// reached. @see Strand::setMaxPendingTasks
+enum class StrandOverflowPolicy
+{
+  DropOldest, ///< Drop the oldest droppable pending task; its future is set in error.
+  DropNewest, ///< Silently drop the new task; its future is set to canceled.
+  Fail,       ///< Refuse the new task; its future is set in error.
+  Block,      ///< Block the caller until a slot is freed (no-op from inside the strand).
+};
+
 // we use ExecutionContext's helpers in schedulerFor, we don't need to implement all the methods
 class StrandPrivate : public ExecutionContext, public boost::enable_shared_from_this<StrandPrivate>
 {
@@ -46,17 +56,49 @@ public:
 
   using Queue = std::deque<boost::shared_ptr<Callback>>;
 
+  /// Intrusive link of the lock-free incoming queue; Callback derives from
+  /// it so that pushing a job does not allocate (see strand.cpp).
+  struct MpscNode
+  {
+    std::atomic<MpscNode*> next{nullptr};
+  };
+
   qi::ExecutionContext& _executor;
   std::atomic<unsigned int> _curId;
   std::atomic<unsigned int> _aliveCount;
-  bool _processing; // protected by mutex, no need for atomic
+  std::atomic<bool> _processing;
   std::atomic<int> _processingThread;
   boost::recursive_mutex _mutex;
   boost::condition_variable_any _processFinished;
-  bool _dying;
+  std::atomic<bool> _dying;
   Queue _queue;
 
+  // Incoming jobs: producers push lock-free, the processing thread drains
+  // them into _queue. Vyukov-style intrusive MPSC queue with a stub node.
+  MpscNode _incomingStub;
+  std::atomic<MpscNode*> _incomingTail{&_incomingStub};
+  MpscNode* _incomingHead{&_incomingStub}; // touched only by the consumer
+  // Number of jobs in the incoming queue, counted before the push: the
+  // processing thread uses it to detect jobs that are queued but not
+  // poppable yet because their producer is mid-push.
+  std::atomic<int64_t> _pendingIncoming{0};
+  // Producers inside enqueueImmediate, past the _dying check; join() waits
+  // for them before draining the queues for the last time.
+  std::atomic<int> _inFlightEnqueues{0};
+  // Mailbox bound: maximum number of pending tasks, 0 meaning unlimited, and
+  // the policy applied to tasks scheduled beyond the limit.
+  std::atomic<size_t> _maxPendingTasks{0};
+  std::atomic<StrandOverflowPolicy> _overflowPolicy{StrandOverflowPolicy::Fail};
+  // Pending tasks in submission order, maintained only under the drop-oldest
+  // policy; entries of executed tasks expire on their own and are pruned
+  // lazily. Protected by _mutex.
+  std::deque<boost::weak_ptr<Callback>> _submissionOrder;
+  // Signaled whenever _aliveCount decreases, to release producers blocked by
+  // the block-on-overflow policy.
+  boost::condition_variable_any _mailboxFreed;
+
   explicit StrandPrivate(qi::ExecutionContext& executor);
+  ~StrandPrivate() override;
 
   // Schedules the callback for execution. If the trigger date `tp` is in the past, executes the
   // callback immediately in the calling thread.
@@ -69,8 +111,35 @@ public:
   // Schedules the callback for deferred execution and returns immediately.
   Future<void> deferImpl(boost::function<void()> cb, qi::Duration delay, ExecutionOptions options = defaultExecutionOptions());
 
+  /// Outcome of confronting a new task with the mailbox bound.
+  enum class Admission
+  {
+    Accepted,
+    RejectedError,    ///< The task must be refused with a future in error.
+    RejectedCanceled, ///< The task must be silently dropped (canceled future).
+  };
+
+  /// Applies the overflow policy when the mailbox is full: drops the oldest
+  /// task, rejects the new one, or blocks until a slot is freed.
+  Admission admitTask();
+  /// Drops the oldest droppable pending task. Must be called with _mutex held.
+  bool dropOldestTask();
+  /// Records the task for the drop-oldest policy bookkeeping, if enabled.
+  void recordSubmission(const boost::shared_ptr<Callback>& cbStruct);
+
   boost::shared_ptr<Callback> createCallback(boost::function<void()> cb, ExecutionOptions options);
   void enqueue(boost::shared_ptr<Callback> cbStruct, ExecutionOptions options);
+  /// Lock-free enqueue for jobs that are not yet visible to any other thread
+  /// (the zero-delay path): a couple of atomic operations, no mutex.
+  void enqueueImmediate(boost::shared_ptr<Callback> cbStruct);
+
+  /// Producer side of the incoming queue, safe from any thread.
+  void pushIncoming(MpscNode* node);
+  /// Moves whatever is poppable from the incoming queue to _queue. Must only
+  /// be called by the single consumer (processing thread, or join).
+  void drainIncoming();
+  /// Schedules process() on the executor unless it is already running.
+  void scheduleProcessIfNeeded();
 
   void process();
   void cancel(boost::shared_ptr<Callback> cbStruct);
@@ -249,6 +318,25 @@ public:
                       MicroSeconds delay = MicroSeconds::zero(),
                       ExecutionOptions options = defaultExecutionOptions());
 
+  using OverflowPolicy = StrandOverflowPolicy;
+
+  /** Bounds the number of tasks waiting to be executed by the strand.
+   *
+   * Without a bound, a strand whose consumer is stuck accumulates tasks
+   * until the process runs out of memory. Once the limit is reached, newly
+   * scheduled tasks are handled according to the policy. Tasks scheduled
+   * with CancelOption::NeverSkipExecution are never dropped by the
+   * drop-oldest policy, and the block policy never blocks calls made from
+   * inside the strand, as that would deadlock it.
+   *
+   * @param limit Maximum number of pending tasks; 0 removes the bound.
+   * @param policy What to do with tasks scheduled beyond the limit.
+   */
+  void setMaxPendingTasks(size_t limit, OverflowPolicy policy = OverflowPolicy::Fail);
+
+  /// Number of tasks scheduled on the strand and not yet executed.
+  size_t pendingTaskCount() const;
+
 private:
   boost::shared_ptr<StrandPrivate> _p;
 
@@ -294,6 +382,34 @@ private:
 
 namespace detail
 {
+  // Void calls - the whole signal->actor delivery traffic - need no result
+  // adapters: the future returned by the strand already carries the call's
+  // success, error or cancellation (see StrandPrivate::process). Hand it the
+  // bound call as a single callable with inline storage, erased once, instead
+  // of stacking the typed-promise machinery of ExecutionContext::async on
+  // top, which costs two more wrapper allocations per deferred invocation.
+  template <typename F, typename... Args>
+  static auto callInStrand(
+      F& func,
+      const boost::function<void()>& onFail,
+      boost::weak_ptr<StrandPrivate> weakStrand,
+      ExecutionOptions options,
+      Args... args)
+      -> typename std::enable_if<std::is_void<decltype(func(std::move(args)...))>::value,
+                                 qi::Future<void>>::type
+  {
+    if (auto strand = weakStrand.lock())
+    {
+      return strand->asyncDelayImpl(std::bind(func, std::move(args)...), qi::Duration(0), options);
+    }
+    else
+    {
+      if (onFail)
+        onFail();
+      return qi::makeFutureError<void>("strand is dead");
+    }
+  }
+
   template <typename F, typename... Args>
   static auto callInStrand(
       F& func,
@@ -301,7 +417,8 @@ namespace detail
       boost::weak_ptr<StrandPrivate> weakStrand,
       ExecutionOptions options,
       Args... args)
-      -> decltype(weakStrand.lock()->async(std::bind(func, std::move(args)...), options)) // TODO: remove in C++14
+      -> typename std::enable_if<!std::is_void<decltype(func(std::move(args)...))>::value,
+             decltype(weakStrand.lock()->async(std::bind(func, std::move(args)...), options))>::type
   {
     if (auto strand = weakStrand.lock())
     {
@@ -9,6 +9,9 @@
 #ifndef _QI_TRACKABLE_HPP_
 # define _QI_TRACKABLE_HPP_
 
+# include <atomic>
+# include <cstdint>
+
 # include <boost/thread/mutex.hpp>
 # include <boost/shared_ptr.hpp>
 # include <boost/thread/condition_variable.hpp>
@@ -25,6 +28,57 @@ namespace qi
   /// Common base class to templates Trackable for compile-time detection.
   class TrackableBase {};
 
+  namespace detail
+  {
+    /// Tracking state shared between a Trackable object and the call
+    /// wrappers built by track() and bind(): the number of calls in flight
+    /// in the low bits, and a flag in the high bit set when destruction
+    /// starts. The wrappers co-own the state, so checking it stays a safe,
+    /// failing operation after the object died.
+    struct TrackState
+    {
+      static const std::uint64_t dying = std::uint64_t(1) << 63;
+      std::atomic<std::uint64_t> value{0};
+      boost::mutex mutex;
+      boost::condition_variable cond;
+
+      /// Enter a call: one atomic increment. @return false if destruction
+      /// has started, in which case the call must not happen.
+      bool tryBeginCall()
+      {
+        if (value.fetch_add(1, std::memory_order_acquire) & dying)
+        {
+          endCall();
+          return false;
+        }
+        return true;
+      }
+
+      /// Leave a call entered with tryBeginCall().
+      void endCall()
+      {
+        const std::uint64_t previous =
+            value.fetch_sub(1, std::memory_order_release);
+        if ((previous & dying) && (previous & ~dying) == 1)
+        {
+          // last call left while beginDestroy() drains: wake it up. Taking
+          // the mutex orders the notification after the waiter went to sleep.
+          boost::mutex::scoped_lock lock(mutex);
+          cond.notify_all();
+        }
+      }
+
+      /// Refuse new calls, then wait for the ones in flight to leave.
+      void beginDestroy()
+      {
+        value.fetch_or(dying, std::memory_order_acq_rel);
+        boost::mutex::scoped_lock lock(mutex);
+        while ((value.load(std::memory_order_acquire) & ~dying) != 0)
+          cond.wait(lock);
+      }
+    };
+  }
+
   /**
    * \brief Object tracking by blocking destruction while shared pointers are present.
    *
@@ -63,6 +117,13 @@ namespace qi
      * are deleted.
      */
     void wait();
+
+    /** State shared with the call wrappers built by track() and bind():
+     * they enter with one atomic increment per invocation, instead of
+     * locking a weak pointer, and destroy() drains the calls in flight.
+     * Internal machinery.
+     */
+    boost::shared_ptr<detail::TrackState> trackState() const;
   protected:
     /**
      * *Must* be called by parent class destructor, first thing.
@@ -76,6 +137,7 @@ namespace qi
     boost::condition_variable _cond;
     boost::mutex              _mutex;
     bool                      _wasDestroyed;
+    boost::shared_ptr<detail::TrackState> _trackState;
   };
 
   class QI_API PointerLockException: public std::exception
@@ -8,6 +8,7 @@
 #define _QI_TRANSLATOR_HPP_
 
 # include <boost/noncopyable.hpp>
+# include <map>
 # include <string>
 # include <qi/api.hpp>
 
@@ -103,6 +104,31 @@ namespace qi
   {
     QI_API void addDomainPath(const std::string &path);
     QI_API void removeDomainPath(const std::string &path);
+
+    /**
+     * \brief Write a compiled message dictionary.
+     *
+     * A compiled dictionary is a flat hash table that qi::Translator maps
+     * read-only into memory and probes directly, bypassing the
+     * boost::locale machinery. It is looked up as
+     * \<domain path\>/\<locale\>/LC_MESSAGES/\<domain\>.qdic, next to the
+     * corresponding .mo catalog, and translate() falls back to the regular
+     * catalog for messages (or locales) it does not cover.
+     *
+     * \param path     Output file path.
+     * \param messages Translations, keyed by message id. When a message has
+     *                 a context, the key is the context, a '\\4' byte, then
+     *                 the message id (see dictionaryKey()).
+     * \return true on success.
+     */
+    QI_API bool compileDictionary(const std::string &path,
+                                  const std::map<std::string, std::string> &messages);
+
+    /**
+     * \brief Build the lookup key of a message for compileDictionary().
+     */
+    QI_API std::string dictionaryKey(const std::string &context,
+                                     const std::string &msg);
   }
 
 }
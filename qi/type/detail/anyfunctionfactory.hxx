@@ -371,6 +371,8 @@ namespace qi
     using ReturnType = typename boost::function_types::result_type<T>::type;
     FunctionTypeInterfaceEq(unsigned long refMask)
       : refMask(refMask)
+      , argsNeedTransform((refMask >> 1) != 0)
+      , adaptReturn(false)
     {
 #ifdef QITYPE_TRACK_FUNCTIONTYPE_INSTANCES
       detail::functionTypeTrack(typeid(S).name());
@@ -378,23 +380,34 @@ namespace qi
     }
     void* call(void* storage, void** args, unsigned int argc) override
     {
+      void* v;
+      if (!argsNeedTransform)
+      { // no reference bit set for any argument: transformRef would copy
+        // args unchanged, so hand the caller's array straight to the call
+        v = detail::makeCall(*(S*)ptrFromStorage(&storage), args);
+      }
+      else
+      {
 #if QI_HAS_VARIABLE_LENGTH_ARRAY
-      void* out[argc];
+        void* out[argc];
 #else
-      void* outStatic[8];
-      void** out;
-      if (argc <= 8)
-        out = outStatic;
-      else
-        out = new void*[argc];
+        void* outStatic[detail::maxAnyFunctionArgsCountHint];
+        void** out;
+        if (argc <= detail::maxAnyFunctionArgsCountHint)
+          out = outStatic;
+        else
+          out = new void*[argc];
 #endif
-      detail::transformRef(args, out, argc, refMask);
-      void* v = detail::makeCall(*(S*)ptrFromStorage(&storage), (void**)out);
+        detail::transformRef(args, out, argc, refMask);
+        v = detail::makeCall(*(S*)ptrFromStorage(&storage), (void**)out);
+#if ! QI_HAS_VARIABLE_LENGTH_ARRAY
+        if (argc > detail::maxAnyFunctionArgsCountHint)
+          delete[] out;
+#endif
+      }
       // v is storage for type ReturnType we claimed we were
-      // adapt return value if needed
-      if (boost::is_pointer<ReturnType>::value &&
-          (_resultType->kind() != TypeKind_Pointer ||
-           static_cast<PointerTypeInterface*>(_resultType)->pointerKind() != PointerTypeInterface::Raw))
+      // adapt return value if needed (decided once in make())
+      if (adaptReturn)
       {
         // if refMask&1, real return type is some Foo& and v is Foo*
         // else, return type is Foo with sizeof(Foo) == sizeof(void*) and v is a Foo
@@ -405,13 +418,11 @@ namespace qi
         // << ' ' << *(unsigned long*)vstorage;
         v = vstorage;
       }
-#if ! QI_HAS_VARIABLE_LENGTH_ARRAY
-      if (argc > 8)
-        delete[] out;
-#endif
       return v;
     }
     unsigned long refMask;
+    bool argsNeedTransform; ///< some argument bit is set in refMask
+    bool adaptReturn;       ///< return storage must be rewrapped for _resultType
     static FunctionTypeInterfaceEq<T, S>* make(unsigned long refMask, std::vector<TypeInterface*> argsType,
                                                TypeInterface* returnType)
     { // we need to hash/compare on all the arguments
@@ -428,6 +439,9 @@ namespace qi
         fptr = new FunctionTypeInterfaceEq<T, S>(refMask);
         fptr->_resultType = returnType;
         fptr->_argumentsType = argsType;
+        fptr->adaptReturn = boost::is_pointer<ReturnType>::value &&
+            (returnType->kind() != TypeKind_Pointer ||
+             static_cast<PointerTypeInterface*>(returnType)->pointerKind() != PointerTypeInterface::Raw);
       }
       return fptr;
     }
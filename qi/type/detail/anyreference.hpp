@@ -322,6 +322,19 @@ public:
   void insert(const K& key, const V& val);
   void insert(const AnyReference& key, const AnyReference& val);
 
+  /** Same as insert(), but hints the map that the key sorts after every
+   * key already present — e.g. when filling it in key order — making the
+   * fill amortized constant time per entry. A wrong hint still inserts
+   * (or overwrites) at the right place.
+   */
+  void insertAtEnd(const AnyReference& key, const AnyReference& val);
+
+  /** Preallocate room for count elements when the container supports it
+   * (vector lists, hash maps); no-op otherwise. Only a hint.
+   * @throw std::runtime_error if kind of `this` is not List, VarArgs or Map
+   */
+  void reserve(size_t count);
+
 
   /** Similar to operator[](), but return an empty AnyValue
    * If the key is not present.
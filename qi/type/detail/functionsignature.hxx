@@ -9,6 +9,7 @@
 
 #include <boost/thread/mutex.hpp>
 #include <qi/macro.hpp>
+#include <qi/type/detail/staticsignature.hpp>
 
 namespace qi {
   namespace detail {
@@ -18,6 +19,16 @@ namespace qi {
       {}
 
       template<typename T> void operator()(T *x) {
+        append<T>(typename HasStaticSignature<T>::type());
+      }
+
+      // Known at compile time: append the static string without going
+      // through the type registry and its lock.
+      template<typename T> void append(std::true_type) {
+        val += staticSignature<T>();
+      }
+
+      template<typename T> void append(std::false_type) {
         val += qi::typeOf<T>()->signature().toString();
       }
 
@@ -9,8 +9,10 @@
 
 #include <map>
 #include <string>
+#include <vector>
 
 #include <boost/smart_ptr/enable_shared_from_this.hpp>
+#include <boost/thread/mutex.hpp>
 
 #include <qi/api.hpp>
 #include <qi/type/detail/futureadapter.hpp>
@@ -44,6 +46,20 @@ class QI_API GenericObject
 public:
   GenericObject(ObjectTypeInterface *type, void *value, const boost::optional<PtrUid>& maybePtrUid = boost::none);
   ~GenericObject();
+
+  /// A copy refers to the same underlying object but starts with an empty
+  /// method cache: the cache mutex is not copyable, and the cache is a
+  /// per-instance memoization anyway.
+  GenericObject(const GenericObject& other);
+  GenericObject& operator=(const GenericObject& other);
+
+  /// GenericObject shells are recycled through a process-wide free list:
+  /// short-lived AnyObject wrappers around the same underlying objects are
+  /// created and destroyed in large numbers, and reusing the shell
+  /// allocation turns that churn into a pool pop/push. The list is capped
+  /// by QI_GENERICOBJECT_POOL_MAX (0 disables pooling).
+  static void* operator new(std::size_t size);
+  static void operator delete(void* p);
   const MetaObject &metaObject();
 
   // Help doxygen and the header reader a bit.
@@ -83,6 +99,18 @@ public:
   /// Find method named name callable with arguments parameters
   int findMethod(const std::string& name, const GenericFunctionParameters& parameters);
 
+  /**
+   * One-way (fire-and-forget) invocation of a signal or a method.
+   *
+   * On a signal, this triggers it. On a method, this invokes it without any
+   * reply bookkeeping: on a remote object the request goes out as a single
+   * post message with no message id tracking, no promise and no reply
+   * generated by the remote end. Errors raised by the target can only be
+   * logged, never reported to the caller. Use it for calls whose result is
+   * not needed (telemetry, notifications, ...).
+   */
+  //@{
+  /// By target name or signature; the ID is resolved on every call.
   void post(const std::string& eventName,
             qi::AutoAnyReference p1 = qi::AutoAnyReference(),
             qi::AutoAnyReference p2 = qi::AutoAnyReference(),
@@ -93,8 +121,21 @@ public:
             qi::AutoAnyReference p7 = qi::AutoAnyReference(),
             qi::AutoAnyReference p8 = qi::AutoAnyReference());
 
+  /// By method or signal ID, for hot paths: resolve the ID once with
+  /// metaObject().methodId() or signalId() and skip the per-call lookup.
+  void post(unsigned int methodOrSignalId,
+            qi::AutoAnyReference p1 = qi::AutoAnyReference(),
+            qi::AutoAnyReference p2 = qi::AutoAnyReference(),
+            qi::AutoAnyReference p3 = qi::AutoAnyReference(),
+            qi::AutoAnyReference p4 = qi::AutoAnyReference(),
+            qi::AutoAnyReference p5 = qi::AutoAnyReference(),
+            qi::AutoAnyReference p6 = qi::AutoAnyReference(),
+            qi::AutoAnyReference p7 = qi::AutoAnyReference(),
+            qi::AutoAnyReference p8 = qi::AutoAnyReference());
+
   void metaPost(unsigned int event, const GenericFunctionParameters& params);
   void metaPost(const std::string &nameWithOptionalSignature, const GenericFunctionParameters &in);
+  //@}
 
   /** Connect an event to an arbitrary callback.
    *
@@ -133,6 +174,20 @@ public:
   qi::FutureSync<AnyValue> property(unsigned int id);
   qi::FutureSync<void> setProperty(unsigned int id, const AnyValue &val);
 
+  /** Reads several properties in one round trip when the peer advertises
+   * the "getProperties" bound method, or through individual reads
+   * otherwise. The reply holds one (error message, value) pair per name,
+   * the error being empty on success, so one unknown property does not
+   * fail the rest.
+   */
+  qi::FutureSync<std::vector<std::pair<std::string, AnyValue>>> properties(
+      const std::vector<std::string>& names);
+  /** Writes several properties, bundled like properties(). Replies with
+   * one error string per entry, empty on success.
+   */
+  qi::FutureSync<std::vector<std::string>> setProperties(
+      const std::vector<std::pair<std::string, AnyValue>>& values);
+
 
   bool isValid() { return type && value;}
   ObjectTypeInterface*  type;
@@ -152,6 +207,18 @@ private:
       const std::string& nameWithOptionalSignature,
       const GenericFunctionParameters& args,
       const int errorNo);
+
+  /* Trusted resolutions of name-based calls. When MetaObject::findMethod
+   * reports that a resolution did not depend on the argument values (exact
+   * 'name::(sig)' form, or a single overload matching the argument count),
+   * the (name, argument count) pairing is recorded here and subsequent
+   * calls jump straight to the method ID, skipping overload resolution.
+   * Assumes the MetaObject stops changing once calls start flowing, which
+   * holds for objects built through the builders.
+   */
+  using MethodCacheKey = std::pair<std::string, size_t>;
+  boost::mutex _methodCacheMutex;
+  std::map<MethodCacheKey, unsigned int> _methodCache;
 };
 
 namespace detail
@@ -162,6 +229,47 @@ using ManagedObjectPtr = boost::shared_ptr<GenericObject>;
 
 }
 
+/**
+ * Accumulates calls on one object and flushes them in a single round trip.
+ *
+ * When the object is remote and the peer advertises the "callBatch" bound
+ * method, all queued calls travel in one bundled message and come back in
+ * one bundled reply, so N calls cost one network round trip instead of N.
+ * Otherwise flush() falls back to issuing the calls individually, so the
+ * batch can be used unconditionally.
+ *
+ * Obtained through AnyObject::batch(). Not thread-safe: queue the calls,
+ * flush once, then discard the batch. Queued calls may execute concurrently
+ * on the target, exactly as if they had been issued separately.
+ */
+class QI_API ObjectBatch
+{
+public:
+  explicit ObjectBatch(detail::ManagedObjectPtr object);
+  ObjectBatch(ObjectBatch&& other);
+  ~ObjectBatch();
+
+  /// Queue a call by method ID. Arguments are copied immediately.
+  /// The returned future is set once flush() got the result back.
+  qi::Future<AnyValue> call(unsigned int methodId, const GenericFunctionParameters& params);
+  /// Queue a call by name, resolving the overload from the arguments.
+  qi::Future<AnyValue> call(const std::string& name, const GenericFunctionParameters& params);
+
+  /// Send every queued call. The returned future is set when all the
+  /// per-call futures are, whichever transport was used.
+  qi::Future<void> flush();
+
+private:
+  struct Entry
+  {
+    unsigned int method;
+    GenericFunctionParameters params; // owned, destroyed after flush
+    Promise<AnyValue> promise;
+  };
+  detail::ManagedObjectPtr _object;
+  std::vector<Entry> _entries;
+};
+
 // C4251
 template <typename FUNCTION_TYPE>
 qi::FutureSync<SignalLink> GenericObject::connect(const std::string& eventName,
@@ -9,6 +9,11 @@
 
 #include <boost/type_traits/has_less.hpp>
 
+namespace ka {
+  template<typename K, typename T, typename C>
+  class flat_map_t;
+}
+
 namespace qi {
   namespace detail {
 
@@ -41,6 +46,15 @@ namespace qi {
         && HasLessGuard<V>::value;
     };
 
+    // Like std::map: the macro-generated operator< makes boost::has_less
+    // report true even when the mapped type is not comparable.
+    template<typename K, typename V, typename C>
+    struct HasLess<ka::flat_map_t<K, V, C> >
+    {
+      static const bool value = HasLessGuard<K>::value
+        && HasLessGuard<V>::value;
+    };
+
     template<typename A, typename B>
     struct HasLess<std::pair<A, B> >
     {
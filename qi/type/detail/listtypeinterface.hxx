@@ -27,6 +27,7 @@ public:
   AnyIterator begin(void* storage) override;
   AnyIterator end(void* storage) override;
   void pushBack(void** storage, void* valueStorage) override;
+  void reserve(void** storage, size_t count) override;
   _QI_BOUNCE_TYPE_METHODS(MethodsImpl);
   TypeInterface* _elementType;
 };
@@ -101,6 +102,17 @@ namespace detail
   {
     container.insert(*element);
   }
+  // Preallocate when the container has a reserve() (std::vector,
+  // std::unordered_map), no-op otherwise (std::list, std::set, std::map).
+  template<typename C>
+  auto reserve(C& container, size_t count, int) -> decltype(container.reserve(count), void())
+  {
+    container.reserve(count);
+  }
+  template<typename C>
+  void reserve(C&, size_t, long)
+  {
+  }
 }
 template<typename T, typename H>
 void ListTypeInterfaceImpl<T, H>::pushBack(void **storage, void* valueStorage)
@@ -109,6 +121,13 @@ void ListTypeInterfaceImpl<T, H>::pushBack(void **storage, void* valueStorage)
   detail::pushBack(*ptr, (typename T::value_type*)_elementType->ptrFromStorage(&valueStorage));
 }
 
+template<typename T, typename H>
+void ListTypeInterfaceImpl<T, H>::reserve(void** storage, size_t count)
+{
+  T* ptr = (T*) ptrFromStorage(storage);
+  detail::reserve(*ptr, count, 0);
+}
+
 template<typename T, typename H>
 size_t ListTypeInterfaceImpl<T, H>::size(void* storage)
 {
@@ -157,6 +176,10 @@ public:
     void* vstor = adaptStorage(storage);
     BaseClass::pushBack(&vstor, valueStorage);
   }
+  void reserve(void** storage, size_t count) override {
+    void* vstor = adaptStorage(storage);
+    BaseClass::reserve(&vstor, count);
+  }
 
   //ListTypeInterface* _list;
 };
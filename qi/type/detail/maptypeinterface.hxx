@@ -7,6 +7,8 @@
 #ifndef _QITYPE_DETAIL_TYPEMAP_HXX_
 #define _QITYPE_DETAIL_TYPEMAP_HXX_
 
+#include <ka/flatmap.hpp>
+
 namespace qi
 {
   // List container
@@ -22,6 +24,8 @@ public:
   AnyIterator begin(void* storage) override;
   AnyIterator end(void* storage) override;
   void insert(void** storage, void* keyStorage, void* valueStorage) override;
+  void insertAtEnd(void** storage, void* keyStorage, void* valueStorage) override;
+  void reserve(void** storage, size_t count) override;
   AnyReference element(void** storage, void* keyStorage, bool autoInsert) override;
   _QI_BOUNCE_TYPE_METHODS(MethodsImpl);
   TypeInterface* _keyType;
@@ -86,6 +90,28 @@ MapTypeInterfaceImpl<M>::insert(void** storage, void* keyStorage, void* valueSto
     it->second = val;
 }
 
+template<typename M> void
+MapTypeInterfaceImpl<M>::insertAtEnd(void** storage, void* keyStorage, void* valueStorage)
+{
+  M* ptr = (M*) ptrFromStorage(storage);
+  typename M::key_type& key = *(typename M::key_type*)_keyType->ptrFromStorage(&keyStorage);
+  typename M::mapped_type& val = *(typename M::mapped_type*)_elementType->ptrFromStorage(&valueStorage);
+  // The hinted insert skips the lookup when the key really sorts last; a
+  // wrong hint degrades to a plain insert. Inserting nothing means the key
+  // was already there: overwrite, like insert().
+  const size_t before = ptr->size();
+  typename M::iterator it = ptr->insert(ptr->end(), std::make_pair(key, val));
+  if (ptr->size() == before)
+    it->second = val;
+}
+
+template<typename M> void
+MapTypeInterfaceImpl<M>::reserve(void** storage, size_t count)
+{
+  M* ptr = (M*) ptrFromStorage(storage);
+  detail::reserve(*ptr, count, 0);
+}
+
 template<typename M> AnyReference
 MapTypeInterfaceImpl<M>::element(void** storage, void* keyStorage, bool autoInsert)
 {
@@ -109,5 +135,10 @@ MapTypeInterfaceImpl<M>::element(void** storage, void* keyStorage, bool autoInse
 template<typename K, typename V, typename C, typename A>
 struct TypeImpl<std::map<K,V, C, A> >: public MapTypeInterfaceImpl<std::map<K, V,C,A> > {};
 
+// ka::flat_map_t implements the container subset used above, so it plugs
+// into the generic map interface and shares std::map's wire signature.
+template<typename K, typename V, typename C>
+struct TypeImpl<ka::flat_map_t<K, V, C> >: public MapTypeInterfaceImpl<ka::flat_map_t<K, V, C> > {};
+
 }
 #endif  // _QITYPE_DETAIL_TYPEMAP_HXX_
@@ -87,6 +87,20 @@ namespace detail {
     {
       return go()->post(eventName, std::forward<Args>(args)...);
     }
+    /// One-way invocation by pre-resolved method or signal ID, skipping the
+    /// per-call name lookup (see GenericObject::post).
+    template <typename... Args>
+    inline void post(unsigned int methodOrSignalId, Args&&... args) const
+    {
+      return go()->post(methodOrSignalId, std::forward<Args>(args)...);
+    }
+    /// Start a call batch on this object: queued calls are flushed in a
+    /// single bundled round trip when the peer supports it (see
+    /// qi::ObjectBatch).
+    inline ObjectBatch batch() const
+    {
+      return ObjectBatch(go()->shared_from_this());
+    }
     template <typename FUNCTOR_TYPE>
     inline qi::FutureSync<SignalLink> connect(const std::string& eventName, FUNCTOR_TYPE callback,
       MetaCallType threadingModel = MetaCallType_Auto) const
@@ -125,6 +139,20 @@ namespace detail {
     {
       return go()->setProperty(id, val);
     }
+    /// Bulk property read, one round trip when the peer supports it.
+    /// See GenericObject::properties.
+    inline qi::FutureSync<std::vector<std::pair<std::string, AnyValue>>> properties(
+        const std::vector<std::string>& names) const
+    {
+      return go()->properties(names);
+    }
+    /// Bulk property write, one round trip when the peer supports it.
+    /// See GenericObject::setProperties.
+    inline qi::FutureSync<std::vector<std::string>> setProperties(
+        const std::vector<std::pair<std::string, AnyValue>>& values) const
+    {
+      return go()->setProperties(values);
+    }
     inline ExecutionContext* executionContext() const
     {
       return go()->executionContext().get();
@@ -7,7 +7,9 @@
 #ifndef _QITYPE_DETAIL_PROPERTY_HXX_
 #define _QITYPE_DETAIL_PROPERTY_HXX_
 
+#include <boost/make_shared.hpp>
 #include <boost/thread/locks.hpp>
+#include <qi/eventloop.hpp>
 #include <qi/future.hpp>
 #include <qi/property.hpp>
 
@@ -69,6 +71,65 @@ namespace qi
   {
   }
 
+  template<typename T>
+  PropertyImpl<T>::~PropertyImpl()
+  {
+    if (_coalesceState)
+    {
+      boost::mutex::scoped_lock lock(_coalesceState->mutex);
+      _coalesceState->alive = false;
+    }
+  }
+
+  template<typename T>
+  void PropertyImpl<T>::setNotifyCoalescing(qi::Duration maxDelay)
+  {
+    if (!_coalesceState)
+    {
+      _coalesceState = boost::make_shared<CoalesceState>();
+      _coalesceState->owner = this;
+    }
+    boost::mutex::scoped_lock lock(_coalesceState->mutex);
+    _coalesceState->maxDelay = maxDelay;
+  }
+
+  template<typename T>
+  void PropertyImpl<T>::notify(const T& v)
+  {
+    const auto state = _coalesceState;
+    if (!state)
+    {
+      (*this)(v);
+      return;
+    }
+    qi::Duration delay;
+    {
+      boost::mutex::scoped_lock lock(state->mutex);
+      delay = state->maxDelay;
+      if (delay != qi::Duration(0))
+      {
+        state->value = v;
+        if (state->pending) // the scheduled notification will pick this value up
+          return;
+        state->pending = true;
+      }
+    }
+    if (delay == qi::Duration(0))
+    {
+      (*this)(v);
+      return;
+    }
+    qi::getEventLoop()->asyncDelay([state] {
+      boost::mutex::scoped_lock lock(state->mutex);
+      state->pending = false;
+      if (!state->alive)
+        return;
+      // Holding the lock serializes with ~PropertyImpl: the owner cannot be
+      // destroyed while we notify.
+      (*state->owner)(state->value);
+    }, delay);
+  }
+
   template<typename T>
   T PropertyImpl<T>::getImpl() const
   {
@@ -81,17 +142,48 @@ namespace qi
   void PropertyImpl<T>::setImpl(const T& v)
   {
     qiLogDebug("qitype.property") << "set " << this << " " << (!!_setter);
+    // The lock only covers the write: by the time the next write can run,
+    // notify() has consumed its reference, so it can read _value lock-free
+    // alongside getNow() readers.
     if (_setter)
     {
-      const bool ok = _setter(boost::ref(_value), v);
+      bool ok;
+      {
+        boost::mutex::scoped_lock lock(_valueMutex);
+        ok = _setter(boost::ref(_value), v);
+      }
       if (ok)
-        (*this)(_value);
+        notify(_value);
     }
     else
     {
-      _value = v;
-      (*this)(_value);
+      {
+        boost::mutex::scoped_lock lock(_valueMutex);
+        _value = v;
+      }
+      notify(_value);
+    }
+  }
+
+  template<typename T>
+  T PropertyImpl<T>::getNow() const
+  {
+    boost::mutex::scoped_lock lock(_valueMutex);
+    return getImpl();
+  }
+
+  template<typename T>
+  template<typename F>
+  void PropertyImpl<T>::readNow(F f) const
+  {
+    boost::mutex::scoped_lock lock(_valueMutex);
+    if (_getter)
+    {
+      const T v = _getter(boost::ref(_value));
+      f(v);
     }
+    else
+      f(_value);
   }
 
 
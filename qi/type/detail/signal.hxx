@@ -7,9 +7,12 @@
 #ifndef _QITYPE_DETAIL_SIGNAL_HXX_
 #define _QITYPE_DETAIL_SIGNAL_HXX_
 
+#include <typeinfo>
+
 #include <qi/trackable.hpp>
 #include <qi/type/detail/manageable.hpp>
 #include <boost/bind.hpp>
+#include <boost/make_shared.hpp>
 #include <qi/type/detail/functionsignature.hxx>
 
 namespace qi
@@ -88,7 +91,12 @@ namespace qi
   template<typename F>
   SignalSubscriber SignalBase::connect(boost::function<F> fun)
   {
-    return connect(AnyFunction::from(std::move(fun)));
+    SignalSubscriber s(AnyFunction::from(fun), MetaCallType_Auto);
+    // Keep the typed functor around: emission skips AnyReference boxing when
+    // it matches the signal's own type (see _tryTriggerTyped).
+    s._setTypedHandler(boost::make_shared<boost::function<F>>(std::move(fun)),
+                       typeid(boost::function<F>));
+    return connect(s);
   }
   // TODO: taking by forward ref is too greedy and connect(SignalSubscriber) takes this overload
   // find a way to fix this
@@ -96,7 +104,18 @@ namespace qi
   template<typename F>
   SignalSubscriber SignalF<T>::connect(F c)
   {
-    SignalSubscriber sub = connect(qi::AnyFunction::from(boost::function<T>(std::move(c))));
+    boost::function<T> typed(std::move(c));
+    auto func = qi::AnyFunction::from(typed);
+    auto execContext = executionContext();
+    SignalSubscriber s = execContext ?
+      SignalSubscriber(std::move(func), execContext) :
+      SignalSubscriber(std::move(func), MetaCallType_Auto);
+    // The callback has the signal's exact type: keep the typed functor so
+    // that emission can invoke it without AnyReference boxing when the
+    // subscriber runs synchronously (see SignalBase::_tryTriggerTyped).
+    s._setTypedHandler(boost::make_shared<boost::function<T>>(std::move(typed)),
+                       typeid(boost::function<T>));
+    SignalSubscriber sub = SignalBase::connect(s);
     if (detail::IsAsyncBind<F>::value)
       sub.setCallType(MetaCallType_Direct);
     return sub;
@@ -133,6 +152,11 @@ namespace qi
   public:                      \
     BounceToSignalBase(SignalBase& signalBase) : signalBase(signalBase) {} \
     R operator()(argsdecl) {   \
+      /* Typed fast path: invoke exact-type synchronous subscribers */ \
+      /* directly, boxing the arguments only when someone needs it.  */ \
+      if (signalBase._tryTriggerTyped(typeid(boost::function<R(argstype)>), \
+            [&](void* f) { (*static_cast<boost::function<R(argstype)>*>(f))(argsues); })) \
+        return;                \
       AnyReferenceVector args; \
       BOOST_PP_REPEAT(n, pushArg, _);    \
       signalBase.trigger(args);          \
@@ -0,0 +1,195 @@
+#pragma once
+/*
+**  Copyright (C) 2013 Aldebaran Robotics
+**  See COPYING for the license
+*/
+
+#ifndef _QITYPE_DETAIL_STATICSIGNATURE_HPP_
+#define _QITYPE_DETAIL_STATICSIGNATURE_HPP_
+
+#include <list>
+#include <map>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <boost/optional.hpp>
+
+/* Compile-time signature strings.
+ *
+ * For a fixed C++ type the qi signature is known at compile time; there is
+ * no reason to go through the locked type registry and build it on first
+ * use. The machinery below assembles the signature as a template character
+ * pack, so staticSignature<T>() is a pointer to static data: no lock, no
+ * lazy initialization, no allocation.
+ *
+ * Types not covered here (registered structs, objects...) keep the runtime
+ * path; HasStaticSignature<T> tells the two apart.
+ */
+
+namespace qi {
+
+  class AnyValue;
+
+  namespace detail {
+
+    template <char... Chars>
+    struct SigChars
+    {
+      static const char value[sizeof...(Chars) + 1];
+    };
+
+    template <char... Chars>
+    const char SigChars<Chars...>::value[sizeof...(Chars) + 1] = { Chars..., '\0' };
+
+    template <typename... Parts>
+    struct SigConcat;
+
+    template <char... A>
+    struct SigConcat<SigChars<A...>>
+    {
+      using type = SigChars<A...>;
+    };
+
+    template <char... A, char... B, typename... Rest>
+    struct SigConcat<SigChars<A...>, SigChars<B...>, Rest...>
+      : SigConcat<SigChars<A..., B...>, Rest...>
+    {
+    };
+
+    /// Signature character of an integer of the given size and signedness
+    /// (see qi::Signature::Type).
+    template <size_t Size, bool Signed>
+    struct IntSigChar;
+    template <> struct IntSigChar<1, true>  { static const char value = 'c'; };
+    template <> struct IntSigChar<1, false> { static const char value = 'C'; };
+    template <> struct IntSigChar<2, true>  { static const char value = 'w'; };
+    template <> struct IntSigChar<2, false> { static const char value = 'W'; };
+    template <> struct IntSigChar<4, true>  { static const char value = 'i'; };
+    template <> struct IntSigChar<4, false> { static const char value = 'I'; };
+    template <> struct IntSigChar<8, true>  { static const char value = 'l'; };
+    template <> struct IntSigChar<8, false> { static const char value = 'L'; };
+
+    template <typename T, typename Enable = void>
+    struct StaticSignature
+    {
+      static const bool isValid = false;
+    };
+
+    template <>
+    struct StaticSignature<void>
+    {
+      static const bool isValid = true;
+      using Chars = SigChars<'v'>;
+    };
+
+    template <>
+    struct StaticSignature<bool>
+    {
+      static const bool isValid = true;
+      using Chars = SigChars<'b'>;
+    };
+
+    template <typename T>
+    struct StaticSignature<T, typename std::enable_if<
+        std::is_integral<T>::value && !std::is_same<T, bool>::value>::type>
+    {
+      static const bool isValid = true;
+      using Chars = SigChars<IntSigChar<sizeof(T), std::is_signed<T>::value>::value>;
+    };
+
+    template <>
+    struct StaticSignature<float>
+    {
+      static const bool isValid = true;
+      using Chars = SigChars<'f'>;
+    };
+
+    template <>
+    struct StaticSignature<double>
+    {
+      static const bool isValid = true;
+      using Chars = SigChars<'d'>;
+    };
+
+    template <>
+    struct StaticSignature<std::string>
+    {
+      static const bool isValid = true;
+      using Chars = SigChars<'s'>;
+    };
+
+    template <>
+    struct StaticSignature<AnyValue>
+    {
+      static const bool isValid = true;
+      using Chars = SigChars<'m'>;
+    };
+
+    template <typename T>
+    struct StaticSignature<std::vector<T>, typename std::enable_if<
+        StaticSignature<T>::isValid>::type>
+    {
+      static const bool isValid = true;
+      using Chars = typename SigConcat<SigChars<'['>,
+          typename StaticSignature<T>::Chars, SigChars<']'>>::type;
+    };
+
+    template <typename T>
+    struct StaticSignature<std::list<T>, typename std::enable_if<
+        StaticSignature<T>::isValid>::type>
+    {
+      static const bool isValid = true;
+      using Chars = typename SigConcat<SigChars<'['>,
+          typename StaticSignature<T>::Chars, SigChars<']'>>::type;
+    };
+
+    template <typename K, typename V>
+    struct StaticSignature<std::map<K, V>, typename std::enable_if<
+        StaticSignature<K>::isValid && StaticSignature<V>::isValid>::type>
+    {
+      static const bool isValid = true;
+      using Chars = typename SigConcat<SigChars<'{'>,
+          typename StaticSignature<K>::Chars,
+          typename StaticSignature<V>::Chars, SigChars<'}'>>::type;
+    };
+
+    template <typename A, typename B>
+    struct StaticSignature<std::pair<A, B>, typename std::enable_if<
+        StaticSignature<A>::isValid && StaticSignature<B>::isValid>::type>
+    {
+      static const bool isValid = true;
+      using Chars = typename SigConcat<SigChars<'('>,
+          typename StaticSignature<A>::Chars,
+          typename StaticSignature<B>::Chars, SigChars<')'>>::type;
+    };
+
+    template <typename T>
+    struct StaticSignature<boost::optional<T>, typename std::enable_if<
+        StaticSignature<T>::isValid>::type>
+    {
+      static const bool isValid = true;
+      using Chars = typename SigConcat<SigChars<'+'>,
+          typename StaticSignature<T>::Chars>::type;
+    };
+
+    template <typename T>
+    struct HasStaticSignature
+      : std::integral_constant<bool, StaticSignature<T>::isValid>
+    {
+    };
+
+    /// Signature string of T, assembled at compile time. The returned
+    /// pointer refers to static storage and is the same on every call.
+    template <typename T>
+    inline const char* staticSignature()
+    {
+      static_assert(StaticSignature<T>::isValid,
+                    "no compile-time signature for this type");
+      return StaticSignature<T>::Chars::value;
+    }
+
+  }
+}
+
+#endif  // _QITYPE_DETAIL_STATICSIGNATURE_HPP_
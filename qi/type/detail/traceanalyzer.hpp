@@ -8,7 +8,9 @@
 #define _QITYPE_TRACEANALYZER_HPP_
 
 #include <boost/utility.hpp>
+#include <map>
 #include <memory>
+#include <utility>
 #include <qi/type/detail/manageable.hpp>
 
 
@@ -27,6 +29,31 @@ namespace qi
     void clear(const qi::os::timeval& limit);
     /// Add a new trace to the system. There is no order requirement between traces.
     void addTrace(const qi::EventTrace& e, unsigned int objectId);
+
+    /// @{ Streaming mode.
+    ///
+    /// addTrace() already ingests traces one by one; these make the
+    /// analyzer usable on an unbounded live stream: a rolling window
+    /// bounds the retained call graph, and per-method latency aggregates
+    /// are maintained as calls complete so they can be polled at any time
+    /// instead of re-analyzing a dump afterwards.
+
+    /// Keep only the calls started within `windowUs` microseconds of the
+    /// most recent trace seen (0, the default, retains everything).
+    /// Eviction happens during addTrace(), so memory stays bounded while
+    /// streaming. Evicting can break async links, like clear(limit).
+    void setRollingWindow(qi::int64_t windowUs);
+
+    /// (object id, method or signal id).
+    using MethodKey = std::pair<unsigned int, unsigned int>;
+    /// Times are in seconds, like Manageable's statistics. Errors count
+    /// like results: the call did complete.
+    using MethodStatisticsMap = std::map<MethodKey, MethodStatistics>;
+    /// Aggregates of the calls completed since the last
+    /// clearMethodStatistics(), unaffected by the rolling window.
+    MethodStatisticsMap methodStatistics() const;
+    void clearMethodStatistics();
+    /// @}
     struct FlowLink
     {
       FlowLink(unsigned int srcObj, unsigned int srcFun, unsigned int dstObj, unsigned int dstFun, bool sync)
@@ -0,0 +1,100 @@
+#pragma once
+/*
+**  Copyright (C) 2018 Aldebaran Robotics
+**  See COPYING for the license
+*/
+
+#ifndef _QITYPE_TRACERING_HPP_
+#define _QITYPE_TRACERING_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include <qi/api.hpp>
+#include <qi/types.hpp>
+#include <qi/type/detail/manageable.hpp>
+
+namespace qi
+{
+  /// One binary trace record. Unlike EventTrace this is a fixed-size POD:
+  /// no arguments and no AnyValue, so that writing one is a plain copy.
+  struct TraceRecord
+  {
+    qi::uint32_t id = 0;          ///< trace id, matches a call with its result
+    qi::uint8_t kind = 0;         ///< an EventTrace::EventKind
+    qi::uint32_t slotId = 0;      ///< method or signal id
+    qi::uint32_t callerContext = 0;
+    qi::uint32_t calleeContext = 0;
+    /// From qi::SteadyClock, in microseconds since its epoch. Note this is
+    /// a steady timebase, not the system clock EventTrace uses.
+    qi::int64_t timestampUs = 0;
+    qi::int64_t userUsTime = 0;   ///< 0 when cpu accounting was off
+    qi::int64_t systemUsTime = 0;
+  };
+
+  /// Process-wide, fixed-size, lock-free trace ring.
+  ///
+  /// Always-on alternative to the per-object `traceObject` signal: that
+  /// signal serializes arguments and goes through signal dispatch for every
+  /// event, which is far too heavy to leave enabled, whereas pushing a
+  /// record here costs one atomic increment and the copy of a few dozen
+  /// bytes, and never blocks - when the ring is full the oldest records are
+  /// overwritten.
+  ///
+  /// Subscribers drain lazily with snapshot(): each slot carries a sequence
+  /// number checked before and after the copy, so a record overwritten
+  /// mid-read is detected and skipped rather than returned torn.
+  ///
+  /// Sized by QI_TRACE_RING_SIZE (in records, rounded up to a power of two,
+  /// default 16384); QI_TRACE_RING=0 starts the process with writing
+  /// disabled.
+  class QI_API TraceRing
+  {
+  public:
+    static TraceRing& instance();
+
+    bool enabled() const { return _enabled.load(std::memory_order_relaxed); }
+    void setEnabled(bool enabled) { _enabled.store(enabled, std::memory_order_relaxed); }
+    size_t capacity() const { return _capacity; }
+
+    /// Lock-free: safe from any thread, including inside the call being
+    /// traced. The caller is expected to have checked enabled().
+    void push(const TraceRecord& record);
+
+    /// Copy of the retained records, oldest first. Slots being overwritten
+    /// while copied are skipped.
+    std::vector<TraceRecord> snapshot() const;
+
+    /// Records pushed since process start, overwritten ones included.
+    qi::uint64_t pushed() const { return _next.load(std::memory_order_relaxed); }
+
+    /// Next trace id, for matching a call record with its result record.
+    qi::uint32_t nextId() { return _nextId.fetch_add(1, std::memory_order_relaxed) + 1; }
+
+  private:
+    TraceRing();
+
+    struct Slot
+    {
+      /// Seqlock: 0 never written, 2*ticket+1 while the write is in flight,
+      /// 2*ticket+2 once ticket's record is published.
+      std::atomic<qi::uint64_t> seq{0};
+      TraceRecord record;
+    };
+
+    std::atomic<bool> _enabled;
+    const size_t _capacity; // power of two
+    const std::unique_ptr<Slot[]> _slots;
+    std::atomic<qi::uint64_t> _next{0};
+    std::atomic<qi::uint32_t> _nextId{0};
+  };
+
+  /// The record as an EventTrace with empty arguments, to reuse the
+  /// existing consumers (e.g. TraceAnalyzer). The timestamp keeps the
+  /// record's steady timebase.
+  QI_API EventTrace toEventTrace(const TraceRecord& record);
+}
+
+#endif  // _QITYPE_TRACERING_HPP_
@@ -19,6 +19,47 @@ namespace qi
     /// Report a type operation failure
     void QI_API typeFail(const char* typeName, const char* operation);
 
+    /// Storage slots for values no bigger than this are served by a
+    /// per-thread recycling pool instead of the general allocator.
+    const size_t smallStorageSize = sizeof(unsigned long long);
+
+    /// Get a pointer-sized storage slot from the calling thread's pool, or
+    /// from the allocator if the pool is empty.
+    QI_API void* allocSmallStorage();
+    /// Return a slot obtained from allocSmallStorage to the calling thread's
+    /// pool. Slots are individually allocated, so they may be released by a
+    /// different thread than the one that obtained them.
+    QI_API void freeSmallStorage(void* storage);
+
+    /// Serves allocSmallStorage from a bump arena for the scope's duration
+    /// on the calling thread. Meant to wrap a message dispatch: argument
+    /// deserialization and conversion temporaries then cost a pointer bump
+    /// each, and the chunks are released wholesale when the scope closes.
+    /// Slots are still safe to free from anywhere at any time: each one
+    /// keeps its chunk alive until released, so values that escape the
+    /// scope (e.g. arguments copied for a queued call) merely delay the
+    /// chunk recycling. Scopes may nest.
+    class QI_API ScopedStorageArena
+    {
+    public:
+      ScopedStorageArena();
+      ~ScopedStorageArena();
+      ScopedStorageArena(const ScopedStorageArena&) = delete;
+      ScopedStorageArena& operator=(const ScopedStorageArena&) = delete;
+    private:
+      void* _arena;
+      void* _previous; // arena active before this scope, restored on exit
+    };
+
+    /// True if values of T are scalar-like and small enough for pooled
+    /// storage. The extra level of indirection keeps sizeof(T) from being
+    /// evaluated on function or incomplete types.
+    template<typename T, bool isPod = boost::is_pod<T>::value>
+    struct IsSmallPOD: boost::false_type {};
+    template<typename T>
+    struct IsSmallPOD<T, true>
+      : boost::integral_constant<bool, (sizeof(T) <= smallStorageSize)> {};
+
     /* Handle creation (create, createInPlace), copy (copy, clone, cloneInPlace), and
     *  destruction(destroy) of a given type.
     *  There is currently no portable way to detect if a given class has
@@ -105,6 +146,23 @@ namespace qi
     {};
 
 
+    /* Small scalar-like types draw their storage from a per-thread pool:
+     * nearly every RPC argument is such a value, and serving them from the
+     * general allocator is pure allocator pressure. Storage stays by-pointer
+     * so the reference semantics of AnyReference (in-place modification)
+     * are preserved, contrary to what by-value storage would do.
+     */
+    template<typename T>
+    struct TypeManagerSmallPOD
+    {
+      static void* create() { void* p = allocSmallStorage(); new(p)T(); return p; }
+      static void createInPlace(void* ptr) { new(ptr)T(); }
+      static void copy(void* dst, const void* src) { *(T*)dst = *(const T*)src; }
+      static void* clone(void* src) { void* p = allocSmallStorage(); new(p)T(*(T*)src); return p; }
+      static void cloneInPlace(void* ptr, void* src) { new(ptr)T(*(T*)src); }
+      static void destroy(void* ptr) { freeSmallStorage(ptr); }
+    };
+
     // TypeManager is accessed by this interface.
     // Only things for which we are sure are marked constructible and clonable
     template<typename T>
@@ -113,7 +171,9 @@ namespace qi
         boost::is_function<T>::value,
           TypeManagerNull<T>,
           typename boost::mpl::if_c< boost::is_pod<T>::value,
-                 TypeManagerDefaultStruct<T>,
+                 typename boost::mpl::if_c< IsSmallPOD<T>::value,
+                        TypeManagerSmallPOD<T>,
+                        TypeManagerDefaultStruct<T> >::type,
                  TypeManagerDefaultInterface<T> >
           ::type>::type {};
 
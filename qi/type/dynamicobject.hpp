@@ -73,6 +73,10 @@ namespace qi
     boost::shared_ptr<DynamicObjectPrivate> _p;
   };
 
+  /// Return the DynamicObject behind an AnyObject of DynamicObject kind,
+  /// or null if the object is empty or of another kind.
+  QI_API DynamicObject* dynamicObjectOf(const AnyObject& obj);
+
   /// Make an AnyObject of DynamicObject kind from a DynamicObject
   QI_API AnyObject     makeDynamicAnyObject(DynamicObject *obj,
     bool destroyObject = true,
@@ -24,6 +24,10 @@ namespace qi {
     ~DynamicObjectBuilder();
 
     // throw on error
+    /// `threadingModel` selects the dispatch of calls to the method; in
+    /// particular MetaCallType_Concurrent tags it as parallel-safe, running
+    /// it on the thread pool outside the ordering of a single-threaded
+    /// object (see the MetaCallType documentation).
     template <typename OBJECT_TYPE, typename METHOD_TYPE>
     inline unsigned int advertiseMethod(const std::string& name,
                                         OBJECT_TYPE object,
@@ -77,6 +81,11 @@ namespace qi {
 
     void setThreadingModel(ObjectThreadingModel model);
 
+    /// Preallocates the object's member lookup tables for the given expected
+    /// counts, so advertising many members does not repeatedly rehash them.
+    /// Optional hint: the tables still grow past the counts.
+    void reserve(std::size_t methodCount, std::size_t signalCount = 0, std::size_t propertyCount = 0);
+
     unsigned int xAdvertiseMethod(const Signature &sigret,
                                   const std::string &name,
                                   const Signature &signature,
@@ -10,6 +10,8 @@
 #include <qi/type/metamethod.hpp>
 #include <qi/type/metasignal.hpp>
 #include <qi/type/metaproperty.hpp>
+#include <ka/flatmap.hpp>
+#include <ka/sha1.hpp>
 
 #ifdef _MSC_VER
 #  pragma warning( push )
@@ -64,6 +66,15 @@ namespace qi {
     */
     PropertyMap propertyMap() const;
 
+    // The internal storage of the member tables: built once when the
+    // interface is assembled, then read on every dispatch, so they live in
+    // sorted contiguous memory rather than one heap node per member. The
+    // std::map typedefs above are kept for the introspection accessors,
+    // which return copies anyway.
+    using MethodFlatMap = ka::flat_map_t<unsigned int, MetaMethod>;
+    using SignalFlatMap = ka::flat_map_t<unsigned int, MetaSignal>;
+    using PropertyFlatMap = ka::flat_map_t<unsigned int, MetaProperty>;
+
     /**
     *   @param id The method's id.
     *   @return The desired method or null if the id is invalid.
@@ -138,9 +149,29 @@ namespace qi {
     */
     std::string description() const;
 
+    /** Hash of the interface content (methods, signals, properties and
+    *   description): two MetaObjects with the same hash describe the same
+    *   interface. Used to deduplicate MetaObject transmissions, so that one
+    *   shape shared by many objects crosses a connection only once.
+    */
+    ka::sha1_digest_t contentHash() const;
+
+    /** Return a copy of the process-wide pooled instance matching this
+    *   metaobject's content hash, registering it on first sight. Copies of
+    *   the pooled instance share the per-member payloads (method names,
+    *   signatures, documentation), so the many identically-shaped objects a
+    *   program may create stop duplicating those strings. Pooled entries
+    *   are kept for the lifetime of the process.
+    */
+    static qi::MetaObject intern(const qi::MetaObject &mo);
+
     MetaObjectPrivate   *_p;
     MetaObject(const MethodMap& methodMap, const SignalMap& signalMap,
       const PropertyMap& propertyMap, const std::string& description);
+    // Overload used by the type-system registration, which reconstructs a
+    // MetaObject from its serialized fields in internal storage form.
+    MetaObject(const MethodFlatMap& methodMap, const SignalFlatMap& signalMap,
+      const PropertyFlatMap& propertyMap, const std::string& description);
   };
 
   bool QI_API operator < (const MetaObject& a, const MetaObject& b);
@@ -164,6 +195,11 @@ namespace qi {
 
     void setDescription(const std::string& desc);
 
+    /// Preallocates the member lookup tables for the given expected counts.
+    /// Optional hint: avoids repeated rehashing when a large interface is
+    /// built member by member. The tables still grow past the counts.
+    void reserve(std::size_t methodCount, std::size_t signalCount, std::size_t propertyCount);
+
     MemberAddInfo addMethod(const qi::Signature &sigret,
                            const std::string &name,
                            const qi::Signature &signature,
@@ -50,6 +50,12 @@ namespace detail {
     /// Declare the class type for which this StaticBuilder is.
     template<typename T> void  buildFor(bool autoRegister = true);
 
+    /// `threadingModel` selects how calls to the method are dispatched:
+    /// MetaCallType_Auto follows the object's threading model (a
+    /// single-threaded object runs its methods one at a time on its strand),
+    /// MetaCallType_Concurrent tags the method as parallel-safe and runs it
+    /// on the thread pool outside that ordering, and MetaCallType_Direct
+    /// forces a synchronous call.
     template <typename FUNCTION_TYPE>
     inline unsigned int advertiseMethod(const std::string& name, FUNCTION_TYPE function, MetaCallType threadingModel = MetaCallType_Auto, int id = -1);
 
@@ -0,0 +1,116 @@
+#pragma once
+/*
+**  Copyright (C) 2013 Aldebaran Robotics
+**  See COPYING for the license
+*/
+
+#ifndef _QI_TYPE_PROXYMETHOD_HPP_
+#define _QI_TYPE_PROXYMETHOD_HPP_
+
+#include <string>
+#include <vector>
+
+#include <qi/anyobject.hpp>
+#include <qi/future.hpp>
+#include <qi/type/detail/functionsignature.hxx>
+
+namespace qi
+{
+
+  template<typename Sig>
+  class ProxyMethod;
+
+  /// Method proxy, using an AnyObject and a method id as backend.
+  ///
+  /// The method is resolved once from the compile-time signature when the
+  /// proxy is set up; calls then go straight to the method id with the
+  /// precomputed return signature, skipping the per-call name lookup,
+  /// overload resolution and signature computation of AnyObject::call.
+  /// If no method matches the signature exactly (e.g. the remote method
+  /// expects convertible argument types), calls fall back to the usual
+  /// resolution by name.
+  ///
+  /// Typical use, in a hand-written or generated proxy class:
+  /// \code
+  /// struct MyServiceProxy
+  /// {
+  ///   MyServiceProxy(AnyObject obj)
+  ///     : doSomething(obj, "doSomething")
+  ///   {}
+  ///   ProxyMethod<int(std::string, int)> doSomething;
+  /// };
+  /// \endcode
+  template<typename R, typename... Args>
+  class ProxyMethod<R(Args...)>
+  {
+  public:
+    ProxyMethod()
+      : _methodId(-1)
+    {}
+
+    ProxyMethod(AnyObject object, const std::string& methodName)
+      : _methodId(-1)
+    {
+      setup(object, methodName);
+    }
+
+    void setup(AnyObject object, const std::string& methodName)
+    {
+      _object = object;
+      _methodName = methodName;
+      _returnSignature = typeOf<R>()->signature();
+      _methodId = object.metaObject().methodId(
+          methodName + "::" + detail::functionArgumentsSignature<R(Args...)>().toString());
+    }
+
+    /// Calls the method synchronously, like AnyObject::call.
+    R operator()(const Args&... args)
+    {
+      std::vector<AnyReference> params = {AnyReference::from(args)...};
+      qi::Future<AnyReference> fmeta = _methodId >= 0
+        ? backend()->metaCall(static_cast<unsigned int>(_methodId), params,
+                              MetaCallType_Direct, _returnSignature)
+        : backend()->metaCall(_methodName, params,
+                              MetaCallType_Direct, _returnSignature);
+      return detail::extractFuture<R>(fmeta);
+    }
+
+    /// Calls the method asynchronously, like AnyObject::async.
+    qi::Future<R> async(const Args&... args)
+    {
+      std::vector<AnyReference> params = {AnyReference::from(args)...};
+      qi::Future<AnyReference> fmeta = _methodId >= 0
+        ? backend()->metaCall(static_cast<unsigned int>(_methodId), params,
+                              MetaCallType_Queued, _returnSignature)
+        : backend()->metaCall(_methodName, params,
+                              MetaCallType_Queued, _returnSignature);
+      qi::Promise<R> result;
+      qi::adaptFutureUnwrap(fmeta, result);
+      return result.future();
+    }
+
+    /// Whether the method was resolved at setup; when false, calls resolve
+    /// the method by name like AnyObject::call does.
+    bool isResolved() const
+    {
+      return _methodId >= 0;
+    }
+
+  private:
+    GenericObject* backend()
+    {
+      GenericObject* go = _object.asGenericObject();
+      if (!go)
+        throw std::runtime_error("Invalid object in ProxyMethod " + _methodName);
+      return go;
+    }
+
+    AnyObject _object;
+    std::string _methodName;
+    int _methodId;
+    Signature _returnSignature;
+  };
+
+}
+
+#endif  // _QI_TYPE_PROXYMETHOD_HPP_
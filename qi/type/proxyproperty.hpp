@@ -7,6 +7,9 @@
 #ifndef _QI_TYPE_PROXYPROPERTY_HPP_
 #define _QI_TYPE_PROXYPROPERTY_HPP_
 
+#include <boost/thread/mutex.hpp>
+
+#include <qi/clock.hpp>
 #include <qi/log.hpp>
 #include <qi/property.hpp>
 #include <qi/anyfunction.hpp>
@@ -39,9 +42,32 @@ namespace qi
     Future<void> onSubscribe(bool enable, GenericObject* object, const std::string& propertyName, SignalLink link);
     AnyReference bounceEvent(const AnyReferenceVector args);
     void triggerOverride(const GenericFunctionParameters& params, MetaCallType, GenericObject* object, const std::string& propertyName);
+
+    /** Serves reads from a local mirror of the remote value.
+     *
+     * The proxy subscribes to the property's change events and keeps the
+     * last value received, so value() answers locally instead of making a
+     * network round trip on every read. A read finding no mirrored value
+     * yet, or one older than maxStaleness, fetches from the backend and
+     * reseeds the mirror. Writes through this proxy update the mirror once
+     * the backend has accepted them.
+     */
+    void enableCache(qi::Duration maxStaleness = qi::Duration::max());
+    /// Drops the mirror and reverts value() to fetching from the backend.
+    void disableCache();
   private:
     T getter(GenericObject* object, const std::string& propertyName);
     bool setter(T&, const T&, GenericObject* object, const std::string& propertyName);
+    void onCacheUpdate(const T& value);
+    void storeCache(const T& value);
+
+    boost::mutex _cacheMutex;
+    bool _cacheEnabled = false;
+    bool _cacheValid = false;
+    T _cachedValue;
+    qi::SteadyClockTimePoint _cacheTime;
+    qi::Duration _cacheMaxStaleness = qi::Duration::max();
+    SignalLink _cacheLink = SignalBase::invalidSignalLink;
   };
 
   template<typename T, template< class...> class PropertyType>
@@ -116,15 +142,69 @@ namespace qi
     object->metaPost(propertyName, params);
   }
   template<typename T, template< class...> class PropertyType>
+  void ProxyProperty<T, PropertyType>::enableCache(qi::Duration maxStaleness)
+  {
+    {
+      boost::mutex::scoped_lock lock(_cacheMutex);
+      _cacheMaxStaleness = maxStaleness;
+      if (_cacheEnabled)
+        return;
+      _cacheEnabled = true;
+      _cacheValid = false;
+    }
+    // Subscribing to ourselves subscribes to the backend's change events,
+    // which keep the mirror fresh from then on.
+    _cacheLink = SignalType::connect(boost::bind(&ThisProxyType::onCacheUpdate, this, _1));
+  }
+  template<typename T, template< class...> class PropertyType>
+  void ProxyProperty<T, PropertyType>::disableCache()
+  {
+    SignalLink link = SignalBase::invalidSignalLink;
+    {
+      boost::mutex::scoped_lock lock(_cacheMutex);
+      if (!_cacheEnabled)
+        return;
+      _cacheEnabled = false;
+      _cacheValid = false;
+      std::swap(link, _cacheLink);
+    }
+    if (link != SignalBase::invalidSignalLink)
+      SignalType::disconnect(link);
+  }
+  template<typename T, template< class...> class PropertyType>
+  void ProxyProperty<T, PropertyType>::onCacheUpdate(const T& value)
+  {
+    storeCache(value);
+  }
+  template<typename T, template< class...> class PropertyType>
+  void ProxyProperty<T, PropertyType>::storeCache(const T& value)
+  {
+    boost::mutex::scoped_lock lock(_cacheMutex);
+    if (!_cacheEnabled)
+      return;
+    _cachedValue = value;
+    _cacheTime = qi::SteadyClock::now();
+    _cacheValid = true;
+  }
+  template<typename T, template< class...> class PropertyType>
   T ProxyProperty<T, PropertyType>::getter(GenericObject* object, const std::string& propertyName)
   {
-    return object->property<T>(propertyName);
+    {
+      boost::mutex::scoped_lock lock(_cacheMutex);
+      if (_cacheEnabled && _cacheValid &&
+          qi::SteadyClock::now() - _cacheTime <= _cacheMaxStaleness)
+        return _cachedValue;
+    }
+    T value = object->property<T>(propertyName);
+    storeCache(value);
+    return value;
   }
   template<typename T, template< class...> class PropertyType>
   bool ProxyProperty<T, PropertyType>::setter(T& target, const T& v, GenericObject* object, const std::string& propertyName)
   {
     // no need to fill target it's never used since we have a getter
     object->setProperty(propertyName, v).value(); // throw on remote error
+    storeCache(v); // keep read-your-writes even if the change event lags
     // Prevent local subscribers from being called
     return false;
   }
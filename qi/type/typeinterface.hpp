@@ -7,6 +7,7 @@
 #ifndef _QI_TYPE_TYPEINTERFACE_HPP_
 #define _QI_TYPE_TYPEINTERFACE_HPP_
 
+#include <atomic>
 #include <typeinfo>
 #include <string>
 
@@ -199,6 +200,12 @@ namespace qi{
     virtual AnyIterator end(void* storage) = 0;
     /// Append an element to the end of the list
     virtual void pushBack(void** storage, void* valueStorage) = 0;
+    /**
+     * Preallocate room for count elements when the underlying container
+     * supports it (std::vector), do nothing otherwise. Only a hint: the
+     * container still grows on demand past it.
+     */
+    virtual void reserve(void** storage, size_t count);
     /// Get the element at index
     virtual void* element(void* storage, int index);
     TypeKind kind() override { return TypeKind_List;}
@@ -226,6 +233,16 @@ namespace qi{
     virtual AnyIterator end(void* storage) = 0;
     /// Set a key to a value and creates it if it does not exist
     virtual void insert(void** storage, void* keyStorage, void* valueStorage) = 0;
+    /**
+     * Same as insert(), but hints the container that the key sorts after
+     * every key already present, making ordered bulk fills amortized
+     * constant time per entry. The hint is only an optimization: a wrong
+     * hint still inserts (or overwrites) at the right place.
+     */
+    virtual void insertAtEnd(void** storage, void* keyStorage, void* valueStorage);
+    /// Preallocate room for count entries when the underlying container
+    /// supports it (hash maps), do nothing otherwise.
+    virtual void reserve(void** storage, size_t count);
     /**
      * Get the value corresponding to the requested key
      *
@@ -260,6 +277,42 @@ namespace qi{
     /// Set the fields of the struct at index (copies the value given)
     virtual void set(void** storage, unsigned int index, void* valStorage) = 0;
     TypeKind kind() override { return TypeKind_Tuple; }
+
+    /** Precomputed serialization program for flat structs.
+     *
+     * A struct is flat when every member is a scalar, a std::string or
+     * itself a flat struct, stored in place: its wire image is then fully
+     * determined by the member addresses, since the binary codec writes
+     * scalars as host bytes, strings as a size followed by the bytes, and
+     * tuples add no framing. The program lists each leaf member's byte
+     * offset inside the storage together with how to emit it; when the
+     * members are all scalars and leave no hole, contiguousSize is the
+     * span of a single bulk copy covering them all, otherwise it is 0 and
+     * the fields are emitted one by one.
+     */
+    struct FlatLayout
+    {
+      enum FieldKind
+      {
+        Field_Scalar, ///< raw bytes at offset, size bytes
+        Field_String  ///< std::string stored in place at offset
+      };
+      struct Field
+      {
+        size_t offset;
+        size_t size;
+        FieldKind kind;
+      };
+      std::vector<Field> fields;
+      size_t contiguousSize;
+      bool   flat;
+    };
+    /** @return the layout program of this struct, computed on first call,
+     * or null if a member is not flat-serializable.
+     */
+    const FlatLayout* flatLayout();
+    ~StructTypeInterface();
+
     /// Get the names of the fields of the struct
     virtual std::vector<std::string> elementsName() { return std::vector<std::string>();}
     /// Get the type name of the struct
@@ -300,6 +353,9 @@ namespace qi{
     }
 
     /// @}
+
+  private:
+    std::atomic<FlatLayout*> _flatLayout{nullptr};
   };
 
   /**
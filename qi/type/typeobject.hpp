@@ -28,6 +28,15 @@ namespace qi {
     MetaCallType_Direct = 1,
     /// Force an asynchronous call in an other thread
     MetaCallType_Queued = 2,
+    /** At method-registration site, tags the method as parallel-safe: it is
+     *  dispatched straight to the thread pool, outside the serializing
+     *  execution context (strand) of a single-threaded object, so any number
+     *  of calls to it may run concurrently with each other and with the
+     *  object's ordered methods. Use it for stateless queries on otherwise
+     *  single-threaded services. Same dispatch as MetaCallType_Queued, under
+     *  the name that states the actual contract.
+     */
+    MetaCallType_Concurrent = MetaCallType_Queued,
   };
   class SignalSubscriber;
   class Manageable;
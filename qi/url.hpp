@@ -7,6 +7,9 @@
 #ifndef _QI_MESSAGING_URL_HPP_
 #define _QI_MESSAGING_URL_HPP_
 
+#include <cstddef>
+#include <map>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -30,7 +33,10 @@ namespace qi {
    *    <li>- *empty string*</li>
    *  </ul>
    *
-   *  @note This class is copyable.
+   *  @note This class is copyable. Copies share the parsed representation:
+   *  a url is parsed once at construction and copying it is a cheap handle
+   *  copy, with no allocation and no re-parsing. The setters detach the
+   *  handle, so a copy is never affected by a mutation of the original.
    */
   class QI_API Url
   {
@@ -138,8 +144,29 @@ namespace qi {
     /// Sets the port. You can use 0.
     void setPort(unsigned short port);
 
+    /**
+     *  @return The query parameters of the url, parsed from the part after
+     *  '?' as '&'-separated key=value pairs (e.g.
+     *  "tcp://host:port?tcp-nodelay=0&recv-buffer-size=262144"). No percent
+     *  decoding is performed. The query does not take part in validity.
+     */
+    const std::map<std::string, std::string>& queryParameters() const;
+
+    /// @return True if the given query parameter is present.
+    bool hasQueryParameter(const std::string& key) const;
+
+    /// @return The value of the given query parameter, or an empty string if
+    /// it is absent.
+    std::string queryParameter(const std::string& key) const;
+
+    /// @return A hash of the normalized url string, computed once at parse
+    /// time, so keying hash maps on urls does not re-hash the string on
+    /// every operation (see std::hash<qi::Url>).
+    std::size_t hash() const;
+
   private:
-    UrlPrivate* _p;
+    // Shared, immutable once built: copies alias it, setters replace it.
+    std::shared_ptr<const UrlPrivate> _p;
   };
 
   /** Compares the url strings.
@@ -160,4 +187,18 @@ namespace qi {
   QI_API Url specifyUrl(const Url& specification, const Url& baseUrl);
 } // namespace qi
 
+// Hashable:
+namespace std
+{
+  template<>
+  struct hash<qi::Url>
+  {
+    std::size_t operator()(const qi::Url& url) const
+    {
+      return url.hash();
+    }
+  };
+
+} // namespace std
+
 #endif  // _QIMESSAGING_URL_HPP_
@@ -13,7 +13,6 @@
 #include <qi/atomic.hpp>
 #include <qi/log.hpp>
 #include <qi/path.hpp>
-#include <qi/path_conf.hpp>
 #include <src/sdklayout.hpp>
 #include <boost/program_options.hpp>
 #include <boost/filesystem.hpp>
@@ -71,6 +70,9 @@ namespace qi {
   static std::vector<std::string>* globalArguments;
   static std::string globalPrefix;
   static std::string globalProgram;
+  static std::string globalProgramArgv0;
+  static bool        globalProgramResolved = false;
+  static boost::mutex globalProgramMutex;
   static std::string globalRealProgram;
 
   using FunctionList = std::vector<std::function<void()>>;
@@ -89,16 +91,6 @@ namespace qi {
   static std::list<boost::asio::signal_set*>* globalSignalSet = nullptr;
 
 
-  static void readPathConf()
-  {
-    std::string prefix = ::qi::path::sdkPrefix();
-    std::vector<std::string> toAdd =  ::qi::path::parseQiPathConf(prefix);
-    std::vector<std::string>::const_iterator it;
-    for (it = toAdd.begin(); it != toAdd.end(); ++it) {
-      ::qi::path::detail::addOptionalSdkPrefix(it->c_str());
-    }
-  }
-
   static void stop_io_service()
   {
     qiLogVerbose() << "Unregistering all signal handlers.";
@@ -249,23 +241,31 @@ namespace qi {
 
   static void initApp(int& argc, char ** &argv, const std::string& path)
   {
-    // this must be initialized first because readPathConf uses it (through
-    // sdklayout)
     if (!path.empty())
     {
-      globalProgram = path;
+      globalProgram = path::detail::normalize(path).str();
+      globalProgramResolved = true;
       qiLogVerbose() << "Program path explicitely set to " << globalProgram;
     }
     else
     {
-      globalProgram = guess_app_from_path(qi::Path::fromNative(argv[0])).str();
-      qiLogVerbose() << "Program path guessed as " << globalProgram;
+      // Guessing the program path probes the filesystem (PATH lookup and
+      // absolute-path resolution), so only capture argv[0] here and defer
+      // the actual work to the first call to program().
+      globalProgramArgv0 = argv[0];
     }
-    globalProgram = path::detail::normalize(globalProgram).str();
 
     parseArguments(argc, argv);
 
-    readPathConf();
+    // The SDK layout (and the path.conf prefixes it pulls in) is likewise
+    // initialized on first use of qi::path. Code that needs paths resolved
+    // before main logic runs can opt back into the eager behavior.
+    if (os::getEnvParam<int>("QI_APPLICATION_EAGER_PATHS", 0) > 0)
+    {
+      Application::program();
+      ::qi::path::sdkPrefix();
+    }
+
     if (globalInitialized)
       throw std::logic_error("Application was already initialized");
     globalInitialized = true;
@@ -532,6 +532,14 @@ namespace qi {
 
   const char *Application::program()
   {
+    boost::mutex::scoped_lock lock(globalProgramMutex);
+    if (!globalProgramResolved && !globalProgramArgv0.empty())
+    {
+      globalProgramResolved = true;
+      globalProgram = path::detail::normalize(
+          guess_app_from_path(qi::Path::fromNative(globalProgramArgv0))).str();
+      qiLogVerbose() << "Program path guessed as " << globalProgram;
+    }
     return globalProgram.c_str();
   }
 
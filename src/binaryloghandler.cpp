@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) 2012 Aldebaran Robotics. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the COPYING file.
+ */
+
+#include <qi/log/binaryloghandler.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+#include <boost/unordered_map.hpp>
+
+#include <qi/clock.hpp>
+#include <qi/log.hpp>
+#include <qi/os.hpp>
+
+qiLogCategory("qi.log.Binaryloghandler");
+
+namespace qi
+{
+namespace log
+{
+  /* On-disk format, host byte order (see tools/qilog-bin2txt.py):
+   *
+   * File header:   char[4] magic "QILG", uint16 version (1), uint16 reserved.
+   * Category def:  uint8 type (0), uint32 id, uint16 nameLen, name bytes.
+   *                Written once, the first time a category is seen.
+   * Log record:    uint8 type (1), uint8 level, uint32 categoryId,
+   *                uint32 threadId, int32 line, int64 dateNs,
+   *                int64 systemDateNs, uint32 msgLen, msg bytes.
+   */
+  namespace
+  {
+    const char binaryLogMagic[4] = { 'Q', 'I', 'L', 'G' };
+    const uint16_t binaryLogVersion = 1;
+    const uint8_t recordTypeCategory = 0;
+    const uint8_t recordTypeLog = 1;
+
+    // Fixed part of a log record, assembled on the stack then written in one
+    // unformatted write.
+    const size_t logRecordHeaderSize =
+        1 + 1 + 4 + 4 + 4 + 8 + 8 + 4;
+
+    template<typename T>
+    char* append(char* dst, const T& value)
+    {
+      memcpy(dst, &value, sizeof(T));
+      return dst + sizeof(T);
+    }
+  }
+
+  struct PrivateBinaryLogHandler
+  {
+    boost::filesystem::ofstream _file;
+    boost::unordered_map<std::string, uint32_t> _categoryIds;
+    uint32_t _nextCategoryId = 0;
+
+    uint32_t categoryId(const char* category)
+    {
+      auto inserted = _categoryIds.insert(
+          std::make_pair(std::string(category ? category : ""), _nextCategoryId));
+      if (!inserted.second)
+        return inserted.first->second;
+      const uint32_t id = _nextCategoryId++;
+      const std::string& name = inserted.first->first;
+      const uint16_t nameLen =
+          static_cast<uint16_t>(std::min<size_t>(name.size(), 0xffffu));
+      char header[1 + 4 + 2];
+      char* p = header;
+      p = append(p, recordTypeCategory);
+      p = append(p, id);
+      p = append(p, nameLen);
+      _file.write(header, p - header);
+      _file.write(name.data(), nameLen);
+      return id;
+    }
+  };
+
+  BinaryLogHandler::BinaryLogHandler(const std::string& filePath)
+  {
+    boost::filesystem::path fPath(filePath);
+    _p.reset(new PrivateBinaryLogHandler());
+
+    // Create the directory!
+    try
+    {
+      if (!boost::filesystem::exists(fPath.make_preferred().parent_path()))
+        boost::filesystem::create_directories(fPath.make_preferred().parent_path());
+    }
+    catch (const boost::filesystem::filesystem_error& e)
+    {
+      qiLogWarning() << e.what();
+    }
+
+    // Open the file.
+    _p->_file.open(fPath.make_preferred(), std::ios_base::app | std::ios_base::out | std::ios_base::binary);
+
+    if (_p->_file.is_open())
+    {
+      char header[sizeof(binaryLogMagic) + 2 + 2];
+      char* p = header;
+      memcpy(p, binaryLogMagic, sizeof(binaryLogMagic));
+      p += sizeof(binaryLogMagic);
+      p = append(p, binaryLogVersion);
+      p = append(p, uint16_t(0));
+      _p->_file.write(header, p - header);
+    }
+    else
+      qiLogWarning() << "Cannot open " << filePath;
+  }
+
+  BinaryLogHandler::~BinaryLogHandler()
+  {
+    if (_p->_file.is_open())
+      _p->_file.flush();
+  }
+
+  void BinaryLogHandler::log(const qi::LogLevel verb,
+                             const qi::Clock::time_point date,
+                             const qi::SystemClock::time_point systemDate,
+                             const char* category,
+                             const char* msg,
+                             const char* /* file */,
+                             const char* /* fct */,
+                             const int line)
+  {
+    if (verb > qi::log::logLevel() || !_p->_file.is_open())
+      return;
+
+    const uint32_t catId = _p->categoryId(category);
+    const uint32_t msgLen = msg ? static_cast<uint32_t>(strlen(msg)) : 0;
+
+    char header[logRecordHeaderSize];
+    char* p = header;
+    p = append(p, recordTypeLog);
+    p = append(p, static_cast<uint8_t>(verb));
+    p = append(p, catId);
+    p = append(p, static_cast<uint32_t>(qi::os::gettid()));
+    p = append(p, static_cast<int32_t>(line));
+    p = append(p, static_cast<int64_t>(
+        boost::chrono::duration_cast<qi::NanoSeconds>(
+            date.time_since_epoch()).count()));
+    p = append(p, static_cast<int64_t>(
+        boost::chrono::duration_cast<qi::NanoSeconds>(
+            systemDate.time_since_epoch()).count()));
+    p = append(p, msgLen);
+    _p->_file.write(header, p - header);
+    if (msgLen)
+      _p->_file.write(msg, msgLen);
+  }
+}
+}
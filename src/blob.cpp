@@ -0,0 +1,93 @@
+/*
+**  Copyright (C) 2018 Softbank Robotics
+**  See COPYING for the license
+*/
+
+#include <algorithm>
+#include <deque>
+#include <stdexcept>
+
+#include <boost/make_shared.hpp>
+
+#include <qi/async.hpp>
+#include <qi/blob.hpp>
+#include <qi/getenv.hpp>
+#include <qi/log.hpp>
+#include <qi/type/objecttypebuilder.hpp>
+
+qiLogCategory("qi.blob");
+
+namespace qi
+{
+  Blob::Blob()
+  {
+  }
+
+  Blob::Blob(Buffer data)
+    : _data(std::move(data))
+  {
+  }
+
+  uint64_t Blob::size() const
+  {
+    return _data.size();
+  }
+
+  Buffer Blob::fetch(uint64_t offset, uint32_t length) const
+  {
+    Buffer chunk;
+    const uint64_t total = _data.size();
+    if (offset >= total)
+      return chunk;
+    const size_t len =
+        static_cast<size_t>(std::min<uint64_t>(length, total - offset));
+    chunk.write(static_cast<const unsigned char*>(_data.data()) + offset, len);
+    return chunk;
+  }
+
+  const Buffer& Blob::data() const
+  {
+    return _data;
+  }
+
+  QI_REGISTER_MT_OBJECT(Blob, size, fetch)
+
+  Object<Blob> makeBlob(Buffer data)
+  {
+    return Object<Blob>(boost::make_shared<Blob>(std::move(data)));
+  }
+
+  Future<Buffer> fetchBlob(AnyObject blob)
+  {
+    // Runs on an event loop worker: the chunk loop blocks on at most one
+    // reply at a time while keeping `window` requests in flight.
+    return qi::async([blob]() mutable -> Buffer {
+      static const uint32_t chunkSize = std::max<uint32_t>(
+          1, os::getEnvDefault<uint32_t>("QI_BLOB_CHUNK_SIZE", 1024 * 1024));
+      static const size_t window = std::max<size_t>(
+          1, os::getEnvDefault<size_t>("QI_BLOB_FETCH_WINDOW", 4));
+      const uint64_t total = blob.call<uint64_t>("size");
+      Buffer out;
+      std::deque<Future<Buffer>> inFlight;
+      uint64_t offset = 0;
+      while (offset < total || !inFlight.empty())
+      {
+        while (offset < total && inFlight.size() < window)
+        {
+          const uint32_t length = static_cast<uint32_t>(
+              std::min<uint64_t>(chunkSize, total - offset));
+          inFlight.push_back(blob.async<Buffer>("fetch", offset, length));
+          offset += length;
+        }
+        // Chunks are requested and appended in order, so waiting on the
+        // oldest request keeps the assembly trivial.
+        Buffer chunk = inFlight.front().value();
+        inFlight.pop_front();
+        if (chunk.size() == 0)
+          throw std::runtime_error("fetchBlob: remote returned an empty chunk");
+        out.write(chunk.data(), chunk.size());
+      }
+      return out;
+    });
+  }
+}
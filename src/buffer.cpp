@@ -7,14 +7,28 @@
 #include <qi/buffer.hpp>
 #include <qi/log.hpp>
 
+#include <algorithm>
 #include <cstdio>
 #include <cstring>
 #include <stdexcept>
 #include <iomanip>
 #include <ctype.h>
 
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
 #include <boost/make_shared.hpp>
 
+#ifndef _WIN32
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <unistd.h>
+#endif
+
+#include <atomic>
+
+#include <qi/memorystats.hpp>
+
 #include "buffer_p.hpp"
 
 
@@ -22,15 +36,85 @@ qiLogCategory("qi.Buffer");
 
 namespace qi
 {
-  BufferPrivate::BufferPrivate() = default;
+  namespace
+  {
+    // Process-wide accounting (qi::memoryStats()), relaxed: the counters are
+    // read individually, no cross-counter consistency is needed.
+    std::atomic<uint64_t> gLiveBuffers{0};
+    std::atomic<uint64_t> gBufferHeapBytes{0};
+    std::atomic<uint64_t> gPooledBuffers{0};
+  }
+
+  BufferPrivate::BufferPrivate()
+  {
+    gLiveBuffers.fetch_add(1, std::memory_order_relaxed);
+  }
 
   BufferPrivate::~BufferPrivate()
+  {
+    releaseStorage();
+    gLiveBuffers.fetch_sub(1, std::memory_order_relaxed);
+  }
+
+  void BufferPrivate::accountHeapBytes()
+  {
+    const size_t owned = (_bigdata && !_external) ? available : 0;
+    if (owned == _accountedHeapBytes)
+      return;
+    if (owned > _accountedHeapBytes)
+      gBufferHeapBytes.fetch_add(owned - _accountedHeapBytes, std::memory_order_relaxed);
+    else
+      gBufferHeapBytes.fetch_sub(_accountedHeapBytes - owned, std::memory_order_relaxed);
+    _accountedHeapBytes = owned;
+  }
+
+  void BufferPrivate::releaseStorage()
   {
     if (_bigdata)
     {
-      free(_bigdata);
+      if (_external)
+      {
+        if (_externalDeleter)
+          _externalDeleter(_bigdata);
+      }
+      else
+        free(_bigdata);
       _bigdata = NULL;
     }
+    _external = false;
+    _externalDeleter.clear();
+    available = std::extent<decltype(_data)>::value;
+    accountHeapBytes();
+  }
+
+  void BufferPrivate::setExternal(unsigned char* data, size_t size,
+                                  boost::function<void(void*)> deleter)
+  {
+    releaseStorage();
+    _bigdata = data;
+    _external = true;
+    _externalDeleter = std::move(deleter);
+    used = size;
+    available = size;
+  }
+
+  bool BufferPrivate::detach(size_t neededSize)
+  {
+    if (!_external)
+      return true;
+    const size_t allocSize = std::max(neededSize, used) + BLOCK;
+    unsigned char* owned = static_cast<unsigned char*>(malloc(allocSize));
+    if (owned == NULL)
+      return false;
+    ::memcpy(owned, _bigdata, used);
+    if (_externalDeleter)
+      _externalDeleter(_bigdata);
+    _bigdata = owned;
+    _external = false;
+    _externalDeleter.clear();
+    available = allocSize;
+    accountHeapBytes();
+    return true;
   }
 
   BufferPrivate::BufferPrivate(const BufferPrivate& b)
@@ -40,38 +124,40 @@ namespace qi
     , available(b.available)
     , _subBuffers(b._subBuffers)
   {
+    gLiveBuffers.fetch_add(1, std::memory_order_relaxed);
     if (b._bigdata)
     {
+      // A copy always owns its storage, even when b adopted external memory.
       _bigdata = static_cast<unsigned char*>(malloc(b.used));
       ::memcpy(_bigdata, b._bigdata, b.used);
+      available = b.used;
     }
     else
     {
       ::memcpy(_data, b._data, b.used);
     }
+    accountHeapBytes();
   }
 
   BufferPrivate& BufferPrivate::operator=(const BufferPrivate& b)
   {
     if (&b == this) return *this;
+    releaseStorage();
     _cachedSubBufferTotalSize = b._cachedSubBufferTotalSize;
     used = b.used;
-    available = b.available;
     _subBuffers = b._subBuffers;
-    if (_bigdata)
-    {
-      free(_bigdata);
-      _bigdata = NULL;
-    }
     if (b._bigdata)
     {
+      // A copy always owns its storage, even when b adopted external memory.
       _bigdata = static_cast<unsigned char*>(malloc(b.used));
       ::memcpy(_bigdata, b._bigdata, b.used);
+      available = b.used;
     }
     else
     {
       ::memcpy(_data, b._data, b.used);
     }
+    accountHeapBytes();
     return *this;
   }
 
@@ -111,8 +197,83 @@ namespace qi
     return const_cast<BufferPrivate*>(this)->data();
   }
 
+  void BufferPrivate::reset()
+  {
+    // Keep small heap blocks to amortize reallocation across messages, but
+    // release big ones so that pooling a few multi-megabyte payloads does not
+    // pin their memory forever.
+    static const size_t maxRetainedBlock = 16 * BLOCK;
+    if (_external || (_bigdata && available > maxRetainedBlock))
+      releaseStorage();
+    used = 0;
+    _cachedSubBufferTotalSize = 0;
+    _subBuffers.clear();
+  }
+
+  namespace
+  {
+    /// Per-thread freelist of BufferPrivate instances. Message construction
+    /// and destruction both happen at high rate on the messaging threads, and
+    /// a per-thread pool removes the malloc/free pair from that path without
+    /// any synchronization.
+    struct BufferPrivatePool
+    {
+      std::vector<BufferPrivate*> items;
+      bool alive = true;
+      // occupancy counters, reported by qi::detail::bufferPoolStats()
+      uint64_t hits = 0;
+      uint64_t misses = 0;
+      uint64_t dropped = 0;
+      ~BufferPrivatePool()
+      {
+        alive = false;
+        gPooledBuffers.fetch_sub(items.size(), std::memory_order_relaxed);
+        for (auto* p: items)
+          delete p;
+        items.clear();
+      }
+    };
+    thread_local BufferPrivatePool bufferPool;
+    const size_t bufferPoolMaxSize = 64;
+
+    void recycleBufferPrivate(BufferPrivate* p)
+    {
+      // The pool may already be destroyed if the thread is exiting.
+      if (!bufferPool.alive || bufferPool.items.size() >= bufferPoolMaxSize)
+      {
+        if (bufferPool.alive)
+          ++bufferPool.dropped;
+        delete p;
+        return;
+      }
+      p->reset();
+      bufferPool.items.push_back(p);
+      gPooledBuffers.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  boost::shared_ptr<BufferPrivate> BufferPrivate::create()
+  {
+    BufferPrivate* p;
+    if (bufferPool.items.empty())
+    {
+      ++bufferPool.misses;
+      p = new BufferPrivate;
+    }
+    else
+    {
+      ++bufferPool.hits;
+      p = bufferPool.items.back();
+      bufferPool.items.pop_back();
+      gPooledBuffers.fetch_sub(1, std::memory_order_relaxed);
+    }
+    return boost::shared_ptr<BufferPrivate>(p, &recycleBufferPrivate);
+  }
+
   bool BufferPrivate::resize(size_t neededSize)
   {
+    if (_external)
+      return detach(neededSize); // adopted memory cannot be realloc'd
     neededSize += BLOCK; // Should be enough in most cases;
 
     qiLogDebug() << "Resizing buffer from " << available << " to " << neededSize;
@@ -125,22 +286,29 @@ namespace qi
       ::memcpy(newBigdata, _data, used);
     available = neededSize;
     _bigdata = newBigdata; // Don't worry, realloc free previous buffer if needed
+    accountHeapBytes();
     return true;
   }
 
   Buffer::Buffer()
-    : _p(boost::make_shared<BufferPrivate>())
+    : _p(BufferPrivate::create())
   {
   }
 
   Buffer::Buffer(const Buffer& b)
-    : _p(boost::make_shared<BufferPrivate>(*b._p))
+    : _p(BufferPrivate::create())
   {
+    *_p = *b._p;
   }
 
   Buffer& Buffer::operator=(const Buffer& b)
   {
-    _p = boost::make_shared<BufferPrivate>(*b._p);
+    if (&b != this)
+    {
+      auto p = BufferPrivate::create();
+      *p = *b._p;
+      _p = std::move(p);
+    }
     return *this;
   }
 
@@ -148,18 +316,89 @@ namespace qi
     : _p(std::move(b._p))
   {
     // The default state of a qi::Buffer contains a valid BufferPrivate pointer.
-    b._p = boost::make_shared<BufferPrivate>();
+    b._p = BufferPrivate::create();
   }
 
   Buffer& Buffer::operator=(Buffer&& b)
   {
     _p = std::move(b._p);
-    b._p = boost::make_shared<BufferPrivate>();
+    b._p = BufferPrivate::create();
     return *this;
   }
 
+  Buffer Buffer::makeShared(const Buffer& b)
+  {
+    Buffer shared;
+    shared._p = b._p;
+    return shared;
+  }
+
+  Buffer Buffer::fromExternal(void* data, size_t size,
+                              boost::function<void(void*)> deleter)
+  {
+    Buffer b;
+    b._p->setExternal(static_cast<unsigned char*>(data), size,
+                      std::move(deleter));
+    return b;
+  }
+
+#ifndef _WIN32
+  Buffer Buffer::fromFile(const std::string& filePath)
+  {
+    const int fd = ::open(filePath.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+      qiLogVerbose() << "fromFile: cannot open " << filePath;
+      return Buffer();
+    }
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || st.st_size == 0)
+    {
+      ::close(fd);
+      return Buffer();
+    }
+    const size_t size = static_cast<size_t>(st.st_size);
+    void* mapped = ::mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    // The mapping keeps its own reference on the file.
+    ::close(fd);
+    if (mapped == MAP_FAILED)
+    {
+      qiLogVerbose() << "fromFile: cannot map " << filePath;
+      return Buffer();
+    }
+    return fromExternal(mapped, size,
+                        [size](void* data) { ::munmap(data, size); });
+  }
+#else
+  Buffer Buffer::fromFile(const std::string& filePath)
+  {
+    // No mmap here: fall back to reading the file into an ordinary buffer.
+    boost::filesystem::ifstream file(boost::filesystem::path(filePath),
+                                     std::ios_base::in | std::ios_base::binary);
+    if (!file.is_open())
+    {
+      qiLogVerbose() << "fromFile: cannot open " << filePath;
+      return Buffer();
+    }
+    file.seekg(0, std::ios_base::end);
+    const std::streamoff size = file.tellg();
+    file.seekg(0, std::ios_base::beg);
+    Buffer b;
+    if (size <= 0)
+      return b;
+    b.reserveCapacity(static_cast<size_t>(size));
+    if (!file.read(static_cast<char*>(b.reserve(static_cast<size_t>(size))),
+                   size))
+      return Buffer();
+    return b;
+  }
+#endif
+
   bool Buffer::write(const void *data, size_t size)
   {
+    // Never write through adopted external memory: copy it out first.
+    if (_p->_external && !_p->detach(_p->used + size))
+      return false;
     if (_p->used + size > _p->available)
     {
       bool ret = _p->resize(_p->used + size);
@@ -226,6 +465,9 @@ namespace qi
   */
   void *Buffer::reserve(size_t size)
   {
+    // Never write through adopted external memory: copy it out first.
+    if (_p->_external)
+      _p->detach(_p->used + size);
     if (_p->used + size > _p->available)
       _p->resize(_p->used + size);
 
@@ -235,8 +477,18 @@ namespace qi
     return p;
   }
 
+  void Buffer::reserveCapacity(size_t size)
+  {
+    if (size > _p->available)
+      _p->resize(size);
+  }
+
   void Buffer::clear()
   {
+    // Give adopted external memory back to its owner; later writes must not
+    // scribble over it.
+    if (_p->_external)
+      _p->releaseStorage();
     _p->used = 0;
     _p->_subBuffers.clear();
     _p->_cachedSubBufferTotalSize = 0;
@@ -284,6 +536,24 @@ namespace qi
   }
 
   namespace detail {
+    BufferPoolStats bufferPoolStats()
+    {
+      BufferPoolStats stats;
+      stats.poolSize = bufferPool.items.size();
+      stats.poolCapacity = bufferPoolMaxSize;
+      stats.hits = bufferPool.hits;
+      stats.misses = bufferPool.misses;
+      stats.dropped = bufferPool.dropped;
+      return stats;
+    }
+
+    void bufferMemoryStats(MemoryStats& stats)
+    {
+      stats.bufferCount = gLiveBuffers.load(std::memory_order_relaxed);
+      stats.bufferHeapBytes = gBufferHeapBytes.load(std::memory_order_relaxed);
+      stats.pooledBufferCount = gPooledBuffers.load(std::memory_order_relaxed);
+    }
+
     void printBuffer(std::ostream& stream, const Buffer& buffer)
     {
       if (buffer.size() == 0) {
@@ -11,7 +11,9 @@
 #define BLOCK   4096
 
 #include <vector>
+#include <boost/function.hpp>
 #include <boost/optional.hpp>
+#include <boost/shared_ptr.hpp>
 #include <qi/atomic.hpp>
 #include <qi/types.hpp>
 
@@ -28,14 +30,51 @@ namespace qi
     const unsigned char* data() const;
     bool            resize(size_t size = 0x100000);
     boost::optional<size_t> indexOfSubBuffer(size_t offset) const;
+
+    /// Return the object to its default-constructed state, keeping a
+    /// moderately sized heap block around so that it can be reused.
+    void            reset();
+
+    /// Adopt externally owned memory without copying it. The object does not
+    /// free the memory itself: the deleter (which may be empty) is invoked
+    /// with \a data when the storage is released.
+    void            setExternal(unsigned char* data, size_t size,
+                                boost::function<void(void*)> deleter);
+
+    /// Copy external storage into owned storage so that it can be mutated.
+    /// No-op when the storage is already owned. Returns false on allocation
+    /// failure, in which case the object is left unchanged.
+    bool            detach(size_t neededSize);
+
+    /// Release the heap or external storage and fall back to _data.
+    /// Does not touch used/_subBuffers; callers reset those as appropriate.
+    void            releaseStorage();
+
+    /// Reconcile the process-wide heap accounting (qi::memoryStats()) with
+    /// the bytes this instance currently owns. To call after every change
+    /// of the heap storage.
+    void            accountHeapBytes();
+
+    /// Get an instance from the calling thread's recycling pool, or a freshly
+    /// allocated one if the pool is empty. The instance automatically goes
+    /// back to the pool of the thread that releases the last reference, so a
+    /// message buffer freed by a socket's write completion is reused by the
+    /// next message built on that thread.
+    static boost::shared_ptr<BufferPrivate> create();
     friend bool operator==(const BufferPrivate& a, const BufferPrivate& b);
 
   public:
     unsigned char*  _bigdata = nullptr;
     unsigned char   _data[STATIC_BLOCK] = {};
+    // When set, _bigdata points to adopted external memory (see setExternal):
+    // it must not be realloc'd or free'd, and mutating operations detach first.
+    bool            _external = false;
+    boost::function<void(void*)> _externalDeleter;
     size_t          _cachedSubBufferTotalSize = 0u;
     size_t          used = 0u; // size used
     size_t          available = std::extent<decltype(_data)>::value; // total size of buffer
+    // Owned heap bytes currently counted in the process-wide accounting.
+    size_t          _accountedHeapBytes = 0u;
 
     std::vector<std::pair<size_t, Buffer> > _subBuffers;
   };
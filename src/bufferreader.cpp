@@ -52,6 +52,17 @@ namespace qi {
     return p;
   }
 
+  Buffer BufferReader::readBufferView(size_t length)
+  {
+    void *data = read(length);
+    if (!data)
+      return Buffer();
+    // The deleter only exists to keep the source storage alive as long as
+    // the view (or any makeShared copy of it) is.
+    boost::shared_ptr<BufferPrivate> storage = _buffer->_p;
+    return Buffer::fromExternal(data, length, [storage](void*) {});
+  }
+
   size_t BufferReader::read(void *data, size_t size)
   {
     if (_buffer->size() - _cursor < size)
@@ -16,6 +16,10 @@
 #include <boost/thread/thread_time.hpp>
 #include <boost/date_time/gregorian/gregorian_types.hpp>
 #endif
+
+#ifdef __linux__
+#include <time.h>
+#endif
 qiLogCategory("qi.clock");
 
 namespace chrono = boost::chrono;
@@ -28,7 +32,7 @@ namespace qi {
    */
   static SteadyClock::time_point _unused_base = SteadyClock::now();
 
-  SteadyClock::time_point SteadyClock::now()
+  static qi::Duration steadyClockBase()
   {
     static bool initialized = false;
     static qi::Duration base;
@@ -37,7 +41,36 @@ namespace qi {
       base = chrono::steady_clock::now().time_since_epoch();
       initialized = true;
     }
-    return time_point(chrono::steady_clock::now().time_since_epoch() - base);
+    return base;
+  }
+
+#ifdef __linux__
+  /* CLOCK_MONOTONIC_COARSE shares the epoch of CLOCK_MONOTONIC (which backs
+   * boost::chrono::steady_clock on Linux) but is served from the vDSO and
+   * only updated at the kernel tick, so reading it is a couple of loads.
+   */
+  static qi::Duration coarseTicks()
+  {
+    struct timespec ts;
+    if (clock_gettime(CLOCK_MONOTONIC_COARSE, &ts) == 0)
+      return qi::Seconds(ts.tv_sec) + qi::NanoSeconds(ts.tv_nsec);
+    // no coarse clock on this kernel, fall back to the precise one
+    return chrono::steady_clock::now().time_since_epoch();
+  }
+#endif
+
+  SteadyClock::time_point SteadyClock::now()
+  {
+    return time_point(chrono::steady_clock::now().time_since_epoch() - steadyClockBase());
+  }
+
+  SteadyClock::time_point SteadyClock::nowCoarse()
+  {
+#ifdef __linux__
+    return time_point(coarseTicks() - steadyClockBase());
+#else
+    return now();
+#endif
   }
 
   Clock::time_point Clock::now()
@@ -45,6 +78,15 @@ namespace qi {
     return time_point(chrono::steady_clock::now().time_since_epoch());
   }
 
+  Clock::time_point Clock::nowCoarse()
+  {
+#ifdef __linux__
+    return time_point(coarseTicks());
+#else
+    return now();
+#endif
+  }
+
   using uint32ms = chrono::duration<uint32_t, boost::milli>;
 
   uint32_t Clock::toUint32ms(const time_point &t) throw()
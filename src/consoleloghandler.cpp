@@ -331,10 +331,11 @@ namespace log
       return;
     }
 
-    std::string logline =
-        qi::detail::logline(qi::log::context(), date, systemDate, category, msg, file, fct, line, verb);
-    printf("%s", logline.c_str());
+    std::string* logline = detail::acquireLogBuffer();
+    qi::detail::logline(*logline, qi::log::context(), date, systemDate, category, msg, file, fct, line, verb);
+    printf("%s", logline->c_str());
     fflush(stdout);
+    detail::releaseLogBuffer(logline);
   }
 }
 }
@@ -2,10 +2,16 @@
 **  Copyright (C) 2012, 2013 Aldebaran Robotics
 **  See COPYING for the license
 */
+#include <algorithm>
+#include <deque>
 #include <thread>
 #include <system_error>
 #include <memory>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+# include <emmintrin.h> // _mm_pause
+#endif
+
 #include <boost/asio/io_service.hpp>
 #include <boost/program_options.hpp>
 #include <boost/make_shared.hpp>
@@ -37,6 +43,22 @@ qiLogCategory("qi.eventloop");
 
 namespace qi {
 
+  namespace detail {
+    namespace {
+      thread_local bool tEventLoopWorker = false;
+    }
+
+    void markEventLoopWorkerThread()
+    {
+      tEventLoopWorker = true;
+    }
+
+    bool isEventLoopWorkerThread()
+    {
+      return tEventLoopWorker;
+    }
+  }
+
   class EventLoopAsio::WorkerThreadPool
   {
     using Container = std::vector<std::thread>;
@@ -127,18 +149,150 @@ namespace qi {
   static const auto gPingTimeoutEnvVar = "QI_EVENTLOOP_PING_TIMEOUT";
   static const auto gGracePeriodEnvVar = "QI_EVENTLOOP_GRACE_PERIOD";
   static const auto gMaxTimeoutsEnvVar = "QI_EVENTLOOP_MAX_TIMEOUTS";
+  static const auto gWorkStealingEnvVar = "QI_EVENTLOOP_WORK_STEALING";
+  static const auto gSpinCountEnvVar = "QI_EVENTLOOP_SPIN_COUNT";
+  static const auto gNetworkThreadCountEnvVar = "QI_EVENTLOOP_NETWORK_THREAD_COUNT";
+  static const auto gLagSampleRateEnvVar = "QI_EVENTLOOP_LAG_SAMPLE_RATE";
+  static const auto gTimerSlackEnvVar = "QI_TIMER_SLACK_US";
   const char* const EventLoopAsio::defaultName = "MainEventLoop";
 
-  EventLoopAsio::EventLoopAsio(int threadCount, std::string name, bool spawnOnOverload)
+  // CPU relax hint for busy-wait loops: keeps the core available to its
+  // hyperthread sibling without giving up the timeslice.
+  static void spinPause()
+  {
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    _mm_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    __asm__ __volatile__("yield");
+#else
+    std::this_thread::yield();
+#endif
+  }
+
+  // One ready queue per stealing worker. The owner pops at the front, thieves
+  // steal at the back, so under load they mostly touch opposite ends and the
+  // mutex is only held for a pointer swap.
+  struct EventLoopAsio::TaskQueue
+  {
+    boost::mutex mutex;
+    std::deque<boost::function<void()>> tasks;
+  };
+
+  // A delayed task parked in the coalescing timer queue. The fired flag makes
+  // completion and cancellation mutually exclusive whatever thread wins.
+  struct EventLoopAsio::DelayedTask
+  {
+    boost::function<void(const boost::system::error_code&)> handler;
+    std::atomic<bool> fired{false};
+    qi::SteadyClockTimePoint bucket; // key of the bucket holding this task
+  };
+
+  void EventLoopAsio::scheduleDelayedTask(const DelayedTaskPtr& task, qi::SteadyClockTimePoint deadline)
+  {
+    static const auto slack = boost::chrono::duration_cast<qi::SteadyClockTimePoint::duration>(
+        qi::MicroSeconds{qi::os::getEnvDefault<qi::int64_t>(gTimerSlackEnvVar, 0)});
+    if (slack.count() > 0)
+    {
+      // Round the deadline up to the bucket boundary so that nearby deadlines
+      // land in the same bucket and fire in one wakeup.
+      const auto rem = deadline.time_since_epoch() % slack;
+      if (rem.count() != 0)
+        deadline += slack - rem;
+    }
+    task->bucket = deadline;
+
+    boost::mutex::scoped_lock lock(_timerQueueMutex);
+    _timerBuckets[deadline].push_back(task);
+    if (!_timerQueueArmed || deadline < _timerQueueTarget)
+      armTimerQueue();
+  }
+
+  void EventLoopAsio::armTimerQueue()
+  {
+    QI_ASSERT(!_timerBuckets.empty());
+    _timerQueueTarget = _timerBuckets.begin()->first;
+    _timerQueueArmed = true;
+    const auto generation = ++_timerQueueGeneration;
+    // expires_at aborts a pending wait; its handler recognizes the stale
+    // generation and does nothing.
+    _timerQueueTimer.expires_at(_timerQueueTarget);
+    _timerQueueTimer.async_wait([=](const boost::system::error_code&) {
+      onTimerQueueFire(generation);
+    });
+  }
+
+  void EventLoopAsio::onTimerQueueFire(uint64_t generation)
+  {
+    std::vector<DelayedTaskPtr> due;
+    {
+      boost::mutex::scoped_lock lock(_timerQueueMutex);
+      if (generation != _timerQueueGeneration)
+        return; // superseded by a re-arm for an earlier deadline
+      _timerQueueArmed = false;
+      const auto now = SteadyClock::now();
+      while (!_timerBuckets.empty() && _timerBuckets.begin()->first <= now)
+      {
+        auto& bucket = _timerBuckets.begin()->second;
+        due.insert(due.end(), std::make_move_iterator(bucket.begin()),
+                   std::make_move_iterator(bucket.end()));
+        _timerBuckets.erase(_timerBuckets.begin());
+      }
+      if (!_timerBuckets.empty())
+        armTimerQueue();
+    }
+    static const boost::system::error_code success;
+    for (const auto& task: due)
+    {
+      if (!task->fired.exchange(true))
+        task->handler(success);
+    }
+  }
+
+  void EventLoopAsio::cancelDelayedTask(const DelayedTaskPtr& task)
+  {
+    if (task->fired.exchange(true))
+      return; // already fired, or already canceled
+    {
+      boost::mutex::scoped_lock lock(_timerQueueMutex);
+      const auto it = _timerBuckets.find(task->bucket);
+      if (it != _timerBuckets.end())
+      {
+        auto& bucket = it->second;
+        bucket.erase(std::remove(bucket.begin(), bucket.end(), task), bucket.end());
+        if (bucket.empty())
+          _timerBuckets.erase(it);
+        // No re-arm: a wakeup with nothing due just re-arms itself.
+      }
+    }
+    task->handler(boost::asio::error::operation_aborted);
+  }
+
+  EventLoopAsio::EventLoopAsio(int threadCount, std::string name, bool spawnOnOverload,
+                               EventLoopThreadAttributes threadAttributes)
     : EventLoopPrivate(std::move(name))
     , _work(nullptr)
     , _maxThreads(0)
     , _workerThreads(new WorkerThreadPool())
     , _spawnOnOverload(spawnOnOverload)
+    , _threadAttributes(std::move(threadAttributes))
   {
     start(threadCount);
   }
 
+  void EventLoopAsio::applyThreadAttributes() const
+  {
+    if (!_threadAttributes.cpuAffinity.empty() &&
+        !qi::os::setCurrentThreadCPUAffinity(_threadAttributes.cpuAffinity))
+      qiLogWarning() << "Event loop " << _name
+                     << ": could not set worker CPU affinity";
+    if (_threadAttributes.realtimePriority > 0 &&
+        !qi::os::setCurrentThreadRealtimePriority(_threadAttributes.realtimePriority))
+      qiLogWarning() << "Event loop " << _name
+                     << ": could not set worker real-time priority "
+                     << _threadAttributes.realtimePriority
+                     << " (insufficient privileges?)";
+  }
+
   void EventLoopAsio::start(int threadCount)
   {
     if (_workerThreads->size() > 0) // workers are already running
@@ -157,7 +311,27 @@ namespace qi {
     delete _work.exchange(new boost::asio::io_service::work(_io));
 
     _maxThreads = qi::os::getEnvDefault(gMaxThreadsEnvVar, 150);
-    _workerThreads->launchN(threadCount, &EventLoopAsio::runWorkerLoop, this);
+
+    // Work-stealing mode needs at least one thread for asio (timers, socket
+    // I/O) plus one stealing worker.
+    _lagSampleRate = qi::os::getEnvDefault(gLagSampleRateEnvVar, 64);
+    _workStealing = qi::os::getEnvDefault(gWorkStealingEnvVar, 0) != 0 && threadCount >= 2;
+    _idleSpinCount = _workStealing ? qi::os::getEnvDefault(gSpinCountEnvVar, 0) : 0;
+    _taskQueues.clear();
+    _nextTaskQueue = 0;
+    _pendingTasks = 0;
+    if (_workStealing)
+    {
+      qiLogVerbose() << "Event loop " << _name << " runs in work-stealing mode ("
+                     << threadCount - 1 << " workers)";
+      for (int i = 0; i < threadCount - 1; ++i)
+        _taskQueues.emplace_back(new TaskQueue);
+      _workerThreads->launch(&EventLoopAsio::runWorkerLoop, this);
+      for (std::size_t i = 0; i < _taskQueues.size(); ++i)
+        _workerThreads->launch(&EventLoopAsio::runStealingWorkerLoop, this, i);
+    }
+    else
+      _workerThreads->launchN(threadCount, &EventLoopAsio::runWorkerLoop, this);
     if (_spawnOnOverload)
     {
       _pingThread = std::thread(&EventLoopAsio::runPingLoop, this);
@@ -189,6 +363,18 @@ namespace qi {
     // because in some cases some work seems to get "stuck" in it for a reason that is unknown yet.
     _io.stop();
 
+    { // Wake the stealing workers up so they notice _work is gone. Tasks left
+      // in the queues are dropped, as asio drops its pending handlers.
+      boost::mutex::scoped_lock lock(_idleMutex);
+      _idleCond.notify_all();
+    }
+
+    { // Drop parked delayed tasks, as asio drops its pending handlers.
+      boost::mutex::scoped_lock lock(_timerQueueMutex);
+      _timerBuckets.clear();
+      _timerQueueArmed = false;
+    }
+
     join();
   }
 
@@ -241,7 +427,14 @@ namespace qi {
         else
         {
           qiLogInfo() << _name << ": Spawning more threads (" << workerCount << ')';
-          _workerThreads->launch(&EventLoopAsio::runWorkerLoop, this);
+          if (_workStealing)
+            // The extra worker shares a queue with an existing one: the
+            // queues are mutex-protected, owner/thief ends are only a
+            // heuristic.
+            _workerThreads->launch(&EventLoopAsio::runStealingWorkerLoop, this,
+                                   _nextTaskQueue++ % _taskQueues.size());
+          else
+            _workerThreads->launch(&EventLoopAsio::runWorkerLoop, this);
         }
         boost::this_thread::sleep_for(graceDuration);
       }
@@ -267,6 +460,8 @@ namespace qi {
   {
     qiLogDebug() << this << "run starting from pool";
     qi::os::setCurrentThreadName(_name);
+    applyThreadAttributes();
+    detail::markEventLoopWorkerThread();
 
     while (true) {
       try
@@ -284,6 +479,198 @@ namespace qi {
     }
   }
 
+  bool EventLoopAsio::tryPopTask(std::size_t preferredQueue, boost::function<void()>& task)
+  {
+    const std::size_t queueCount = _taskQueues.size();
+    for (std::size_t i = 0; i < queueCount; ++i)
+    {
+      TaskQueue& queue = *_taskQueues[(preferredQueue + i) % queueCount];
+      boost::mutex::scoped_lock lock(queue.mutex);
+      if (queue.tasks.empty())
+        continue;
+      if (i == 0)
+      { // own queue: oldest task first
+        task = std::move(queue.tasks.front());
+        queue.tasks.pop_front();
+      }
+      else
+      { // stealing: take the other end to stay off the owner's cache line
+        task = std::move(queue.tasks.back());
+        queue.tasks.pop_back();
+      }
+      --_pendingTasks;
+      return true;
+    }
+    return false;
+  }
+
+  // Log-scaled histogram bucket of a sampled queue delay: <100us, <1ms,
+  // <10ms, <100ms, <1s, and everything above.
+  static unsigned lagBucket(qi::Duration lag)
+  {
+    qi::Duration bound = qi::MicroSeconds(100);
+    for (unsigned i = 0; i + 1 < EventLoopLagStats::bucketCount; ++i, bound *= 10)
+    {
+      if (lag < bound)
+        return i;
+    }
+    return EventLoopLagStats::bucketCount - 1;
+  }
+
+  void EventLoopAsio::recordLagSample(qi::Duration lag)
+  {
+    std::vector<LagWatcher> breached;
+    {
+      boost::mutex::scoped_lock lock(_lagMutex);
+      ++_lagStats.samples;
+      _lagStats.totalLag += lag;
+      if (lag > _lagStats.maxLag)
+        _lagStats.maxLag = lag;
+      ++_lagStats.buckets[lagBucket(lag)];
+      for (auto it = _lagWatchers.begin(); it != _lagWatchers.end();)
+      {
+        if (lag > it->threshold)
+        {
+          breached.push_back(std::move(*it));
+          it = _lagWatchers.erase(it);
+        }
+        else
+          ++it;
+      }
+    }
+    // Promises are set outside the lock: their callbacks may post back to the
+    // loop or query the stats.
+    for (auto& watcher: breached)
+    {
+      qiLogWarning() << "Event loop " << _name << " queue delay "
+                     << qi::to_string(lag) << " exceeds the monitored threshold";
+      watcher.promise.setError("Event loop monitor timeout");
+    }
+  }
+
+  bool EventLoopAsio::removeLagWatcher(uint64_t id)
+  {
+    boost::mutex::scoped_lock lock(_lagMutex);
+    for (auto it = _lagWatchers.begin(); it != _lagWatchers.end(); ++it)
+    {
+      if (it->id == id)
+      {
+        _lagWatchers.erase(it);
+        return true;
+      }
+    }
+    return false;
+  }
+
+  qi::Future<void> EventLoopAsio::watchLag(qi::Duration threshold)
+  {
+    boost::mutex::scoped_lock lock(_lagMutex);
+    const uint64_t id = ++_nextLagWatcherId;
+    // Only set the canceled state when the watcher was actually removed: a
+    // concurrent breach may already have claimed the promise.
+    qi::Promise<void> promise([this, id](qi::Promise<void> p) {
+      if (removeLagWatcher(id))
+        p.setCanceled();
+    });
+    _lagWatchers.push_back(LagWatcher{threshold, promise, id});
+    return promise.future();
+  }
+
+  EventLoopLagStats EventLoopAsio::lagStats() const
+  {
+    boost::mutex::scoped_lock lock(_lagMutex);
+    return _lagStats;
+  }
+
+  void EventLoopAsio::postImmediate(boost::function<void()> task)
+  {
+    // Sample the queue delay of one task out of N: timestamp it at enqueue
+    // and record how long it waited when it starts executing. Sampling keeps
+    // the wrapping allocation and the clock reads off the common path.
+    if (_lagSampleRate > 0 &&
+        ++_lagSampleCounter % static_cast<uint64_t>(_lagSampleRate) == 0)
+    {
+      const auto enqueued = SteadyClock::now();
+      boost::function<void()> inner = std::move(task);
+      task = [this, enqueued, inner] {
+        recordLagSample(SteadyClock::now() - enqueued);
+        inner();
+      };
+    }
+
+    if (!_workStealing || _taskQueues.empty())
+    {
+      _io.post(std::move(task));
+      return;
+    }
+
+    // Round-robin placement spreads the load over the queues; stealing evens
+    // out whatever imbalance is left.
+    const std::size_t index = _nextTaskQueue++ % _taskQueues.size();
+    {
+      boost::mutex::scoped_lock lock(_taskQueues[index]->mutex);
+      _taskQueues[index]->tasks.push_back(std::move(task));
+    }
+    // Increment-then-read mirrors the worker's register-then-recheck in
+    // runStealingWorkerLoop: with sequentially consistent atomics either we
+    // see the idle worker here, or it sees the pending task and never blocks.
+    ++_pendingTasks;
+    if (_idleWorkers.load() > 0)
+    {
+      boost::mutex::scoped_lock lock(_idleMutex);
+      _idleCond.notify_one();
+    }
+  }
+
+  void EventLoopAsio::runStealingWorkerLoop(std::size_t queueIndex)
+  {
+    qiLogDebug() << this << " work-stealing worker " << queueIndex << " starting";
+    qi::os::setCurrentThreadName(_name);
+    applyThreadAttributes();
+    detail::markEventLoopWorkerThread();
+
+    while (_work.load())
+    {
+      boost::function<void()> task;
+      if (!tryPopTask(queueIndex, task))
+      {
+        // Spin a bit before parking: waking a worker through the condition
+        // variable costs a few microseconds, which dominates the latency of
+        // short tasks under bursty load (QI_EVENTLOOP_SPIN_COUNT).
+        bool popped = false;
+        for (int spin = _idleSpinCount; spin > 0 && _work.load(); --spin)
+        {
+          spinPause();
+          if (_pendingTasks.load() != 0 && tryPopTask(queueIndex, task))
+          {
+            popped = true;
+            break;
+          }
+        }
+        if (!popped)
+        {
+          boost::mutex::scoped_lock lock(_idleMutex);
+          ++_idleWorkers;
+          if (_pendingTasks.load() == 0 && _work.load())
+            _idleCond.wait(lock);
+          --_idleWorkers;
+          continue;
+        }
+      }
+
+      try
+      {
+        task();
+      } catch(const detail::TerminateThread& /* e */) {
+        break;
+      } catch(const std::exception& e) {
+        qiLogWarning() << "Error caught in eventloop(" << _name << ").async: " << e.what();
+      } catch(...) {
+        qiLogWarning() << "Uncaught exception in eventloop(" << _name << ")";
+      }
+    }
+  }
+
   bool EventLoopAsio::isInThisContext() const
   {
     return _workerThreads->isWorker(std::this_thread::get_id());
@@ -305,10 +692,69 @@ namespace qi {
     qiLogDebug()  << "Waiting threads from the pool - DONE";
   }
 
+  namespace
+  {
+    // Per-tag execution-time table (see qi::registerTaskTag). Slots are
+    // plain atomics so tagged tasks pay two clock reads and two relaxed
+    // adds; untagged tasks pay nothing.
+    const unsigned int maxTaskTags = 64;
+    struct TaskTagSlot
+    {
+      std::atomic<uint64_t> taskCount{0};
+      std::atomic<uint64_t> totalTimeUs{0};
+    };
+    TaskTagSlot gTaskTagSlots[maxTaskTags];
+    boost::mutex gTaskTagNamesMutex;
+    std::vector<std::string> gTaskTagNames; // index == tag - 1
+
+    void accountTaskTag(unsigned int taskTag, qi::SteadyClockTimePoint start)
+    {
+      TaskTagSlot& slot = gTaskTagSlots[taskTag - 1];
+      const auto elapsed = boost::chrono::duration_cast<qi::MicroSeconds>(
+          qi::SteadyClock::now() - start);
+      slot.taskCount.fetch_add(1, std::memory_order_relaxed);
+      slot.totalTimeUs.fetch_add(static_cast<uint64_t>(elapsed.count()),
+                                 std::memory_order_relaxed);
+    }
+  }
+
+  unsigned int registerTaskTag(const std::string& name)
+  {
+    boost::mutex::scoped_lock lock(gTaskTagNamesMutex);
+    for (unsigned int i = 0; i < gTaskTagNames.size(); ++i)
+      if (gTaskTagNames[i] == name)
+        return i + 1;
+    if (gTaskTagNames.size() >= maxTaskTags)
+    {
+      qiLogWarning() << "Task tag registry is full, \"" << name
+                     << "\" will run untagged";
+      return 0;
+    }
+    gTaskTagNames.push_back(name);
+    return static_cast<unsigned int>(gTaskTagNames.size());
+  }
+
+  std::vector<TaskTagStats> taskTagStats()
+  {
+    std::vector<TaskTagStats> table;
+    boost::mutex::scoped_lock lock(gTaskTagNamesMutex);
+    table.reserve(gTaskTagNames.size());
+    for (unsigned int i = 0; i < gTaskTagNames.size(); ++i)
+    {
+      TaskTagStats row;
+      row.name = gTaskTagNames[i];
+      row.taskCount = gTaskTagSlots[i].taskCount.load(std::memory_order_relaxed);
+      row.totalTimeUs = gTaskTagSlots[i].totalTimeUs.load(std::memory_order_relaxed);
+      table.push_back(row);
+    }
+    return table;
+  }
+
   /// Destructible D
   template <typename D>
   void EventLoopAsio::invoke_maybe(boost::function<void()> f, qi::uint64_t id, qi::Promise<void> p,
-                                   const boost::system::error_code& erc, D countTask)
+                                   const boost::system::error_code& erc, D countTask,
+                                   unsigned int taskTag)
   {
     boost::ignore_unused(id, countTask);
     if (!erc)
@@ -318,7 +764,16 @@ namespace qi {
 
       try
       {
-        f();
+        if (taskTag && taskTag <= maxTaskTags)
+        {
+          const auto start = qi::SteadyClock::now();
+          f();
+          accountTaskTag(taskTag, start);
+        }
+        else
+        {
+          f();
+        }
         tracepoint(qi_qi, eventloop_task_stop, id);
         p.setValue(0);
       }
@@ -363,7 +818,7 @@ namespace qi {
       tracepoint(qi_qi, eventloop_post, id, cb.target_type().name());
 
       auto countTotalTask = ka::shared_ptr(ka::scoped_incr_and_decr(_totalTask));
-      _io.post([=] { invoke_maybe(cb, id, Promise<void>{}, erc, countTotalTask); });
+      postImmediate([=] { invoke_maybe(cb, id, Promise<void>{}, erc, countTotalTask, options.taskTag); });
     }
     else
     {
@@ -404,14 +859,22 @@ namespace qi {
     tracepoint(qi_qi, eventloop_delay, id, cb.target_type().name(), boost::chrono::duration_cast<qi::MicroSeconds>(delay).count());
     if (delay > Duration::zero())
     {
-      boost::shared_ptr<boost::asio::steady_timer> timer = boost::make_shared<boost::asio::steady_timer>(boost::ref(_io));
-      timer->expires_from_now(boost::chrono::duration_cast<boost::asio::steady_timer::duration>(delay));
-      auto prom = detail::makeCancelingPromise(options, boost::bind(&boost::asio::steady_timer::cancel, timer));
-      timer->async_wait([=](const boost::system::error_code& erc) { invoke_maybe(cb, id, prom, erc, countTotalTask); });
+      auto task = boost::make_shared<DelayedTask>();
+      auto prom = detail::makeCancelingPromise(options, boost::bind(&EventLoopAsio::cancelDelayedTask, this, task));
+      task->handler = [=](const boost::system::error_code& erc) {
+        // In work-stealing mode the asio thread only drives timers and I/O:
+        // hand the callback itself over to the worker queues.
+        if (_workStealing)
+          postImmediate([=] { invoke_maybe(cb, id, prom, erc, countTotalTask, options.taskTag); });
+        else
+          invoke_maybe(cb, id, prom, erc, countTotalTask, options.taskTag);
+      };
+      scheduleDelayedTask(task,
+          SteadyClock::now() + boost::chrono::duration_cast<qi::SteadyClockTimePoint::duration>(delay));
       return prom.future();
     }
     Promise<void> prom;
-    _io.post([=] { invoke_maybe(cb, id, prom, erc, countTotalTask); });
+    postImmediate([=] { invoke_maybe(cb, id, prom, erc, countTotalTask, options.taskTag); });
     return prom.future();
   }
 
@@ -438,10 +901,15 @@ namespace qi {
     auto countTotalTask = ka::shared_ptr(ka::scoped_incr_and_decr(_totalTask));
 
     //tracepoint(qi_qi, eventloop_delay, id, cb.target_type().name(), qi::MicroSeconds(delay).count());
-    boost::shared_ptr<SteadyTimer> timer = boost::make_shared<SteadyTimer>(boost::ref(_io));
-    timer->expires_at(timepoint);
-    auto prom = detail::makeCancelingPromise(options, boost::bind(&SteadyTimer::cancel, timer));
-    timer->async_wait([=](const boost::system::error_code& erc) { invoke_maybe(cb, id, prom, erc, countTotalTask); });
+    auto task = boost::make_shared<DelayedTask>();
+    auto prom = detail::makeCancelingPromise(options, boost::bind(&EventLoopAsio::cancelDelayedTask, this, task));
+    task->handler = [=](const boost::system::error_code& erc) {
+      if (_workStealing)
+        postImmediate([=] { invoke_maybe(cb, id, prom, erc, countTotalTask, options.taskTag); });
+      else
+        invoke_maybe(cb, id, prom, erc, countTotalTask, options.taskTag);
+    };
+    scheduleDelayedTask(task, timepoint);
     return prom.future();
   }
 
@@ -450,13 +918,20 @@ namespace qi {
     _maxThreads = static_cast<int>(max);
   }
 
+  unsigned int EventLoopAsio::workerCount() const
+  {
+    return static_cast<unsigned int>(_workerThreads->size());
+  }
+
   void* EventLoopAsio::nativeHandle()
   {
     return static_cast<void*>(&_io);
   }
 
-  EventLoop::EventLoop(std::string name, int nthreads, bool spawnOnOverload)
-    : _p(std::make_shared<EventLoopAsio>(nthreads, name, spawnOnOverload))
+  EventLoop::EventLoop(std::string name, int nthreads, bool spawnOnOverload,
+                       EventLoopThreadAttributes threadAttributes)
+    : _p(std::make_shared<EventLoopAsio>(nthreads, name, spawnOnOverload,
+                                         std::move(threadAttributes)))
     , _name(name)
   {
   }
@@ -588,84 +1063,35 @@ namespace qi {
     });
   }
 
-  struct MonitorContext
+  unsigned int EventLoop::workerCount() const
   {
-    EventLoop* target;
-    EventLoop* helper;
-    Future<void> mon;
-    bool isFired;  // true: pinging, false: waiting for next ping.
-    bool ending;
-    uint64_t maxDelay;
-    Promise<void> promise;
-    int64_t startTime;
-  };
-
-  static void monitor_pingtimeout(boost::shared_ptr<MonitorContext> ctx)
-  {
-    if (!ctx->isFired)
-      return; // Got the pong in the meantime, abort
-    ctx->promise.setError("Event loop monitor timeout");
-    /* Ping system is still on, but promise is set.
-     * So future invocations of cancel() will be ignored, which makes the
-     * monitoring unstopable.
-     * So reset the value.
-    */
-    ctx->promise = Promise<void>();
-  }
-
-  static void monitor_cancel(qi::Promise<void>, boost::shared_ptr<MonitorContext> ctx)
-  {
-    ctx->ending = true;
-    try {
-      ctx->mon.cancel();
+    return safeCall(_p, [](const ImplPtr& impl){
+      return impl->workerCount();
     }
-    catch (...)
-    {}
+    , []() -> unsigned int {
+      return 0;
+    });
   }
 
-  static void monitor_ping(boost::shared_ptr<MonitorContext> ctx)
+  EventLoopLagStats EventLoop::lagStats() const
   {
-    if (ctx->ending)
-      return;
-    if (ctx->isFired)
-    { // This is a pong
-      ctx->isFired = false;
-      // Cancel monitoring async call
-      try {
-        ctx->mon.cancel();
-      }
-      catch (const std::exception& e) {
-        qiLogDebug() << "Failed to cancel monitoring async call: " << e.what();
-      }
-      uint64_t pingDelay = os::ustime() - ctx->startTime;
-      if (pingDelay > ctx->maxDelay / 2)
-        qiLogDebug() << "Long ping " << pingDelay;
-      // Wait a bit before pinging againg
-      ctx->helper->asyncDelay(boost::bind(&monitor_ping, ctx), qi::MicroSeconds(ctx->maxDelay*5));
-    }
-    else
-    { // Delay between pings reached, ping again
-      ctx->startTime = os::ustime();
-      ctx->isFired = true;
-      // Start monitor async first, or the ping async can trigger before the
-      // monitor async is setup
-      ctx->mon = ctx->helper->asyncDelay(boost::bind(&monitor_pingtimeout, ctx), qi::MicroSeconds(ctx->maxDelay));
-      ctx->target->post(boost::bind(&monitor_ping, ctx));
+    return safeCall(_p, [](const ImplPtr& impl){
+      return impl->lagStats();
     }
+    , []{
+      return EventLoopLagStats();
+    });
   }
 
   qi::Future<void> EventLoop::monitorEventLoop(EventLoop* helper, uint64_t maxDelay)
   {
-    // Context data is a Future*[2]
-    boost::shared_ptr<MonitorContext> ctx = boost::make_shared<MonitorContext>();
-    ctx->target = this;
-    ctx->helper = helper;
-    ctx->maxDelay = maxDelay;
-    ctx->promise = Promise<void>(boost::bind<void>(&monitor_cancel, _1, ctx));
-    ctx->isFired = false;
-    ctx->ending = false;
-    monitor_ping(ctx);
-    return ctx->promise.future();
+    // The helper loop is not needed anymore: the lag is sampled passively on
+    // the monitored loop itself instead of being measured with ping tasks,
+    // which loaded the pool and woke idle CPUs just to check responsiveness.
+    boost::ignore_unused(helper);
+    return safeCall(_p, [&](const ImplPtr& impl) {
+      return impl->watchLag(qi::MicroSeconds(maxDelay));
+    }, onDestructingError);
   }
 
   static void eventloop_stop(EventLoop* &ctx)
@@ -715,12 +1141,20 @@ namespace qi {
   {
     static boost::mutex mutex;
     static std::atomic<int> init(0);
-    return _getInternal(ctx, 1, "EventLoopNetwork", false, mutex, init);
+    // The network loop only runs socket I/O and timers: decoded messages are
+    // handed over to the worker pool through the sockets' strands, so one
+    // thread is usually enough. Hosts with many busy sockets can grow the
+    // reactor pool independently of the worker pool.
+    static const int threadCount = qi::os::getEnvDefault(gNetworkThreadCountEnvVar, 1);
+    return _getInternal(ctx, threadCount, "EventLoopNetwork", false, mutex, init);
   }
 
   void startEventLoop(int nthread)
   {
     _get(_poolEventLoop, nthread);
+    // Also spin up the network eventloop so that both pools are sized and
+    // running before the first connection instead of on first use.
+    _getNetwork(_networkEventLoop);
   }
 
   EventLoop* getEventLoop()
@@ -8,12 +8,26 @@
 #define _SRC_EVENTLOOP_P_HPP_
 
 #include <atomic>
+#include <map>
+#include <memory>
 #include <thread>
+#include <vector>
 #include <boost/asio.hpp>
 #include <qi/eventloop.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
 #include <boost/thread/synchronized_value.hpp>
 
 namespace qi {
+  namespace detail {
+    /// Marks the calling thread as an event-loop worker. Called once at
+    /// worker startup; the flag is thread-local and never reset.
+    void markEventLoopWorkerThread();
+    /// \return whether the calling thread is an event-loop worker. Used by
+    /// the FutureSync destruction hand-off policy.
+    bool isEventLoopWorkerThread();
+  }
+
   class AsyncCallHandlePrivate
   {
   public:
@@ -51,6 +65,9 @@ namespace qi {
     virtual void post(qi::SteadyClockTimePoint timepoint, const boost::function<void ()>& callback, ExecutionOptions options = defaultExecutionOptions())=0;
     virtual void* nativeHandle()=0;
     virtual void setMaxThreads(unsigned int max)=0;
+    virtual unsigned int workerCount() const=0;
+    virtual EventLoopLagStats lagStats() const=0;
+    virtual qi::Future<void> watchLag(qi::Duration threshold)=0;
     boost::synchronized_value<boost::function<void()>> _emergencyCallback;
     const std::string _name;
   };
@@ -61,7 +78,8 @@ namespace qi {
     static const char* const defaultName;
 
     explicit EventLoopAsio(int threadCount = 0, std::string name = defaultName,
-      bool spawnOnOverload = true);
+      bool spawnOnOverload = true,
+      EventLoopThreadAttributes threadAttributes = EventLoopThreadAttributes());
     ~EventLoopAsio() override;
 
     bool isInThisContext() const override;
@@ -78,14 +96,32 @@ namespace qi {
         const boost::function<void ()>& callback, ExecutionOptions options = defaultExecutionOptions()) override;
     void* nativeHandle() override;
     void setMaxThreads(unsigned int max) override;
+    unsigned int workerCount() const override;
+    EventLoopLagStats lagStats() const override;
+    qi::Future<void> watchLag(qi::Duration threshold) override;
 
   private:
     /// Destructible D
     template<typename D>
     void invoke_maybe(boost::function<void()> f, qi::uint64_t id, qi::Promise<void> p,
-                      const boost::system::error_code& erc, D countTask);
+                      const boost::system::error_code& erc, D countTask,
+                      unsigned int taskTag = 0);
     void runWorkerLoop();
     void runPingLoop();
+    /// Applies _threadAttributes to the calling worker thread.
+    void applyThreadAttributes() const;
+
+    /// Work-stealing mode (QI_EVENTLOOP_WORK_STEALING): zero-delay tasks go
+    /// through per-worker queues instead of the shared asio ready queue,
+    /// which does not scale past a handful of cores. asio keeps handling
+    /// timers and socket I/O on a dedicated thread.
+    void runStealingWorkerLoop(std::size_t queueIndex);
+    /// Posts a zero-delay task, through the worker queues in work-stealing
+    /// mode and through asio otherwise.
+    void postImmediate(boost::function<void()> task);
+    /// Pops a task, looking at the worker's own queue first and then trying
+    /// to steal from the others. Returns false when all queues are empty.
+    bool tryPopTask(std::size_t preferredQueue, boost::function<void()>& task);
 
     boost::asio::io_service _io;
     std::atomic<boost::asio::io_service::work*> _work; // keep io.run() alive
@@ -95,9 +131,67 @@ namespace qi {
     std::unique_ptr<WorkerThreadPool> _workerThreads;
     std::thread _pingThread;
 
+    /// Delayed tasks are coalesced into buckets served by one asio timer
+    /// instead of one timer object per call: thousands of periodic tasks
+    /// then cost one heap entry, and with a slack (QI_TIMER_SLACK_US)
+    /// nearby deadlines fire in a single wakeup.
+    struct DelayedTask;
+    using DelayedTaskPtr = boost::shared_ptr<DelayedTask>;
+    void scheduleDelayedTask(const DelayedTaskPtr& task, qi::SteadyClockTimePoint deadline);
+    void cancelDelayedTask(const DelayedTaskPtr& task);
+    /// Re-arms the timer on the earliest bucket. _timerQueueMutex must be held.
+    void armTimerQueue();
+    void onTimerQueueFire(uint64_t generation);
+
+    struct TaskQueue;
+    std::vector<std::unique_ptr<TaskQueue>> _taskQueues; // only filled in work-stealing mode
+    std::atomic<unsigned int> _nextTaskQueue{0}; // round-robin placement of posted tasks
+    std::atomic<int64_t> _pendingTasks{0}; // tasks sitting in _taskQueues
+    std::atomic<int> _idleWorkers{0}; // stealing workers blocked in _idleCond
+    boost::mutex _idleMutex;
+    boost::condition_variable _idleCond;
+    bool _workStealing = false; // set in start()
+    /// How many pause iterations an idle stealing worker spins before
+    /// parking in _idleCond (QI_EVENTLOOP_SPIN_COUNT, 0 parks immediately).
+    /// Parking and waking go through the mutex, which is too slow when
+    /// message bursts arrive a few microseconds apart.
+    int _idleSpinCount = 0; // set in start()
+
+    using TimerBuckets = std::map<qi::SteadyClockTimePoint, std::vector<DelayedTaskPtr>>;
+    boost::mutex _timerQueueMutex;
+    TimerBuckets _timerBuckets;
+    bool _timerQueueArmed = false;
+    qi::SteadyClockTimePoint _timerQueueTarget;
+    // Bumped at every re-arm so that a superseded wait can recognize itself.
+    uint64_t _timerQueueGeneration = 0;
+    boost::asio::basic_waitable_timer<qi::SteadyClock> _timerQueueTimer{_io};
+
+    /// Passive lag sampling: one task out of N (QI_EVENTLOOP_LAG_SAMPLE_RATE)
+    /// posted through postImmediate is timestamped, and its queue delay is
+    /// recorded into _lagStats when it starts executing. Replaces the
+    /// ping-based probing of monitorEventLoop, which loaded the pool and woke
+    /// idle CPUs just to measure responsiveness.
+    void recordLagSample(qi::Duration lag);
+    /// Removes the watcher registered with that id, if still registered.
+    bool removeLagWatcher(uint64_t id);
+
+    struct LagWatcher
+    {
+      qi::Duration threshold;
+      qi::Promise<void> promise;
+      uint64_t id;
+    };
+    std::atomic<uint64_t> _lagSampleCounter{0};
+    int _lagSampleRate = 0; // set in start()
+    mutable boost::mutex _lagMutex;
+    EventLoopLagStats _lagStats;
+    std::vector<LagWatcher> _lagWatchers;
+    uint64_t _nextLagWatcherId = 0;
+
     std::atomic<int64_t> _totalTask {0};
     std::atomic<int64_t> _activeTask {0};
     const bool _spawnOnOverload;
+    const EventLoopThreadAttributes _threadAttributes;
   };
 }
 
@@ -76,10 +76,11 @@ namespace log
     }
     else
     {
-      std::string logline =
-          qi::detail::logline(qi::log::context(), date, systemDate, category, msg, file, fct, line, verb);
-      fprintf(_p->_file, "%s", logline.c_str());
+      std::string* logline = detail::acquireLogBuffer();
+      qi::detail::logline(*logline, qi::log::context(), date, systemDate, category, msg, file, fct, line, verb);
+      fprintf(_p->_file, "%s", logline->c_str());
       fflush(_p->_file);
+      detail::releaseLogBuffer(logline);
     }
   }
 }
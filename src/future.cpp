@@ -2,16 +2,62 @@
 **  Copyright (C) 2012 Aldebaran Robotics
 **  See COPYING for the license
 */
+#include <atomic>
+#include <new>
+#include <vector>
+
 #include <qi/future.hpp>
 #include <qi/log.hpp>
+#include <qi/memorystats.hpp>
 #include <qi/os.hpp>
 
+#include "trace_p.hpp"
+#include "eventloop_p.hpp"
+
 #include <boost/thread.hpp>
 
 qiLogCategory("qi.future");
 
 namespace qi {
 
+  namespace {
+    // FutureSync destruction hand-off policy (see future_fwd.hpp). -1 means
+    // the environment has not been consulted yet.
+    std::atomic<int> gFutureSyncHandOff{-1};
+    std::atomic<uint64_t> gFutureSyncHandOffCount{0};
+  }
+
+  void setFutureSyncHandOffEnabled(bool enabled)
+  {
+    gFutureSyncHandOff.store(enabled ? 1 : 0);
+  }
+
+  bool futureSyncHandOffEnabled()
+  {
+    int enabled = gFutureSyncHandOff.load(std::memory_order_relaxed);
+    if (enabled < 0)
+    {
+      enabled = os::getEnvParam<int>("QI_FUTURESYNC_HANDOFF", 0) > 0 ? 1 : 0;
+      gFutureSyncHandOff.store(enabled);
+    }
+    return enabled == 1;
+  }
+
+  uint64_t futureSyncHandOffCount()
+  {
+    return gFutureSyncHandOffCount.load();
+  }
+
+  namespace detail {
+    bool handOffFutureSyncWait()
+    {
+      if (!futureSyncHandOffEnabled() || !isEventLoopWorkerThread())
+        return false;
+      ++gFutureSyncHandOffCount;
+      return true;
+    }
+  }
+
   namespace detail {
     class FutureBasePrivate {
     public:
@@ -26,6 +72,10 @@ namespace qi {
       std::string  _error;
       std::atomic<FutureState> _state;
       std::atomic<bool> _cancelRequested;
+      // Number of threads currently blocked in wait(). Lets notifyFinish()
+      // skip the condition variable wakeup entirely when nobody waits, which
+      // is the common case on the messaging reply path.
+      std::atomic<unsigned int> _waiters;
     };
 
     FutureBasePrivate::FutureBasePrivate()
@@ -33,20 +83,105 @@ namespace qi {
         _mutex(),
         _error(),
         _state(FutureState_None),
-        _cancelRequested(false)
+        _cancelRequested(false),
+        _waiters(0)
+
+
+    {
+    }
+
+    namespace {
+      // Thread-local free lists backing allocFutureState()/freeFutureState(),
+      // one per size class, following the same scheme as the buffer pool in
+      // buffer.cpp. Blocks are always allocated at the full size of their
+      // class so that any later request of the same class can reuse them.
+      const size_t futurePoolGranularity = 64;
+      const size_t futurePoolClassCount = 8; // pooled range: up to 512 bytes
+      const size_t futurePoolMaxItemsPerClass = 64;
+
+      // Process-wide accounting (qi::memoryStats()), relaxed.
+      std::atomic<uint64_t> gLiveFutureStates{0};
+      std::atomic<uint64_t> gPooledFutureStates{0};
+
+      struct FutureStatePool
+      {
+        std::vector<void*> items[futurePoolClassCount];
+        bool alive = true;
+        ~FutureStatePool()
+        {
+          alive = false;
+          for (auto& list: items)
+          {
+            gPooledFutureStates.fetch_sub(list.size(), std::memory_order_relaxed);
+            for (void* p: list)
+              ::operator delete(p);
+            list.clear();
+          }
+        }
+      };
+      thread_local FutureStatePool futureStatePool;
+
+      size_t futurePoolClass(size_t size)
+      {
+        return (size == 0 ? 0 : size - 1) / futurePoolGranularity;
+      }
+    }
+
+    void* allocFutureState(std::size_t size)
+    {
+      gLiveFutureStates.fetch_add(1, std::memory_order_relaxed);
+      const size_t sizeClass = futurePoolClass(size);
+      if (sizeClass >= futurePoolClassCount)
+        return ::operator new(size);
+      if (futureStatePool.alive)
+      {
+        auto& items = futureStatePool.items[sizeClass];
+        if (!items.empty())
+        {
+          void* p = items.back();
+          items.pop_back();
+          gPooledFutureStates.fetch_sub(1, std::memory_order_relaxed);
+          return p;
+        }
+      }
+      // Always the full class size, even when this thread's pool is already
+      // destroyed: the block may be freed into another thread's pool and
+      // handed out for any allocation of the same class.
+      return ::operator new((sizeClass + 1) * futurePoolGranularity);
+    }
 
+    void freeFutureState(void* ptr, std::size_t size)
+    {
+      if (!ptr)
+        return;
+      gLiveFutureStates.fetch_sub(1, std::memory_order_relaxed);
+      const size_t sizeClass = futurePoolClass(size);
+      // The pool may already be destroyed if the thread is exiting.
+      if (sizeClass < futurePoolClassCount && futureStatePool.alive &&
+          futureStatePool.items[sizeClass].size() < futurePoolMaxItemsPerClass)
+      {
+        futureStatePool.items[sizeClass].push_back(ptr);
+        gPooledFutureStates.fetch_add(1, std::memory_order_relaxed);
+        return;
+      }
+      ::operator delete(ptr);
+    }
 
+    void futureMemoryStats(MemoryStats& stats)
     {
+      stats.futureCount = gLiveFutureStates.load(std::memory_order_relaxed);
+      stats.pooledFutureCount = gPooledFutureStates.load(std::memory_order_relaxed);
     }
 
     FutureBase::FutureBase()
-      : _p(new FutureBasePrivate())
+      : _p(new (allocFutureState(sizeof(FutureBasePrivate))) FutureBasePrivate())
     {
     }
 
     FutureBase::~FutureBase()
     {
-      delete _p;
+      _p->~FutureBasePrivate();
+      freeFutureState(_p, sizeof(FutureBasePrivate));
     };
 
     FutureState FutureBase::state() const
@@ -59,31 +194,66 @@ namespace qi {
       return p->_state.load() != FutureState_Running;
     }
 
+    namespace {
+      /* Registers a blocked thread in _waiters for the duration of a wait.
+       *
+       * The protocol with notifyFinish() relies on the default sequentially
+       * consistent atomics: the waiter increments _waiters and then rechecks
+       * _state under the mutex, the finisher stores _state and then reads
+       * _waiters. Whatever the interleaving, either the finisher sees the
+       * waiter and notifies under the mutex, or the waiter sees the final
+       * state and never blocks.
+       */
+      struct ScopedWaiterCount
+      {
+        explicit ScopedWaiterCount(FutureBasePrivate* p)
+          : _p(p)
+        {
+          ++_p->_waiters;
+        }
+        ~ScopedWaiterCount()
+        {
+          --_p->_waiters;
+        }
+        FutureBasePrivate* _p;
+      };
+    }
+
     FutureState FutureBase::wait(int msecs) const {
+      // Fast path: the state only moves forward, so a finished future can be
+      // read without taking the mutex.
+      FutureState state = FutureState(_p->_state.load());
+      if (state != FutureState_Running)
+        return state;
+      // msecs <= 0 : do nothing just return the state
+      if (msecs != FutureTimeout_Infinite && msecs <= 0)
+        return state;
+      ScopedWaiterCount waiter(_p);
       boost::recursive_mutex::scoped_lock lock(_p->_mutex);
-      if (_p->_state.load() != FutureState_Running)
-        return FutureState(_p->_state.load());
       if (msecs == FutureTimeout_Infinite)
         _p->_cond.wait(lock, boost::bind(&waitFinished, _p));
-      else if (msecs > 0)
+      else
         _p->_cond.wait_for(lock, qi::MilliSeconds(msecs),
             boost::bind(&waitFinished, _p));
-      // msecs <= 0 : do nothing just return the state
       return FutureState(_p->_state.load());
     }
 
     FutureState FutureBase::wait(qi::Duration duration) const {
+      FutureState state = FutureState(_p->_state.load());
+      if (state != FutureState_Running)
+        return state;
+      ScopedWaiterCount waiter(_p);
       boost::recursive_mutex::scoped_lock lock(_p->_mutex);
-      if (_p->_state.load() != FutureState_Running)
-        return FutureState(_p->_state.load());
       _p->_cond.wait_for(lock, duration, boost::bind(&waitFinished, _p));
       return FutureState(_p->_state.load());
     }
 
     FutureState FutureBase::wait(qi::SteadyClock::time_point timepoint) const {
+      FutureState state = FutureState(_p->_state.load());
+      if (state != FutureState_Running)
+        return state;
+      ScopedWaiterCount waiter(_p);
       boost::recursive_mutex::scoped_lock lock(_p->_mutex);
-      if (_p->_state.load() != FutureState_Running)
-        return FutureState(_p->_state.load());
       _p->_cond.wait_until(lock, timepoint, boost::bind(&waitFinished, _p));
       return FutureState(_p->_state.load());
     }
@@ -92,6 +262,7 @@ namespace qi {
       //always set by setValue
       //boost::recursive_mutex::scoped_lock lock(_p->_mutex);
       _p->_state = FutureState_FinishedWithValue;
+      QI_TRACE2(future_finish, _p, FutureState_FinishedWithValue);
     }
 
     void FutureBase::requestCancel() {
@@ -102,6 +273,7 @@ namespace qi {
       //always set by setCanceled
       //boost::recursive_mutex::scoped_lock lock(_p->_mutex);
       _p->_state = FutureState_Canceled;
+      QI_TRACE2(future_finish, _p, FutureState_Canceled);
     }
 
     void FutureBase::reportError(const std::string &message) {
@@ -109,6 +281,7 @@ namespace qi {
       //boost::recursive_mutex::scoped_lock lock(_p->_mutex);
       _p->_state = FutureState_FinishedWithError;
       _p->_error = message;
+      QI_TRACE2(future_finish, _p, FutureState_FinishedWithError);
     }
 
     void FutureBase::reportStart() {
@@ -117,6 +290,13 @@ namespace qi {
     }
 
     void FutureBase::notifyFinish() {
+      // Called after the final state has been stored. If no thread is blocked
+      // in wait() there is nobody to wake up and the condition variable can
+      // be left alone: this makes promise completion wait-free in the common
+      // case where the result is consumed through callbacks only. See
+      // ScopedWaiterCount for the ordering argument.
+      if (_p->_waiters.load() == 0)
+        return;
       boost::unique_lock<boost::recursive_mutex> l{_p->_mutex};
       _p->_cond.notify_all();
     }
@@ -10,6 +10,7 @@
 #include <boost/filesystem.hpp>
 #include <boost/bind.hpp>
 
+#include <algorithm>
 #include <sstream>
 #include <iomanip>
 #include <string>
@@ -17,20 +18,132 @@
 #include "log_p.hpp"
 #include <qi/os.hpp>
 #include <cstdio>
+#include <cstring>
 #include <boost/thread/mutex.hpp>
 
+#ifndef _WIN32
+# include <sys/mman.h>
+# include <sys/types.h>
+# include <fcntl.h>
+# include <unistd.h>
+#endif
+
 qiLogCategory("qi.log.headfileloghandler");
 
 namespace qi
 {
 namespace log
 {
+#ifndef _WIN32
+  namespace
+  {
+    size_t pageSize()
+    {
+      static const size_t size = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+      return size;
+    }
+
+    size_t pageAlignDown(size_t value)
+    {
+      return value & ~(pageSize() - 1);
+    }
+
+    size_t pageAlignUp(size_t value)
+    {
+      return pageAlignDown(value + pageSize() - 1);
+    }
+
+    // Unsynced bytes triggering a background writeback of the segment.
+    const size_t msyncChunk = 64u * 1024u;
+  }
+#endif
+
   struct PrivateHeadFileLogHandler
   {
     FILE* _file;
     int _count;
     int _max;
     boost::mutex _mutex;
+
+#ifndef _WIN32
+    // mmap'd backend: the file grows one fixed-size segment at a time and
+    // records are appended with a bump pointer, so the log consumer thread
+    // pays a memcpy per record instead of a write syscall. msync(MS_ASYNC)
+    // schedules writeback in the background every msyncChunk bytes, which
+    // also bounds what a power cut can lose. _file stays the fallback when
+    // the mapping cannot be set up.
+    int _fd = -1;
+    char* _map = nullptr;
+    size_t _segmentSize = 0;
+    size_t _segmentBase = 0; // file offset of the current segment
+    size_t _offset = 0;      // bump pointer within the current segment
+    size_t _synced = 0;      // bytes already handed to msync
+
+    void append(const char* data, size_t size)
+    {
+      while (size > 0)
+      {
+        if (_offset == _segmentSize)
+        {
+          rotateSegment();
+          if (_fd < 0) // rotation failed, the tail of the head is lost
+            return;
+        }
+        const size_t chunk = std::min(size, _segmentSize - _offset);
+        std::memcpy(_map + _offset, data, chunk);
+        _offset += chunk;
+        data += chunk;
+        size -= chunk;
+      }
+      if (_offset - _synced >= msyncChunk)
+      {
+        const size_t from = pageAlignDown(_synced);
+        ::msync(_map + from, _offset - from, MS_ASYNC);
+        _synced = _offset;
+      }
+    }
+
+    // Current segment full: schedule its writeback, grow the file by one
+    // segment and map the new tail.
+    void rotateSegment()
+    {
+      ::msync(_map, _offset, MS_ASYNC);
+      ::munmap(_map, _segmentSize);
+      _map = nullptr;
+      _segmentBase += _segmentSize;
+      _offset = 0;
+      _synced = 0;
+      if (::ftruncate(_fd, static_cast<off_t>(_segmentBase + _segmentSize)) == 0)
+      {
+        void* map = ::mmap(NULL, _segmentSize, PROT_READ | PROT_WRITE, MAP_SHARED,
+                           _fd, static_cast<off_t>(_segmentBase));
+        if (map != MAP_FAILED)
+        {
+          _map = static_cast<char*>(map);
+          return;
+        }
+      }
+      ::close(_fd);
+      _fd = -1;
+    }
+
+    // Unmap, trim the zero padding of the last segment and close.
+    void finalize()
+    {
+      if (_fd < 0)
+        return;
+      if (_map != nullptr)
+      {
+        ::msync(_map, _offset, MS_ASYNC);
+        ::munmap(_map, _segmentSize);
+        _map = nullptr;
+      }
+      if (::ftruncate(_fd, static_cast<off_t>(_segmentBase + _offset)) != 0)
+        qiLogVerbose() << "Cannot trim log file to its final size";
+      ::close(_fd);
+      _fd = -1;
+    }
+#endif
   };
 
   HeadFileLogHandler::HeadFileLogHandler(const std::string& filePath, int length)
@@ -51,6 +164,30 @@ namespace log
     {
       qiLogWarning() << e.what() << std::endl;
     }
+#ifndef _WIN32
+    // Preferred backend: an mmap'd segment appended with a bump pointer.
+    const int fd = ::open(fPath.make_preferred().string().c_str(),
+                          O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd >= 0)
+    {
+      const size_t segment = pageAlignUp(std::max<size_t>(
+          os::getEnvParam<size_t>("QI_LOG_MMAP_SEGMENT_KB", 256) * 1024u,
+          pageSize()));
+      if (::ftruncate(fd, static_cast<off_t>(segment)) == 0)
+      {
+        void* map = ::mmap(NULL, segment, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (map != MAP_FAILED)
+        {
+          _p->_fd = fd;
+          _p->_map = static_cast<char*>(map);
+          _p->_segmentSize = segment;
+          _p->_count = 0;
+          return;
+        }
+      }
+      ::close(fd);
+    }
+#endif
     // Open the file.
     FILE* file = qi::os::fopen(fPath.make_preferred().string().c_str(), "w+");
 
@@ -67,6 +204,9 @@ namespace log
 
   HeadFileLogHandler::~HeadFileLogHandler()
   {
+#ifndef _WIN32
+    _p->finalize();
+#endif
     if (_p->_file != NULL)
       fclose(_p->_file);
     delete _p;
@@ -85,24 +225,38 @@ namespace log
 
     if (_p->_count < _p->_max)
     {
-      if (verb > qi::log::logLevel() || _p->_file == NULL)
+      if (verb > qi::log::logLevel())
+        return;
+      std::string* logline = detail::acquireLogBuffer();
+      qi::detail::logline(*logline, qi::log::context(), date, systemDate, category, msg, file, fct, line, verb);
+#ifndef _WIN32
+      if (_p->_fd >= 0)
       {
+        _p->append(logline->data(), logline->size());
+        _p->_count++;
+        detail::releaseLogBuffer(logline);
         return;
       }
-      else
+#endif
+      if (_p->_file != NULL)
       {
-        std::string logline =
-            qi::detail::logline(qi::log::context(), date, systemDate, category, msg, file, fct, line, verb);
-        fprintf(_p->_file, "%s", logline.c_str());
+        fprintf(_p->_file, "%s", logline->c_str());
         fflush(_p->_file);
 
         _p->_count++;
       }
+      detail::releaseLogBuffer(logline);
     }
-    else if (_p->_file != NULL)
+    else
     {
-      fclose(_p->_file);
-      _p->_file = NULL;
+#ifndef _WIN32
+      _p->finalize();
+#endif
+      if (_p->_file != NULL)
+      {
+        fclose(_p->_file);
+        _p->_file = NULL;
+      }
     }
   }
 }
@@ -7,6 +7,8 @@
 
 #include <boost/config.hpp>
 #include <boost/function.hpp>
+#include <boost/make_shared.hpp>
+#include <boost/shared_ptr.hpp>
 #include <qi/log/journaldloghandler.hpp>
 #include <qi/log.hpp>
 #include <qi/os.hpp>
@@ -15,8 +17,15 @@
 // journaldloghandler.cpp
 #define SD_JOURNAL_SUPPRESS_LOCATION 1
 #include <systemd/sd-journal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
 #include <iostream>
 #include <cstdio>
+#include <string>
+#include <vector>
 
 namespace qi
 {
@@ -47,11 +56,104 @@ namespace log
     // the optimal value for FILE_LEN is 127
     BOOST_STATIC_CONSTEXPR auto FILE_LEN = 127u;
     BOOST_STATIC_CONSTEXPR auto FILE_PREFIX_LEN = sizeof("CODE_FILE=") - 1;
-    char _fileBuffer[FILE_PREFIX_LEN + FILE_LEN + 1u];
-    char _lineBuffer[32u];
-    // extraneous field to pass to journald, if not empty.
-    std::string _identifier;
-    const char *_format; // might be nullptr
+
+    // The mutable state lives behind a shared pointer: the handler is
+    // copied into a boost::function and the copies must share the batch
+    // and the journald socket descriptor.
+    struct State
+    {
+      char fileBuffer[FILE_PREFIX_LEN + FILE_LEN + 1u] = "CODE_FILE=";
+      char lineBuffer[32u] = "CODE_LINE=";
+      // extraneous field to pass to journald, if not empty.
+      std::string identifier;
+      const char* format = nullptr;
+
+      // Batched submission: records are serialized in the native journald
+      // wire format and sent several datagrams per sendmmsg call, instead
+      // of one sd_journal_send round trip per record. fd is the native
+      // journald socket, -1 when unavailable (every record then goes
+      // through sd_journal_send as before).
+      int fd = -1;
+      size_t batchMax = 0;          // records per flush
+      qi::Duration flushDelay{0};   // age forcing a flush, measured
+                                    // against the incoming record dates
+      std::vector<std::string> batch;
+      qi::Clock::time_point oldestDate;
+
+      ~State()
+      {
+        flush();
+        if (fd >= 0)
+          ::close(fd);
+      }
+
+      // One field of the native journald protocol: NAME=value followed by
+      // a newline or, when the value itself contains newlines, NAME, a
+      // newline, the value size as a little-endian 64-bit integer, the
+      // value, and a newline.
+      static void appendField(std::string& entry, const char* name, const char* value)
+      {
+        if (std::strchr(value, '\n') == nullptr)
+        {
+          entry += name;
+          entry += '=';
+          entry += value;
+          entry += '\n';
+          return;
+        }
+        entry += name;
+        entry += '\n';
+        const uint64_t size = std::strlen(value);
+        char sizeLe[8];
+        for (unsigned int i = 0; i < 8u; ++i)
+          sizeLe[i] = static_cast<char>((size >> (8u * i)) & 0xff);
+        entry.append(sizeLe, 8);
+        entry.append(value, size);
+        entry += '\n';
+      }
+
+      void flush()
+      {
+        if (batch.empty())
+          return;
+        // One datagram per record (the protocol has no multi-record
+        // datagrams), but a single syscall submits the whole batch.
+        std::vector<struct iovec> iov(batch.size());
+        std::vector<struct mmsghdr> messages(batch.size());
+        std::memset(messages.data(), 0, messages.size() * sizeof(struct mmsghdr));
+        for (size_t i = 0; i < batch.size(); ++i)
+        {
+          iov[i].iov_base = const_cast<char*>(batch[i].data());
+          iov[i].iov_len = batch[i].size();
+          messages[i].msg_hdr.msg_iov = &iov[i];
+          messages[i].msg_hdr.msg_iovlen = 1;
+        }
+        size_t sent = 0;
+        while (sent < batch.size())
+        {
+          const int n = ::sendmmsg(fd, messages.data() + sent,
+                                   static_cast<unsigned int>(batch.size() - sent), 0);
+          if (n > 0)
+          {
+            sent += static_cast<size_t>(n);
+            continue;
+          }
+          if (errno == EINTR)
+            continue;
+          break;
+        }
+        // One record may be refused (e.g. EMSGSIZE on a huge message)
+        // without condemning the rest of the batch: retry one by one.
+        for (; sent < batch.size(); ++sent)
+        {
+          if (::send(fd, batch[sent].data(), batch[sent].size(), 0) < 0)
+            std::cerr << "Failed to send message to journald." << std::endl;
+        }
+        batch.clear();
+      }
+    };
+    boost::shared_ptr<State> _state;
+
   public:
 
     // identifier: name to use as the SYSLOG_IDENTIFIER field value (aka syslog tag).
@@ -62,10 +164,28 @@ namespace log
     // If identifier is empty, it is not passed to sd_journal_send, in order to
     // let sd_journald_send set SYSLOG_IDENTIFIER itself.
     JournaldLogHandler(std::string identifier)
-      : _fileBuffer{"CODE_FILE="}, // extra bytes are zero-initialized
-        _lineBuffer{"CODE_LINE="}, // extra bytes are zero-initialized
-        _identifier(identifier),
-        _format(identifier.empty() ? nullptr : "SYSLOG_IDENTIFIER=%s") {
+      : _state(boost::make_shared<State>())
+    {
+      _state->identifier = identifier;
+      _state->format = identifier.empty() ? nullptr : "SYSLOG_IDENTIFIER=%s";
+      _state->batchMax = os::getEnvParam<size_t>("QI_JOURNALD_BATCH", 64);
+      _state->flushDelay =
+          qi::MilliSeconds(os::getEnvParam<int64_t>("QI_JOURNALD_FLUSH_MS", 100));
+      if (_state->batchMax > 1)
+      {
+        const int fd = ::socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+        if (fd >= 0)
+        {
+          struct sockaddr_un addr;
+          std::memset(&addr, 0, sizeof(addr));
+          addr.sun_family = AF_UNIX;
+          std::strcpy(addr.sun_path, "/run/systemd/journal/socket");
+          if (::connect(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) == 0)
+            _state->fd = fd;
+          else
+            ::close(fd);
+        }
+      }
     }
 
     /**
@@ -80,7 +200,7 @@ namespace log
      * \param line line number in the issuer file.
      */
     void operator()(const qi::LogLevel verb,
-                    const qi::Clock::time_point /* date */,
+                    const qi::Clock::time_point date,
                     const qi::SystemClock::time_point /* systemDate */,
                     const char* category,
                     const char* msg,
@@ -90,6 +210,7 @@ namespace log
     {
 
       QI_ASSERT(file != nullptr);
+      State& state = *_state;
       const auto priority = toSyslogPriority(verb);
       const bool sendLocation =
 #if defined(NO_QI_LOG_DETAILED_CONTEXT)
@@ -97,21 +218,54 @@ namespace log
 #else
         (*file != '\0');
 #endif
+      if (state.fd >= 0)
+      {
+        if (state.batch.empty())
+          state.oldestDate = date;
+        std::string entry;
+        State::appendField(entry, "MESSAGE", msg);
+        State::appendField(entry, "QI_CATEGORY", category);
+        char numBuffer[32u];
+        std::snprintf(numBuffer, sizeof(numBuffer), "PRIORITY=%i", priority);
+        entry += numBuffer;
+        entry += '\n';
+        entry += "QI=1\n";
+        if (!state.identifier.empty())
+          State::appendField(entry, "SYSLOG_IDENTIFIER", state.identifier.c_str());
+        if (sendLocation)
+        {
+          State::appendField(entry, "CODE_FILE", file);
+          std::snprintf(numBuffer, sizeof(numBuffer), "%i", line);
+          State::appendField(entry, "CODE_LINE", numBuffer);
+          State::appendField(entry, "CODE_FUNC", fct);
+        }
+        state.batch.push_back(std::move(entry));
+        // Errors must reach the journal before a possible crash, and a
+        // quiet process must not hold its last records back forever: flush
+        // on severity and on age. Age is measured against the record dates
+        // so an idle tail only lingers until the next record; the
+        // destructor flushes the very last ones.
+        if (state.batch.size() >= state.batchMax ||
+            verb <= qi::LogLevel_Error ||
+            date - state.oldestDate >= state.flushDelay)
+          state.flush();
+        return;
+      }
       if (sendLocation)
       {
         // do not write to the last byte in file_buffer, to ensure there
         // is null terminating character if strlen(file) == FILE_LEN
-        std::strncpy(_fileBuffer + FILE_PREFIX_LEN, file, FILE_LEN);
-        std::snprintf(_lineBuffer, sizeof(_lineBuffer), "CODE_LINE=%i", line);
+        std::strncpy(state.fileBuffer + FILE_PREFIX_LEN, file, FILE_LEN);
+        std::snprintf(state.lineBuffer, sizeof(state.lineBuffer), "CODE_LINE=%i", line);
         int i = sd_journal_send_with_location(
-                    _fileBuffer,
-                    _lineBuffer,
+                    state.fileBuffer,
+                    state.lineBuffer,
                     fct,
                     "MESSAGE=%s", msg,
                     "QI_CATEGORY=%s", category,
                     "PRIORITY=%i", priority,
                     "QI=1",
-                    _format, _identifier.c_str(),
+                    state.format, state.identifier.c_str(),
                     nullptr);
         if (i == 0)
           return;
@@ -122,7 +276,7 @@ namespace log
                                 "QI_CATEGORY=%s", category,
                                 "PRIORITY=%i", priority,
                                 "QI=1",
-                                _format, _identifier.c_str(),
+                                state.format, state.identifier.c_str(),
                                 nullptr);
         if (i == 0)
           return;
@@ -16,8 +16,10 @@
 #include <qi/log.hpp>
 #include "log_p.hpp"
 #include <qi/os.hpp>
+#include <atomic>
 #include <list>
 #include <map>
+#include <cstdio>
 #include <cstring>
 #include <iomanip>
 #include <iostream>
@@ -34,9 +36,10 @@
 #include <boost/unordered_map.hpp>
 #include <boost/algorithm/string.hpp>
 
-#include <boost/lockfree/queue.hpp>
 #include <boost/function.hpp>
+#include <boost/make_shared.hpp>
 #include <boost/predef.h>
+#include <boost/shared_ptr.hpp>
 
 #ifdef WITH_SYSTEMD
 #include <qi/log/journaldloghandler.hpp>
@@ -68,44 +71,100 @@ qiLogCategory("qi.log");
 namespace qi {
   namespace detail {
 
-    std::string logline(LogContext                         context,
-                        const qi::Clock::time_point        date,
-                        const qi::SystemClock::time_point  systemDate,
-                        const char                        *category,
-                        const char                        *msg,
-                        const char                        *file,
-                        const char                        *fct,
-                        const int                          line,
-                        const qi::LogLevel                 verb)
+    namespace
     {
-      std::stringstream logline;
+      void appendDate(std::string& out, const qi::os::timeval date)
+      {
+        char scratch[32];
+        snprintf(scratch, sizeof(scratch), "%lld.%06lld",
+                 static_cast<long long>(date.tv_sec),
+                 static_cast<long long>(date.tv_usec));
+        out += scratch;
+      }
+
+      void appendTid(std::string& out)
+      {
+        char scratch[32];
+        snprintf(scratch, sizeof(scratch), "%i", qi::os::gettid());
+        out += scratch;
+      }
+    }
 
+    void logline(std::string&                       out,
+                 LogContext                         context,
+                 const qi::Clock::time_point        date,
+                 const qi::SystemClock::time_point  systemDate,
+                 const char                        *category,
+                 const char                        *msg,
+                 const char                        *file,
+                 const char                        *fct,
+                 const int                          line,
+                 const qi::LogLevel                 verb)
+    {
       if (context & qi::LogContextAttr_Verbosity)
-        logline << qi::log::logLevelToString(verb) << " ";
+      {
+        out += qi::log::logLevelToString(verb);
+        out += ' ';
+      }
       if (context & qi::LogContextAttr_ShortVerbosity)
-        logline << qi::log::logLevelToString(verb, false) << " ";
+      {
+        out += qi::log::logLevelToString(verb, false);
+        out += ' ';
+      }
       if (context & qi::LogContextAttr_Date)
-        logline << qi::detail::dateToString(date) << " ";
+      {
+        appendDate(out, qi::os::timeval(date.time_since_epoch()));
+        out += ' ';
+      }
       if (context & qi::LogContextAttr_SystemDate)
-        logline << qi::detail::dateToString(systemDate) << " ";
+      {
+        appendDate(out, qi::os::timeval(systemDate.time_since_epoch()));
+        out += ' ';
+      }
       if (context & qi::LogContextAttr_Tid)
-        logline << qi::detail::tidToString() << " ";
+      {
+        appendTid(out);
+        out += ' ';
+      }
       if (context & qi::LogContextAttr_Category)
-        logline << category << ": ";
+      {
+        out += category;
+        out += ": ";
+      }
       if (context & qi::LogContextAttr_File) {
-        logline << file;
+        out += file;
         if (line != 0)
-          logline << "(" << line << ")";
-        logline << " ";
+        {
+          char scratch[16];
+          snprintf(scratch, sizeof(scratch), "(%i)", line);
+          out += scratch;
+        }
+        out += ' ';
       }
       if (context & qi::LogContextAttr_Function)
-        logline << fct << "() ";
+      {
+        out += fct;
+        out += "() ";
+      }
       if (context & qi::LogContextAttr_Return)
-        logline << std::endl;
-      logline.write(msg, static_cast<std::streamsize>(qi::detail::rtrim(msg)));
-      logline << std::endl;
+        out += '\n';
+      out.append(msg, qi::detail::rtrim(msg));
+      out += '\n';
+    }
 
-      return logline.str();
+    std::string logline(LogContext                         context,
+                        const qi::Clock::time_point        date,
+                        const qi::SystemClock::time_point  systemDate,
+                        const char                        *category,
+                        const char                        *msg,
+                        const char                        *file,
+                        const char                        *fct,
+                        const int                          line,
+                        const qi::LogLevel                 verb)
+    {
+      std::string out;
+      logline(out, context, date, systemDate, category, msg, file, fct, line, verb);
+      return out;
     }
 
     std::string logline(LogContext             context,
@@ -190,20 +249,16 @@ namespace qi {
 
     const std::string dateToString(const qi::os::timeval date)
     {
-      std::stringstream ss;
-      ss << date.tv_sec << "."
-        << std::setw(6) << std::setfill('0') << date.tv_usec;
-
-      return ss.str();
+      std::string out;
+      appendDate(out, date);
+      return out;
     }
 
     const std::string tidToString()
     {
-      int tid = qi::os::gettid();
-      std::stringstream ss;
-      ss << tid;
-
-      return ss.str();
+      std::string out;
+      appendTid(out);
+      return out;
     }
 
     /* Emulate previous behavior that ensured a single newline was
@@ -241,6 +296,107 @@ namespace qi {
       char                       _log[LOG_SIZE];
       qi::Clock::time_point       _date;
       qi::SystemClock::time_point _systemDate;
+      // Non-null format marks a deferred statement: _log is unused and the
+      // consumer formats the record when dispatching.
+      detail::DeferredLogRecord   _record;
+    };
+
+    /* Bounded MPSC ring buffer for the async log path (Vyukov bounded queue
+     * with per-cell sequence numbers, single consumer). Producers claim a
+     * cell with a couple of atomic operations and never take a lock, so a
+     * burst of logging from one thread cannot block the others. The consumer
+     * side (printLog) is serialized by the handler locks.
+     *
+     * When the ring is full the behavior depends on QI_LOG_OVERFLOW: "block"
+     * makes the producer spin for a free cell, anything else (the default)
+     * counts the message as dropped, which the consumer reports. The previous
+     * implementation claimed slots with a non-atomic increment on a volatile
+     * counter and could corrupt or silently overwrite entries under
+     * contention.
+     */
+    class LogQueue
+    {
+    public:
+      struct Cell
+      {
+        std::atomic<unsigned long> sequence;
+        privateLog data;
+      };
+
+      LogQueue()
+      {
+        for (unsigned long i = 0; i < RTLOG_BUFFERS; ++i)
+          _cells[i].sequence.store(i, std::memory_order_relaxed);
+      }
+
+      /// Claims a free cell, or returns null when the ring is full.
+      /// publish() must be called on the result once the payload is filled.
+      Cell* tryClaim()
+      {
+        unsigned long pos = _enqueuePos.load(std::memory_order_relaxed);
+        for (;;)
+        {
+          Cell& cell = _cells[pos % RTLOG_BUFFERS];
+          const unsigned long seq = cell.sequence.load(std::memory_order_acquire);
+          const long dif = static_cast<long>(seq) - static_cast<long>(pos);
+          if (dif == 0)
+          {
+            if (_enqueuePos.compare_exchange_weak(pos, pos + 1,
+                                                  std::memory_order_relaxed))
+              return &cell;
+          }
+          else if (dif < 0)
+          {
+            return nullptr; // full
+          }
+          else
+          {
+            pos = _enqueuePos.load(std::memory_order_relaxed);
+          }
+        }
+      }
+
+      /// Makes a claimed cell visible to the consumer.
+      void publish(Cell* cell)
+      {
+        // Between claim and publish the sequence still holds the claimed
+        // position and only this producer owns the cell.
+        cell->sequence.store(cell->sequence.load(std::memory_order_relaxed) + 1,
+                             std::memory_order_release);
+      }
+
+      /// Next published cell, or null when the ring is empty. release() must
+      /// be called once the entry has been dispatched. Consumer side only.
+      Cell* tryPop()
+      {
+        const unsigned long pos = _dequeuePos.load(std::memory_order_relaxed);
+        Cell& cell = _cells[pos % RTLOG_BUFFERS];
+        if (cell.sequence.load(std::memory_order_acquire) != pos + 1)
+          return nullptr;
+        return &cell;
+      }
+
+      /// Recycles the cell returned by the last tryPop(). Consumer side only.
+      void release()
+      {
+        const unsigned long pos = _dequeuePos.load(std::memory_order_relaxed);
+        _cells[pos % RTLOG_BUFFERS].sequence.store(pos + RTLOG_BUFFERS,
+                                                   std::memory_order_release);
+        _dequeuePos.store(pos + 1, std::memory_order_relaxed);
+      }
+
+      bool empty() { return tryPop() == nullptr; }
+
+      void countDrop() { _dropped.fetch_add(1, std::memory_order_relaxed); }
+      unsigned long takeDropped() { return _dropped.exchange(0, std::memory_order_relaxed); }
+
+    private:
+      Cell _cells[RTLOG_BUFFERS];
+      std::atomic<unsigned long> _enqueuePos{0};
+      // Mutated by the lock-serialized consumer only; atomic because the
+      // async thread's wait predicate reads it without those locks.
+      std::atomic<unsigned long> _dequeuePos{0};
+      std::atomic<unsigned long> _dropped{0};
     };
 
     class Log
@@ -286,7 +442,7 @@ namespace qi {
       bool                       SyncLog;
       bool                       AsyncLogInit;
 
-      boost::lockfree::queue<privateLog*>     logs;
+      LogQueue                   logs;
 
       using LogHandlerMap = std::map<std::string, Handler>;
       LogHandlerMap logHandlers;
@@ -325,6 +481,19 @@ namespace qi {
       return *_glCategories;
     }
 
+    // Read-side snapshot of the category map, republished under _mutex()
+    // after every insertion. Looking up an existing category is then one
+    // atomic load plus a map find, with no lock: the registry is
+    // insert-only and Category objects are never deleted, and level changes
+    // mutate the categories in place so the snapshot never goes stale.
+    inline boost::shared_ptr<const CategoryMap>& _categoriesSnapshot()
+    {
+      static boost::shared_ptr<const CategoryMap>* _glSnapshot;
+      QI_ONCE(_glSnapshot = new boost::shared_ptr<const CategoryMap>(
+          boost::make_shared<CategoryMap>()));
+      return *_glSnapshot;
+    }
+
     // protects globs and categories, both the map and the per-category vector
     inline boost::recursive_mutex& _mutex()
     {
@@ -338,8 +507,6 @@ namespace qi {
     static LogColor               _glColorWhen = LogColor_Auto;
 
     static Log                   *LogInstance = nullptr;
-    static privateLog             LogBuffer[RTLOG_BUFFERS];
-    static volatile unsigned long LogPush = 0;
 
     namespace detail {
 
@@ -564,6 +731,56 @@ namespace qi {
             return result;
           }
       }
+
+      namespace
+      {
+        /* Per-thread freelist of formatting buffers for LogStream and the
+         * handlers. A couple of buffers per thread is enough: depth only
+         * grows when formatting an argument of a log statement itself logs.
+         * The pool is a plain thread_local so it can already be dead during
+         * static destruction; acquire and release then degrade to plain
+         * new/delete, like the FormatMap ward above.
+         */
+        struct LogBufferPool
+        {
+          std::vector<std::string*> items;
+          bool alive = true;
+          ~LogBufferPool()
+          {
+            alive = false;
+            for (auto* s: items)
+              delete s;
+            items.clear();
+          }
+        };
+        thread_local LogBufferPool logBufferPool;
+        const size_t logBufferPoolMaxSize = 8;
+        // Do not let one huge formatted message pin its capacity forever.
+        const size_t logBufferMaxRetainedCapacity = 64 * 1024;
+      }
+
+      std::string* acquireLogBuffer()
+      {
+        LogBufferPool& pool = logBufferPool;
+        if (!pool.alive || pool.items.empty())
+          return new std::string;
+        std::string* buffer = pool.items.back();
+        pool.items.pop_back();
+        return buffer;
+      }
+
+      void releaseLogBuffer(std::string* buffer)
+      {
+        LogBufferPool& pool = logBufferPool;
+        if (!pool.alive || pool.items.size() >= logBufferPoolMaxSize ||
+            buffer->capacity() > logBufferMaxRetainedCapacity)
+        {
+          delete buffer;
+          return;
+        }
+        buffer->clear();
+        pool.items.push_back(buffer);
+      }
     }
 
     namespace detail {
@@ -584,7 +801,8 @@ namespace qi {
           }
         }
         levels[sub] = level;
-        maxLevel = *std::max_element(levels.begin(), levels.end());
+        maxLevel.store(*std::max_element(levels.begin(), levels.end()),
+                       std::memory_order_relaxed);
       }
     }
 
@@ -651,17 +869,45 @@ namespace qi {
       }
     } synchLog;
 
-    void Log::printLog()
+    // Builds the message of a deferred statement; runs on the consumer side.
+    static void formatDeferredRecord(const detail::DeferredLogRecord& record, std::string& out)
     {
-      privateLog* pl = nullptr;
+      boost::format fmt = detail::getFormat(record.format);
+      for (unsigned int i = 0; i < record.argCount; ++i)
+        record.args[i].apply(fmt, record.args[i].storage);
+      out = boost::str(fmt);
+    }
 
+    void Log::printLog()
+    {
       boost::recursive_mutex::scoped_lock lock(_mutex(), boost::defer_lock);
       boost::mutex::scoped_lock lockHandlers(LogInstance->LogHandlerLock, boost::defer_lock);
       boost::lock(lock, lockHandlers);
-      while (logs.pop(pl))
+      while (LogQueue::Cell* cell = logs.tryPop())
       {
-        dispatch_unsynchronized(pl->_logLevel, pl->_date, pl->_systemDate, pl->_category, pl->_log,
-                                pl->_file, pl->_function, pl->_line);
+        const privateLog* pl = &cell->data;
+        if (pl->_record.format)
+        {
+          std::string* buf = detail::acquireLogBuffer();
+          formatDeferredRecord(pl->_record, *buf);
+          dispatch_unsynchronized(pl->_logLevel, pl->_date, pl->_systemDate, pl->_category,
+                                  buf->c_str(), pl->_file, pl->_function, pl->_line);
+          detail::releaseLogBuffer(buf);
+        }
+        else
+        {
+          dispatch_unsynchronized(pl->_logLevel, pl->_date, pl->_systemDate, pl->_category,
+                                  pl->_log, pl->_file, pl->_function, pl->_line);
+        }
+        logs.release();
+      }
+      const unsigned long dropped = logs.takeDropped();
+      if (dropped)
+      {
+        char msg[64];
+        snprintf(msg, sizeof(msg), "%lu log message(s) dropped (queue full)", dropped);
+        dispatch_unsynchronized(qi::LogLevel_Warning, qi::Clock::now(), qi::SystemClock::now(),
+                                "qi.log", msg, __FILE__, __FUNCTION__, __LINE__);
       }
     }
 
@@ -726,7 +972,6 @@ namespace qi {
     inline Log::Log() :
       SyncLog(true),
       AsyncLogInit(false)
-      , logs(50)
     {
       LogInit = true;
     }
@@ -823,6 +1068,79 @@ namespace qi {
       ::qi::log::detail::log(verb, NULL, categoryStr, msg, file, fct, line);
     }
 
+    // Claims a cell of the async ring, honoring the QI_LOG_OVERFLOW policy.
+    // Returns null when the message must be dropped (already counted).
+    static LogQueue::Cell* claimLogCell()
+    {
+      LogQueue::Cell* cell = LogInstance->logs.tryClaim();
+      if (!cell)
+      {
+        static const bool blockOnFull =
+            qi::os::getEnvParam<std::string>("QI_LOG_OVERFLOW", "drop") == "block";
+        if (!blockOnFull)
+        {
+          LogInstance->logs.countDrop();
+          // the consumer has a full ring to drain anyway
+          LogInstance->LogReadyCond.notify_one();
+          return nullptr;
+        }
+        do
+        {
+          boost::this_thread::yield();
+          cell = LogInstance->logs.tryClaim();
+        } while (!cell);
+      }
+      return cell;
+    }
+
+    void log(const qi::LogLevel              verb,
+             CategoryType                    category,
+             const detail::DeferredLogRecord& record,
+             const char                     *file,
+             const char                     *fct,
+             const int                       line)
+    {
+      if (!isVisible(category, verb))
+        return;
+      if (!LogInstance || !LogInstance->LogInit)
+        return;
+
+      qi::Clock::time_point date = qi::Clock::nowCoarse();
+      qi::SystemClock::time_point systemDate = qi::SystemClock::now();
+      if (LogInstance->SyncLog)
+      {
+        // No consumer thread to defer to: format on the spot and dispatch.
+        std::string* buf = detail::acquireLogBuffer();
+        formatDeferredRecord(record, *buf);
+        boost::recursive_mutex::scoped_lock lock(_mutex(), boost::defer_lock);
+        boost::mutex::scoped_lock lockHandlers(LogInstance->LogHandlerLock, boost::defer_lock);
+        boost::lock(lock, lockHandlers);
+        LogInstance->dispatch_unsynchronized(verb, date, systemDate, *category, buf->c_str(),
+                                             file, fct, line);
+        detail::releaseLogBuffer(buf);
+      }
+      else
+      {
+        LogQueue::Cell* cell = claimLogCell();
+        if (!cell)
+          return;
+        privateLog* pl = &cell->data;
+
+        pl->_logLevel = verb;
+        pl->_line = line;
+        pl->_date = date;
+        pl->_systemDate = systemDate;
+
+        my_strcpy(pl->_category, category->name.c_str(), CAT_SIZE);
+        my_strcpy(pl->_file, file, FILE_SIZE);
+        my_strcpy(pl->_function, fct, FUNC_SIZE);
+        pl->_log[0] = '\0';
+        pl->_record = record;
+        LogInstance->logs.publish(cell);
+        LogInstance->LogReadyCond.notify_one();
+      }
+    }
+
     void detail::log(const qi::LogLevel    verb,
                      CategoryType          category,
                      const char           *categoryStr,
@@ -836,7 +1154,9 @@ namespace qi {
       if (!LogInstance->LogInit)
         return;
 
-      qi::Clock::time_point date = qi::Clock::now();
+      // Log records only need tick-level precision; the coarse read avoids
+      // a clock syscall per message on platforms without a steady vDSO path.
+      qi::Clock::time_point date = qi::Clock::nowCoarse();
       qi::SystemClock::time_point systemDate = qi::SystemClock::now();
       if (LogInstance->SyncLog)
       {
@@ -852,8 +1172,10 @@ namespace qi {
       }
       else
       {
-        int tmpRtLogPush = ++LogPush % RTLOG_BUFFERS;
-        privateLog* pl = &(LogBuffer[tmpRtLogPush]);
+        LogQueue::Cell* cell = claimLogCell();
+        if (!cell)
+          return;
+        privateLog* pl = &cell->data;
 
         pl->_logLevel = verb;
         pl->_line = line;
@@ -864,7 +1186,8 @@ namespace qi {
         my_strcpy(pl->_file, file, FILE_SIZE);
         my_strcpy(pl->_function, fct, FUNC_SIZE);
         my_strcpy(pl->_log, msg, LOG_SIZE);
-        LogInstance->logs.push(pl);
+        pl->_record.format = nullptr;
+        LogInstance->logs.publish(cell);
         LogInstance->LogReadyCond.notify_one();
       }
     }
@@ -1023,6 +1346,15 @@ namespace qi {
 
     CategoryType addCategory(const std::string& name)
     {
+      // Fast path: the category already exists (qiLogCategory macros from
+      // every module funnel here during startup, often concurrently).
+      {
+        const boost::shared_ptr<const CategoryMap> snapshot =
+            boost::atomic_load(&_categoriesSnapshot());
+        const CategoryMap::const_iterator i = snapshot->find(name);
+        if (i != snapshot->end())
+          return i->second;
+      }
       boost::recursive_mutex::scoped_lock lock(_mutex());
       CategoryMap& c = _categories();
       CategoryMap::iterator i = c.find(name);
@@ -1031,6 +1363,9 @@ namespace qi {
         detail::Category* res = new detail::Category(name);
         c[name] = res;
         checkGlobs(res);
+        boost::atomic_store(&_categoriesSnapshot(),
+                            boost::shared_ptr<const CategoryMap>(
+                                boost::make_shared<CategoryMap>(c)));
         return res;
       }
       else
@@ -17,6 +17,21 @@ namespace qi
 {
   namespace detail
   {
+    // Appends the formatted record to out (which is not cleared first).
+    // Handlers that reuse one warm buffer per record pay no allocation for
+    // the formatting; the std::string-returning overload below wraps this.
+    void logline(std::string&                       out,
+                 LogContext                         context,
+                 const qi::Clock::time_point        date,
+                 const qi::SystemClock::time_point  systemDate,
+                 const char                        *category,
+                 const char                        *msg,
+                 const char                        *file,
+                 const char                        *fct,
+                 const int                          line,
+                 const qi::LogLevel                 verb
+                 );
+
     // export so we can test it
     std::string logline(LogContext                         context,
                         const qi::Clock::time_point        date,
@@ -0,0 +1,18 @@
+/*
+**  Copyright (C) 2018 Aldebaran Robotics
+**  See COPYING for the license
+*/
+
+#include <qi/memorystats.hpp>
+
+namespace qi
+{
+  MemoryStats memoryStats()
+  {
+    MemoryStats stats;
+    detail::bufferMemoryStats(stats);
+    detail::futureMemoryStats(stats);
+    detail::socketMemoryStats(stats);
+    return stats;
+  }
+}
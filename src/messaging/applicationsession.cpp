@@ -9,6 +9,7 @@
 #include <qi/trackable.hpp>
 #include <qi/applicationsession.hpp>
 #include <qi/anyvalue.hpp>
+#include <qi/detail/futurebarrier.hpp>
 #include <qi/log.hpp>
 
 qiLogCategory("qi.applicationsession");
@@ -326,6 +327,57 @@ void ApplicationSession::startSession()
   _p->connect();
 }
 
+namespace
+{
+  // Collect the outcome of concurrent per-service operations into one
+  // future: set once all are done, in error with the names of the failures.
+  template <typename T>
+  qi::Future<void> mergeServiceResults(const std::string& what,
+                                       const std::vector<std::string>& names,
+                                       std::vector<qi::Future<T>>& futures)
+  {
+    return qi::waitForAll(futures).async().andThen(
+        [what, names](const std::vector<qi::Future<T>>& results) {
+          std::string failures;
+          for (size_t i = 0; i < results.size(); ++i)
+          {
+            if (!results[i].hasError())
+              continue;
+            if (!failures.empty())
+              failures += ", ";
+            failures += names[i] + ": " + results[i].error();
+          }
+          if (!failures.empty())
+            throw std::runtime_error("failed to " + what + " services: " + failures);
+        });
+  }
+}
+
+qi::FutureSync<void> ApplicationSession::registerServices(
+    const std::vector<std::pair<std::string, AnyObject>>& services)
+{
+  std::vector<std::string> names;
+  std::vector<qi::Future<unsigned int>> futures;
+  names.reserve(services.size());
+  futures.reserve(services.size());
+  for (const auto& service: services)
+  {
+    names.push_back(service.first);
+    futures.push_back(_p->_session->registerService(service.first, service.second).async());
+  }
+  return mergeServiceResults("register", names, futures);
+}
+
+qi::FutureSync<void> ApplicationSession::waitForServices(
+    const std::vector<std::string>& services)
+{
+  std::vector<qi::Future<void>> futures;
+  futures.reserve(services.size());
+  for (const auto& service: services)
+    futures.push_back(_p->_session->waitForService(service).async());
+  return mergeServiceResults("wait for", services, futures);
+}
+
 void ApplicationSession::run()
 {
   if(!_p->_session->isConnected())
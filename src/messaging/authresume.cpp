@@ -0,0 +1,96 @@
+/*
+**  Copyright (C) 2018 Softbank Robotics
+**  See COPYING for the license
+*/
+
+#include <map>
+
+#include <boost/thread/mutex.hpp>
+
+#include <qi/clock.hpp>
+#include <qi/messaging/authprovider.hpp>
+#include <qi/os.hpp>
+
+#include "authresume.hpp"
+
+namespace qi
+{
+namespace auth_resume
+{
+  const std::string TokenKey = AuthProvider::QiAuthPrefix + "resume_token";
+
+  namespace
+  {
+    Seconds tokenLifetime()
+    {
+      static const auto seconds = os::getEnvParam<int64_t>("QI_AUTH_RESUME_TTL", 300);
+      return Seconds{seconds};
+    }
+
+    boost::mutex issuedMutex;
+    // Tokens this process handed out, with their expiry. Bounded by the
+    // lifetime: expired entries are swept on every issue.
+    std::map<std::string, SteadyClockTimePoint> issuedTokens;
+
+    boost::mutex storedMutex;
+    // Tokens received from servers, keyed by endpoint.
+    std::map<std::string, std::string> storedTokens;
+  }
+
+  bool enabled()
+  {
+    return tokenLifetime() != Seconds::zero();
+  }
+
+  std::string issueToken()
+  {
+    const std::string token = os::generateUuid();
+    const auto now = SteadyClock::now();
+    boost::mutex::scoped_lock lock(issuedMutex);
+    for (auto it = issuedTokens.begin(); it != issuedTokens.end();)
+    {
+      if (it->second <= now)
+        it = issuedTokens.erase(it);
+      else
+        ++it;
+    }
+    issuedTokens[token] = now + tokenLifetime();
+    return token;
+  }
+
+  bool redeemToken(const std::string& token)
+  {
+    boost::mutex::scoped_lock lock(issuedMutex);
+    const auto it = issuedTokens.find(token);
+    if (it == issuedTokens.end())
+      return false;
+    if (it->second <= SteadyClock::now())
+    {
+      issuedTokens.erase(it);
+      return false;
+    }
+    return true;
+  }
+
+  void rememberToken(const std::string& endpoint, const std::string& token)
+  {
+    boost::mutex::scoped_lock lock(storedMutex);
+    storedTokens[endpoint] = token;
+  }
+
+  std::string tokenFor(const std::string& endpoint)
+  {
+    if (!enabled())
+      return std::string();
+    boost::mutex::scoped_lock lock(storedMutex);
+    const auto it = storedTokens.find(endpoint);
+    return it != storedTokens.end() ? it->second : std::string();
+  }
+
+  void forgetToken(const std::string& endpoint)
+  {
+    boost::mutex::scoped_lock lock(storedMutex);
+    storedTokens.erase(endpoint);
+  }
+}
+}
@@ -0,0 +1,50 @@
+#pragma once
+/*
+**  Copyright (C) 2018 Softbank Robotics
+**  See COPYING for the license
+*/
+
+#ifndef _SRC_MESSAGING_AUTHRESUME_HPP_
+#define _SRC_MESSAGING_AUTHRESUME_HPP_
+
+#include <string>
+
+namespace qi
+{
+  /// Resumable authentication: when a client completes the full exchange,
+  /// the server hands it an opaque token along with the State_Done reply.
+  /// Replaying that token in the first authentication message of a later
+  /// connection concludes the exchange in a single round trip, without
+  /// going through the authentication provider again.
+  ///
+  /// The token is a bearer credential: within its lifetime
+  /// (QI_AUTH_RESUME_TTL seconds, default 300, 0 disables the whole
+  /// mechanism) it is as good as the credentials that earned it, so it only
+  /// ever travels inside the authentication capability map.
+  namespace auth_resume
+  {
+    /// Key of the token in the authentication capability map.
+    extern const std::string TokenKey;
+
+    bool enabled();
+
+    // Server side
+
+    /// A fresh token, remembered until its lifetime elapses.
+    std::string issueToken();
+    /// True when the token was issued here and is still valid. The token
+    /// stays valid until its lifetime elapses, so several sockets of the
+    /// same client can resume with it concurrently.
+    bool redeemToken(const std::string& token);
+
+    // Client side: tokens received from servers, keyed by endpoint.
+
+    void rememberToken(const std::string& endpoint, const std::string& token);
+    /// The stored token for this endpoint, or an empty string.
+    std::string tokenFor(const std::string& endpoint);
+    /// Drop the stored token, after the server refused it.
+    void forgetToken(const std::string& endpoint);
+  }
+}
+
+#endif  // _SRC_MESSAGING_AUTHRESUME_HPP_
@@ -3,11 +3,19 @@
 **  See COPYING for the license
 */
 
+#include <cstring>
+
 #include <boost/make_shared.hpp>
 
 #include <qi/anyobject.hpp>
+#include <qi/binarycodec.hpp>
+#include <qi/eventloop.hpp>
+#include <qi/getenv.hpp>
+#include <qi/detail/futurebarrier.hpp>
+#include <qi/type/dynamicobject.hpp>
 #include <qi/type/objecttypebuilder.hpp>
 #include "boundobject.hpp"
+#include "remoteobject_p.hpp"
 
 qiLogCategory("qimessaging.boundobject");
 
@@ -15,19 +23,64 @@ const auto invalidValueError = "The value is invalid.";
 
 namespace qi {
 
-  static AnyReference forwardEvent(const GenericFunctionParameters& params,
+  /* Batched reclamation of call artifacts.
+   *
+   * Destroying the deserialized arguments and the result of a dispatched
+   * call walks the whole value tree, and nothing on the dispatch or reply
+   * path reads them afterwards: it is pure cleanup. Instead of paying the
+   * walk inline, hand the values to a queue drained in one batch on the
+   * thread pool so the hot path ends at reply enqueue. Values served by
+   * the dispatch arena keep their chunks alive until the drain runs,
+   * which the arena explicitly supports.
+   */
+  namespace {
+    boost::mutex deferredDestroyMutex;
+    std::vector<AnyReference> deferredDestroyQueue;
+    bool deferredDrainScheduled = false;
+
+    void drainDeferredDestroy()
+    {
+      std::vector<AnyReference> batch;
+      {
+        boost::mutex::scoped_lock lock(deferredDestroyMutex);
+        batch.swap(deferredDestroyQueue);
+        deferredDrainScheduled = false;
+      }
+      for (AnyReference& val: batch)
+        val.destroy();
+    }
+
+    void deferDestroy(AnyReference val)
+    {
+      if (!val.isValid())
+        return;
+      bool mustSchedule = false;
+      {
+        boost::mutex::scoped_lock lock(deferredDestroyMutex);
+        deferredDestroyQueue.push_back(val);
+        if (!deferredDrainScheduled)
+        {
+          deferredDrainScheduled = true;
+          mustSchedule = true;
+        }
+      }
+      if (mustSchedule)
+        qi::getEventLoop()->post(&drainDeferredDestroy);
+    }
+  }
+
+  static Message buildEventMessage(const GenericFunctionParameters& params,
                                    unsigned int service, unsigned int object,
-                                   unsigned int event, Signature sig,
-                                   MessageSocketPtr client,
+                                   unsigned int event, const Signature& sig,
+                                   const MessageSocketPtr& client,
                                    boost::weak_ptr<ObjectHost> context,
                                    const std::string& signature)
   {
-    qiLogDebug() << "forwardEvent";
     qi::Message msg;
     // FIXME: would like to factor with serveresult.hpp convertAndSetValue()
     // but we have a setValue/setValues issue
     bool processed = false;
-    if (!signature.empty() && client->remoteCapability("MessageFlags", false))
+    if (!signature.empty() && client && client->remoteCapability("MessageFlags", false))
     {
       qiLogDebug() << "forwardEvent attempting conversion to " << signature;
       try
@@ -65,7 +118,7 @@ namespace qi {
       catch (const std::exception& e)
       {
         qiLogVerbose() << "forwardEvent::setValues exception: " << e.what();
-        if (!client->remoteCapability("MessageFlags", false))
+        if (!client || !client->remoteCapability("MessageFlags", false))
           throw e;
         // Delegate conversion to the remote end.
         msg.addFlags(Message::TypeFlag_DynamicPayload);
@@ -76,7 +129,261 @@ namespace qi {
     msg.setFunction(event);
     msg.setType(Message::Type_Event);
     msg.setObject(object);
-    client->send(std::move(msg));
+    return msg;
+  }
+
+  /* Delta-event encoding (capabilityname::deltaEvents): when every
+   * subscriber advertises the capability and the event carries a single
+   * struct, each field is serialized on its own and diffed against the
+   * previous payload; only the changed fields travel, prefixed by a 32-bit
+   * change mask (TypeFlag_DeltaPayload). Full keyframes go out when the
+   * subscriber set changes, every QI_DELTA_EVENT_KEYFRAME events, or when
+   * every field changed anyway. Sends happen under the fanout mutex so the
+   * delta chain matches the order the messages are queued in; TCP then
+   * delivers them in order, which is why no acknowledgment is needed.
+   * Returns true when the event was sent (delta or keyframe); false hands
+   * it back to the regular paths.
+   */
+  static bool trySendDeltaEvent(const GenericFunctionParameters& params,
+                                unsigned int service, unsigned int object,
+                                unsigned int event, const Signature& sig,
+                                EventFanout& fanout,
+                                const std::vector<MessageSocketPtr>& clients,
+                                boost::weak_ptr<ObjectHost> context)
+  {
+    static const int keyframePeriod =
+        qi::os::getEnvDefault("QI_DELTA_EVENT_KEYFRAME", 100);
+    if (params.size() != 1)
+      return false;
+    TypeInterface* type = params[0].type();
+    if (!type || type->kind() != TypeKind_Tuple)
+      return false;
+    StructTypeInterface* structType = static_cast<StructTypeInterface*>(type);
+    const std::vector<TypeInterface*> members = structType->memberTypes();
+    if (members.empty() || members.size() > 32)
+      return false;
+
+    boost::mutex::scoped_lock lock(fanout.socketsMutex);
+    EventFanout::DeltaState& state = fanout.delta;
+
+    // Re-check subscriber support only when the subscriber set changes; a
+    // new subscriber also invalidates the state since it needs a keyframe
+    // before any delta.
+    bool sameClients = state.clients.size() == clients.size();
+    for (unsigned i = 0; sameClients && i < clients.size(); ++i)
+      sameClients = state.clients[i] == clients[i].get();
+    if (!sameClients)
+    {
+      state.clients.clear();
+      state.clients.reserve(clients.size());
+      state.fieldPayloads.clear();
+      state.clientsSupportDelta = !clients.empty();
+      for (const auto& client: clients)
+      {
+        state.clients.push_back(client.get());
+        if (!client->sharedCapabilityFlag(StreamContext::SharedCapability_DeltaEvents))
+          state.clientsSupportDelta = false;
+      }
+    }
+    if (!state.clientsSupportDelta)
+      return false;
+
+    // Serialize each field on its own so the payload can be diffed against
+    // the previous one and cached for the next.
+    std::vector<qi::Buffer> payloads(members.size());
+    try
+    {
+      for (unsigned i = 0; i < members.size(); ++i)
+        encodeBinary(&payloads[i],
+                     AnyReference(members[i], structType->get(params[0].rawValue(), i)));
+    }
+    catch (const std::exception& e)
+    {
+      qiLogDebug() << "delta event field serialization failed: " << e.what();
+      state.fieldPayloads.clear();
+      return false;
+    }
+
+    uint32_t mask = 0;
+    bool sendDelta = state.fieldPayloads.size() == members.size() &&
+                     state.deltasSinceKeyframe < keyframePeriod;
+    if (sendDelta)
+    {
+      for (unsigned i = 0; i < members.size(); ++i)
+      {
+        const qi::Buffer& current = payloads[i];
+        const qi::Buffer& previous = state.fieldPayloads[i];
+        if (current.size() != previous.size() ||
+            std::memcmp(current.data(), previous.data(), current.size()) != 0)
+          mask |= uint32_t(1) << i;
+      }
+      const uint32_t allFields = members.size() == 32 ?
+          ~uint32_t(0) : (uint32_t(1) << members.size()) - 1;
+      if (mask == allFields)
+        sendDelta = false; // a delta of every field costs more than the payload
+    }
+
+    qi::Message msg;
+    if (sendDelta)
+    {
+      qi::Buffer buf;
+      encodeBinary(&buf, AnyReference::from(mask));
+      for (unsigned i = 0; i < members.size(); ++i)
+        if (mask & (uint32_t(1) << i))
+          buf.write(payloads[i].data(), payloads[i].size());
+      msg.setBuffer(std::move(buf));
+      msg.setService(service);
+      msg.setFunction(event);
+      msg.setType(Message::Type_Event);
+      msg.setObject(object);
+      msg.addFlags(Message::TypeFlag_DeltaPayload);
+      ++state.deltasSinceKeyframe;
+    }
+    else
+    {
+      try
+      {
+        msg = buildEventMessage(params, service, object, event, sig,
+                                MessageSocketPtr(), context, std::string());
+      }
+      catch (const std::exception& e)
+      {
+        qiLogDebug() << "delta event keyframe serialization failed: " << e.what();
+        state.fieldPayloads.clear();
+        return false;
+      }
+      state.deltasSinceKeyframe = 0;
+    }
+    state.fieldPayloads = std::move(payloads);
+    for (const auto& client: clients)
+      client->send(msg); // by-value: each destination gets its own header
+    return true;
+  }
+
+  static AnyReference forwardEvent(const GenericFunctionParameters& params,
+                                   unsigned int service, unsigned int object,
+                                   unsigned int event, Signature sig,
+                                   EventFanoutPtr fanout,
+                                   boost::weak_ptr<ObjectHost> context,
+                                   const std::string& signature)
+  {
+    qiLogDebug() << "forwardEvent";
+    std::vector<MessageSocketPtr> clients;
+    std::vector<MessageSocketPtr> heldBack; // over their window, coalescing
+    bool filtered = false;
+    {
+      boost::mutex::scoped_lock lock(fanout->socketsMutex);
+      const bool rateLimited = !fanout->rateLimits.empty();
+      filtered = rateLimited || !fanout->flowControls.empty();
+      const qi::SteadyClockTimePoint now =
+          rateLimited ? qi::SteadyClock::now() : qi::SteadyClockTimePoint();
+      clients.reserve(fanout->sockets.size());
+      for (const auto& socketAndCount: fanout->sockets)
+      {
+        if (rateLimited)
+        {
+          auto rit = fanout->rateLimits.find(socketAndCount.first);
+          if (rit != fanout->rateLimits.end())
+          {
+            if (now < rit->second.nextDue)
+              continue; // throttled: drop this event for this subscriber
+            rit->second.nextDue = now + rit->second.minInterval;
+          }
+        }
+        auto fit = fanout->flowControls.find(socketAndCount.first);
+        if (fit != fanout->flowControls.end())
+        {
+          if (fit->second.unacked >= fit->second.window)
+          {
+            if (fit->second.coalesce)
+              heldBack.push_back(socketAndCount.first);
+            continue; // window full: ackEvent will reopen it
+          }
+          ++fit->second.unacked;
+        }
+        clients.push_back(socketAndCount.first);
+      }
+    }
+
+    // Payloads without objects or dynamics serialize identically for every
+    // destination: build the message once and let every copy share the
+    // payload buffer, only the header being per-destination. Object
+    // references and forced conversions depend on the destination socket
+    // and keep the per-socket path.
+    const std::string sigStr = sig.toString();
+    const bool socketDependent = !signature.empty()
+        || sigStr.find_first_of("om") != std::string::npos;
+
+    // Coalescing: keep the newest event for window-full subscribers,
+    // ackEvent delivers it when the window reopens. Socket-dependent
+    // payloads cannot be held serialized, so coalescing degrades to
+    // dropping for them.
+    if (!heldBack.empty() && !socketDependent)
+    {
+      try
+      {
+        const Message latest = buildEventMessage(params, service, object, event,
+                                                 sig, MessageSocketPtr(), context,
+                                                 std::string());
+        boost::mutex::scoped_lock lock(fanout->socketsMutex);
+        for (const auto& client: heldBack)
+        {
+          auto fit = fanout->flowControls.find(client);
+          if (fit != fanout->flowControls.end())
+            fit->second.pending = latest; // newest wins
+        }
+      }
+      catch (const std::exception& e)
+      {
+        qiLogDebug() << "forwardEvent coalesce serialization failed: " << e.what();
+      }
+    }
+    if (clients.empty())
+      return AnyReference();
+
+    // A throttled or window-limited subscriber misses events, which would
+    // desynchronize its delta receiver state: filtered fanouts stay on
+    // full payloads.
+    if (!socketDependent && !filtered &&
+        trySendDeltaEvent(params, service, object, event, sig, *fanout, clients, context))
+      return AnyReference();
+    if (clients.size() > 1 && !socketDependent)
+    {
+      try
+      {
+        const Message shared = buildEventMessage(params, service, object, event,
+                                                 sig, MessageSocketPtr(), context,
+                                                 std::string());
+        for (const auto& client: clients)
+          client->send(shared); // by-value: each destination gets its own header
+        return AnyReference();
+      }
+      catch (const std::exception& e)
+      {
+        // Serialization needed the socket after all (dynamic payload
+        // delegation): fall through to the per-socket path.
+        qiLogDebug() << "forwardEvent shared serialization failed: " << e.what();
+      }
+    }
+    if (clients.size() == 1)
+    {
+      clients.front()->send(buildEventMessage(params, service, object, event,
+                                              sig, clients.front(), context,
+                                              signature));
+      return AnyReference();
+    }
+    for (const auto& client: clients)
+    {
+      try
+      {
+        client->send(buildEventMessage(params, service, object, event, sig,
+                                       client, context, signature));
+      }
+      catch (const std::exception& e)
+      { // do not let one destination starve the others
+        qiLogVerbose() << "forwardEvent to " << client.get() << " failed: " << e.what();
+      }
+    }
     return AnyReference();
   }
 
@@ -100,6 +407,11 @@ namespace qi {
     , _callType(mct)
     , _owner(owner)
   {
+    // When the bound object merely proxies a remote one (gateway, service
+    // directory proxy, objects passed by reference), calls can be relayed
+    // without parsing their payloads. The RemoteObject stays alive through
+    // _object, which we hold until destruction.
+    _relayTarget = dynamic_cast<RemoteObject*>(dynamicObjectOf(object));
     _self = createServiceBoundObjectType(this, bindTerminate);
   }
 
@@ -131,52 +443,189 @@ namespace qi {
       ob->advertiseMethod("registerEvent"  , &ServiceBoundObject::registerEvent, MetaCallType_Direct, qi::Message::BoundObjectFunction_RegisterEvent);
       ob->advertiseMethod("unregisterEvent", &ServiceBoundObject::unregisterEvent, MetaCallType_Direct, qi::Message::BoundObjectFunction_UnregisterEvent);
       ob->advertiseMethod("terminate",       &ServiceBoundObject::terminate, MetaCallType_Direct, qi::Message::BoundObjectFunction_Terminate);
+      ob->advertiseMethod("terminateBatch",  &ServiceBoundObject::terminateBatch, MetaCallType_Direct, qi::Message::BoundObjectFunction_TerminateBatch);
       /* GenericObject-related stuff.
       * Those methods could be advertised and implemented by GenericObject itself.
       * But since we already have a wrapper system in place in BoundObject, us it.
       * There is no use-case that requires the methods below without a BoundObject present.
       */
       ob->advertiseMethod("metaObject"     , &ServiceBoundObject::metaObject, MetaCallType_Direct, qi::Message::BoundObjectFunction_MetaObject);
+      ob->advertiseMethod("metaObjectHash" , &ServiceBoundObject::metaObjectHash, MetaCallType_Direct, qi::Message::BoundObjectFunction_MetaObjectHash);
       ob->advertiseMethod("property", &ServiceBoundObject::property, MetaCallType_Queued, qi::Message::BoundObjectFunction_GetProperty);
       ob->advertiseMethod("setProperty", &ServiceBoundObject::setProperty, MetaCallType_Queued, qi::Message::BoundObjectFunction_SetProperty);
       ob->advertiseMethod("properties",       &ServiceBoundObject::properties, MetaCallType_Direct, qi::Message::BoundObjectFunction_Properties);
       ob->advertiseMethod("registerEventWithSignature"  , &ServiceBoundObject::registerEventWithSignature, MetaCallType_Direct, qi::Message::BoundObjectFunction_RegisterEventWithSignature);
+      ob->advertiseMethod("callBatch", &ServiceBoundObject::callBatch, MetaCallType_Queued, qi::Message::BoundObjectFunction_CallBatch);
+      ob->advertiseMethod("getProperties", &ServiceBoundObject::getProperties, MetaCallType_Queued, qi::Message::BoundObjectFunction_GetProperties);
+      ob->advertiseMethod("setProperties", &ServiceBoundObject::setProperties, MetaCallType_Queued, qi::Message::BoundObjectFunction_SetProperties);
+      ob->advertiseMethod("registerEventWithRate", &ServiceBoundObject::registerEventWithRate, MetaCallType_Direct, qi::Message::BoundObjectFunction_RegisterEventWithRate);
+      ob->advertiseMethod("setEventRate", &ServiceBoundObject::setEventRate, MetaCallType_Direct, qi::Message::BoundObjectFunction_SetEventRate);
+      ob->advertiseMethod("setEventWindow", &ServiceBoundObject::setEventWindow, MetaCallType_Direct, qi::Message::BoundObjectFunction_SetEventWindow);
+      ob->advertiseMethod("ackEvent", &ServiceBoundObject::ackEvent, MetaCallType_Direct, qi::Message::BoundObjectFunction_AckEvent);
     }
     AnyObject result = ob->object(self, &AnyObject::deleteGenericObjectOnly);
     return result;
   }
 
-  // Bound Method
-  qi::Future<SignalLink> ServiceBoundObject::registerEvent(unsigned int objectId, unsigned int eventId, SignalLink remoteSignalLinkId) {
+  qi::Future<SignalLink> ServiceBoundObject::registerEventImpl(unsigned int eventId, SignalLink remoteSignalLinkId, const std::string& signature, float maxRateHz) {
     // fetch signature
     const MetaSignal* ms = _object.metaObject().signal(eventId);
     if (!ms)
       throw std::runtime_error("No such signal");
     QI_ASSERT(_currentSocket);
-    AnyFunction mc = AnyFunction::fromDynamicFunction(boost::bind(&forwardEvent, _1, _serviceId, _objectId, eventId, ms->parametersSignature(), _currentSocket, weakPtr(), ""));
-    qi::Future<SignalLink> linking = _object.connect(eventId, mc);
+    // One local connection per (event, forced signature), fanned out to every
+    // subscriber socket: the payload is then serialized once per fanout
+    // instead of once per socket when it does not depend on the destination.
+    const EventFanoutKey key(eventId, signature);
+    EventFanoutPtr& fanout = _eventFanouts[key];
+    if (!fanout)
+    {
+      fanout = boost::make_shared<EventFanout>();
+      AnyFunction mc = AnyFunction::fromDynamicFunction(boost::bind(&forwardEvent, _1, _serviceId, _objectId, eventId, ms->parametersSignature(), fanout, weakPtr(), signature));
+      fanout->localSignalLinkId = _object.connect(eventId, mc);
+    }
+    {
+      boost::mutex::scoped_lock lock(fanout->socketsMutex);
+      ++fanout->sockets[_currentSocket];
+      if (maxRateHz > 0.0f)
+      {
+        EventFanout::RateLimit& limit = fanout->rateLimits[_currentSocket];
+        limit.minInterval = qi::MicroSeconds(static_cast<int64_t>(1e6 / maxRateHz));
+        limit.nextDue = qi::SteadyClockTimePoint(); // first event passes
+      }
+    }
+    qi::Future<SignalLink> linking = fanout->localSignalLinkId;
     auto& linkEntry = _links[_currentSocket][remoteSignalLinkId];
-    linkEntry = RemoteSignalLink(linking, eventId);
+    linkEntry = RemoteSignalLink(linking, eventId, signature);
     return linking.andThen([=](SignalLink linkId) mutable {
       qiLogDebug() << "SBO rl " << remoteSignalLinkId << " ll " << linkId;
       return linkId;
     });
   }
 
+  qi::Future<void> ServiceBoundObject::releaseEventFanout(const RemoteSignalLink& link, const MessageSocketPtr& socket) {
+    const EventFanoutKey key(link.event, link.signature);
+    EventFanoutMap::iterator it = _eventFanouts.find(key);
+    if (it == _eventFanouts.end())
+      return Future<void>{nullptr};
+    EventFanoutPtr fanout = it->second;
+    bool last = false;
+    {
+      boost::mutex::scoped_lock lock(fanout->socketsMutex);
+      auto sit = fanout->sockets.find(socket);
+      if (sit != fanout->sockets.end() && --sit->second == 0)
+      {
+        fanout->sockets.erase(sit);
+        fanout->rateLimits.erase(socket);
+        fanout->flowControls.erase(socket);
+      }
+      last = fanout->sockets.empty();
+    }
+    if (!last)
+      return Future<void>{nullptr};
+    _eventFanouts.erase(it);
+    AnyObject object = _object;
+    return fanout->localSignalLinkId.andThen([=](SignalLink localLink) mutable {
+      return object.disconnect(localLink).async();
+    }).unwrap();
+  }
+
+  // Bound Method
+  qi::Future<SignalLink> ServiceBoundObject::registerEvent(unsigned int objectId, unsigned int eventId, SignalLink remoteSignalLinkId) {
+    return registerEventImpl(eventId, remoteSignalLinkId, std::string());
+  }
+
   qi::Future<SignalLink> ServiceBoundObject::registerEventWithSignature(unsigned int objectId, unsigned int eventId, SignalLink remoteSignalLinkId, const std::string& signature) {
-    // fetch signature
-    const MetaSignal* ms = _object.metaObject().signal(eventId);
-    if (!ms)
-      throw std::runtime_error("No such signal");
-    QI_ASSERT(_currentSocket);
-    AnyFunction mc = AnyFunction::fromDynamicFunction(boost::bind(&forwardEvent, _1, _serviceId, _objectId, eventId, ms->parametersSignature(), _currentSocket, weakPtr(), signature));
-    qi::Future<SignalLink> linking = _object.connect(eventId, mc);
-    auto& linkEntry = _links[_currentSocket][remoteSignalLinkId];
-    linkEntry = RemoteSignalLink(linking, eventId);
-    return linking.andThen([=](SignalLink linkId) mutable {
-      qiLogDebug() << "SBO rl " << remoteSignalLinkId << " ll " << linkId;
-      return linkId;
-    });
+    return registerEventImpl(eventId, remoteSignalLinkId, signature);
+  }
+
+  // Bound Method
+  qi::Future<SignalLink> ServiceBoundObject::registerEventWithRate(unsigned int objectId, unsigned int eventId, SignalLink remoteSignalLinkId, float maxRateHz) {
+    return registerEventImpl(eventId, remoteSignalLinkId, std::string(), maxRateHz);
+  }
+
+  qi::EventFanoutPtr ServiceBoundObject::findEventFanout(unsigned int objectId, SignalLink remoteSignalLinkId, const char* requestName) {
+    ServiceSignalLinks& sl = _links[_currentSocket];
+    ServiceSignalLinks::iterator it = sl.find(remoteSignalLinkId);
+    if (it == sl.end())
+    {
+      std::stringstream ss;
+      ss << requestName << " request failed for " << remoteSignalLinkId << " " << objectId;
+      qiLogError() << ss.str();
+      throw std::runtime_error(ss.str());
+    }
+    const EventFanoutKey key(it->second.event, it->second.signature);
+    EventFanoutMap::iterator fit = _eventFanouts.find(key);
+    return fit == _eventFanouts.end() ? EventFanoutPtr() : fit->second;
+  }
+
+  // Bound Method
+  qi::Future<void> ServiceBoundObject::setEventRate(unsigned int objectId, unsigned int QI_UNUSED(event), SignalLink remoteSignalLinkId, float maxRateHz) {
+    EventFanoutPtr fanout = findEventFanout(objectId, remoteSignalLinkId, "setEventRate");
+    if (!fanout)
+      return Future<void>{nullptr};
+    boost::mutex::scoped_lock lock(fanout->socketsMutex);
+    if (maxRateHz > 0.0f)
+    {
+      EventFanout::RateLimit& limit = fanout->rateLimits[_currentSocket];
+      limit.minInterval = qi::MicroSeconds(static_cast<int64_t>(1e6 / maxRateHz));
+      limit.nextDue = qi::SteadyClockTimePoint(); // next event passes
+    }
+    else
+      fanout->rateLimits.erase(_currentSocket);
+    return Future<void>{nullptr};
+  }
+
+  // Bound Method
+  qi::Future<void> ServiceBoundObject::setEventWindow(unsigned int objectId, unsigned int QI_UNUSED(event), SignalLink remoteSignalLinkId, int window, bool coalesce) {
+    EventFanoutPtr fanout = findEventFanout(objectId, remoteSignalLinkId, "setEventWindow");
+    if (!fanout)
+      return Future<void>{nullptr};
+    MessageSocketPtr socket = _currentSocket;
+    boost::mutex::scoped_lock lock(fanout->socketsMutex);
+    if (window > 0)
+    {
+      EventFanout::FlowControl& fc = fanout->flowControls[socket];
+      fc.window = window;
+      fc.coalesce = coalesce;
+      // unacked and pending carry over when tightening/loosening a window
+    }
+    else
+    {
+      auto it = fanout->flowControls.find(socket);
+      if (it != fanout->flowControls.end())
+      {
+        // Lifting the window releases the event held back, if any.
+        if (it->second.pending)
+          socket->send(*it->second.pending);
+        fanout->flowControls.erase(it);
+      }
+    }
+    return Future<void>{nullptr};
+  }
+
+  // Bound Method
+  qi::Future<void> ServiceBoundObject::ackEvent(unsigned int objectId, unsigned int QI_UNUSED(event), SignalLink remoteSignalLinkId, int count) {
+    EventFanoutPtr fanout = findEventFanout(objectId, remoteSignalLinkId, "ackEvent");
+    if (!fanout)
+      return Future<void>{nullptr};
+    MessageSocketPtr socket = _currentSocket;
+    // Sending under the mutex so the released event and the window counter
+    // stay consistent with concurrent forwardEvent calls.
+    boost::mutex::scoped_lock lock(fanout->socketsMutex);
+    auto it = fanout->flowControls.find(socket);
+    if (it == fanout->flowControls.end())
+      return Future<void>{nullptr};
+    EventFanout::FlowControl& fc = it->second;
+    fc.unacked = count < fc.unacked ? fc.unacked - count : 0;
+    if (fc.pending && fc.unacked < fc.window)
+    {
+      Message msg = *fc.pending;
+      fc.pending = boost::none;
+      ++fc.unacked;
+      socket->send(msg);
+    }
+    return Future<void>{nullptr};
   }
 
   // Bound Method
@@ -192,13 +641,11 @@ namespace qi {
       throw std::runtime_error(ss.str());
     }
 
-    auto localSignalLinkId = it->second.localSignalLinkId;
+    const RemoteSignalLink link = it->second;
     sl.erase(it);
     if (sl.empty())
       _links.erase(_currentSocket);
-    return localSignalLinkId.andThen([=](SignalLink link) {
-      return _object.disconnect(link).async();
-    }).unwrap();
+    return releaseEventFanout(link, _currentSocket);
   }
 
   // Bound Method
@@ -207,6 +654,13 @@ namespace qi {
     return qi::MetaObject::merge(_self.metaObject(), _object.metaObject());
   }
 
+  std::string ServiceBoundObject::metaObjectHash(unsigned int objectId) {
+    // The hash is content-only, so the client computes the same one from
+    // the MetaObject it fetched last time and can compare.
+    const ka::sha1_digest_t hash = metaObject(objectId).contentHash();
+    return std::string(hash.begin(), hash.end());
+  }
+
 
   void ServiceBoundObject::terminate(unsigned int)
   {
@@ -222,6 +676,20 @@ namespace qi {
       qiLogWarning() << "terminate() received on object without an owner";
   }
 
+  void ServiceBoundObject::terminateBatch(std::vector<unsigned int> objectIds)
+  {
+    qiLogDebug() << "terminateBatch() received for " << objectIds.size() << " objects";
+    if (_owner)
+    {
+      if (boost::shared_ptr<ObjectHost> owner = _owner->lock())
+        owner->removeObjects(objectIds);
+      else
+        qiLogDebug() << "terminateBatch() received an object with an expired owner";
+    }
+    else
+      qiLogWarning() << "terminateBatch() received on object without an owner";
+  }
+
   static void destroyAbstractFuture(AnyReference value)
   {
     value.destroy();
@@ -229,6 +697,10 @@ namespace qi {
 
   void ServiceBoundObject::onMessage(const qi::Message &msg, MessageSocketPtr socket) {
     boost::mutex::scoped_lock lock(_callMutex);
+    // Serve the scalar storage of this dispatch (deserialized arguments,
+    // conversion temporaries, and for direct calls the whole execution) from
+    // a bump arena released wholesale when the dispatch ends.
+    detail::ScopedStorageArena storageArena;
     try {
       if (msg.version() > Message::Header::currentVersion())
       {
@@ -274,6 +746,23 @@ namespace qi {
           throw std::runtime_error(ss.str());
         }
         sigparam = mm->parametersSignature();
+
+        /* Zero-parse relay: when this object only proxies a remote one,
+         * deserializing the payload to re-serialize it is pure waste. The
+         * payload can be moved socket-to-socket untouched as long as its
+         * bytes are socket-independent: no object references and no dynamic
+         * values in either direction (both are rewritten per socket), and
+         * no flag that changes the payload layout. A signature annotation
+         * containing the letters 'o' or 'm' falls back to the slow path,
+         * which is only conservative. */
+        if (_relayTarget && !isSpecialFunction &&
+            (msg.flags() & ~Message::TypeFlag_HighPriority) == 0 &&
+            sigparam.toString().find_first_of("om") == std::string::npos &&
+            mm->returnSignature().toString().find_first_of("om") == std::string::npos)
+        {
+          relayRemoteCall(msg, socket, funcId);
+          return;
+        }
       }
 
       else if (msg.type() == qi::Message::Type_Post) {
@@ -292,6 +781,15 @@ namespace qi {
       }
       else if (msg.type() == qi::Message::Type_Cancel)
       {
+        if (msg.flags() & Message::TypeFlag_BatchCancel)
+        { // One message, several calls to cancel (BatchCancel capability).
+          AnyReference ref = msg.value("[I]", socket);
+          const std::vector<unsigned int> origMsgIds = ref.to<std::vector<unsigned int>>();
+          ref.destroy();
+          for (const unsigned int origMsgId: origMsgIds)
+            cancelCall(socket, msg, origMsgId);
+          return;
+        }
         AnyReference ref = msg.value("I", socket);
         unsigned int origMsgId = ref.to<unsigned int>();
         ref.destroy();
@@ -307,20 +805,40 @@ namespace qi {
       AnyReference value;
       if (msg.flags() & Message::TypeFlag_DynamicPayload)
         sigparam = "m";
-      // ReturnType flag appends a signature to the payload
+      // The ReturnType and CallDeadline flags append fields to the payload,
+      // in that order: the expected return signature, then the completion
+      // budget in milliseconds.
       Signature originalSignature;
       bool hasReturnType = (msg.flags() & Message::TypeFlag_ReturnType) ? true : false;
-      if (hasReturnType)
+      const bool hasDeadline = (msg.flags() & Message::TypeFlag_CallDeadline) ? true : false;
+      if (hasReturnType || hasDeadline)
       {
         originalSignature = sigparam;
-        sigparam = "(" + sigparam.toString() + "s)";
+        std::string composed = "(" + sigparam.toString();
+        if (hasReturnType)
+          composed += "s";
+        if (hasDeadline)
+          composed += "I";
+        sigparam = composed + ")";
       }
       value = msg.value(sigparam, socket);
       std::string returnSignature;
-      if (hasReturnType)
+      SteadyClockTimePoint deadlineExpiry;
+      if (hasReturnType || hasDeadline)
       {
-        returnSignature = value[1].to<std::string>();
-        value[1].destroy();
+        size_t index = 1;
+        if (hasReturnType)
+        {
+          returnSignature = value[index].to<std::string>();
+          value[index].destroy();
+          ++index;
+        }
+        if (hasDeadline)
+        {
+          deadlineExpiry = SteadyClock::now()
+            + qi::MilliSeconds(value[index].to<unsigned int>());
+          value[index].destroy();
+        }
         value = value[0];
         sigparam = originalSignature;
       }
@@ -352,13 +870,26 @@ namespace qi {
       switch (msg.type())
       {
       case Message::Type_Call: {
+        if (hasDeadline && SteadyClock::now() >= deadlineExpiry)
+        {
+          // The caller already gave up on this call: reply with the error
+          // it expects instead of spending cycles on a worthless answer.
+          qiLogVerbose() << "Skipping call " << msg.address()
+                         << ": deadline expired before invocation";
+          qi::Promise<AnyReference> prom;
+          prom.setError("call deadline expired");
+          serverResultAdapter(prom.future(), Signature(), _gethost(), socket, msg.address(), Signature(),
+                              CancelableKitWeak(_cancelables));
+          break;
+        }
         boost::recursive_mutex::scoped_lock lock(_mutex);
         _currentSocket = socket;
 
         // Property accessors are insecure to call synchronously
         // because users can customize them.
         const bool isUserDefinedFunction =
-            !isSpecialFunction || funcId == 5 /* property */ || funcId == 6 /* setProperty */;
+            !isSpecialFunction || funcId == 5 /* property */ || funcId == 6 /* setProperty */
+            || funcId == 9 /* callBatch */;
         qi::MetaCallType callType = isUserDefinedFunction ? _callType : MetaCallType_Direct;
 
         qi::Signature sig = returnSignature.empty() ? Signature() : Signature(returnSignature);
@@ -375,9 +906,15 @@ namespace qi {
           retSig = mm->returnSignature();
         _currentSocket.reset();
 
+        // Force the reply adapter onto the general worker pool: it encodes
+        // the result and enqueues it on the socket, which needs no object
+        // state. Run synchronously it would occupy the object's execution
+        // context (or the dispatch thread for direct calls) for the whole
+        // serialization of a possibly large reply, blocking the next call.
         fut.connect(boost::bind<void>
                     (&ServiceBoundObject::serverResultAdapter, _1, retSig, _gethost(), socket, msg.address(), sig,
-                     CancelableKitWeak(_cancelables), cancelRequested));
+                     CancelableKitWeak(_cancelables), cancelRequested),
+                    FutureCallbackType_Async);
       }
         break;
       case Message::Type_Post: {
@@ -391,7 +928,7 @@ namespace qi {
         qiLogError() << "unknown request of type " << (int)msg.type() << " on service: " << msg.address();
       }
       //########################
-      value.destroy();
+      deferDestroy(value);
     } catch (const std::runtime_error &e) {
       if (msg.type() == Message::Type_Call) {
         qi::Promise<AnyReference> prom;
@@ -409,6 +946,67 @@ namespace qi {
     }
   }
 
+  void ServiceBoundObject::relayRemoteCall(const qi::Message& msg,
+                                           const MessageSocketPtr& socket,
+                                           unsigned int funcId)
+  {
+    qiLogDebug() << "Relaying call " << msg.address() << " without payload parsing";
+    // The client socket is the fairness key: relayed traffic shares the
+    // upstream connection deficit-round-robin per origin under backpressure.
+    qi::Future<Message> reply = _relayTarget->metaCallRaw(funcId, msg, socket);
+
+    /* Register a stand-in in the cancelable table so a Type_Cancel from the
+     * client reaches the upstream call: cancel requests propagate from the
+     * adapter to the relay future, which sends the cancel message. The
+     * adapter's value is a void reference, so cancelCall's future-of-future
+     * inspection is a no-op. */
+    AtomicIntPtr cancelRequested = boost::make_shared<qi::Atomic<int>>(0);
+    qi::Future<AnyReference> cancelAdapter =
+        reply.andThen(FutureCallbackType_Sync,
+                      [](const Message&) { return AnyReference(typeOf<void>()); });
+    {
+      boost::mutex::scoped_lock futlock(_cancelables->guard);
+      _cancelables->map[socket][msg.id()] = std::make_pair(cancelAdapter, cancelRequested);
+    }
+
+    const MessageAddress replyaddr = msg.address();
+    const CancelableKitWeak kit(_cancelables);
+    reply.connect([replyaddr, socket, kit](qi::Future<Message> f) {
+      _removeCachedFuture(kit, socket, replyaddr.messageId);
+      if (!socket->isConnected())
+      {
+        qiLogDebug() << "Can't send relayed result: the socket has been disconnected";
+        return;
+      }
+      qi::Message ret(Message::Type_Reply, replyaddr);
+      if (f.hasError())
+      {
+        ret.setType(qi::Message::Type_Error);
+        ret.setError(f.error());
+      }
+      else if (f.isCanceled())
+      {
+        if (!socket->sharedCapability(capabilityname::remoteCancelableCalls, false))
+        {
+          ret.setType(qi::Message::Type_Error);
+          ret.setError("Call has been canceled.");
+        }
+        else
+          ret.setType(qi::Message::Type_Canceled);
+      }
+      else
+      {
+        // Forward the reply (or upstream error) payload verbatim.
+        const Message& rep = f.value();
+        ret.setType(rep.type());
+        ret.setFlags(rep.flags());
+        ret.setBuffer(Buffer::makeShared(rep.buffer()));
+      }
+      if (!socket->send(std::move(ret)))
+        qiLogWarning() << "Can't send relayed answer for address:" << replyaddr;
+    });
+  }
+
   void ServiceBoundObject::cancelCall(MessageSocketPtr socket, const Message& cancelMessage, MessageId origMsgId)
   {
     qiLogDebug() << "Canceling call: " << origMsgId << " on client " << socket.get();
@@ -494,7 +1092,7 @@ namespace qi {
     {
       for (ServiceSignalLinks::iterator jt = it->second.begin(); jt != it->second.end(); ++jt)
       {
-        _object.disconnect(jt->second.localSignalLinkId.value()).async()
+        releaseEventFanout(jt->second, client)
             .then([](Future<void> f) { if (f.hasError()) qiLogError() << f.error(); });
       }
       _links.erase(it);
@@ -547,6 +1145,120 @@ namespace qi {
     return res;
   }
 
+  // Bound Method
+  qi::Future<std::vector<ServiceBoundObject::CallBatchResult>> ServiceBoundObject::callBatch(
+      const std::vector<CallBatchEntry>& calls)
+  {
+    std::vector<qi::Future<AnyReference>> results;
+    results.reserve(calls.size());
+    for (unsigned i = 0; i < calls.size(); ++i)
+    {
+      // Batched entries only reach the underlying object, like regular calls:
+      // the bound-object functions stay out of reach.
+      if (calls[i].first < Manageable::startId || !_object.metaObject().method(calls[i].first))
+      {
+        std::stringstream ss;
+        ss << "Batched call to unknown function " << calls[i].first;
+        results.push_back(qi::makeFutureError<AnyReference>(ss.str()));
+        continue;
+      }
+      try
+      {
+        AnyValue args = calls[i].second;
+        GenericFunctionParameters params(args.asTupleValuePtr());
+        results.push_back(_object.metaCall(calls[i].first, params, _callType));
+      }
+      catch (const std::exception& e)
+      {
+        results.push_back(qi::makeFutureError<AnyReference>(e.what()));
+      }
+    }
+    return qi::waitForAll(results).async().andThen(
+        [](const std::vector<qi::Future<AnyReference>>& done) {
+          std::vector<CallBatchResult> replies;
+          replies.reserve(done.size());
+          for (unsigned i = 0; i < done.size(); ++i)
+          {
+            qi::Future<AnyReference> result = done[i];
+            if (result.isCanceled())
+              replies.push_back(CallBatchResult("Call canceled", AnyValue::makeVoid()));
+            else if (result.hasError())
+              replies.push_back(CallBatchResult(result.error(), AnyValue::makeVoid()));
+            else
+              replies.push_back(CallBatchResult(std::string(), AnyValue(result.value(), false, true)));
+          }
+          return replies;
+        });
+  }
+
+  qi::Future<std::vector<ServiceBoundObject::PropertyResult>> ServiceBoundObject::getProperties(
+      const std::vector<AnyValue>& names)
+  {
+    std::vector<qi::Future<AnyValue>> results;
+    results.reserve(names.size());
+    for (unsigned i = 0; i < names.size(); ++i)
+    {
+      try
+      {
+        results.push_back(property(names[i]));
+      }
+      catch (const std::exception& e)
+      {
+        results.push_back(qi::makeFutureError<AnyValue>(e.what()));
+      }
+    }
+    return qi::waitForAll(results).async().andThen(
+        [](const std::vector<qi::Future<AnyValue>>& done) {
+          std::vector<PropertyResult> replies;
+          replies.reserve(done.size());
+          for (unsigned i = 0; i < done.size(); ++i)
+          {
+            qi::Future<AnyValue> result = done[i];
+            if (result.isCanceled())
+              replies.push_back(PropertyResult("Property read canceled", AnyValue::makeVoid()));
+            else if (result.hasError())
+              replies.push_back(PropertyResult(result.error(), AnyValue::makeVoid()));
+            else
+              replies.push_back(PropertyResult(std::string(), result.value()));
+          }
+          return replies;
+        });
+  }
+
+  qi::Future<std::vector<std::string>> ServiceBoundObject::setProperties(
+      const std::vector<std::pair<AnyValue, AnyValue>>& values)
+  {
+    std::vector<qi::Future<void>> results;
+    results.reserve(values.size());
+    for (unsigned i = 0; i < values.size(); ++i)
+    {
+      try
+      {
+        results.push_back(setProperty(values[i].first, values[i].second));
+      }
+      catch (const std::exception& e)
+      {
+        results.push_back(qi::makeFutureError<void>(e.what()));
+      }
+    }
+    return qi::waitForAll(results).async().andThen(
+        [](const std::vector<qi::Future<void>>& done) {
+          std::vector<std::string> errors;
+          errors.reserve(done.size());
+          for (unsigned i = 0; i < done.size(); ++i)
+          {
+            qi::Future<void> result = done[i];
+            if (result.isCanceled())
+              errors.push_back("Property write canceled");
+            else if (result.hasError())
+              errors.push_back(result.error());
+            else
+              errors.push_back(std::string());
+          }
+          return errors;
+        });
+  }
+
   void ServiceBoundObject::_removeCachedFuture(CancelableKitWeak kit, MessageSocketPtr sock, MessageId id)
   {
     CancelableKitPtr kitPtr = kit.lock();
@@ -569,6 +1281,30 @@ namespace qi {
     }
   }
 
+  // Debug aid (QI_REPLY_COPY_WARN_SIZE, bytes, 0 = off): count and report
+  // the replies whose value got copied on its way to the wire and weigh
+  // more than the threshold, per method, to spot the copy sites that still
+  // hurt big-payload services.
+  static void reportReplyCopy(const Message& ret, size_t copiedBytes, const char* site)
+  {
+    static const size_t threshold =
+        qi::os::getEnvDefault<size_t>("QI_REPLY_COPY_WARN_SIZE", 0);
+    if (threshold == 0 || copiedBytes < threshold)
+      return;
+    using MethodKey = std::pair<unsigned int, unsigned int>; // service, method
+    static boost::mutex countMutex;
+    static std::map<MethodKey, unsigned int> counts;
+    unsigned int count = 0;
+    {
+      boost::mutex::scoped_lock lock(countMutex);
+      count = ++counts[MethodKey(ret.service(), ret.action())];
+    }
+    qiLogWarning("qimessaging.serverresult")
+        << "Reply to " << ret.service() << "." << ret.action() << " copied "
+        << copiedBytes << " bytes (" << site << "), " << count
+        << " copies over threshold for this method";
+  }
+
   // if 'val' is a qi::Object<> its ownership will be given to the 'host' object
   static inline void convertAndSetValue(Message& ret, AnyReference val,
     const Signature& targetSignature, boost::weak_ptr<ObjectHost> host,
@@ -590,6 +1326,8 @@ namespace qi {
       {
         ret.setValue(*conv, "m", host, socket);
         ret.addFlags(Message::TypeFlag_DynamicPayload);
+        if (conv->rawValue() != val.rawValue())
+          reportReplyCopy(ret, ret.buffer().totalSize(), "forced signature conversion");
         return;
       }
     }
@@ -633,17 +1371,28 @@ namespace qi {
         else
           ret.setType(Message::Type_Canceled);
       }
-      else
+      else if (kind == TypeKind_Void)
       {
         // Future<void>::value() give a void* so we need a special handling to
         // produce a real void
-        AnyValue value;
-        if (kind == TypeKind_Void)
-          value = AnyValue(qi::typeOf<void>());
-        else
-          value = ao->call<AnyValue>("value", 0);
+        AnyValue value(qi::typeOf<void>());
         convertAndSetValue(ret, value.asReference(), targetSignature, host, socket.get(), forcedReturnSignature);
       }
+      else
+      {
+        // Take the result out of the future by reference instead of
+        // converting it to a dynamic AnyValue: that conversion deep-copied
+        // the value, which is what hurt methods returning big buffers.
+        // One copy remains in the generic call machinery, which clones the
+        // `const T&` that Future::value() returns; reportReplyCopy makes it
+        // visible so such methods can be found.
+        int timeout = 0;
+        GenericFunctionParameters params;
+        params.push_back(AnyReference::from(timeout));
+        detail::UniqueAnyReference result{ ao->metaCall("value", params, MetaCallType_Direct).value() };
+        convertAndSetValue(ret, *result, targetSignature, host, socket.get(), forcedReturnSignature);
+        reportReplyCopy(ret, ret.buffer().totalSize(), "future value extraction");
+      }
     } catch (const std::exception &e) {
       //be more than safe. we always want to nack the client in case of error
       ret.setType(qi::Message::Type_Error);
@@ -656,11 +1405,11 @@ namespace qi {
     if (!socket->send(std::move(ret)))
     {
       // TODO: if `convertAndSetValue` transfers ownership of `val` in the object host,
-      // `val.destroy()` below won't be enough. Check if it's necessary to destroy
+      // destroying `val` below won't be enough. Check if it's necessary to destroy
       // `val` inside the host.
       qiLogWarning("qimessaging.serverresult") << "Can't generate an answer for address:" << replyaddr;
     }
-    val.destroy();
+    deferDestroy(val);
   }
 
   void ServiceBoundObject::serverResultAdapter(Future<AnyReference> future,
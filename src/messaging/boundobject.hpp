@@ -12,6 +12,8 @@
 #include <boost/signals2.hpp>
 #include <boost/optional.hpp>
 #include <qi/api.hpp>
+#include <qi/buffer.hpp>
+#include <qi/clock.hpp>
 #include <qi/session.hpp>
 #include "transportserver.hpp"
 #include <qi/atomic.hpp>
@@ -25,6 +27,7 @@ using AtomicIntPtr = boost::shared_ptr<qi::Atomic<int>>;
 namespace qi {
 
   class GenericObject;
+  class RemoteObject;
   class ServiceDirectoryClient;
   class ServiceDirectory;
 
@@ -36,14 +39,71 @@ namespace qi {
       , event(0)
     {}
 
-    RemoteSignalLink(qi::Future<SignalLink> localSignalLinkId, unsigned int event)
+    RemoteSignalLink(qi::Future<SignalLink> localSignalLinkId, unsigned int event,
+                     const std::string& signature = std::string())
     : localSignalLinkId(localSignalLinkId)
-    , event(event) {}
+    , event(event)
+    , signature(signature) {}
 
     qi::Future<SignalLink> localSignalLinkId;
     unsigned int event;
+    // Forced conversion signature, empty for plain registerEvent.
+    std::string signature;
   };
 
+  /// Fanout of one local signal connection to every remote subscriber socket
+  /// that registered the same event with the same forced signature. The event
+  /// payload is then serialized once per fanout instead of once per socket
+  /// whenever it does not depend on the destination (see forwardEvent).
+  struct EventFanout
+  {
+    qi::Future<SignalLink> localSignalLinkId;
+    boost::mutex socketsMutex;
+    // Subscriber sockets with a registration count: the same client may
+    // register the same event through several remote links.
+    std::map<MessageSocketPtr, int> sockets;
+
+    // Delta-event state (capabilityname::deltaEvents): the per-field
+    // serialized bytes of the last payload sent, diffed against each new
+    // payload so only changed fields travel. Guarded by socketsMutex, which
+    // is also held across the sends so the delta chain matches the order
+    // the messages are queued in. See trySendDeltaEvent.
+    struct DeltaState
+    {
+      std::vector<qi::Buffer> fieldPayloads; // last sent value, one buffer per field
+      std::vector<MessageSocket*> clients;   // subscriber set the state is valid for
+      bool clientsSupportDelta = false;
+      int deltasSinceKeyframe = 0;
+    };
+    DeltaState delta;
+
+    // Per-subscriber rate ceiling (registerEventWithRate/setEventRate):
+    // events beyond the rate are dropped for that socket before
+    // serialization, the first event of each interval being the one kept.
+    // Guarded by socketsMutex like the rest.
+    struct RateLimit
+    {
+      qi::Duration minInterval{0};
+      qi::SteadyClockTimePoint nextDue; // epoch: first event always passes
+    };
+    std::map<MessageSocketPtr, RateLimit> rateLimits;
+
+    // Per-subscriber delivery window (setEventWindow/ackEvent): after
+    // `window` unacknowledged events a subscriber stops receiving; with
+    // coalesce the newest held-back event is kept and delivered when an
+    // acknowledgment reopens the window, without it held-back events are
+    // dropped. Guarded by socketsMutex like the rest.
+    struct FlowControl
+    {
+      int window = 0;
+      int unacked = 0;
+      bool coalesce = true;
+      boost::optional<qi::Message> pending; // newest held-back event
+    };
+    std::map<MessageSocketPtr, FlowControl> flowControls;
+  };
+  using EventFanoutPtr = boost::shared_ptr<EventFanout>;
+
 
   class BoundObject {
   public:
@@ -90,12 +150,49 @@ namespace qi {
     //PUBLIC BOUND METHODS
     qi::Future<SignalLink> registerEvent(unsigned int serviceId, unsigned int eventId, SignalLink linkId);
     qi::Future<SignalLink> registerEventWithSignature(unsigned int serviceId, unsigned int eventId, SignalLink linkId, const std::string& signature);
+    // registerEvent with a rate ceiling in Hz: events beyond maxRateHz are
+    // dropped for this subscriber before serialization, so a slow consumer
+    // only costs its own rate. 0 means unlimited. setEventRate adjusts (or
+    // lifts, with 0) the ceiling of an existing registration. Client side
+    // is SignalSubscriber::setMaxEventRate.
+    qi::Future<SignalLink> registerEventWithRate(unsigned int serviceId, unsigned int eventId, SignalLink linkId, float maxRateHz);
+    qi::Future<void> setEventRate(unsigned int serviceId, unsigned int eventId, SignalLink linkId, float maxRateHz);
+    // Windowed delivery for an existing registration: at most `window`
+    // unacknowledged events are sent to this subscriber, ackEvent reopening
+    // the window as events are consumed. 0 lifts the window. Client side is
+    // SignalSubscriber::setAckWindow; acknowledgments are sent automatically
+    // by RemoteObject.
+    qi::Future<void> setEventWindow(unsigned int serviceId, unsigned int eventId, SignalLink linkId, int window, bool coalesce);
+    qi::Future<void> ackEvent(unsigned int serviceId, unsigned int eventId, SignalLink linkId, int count);
     qi::Future<void> unregisterEvent(unsigned int serviceId, unsigned int eventId, SignalLink linkId);
     qi::MetaObject metaObject(unsigned int serviceId);
+    // Content hash of metaObject()'s result, as 20 raw bytes. Fetched by
+    // reconnecting clients to skip the full MetaObject transfer when the
+    // interface did not change (see capabilityname::metaObjectHash).
+    std::string    metaObjectHash(unsigned int serviceId);
     void           terminate(unsigned int serviceId); //bound only in special cases
+    // Batched form of terminate: releases all the listed hosted objects of
+    // this object's owner in one pass, so dropping a whole proxy graph
+    // costs one message instead of one per object.
+    void           terminateBatch(std::vector<unsigned int> objectIds);
     qi::Future<AnyValue> property(const AnyValue& name);
     Future<void>   setProperty(const AnyValue& name, AnyValue value);
     std::vector<std::string> properties();
+    // One bundled message for several calls on the underlying object, each
+    // entry being (function id, argument tuple). The reply holds one
+    // (error message, value) pair per entry, the error being empty on
+    // success. Client side is qi::ObjectBatch.
+    using CallBatchEntry = std::pair<unsigned int, AnyValue>;
+    using CallBatchResult = std::pair<std::string, AnyValue>;
+    qi::Future<std::vector<CallBatchResult>> callBatch(const std::vector<CallBatchEntry>& calls);
+    // Bulk property access: one message carrying several property names (or
+    // ids, like property/setProperty). getProperties replies with one
+    // (error message, value) pair per entry, setProperties with one error
+    // string per entry, empty on success, so one bad entry does not fail
+    // the rest. Client side is GenericObject::properties/setProperties.
+    using PropertyResult = std::pair<std::string, AnyValue>;
+    qi::Future<std::vector<PropertyResult>> getProperties(const std::vector<AnyValue>& names);
+    qi::Future<std::vector<std::string>> setProperties(const std::vector<std::pair<AnyValue, AnyValue>>& values);
   public:
     /*
     * Returns the last socket that sent a message to this object.
@@ -149,9 +246,32 @@ namespace qi {
     // remote link id -> local link id
     using ServiceSignalLinks = std::map<SignalLink, RemoteSignalLink>;
     using BySocketServiceSignalLinks = std::map<qi::MessageSocketPtr, ServiceSignalLinks>;
+    // (event, forced signature) -> shared fanout
+    using EventFanoutKey = std::pair<unsigned int, std::string>;
+    using EventFanoutMap = std::map<EventFanoutKey, EventFanoutPtr>;
+
+    /// Zero-parse relay of a call to _object when it is a RemoteObject (the
+    /// gateway/proxy case): the payload buffer moves socket-to-socket
+    /// untouched and only headers are rewritten. Caller has checked the
+    /// message and method are eligible (see onMessage).
+    void relayRemoteCall(const qi::Message& msg, const MessageSocketPtr& socket,
+                         unsigned int funcId);
+
+    qi::Future<SignalLink> registerEventImpl(unsigned int eventId, SignalLink remoteSignalLinkId,
+                                             const std::string& signature, float maxRateHz = 0.0f);
+    /// Fanout behind the registration `remoteSignalLinkId` of the current
+    /// socket, null when the fanout is already gone. Throws when the link
+    /// itself is unknown, like unregisterEvent does.
+    EventFanoutPtr findEventFanout(unsigned int objectId, SignalLink remoteSignalLinkId,
+                                   const char* requestName);
+    /// Drops one registration of `socket` on the fanout designated by `link`,
+    /// disconnecting the local signal connection when the last subscriber
+    /// socket leaves.
+    qi::Future<void> releaseEventFanout(const RemoteSignalLink& link, const MessageSocketPtr& socket);
 
     //Event handling (no lock needed)
     BySocketServiceSignalLinks  _links;
+    EventFanoutMap              _eventFanouts;
 
     boost::mutex _callMutex;
   private:
@@ -159,6 +279,8 @@ namespace qi {
     unsigned int           _serviceId;
     unsigned int           _objectId;
     qi::AnyObject          _object;
+    // Non-null when _object proxies a remote object; owned through _object.
+    RemoteObject*          _relayTarget = nullptr;
     qi::AnyObject          _self;
     qi::MetaCallType       _callType;
     boost::optional<boost::weak_ptr<qi::ObjectHost>> _owner;
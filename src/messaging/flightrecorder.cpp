@@ -0,0 +1,108 @@
+/*
+**  Copyright (C) 2018 Softbank Robotics
+**  See COPYING for the license
+*/
+
+#include <iomanip>
+#include <sstream>
+#include <vector>
+
+#include <qi/clock.hpp>
+#include <qi/log.hpp>
+#include <qi/os.hpp>
+
+#include "flightrecorder.hpp"
+#include "message.hpp"
+
+qiLogCategory("qimessaging.flightrecorder");
+
+namespace qi
+{
+  namespace
+  {
+    size_t slotsFromEnv()
+    {
+      static const size_t slots =
+          os::getEnvParam<size_t>("QI_FLIGHT_RECORDER_SIZE", 256);
+      return slots > 0 ? slots : 1;
+    }
+
+    int64_t nowUs()
+    {
+      return boost::chrono::duration_cast<qi::MicroSeconds>(
+          SystemClock::now().time_since_epoch()).count();
+    }
+  }
+
+  FlightRecorder::FlightRecorder()
+    : _slots(slotsFromEnv())
+    , _entries(new Entry[_slots])
+  {
+  }
+
+  void FlightRecorder::record(const Message& msg, bool sent)
+  {
+    const uint64_t n = _count.fetch_add(1, std::memory_order_relaxed);
+    Entry& entry = _entries[n % _slots];
+    entry.seq.store(2 * n + 1, std::memory_order_release);
+    entry.timestampUs = nowUs();
+    entry.id = msg.id();
+    entry.service = msg.service();
+    entry.object = msg.object();
+    entry.action = msg.action();
+    entry.payloadBytes = msg.buffer().totalSize();
+    entry.type = static_cast<uint8_t>(msg.type());
+    entry.flags = msg.flags();
+    entry.sent = sent;
+    entry.seq.store(2 * n + 2, std::memory_order_release);
+  }
+
+  void FlightRecorder::dump(const std::string& reason) const
+  {
+    const uint64_t total = _count.load(std::memory_order_acquire);
+    const uint64_t first = total > _slots ? total - _slots : 0;
+    std::ostringstream out;
+    out << "Message history (" << reason << "), " << total
+        << " messages seen, last " << (total - first) << " recorded:";
+    size_t torn = 0;
+    for (uint64_t n = first; n < total; ++n)
+    {
+      const Entry& entry = _entries[n % _slots];
+      if (entry.seq.load(std::memory_order_acquire) != 2 * n + 2)
+      { // Overwritten or being written by a concurrent record(): skip it.
+        ++torn;
+        continue;
+      }
+      Entry copy;
+      copy.timestampUs = entry.timestampUs;
+      copy.id = entry.id;
+      copy.service = entry.service;
+      copy.object = entry.object;
+      copy.action = entry.action;
+      copy.payloadBytes = entry.payloadBytes;
+      copy.type = entry.type;
+      copy.flags = entry.flags;
+      copy.sent = entry.sent;
+      if (entry.seq.load(std::memory_order_acquire) != 2 * n + 2)
+      { // The copy raced with a wrap-around: drop the torn data.
+        ++torn;
+        continue;
+      }
+      out << "\n  " << copy.timestampUs / 1000000 << "."
+          << std::setfill('0') << std::setw(6) << copy.timestampUs % 1000000
+          << std::setfill(' ')
+          << (copy.sent ? " sent " : " recv ")
+          << std::setw(8) << Message::typeToString(
+                 static_cast<Message::Type>(copy.type))
+          << " id:" << copy.id
+          << " service:" << copy.service
+          << " object:" << copy.object
+          << " action:" << copy.action
+          << " flags:0x" << std::hex << int(copy.flags) << std::dec
+          << " payload:" << copy.payloadBytes;
+    }
+    if (torn > 0)
+      out << "\n  (" << torn << " entries lost to concurrent writes)";
+    qiLogInfo() << out.str();
+  }
+}
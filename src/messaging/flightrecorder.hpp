@@ -0,0 +1,71 @@
+#pragma once
+/*
+**  Copyright (C) 2018 Softbank Robotics
+**  See COPYING for the license
+*/
+
+#ifndef _SRC_MESSAGING_FLIGHTRECORDER_HPP_
+#define _SRC_MESSAGING_FLIGHTRECORDER_HPP_
+
+#include <atomic>
+#include <memory>
+#include <string>
+
+#include <boost/shared_ptr.hpp>
+
+namespace qi
+{
+  class Message;
+
+  /// Always-on flight recorder of the messaging activity: a fixed ring of
+  /// the last N sent and received message headers (never the payloads), with
+  /// timestamps. Each session owns one and installs it on every socket it
+  /// creates or accepts; after an incident, dump() turns the ring into log
+  /// lines so field reports come with the messaging history that led to the
+  /// failure.
+  ///
+  /// record() is a single ring write: a relaxed counter increment plus a
+  /// seqlock-guarded slot store, cheap enough for the send and receive hot
+  /// paths. Writers never block and readers (dump) simply skip slots torn by
+  /// a concurrent write.
+  ///
+  /// The ring size comes from QI_FLIGHT_RECORDER_SIZE (default 256 entries).
+  class FlightRecorder
+  {
+  public:
+    FlightRecorder();
+
+    /// One ring write; `sent` tells the direction.
+    void record(const Message& msg, bool sent);
+
+    /// Logs the recorded entries, oldest first, as a single info message on
+    /// the qimessaging.flightrecorder category. `reason` says what triggered
+    /// the dump (session error, explicit request...).
+    void dump(const std::string& reason) const;
+
+  private:
+    struct Entry
+    {
+      // Seqlock: 0 empty, odd while written, 2n+2 once emission n is
+      // complete. Lets dump() detect slots it raced with.
+      std::atomic<uint64_t> seq{0};
+      int64_t timestampUs; // SystemClock, so it lines up with the log dates.
+      unsigned int id;
+      unsigned int service;
+      unsigned int object;
+      unsigned int action;
+      size_t payloadBytes;
+      uint8_t type;
+      uint8_t flags;
+      bool sent;
+    };
+
+    const size_t _slots;
+    std::unique_ptr<Entry[]> _entries;
+    std::atomic<uint64_t> _count{0};
+  };
+
+  using FlightRecorderPtr = boost::shared_ptr<FlightRecorder>;
+}
+
+#endif  // _SRC_MESSAGING_FLIGHTRECORDER_HPP_
@@ -0,0 +1,192 @@
+/*
+**  Copyright (C) 2018 Aldebaran Robotics
+**  See COPYING for the license
+*/
+
+#include <cstring>
+
+#include "lz4block.hpp"
+
+/// LZ4 block format reminder (see the public format description):
+///
+/// A block is a sequence of "sequences". Each sequence is:
+/// - a token byte: high nibble = literal count, low nibble = match length - 4;
+///   a nibble of 15 means "extended length follows": add the following bytes
+///   until one is not 255,
+/// - the literals themselves,
+/// - a 2-byte little-endian match offset (1..65535), pointing back into the
+///   already-decoded output,
+/// - the match length extension bytes, if the low nibble was 15.
+/// The last sequence of a block stops after its literals.
+///
+/// Compressor-side restrictions of the format: the last 5 bytes are always
+/// literals, and the last match must start at least 12 bytes before the end
+/// of the block. Short inputs are therefore emitted as a single literal run.
+
+namespace qi
+{
+namespace lz4block
+{
+  namespace
+  {
+    const std::size_t minMatch = 4;
+    const std::size_t lastLiterals = 5;
+    // No match may start closer than this to the end of the input.
+    const std::size_t matchStartMargin = 12;
+    const std::size_t maxOffset = 65535;
+
+    // 8192 entries of 4 bytes: small enough to set up per message, large
+    // enough that few-kilobyte payloads rarely collide.
+    const unsigned int hashBits = 13;
+
+    inline qi::uint32_t read32(const unsigned char* p)
+    {
+      qi::uint32_t v;
+      std::memcpy(&v, p, sizeof v);
+      return v;
+    }
+
+    inline unsigned int hash4(const unsigned char* p)
+    {
+      // Knuth multiplicative hash of the next 4 bytes.
+      return static_cast<unsigned int>((read32(p) * 2654435761u) >> (32 - hashBits));
+    }
+
+    /// Append a length nibble extension (LZ4 "15 then bytes of 255" scheme).
+    inline void putExtendedLength(std::vector<unsigned char>& out, std::size_t length)
+    {
+      while (length >= 255)
+      {
+        out.push_back(255);
+        length -= 255;
+      }
+      out.push_back(static_cast<unsigned char>(length));
+    }
+
+    /// Append one sequence: literals [litBegin, litBegin + litCount), then,
+    /// if matchLength != 0, a match of that length at the given offset.
+    void putSequence(std::vector<unsigned char>& out,
+                     const unsigned char* litBegin, std::size_t litCount,
+                     std::size_t offset, std::size_t matchLength)
+    {
+      const std::size_t litNibble = litCount < 15 ? litCount : 15;
+      const std::size_t matchCode = matchLength == 0 ? 0 : matchLength - minMatch;
+      const std::size_t matchNibble = matchCode < 15 ? matchCode : 15;
+      out.push_back(static_cast<unsigned char>((litNibble << 4) | matchNibble));
+      if (litNibble == 15)
+        putExtendedLength(out, litCount - 15);
+      out.insert(out.end(), litBegin, litBegin + litCount);
+      if (matchLength == 0)
+        return; // last sequence of the block
+      out.push_back(static_cast<unsigned char>(offset & 0xff));
+      out.push_back(static_cast<unsigned char>(offset >> 8));
+      if (matchNibble == 15)
+        putExtendedLength(out, matchCode - 15);
+    }
+  }
+
+  void compress(const unsigned char* src, std::size_t size,
+                std::vector<unsigned char>& out)
+  {
+    if (size < matchStartMargin + 1)
+    {
+      // Too short for any match: a single literal run.
+      putSequence(out, src, size, 0, 0);
+      return;
+    }
+
+    // Positions of previously seen 4-byte sequences, by hash.
+    // 32-bit positions are enough: payloads are bounded well below 2^31
+    // (see getMaxPayloadFromEnv).
+    std::vector<qi::int32_t> table(std::size_t{1} << hashBits, -1);
+
+    const std::size_t matchStartLimit = size - matchStartMargin;
+    const std::size_t matchEndLimit = size - lastLiterals;
+    std::size_t pos = 0;
+    std::size_t anchor = 0; // first literal not yet emitted
+    while (pos < matchStartLimit)
+    {
+      const unsigned int h = hash4(src + pos);
+      const qi::int32_t candidate = table[h];
+      table[h] = static_cast<qi::int32_t>(pos);
+      if (candidate < 0 || pos - static_cast<std::size_t>(candidate) > maxOffset ||
+          read32(src + candidate) != read32(src + pos))
+      {
+        ++pos;
+        continue;
+      }
+      const std::size_t match = static_cast<std::size_t>(candidate);
+      std::size_t matchLength = minMatch;
+      while (pos + matchLength < matchEndLimit &&
+             src[match + matchLength] == src[pos + matchLength])
+        ++matchLength;
+      putSequence(out, src + anchor, pos - anchor, pos - match, matchLength);
+      pos += matchLength;
+      anchor = pos;
+    }
+    putSequence(out, src + anchor, size - anchor, 0, 0);
+  }
+
+  bool decompress(const unsigned char* src, std::size_t srcSize,
+                  unsigned char* dst, std::size_t dstSize)
+  {
+    std::size_t ip = 0;
+    std::size_t op = 0;
+    while (ip < srcSize)
+    {
+      const unsigned char token = src[ip++];
+      // literals
+      std::size_t litCount = token >> 4;
+      if (litCount == 15)
+      {
+        unsigned char b;
+        do
+        {
+          if (ip >= srcSize)
+            return false;
+          b = src[ip++];
+          litCount += b;
+        } while (b == 255);
+      }
+      if (litCount > srcSize - ip || litCount > dstSize - op)
+        return false;
+      if (litCount != 0)
+      {
+        std::memcpy(dst + op, src + ip, litCount);
+        ip += litCount;
+        op += litCount;
+      }
+      if (ip == srcSize)
+        break; // last sequence: literals only
+      // match
+      if (srcSize - ip < 2)
+        return false;
+      const std::size_t offset = src[ip] | (static_cast<std::size_t>(src[ip + 1]) << 8);
+      ip += 2;
+      if (offset == 0 || offset > op)
+        return false;
+      std::size_t matchLength = (token & 0xf) + minMatch;
+      if ((token & 0xf) == 15)
+      {
+        unsigned char b;
+        do
+        {
+          if (ip >= srcSize)
+            return false;
+          b = src[ip++];
+          matchLength += b;
+        } while (b == 255);
+      }
+      if (matchLength > dstSize - op)
+        return false;
+      // Byte-by-byte on purpose: the match may overlap the bytes being
+      // written (offset < matchLength encodes a repetition).
+      const unsigned char* match = dst + op - offset;
+      for (std::size_t i = 0; i != matchLength; ++i)
+        dst[op + i] = match[i];
+      op += matchLength;
+    }
+    return op == dstSize;
+  }
+}
+}
@@ -0,0 +1,52 @@
+#pragma once
+/*
+**  Copyright (C) 2018 Aldebaran Robotics
+**  See COPYING for the license
+*/
+
+#ifndef _SRC_MESSAGING_LZ4BLOCK_HPP_
+#define _SRC_MESSAGING_LZ4BLOCK_HPP_
+
+#include <cstddef>
+#include <vector>
+#include <qi/api.hpp>
+#include <qi/types.hpp>
+
+namespace qi
+{
+  /// Self-contained implementation of the LZ4 block format, used to compress
+  /// message payloads on bandwidth-bound links.
+  ///
+  /// Only the raw block format is implemented (no frame header, no
+  /// checksums): the messaging layer already delimits payloads and carries
+  /// their sizes, so the frame layer would be pure overhead. The produced
+  /// blocks are compatible with any conforming LZ4 block decoder, which
+  /// leaves the door open to switching to the reference library later
+  /// without a protocol change.
+  ///
+  /// The compressor is a greedy single-pass matcher tuned for speed rather
+  /// than ratio, which is the right trade-off for per-message compression.
+  namespace lz4block
+  {
+    /// Append to `out` the LZ4 block encoding of `src[0..size)`.
+    ///
+    /// The output is appended so that the caller can prepend its own header
+    /// (typically the decompressed size, which the block format does not
+    /// carry).
+    ///
+    /// Precondition: `src` is valid over `size` bytes.
+    QI_API void compress(const unsigned char* src, std::size_t size,
+                         std::vector<unsigned char>& out);
+
+    /// Decode the LZ4 block `src[0..srcSize)` into `dst[0..dstSize)`.
+    ///
+    /// Returns false if the input is not a well-formed block decoding to
+    /// exactly `dstSize` bytes; `dst` contents are then unspecified.
+    /// All reads and writes are bound-checked against the given sizes, so
+    /// malformed input from the network cannot read or write out of bounds.
+    QI_API bool decompress(const unsigned char* src, std::size_t srcSize,
+                           unsigned char* dst, std::size_t dstSize);
+  }
+}
+
+#endif  // _SRC_MESSAGING_LZ4BLOCK_HPP_
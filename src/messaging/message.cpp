@@ -2,10 +2,12 @@
 **  Copyright (C) 2012 Aldebaran Robotics
 **  See COPYING for the license
 */
+#include <algorithm>
 #include <cstring>
 
 #include <boost/make_shared.hpp>
 #include <boost/container/small_vector.hpp>
+#include <boost/thread/mutex.hpp>
 
 #include <qi/assert.hpp>
 #include <qi/anyvalue.hpp>
@@ -13,20 +15,142 @@
 
 #include <qi/atomic.hpp>
 #include <qi/log.hpp>
+#include <qi/messaging/calldeadline.hpp>
+#include <qi/messaging/messagepriority.hpp>
+#include <qi/messaging/replydelivery.hpp>
 #include <boost/cstdint.hpp>
 #include <qi/types.hpp>
 #include <qi/buffer.hpp>
 #include <qi/binarycodec.hpp>
+#include <qi/eventloop.hpp>
+#include <qi/os.hpp>
 
 #include "boundobject.hpp"
+#include "lz4block.hpp"
 #include "remoteobject_p.hpp"
 
 qiLogCategory("qimessaging.message");
 
 namespace qi
 {
+  namespace
+  {
+    thread_local MessagePriority threadMessagePriority = MessagePriority::Normal;
+  }
+
+  ScopedMessagePriority::ScopedMessagePriority(MessagePriority priority)
+    : _previous(threadMessagePriority)
+  {
+    threadMessagePriority = priority;
+  }
+
+  ScopedMessagePriority::~ScopedMessagePriority()
+  {
+    threadMessagePriority = _previous;
+  }
+
+  namespace detail
+  {
+    MessagePriority currentMessagePriority()
+    {
+      return threadMessagePriority;
+    }
+  }
+
+  namespace
+  {
+    thread_local ReplyDelivery threadReplyDelivery = ReplyDelivery::Scheduled;
+  }
+
+  ScopedReplyDelivery::ScopedReplyDelivery(ReplyDelivery delivery)
+    : _previous(threadReplyDelivery)
+  {
+    threadReplyDelivery = delivery;
+  }
+
+  ScopedReplyDelivery::~ScopedReplyDelivery()
+  {
+    threadReplyDelivery = _previous;
+  }
+
+  namespace detail
+  {
+    ReplyDelivery currentReplyDelivery()
+    {
+      return threadReplyDelivery;
+    }
+  }
+
+  namespace
+  {
+    thread_local qi::Duration threadCallDeadline = qi::Duration::zero();
+  }
+
+  ScopedCallDeadline::ScopedCallDeadline(qi::Duration budget)
+    : _previous(threadCallDeadline)
+  {
+    threadCallDeadline = budget;
+  }
+
+  ScopedCallDeadline::~ScopedCallDeadline()
+  {
+    threadCallDeadline = _previous;
+  }
+
+  namespace detail
+  {
+    qi::Duration currentCallDeadline()
+    {
+      return threadCallDeadline;
+    }
+  }
+
   const qi::uint32_t Message::Header::magicCookie = 0x42adde42;
 
+  const qi::uint8_t Message::CompactHeader::marker;
+  const std::size_t Message::CompactHeader::size;
+
+  bool Message::CompactHeader::fits(const Header& header)
+  {
+    return header.service < 0x10000u && header.object < 0x10000u &&
+           header.action < 0x10000u;
+  }
+
+  void Message::CompactHeader::encode(const Header& header, qi::uint8_t* dst)
+  {
+    QI_ASSERT(fits(header));
+    dst[0] = marker;
+    dst[1] = header.type;
+    dst[2] = header.flags;
+    dst[3] = 0; // reserved
+    const qi::uint16_t service = static_cast<qi::uint16_t>(header.service);
+    const qi::uint16_t object = static_cast<qi::uint16_t>(header.object);
+    const qi::uint16_t action = static_cast<qi::uint16_t>(header.action);
+    std::memcpy(dst + 4, &header.id, 4);
+    std::memcpy(dst + 8, &header.size, 4);
+    std::memcpy(dst + 12, &service, 2);
+    std::memcpy(dst + 14, &object, 2);
+    std::memcpy(dst + 16, &action, 2);
+  }
+
+  void Message::CompactHeader::decode(const qi::uint8_t* src, Header& header)
+  {
+    QI_ASSERT(src[0] == marker);
+    header.magic = Header::magicCookie;
+    header.version = Header::currentVersion();
+    header.type = src[1];
+    header.flags = src[2];
+    qi::uint16_t service = 0, object = 0, action = 0;
+    std::memcpy(&header.id, src + 4, 4);
+    std::memcpy(&header.size, src + 8, 4);
+    std::memcpy(&service, src + 12, 2);
+    std::memcpy(&object, src + 14, 2);
+    std::memcpy(&action, src + 16, 2);
+    header.service = service;
+    header.object = object;
+    header.action = action;
+  }
+
   qi::uint32_t Message::Header::newMessageId()
   {
     static std::atomic<qi::uint32_t> id(0);
@@ -72,6 +196,10 @@ namespace qi
       return "MetaObject";
     case BoundObjectFunction_Terminate:
       return "Terminate";
+    case BoundObjectFunction_TerminateBatch:
+      return "TerminateBatch";
+    case BoundObjectFunction_MetaObjectHash:
+      return "MetaObjectHash";
     case BoundObjectFunction_GetProperty:
       return "GetProperty";
     case BoundObjectFunction_SetProperty:
@@ -197,6 +325,98 @@ namespace qi
     return _header.action;
   }
 
+  namespace
+  {
+    /// Wire bytes of a payload: the main buffer with the sub-buffer contents
+    /// interleaved after their size fields, exactly as the socket layer lays
+    /// them out for the network (see sock::appendBuffers).
+    std::vector<unsigned char> flattenPayload(const Buffer& buffer)
+    {
+      std::vector<unsigned char> flat;
+      flat.reserve(buffer.totalSize());
+      const auto data = static_cast<const unsigned char*>(buffer.data());
+      size_t beginOffset = 0;
+      for (const auto& sub: buffer.subBuffers())
+      {
+        const size_t endOffset = sub.first + sizeof(Buffer::size_type);
+        flat.insert(flat.end(), data + beginOffset, data + endOffset);
+        beginOffset = endOffset;
+        const Buffer& subBuffer = sub.second;
+        const auto subData = static_cast<const unsigned char*>(subBuffer.data());
+        flat.insert(flat.end(), subData, subData + subBuffer.size());
+      }
+      flat.insert(flat.end(), data + beginOffset, data + buffer.size());
+      return flat;
+    }
+  }
+
+  bool Message::compressPayload()
+  {
+    QI_ASSERT(!(flags() & TypeFlag_Compressed));
+    const std::vector<unsigned char> plain = flattenPayload(_buffer);
+    if (plain.empty())
+      return false;
+    // The block format does not carry the decompressed size: prepend it.
+    const qi::uint32_t plainSize = static_cast<qi::uint32_t>(plain.size());
+    std::vector<unsigned char> packed(sizeof plainSize);
+    std::memcpy(packed.data(), &plainSize, sizeof plainSize);
+    lz4block::compress(plain.data(), plain.size(), packed);
+    if (packed.size() >= plain.size())
+      return false; // incompressible payload, keep it as-is
+    Buffer compressed;
+    compressed.write(packed.data(), packed.size());
+    setBuffer(std::move(compressed));
+    addFlags(TypeFlag_Compressed);
+    return true;
+  }
+
+  bool Message::decompressPayload()
+  {
+    if (!(flags() & TypeFlag_Compressed))
+      return true;
+    const auto data = static_cast<const unsigned char*>(_buffer.data());
+    const size_t size = _buffer.size();
+    qi::uint32_t plainSize = 0;
+    if (size < sizeof plainSize)
+      return false;
+    std::memcpy(&plainSize, data, sizeof plainSize);
+    // LZ4 expands at most 255x, so a bigger announced size cannot be honest.
+    // This bounds the allocation a corrupt or malicious header can cause.
+    if (plainSize / 255 > size)
+      return false;
+    Buffer plain;
+    const auto dst = static_cast<unsigned char*>(plain.reserve(plainSize));
+    if (!lz4block::decompress(data + sizeof plainSize, size - sizeof plainSize,
+                              dst, plainSize))
+      return false;
+    setFlags(static_cast<qi::uint8_t>(flags() & ~TypeFlag_Compressed));
+    setBuffer(std::move(plain));
+    return true;
+  }
+
+  std::list<Message> Message::splitPayload(size_t maxFragmentSize) const
+  {
+    QI_ASSERT(maxFragmentSize != 0);
+    const std::vector<unsigned char> plain = flattenPayload(_buffer);
+    QI_ASSERT(!plain.empty());
+    std::list<Message> fragments;
+    size_t offset = 0;
+    while (offset < plain.size())
+    {
+      const size_t chunk = std::min(maxFragmentSize, plain.size() - offset);
+      Message fragment;
+      fragment._header = _header;
+      Buffer buffer;
+      buffer.write(plain.data() + offset, chunk);
+      fragment.setBuffer(std::move(buffer));
+      offset += chunk;
+      if (offset != plain.size())
+        fragment.addFlags(TypeFlag_MoreFragments);
+      fragments.push_back(std::move(fragment));
+    }
+    return fragments;
+  }
+
   namespace
   {
     ObjectSerializationInfo serializeObject(
@@ -234,6 +454,74 @@ namespace qi
       return res;
     }
 
+    /// Terminate batching: one terminateBatch post per (socket, service)
+    /// and per batching window (QI_TERMINATE_BATCH_WINDOW_MS, default 10),
+    /// instead of one terminate post per released proxy. Dropping a whole
+    /// proxy graph then costs a handful of messages instead of thousands.
+    class TerminateBatcher
+    {
+    public:
+      static TerminateBatcher& instance()
+      {
+        // Leaked on purpose: proxies may still be released during static
+        // destruction.
+        static TerminateBatcher* batcher = new TerminateBatcher;
+        return *batcher;
+      }
+
+      void add(const MessageSocketPtr& socket, unsigned int service, unsigned int objectId)
+      {
+        bool scheduleFlush = false;
+        {
+          boost::mutex::scoped_lock lock(_mutex);
+          _pending[std::make_pair(socket, service)].push_back(objectId);
+          scheduleFlush = !_flushScheduled;
+          _flushScheduled = true;
+        }
+        if (scheduleFlush)
+        {
+          static const auto window =
+              MilliSeconds{os::getEnvParam<int64_t>("QI_TERMINATE_BATCH_WINDOW_MS", 10)};
+          getEventLoop()->asyncDelay([this] { flush(); }, window);
+        }
+      }
+
+    private:
+      void flush()
+      {
+        PendingMap pending;
+        {
+          boost::mutex::scoped_lock lock(_mutex);
+          pending.swap(_pending);
+          _flushScheduled = false;
+        }
+        for (auto& group: pending)
+        {
+          const MessageSocketPtr& socket = group.first.first;
+          std::vector<unsigned int>& ids = group.second;
+          if (!socket->isConnected())
+            continue; // The remote end drops its references on disconnection.
+          Message msg;
+          msg.setType(Message::Type_Post);
+          msg.setService(group.first.second);
+          // Routed through one of the dying objects; it is still hosted,
+          // since removing it is precisely what this message requests.
+          msg.setObject(ids.front());
+          msg.setFunction(Message::BoundObjectFunction_TerminateBatch);
+          std::vector<AnyReference> params;
+          params.push_back(AnyReference::from(ids));
+          msg.setValues(params, "([I])", {}, socket.get());
+          socket->send(std::move(msg));
+        }
+      }
+
+      using PendingMap =
+          std::map<std::pair<MessageSocketPtr, unsigned int>, std::vector<unsigned int>>;
+      boost::mutex _mutex;
+      PendingMap _pending;
+      bool _flushScheduled = false;
+    };
+
     void onProxyLost(GenericObject* ptr)
     {
       qiLogDebug() << "Proxy on argument object lost, invoking terminate...";
@@ -244,6 +532,18 @@ namespace qi
       * do using shared_from_this().
       * So go through backend
       */
+      // Batch when the remote end advertises terminateBatch (the method is
+      // part of the transmitted metaobject, so old peers simply lack it and
+      // keep receiving one terminate per object).
+      RemoteObject* robj = static_cast<RemoteObject*>(dobj);
+      if (dobj->metaObject().methodId("terminateBatch::([I])") >= 0)
+      {
+        if (MessageSocketPtr socket = robj->socket())
+        {
+          TerminateBatcher::instance().add(socket, robj->service(), robj->object());
+          return;
+        }
+      }
       //FIXME: use post()
       int mid = dobj->metaObject().methodId("terminate::(I)");
       if (mid<0)
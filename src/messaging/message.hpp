@@ -19,6 +19,7 @@
 #include <qi/assert.hpp>
 #include <ka/scoped.hpp>
 #include <boost/weak_ptr.hpp>
+#include <list>
 
 namespace qi {
 
@@ -90,6 +91,35 @@ namespace qi {
     };
     static_assert(sizeof(Header) == 28, "Message::Header does not have the right size!");
 
+    /** Optional 18-byte wire form of the header, used instead of the 28-byte
+     * Header when both ends advertised the CompactHeader capability and the
+     * ids fit (service, object and action below 65536).
+     *
+     * Layout: marker byte, type, flags, one reserved byte, then id and size
+     * as in the full header, then 16-bit service, object and action. The
+     * magic cookie is implied by the marker and the version by the
+     * negotiation: the compact form is only exchanged between ends speaking
+     * the current protocol version.
+     *
+     * A connection may carry a mix of both forms: a message whose ids do not
+     * fit keeps the full header, and the receiver tells the forms apart from
+     * the first byte (the magic cookie 0x42adde42 starts and ends with 0x42,
+     * so a full header always starts with 0x42 on the wire, whatever the
+     * endianness; the marker must differ from it).
+     */
+    struct CompactHeader
+    {
+      static const qi::uint8_t marker = 0x51;
+      static const std::size_t size = 18;
+      /// True when the header ids fit the compact form.
+      QI_API static bool fits(const Header& header);
+      /// Write the compact form of `header` into `dst` (`size` bytes).
+      /// Precondition: fits(header)
+      QI_API static void encode(const Header& header, qi::uint8_t* dst);
+      /// Rebuild a full header from `src` (`size` bytes starting with
+      /// `marker`). Sets magic and version to their implied values.
+      QI_API static void decode(const qi::uint8_t* src, Header& header);
+    };
 
     // Fixed service id numbers
     enum Service
@@ -113,6 +143,15 @@ namespace qi {
       BoundObjectFunction_SetProperty       = 6,
       BoundObjectFunction_Properties        = 7,
       BoundObjectFunction_RegisterEventWithSignature = 8,
+      BoundObjectFunction_CallBatch         = 9,
+      BoundObjectFunction_GetProperties     = 10,
+      BoundObjectFunction_SetProperties     = 11,
+      BoundObjectFunction_RegisterEventWithRate = 12,
+      BoundObjectFunction_SetEventRate      = 13,
+      BoundObjectFunction_SetEventWindow    = 14,
+      BoundObjectFunction_AckEvent          = 15,
+      BoundObjectFunction_TerminateBatch    = 16,
+      BoundObjectFunction_MetaObjectHash    = 17,
     };
 
     enum ServerFunction
@@ -162,6 +201,43 @@ namespace qi {
      * NOT IMPLEMENTED
      */
     static const unsigned int TypeFlag_ReturnType = 2;
+    /* If flag is set, the payload is LZ4-compressed: a uint32 with the
+     * decompressed payload size, followed by one LZ4 block.
+     * Only sent when both ends advertised the MessageCompression capability.
+     */
+    static const unsigned int TypeFlag_Compressed = 4;
+    /* If flag is set, the payload is one fragment of a larger message and
+     * more fragments with the same id follow. The last fragment does not
+     * carry the flag; the receiver concatenates the payloads in arrival
+     * order. Only sent when both ends advertised the MessageFragmentation
+     * capability.
+     */
+    static const unsigned int TypeFlag_MoreFragments = 8;
+    /* If flag is set, the message is latency-critical: the send queue moves
+     * it ahead of queued normal-priority messages (see qi::MessagePriority).
+     * Purely a scheduling hint; receivers need not interpret it.
+     */
+    static const unsigned int TypeFlag_HighPriority = 16;
+    /* If flag is set on an event message, the payload is a delta against
+     * the previous event of the same stream: a uint32 mask of the struct
+     * fields that changed, followed by the serialized changed fields in
+     * order. Full payloads (keyframes) travel without the flag. Only sent
+     * when both ends advertised the DeltaEvents capability.
+     */
+    static const unsigned int TypeFlag_DeltaPayload = 32;
+    /* If flag is set on a Type_Cancel message, the payload is a list of
+     * call ids ("[I]") instead of a single one ("I"): one message cancels
+     * a whole batch of calls. Only sent when both ends advertised the
+     * BatchCancel capability.
+     */
+    static const unsigned int TypeFlag_BatchCancel = 64;
+    /* If flag is set, a uint32 completion budget in milliseconds is
+     * appended to the payload, after the TypeFlag_ReturnType signature
+     * when both are present. A server dequeuing the call after the budget
+     * ran out replies "call deadline expired" instead of invoking it.
+     * Only sent when both ends advertised the CallDeadline capability.
+     */
+    static const unsigned int TypeFlag_CallDeadline = 128;
 
     QI_API static const char* typeToString(Type t);
     QI_API static const char* actionToString(unsigned int action, unsigned int service);
@@ -284,6 +360,58 @@ namespace qi {
       return extracted;
     }
 
+    /** Replace the payload by its LZ4-compressed form and set
+     * TypeFlag_Compressed.
+     * Returns false and leaves the message unchanged if compression does not
+     * shrink the payload (e.g. already-compressed data).
+     * Must only be used when the remote end advertised the
+     * MessageCompression capability.
+     */
+    QI_API bool compressPayload();
+
+    /** Reverse of compressPayload(): replace a TypeFlag_Compressed payload
+     * by its decompressed form and clear the flag.
+     * Returns false if the payload is corrupt, in which case the message
+     * must be discarded. No-op on messages without the flag.
+     */
+    QI_API bool decompressPayload();
+
+    /** Use the compact wire header (see CompactHeader) when the ids fit;
+     * no effect otherwise. Captures the header at call time, so call it
+     * last, right before handing the message to the socket.
+     * Must only be used when the remote end advertised the CompactHeader
+     * capability.
+     */
+    void enableCompactHeader()
+    {
+      _compactOnWire = CompactHeader::fits(_header);
+      if (_compactOnWire)
+        CompactHeader::encode(_header, _compactWire);
+    }
+
+    /// True when the message must be sent with the compact header.
+    bool compactOnWire() const
+    {
+      return _compactOnWire;
+    }
+
+    /// The encoded compact header (CompactHeader::size bytes).
+    /// Precondition: compactOnWire()
+    const qi::uint8_t* compactWireHeader() const
+    {
+      return _compactWire;
+    }
+
+    /** Split the payload into messages of at most maxFragmentSize payload
+     * bytes, all sharing this message's header. Every fragment but the last
+     * carries TypeFlag_MoreFragments; concatenating the payloads in order
+     * reconstructs this message.
+     * Must only be used when the remote end advertised the
+     * MessageFragmentation capability.
+     * Precondition: the payload is not empty and maxFragmentSize is not 0.
+     */
+    QI_API std::list<Message> splitPayload(size_t maxFragmentSize) const;
+
     void setError(const std::string &error)
     {
       QI_ASSERT(type() == Type_Error && "called setError on a non Type_Error message");
@@ -338,6 +466,8 @@ namespace qi {
     Buffer _buffer;
     std::string signature;
     Header _header;
+    bool _compactOnWire = false;
+    qi::uint8_t _compactWire[CompactHeader::size];
 
     void encodeBinary(const qi::AutoAnyReference& ref,
                       SerializeObjectCallback onObject,
@@ -0,0 +1,102 @@
+/*
+**  Copyright (C) 2026 Softbank Robotics
+**  See COPYING for the license
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <string>
+
+#include <qi/buffer.hpp>
+#include <qi/clock.hpp>
+#include <qi/log.hpp>
+#include <qi/os.hpp>
+
+#include "messagecapture.hpp"
+#include "message.hpp"
+
+qiLogCategory("qimessaging.capture");
+
+namespace qi
+{
+  namespace
+  {
+    const std::string& captureFileFromEnv()
+    {
+      static const std::string path = os::getenv("QI_MESSAGE_CAPTURE");
+      return path;
+    }
+
+    int64_t nowUs()
+    {
+      return boost::chrono::duration_cast<qi::MicroSeconds>(
+          SystemClock::now().time_since_epoch()).count();
+    }
+  }
+
+  const char MessageCapture::magic[8] = { 'q', 'i', 'c', 'a', 'p', 0, 0, 1 };
+
+  bool MessageCapture::enabled()
+  {
+    static const bool on = !captureFileFromEnv().empty();
+    return on;
+  }
+
+  MessageCapture& MessageCapture::instance()
+  {
+    static MessageCapture capture;
+    return capture;
+  }
+
+  MessageCapture::MessageCapture()
+    : _payloadBytes(os::getEnvParam<size_t>("QI_MESSAGE_CAPTURE_PAYLOAD_BYTES", 0))
+    , _sample(std::max<uint64_t>(
+          os::getEnvParam<uint64_t>("QI_MESSAGE_CAPTURE_SAMPLE", 1), 1))
+  {
+    const std::string path =
+        captureFileFromEnv() + "." + os::to_string(os::getpid());
+    _file.open(path.c_str(), std::ios::binary | std::ios::trunc);
+    if (!_file)
+    {
+      qiLogWarning() << "Cannot open message capture file " << path
+                     << ", capture disabled.";
+      return;
+    }
+    _file.write(magic, sizeof(magic));
+    qiLogInfo() << "Capturing messages to " << path;
+  }
+
+  void MessageCapture::record(const void* socket, const Message& msg, bool sent)
+  {
+    const Buffer& payload = msg.buffer();
+    boost::mutex::scoped_lock lock(_mutex);
+    if (!_file)
+      return;
+    const uint64_t n = _count++;
+    uint32_t& socketId = _socketIds[socket];
+    if (socketId == 0)
+      socketId = static_cast<uint32_t>(_socketIds.size());
+
+    RecordHeader record;
+    std::memset(&record, 0, sizeof(record));
+    record.timestampUs = nowUs();
+    record.socketId = socketId;
+    // Payloads are sampled: only the main buffer of every _sample-th
+    // message, truncated, so a capture stays compact under load.
+    size_t stored = 0;
+    if (_payloadBytes > 0 && n % _sample == 0)
+      stored = std::min(_payloadBytes, payload.size());
+    record.payloadBytes = static_cast<uint32_t>(stored);
+    record.sent = sent ? 1 : 0;
+
+    _file.write(reinterpret_cast<const char*>(&record), sizeof(record));
+    _file.write(reinterpret_cast<const char*>(&msg.header()),
+                sizeof(Message::Header));
+    if (stored > 0)
+      _file.write(static_cast<const char*>(payload.data()), stored);
+    // Bound what a crash can lose without paying a flush per message.
+    if (n % 1024 == 0)
+      _file.flush();
+  }
+}
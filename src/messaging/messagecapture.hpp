@@ -0,0 +1,70 @@
+#pragma once
+/*
+**  Copyright (C) 2026 Softbank Robotics
+**  See COPYING for the license
+*/
+
+#ifndef _SRC_MESSAGING_MESSAGECAPTURE_HPP_
+#define _SRC_MESSAGING_MESSAGECAPTURE_HPP_
+
+#include <cstdint>
+#include <fstream>
+#include <map>
+
+#include <boost/thread/mutex.hpp>
+
+namespace qi
+{
+  class Message;
+
+  /// Opt-in capture of the messaging traffic to a file, so a production
+  /// incident can be replayed in the lab at original or accelerated pacing
+  /// (see benchmarks/replay_qimessaging.cpp). Unlike the FlightRecorder ring
+  /// it keeps everything it sees, so it costs a file write per message and
+  /// stays off unless explicitly requested.
+  ///
+  /// QI_MESSAGE_CAPTURE names the capture file; the process id is appended
+  /// so one setting covers every process of a robot. Empty (the default)
+  /// disables the capture entirely. Headers are always stored; payloads are
+  /// stored truncated to QI_MESSAGE_CAPTURE_PAYLOAD_BYTES (0, the default,
+  /// stores none) for one message out of QI_MESSAGE_CAPTURE_SAMPLE (1: all).
+  ///
+  /// File format, fields in host byte order: the 8-byte `magic`, then one
+  /// record per message: a RecordHeader, the 28-byte wire header, and
+  /// `payloadBytes` bytes of payload.
+  class MessageCapture
+  {
+  public:
+    struct RecordHeader
+    {
+      int64_t timestampUs;   ///< SystemClock, so it lines up with the log dates.
+      uint32_t socketId;     ///< Tells the capture's streams apart.
+      uint32_t payloadBytes; ///< Stored bytes, not the original payload size.
+      uint8_t sent;          ///< 1 sent, 0 received.
+      uint8_t reserved[7];   ///< Zero; keeps the record size a round 24 bytes.
+    };
+    static_assert(sizeof(RecordHeader) == 24, "RecordHeader does not have the right size!");
+
+    /// "qicap", a zero byte, and the format version.
+    static const char magic[8];
+
+    /// Whether QI_MESSAGE_CAPTURE is set; read once.
+    static bool enabled();
+    static MessageCapture& instance();
+
+    /// Appends one record. `socket` is only used as a stream identity.
+    void record(const void* socket, const Message& msg, bool sent);
+
+  private:
+    MessageCapture();
+
+    boost::mutex _mutex;
+    std::ofstream _file;
+    std::map<const void*, uint32_t> _socketIds;
+    uint64_t _count = 0;
+    const size_t _payloadBytes;
+    const uint64_t _sample;
+  };
+}
+
+#endif  // _SRC_MESSAGING_MESSAGECAPTURE_HPP_
@@ -2,7 +2,10 @@
 **  Copyright (C) 2012 Aldebaran Robotics
 **  See COPYING for the license
 */
+#include <boost/make_shared.hpp>
+
 #include "messagedispatcher.hpp"
+#include "../trace_p.hpp"
 
 qiLogCategory("qimessaging.messagedispatcher");
 
@@ -35,10 +38,12 @@ namespace qi {
 
   MessageDispatcher::MessageDispatcher(ExecutionContext* execContext)
     : _execContext{ execContext }
+    , _nextLink{ 0 }
   {
   }
 
   void MessageDispatcher::dispatch(const qi::Message& msg) {
+    QI_TRACE4(message_dispatch, msg.id(), msg.type(), msg.service(), msg.object());
     //remove the address from the messageSent map
     if (msg.type() == qi::Message::Type_Reply)
     {
@@ -52,68 +57,75 @@ namespace qi {
     }
 
     {
-      boost::shared_ptr<OnMessageSignal> sig[2];
+      boost::shared_ptr<const HandlerList> handlers[2];
       bool hit = false;
+      // Lock-free lookup on the published snapshot: registration churn from
+      // other threads republishes a new snapshot instead of blocking us.
+      const auto handlerMap = boost::atomic_load(&_handlerMapSnapshot);
+      if (handlerMap)
       {
-        boost::recursive_mutex::scoped_lock sl(_signalMapMutex);
-        SignalMap::iterator it;
-        it = _signalMap.find(Target(msg.service(), msg.object()));
-        if (it != _signalMap.end())
+        HandlerMap::const_iterator it;
+        it = handlerMap->find(Target(msg.service(), msg.object()));
+        if (it != handlerMap->end())
         {
           hit = true;
-          sig[0] = it->second;
+          handlers[0] = it->second;
         }
-        it = _signalMap.find(Target(msg.service(), ALL_OBJECTS));
-        if (it != _signalMap.end())
+        it = handlerMap->find(Target(msg.service(), ALL_OBJECTS));
+        if (it != handlerMap->end())
         {
           hit = true;
-          sig[1] = it->second;
+          handlers[1] = it->second;
         }
       }
-      if (sig[0])
-        (*sig[0])(msg);
-      if (sig[1])
-        (*sig[1])(msg);
+      // Plain calls on an immutable list: no subscriber bookkeeping, no
+      // type-erased invocation per message.
+      for (const auto& list: handlers)
+        if (list)
+          for (const auto& handler: *list)
+            handler.fun(msg);
       if (!hit) // FIXME: that should probably never happen, raise log level
         qiLogDebug() << "No listener for service " << msg.service();
     }
   }
 
+  void MessageDispatcher::publishHandlerMap()
+  {
+    // Precondition: _handlerMapMutex is held.
+    boost::atomic_store(&_handlerMapSnapshot,
+                        boost::shared_ptr<const HandlerMap>(boost::make_shared<HandlerMap>(_handlerMap)));
+  }
+
   qi::SignalLink
-  MessageDispatcher::messagePendingConnect(unsigned int serviceId, unsigned int objectId, boost::function<void (const qi::Message&)> fun) {
-    boost::recursive_mutex::scoped_lock sl(_signalMapMutex);
-    boost::shared_ptr<OnMessageSignal> &sig = _signalMap[Target(serviceId, objectId)];
-    if (!sig)
-      sig.reset(new OnMessageSignal(_execContext));
-    sig->setCallType(MetaCallType_Direct);
-    return sig->connect(fun);
+  MessageDispatcher::messagePendingConnect(unsigned int serviceId, unsigned int objectId, MessageHandler fun) {
+    boost::mutex::scoped_lock sl(_handlerMapMutex);
+    const qi::SignalLink link = ++_nextLink;
+    boost::shared_ptr<const HandlerList>& list = _handlerMap[Target(serviceId, objectId)];
+    // The published list is immutable, replace it instead of growing it.
+    auto newList = list ? boost::make_shared<HandlerList>(*list)
+                        : boost::make_shared<HandlerList>();
+    newList->push_back(Handler{link, std::move(fun)});
+    list = newList;
+    publishHandlerMap();
+    return link;
   }
 
   void MessageDispatcher::messagePendingDisconnect(unsigned int serviceId, unsigned int objectId, qi::SignalLink linkId)
   {
-    // Do not hold the lock when invoking disconnect()
-    // or deadlock may occur as disconnect() waits for
-    // handlers to finish before returning.
-    boost::shared_ptr<OnMessageSignal> sig;
-    {
-      boost::recursive_mutex::scoped_lock sl(_signalMapMutex);
-      SignalMap::iterator it;
-      it = _signalMap.find(Target(serviceId, objectId));
-      if (it != _signalMap.end())
-        sig = it->second;
-      else
-        return;
-    }
-    sig->disconnectAsync(linkId);
-    if (!sig->hasSubscribers())
-    {
-      // We need to re-acquire lock and check emptyness when locked
-       boost::recursive_mutex::scoped_lock sl(_signalMapMutex);
-       SignalMap::iterator it;
-       it = _signalMap.find(Target(serviceId, objectId));
-       if (it != _signalMap.end() && !it->second->hasSubscribers())
-         _signalMap.erase(it);
-    }
+    boost::mutex::scoped_lock sl(_handlerMapMutex);
+    HandlerMap::iterator it = _handlerMap.find(Target(serviceId, objectId));
+    if (it == _handlerMap.end())
+      return;
+    auto newList = boost::make_shared<HandlerList>();
+    newList->reserve(it->second->size());
+    for (const auto& handler: *it->second)
+      if (handler.link != linkId)
+        newList->push_back(handler);
+    if (newList->empty())
+      _handlerMap.erase(it);
+    else
+      it->second = newList;
+    publishHandlerMap();
   }
 
   void MessageDispatcher::cleanPendingMessages()
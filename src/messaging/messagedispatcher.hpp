@@ -18,8 +18,14 @@ namespace qi {
    * @brief The MessageDispatcher class dispatches messages from a TransportSocket
    * \internal
    *
-   * Receive message from a TransportSocket and send them on the appropriate
-   * signal, based on the serviceId of the message.
+   * Receive message from a TransportSocket and deliver them to the handler
+   * registered for the serviceId/objectId of the message.
+   *
+   * Dispatch targets are known, long-lived components (RemoteObject,
+   * BoundObject), so handlers are stored and invoked as plain callables:
+   * every inbound message skips the signal subscriber management and
+   * type-erased invocation. Observers wanting a signal can connect to the
+   * socket's `messageReady`, which is kept for diagnostics.
    *
    * This class generate an error message for all pending message that have timed out.
    * at the moment it only generate message if the socket have been disconnected.
@@ -37,19 +43,48 @@ namespace qi {
     void cleanPendingMessages();
 
     static const unsigned int ALL_OBJECTS;
-    qi::SignalLink messagePendingConnect(unsigned int serviceId, unsigned int objectId, boost::function<void (const qi::Message&)> fun);
+
+    using MessageHandler = boost::function<void (const qi::Message&)>;
+
+    /// Registers a handler called directly, in the dispatching thread, for
+    /// every message addressed to the given service/object. The returned
+    /// link identifies the registration for messagePendingDisconnect().
+    qi::SignalLink messagePendingConnect(unsigned int serviceId, unsigned int objectId, MessageHandler fun);
+    /// Removes a handler. A dispatch already in flight on the previous
+    /// snapshot may still invoke it once, as with an async signal
+    /// disconnection.
     void           messagePendingDisconnect(unsigned int serviceId, unsigned int objectId, qi::SignalLink linkId);
 
+  private:
+    /// Republish the read snapshot of the handler map.
+    /// Must be called with _handlerMapMutex held, after any map change.
+    void publishHandlerMap();
+
   public:
     using Target = std::pair<unsigned int, unsigned int>;
-    using OnMessageSignal = Signal<const qi::Message&>;
-    // use shared-ptr on signal so that we may hold it without holding the map lock
-    using SignalMap = std::map<Target, boost::shared_ptr<OnMessageSignal> >;
+    // One registration on a dispatch target.
+    struct Handler
+    {
+      qi::SignalLink link;
+      MessageHandler fun;
+    };
+    // Handler lists are immutable once published: (un)registration replaces
+    // the list, so a dispatching thread can run one without locking.
+    using HandlerList = std::vector<Handler>;
+    using HandlerMap = std::map<Target, boost::shared_ptr<const HandlerList> >;
     using MessageSentMap = std::map<unsigned int, MessageAddress>;
 
     ExecutionContext*      _execContext;
-    SignalMap              _signalMap;
-    boost::recursive_mutex _signalMapMutex;
+    // Master copy, only touched by (un)registration under _handlerMapMutex.
+    HandlerMap             _handlerMap;
+    boost::mutex           _handlerMapMutex;
+    // Link ids handed out by messagePendingConnect, under _handlerMapMutex.
+    qi::SignalLink         _nextLink;
+    // RCU-style read path: dispatch() works on an immutable snapshot loaded
+    // atomically, so the socket read thread never contends with
+    // connect/disconnect churn. Writers rebuild and republish the snapshot
+    // under _handlerMapMutex.
+    boost::shared_ptr<const HandlerMap> _handlerMapSnapshot;
 
     MessageSentMap         _messageSent;
     boost::mutex           _messageSentMutex;
@@ -1,4 +1,11 @@
+#include <algorithm>
+#include <set>
+
+#include <boost/thread/mutex.hpp>
+
 #include <qi/log.hpp>
+#include <qi/memorystats.hpp>
+#include <qi/os.hpp>
 #include <qi/messaging/sock/option.hpp>
 #include "messagesocket.hpp"
 #include "tcpmessagesocket.hpp"
@@ -20,15 +27,140 @@ namespace qi
     _signalsStrand.join();
   }
 
+  void MessageSocket::advertiseCapability(const std::string& key, const AnyValue& value)
+  {
+    StreamContext::advertiseCapability(key, value);
+    CapabilityMap cm;
+    cm[key] = value;
+    Message msg;
+    msg.setType(Message::Type_Capability);
+    msg.setService(Message::Service_Server);
+    msg.setValue(AnyValue::from(cm), typeOf<CapabilityMap>()->signature(), {}, this);
+    send(std::move(msg));
+  }
+
   bool MessageSocket::isConnected() const
   {
     return status() == qi::MessageSocket::Status::Connected;
   }
 
+  void MessageSocket::initSendBackpressureDefaults()
+  {
+    static const size_t high =
+        os::getEnvParam<size_t>("QIMESSAGING_SEND_QUEUE_HIGH_WATERMARK", 0);
+    static const size_t low =
+        os::getEnvParam<size_t>("QIMESSAGING_SEND_QUEUE_LOW_WATERMARK", high / 2);
+    static const int policy = os::getEnvParam<int>(
+        "QIMESSAGING_SEND_QUEUE_POLICY", static_cast<int>(SendQueuePolicy::DropEvents));
+    _sendHighWatermark.store(high);
+    _sendLowWatermark.store(std::min(low, high));
+    _sendQueuePolicy.store(static_cast<SendQueuePolicy>(policy));
+  }
+
+  void MessageSocket::setSendWatermarks(size_t high, size_t low)
+  {
+    _sendHighWatermark.store(high);
+    _sendLowWatermark.store(std::min(low, high));
+    if (high == 0)
+      _sendSaturated.store(false);
+  }
+
+  bool MessageSocket::acceptForSend(const Message& msg, size_t queuedBytes)
+  {
+    const size_t high = _sendHighWatermark.load();
+    const SendQueuePolicy policy = _sendQueuePolicy.load();
+    if (high == 0 || policy == SendQueuePolicy::Unbounded)
+      return true;
+    if (!_sendSaturated.load())
+    {
+      if (queuedBytes < high)
+        return true;
+      qiLogWarning() << this << " send queue reached its high watermark (" << queuedBytes
+                     << " >= " << high << " bytes), applying backpressure.";
+      _sendSaturated.store(true);
+    }
+    else if (queuedBytes <= _sendLowWatermark.load())
+    { // Drained in the meantime (e.g. only rejected messages since the drain).
+      _sendSaturated.store(false);
+      return true;
+    }
+    if (policy == SendQueuePolicy::DropEvents &&
+        msg.type() != Message::Type_Event && msg.type() != Message::Type_Post)
+      return true;
+    return false;
+  }
+
+  SocketStats MessageSocket::stats() const
+  {
+    SocketStats stats;
+    stats.url = url().str();
+    stats.messagesSent = _messagesSent.load(std::memory_order_relaxed);
+    stats.bytesSent = _bytesSent.load(std::memory_order_relaxed);
+    stats.messagesReceived = _messagesReceived.load(std::memory_order_relaxed);
+    stats.bytesReceived = _bytesReceived.load(std::memory_order_relaxed);
+    stats.sendQueueBytes = sendQueueBytes();
+    stats.sendQueuePeakBytes = _sendQueuePeakBytes.load(std::memory_order_relaxed);
+    stats.handshakeDurationUs = _handshakeDurationUs.load(std::memory_order_relaxed);
+    return stats;
+  }
+
+  void MessageSocket::setFlightRecorder(FlightRecorderPtr recorder)
+  {
+    _flightRecorderOwner = recorder;
+    _flightRecorder.store(recorder.get(), std::memory_order_release);
+  }
+
+  void MessageSocket::updateSendDrain(size_t queuedBytes)
+  {
+    if (!_sendSaturated.load())
+      return;
+    if (queuedBytes > _sendLowWatermark.load())
+      return;
+    _sendSaturated.store(false);
+    writable();
+  }
+
+  bool isKnownTransportProtocol(const std::string& protocol)
+  {
+    return protocol == "tcp" || protocol == "tcps";
+  }
+
   MessageSocketPtr makeMessageSocket(const std::string &protocol, qi::EventLoop *eventLoop)
   {
     return makeTcpMessageSocket(protocol, eventLoop);
   }
+
+  namespace detail
+  {
+    namespace
+    {
+      // Registry operations only happen at socket creation and destruction,
+      // so a plain mutex costs nothing on the messaging hot paths.
+      boost::mutex gSocketRegistryMutex;
+      std::set<MessageSocket*> gSocketRegistry;
+    }
+
+    void registerSocket(MessageSocket* socket)
+    {
+      boost::mutex::scoped_lock lock(gSocketRegistryMutex);
+      gSocketRegistry.insert(socket);
+    }
+
+    void unregisterSocket(MessageSocket* socket)
+    {
+      boost::mutex::scoped_lock lock(gSocketRegistryMutex);
+      gSocketRegistry.erase(socket);
+    }
+
+    void socketMemoryStats(MemoryStats& stats)
+    {
+      boost::mutex::scoped_lock lock(gSocketRegistryMutex);
+      stats.socketCount = gSocketRegistry.size();
+      stats.sendQueueBytes = 0;
+      for (MessageSocket* socket: gSocketRegistry)
+        stats.sendQueueBytes += socket->sendQueueBytes();
+    }
+  }
 }
 
 #if BOOST_COMP_MSVC
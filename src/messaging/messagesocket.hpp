@@ -6,13 +6,18 @@
 # include <boost/noncopyable.hpp>
 # include <boost/variant.hpp>
 # include <boost/optional.hpp>
+# include <qi/clock.hpp>
 # include <qi/future.hpp>
+# include <qi/messaging/socketstats.hpp>
 # include "message.hpp"
 # include <qi/url.hpp>
 # include <qi/eventloop.hpp>
 # include <qi/signal.hpp>
 # include <qi/binarycodec.hpp>
+# include <atomic>
 # include <string>
+# include "flightrecorder.hpp"
+# include "messagecapture.hpp"
 # include "messagedispatcher.hpp"
 # include "streamcontext.hpp"
 
@@ -53,6 +58,20 @@ namespace qi
       Event_Message = 1,
     };
 
+    /// What send() does with a message once the queued bytes reached the
+    /// high watermark (and until they drain back below the low one).
+    enum class SendQueuePolicy
+    {
+      /// Queue without bound (historical behavior).
+      Unbounded = 0,
+      /// Reject every message: send() returns false.
+      FailFast = 1,
+      /// Reject only event and post messages; calls, replies and the other
+      /// bookkeeping messages still go through. This lets publishers shed
+      /// load on a stalled subscriber without breaking RPC on the socket.
+      DropEvents = 2,
+    };
+
     explicit MessageSocket(qi::EventLoop* eventLoop = qi::getNetworkEventLoop())
       : _eventLoop(eventLoop)
       , _dispatcher{ &_signalsStrand }
@@ -62,11 +81,14 @@ namespace qi
       , disconnected{ &_signalsStrand }
       , messageReady{ &_signalsStrand }
       , socketEvent{ &_signalsStrand }
+      , writable{ &_signalsStrand }
     {
       connected.setCallType(MetaCallType_Direct);
       disconnected.setCallType(MetaCallType_Direct);
       messageReady.setCallType(MetaCallType_Direct);
       socketEvent.setCallType(MetaCallType_Direct);
+      writable.setCallType(MetaCallType_Direct);
+      initSendBackpressureDefaults();
     }
 
     virtual qi::FutureSync<void> connect(const qi::Url &url) = 0;
@@ -74,6 +96,13 @@ namespace qi
 
     virtual bool send(qi::Message msg) = 0;
 
+    /// Advertise a local capability mid-stream: updates the local map and
+    /// sends a Type_Capability message carrying it, so the remote end sees
+    /// the change at a well-defined point of the stream (used by the
+    /// compact value encoding activation, see
+    /// StreamContext::compactValuesSendEnabled()).
+    void advertiseCapability(const std::string& key, const AnyValue& value) override;
+
     /// Start reading if is not already reading.
     /// Must be called once if the socket is obtained through TransportServer::newConnection()
     virtual bool  ensureReading() = 0;
@@ -85,6 +114,42 @@ namespace qi
 
     bool isConnected() const;
 
+    /// @{ Send-queue backpressure.
+    ///
+    /// Watermarks are in bytes of queued messages (headers included), 0
+    /// disabling the mechanism. Defaults come from the
+    /// QIMESSAGING_SEND_QUEUE_HIGH_WATERMARK,
+    /// QIMESSAGING_SEND_QUEUE_LOW_WATERMARK (default: half the high one) and
+    /// QIMESSAGING_SEND_QUEUE_POLICY environment variables.
+
+    /// `low` must not exceed `high`; it is clamped if it does.
+    void setSendWatermarks(size_t high, size_t low);
+    size_t sendHighWatermark() const { return _sendHighWatermark.load(); }
+    size_t sendLowWatermark() const { return _sendLowWatermark.load(); }
+    void setSendQueuePolicy(SendQueuePolicy policy) { _sendQueuePolicy.store(policy); }
+    SendQueuePolicy sendQueuePolicy() const { return _sendQueuePolicy.load(); }
+
+    /// Bytes currently waiting in the send queue.
+    virtual size_t sendQueueBytes() const { return 0; }
+
+    /// False while the policy is rejecting messages: the queue reached the
+    /// high watermark and has not drained below the low one yet. `writable`
+    /// is emitted when this becomes true again.
+    bool canSend() const { return !_sendSaturated.load(); }
+    /// @}
+
+    /// Snapshot of the socket's activity counters (always-on, relaxed
+    /// atomics: see SocketStats for the accuracy contract).
+    SocketStats stats() const;
+
+    /// Install the flight recorder this socket feeds with the headers of the
+    /// messages it sends and receives — normally the recorder of the session
+    /// that owns the socket. The socket shares ownership, so the recorder
+    /// outlives any in-flight record(). To be called once, right after
+    /// creating or accepting the socket: the hot path reads the recorder
+    /// without synchronization, so replacing it under traffic is not safe.
+    void setFlightRecorder(FlightRecorderPtr recorder);
+
     static const unsigned int ALL_OBJECTS = (unsigned int)-1;
 
     qi::SignalLink messagePendingConnect(unsigned int serviceId, unsigned int objectId, boost::function<void (const qi::Message&)> fun) {
@@ -96,10 +161,75 @@ namespace qi
     }
 
   protected:
+    /// Applies the configured policy to a message about to be enqueued, given
+    /// the current queue size. Returns false when the message must be
+    /// rejected, and updates the saturation state.
+    bool acceptForSend(const Message& msg, size_t queuedBytes);
+    /// To call once queued bytes decreased: clears the saturation state and
+    /// emits `writable` when the queue drained below the low watermark.
+    void updateSendDrain(size_t queuedBytes);
+
+    /// @{ Statistics accounting. All relaxed: the counters are monotonic and
+    /// read individually, no cross-counter consistency is needed.
+
+    /// `wireBytes` is the full size of the message as enqueued (header
+    /// included), `queuedBytes` the queue depth including it.
+    void accountSent(size_t wireBytes, size_t queuedBytes)
+    {
+      _messagesSent.fetch_add(1, std::memory_order_relaxed);
+      _bytesSent.fetch_add(wireBytes, std::memory_order_relaxed);
+      auto peak = _sendQueuePeakBytes.load(std::memory_order_relaxed);
+      while (queuedBytes > peak &&
+             !_sendQueuePeakBytes.compare_exchange_weak(peak, queuedBytes,
+                                                        std::memory_order_relaxed))
+      {}
+    }
+    void accountReceived(size_t wireBytes)
+    {
+      _messagesReceived.fetch_add(1, std::memory_order_relaxed);
+      _bytesReceived.fetch_add(wireBytes, std::memory_order_relaxed);
+    }
+    void setHandshakeDuration(MicroSeconds duration)
+    {
+      _handshakeDurationUs.store(duration.count(), std::memory_order_relaxed);
+    }
+    /// @}
+
+    /// One flight-recorder ring write, nothing when no recorder is
+    /// installed, plus one capture record when QI_MESSAGE_CAPTURE is set.
+    /// To call once per message on the send and receive paths.
+    void recordMessage(const Message& msg, bool sent)
+    {
+      if (auto* recorder = _flightRecorder.load(std::memory_order_acquire))
+        recorder->record(msg, sent);
+      if (MessageCapture::enabled())
+        MessageCapture::instance().record(this, msg, sent);
+    }
+
     qi::EventLoop* _eventLoop;
     Strand _signalsStrand; // Must be declared before the MessageDispatcher and the signals.
     qi::MessageDispatcher _dispatcher;
 
+  private:
+    void initSendBackpressureDefaults();
+
+    std::atomic<size_t> _sendHighWatermark;
+    std::atomic<size_t> _sendLowWatermark;
+    std::atomic<SendQueuePolicy> _sendQueuePolicy;
+    std::atomic<bool> _sendSaturated{false};
+
+    std::atomic<uint64_t> _messagesSent{0};
+    std::atomic<uint64_t> _bytesSent{0};
+    std::atomic<uint64_t> _messagesReceived{0};
+    std::atomic<uint64_t> _bytesReceived{0};
+    std::atomic<uint64_t> _sendQueuePeakBytes{0};
+    std::atomic<int64_t> _handshakeDurationUs{-1};
+
+    // _flightRecorderOwner keeps the recorder alive, the atomic raw pointer
+    // is what the hot path loads (see setFlightRecorder for the contract).
+    FlightRecorderPtr _flightRecorderOwner;
+    std::atomic<FlightRecorder*> _flightRecorder{nullptr};
+
   public:
     // C4251
     qi::Signal<>                   connected;
@@ -110,10 +240,31 @@ namespace qi
     using SocketEventData = boost::variant<std::string, qi::Message>;
     // C4251
     qi::Signal<SocketEventData>  socketEvent;
+    /// Emitted when the send queue, after having reached the high watermark,
+    /// drained below the low one: sending is worth retrying (see canSend()).
+    // C4251
+    qi::Signal<>                 writable;
   };
 
   using MessageSocketPtr = boost::shared_ptr<MessageSocket>;
+  /// True if the protocol names a transport this build can create, both as
+  /// client socket and as server. Keep in sync with makeMessageSocket and
+  /// TransportServer::listen: any new transport (e.g. a local or
+  /// shared-memory one) must be recognized here.
+  bool isKnownTransportProtocol(const std::string& protocol);
+
   MessageSocketPtr makeMessageSocket(const std::string &protocol, qi::EventLoop *eventLoop = getNetworkEventLoop());
+
+  namespace detail
+  {
+    /// Registry of the open sockets, feeding the socket part of
+    /// qi::memoryStats() (socket count, aggregated send-queue bytes).
+    /// Concrete sockets register in their constructor and unregister first
+    /// thing in their destructor, so a snapshot never reaches a socket whose
+    /// derived part is already gone.
+    void registerSocket(MessageSocket* socket);
+    void unregisterSocket(MessageSocket* socket);
+  }
 }
 
 #endif  // _SRC_MESSAGESOCKET_HPP_
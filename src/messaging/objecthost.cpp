@@ -3,6 +3,8 @@
 **  See COPYING for the license
 */
 
+#include <boost/make_shared.hpp>
+
 #include <qi/actor.hpp>
 #include "objecthost.hpp"
 
@@ -24,20 +26,35 @@ ObjectHost::ObjectHost(unsigned int service)
    // so does clear() while iterating
    ObjectMap map;
    std::swap(map, _objectMap);
+   // Drop the snapshot first so the objects' references are really released
+   // when the local map clears.
+   boost::atomic_store(&_objectMapSnapshot, boost::shared_ptr<const ObjectMap>());
    map.clear();
  }
 
+void ObjectHost::publishObjectMap()
+{
+  // Precondition: _mutex is held.
+  boost::atomic_store(&_objectMapSnapshot,
+                      boost::shared_ptr<const ObjectMap>(boost::make_shared<ObjectMap>(_objectMap)));
+}
+
 BoundAnyObject ObjectHost::recursiveFindObject(uint32_t objectId)
 {
-  boost::recursive_mutex::scoped_lock lock(_mutex);
-  auto it = _objectMap.find(objectId);
-  auto e = end(_objectMap);
+  // Lock-free lookup on the published snapshot: object creation and
+  // destruction republish a new snapshot instead of blocking the routing of
+  // every message to every hosted object.
+  const auto map = boost::atomic_load(&_objectMapSnapshot);
+  if (!map)
+    return {};
+  auto it = map->find(objectId);
+  auto e = end(*map);
   if (it != e)
   {
     return it->second;
   }
   // Object was not found, so search in the children.
-  auto b = begin(_objectMap);
+  auto b = begin(*map);
   while (b != e)
   {
     BoundObject* obj{b->second.get()};
@@ -86,6 +103,7 @@ unsigned int ObjectHost::addObject(BoundAnyObject obj, StreamContext* remoteRef,
     id = nextId();
   QI_ASSERT(_objectMap.find(id) == _objectMap.end());
   _objectMap[id] = obj;
+  publishObjectMap();
   _remoteReferences[remoteRef].push_back(id);
   return id;
 }
@@ -144,6 +162,7 @@ Future<void> ObjectHost::removeObject(unsigned int id, Future<void> fut)
     }
     const auto obj = it->second;
     _objectMap.erase(it);
+    publishObjectMap();
     qiLogDebug() << this << " count " << obj.use_count();
     // Because of potential dependencies between the object's destruction
     // and the networking resources, we transfer the object's destruction
@@ -159,6 +178,38 @@ Future<void> ObjectHost::removeObject(unsigned int id, Future<void> fut)
   return fut;
 }
 
+Future<void> ObjectHost::removeObjects(const std::vector<unsigned int>& ids, Future<void> fut)
+{
+  boost::recursive_mutex::scoped_lock lock(_mutex);
+  bool removed = false;
+  for (const unsigned int id: ids)
+  {
+    ObjectMap::iterator it = _objectMap.find(id);
+    if (it == _objectMap.end())
+    {
+      qiLogDebug() << this << " No match in host for " << id;
+      continue;
+    }
+    const auto obj = it->second;
+    _objectMap.erase(it);
+    removed = true;
+    // Same deferred destruction scheme as removeObject: the objects may
+    // hold networking resources, so their destruction is chained on
+    // another thread.
+    const auto resetter = PointerDeferredResetHack<BoundAnyObject>(std::move(obj));
+    fut = fut.then([resetter](Future<void> f) {
+      if (f.hasError())
+        qiLogWarning() << "Object destruction failed: " << f.error();
+      resetter();
+    });
+    qiLogDebug() << this << " Object " << id << " removed.";
+  }
+  // One snapshot republication for the whole batch.
+  if (removed)
+    publishObjectMap();
+  return fut;
+}
+
 void ObjectHost::clear()
 {
   boost::recursive_mutex::scoped_lock lock(_mutex);
@@ -169,6 +220,7 @@ void ObjectHost::clear()
       sbo->_owner.reset();
   }
   _objectMap.clear();
+  publishObjectMap();
 }
 
 }
@@ -34,6 +34,11 @@ namespace qi
     void onMessage(const qi::Message &msg, MessageSocketPtr socket);
     unsigned int addObject(BoundAnyObject obj, StreamContext* remoteReferencer, unsigned int objId = 0);
     Future<void> removeObject(unsigned int id, Future<void> fut = Future<void>{nullptr});
+    /// Remove several objects in one pass: the lookup snapshot is
+    /// republished once instead of once per object. Unknown ids are
+    /// silently skipped, like in removeObject.
+    Future<void> removeObjects(const std::vector<unsigned int>& ids,
+                               Future<void> fut = Future<void>{nullptr});
     void removeRemoteReferences(MessageSocketPtr socket);
     unsigned int service() { return _service;}
     virtual unsigned int nextId() = 0;
@@ -47,10 +52,18 @@ namespace qi
     /// destination of the call (the "service") does not know directly the called object, but instead one of its
     /// (ObjectHost) children knows it.
     BoundAnyObject recursiveFindObject(uint32_t objectId);
+    /// Republish the lookup snapshot after a change to _objectMap.
+    /// Precondition: _mutex is held.
+    void publishObjectMap();
     using RemoteReferencesMap = std::map<StreamContext*, std::vector<unsigned int>>;
     boost::recursive_mutex    _mutex;
     unsigned int    _service;
     ObjectMap       _objectMap;
+    // Immutable snapshot of _objectMap, swapped with boost::atomic_store on
+    // every change (rare), so that routing a message to a hosted object
+    // (frequent) costs a single boost::atomic_load - no lock (same scheme as
+    // MessageDispatcher's signal map).
+    boost::shared_ptr<const ObjectMap> _objectMapSnapshot;
     RemoteReferencesMap _remoteReferences;
   };
 }
@@ -161,10 +161,107 @@ namespace qi {
     return prom.future();
   };
 
+  static void servicesReadyAck(qi::Future<void> fut, qi::Promise<std::vector<unsigned int>> result,
+                               std::vector<unsigned int> idxs) {
+    if (fut.hasError()) {
+      result.setError(fut.error());
+      return;
+    }
+    result.setValue(idxs);
+  }
+
+  void ObjectRegistrar::onBulkRegisterFinished(qi::Future<std::vector<unsigned int>> fut,
+                                               std::vector<std::pair<qi::AnyObject, qi::ServiceInfo>> requests,
+                                               qi::Promise<std::vector<unsigned int>> result)
+  {
+    if (fut.hasError()) {
+      result.setError(fut.error());
+      return;
+    }
+    const std::vector<unsigned int> idxs = fut.value();
+    if (idxs.size() != requests.size()) {
+      result.setError("The directory returned a wrong number of service ids.");
+      return;
+    }
+    for (std::size_t i = 0; i != idxs.size(); ++i)
+    {
+      const unsigned int idx = idxs[i];
+      qi::ServiceInfo si = requests[i].second;
+      si.setServiceId(idx);
+      {
+        boost::mutex::scoped_lock sl(_servicesMutex);
+        if (_services.find(idx) != _services.end()) {
+          qiLogError() << "A service is already registered with that id:" << idx;
+          result.setError("Service already registered.");
+          return;
+        }
+        BoundService bs;
+        bs.id          = idx;
+        bs.object      = requests[i].first;
+        bs.serviceInfo = si;
+        bs.name        = si.name();
+        _services[idx] = bs;
+        Server::addObject(idx, bs.object);
+      }
+      {
+        boost::mutex::scoped_lock sl(_serviceNameToIndexMutex);
+        _serviceNameToIndex[si.name()] = idx;
+      }
+    }
+
+    // one ready ack for the whole batch
+    qi::Future<void> fut2 = _sdClient->servicesReady(idxs);
+    fut2.connect(boost::bind(&servicesReadyAck, _1, result, idxs));
+  }
+
+  qi::Future<std::vector<unsigned int>> ObjectRegistrar::registerServices(
+      const std::vector<std::pair<std::string, qi::AnyObject>> &services)
+  {
+    if (Server::endpoints().empty()) {
+      qiLogError() << "Could not register services: the current server has no endpoint";
+      return qi::Future<std::vector<unsigned int>>();
+    }
+    std::vector<qi::ServiceInfo> infos;
+    std::vector<std::pair<qi::AnyObject, qi::ServiceInfo>> requests;
+    infos.reserve(services.size());
+    requests.reserve(services.size());
+    for (std::vector<std::pair<std::string, qi::AnyObject>>::const_iterator it = services.begin();
+         it != services.end(); ++it)
+    {
+      qi::ServiceInfo si;
+      si.setName(it->first);
+      si.setProcessId(qi::os::getpid());
+      si.setMachineId(qi::os::getMachineId());
+      si.setEndpoints(Server::endpoints());
+      si.setSessionId(_id);
+      infos.push_back(si);
+      requests.push_back(std::make_pair(it->second, si));
+    }
+
+    qi::Promise<std::vector<unsigned int>> prom;
+    qi::Future<std::vector<unsigned int>> future = _sdClient->registerServices(infos);
+    future.connect(track(boost::bind<void>(&ObjectRegistrar::onBulkRegisterFinished, this, _1, requests, prom),
+                         static_cast<Trackable<Server>*>(this)));
+    return prom.future();
+  }
+
   qi::Future<void> ObjectRegistrar::unregisterService(unsigned int idx)
   {
     qi::Future<void> future = _sdClient->unregisterService(idx);
+    removeLocalService(idx);
+    return future;
+  }
+
+  qi::Future<void> ObjectRegistrar::unregisterServices(const std::vector<unsigned int> &idxs)
+  {
+    qi::Future<void> future = _sdClient->unregisterServices(idxs);
+    for (std::vector<unsigned int>::const_iterator it = idxs.begin(); it != idxs.end(); ++it)
+      removeLocalService(*it);
+    return future;
+  }
 
+  void ObjectRegistrar::removeLocalService(unsigned int idx)
+  {
     std::string name;
     {
       // Create a local variable to keep the underlying bound anyobject alive outside the map.
@@ -198,7 +295,6 @@ namespace qi {
       else
         qiLogVerbose() << "Can't find idx associated to name :" << name;
     }
-    return future;
   }
 
   std::vector<qi::ServiceInfo> ObjectRegistrar::registeredServices() {
@@ -9,6 +9,8 @@
 
 #include <string>
 #include <set>
+#include <utility>
+#include <vector>
 #include <boost/thread/recursive_mutex.hpp>
 #include <qi/api.hpp>
 #include <qi/session.hpp>
@@ -47,6 +49,13 @@ namespace qi {
     //register/unregister services
     qi::Future<unsigned int>     registerService(const std::string &name, qi::AnyObject obj);
     qi::Future<void>             unregisterService(unsigned int idx);
+    /// Registers a whole stack of services through one directory exchange
+    /// (a bulk registration plus a bulk ready ack), instead of a pair of
+    /// round trips per service. All or nothing on the directory side.
+    qi::Future<std::vector<unsigned int>> registerServices(
+        const std::vector<std::pair<std::string, qi::AnyObject>> &services);
+    /// Symmetric bulk unregistration, one exchange for the whole batch.
+    qi::Future<void>             unregisterServices(const std::vector<unsigned int> &idxs);
     void                         updateServiceInfo();
 
     //list services
@@ -58,9 +67,11 @@ namespace qi {
     void registerSocket(MessageSocketPtr socket);
 
     using Server::setAuthProviderFactory;
+    using Server::setFlightRecorder;
     using Server::listen;
     using Server::setIdentity;
     using Server::endpoints;
+    using Server::sockets;
 
   private:
     //0 on error
@@ -69,6 +80,11 @@ namespace qi {
   private:
     //Future
     void onFutureFinished(qi::Future<unsigned int> future, int id, qi::Promise<unsigned int> result);
+    void onBulkRegisterFinished(qi::Future<std::vector<unsigned int>> future,
+                                std::vector<std::pair<qi::AnyObject, qi::ServiceInfo>> requests,
+                                qi::Promise<std::vector<unsigned int>> result);
+    // Local bookkeeping shared by unregisterService and unregisterServices.
+    void removeLocalService(unsigned int idx);
 
   private:
     using BoundServiceMap = std::map<unsigned int, BoundService>;
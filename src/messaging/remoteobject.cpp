@@ -9,10 +9,18 @@
 # pragma warning(disable: 4355)
 #endif
 
+#include <algorithm>
+
 #include "remoteobject_p.hpp"
 #include "message.hpp"
 #include "messagesocket.hpp"
+#include <qi/binarycodec.hpp>
+#include <qi/buffer.hpp>
 #include <qi/log.hpp>
+#include <qi/messaging/calldeadline.hpp>
+#include <qi/messaging/messagepriority.hpp>
+#include <qi/messaging/replydelivery.hpp>
+#include <qi/os.hpp>
 #include <boost/thread/mutex.hpp>
 #include <qi/eventloop.hpp>
 
@@ -20,6 +28,39 @@ qiLogCategory("qimessaging.remoteobject");
 
 namespace qi {
 
+  namespace {
+    /* Reconnect MetaObject cache, process-wide: every full fetch lands here
+     * keyed by the raw content hash, so a client reconnecting to a service
+     * whose interface did not change (the server advertises the hash
+     * cheaply, see capabilityname::metaObjectHash) reuses the cached
+     * MetaObject and skips the transfer entirely. Entries are interned, so
+     * the cache adds no storage beyond MetaObject::intern's pool.
+     */
+    using FetchedMetaObjectCache = std::map<std::string, qi::MetaObject>;
+
+    boost::mutex gFetchedMetaObjectCacheMutex;
+    FetchedMetaObjectCache gFetchedMetaObjectCache;
+
+    boost::optional<qi::MetaObject> fetchedMetaObjectCacheGet(const std::string& hash)
+    {
+      boost::mutex::scoped_lock lock(gFetchedMetaObjectCacheMutex);
+      const FetchedMetaObjectCache::iterator it = gFetchedMetaObjectCache.find(hash);
+      if (it == gFetchedMetaObjectCache.end())
+        return {};
+      return it->second;
+    }
+
+    void fetchedMetaObjectCacheSet(const qi::MetaObject& mo)
+    {
+      // Content-only and deterministic: this is the same hash the server
+      // advertises for this interface.
+      const ka::sha1_digest_t hash = mo.contentHash();
+      const std::string key(hash.begin(), hash.end());
+      boost::mutex::scoped_lock lock(gFetchedMetaObjectCacheMutex);
+      gFetchedMetaObjectCache[key] = qi::MetaObject::intern(mo);
+    }
+  }
+
 
   static qi::MetaObject* createRemoteObjectSpecialMetaObject() {
     qi::MetaObject *mo = new qi::MetaObject;
@@ -27,12 +68,14 @@ namespace qi {
     mob.addMethod("L", "registerEvent", "(IIL)", qi::Message::BoundObjectFunction_RegisterEvent);
     mob.addMethod("v", "unregisterEvent", "(IIL)", qi::Message::BoundObjectFunction_UnregisterEvent);
     mob.addMethod(typeOf<MetaObject>()->signature(), "metaObject", "(I)", qi::Message::BoundObjectFunction_MetaObject);
+    mob.addMethod("s", "metaObjectHash", "(I)", qi::Message::BoundObjectFunction_MetaObjectHash);
     mob.addMethod("L", "registerEventWithSignature", "(IILs)", qi::Message::BoundObjectFunction_RegisterEventWithSignature);
     *mo = mob.metaObject();
 
     QI_ASSERT(mo->methodId("registerEvent::(IIL)") == qi::Message::BoundObjectFunction_RegisterEvent);
     QI_ASSERT(mo->methodId("unregisterEvent::(IIL)") == qi::Message::BoundObjectFunction_UnregisterEvent);
     QI_ASSERT(mo->methodId("metaObject::(I)") == qi::Message::BoundObjectFunction_MetaObject);
+    QI_ASSERT(mo->methodId("metaObjectHash::(I)") == qi::Message::BoundObjectFunction_MetaObjectHash);
     QI_ASSERT(mo->methodId("registerEventWithSignature::(IILs)") == qi::Message::BoundObjectFunction_RegisterEventWithSignature);
 
     return mo;
@@ -102,6 +145,10 @@ namespace qi {
         track(boost::bind<void>(&RemoteObject::onMessagePending, this, _1), this));
       _linkDisconnected = socket->disconnected.connect(
           track([=](const std::string& reason) { onSocketDisconnected(reason); }, this));
+      // Relay fairness: queued relayed calls leave when the send queue
+      // drains below the low watermark (see drainRelayQueues).
+      _linkWritable = socket->writable.connect(
+          track([=]() { drainRelayQueues(); }, this));
     }
   }
 
@@ -120,22 +167,83 @@ namespace qi {
     }
     qiLogVerbose() << "Fetched metaobject";
     setMetaObject(fut.value());
+    fetchedMetaObjectCacheSet(fut.value());
     prom.setValue(0);
   }
 
-
+  void RemoteObject::onMetaObjectHash(qi::Future<std::string> fut, qi::Promise<void> prom) {
+    if (!fut.hasError())
+    {
+      boost::optional<qi::MetaObject> cached = fetchedMetaObjectCacheGet(fut.value());
+      if (cached)
+      {
+        qiLogVerbose() << "MetaObject unchanged since last fetch, reusing the cached one";
+        setMetaObject(*cached);
+        prom.setValue(0);
+        return;
+      }
+    }
+    else
+      qiLogVerbose() << "MetaObject hash error, falling back to the full fetch: "
+                     << fut.error();
+    fetchFullMetaObject(prom);
+  }
 
   //retrieve the metaObject from the network
   qi::Future<void> RemoteObject::fetchMetaObject() {
     qiLogVerbose() << "Requesting metaobject";
     qi::Promise<void> prom(qi::FutureCallbackType_Sync);
+    MessageSocketPtr sock = *_socket;
+    if (sock && sock->remoteCapability<bool>(capabilityname::metaObjectHash, false))
+    {
+      // Ask for the content hash first: a 20-byte reply instead of the
+      // whole MetaObject when this interface was already fetched once.
+      qi::Future<std::string> fut = _self.async<std::string>("metaObjectHash", 0U);
+      fut.connect(track(boost::bind<void>(&RemoteObject::onMetaObjectHash, this, _1, prom), this));
+      return prom.future();
+    }
+    fetchFullMetaObject(prom);
+    return prom.future();
+  }
+
+  void RemoteObject::fetchFullMetaObject(qi::Promise<void> prom) {
     qi::Future<qi::MetaObject> fut =
       _self.async<qi::MetaObject>("metaObject", 0U);
     fut.connect(track(boost::bind<void>(&RemoteObject::onMetaObject, this, _1, prom), this));
-    return prom.future();
   }
 
   //should be done in the object thread
+  AnyValue RemoteObject::applyDeltaEvent(const Message& msg, const MessageSocketPtr& socket)
+  {
+    boost::mutex::scoped_lock lock(_deltaEventMutex);
+    std::map<unsigned int, AnyValue>::iterator it = _deltaEventState.find(msg.event());
+    if (it == _deltaEventState.end())
+    {
+      // Should not happen: the emitter sends a keyframe to any new
+      // subscriber set before the first delta.
+      qiLogWarning() << "Delta event " << msg.event() << " without a keyframe, dropping";
+      return AnyValue();
+    }
+    AnyValue& stored = it->second;
+    GenericFunctionParameters params = stored.asTupleValuePtr();
+    AnyReference structRef = params[0];
+    StructTypeInterface* structType = static_cast<StructTypeInterface*>(structRef.type());
+    const std::vector<TypeInterface*> members = structType->memberTypes();
+
+    BufferReader reader(msg.buffer());
+    uint32_t mask = 0;
+    decodeBinary(&reader, &mask);
+    for (unsigned i = 0; i < members.size(); ++i)
+    {
+      if (!(mask & (uint32_t(1) << i)))
+        continue;
+      AnyReference field(members[i], structType->get(structRef.rawValue(), i));
+      decodeBinary(&reader, field, DeserializeObjectCallback(), socket.get());
+    }
+    // Deep copy: triggering the subscribers must not race the next delta.
+    return stored;
+  }
+
   void RemoteObject::onMessagePending(const qi::Message &msg)
   {
     MessageSocketPtr sock = *_socket;
@@ -156,6 +264,23 @@ namespace qi {
     }
 
     if (msg.type() == qi::Message::Type_Event) {
+      // Windowed streams (setEventWindow): acknowledge what we received so
+      // the emitter's window reopens. Acking every half window halves the
+      // acknowledgment traffic while never letting the window drain.
+      {
+        boost::mutex::scoped_lock lock(_eventAckMutex);
+        auto ackIt = _eventAckState.find(msg.event());
+        if (ackIt != _eventAckState.end())
+        {
+          EventAckState& ack = ackIt->second;
+          if (2 * ++ack.received >= ack.window)
+          {
+            _self.async<void>("ackEvent", _service, msg.event(),
+                              ack.remoteSignalLink, ack.received);
+            ack.received = 0;
+          }
+        }
+      }
       SignalBase* sb = signal(msg.event());
       if (sb)
       {
@@ -166,6 +291,17 @@ namespace qi {
           const MetaSignal* ms  = _self.metaObject().signal(msg.event());
           qi::Signature sig = ms->parametersSignature();
 
+          if (msg.flags() & Message::TypeFlag_DeltaPayload)
+          {
+            AnyValue rebuilt = applyDeltaEvent(msg, sock);
+            if (rebuilt.isValid())
+            {
+              GenericFunctionParameters args = rebuilt.asTupleValuePtr();
+              sb->trigger(args);
+            }
+            return;
+          }
+
           // Remove top-level tuple
           //sig = sig.substr(1, sig.length()-2);
           //TODO: Optimise
@@ -178,7 +314,19 @@ namespace qi {
             if (sig == "m")
               args = value.content().asTupleValuePtr();
             else
+            {
               args = value.asTupleValuePtr();
+              // Keep the last full payload of delta-capable streams so
+              // later TypeFlag_DeltaPayload events can be rebuilt.
+              if (args.size() == 1 && args[0].kind() == TypeKind_Tuple &&
+                  sock && sock->localCapability(capabilityname::deltaEvents, false) &&
+                  sig.toString().find_first_of("om") == std::string::npos &&
+                  static_cast<StructTypeInterface*>(args[0].type())->memberTypes().size() <= 32)
+              {
+                boost::mutex::scoped_lock lock(_deltaEventMutex);
+                _deltaEventState[msg.event()] = value; // deep copy
+              }
+            }
             qiLogDebug() << "Triggering local event listeners with args : " << args.size();
             sb->trigger(args);
           }
@@ -206,13 +354,23 @@ namespace qi {
       return;
     }
 
+    // Zero-parse relays first: hand the raw message over without touching
+    // the payload.
+    if (auto rawPromise = _rawPromises.take(msg.id()))
+    {
+      qiLogDebug() << "Handling raw relay promise id:" << msg.id();
+      if (msg.type() == qi::Message::Type_Canceled)
+        rawPromise->setCanceled();
+      else
+        rawPromise->setValue(msg);
+      return;
+    }
+
     qi::Promise<AnyReference> promise;
     {
-      auto syncPromises = _promises.synchronize();
-      auto it = syncPromises->find(msg.id());
-      if (it != syncPromises->end()) {
-        promise = (*syncPromises)[msg.id()];
-        syncPromises->erase(it);
+      auto taken = _promises.take(msg.id());
+      if (taken) {
+        promise = *taken;
         qiLogDebug() << "Handling promise id:" << msg.id();
       } else  {
         qiLogError() << "no promise found for req id:" << msg.id()
@@ -301,8 +459,14 @@ namespace qi {
       }
     }
 
-    qi::Promise<AnyReference> out;
+    // With inline delivery the reply completes the promise on the network
+    // thread, instead of bouncing continuations through the event loop.
+    qi::Promise<AnyReference> out(detail::currentReplyDelivery() == ReplyDelivery::Inline ?
+                                    qi::FutureCallbackType_Sync :
+                                    qi::FutureCallbackType_Async);
     qi::Message msg;
+    if (detail::currentMessagePriority() == MessagePriority::High)
+      msg.addFlags(Message::TypeFlag_HighPriority);
     MessageSocketPtr sock;
     // qiLogDebug() << this << " metacall " << msg.service() << " " << msg.function() <<" " << msg.id();
     {
@@ -314,14 +478,12 @@ namespace qi {
       {
         return makeFutureError<AnyReference>("Socket is not connected");
       }
-      auto syncPromises = _promises.synchronize();
-      if (syncPromises->find(msg.id()) != syncPromises->end())
+      qiLogDebug() << "Adding promise id:" << msg.id();
+      if (!_promises.insert(msg.id(), out))
       {
         qiLogError() << "There is already a pending promise with id "
                                    << msg.id();
       }
-      qiLogDebug() << "Adding promise id:" << msg.id();
-      (*syncPromises)[msg.id()] = out;
     }
     qi::Signature funcSig = mm->parametersSignature();
     try {
@@ -341,6 +503,17 @@ namespace qi {
       msg.addFlags(Message::TypeFlag_ReturnType);
       msg.setValue(returnSignature.toString(), Signature("s"));
     }
+    const qi::Duration deadlineBudget = detail::currentCallDeadline();
+    if (deadlineBudget > qi::Duration::zero() &&
+        sock->sharedCapabilityFlag(StreamContext::SharedCapability_CallDeadline))
+    {
+      // Appended after the ReturnType signature when both are present: the
+      // server decodes the trailing fields in this order.
+      const auto budgetMs = static_cast<unsigned int>((std::max<qi::int64_t>)(
+          1, boost::chrono::duration_cast<qi::MilliSeconds>(deadlineBudget).count()));
+      msg.addFlags(Message::TypeFlag_CallDeadline);
+      msg.setValue(AnyReference::from(budgetMs), "I");
+    }
     msg.setType(qi::Message::Type_Call);
     msg.setService(_service);
     msg.setObject(_object);
@@ -366,18 +539,120 @@ namespace qi {
       }
       out.setError(ss.str());
       qiLogDebug() << "Removing promise id:" << msgId;
-      _promises->erase(msgId);
+      _promises.erase(msgId);
     }
     else
+    {
       out.setOnCancel(qi::bind(&RemoteObject::onFutureCancelled, this, msgId));
+      if (deadlineBudget > qi::Duration::zero())
+        registerCallDeadline(msgId, SteadyClock::now() + deadlineBudget);
+    }
     return out.future();
   }
 
+  qi::Future<Message> RemoteObject::metaCallRaw(unsigned int method, const Message& call,
+                                                const MessageSocketPtr& origin)
+  {
+    qi::Promise<Message> out(detail::currentReplyDelivery() == ReplyDelivery::Inline ?
+                               qi::FutureCallbackType_Sync :
+                               qi::FutureCallbackType_Async);
+    qi::Message msg;
+    // Share the payload storage of the original message: the relayed call
+    // carries the client's bytes untouched under a rewritten header.
+    msg.setBuffer(Buffer::makeShared(call.buffer()));
+    msg.setFlags(call.flags());
+    MessageSocketPtr sock;
+    {
+      auto syncSock = _socket.synchronize();
+      sock = *syncSock;
+      // Check socket while holding the lock to avoid a race with close()
+      // where we would add a promise to the map after said map got cleared
+      if (!sock || !sock->isConnected())
+        return makeFutureError<Message>("Socket is not connected");
+      if (!_rawPromises.insert(msg.id(), out))
+      {
+        qiLogError() << "There is already a pending relay promise with id "
+                     << msg.id();
+      }
+    }
+    msg.setType(qi::Message::Type_Call);
+    msg.setService(_service);
+    msg.setObject(_object);
+    msg.setFunction(method);
+
+    const auto msgId = msg.id();
+    {
+      // Fair queuing: while the upstream socket applies backpressure, or
+      // calls of other origins are already waiting, the call joins its
+      // origin's queue and leaves deficit-round-robin on drain.
+      boost::mutex::scoped_lock lock(_relayQueueMutex);
+      if (!_relayQueues.empty() || !sock->canSend())
+      {
+        _relayQueues[origin.get()].messages.push_back(std::move(msg));
+        lock.unlock();
+        out.setOnCancel(qi::bind(&RemoteObject::onFutureCancelled, this, msgId));
+        // Opportunistic: the queue may have drained since the last
+        // `writable` emission.
+        drainRelayQueues();
+        return out.future();
+      }
+    }
+    if (!sock->isConnected() || !sock->send(std::move(msg)))
+    {
+      std::stringstream ss;
+      ss << "Network error while relaying call to method " << method << ".";
+      qiLogVerbose() << ss.str();
+      out.setError(ss.str());
+      _rawPromises.erase(msgId);
+    }
+    else
+      out.setOnCancel(qi::bind(&RemoteObject::onFutureCancelled, this, msgId));
+    return out.future();
+  }
+
+  void RemoteObject::drainRelayQueues()
+  {
+    static const size_t quantum =
+        os::getEnvParam<size_t>("QI_RELAY_FAIR_QUANTUM", 64 * 1024);
+    MessageSocketPtr sock = *_socket;
+    boost::mutex::scoped_lock lock(_relayQueueMutex);
+    if (!sock || !sock->isConnected())
+    {
+      // close() fails the matching relay promises; the payloads just go.
+      _relayQueues.clear();
+      return;
+    }
+    while (!_relayQueues.empty() && sock->canSend())
+    {
+      // Rotate over the origins; deficits accumulate one quantum per round,
+      // so an origin with a message larger than the quantum just waits a
+      // few rounds instead of blocking the others.
+      auto it = _relayQueues.upper_bound(_relayDrainPos);
+      if (it == _relayQueues.end())
+        it = _relayQueues.begin();
+      _relayDrainPos = it->first;
+      RelayOriginQueue& queue = it->second;
+      queue.deficit += quantum;
+      while (!queue.messages.empty() && sock->canSend())
+      {
+        const size_t size =
+            queue.messages.front().buffer().totalSize() + sizeof(Message::Header);
+        if (size > queue.deficit)
+          break;
+        queue.deficit -= size;
+        Message msg = std::move(queue.messages.front());
+        queue.messages.pop_front();
+        sock->send(std::move(msg));
+      }
+      if (queue.messages.empty())
+        _relayQueues.erase(it); // classic DRR: deficits do not carry over
+    }
+  }
+
   void RemoteObject::onFutureCancelled(unsigned int originalMessageId)
   {
     qiLogDebug() << "Cancel request for message " << originalMessageId;
     MessageSocketPtr sock = *_socket;
-    Message cancelMessage;
 
     if (!sock)
     {
@@ -385,11 +660,29 @@ namespace qi {
                    << _service << " is disconnected.";
       return;
     }
-    if (!sock->sharedCapability<bool>(capabilityname::remoteCancelableCalls, false))
+    if (!sock->sharedCapabilityFlag(StreamContext::SharedCapability_RemoteCancelableCalls))
     {
       qiLogWarning() << "Remote end does not support cancelable calls.";
       return;
     }
+    if (sock->sharedCapabilityFlag(StreamContext::SharedCapability_BatchCancel))
+    {
+      // Coalesce: cancels requested in the same event-loop turn (typically a
+      // whole batch of speculative calls dropped at once) leave as a single
+      // message. The flush runs at most a scheduling quantum later, which is
+      // well within the latency of the cancel round-trip itself.
+      bool scheduleFlush = false;
+      {
+        boost::mutex::scoped_lock lock(_pendingCancelMutex);
+        _pendingCancels.push_back(originalMessageId);
+        scheduleFlush = !_cancelFlushScheduled;
+        _cancelFlushScheduled = true;
+      }
+      if (scheduleFlush)
+        getEventLoop()->post(track([this] { flushPendingCancels(); }, this));
+      return;
+    }
+    Message cancelMessage;
     cancelMessage.setService(_service);
     cancelMessage.setType(Message::Type_Cancel);
     cancelMessage.setValue(AnyReference::from(originalMessageId), "I");
@@ -397,6 +690,91 @@ namespace qi {
     sock->send(std::move(cancelMessage));
   }
 
+  void RemoteObject::flushPendingCancels()
+  {
+    std::vector<unsigned int> ids;
+    {
+      boost::mutex::scoped_lock lock(_pendingCancelMutex);
+      ids.swap(_pendingCancels);
+      _cancelFlushScheduled = false;
+    }
+    if (ids.empty())
+      return;
+    MessageSocketPtr sock = *_socket;
+    if (!sock)
+    {
+      qiLogWarning() << "Tried to cancel " << ids.size()
+                     << " call(s), but the socket to service " << _service
+                     << " is disconnected.";
+      return;
+    }
+    Message cancelMessage;
+    cancelMessage.setService(_service);
+    cancelMessage.setType(Message::Type_Cancel);
+    cancelMessage.setObject(_object);
+    if (ids.size() == 1)
+      cancelMessage.setValue(AnyReference::from(ids.front()), "I");
+    else
+    {
+      cancelMessage.addFlags(Message::TypeFlag_BatchCancel);
+      cancelMessage.setValue(AnyReference::from(ids), "[I]");
+    }
+    sock->send(std::move(cancelMessage));
+  }
+
+  void RemoteObject::registerCallDeadline(unsigned int msgId, SteadyClockTimePoint expiry)
+  {
+    boost::mutex::scoped_lock lock(_deadlineMutex);
+    _deadlines[expiry].push_back(msgId);
+    if (_deadlineSweepArmed && _deadlineSweepAt <= expiry)
+      return;
+    // This deadline is the new earliest one: re-arm the single sweep timer
+    // on it, superseding the previously armed one.
+    if (_deadlineSweepArmed)
+      _deadlineSweep.cancel();
+    _deadlineSweepArmed = true;
+    _deadlineSweepAt = expiry;
+    _deadlineSweep = getEventLoop()->asyncDelay(
+        track([this] { sweepExpiredCalls(); }, this),
+        (std::max)(expiry - SteadyClock::now(), qi::Duration::zero()));
+  }
+
+  void RemoteObject::sweepExpiredCalls()
+  {
+    std::vector<unsigned int> expired;
+    {
+      boost::mutex::scoped_lock lock(_deadlineMutex);
+      _deadlineSweepArmed = false;
+      const SteadyClockTimePoint now = SteadyClock::now();
+      auto it = _deadlines.begin();
+      while (it != _deadlines.end() && it->first <= now)
+      {
+        expired.insert(expired.end(), it->second.begin(), it->second.end());
+        it = _deadlines.erase(it);
+      }
+      if (!_deadlines.empty())
+      {
+        _deadlineSweepArmed = true;
+        _deadlineSweepAt = _deadlines.begin()->first;
+        _deadlineSweep = getEventLoop()->asyncDelay(
+            track([this] { sweepExpiredCalls(); }, this),
+            _deadlineSweepAt - now);
+      }
+    }
+    unsigned int failedCount = 0;
+    for (unsigned int msgId: expired)
+    {
+      auto promise = _promises.take(msgId);
+      if (!promise) // already answered
+        continue;
+      promise->setError("call deadline expired");
+      ++failedCount;
+    }
+    if (failedCount > 0)
+      qiLogVerbose() << "Expired " << failedCount << " of " << expired.size()
+                     << " tracked call(s) to service " << _service << " in one sweep";
+  }
+
   void RemoteObject::metaPost(AnyObject, unsigned int event, const qi::GenericFunctionParameters &in)
   {
     // Bounce the emit request to server
@@ -405,6 +783,8 @@ namespace qi {
     // But it is a bit complex, because the server will bounce the
     // event back to us.
     qi::Message msg;
+    if (detail::currentMessagePriority() == MessagePriority::High)
+      msg.addFlags(Message::TypeFlag_HighPriority);
     // apparent signature must match for correct serialization
     qi::Signature argsSig = qi::makeTupleSignature(in, false);
     qi::Signature funcSig;
@@ -494,15 +874,89 @@ namespace qi {
       }
       rsl.remoteSignalLink = uid;
       qiLogDebug() << this << " connect() to " << event << " gave " << uid << " (new remote connection)";
+      const float maxRate = sub.maxEventRate();
       if (score >= 0.2)
-        rsl.future = _self.async<SignalLink>("registerEvent", _service, event, uid);
+      {
+        // Ask the emitter to throttle for us when the subscriber requested a
+        // rate ceiling and the remote end is recent enough to understand it;
+        // older peers just deliver everything (forced-signature registrations
+        // too, being rarer than they are worth a third variant).
+        if (maxRate > 0.0f && !metaObject().findMethod("registerEventWithRate").empty())
+        {
+          rsl.negotiatedRate = maxRate;
+          rsl.future = _self.async<SignalLink>("registerEventWithRate", _service, event, uid, maxRate);
+        }
+        else
+          rsl.future = _self.async<SignalLink>("registerEvent", _service, event, uid);
+      }
       else // we might or might not be capable to convert, ask the remote end to try also
         rsl.future =
             _self.async<SignalLink>("registerEventWithSignature", _service, event, uid, subSignature.toString());
+      // Windowed delivery: cap the number of unacknowledged events in
+      // flight once the registration exists. The ack state is installed
+      // before asking so no event can arrive unaccounted.
+      const int window = sub.ackWindow();
+      if (window > 0 && !metaObject().findMethod("setEventWindow").empty())
+      {
+        rsl.negotiatedWindow = window;
+        const bool coalesce = sub.ackCoalesce();
+        rsl.future.connect(track([=](Future<SignalLink> f) {
+          if (f.hasError())
+            return;
+          {
+            boost::mutex::scoped_lock lock(_eventAckMutex);
+            EventAckState& ack = _eventAckState[event];
+            ack.window = window;
+            ack.received = 0;
+            ack.remoteSignalLink = uid;
+          }
+          _self.async<void>("setEventWindow", _service, event, uid, window, coalesce);
+        }, this));
+      }
     }
     else
     {
       qiLogDebug() << this << "connect() to " << event << " gave " << uid << " (reusing remote connection)";
+      // The remote registration is shared: if it was throttled and this
+      // subscriber wants more events, lift the ceiling to the least
+      // restrictive request (local subscribers still all see every event
+      // the emitter lets through).
+      const float maxRate = sub.maxEventRate();
+      if (rsl.negotiatedRate > 0.0f &&
+          (maxRate <= 0.0f || maxRate > rsl.negotiatedRate) &&
+          !metaObject().findMethod("setEventRate").empty())
+      {
+        rsl.negotiatedRate = maxRate;
+        SignalLink remoteLink = rsl.remoteSignalLink;
+        rsl.future.connect(track([=](Future<SignalLink>) {
+          _self.async<void>("setEventRate", _service, event, remoteLink, maxRate);
+        }, this));
+      }
+      // Same for the delivery window: widen (or lift, with 0) the shared one
+      // when this subscriber wants more events in flight.
+      const int window = sub.ackWindow();
+      if (rsl.negotiatedWindow > 0 &&
+          (window <= 0 || window > rsl.negotiatedWindow) &&
+          !metaObject().findMethod("setEventWindow").empty())
+      {
+        rsl.negotiatedWindow = window;
+        const bool coalesce = sub.ackCoalesce();
+        SignalLink remoteLink = rsl.remoteSignalLink;
+        rsl.future.connect(track([=](Future<SignalLink>) {
+          {
+            boost::mutex::scoped_lock lock(_eventAckMutex);
+            if (window > 0)
+            {
+              EventAckState& ack = _eventAckState[event];
+              ack.window = window;
+              ack.remoteSignalLink = remoteLink;
+            }
+            else
+              _eventAckState.erase(event);
+          }
+          _self.async<void>("setEventWindow", _service, event, remoteLink, window, coalesce);
+        }, this));
+      }
     }
 
     rsl.future.connect(track(boost::bind<void>(&onEventConnected, this, _1, prom, uid), this));
@@ -548,6 +1002,8 @@ namespace qi {
         if (rsl.localSignalLink.size() == 0) {
           toDisco = rsl.remoteSignalLink;
           _localToRemoteSignalLink.erase(it);
+          boost::mutex::scoped_lock ackLock(_eventAckMutex);
+          _eventAckState.erase(event);
         }
       }
 
@@ -575,19 +1031,37 @@ namespace qi {
         socket->messagePendingDisconnect(_service, MessageSocket::ALL_OBJECTS, _linkMessageDispatcher);
         if (!fromSignal)
           socket->disconnected.disconnectAsync(_linkDisconnected);
+        socket->writable.disconnectAsync(_linkWritable);
     }
-    std::map<int, qi::Promise<AnyReference> > promises;
     {
-      auto syncPromises = _promises.synchronize();
-      promises = *syncPromises;
-      syncPromises->clear();
+      // Drop the relayed calls still waiting for the send queue to drain:
+      // their promises are failed with the others just below.
+      boost::mutex::scoped_lock lock(_relayQueueMutex);
+      _relayQueues.clear();
     }
+    auto promises = _promises.takeAll();
     // Nobody should be able to add anything to promises at this point.
     for (auto& pair: promises)
     {
       qiLogVerbose() << "Reporting error for request " << pair.first << "(" << reason << ")";
       pair.second.setError(reason);
     }
+    auto rawPromises = _rawPromises.takeAll();
+    for (auto& pair: rawPromises)
+    {
+      qiLogVerbose() << "Reporting error for relayed request " << pair.first << "(" << reason << ")";
+      pair.second.setError(reason);
+    }
+    {
+      // The tracked deadlines all pointed to promises failed just above.
+      boost::mutex::scoped_lock lock(_deadlineMutex);
+      _deadlines.clear();
+      if (_deadlineSweepArmed)
+      {
+        _deadlineSweep.cancel();
+        _deadlineSweepArmed = false;
+      }
+    }
 
     //@warning: remove connection are not removed
     //          not very important ATM, because RemoteObject
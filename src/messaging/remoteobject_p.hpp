@@ -9,14 +9,17 @@
 
 #include "messagesocket.hpp"
 #include <qi/anyobject.hpp>
+#include <qi/clock.hpp>
 #include <qi/type/dynamicobject.hpp>
 #include <qi/signal.hpp>
 
 #include "messagedispatcher.hpp"
 #include "objecthost.hpp"
 
+#include <boost/optional.hpp>
 #include <boost/thread/mutex.hpp>
 #include <boost/thread/synchronized_value.hpp>
+#include <deque>
 #include <string>
 
 namespace qi {
@@ -32,6 +35,73 @@ namespace qi {
     std::vector<qi::SignalLink> localSignalLink;
     qi::SignalLink              remoteSignalLink;
     qi::Future<qi::SignalLink>  future;
+    // Rate ceiling (Hz) the shared remote registration was negotiated with,
+    // 0 when unlimited. Lifted when a later subscriber wants more events.
+    float                       negotiatedRate = 0.0f;
+    // Delivery window (events) the shared remote registration was negotiated
+    // with, 0 when unwindowed. Lifted like the rate.
+    int                         negotiatedWindow = 0;
+  };
+
+  /// Pending-call table sharded by message id.
+  ///
+  /// One synchronized map per shard: the socket thread matching a reply only
+  /// locks the shard of that message id, so it does not serialize with
+  /// callers issuing new calls, and concurrent callers spread over shards
+  /// since message ids are allocated sequentially.
+  ///
+  /// Promise P
+  template<typename P>
+  class PendingPromises
+  {
+  public:
+    using Map = std::map<int, P>;
+
+    /// Register a pending call. Returns false if the id is already present,
+    /// in which case the table is left unchanged.
+    bool insert(int msgId, const P& promise)
+    {
+      auto syncShard = shard(msgId).synchronize();
+      return syncShard->emplace(msgId, promise).second;
+    }
+
+    /// Remove and return the promise matching the id, if any.
+    boost::optional<P> take(int msgId)
+    {
+      auto syncShard = shard(msgId).synchronize();
+      const auto it = syncShard->find(msgId);
+      if (it == syncShard->end())
+        return {};
+      auto promise = it->second;
+      syncShard->erase(it);
+      return promise;
+    }
+
+    void erase(int msgId)
+    {
+      shard(msgId)->erase(msgId);
+    }
+
+    /// Remove and return all pending promises, e.g. to fail them on close.
+    Map takeAll()
+    {
+      Map all;
+      for (auto& s: _shards)
+      {
+        auto syncShard = s.synchronize();
+        all.insert(syncShard->begin(), syncShard->end());
+        syncShard->clear();
+      }
+      return all;
+    }
+
+  private:
+    static const unsigned int shardCount = 16;
+    boost::synchronized_value<Map>& shard(int msgId)
+    {
+      return _shards[static_cast<unsigned int>(msgId) % shardCount];
+    }
+    boost::synchronized_value<Map> _shards[shardCount];
   };
 
   class RemoteObject : public qi::DynamicObject, public ObjectHost, public Trackable<RemoteObject> {
@@ -52,6 +122,27 @@ namespace qi {
     void close(const std::string& reason, bool fromSignal = false);
     unsigned int service() const { return _service; }
     unsigned int object() const { return _object; }
+    /// The socket this object communicates through; null once closed.
+    MessageSocketPtr socket() { return *_socket; }
+
+    /// Relay fast path for gateways: forward a call without deserializing
+    /// its payload. The call message's payload buffer and flags are reused
+    /// as-is (sharing the payload storage, no copy); only the header is
+    /// rewritten for this object's service/object ids. The returned future
+    /// is fulfilled with the raw reply or error message, again unparsed.
+    /// The caller must guarantee the payload is socket-independent: no
+    /// object references, no dynamic values (see
+    /// ServiceBoundObject::onMessage), and no compact value encoding on
+    /// either connection (capabilityname::compactValues is negotiated per
+    /// connection and a relayed payload keeps its original encoding).
+    ///
+    /// `origin` identifies the client the call came from, as a fairness
+    /// key: when the upstream socket applies backpressure (see
+    /// MessageSocket::canSend()), relayed calls wait in per-origin queues
+    /// and leave deficit-round-robin as the socket drains, so one bulk
+    /// client cannot starve the others sharing the upstream connection.
+    qi::Future<Message> metaCallRaw(unsigned int method, const Message& call,
+                                    const MessageSocketPtr& origin = MessageSocketPtr());
 
   protected:
     //TransportSocket.messagePending
@@ -62,9 +153,30 @@ namespace qi {
     virtual void metaPost(AnyObject context, unsigned int event, const GenericFunctionParameters& args);
     virtual qi::Future<AnyReference> metaCall(AnyObject context, unsigned int method, const GenericFunctionParameters& args, qi::MetaCallType callType, Signature returnSignature);
     void onFutureCancelled(unsigned int originalMessageId);
+    /// Sends the cancel requests accumulated since the last flush, as one
+    /// TypeFlag_BatchCancel message when several piled up (see
+    /// capabilityname::batchCancel).
+    void flushPendingCancels();
+    /// Records the caller-side deadline of a pending call and (re)arms the
+    /// sweep timer when this deadline is the earliest one.
+    void registerCallDeadline(unsigned int msgId, SteadyClockTimePoint expiry);
+    /// Fails every pending call whose deadline has passed, in one batch,
+    /// and re-arms the timer for the next earliest deadline.
+    void sweepExpiredCalls();
+    /// Sends queued relayed calls, one deficit-round-robin quantum
+    /// (QI_RELAY_FAIR_QUANTUM bytes, default 64kB) per origin per round,
+    /// until the upstream socket saturates again. Runs on every `writable`
+    /// emission and whenever a call gets queued (see metaCallRaw).
+    void drainRelayQueues();
 
     //metaObject received
     void onMetaObject(qi::Future<qi::MetaObject> fut, qi::Promise<void> prom);
+    /// MetaObject content hash received (capabilityname::metaObjectHash):
+    /// reuses the process-wide cached MetaObject on a hit, falls back to
+    /// the full fetch on a miss or an error (e.g. an old remote end).
+    void onMetaObjectHash(qi::Future<std::string> fut, qi::Promise<void> prom);
+    /// The unconditional MetaObject round trip behind fetchMetaObject().
+    void fetchFullMetaObject(qi::Promise<void> prom);
 
     virtual qi::Future<SignalLink> metaConnect(unsigned int event, const SignalSubscriber& sub);
     virtual qi::Future<void> metaDisconnect(SignalLink linkId);
@@ -72,18 +184,69 @@ namespace qi {
     virtual qi::Future<AnyValue> metaProperty(qi::AnyObject context, unsigned int id);
     virtual qi::Future<void> metaSetProperty(qi::AnyObject context, unsigned int id, AnyValue val);
 
+    /// Rebuilds a TypeFlag_DeltaPayload event from the last full payload
+    /// received for this event and returns the complete value, or an
+    /// invalid AnyValue when no keyframe arrived yet (the delta is then
+    /// dropped). See capabilityname::deltaEvents.
+    AnyValue applyDeltaEvent(const Message& msg, const MessageSocketPtr& socket);
+
   protected:
     using LocalToRemoteSignalLinkMap = std::map<qi::uint64_t, RemoteSignalLinks>;
 
     boost::synchronized_value<MessageSocketPtr>   _socket;
     unsigned int                                    _service;
     unsigned int                                    _object;
-    boost::synchronized_value<std::map<int, qi::Promise<AnyReference>>> _promises;
+    PendingPromises<qi::Promise<AnyReference>>      _promises;
+    // Pending zero-parse relays (metaCallRaw), matched before _promises.
+    PendingPromises<qi::Promise<Message>>           _rawPromises;
     qi::SignalLink                                  _linkMessageDispatcher;
     qi::SignalLink                                  _linkDisconnected;
+    qi::SignalLink                                  _linkWritable;
     qi::AnyObject                                   _self;
     boost::recursive_mutex                          _localToRemoteSignalLinkMutex;
     LocalToRemoteSignalLinkMap                      _localToRemoteSignalLink;
+    // Last full payload per delta-capable event stream, kept up to date by
+    // applyDeltaEvent (capabilityname::deltaEvents).
+    boost::mutex                                    _deltaEventMutex;
+    std::map<unsigned int, AnyValue>                _deltaEventState;
+    // Windowed event streams (setEventWindow): received events are counted
+    // and acknowledged back every half window so the emitter keeps sending.
+    struct EventAckState
+    {
+      int window = 0;
+      int received = 0; // events since the last acknowledgment
+      qi::SignalLink remoteSignalLink = qi::SignalBase::invalidSignalLink;
+    };
+    boost::mutex                                    _eventAckMutex;
+    std::map<unsigned int, EventAckState>           _eventAckState;
+    // Cancel requests coalesced within one event-loop turn, so cancelling a
+    // batch of speculative calls costs one message instead of one per call
+    // (capabilityname::batchCancel).
+    boost::mutex                                    _pendingCancelMutex;
+    std::vector<unsigned int>                       _pendingCancels;
+    bool                                            _cancelFlushScheduled = false;
+    // Relayed calls held back while the upstream socket applies
+    // backpressure, one queue per origin client drained deficit-round-robin
+    // (drainRelayQueues). The key is only a fairness bucket, it holds no
+    // reference. With no send watermarks configured the queues stay empty
+    // and calls go straight to the socket.
+    struct RelayOriginQueue
+    {
+      std::deque<Message> messages;
+      size_t deficit = 0; // DRR: bytes this origin may still send this round
+    };
+    boost::mutex                                    _relayQueueMutex;
+    std::map<MessageSocket*, RelayOriginQueue>      _relayQueues;
+    MessageSocket*                                  _relayDrainPos = nullptr;
+    // Caller-side deadlines of pending calls, ordered by expiry. A single
+    // timer armed on the earliest entry expires whole batches in one
+    // sweep, instead of one delayed task per call (ScopedCallDeadline).
+    boost::mutex                                    _deadlineMutex;
+    std::map<SteadyClockTimePoint,
+             std::vector<unsigned int>>             _deadlines;
+    qi::Future<void>                                _deadlineSweep;
+    SteadyClockTimePoint                            _deadlineSweepAt;
+    bool                                            _deadlineSweepArmed = false;
 
   private:
     static qi::Atomic<unsigned int> _nextId;
@@ -12,6 +12,7 @@
 #include <exception>
 #include "servicedirectoryclient.hpp"
 #include "authprovider_p.hpp"
+#include "authresume.hpp"
 
 qiLogCategory("qimessaging.server");
 
@@ -119,8 +120,12 @@ namespace qi {
       return;
     }
 
+    if (_flightRecorder)
+      socket->setFlightRecorder(_flightRecorder);
+
     auto inserted = _subscribers.insert(std::make_pair(socket, SocketSubscriber{}));
     QI_ASSERT(inserted.second && "Socket insertion failed. Socket already exists.");
+    publishSockets();
 
     auto& subscriber = inserted.first->second;
 
@@ -198,7 +203,23 @@ namespace qi {
     CapabilityMap authData = cmref.to<CapabilityMap>();
     cmref.destroy();
 
-    CapabilityMap authResult = auth->processAuth(authData);
+    // Resumable authentication: a client that completed the full exchange
+    // recently may replay the token it was handed instead of redoing it,
+    // which concludes in one round trip whatever the provider's number of
+    // steps.
+    CapabilityMap authResult;
+    const CapabilityMap::iterator tokenIt = authData.find(auth_resume::TokenKey);
+    if (tokenIt != authData.end() && auth_resume::enabled()
+        && auth_resume::redeemToken(tokenIt->second.to<std::string>()))
+    {
+      qiLogVerbose() << "Client " << socket->remoteEndpoint().value().str()
+                     << " resumed authentication with a token.";
+      authResult[AuthProvider::State_Key] = AnyValue::from<unsigned int>(AuthProvider::State_Done);
+    }
+    else
+    {
+      authResult = auth->processAuth(authData);
+    }
     const unsigned int state = authResult[AuthProvider::State_Key].to<unsigned int>();
 
     const std::string cmsig = typeOf<CapabilityMap>()->signature().toString();
@@ -209,6 +230,9 @@ namespace qi {
         qiLogVerbose() << "Client " << socket->remoteEndpoint().value().str() << " successfully authenticated.";
         socket->messageReady.disconnectAsync(*signalLink); // yet guarantees immediate disconnection
         connectMessageReady(socket);
+        // Hand out (or rotate) the resume token of this client.
+        if (auth_resume::enabled())
+          authResult[auth_resume::TokenKey] = AnyValue::from(auth_resume::issueToken());
         // no break, we know that authentication is done, send the response to the remote end
         QI_FALLTHROUGH;
       case AuthProvider::State_Cont:
@@ -238,6 +262,10 @@ namespace qi {
           socket->disconnect().async();
         }
     }
+    // Replay the calls the client pipelined behind the exchange, now that
+    // the authentication reply precedes their replies on the wire.
+    if (state == AuthProvider::State_Done)
+      flushMessagesParkedDuringAuth(socket);
   }
 
   /* We handle the case when we receive an authentication message,but the server has disabled authentication.
@@ -268,6 +296,14 @@ namespace qi {
   void Server::handleNotAuthMsgAuthEnabled(const Message &msg, MessageSocketPtr socket, AuthProviderPtr auth,
       boost::shared_ptr<bool> first, boost::shared_ptr<qi::SignalLink> signalLink, qi::Message &reply)
   {
+    // Authentication pipelining: a capable client may send its first calls
+    // right behind the authentication message instead of waiting for the
+    // reply. The authentication message always comes first, so the client's
+    // capabilities are known here; park the early messages and replay them
+    // once the exchange concludes.
+    if (parkMessageDuringAuth(msg, socket))
+      return;
+
     socket->messageReady.disconnect(*signalLink);
     std::stringstream err;
 
@@ -297,6 +333,43 @@ namespace qi {
   }
 
 
+  bool Server::parkMessageDuringAuth(const Message& msg, const MessageSocketPtr& socket)
+  {
+    static const size_t maxParked = os::getEnvParam<size_t>("QI_AUTH_PIPELINE_MAX", 16);
+    // Byte budget on top of the message count: the client is not
+    // authenticated yet, so it must not be able to pin server memory by
+    // pipelining a few huge payloads.
+    static const size_t maxParkedBytes =
+        os::getEnvParam<size_t>("QI_AUTH_PIPELINE_MAX_BYTES", 1024 * 1024);
+    if (!socket->remoteCapability(capabilityname::authPipelining, false))
+      return false;
+    const size_t msgBytes = msg.buffer().totalSize();
+    boost::recursive_mutex::scoped_lock sl(_socketsMutex);
+    auto it = _subscribers.find(socket);
+    if (it == _subscribers.end() || it->second.pendingDuringAuth.size() >= maxParked ||
+        it->second.pendingDuringAuthBytes + msgBytes > maxParkedBytes)
+      return false;
+    it->second.pendingDuringAuth.push_back(msg);
+    it->second.pendingDuringAuthBytes += msgBytes;
+    qiLogDebug() << "Parked message " << msg.id() << " received during authentication.";
+    return true;
+  }
+
+  void Server::flushMessagesParkedDuringAuth(const MessageSocketPtr& socket)
+  {
+    std::vector<Message> parked;
+    {
+      boost::recursive_mutex::scoped_lock sl(_socketsMutex);
+      auto it = _subscribers.find(socket);
+      if (it == _subscribers.end())
+        return;
+      std::swap(parked, it->second.pendingDuringAuth);
+      it->second.pendingDuringAuthBytes = 0;
+    }
+    for (const auto& msg: parked)
+      onMessageReady(msg, socket);
+  }
+
   void Server::onMessageReady(const qi::Message &msg, MessageSocketPtr socket) {
     qi::BoundAnyObject obj;
     {
@@ -357,7 +430,10 @@ namespace qi {
       const auto subscribersCopy = [&]
       {
         boost::recursive_mutex::scoped_lock sl(_socketsMutex);
-        return std::move(_subscribers);
+        auto subscribers = std::move(_subscribers);
+        _subscribers.clear();
+        publishSockets();
+        return subscribers;
       }();
 
       for (auto& pair : subscribersCopy)
@@ -366,6 +442,26 @@ namespace qi {
     _server.close();
   }
 
+  void Server::publishSockets()
+  {
+    auto snapshot = boost::make_shared<SocketSnapshot>();
+    snapshot->reserve(_subscribers.size());
+    for (const auto& pair : _subscribers)
+      snapshot->push_back(pair.first);
+    boost::atomic_store(&_socketsSnapshot,
+                        boost::shared_ptr<const SocketSnapshot>(snapshot));
+  }
+
+  std::vector<MessageSocketPtr> Server::sockets()
+  {
+    // Lock-free read of the published snapshot (see publishSockets()), so
+    // iterating the sockets never delays accepts and disconnects.
+    const auto snapshot = boost::atomic_load(&_socketsSnapshot);
+    if (!snapshot)
+      return {};
+    return *snapshot;
+  }
+
   qi::Future<void> Server::listen(const qi::Url &address)
   {
     // Assume this means we are back on-line.
@@ -412,6 +508,7 @@ namespace qi {
           QI_ASSERT(it != _subscribers.end());
           auto local = std::move(*it);
           _subscribers.erase(it);
+          publishSockets();
           return local;
         }();
 
@@ -41,8 +41,14 @@ namespace qi {
 
     std::vector<qi::Url> endpoints() const;
 
+    /// The sockets currently accepted by this server.
+    std::vector<MessageSocketPtr> sockets();
+
     void onTransportServerNewConnection(MessageSocketPtr socket, bool startReading);
     void setAuthProviderFactory(AuthProviderFactoryPtr factory);
+    /// Recorder installed on every accepted socket (see
+    /// MessageSocket::setFlightRecorder). To call before listen().
+    void setFlightRecorder(FlightRecorderPtr recorder) { _flightRecorder = recorder; }
 
   private:
     void setSocketObjectEndpoints();
@@ -77,6 +83,7 @@ namespace qi {
 
     boost::mutex                        _stateMutex;
     AuthProviderFactoryPtr              _authProviderFactory;
+    FlightRecorderPtr                   _flightRecorder;
     bool                                _enforceAuth;
   public:
     TransportServer                     _server;
@@ -88,13 +95,37 @@ namespace qi {
     {
       qi::SignalLink disconnected = qi::SignalBase::invalidSignalLink;
       qi::SignalLink messageReady = qi::SignalBase::invalidSignalLink;
+      // Authentication pipelining: messages a capable client sent behind
+      // its authentication message, replayed once the exchange concludes.
+      std::vector<Message> pendingDuringAuth;
+      // Payload bytes parked above, counted against the byte budget: the
+      // client is not authenticated yet, so what it can pin is bounded.
+      size_t pendingDuringAuthBytes = 0;
     };
     std::map<MessageSocketPtr, SocketSubscriber> _subscribers;
 
     boost::recursive_mutex              _socketsMutex;
 
+    // Immutable snapshot of the _subscribers keys, swapped with
+    // boost::atomic_store on every accept and disconnect, so iterating the
+    // connected sockets costs a single boost::atomic_load instead of
+    // contending with the accept path (same scheme as ObjectHost's object
+    // map).
+    using SocketSnapshot = std::vector<MessageSocketPtr>;
+    boost::shared_ptr<const SocketSnapshot> _socketsSnapshot;
+
+    /// Republish the socket snapshot after a membership change of
+    /// _subscribers. Precondition: _socketsMutex is held.
+    void publishSockets();
+
     void connectMessageReady(const MessageSocketPtr& socket);
     void disconnectSignals(const MessageSocketPtr& socket, const SocketSubscriber& subscriber);
+    /// Park a message received while the authentication exchange is still
+    /// running. Returns false when the message cannot be parked (client did
+    /// not advertise pipelining, unknown socket, or too many parked already).
+    bool parkMessageDuringAuth(const Message& msg, const MessageSocketPtr& socket);
+    /// Replay the messages parked during the authentication exchange.
+    void flushMessagesParkedDuringAuth(const MessageSocketPtr& socket);
   };
 }
 
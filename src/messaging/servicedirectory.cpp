@@ -9,13 +9,18 @@
 # pragma warning(disable: 4355)
 #endif
 
+#include <algorithm>
+#include <set>
 #include <vector>
 #include <map>
 
+#include <boost/bind.hpp>
 #include <boost/make_shared.hpp>
 
 #include <qi/anyobject.hpp>
+#include <qi/eventloop.hpp>
 #include <qi/future.hpp>
+#include <qi/getenv.hpp>
 #include "transportserver.hpp"
 #include "messagesocket.hpp"
 #include "servicedirectory.hpp"
@@ -64,7 +69,15 @@ namespace qi
       QI_ASSERT(id == qi::Message::ServiceDirectoryAction_ServiceRemoved);
       id = ob->advertiseMethod("machineId", &ServiceDirectory::machineId);
       QI_ASSERT(id == qi::Message::ServiceDirectoryAction_MachineId);
+      // Past the fixed ServiceDirectoryAction ids: resolved by name.
+      ob->advertiseSignal("servicesChanged", &ServiceDirectory::servicesChanged);
+      ob->advertiseMethod("currentSequence", &ServiceDirectory::currentSequence);
+      ob->advertiseMethod("changesSince", &ServiceDirectory::changesSince);
       ob->advertiseMethod("_socketOfService", &ServiceDirectory::_socketOfService);
+      // Bulk forms: one exchange for a whole stack of services.
+      ob->advertiseMethod("registerServices", &ServiceDirectory::registerServices);
+      ob->advertiseMethod("unregisterServices", &ServiceDirectory::unregisterServices);
+      ob->advertiseMethod("servicesReady", &ServiceDirectory::servicesReady);
       // used locally only, we do not export its id
       // Silence compile warning unused id
       (void)id;
@@ -74,11 +87,18 @@ namespace qi
 
   ServiceDirectory::ServiceDirectory()
     : servicesCount(0)
+    , servicesSnapshotDirty(true)
   {
   }
 
   ServiceDirectory::~ServiceDirectory()
   {
+    // A batching window may still be armed with a raw `this`.
+    if (changeFlush.isValid())
+    {
+      changeFlush.cancel();
+      changeFlush.wait();
+    }
     if (!connectedServices.empty())
       qiLogWarning() << "Destroying while connected services remain";
   }
@@ -122,37 +142,59 @@ namespace qi
   std::vector<ServiceInfo> ServiceDirectory::services()
   {
     boost::recursive_mutex::scoped_lock lock(mutex);
-    std::vector<ServiceInfo> result;
-    std::map<unsigned int, ServiceInfo>::const_iterator it;
-
-    for (it = connectedServices.begin(); it != connectedServices.end(); ++it)
-      result.push_back(it->second);
-
-    return result;
+    if (servicesSnapshotDirty)
+    {
+      servicesSnapshot.clear();
+      servicesSnapshot.reserve(connectedServices.size());
+      for (ServiceInfoMap::const_iterator it = connectedServices.begin();
+           it != connectedServices.end(); ++it)
+        servicesSnapshot.push_back(it->second);
+      // Keep the historical id-ordered output now that the map is unordered.
+      std::sort(servicesSnapshot.begin(), servicesSnapshot.end(),
+                [](const ServiceInfo& a, const ServiceInfo& b) {
+                  return a.serviceId() < b.serviceId();
+                });
+      servicesSnapshotDirty = false;
+    }
+    return servicesSnapshot;
   }
 
   ServiceInfo ServiceDirectory::service(const std::string &name)
   {
-    boost::recursive_mutex::scoped_lock lock(mutex);
-    std::map<unsigned int, ServiceInfo>::const_iterator servicesIt;
-    std::map<std::string, unsigned int>::const_iterator it;
-
-    it = nameToIdx.find(name);
-    if (it == nameToIdx.end()) {
-      std::stringstream ss;
-      ss << "Cannot find service '" << name << "' in index";
-      throw std::runtime_error(ss.str());
+    boost::function<bool(const std::string&)> missingHandler;
+    {
+      boost::recursive_mutex::scoped_lock lock(mutex);
+      NameToIndexMap::const_iterator it = nameToIdx.find(name);
+      if (it != nameToIdx.end())
+      {
+        ServiceInfoMap::const_iterator servicesIt = connectedServices.find(it->second);
+        if (servicesIt == connectedServices.end()) {
+          std::stringstream ss;
+          ss << "Cannot find ServiceInfo for service '" << name << "'";
+          throw std::runtime_error(ss.str());
+        }
+        return servicesIt->second;
+      }
+      missingHandler = missingServiceHandler;
     }
 
-    unsigned int idx = it->second;
-
-    servicesIt = connectedServices.find(idx);
-    if (servicesIt == connectedServices.end()) {
-      std::stringstream ss;
-      ss << "Cannot find ServiceInfo for service '" << name << "'";
-      throw std::runtime_error(ss.str());
+    // Give the handler a chance to register the service on demand (lazy
+    // mirroring), without holding the directory mutex, then retry once.
+    if (missingHandler && missingHandler(name))
+    {
+      boost::recursive_mutex::scoped_lock lock(mutex);
+      NameToIndexMap::const_iterator it = nameToIdx.find(name);
+      if (it != nameToIdx.end())
+      {
+        ServiceInfoMap::const_iterator servicesIt = connectedServices.find(it->second);
+        if (servicesIt != connectedServices.end())
+          return servicesIt->second;
+      }
     }
-    return servicesIt->second;
+
+    std::stringstream ss;
+    ss << "Cannot find service '" << name << "' in index";
+    throw std::runtime_error(ss.str());
   }
 
   unsigned int ServiceDirectory::registerService(const ServiceInfo &svcinfo)
@@ -163,7 +205,7 @@ namespace qi
 
     MessageSocketPtr socket = sbo->currentSocket();
     boost::recursive_mutex::scoped_lock lock(mutex);
-    std::map<std::string, unsigned int>::iterator it;
+    NameToIndexMap::iterator it;
     it = nameToIdx.find(svcinfo.name());
     if (it != nameToIdx.end())
     {
@@ -211,7 +253,7 @@ namespace qi
     bool pending = false;
     // search the id before accessing it
     // otherwise operator[] create a empty entry
-    std::map<unsigned int, ServiceInfo>::iterator it2;
+    ServiceInfoMap::iterator it2;
     it2 = connectedServices.find(idx);
     if (it2 == connectedServices.end()) {
       qiLogVerbose() << "Unregister Service: service #" << idx << " not found in the"
@@ -229,7 +271,7 @@ namespace qi
 
     std::string serviceName = it2->second.name();
 
-    std::map<std::string, unsigned int>::iterator it;
+    NameToIndexMap::iterator it;
     it = nameToIdx.find(serviceName);
     if (it == nameToIdx.end())
     {
@@ -258,7 +300,10 @@ namespace qi
     if (pending)
       pendingServices.erase(it2);
     else
+    {
       connectedServices.erase(it2);
+      servicesSnapshotDirty = true;
+    }
 
     // Find and remove serviceId into socketToIdx map
     {
@@ -276,12 +321,13 @@ namespace qi
     }
 
     serviceRemoved(idx, serviceName);
+    recordServiceChange(false, idx, serviceName);
   }
 
   void ServiceDirectory::updateServiceInfo(const ServiceInfo &svcinfo)
   {
     boost::recursive_mutex::scoped_lock lock(mutex);
-    std::map<unsigned int, ServiceInfo>::iterator itService;
+    ServiceInfoMap::iterator itService;
 
     for (itService = connectedServices.begin();
          itService != connectedServices.end();
@@ -290,6 +336,7 @@ namespace qi
       if (svcinfo.sessionId() == itService->second.sessionId())
       {
         itService->second.setEndpoints(svcinfo.endpoints());
+        servicesSnapshotDirty = true;
       }
     }
 
@@ -297,6 +344,7 @@ namespace qi
     if (itService != connectedServices.end())
     {
       connectedServices[svcinfo.serviceId()] = svcinfo;
+      servicesSnapshotDirty = true;
       return;
     }
 
@@ -319,7 +367,7 @@ namespace qi
     boost::recursive_mutex::scoped_lock lock(mutex);
     // search the id before accessing it
     // otherwise operator[] create a empty entry
-    std::map<unsigned int, ServiceInfo>::iterator itService;
+    ServiceInfoMap::iterator itService;
     itService = pendingServices.find(idx);
     if (itService == pendingServices.end())
     {
@@ -332,8 +380,125 @@ namespace qi
     std::string serviceName = itService->second.name();
     connectedServices[idx] = itService->second;
     pendingServices.erase(itService);
+    servicesSnapshotDirty = true;
 
     serviceAdded(idx, serviceName);
+    recordServiceChange(true, idx, serviceName);
+  }
+
+  std::vector<unsigned int> ServiceDirectory::registerServices(const std::vector<ServiceInfo> &svcinfos)
+  {
+    boost::recursive_mutex::scoped_lock lock(mutex);
+    // All or nothing: check the whole batch before registering anything,
+    // so a conflict in the middle does not leave a half-registered stack.
+    std::set<std::string> batchNames;
+    for (std::vector<ServiceInfo>::const_iterator it = svcinfos.begin();
+         it != svcinfos.end(); ++it)
+    {
+      if (nameToIdx.find(it->name()) != nameToIdx.end() ||
+          !batchNames.insert(it->name()).second)
+      {
+        std::stringstream ss;
+        ss << "Service \"" << it->name() << "\" is already registered. "
+           << "Rejecting the whole batch registration.";
+        qiLogWarning() << ss.str();
+        throw std::runtime_error(ss.str());
+      }
+    }
+    std::vector<unsigned int> idxs;
+    idxs.reserve(svcinfos.size());
+    for (std::vector<ServiceInfo>::const_iterator it = svcinfos.begin();
+         it != svcinfos.end(); ++it)
+      idxs.push_back(registerService(*it));
+    return idxs;
+  }
+
+  void ServiceDirectory::unregisterServices(const std::vector<unsigned int> &idxs)
+  {
+    boost::recursive_mutex::scoped_lock lock(mutex);
+    std::string errors;
+    for (std::vector<unsigned int>::const_iterator it = idxs.begin();
+         it != idxs.end(); ++it)
+    {
+      try {
+        unregisterService(*it);
+      } catch (const std::exception& e) {
+        // Keep going: one stale id must not keep the others registered.
+        if (!errors.empty())
+          errors += "; ";
+        errors += e.what();
+      }
+    }
+    if (!errors.empty())
+      throw std::runtime_error(errors);
+  }
+
+  void ServiceDirectory::servicesReady(const std::vector<unsigned int> &idxs)
+  {
+    boost::recursive_mutex::scoped_lock lock(mutex);
+    for (std::vector<unsigned int>::const_iterator it = idxs.begin();
+         it != idxs.end(); ++it)
+      serviceReady(*it);
+  }
+
+  qi::uint64_t ServiceDirectory::currentSequence()
+  {
+    boost::recursive_mutex::scoped_lock lock(mutex);
+    return changeSequence;
+  }
+
+  std::vector<ServiceDirectoryChange> ServiceDirectory::changesSince(qi::uint64_t sequence)
+  {
+    boost::recursive_mutex::scoped_lock lock(mutex);
+    if (sequence > changeSequence)
+      throw std::runtime_error("changesSince: sequence is ahead of the directory");
+    const qi::uint64_t oldest =
+        changeLog.empty() ? changeSequence : changeLog.front().sequence - 1;
+    if (sequence < oldest)
+      throw std::runtime_error(
+          "changesSince: sequence too old, take a new services() snapshot");
+    std::vector<ServiceDirectoryChange> out;
+    for (const ServiceDirectoryChange& change: changeLog)
+      if (change.sequence > sequence)
+        out.push_back(change);
+    return out;
+  }
+
+  void ServiceDirectory::recordServiceChange(bool added, unsigned int serviceId, const std::string& name)
+  {
+    ServiceDirectoryChange change;
+    change.serviceId = serviceId;
+    change.name = name;
+    change.added = added;
+    change.sequence = ++changeSequence;
+    static const size_t logSize = (std::max<size_t>)(
+        1, qi::os::getEnvDefault<size_t>("QI_SD_CHANGE_LOG_SIZE", 1024));
+    changeLog.push_back(change);
+    while (changeLog.size() > logSize)
+      changeLog.pop_front();
+    pendingChanges.push_back(std::move(change));
+    if (changeFlushScheduled)
+      return;
+    changeFlushScheduled = true;
+    static const int windowMs =
+        qi::os::getEnvDefault<int>("QI_SD_BATCH_WINDOW_MS", 20);
+    changeFlush = qi::getEventLoop()->asyncDelay(
+        boost::bind(&ServiceDirectory::flushServiceChanges, this),
+        qi::MilliSeconds(windowMs));
+  }
+
+  void ServiceDirectory::flushServiceChanges()
+  {
+    std::vector<ServiceDirectoryChange> batch;
+    {
+      boost::recursive_mutex::scoped_lock lock(mutex);
+      changeFlushScheduled = false;
+      batch.swap(pendingChanges);
+    }
+    if (batch.empty())
+      return;
+    qiLogDebug() << "Notifying " << batch.size() << " batched directory change(s)";
+    servicesChanged(batch);
   }
 
 
@@ -352,6 +517,11 @@ namespace qi
   {
   }
 
+  void Session_SD::setMissingServiceHandler(boost::function<bool(const std::string&)> handler)
+  {
+    _sdObject->_setMissingServiceHandler(std::move(handler));
+  }
+
   void Session_SD::updateServiceInfo()
   {
     ServiceInfo si;
@@ -451,6 +621,12 @@ namespace qi
     sbo->_onSocketDisconnectedCallback = boost::bind(&ServiceDirectory::onSocketDisconnected, this, _1, _2);
   }
 
+  void ServiceDirectory::_setMissingServiceHandler(boost::function<bool(const std::string&)> handler)
+  {
+    boost::recursive_mutex::scoped_lock lock(mutex);
+    missingServiceHandler = std::move(handler);
+  }
+
 } // !qi
 
 #ifdef _MSC_VER
@@ -7,10 +7,12 @@
 #ifndef _QIMESSAGING_SERVICEDIRECTORY_HPP_
 #define _QIMESSAGING_SERVICEDIRECTORY_HPP_
 
+# include <deque>
 # include <qi/url.hpp>
 # include <qi/future.hpp>
 # include "messagesocket.hpp"
 # include <boost/thread/recursive_mutex.hpp>
+# include <boost/unordered_map.hpp>
 # include "boundobject.hpp"
 # include "server.hpp"
 # include "objectregistrar.hpp"
@@ -33,21 +35,73 @@ namespace qi
     unsigned int             registerService(const ServiceInfo &svcinfo);
     void                     unregisterService(const unsigned int &idx);
     void                     serviceReady(const unsigned int &idx);
+    /// Registers a whole batch in one exchange. All or nothing: a name
+    /// conflict rejects the batch without registering anything.
+    std::vector<unsigned int> registerServices(const std::vector<ServiceInfo> &svcinfos);
+    /// Unregisters a batch in one exchange. Best effort: a stale id does
+    /// not keep the others registered, the errors are aggregated.
+    void                     unregisterServices(const std::vector<unsigned int> &idxs);
+    /// Batched serviceReady, acknowledging a registerServices() in one
+    /// exchange.
+    void                     servicesReady(const std::vector<unsigned int> &idxs);
     void                     updateServiceInfo(const ServiceInfo &svcinfo);
     std::string              machineId();
+    /// Sequence number of the latest directory change; grows by one per
+    /// registration or removal. Watchers snapshot it before services().
+    qi::uint64_t             currentSequence();
+    /// Every change recorded after `sequence`, oldest first. Throws when
+    /// the bounded change log no longer reaches back that far: the
+    /// watcher must then take a new services() snapshot.
+    std::vector<ServiceDirectoryChange> changesSince(qi::uint64_t sequence);
     qi::MessageSocketPtr   _socketOfService(unsigned int id);
     void                     _setServiceBoundObject(boost::shared_ptr<ServiceBoundObject> sbo);
+    /// Sets the handler invoked when service() is asked for a name that is
+    /// not registered. The handler may register the service on demand (lazy
+    /// mirroring); it returns true when it did, in which case the lookup is
+    /// retried once. Called without the directory mutex held.
+    void                     _setMissingServiceHandler(boost::function<bool(const std::string&)> handler);
+
+    /// Journals a change and schedules the batched notification; the
+    /// mutating caller holds `mutex`.
+    void recordServiceChange(bool added, unsigned int serviceId, const std::string& name);
+    /// Emits the changes accumulated during the batching window.
+    void flushServiceChanges();
 
     qi::Signal<unsigned int, std::string>  serviceAdded;
     qi::Signal<unsigned int, std::string>  serviceRemoved;
+    /// Batched form of serviceAdded/serviceRemoved: changes within
+    /// QI_SD_BATCH_WINDOW_MS (default 20) are delivered as one list, so a
+    /// fleet-wide restart costs watchers a few notifications instead of
+    /// thousands.
+    qi::Signal<std::vector<ServiceDirectoryChange>> servicesChanged;
 
   public:
-    std::map<unsigned int, ServiceInfo>                       pendingServices;
-    std::map<unsigned int, ServiceInfo>                       connectedServices;
-    std::map<std::string, unsigned int>                       nameToIdx;
+    // Lookup indexes: both sides of a session connect hit service() and
+    // services() repeatedly, so resolution must stay O(1) under reconnect
+    // storms.
+    using ServiceInfoMap = boost::unordered_map<unsigned int, ServiceInfo>;
+    using NameToIndexMap = boost::unordered_map<std::string, unsigned int>;
+
+    ServiceInfoMap                                            pendingServices;
+    ServiceInfoMap                                            connectedServices;
+    NameToIndexMap                                            nameToIdx;
     std::map<MessageSocketPtr, std::vector<unsigned int> >  socketToIdx;
     std::map<unsigned int, MessageSocketPtr>                idxToSocket;
     unsigned int                                              servicesCount;
+    // Cached services() result, rebuilt lazily after a mutation of
+    // connectedServices instead of once per call.
+    std::vector<ServiceInfo>                                  servicesSnapshot;
+    bool                                                      servicesSnapshotDirty;
+    // Change journal behind servicesChanged and changesSince(), guarded
+    // by `mutex`. The log is bounded (QI_SD_CHANGE_LOG_SIZE, default
+    // 1024): watchers whose sequence fell off take a full snapshot again.
+    qi::uint64_t                                              changeSequence = 0;
+    std::deque<ServiceDirectoryChange>                        changeLog;
+    std::vector<ServiceDirectoryChange>                       pendingChanges;
+    bool                                                      changeFlushScheduled = false;
+    qi::Future<void>                                          changeFlush;
+    // Guarded by `mutex`; copied out before invocation.
+    boost::function<bool(const std::string&)>                 missingServiceHandler;
     boost::weak_ptr<ServiceBoundObject>                       serviceBoundObject;
     /* Our methods can be invoked from remote, and from socket callbacks,
     * so thread-safety is required.
@@ -65,6 +119,7 @@ namespace qi
 
     qi::Future<void> listenStandalone(const std::vector<Url>& listenAddresses);
     void             updateServiceInfo();
+    void             setMissingServiceHandler(boost::function<bool(const std::string&)> handler);
 
   private:
     friend class SessionPrivate;
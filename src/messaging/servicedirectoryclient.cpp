@@ -8,6 +8,7 @@
 #include "messagesocket.hpp"
 #include "server.hpp"
 #include "authprovider_p.hpp"
+#include "authresume.hpp"
 
 qiLogCategory("qimessaging.servicedirectoryclient");
 
@@ -105,6 +106,12 @@ namespace qi {
       stateData = std::move(_stateData);
     }
 
+    {
+      // Resolved services are only valid for the directory we were talking to.
+      boost::mutex::scoped_lock lock(_cacheMutex);
+      _serviceCache.clear();
+    }
+
     Future<void> fut = futurize(); // if there was nothing asynchronous to do, return a future with
                                    // a value already set
 
@@ -233,6 +240,10 @@ namespace qi {
         socket->socketEvent.disconnect(_stateData.sdSocketSocketEventSignalLink);
       if (_enforceAuth)
       {
+        // A stale resume token may be the reason: drop it so the retry
+        // goes through the full exchange.
+        if (socket)
+          auth_resume::forgetToken(socket->url().str());
         std::stringstream error;
         if (msg.type() == Message::Type_Error)
           error << "Authentication failed: " << msg.value("s", socket).to<std::string>();
@@ -269,6 +280,10 @@ namespace qi {
     }
     if (authData[AuthProvider::State_Key].to<unsigned int>() == AuthProvider::State_Done)
     {
+      // Keep the resume token for the next connection to this endpoint.
+      const CapabilityMap::iterator tokenIt = authData.find(auth_resume::TokenKey);
+      if (socket && tokenIt != authData.end())
+        auth_resume::rememberToken(socket->url().str(), tokenIt->second.to<std::string>());
       if (socket)
         socket->socketEvent.disconnect(_stateData.sdSocketSocketEventSignalLink);
       qi::Future<void> future = _remoteObject->fetchMetaObject();
@@ -322,6 +337,11 @@ namespace qi {
 
     CapabilityMap socketCaps = socket->localCapabilities();
     socketCaps.insert(authCaps.begin(), authCaps.end());
+    // Resumable authentication: replay the token from a previous exchange
+    // with this endpoint, so the server can conclude in one round trip.
+    const std::string resumeToken = auth_resume::tokenFor(socket->url().str());
+    if (!resumeToken.empty())
+      socketCaps[auth_resume::TokenKey] = AnyValue::from(resumeToken);
 
     Message msgCapabilities;
     msgCapabilities.setFunction(Message::ServerFunction_Authenticate);
@@ -350,6 +370,8 @@ namespace qi {
 
       if (!_stateData.sdSocket)
         return qi::makeFutureError<void>(std::string("unrecognized protocol '") + serviceDirectoryURL.protocol() + "' in url '" + serviceDirectoryURL.str() + "'");
+      if (_flightRecorder)
+        _stateData.sdSocket->setFlightRecorder(_flightRecorder);
       auto socket = _stateData.sdSocket;
       _stateData.sdSocketDisconnectedSignalLink = _stateData.sdSocket->disconnected.connect(track(
           [=](const std::string& reason) mutable {
@@ -422,11 +444,20 @@ namespace qi {
 
   void ServiceDirectoryClient::onServiceRemoved(unsigned int idx, const std::string &name) {
     qiLogVerbose() << "ServiceDirectoryClient: Service Removed #" << idx << ": " << name << std::endl;
+    {
+      boost::mutex::scoped_lock lock(_cacheMutex);
+      _serviceCache.erase(name);
+    }
     serviceRemoved(idx, name);
   }
 
   void ServiceDirectoryClient::onServiceAdded(unsigned int idx, const std::string &name) {
     qiLogVerbose() << "ServiceDirectoryClient: Service Added #" << idx << ": " << name << std::endl;
+    {
+      // A re-registration may carry new endpoints: drop any stale entry.
+      boost::mutex::scoped_lock lock(_cacheMutex);
+      _serviceCache.erase(name);
+    }
     serviceAdded(idx, name);
   }
 
@@ -459,7 +490,20 @@ namespace qi {
   }
 
   qi::Future<ServiceInfo>              ServiceDirectoryClient::service(const std::string &name) {
-    return _object.async< ServiceInfo >("service", name);
+    {
+      boost::mutex::scoped_lock lock(_cacheMutex);
+      ServiceInfoCache::const_iterator it = _serviceCache.find(name);
+      if (it != _serviceCache.end())
+        return qi::Future<ServiceInfo>(it->second);
+    }
+    qi::Future<ServiceInfo> fut = _object.async< ServiceInfo >("service", name);
+    fut.connect(track([this, name](const qi::Future<ServiceInfo>& result) {
+          if (!result.hasValue())
+            return;
+          boost::mutex::scoped_lock lock(_cacheMutex);
+          _serviceCache[name] = result.value();
+        }, this));
+    return fut;
   }
 
   qi::Future<unsigned int>             ServiceDirectoryClient::registerService(const ServiceInfo &svcinfo) {
@@ -474,7 +518,24 @@ namespace qi {
     return _object.async<void>("serviceReady", idx);
   }
 
+  qi::Future<std::vector<unsigned int>> ServiceDirectoryClient::registerServices(const std::vector<ServiceInfo> &svcinfos) {
+    return _object.async< std::vector<unsigned int> >("registerServices", svcinfos);
+  }
+
+  qi::Future<void>                     ServiceDirectoryClient::unregisterServices(const std::vector<unsigned int> &idxs) {
+    return _object.async<void>("unregisterServices", idxs);
+  }
+
+  qi::Future<void>                     ServiceDirectoryClient::servicesReady(const std::vector<unsigned int> &idxs) {
+    return _object.async<void>("servicesReady", idxs);
+  }
+
   qi::Future<void>                     ServiceDirectoryClient::updateServiceInfo(const ServiceInfo &svcinfo) {
+    {
+      // The directory emits no signal for plain info updates.
+      boost::mutex::scoped_lock lock(_cacheMutex);
+      _serviceCache.erase(svcinfo.name());
+    }
     return _object.async<void>("updateServiceInfo", svcinfo);
   }
 
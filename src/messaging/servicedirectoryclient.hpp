@@ -9,6 +9,7 @@
 
 #include <vector>
 #include <string>
+#include <boost/unordered_map.hpp>
 #include <qi/signal.hpp>
 #include <qi/trackable.hpp>
 #include <qi/messaging/serviceinfo.hpp>
@@ -43,6 +44,10 @@ namespace qi {
     qi::Future< unsigned int >             registerService(const ServiceInfo &svcinfo);
     qi::Future< void >                     unregisterService(const unsigned int &idx);
     qi::Future< void >                     serviceReady(const unsigned int &idx);
+    // Bulk forms, completing a whole batch in one directory exchange.
+    qi::Future< std::vector<unsigned int> > registerServices(const std::vector<ServiceInfo> &svcinfos);
+    qi::Future< void >                     unregisterServices(const std::vector<unsigned int> &idxs);
+    qi::Future< void >                     servicesReady(const std::vector<unsigned int> &idxs);
     qi::Future< void >                     updateServiceInfo(const ServiceInfo &svcinfo);
     qi::Future< std::string >              machineId();
     /// if isLocal() only, return socket holding given service id
@@ -56,6 +61,9 @@ namespace qi {
     MessageSocketPtr socket();
     // True if ServiceDirectory is local
     bool isLocal();
+    /// Recorder installed on the service directory socket at creation (see
+    /// MessageSocket::setFlightRecorder). To call before connect().
+    void setFlightRecorder(FlightRecorderPtr recorder) { _flightRecorder = recorder; }
   private:
     //ServiceDirectory Interface
     void onServiceAdded(unsigned int idx, const std::string &name);
@@ -104,10 +112,23 @@ namespace qi {
     };
 
     StateData _stateData; // protected by _mutex
+
+    /* Cache of resolved services, filled by service() and invalidated by the
+     * serviceAdded/serviceRemoved signals the directory pushes to us (a
+     * re-registration emits both, so stale endpoints are dropped). Cleared
+     * wholesale on disconnection since we may reconnect to another directory.
+     * Caveat: a bare updateServiceInfo() from another session emits no
+     * signal, so we also drop the entry when this client updates a service.
+     */
+    using ServiceInfoCache = boost::unordered_map<std::string, ServiceInfo>;
+    ServiceInfoCache _serviceCache; // protected by _cacheMutex
+    boost::mutex _cacheMutex;
+
     std::unique_ptr<qi::RemoteObject> _remoteObject;
     // _object is a remote object of serviceDirectory
     AnyObject _object;
     ClientAuthenticatorFactoryPtr _authFactory;
+    FlightRecorderPtr _flightRecorder;
     bool _enforceAuth;
     mutable boost::mutex _mutex;
   };
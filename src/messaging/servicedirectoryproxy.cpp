@@ -93,6 +93,41 @@ AuthProviderFactoryPtr placeholderIfNull(AuthProviderFactoryPtr factory)
   return factory;
 }
 
+/// Matches a name against a pattern where '*' matches any sequence of
+/// characters. Iterative so that pathological patterns stay linear.
+bool matchesWildcardPattern(boost::string_ref name, boost::string_ref pattern)
+{
+  std::size_t n = 0;
+  std::size_t p = 0;
+  std::size_t lastStar = std::string::npos;
+  std::size_t backtrack = 0;
+  while (n < name.size())
+  {
+    if (p < pattern.size() && pattern[p] == '*')
+    {
+      lastStar = p++;
+      backtrack = n;
+    }
+    else if (p < pattern.size() && pattern[p] == name[n])
+    {
+      ++p;
+      ++n;
+    }
+    else if (lastStar != std::string::npos)
+    {
+      p = lastStar + 1;
+      n = ++backtrack;
+    }
+    else
+    {
+      return false;
+    }
+  }
+  while (p < pattern.size() && pattern[p] == '*')
+    ++p;
+  return p == pattern.size();
+}
+
 MirroringResult mirrorService(const std::string& name,
                               Session& srcSess,
                               Session& destSess,
@@ -171,6 +206,7 @@ public:
   Future<void> setAuthProviderFactory(AuthProviderFactoryPtr provider);
   Future<void> attachToServiceDirectory(const Url& sdUrl);
   Future<ServiceFilter> setServiceFilter(ServiceFilter filter);
+  Future<void> setLazyMirroring(bool enabled);
 
 private:
   // Precondition synchronized():
@@ -184,6 +220,18 @@ private:
   // Precondition: synchronized()
   MirroringResult mirrorServiceFromSDUnsync(unsigned int remoteId, const std::string& serviceName);
 
+  // Precondition: synchronized()
+  //
+  // Mirrors a service from the service directory immediately, regardless of
+  // the lazy mirroring mode.
+  MirroringResult mirrorServiceFromSDNowUnsync(unsigned int remoteId, const std::string& serviceName);
+
+  // Precondition: synchronized()
+  //
+  // Mirrors a service whose mirroring was deferred by the lazy mirroring
+  // mode. Returns true when the service is now available on the proxy.
+  bool mirrorDeferredServiceUnsync(const std::string& serviceName);
+
   // Precondition: synchronized() && _sdClient
   //
   // Binds to a service directory by connecting to its signals.
@@ -289,6 +337,10 @@ private:
   };
   using MirroredServiceInfoMap = std::unordered_map<std::string, MirroredServiceInfo>;
   MirroredServiceInfoMap _servicesInfo;
+  // Services whose mirroring is deferred until first client use (lazy
+  // mirroring mode), mapped to their id on the service directory.
+  std::unordered_map<std::string, unsigned int> _deferredServices;
+  bool _lazyMirroring = false;
   Url _listenUrl;
   Url _sdUrl;
   boost::optional<Identity> _identity;
@@ -324,6 +376,22 @@ Future<ServiceDirectoryProxy::ServiceFilter> ServiceDirectoryProxy::setServiceFi
   return _p->setServiceFilter(std::move(filter));
 }
 
+ServiceDirectoryProxy::ServiceFilter ServiceDirectoryProxy::allowListServiceFilter(
+    std::vector<std::string> allowedPatterns)
+{
+  return [allowedPatterns](boost::string_ref name) {
+    for (const auto& pattern : allowedPatterns)
+      if (matchesWildcardPattern(name, pattern))
+        return false; // in the allow-list: not filtered
+    return true; // matches no pattern: filtered out
+  };
+}
+
+Future<void> ServiceDirectoryProxy::setLazyMirroring(bool enabled)
+{
+  return _p->setLazyMirroring(enabled);
+}
+
 UrlVector ServiceDirectoryProxy::endpoints() const
 {
   return _p->endpoints().value();
@@ -416,6 +484,7 @@ void ServiceDirectoryProxy::Impl::closeUnsync()
     auto server = std::move_if_noexcept(_server);     // idem
     _status.set(totallyDisconnected);
     _servicesInfo.clear();
+    _deferredServices.clear();
   }
   catch (const std::exception& ex)
   {
@@ -474,6 +543,7 @@ Future<ServiceDirectoryProxy::ListenStatus> ServiceDirectoryProxy::Impl::listenA
           qiLogVerbose() << "Instanciating server";
           _status.set(ListenStatus::NotListening);
           _servicesInfo.clear();
+          _deferredServices.clear();
           _server = createServerUnsync();
           _status.set(ListenStatus::Starting);
         }
@@ -593,6 +663,19 @@ Future<ServiceDirectoryProxy::ServiceFilter> ServiceDirectoryProxy::Impl::setSer
   });
 }
 
+Future<void> ServiceDirectoryProxy::Impl::setLazyMirroring(bool enabled)
+{
+  return _strand.async([=] {
+    if (_lazyMirroring == enabled)
+      return;
+    qiLogVerbose() << (enabled ? "Enabling" : "Disabling") << " lazy mirroring";
+    _lazyMirroring = enabled;
+    // Materialize the services that were deferred while the mode was active.
+    if (!enabled && _status.current().isReady())
+      mirrorAllServices();
+  });
+}
+
 Future<void> ServiceDirectoryProxy::Impl::mirrorAllServices()
 {
   return _strand.async([=] {
@@ -626,15 +709,48 @@ MirroringResult ServiceDirectoryProxy::Impl::mirrorServiceFromSDUnsync(unsigned
     return { name, MirroringResult::Status::Skipped, {} };
   }
 
+  if (_lazyMirroring)
+  {
+    qiLogVerbose() << "Deferring mirroring of service '" << name
+                   << "' until its first client use.";
+    _deferredServices[name] = remoteId;
+    return { name, MirroringResult::Status::Skipped, {} };
+  }
+
+  return mirrorServiceFromSDNowUnsync(remoteId, name);
+}
+
+MirroringResult ServiceDirectoryProxy::Impl::mirrorServiceFromSDNowUnsync(unsigned int remoteId,
+                                                                          const std::string& name)
+{
   qiLogVerbose() << "Mirroring service '" << name << "' from the service directory to the proxy.";
   const auto result =
       mirrorService(name, *_sdClient, *_server, "service directory", "proxy");
   if (result.mirroredId)
+  {
+    _deferredServices.erase(name);
     _servicesInfo[name] = { *result.mirroredId, remoteId,
                             MirroredServiceInfo::Source::ServiceDirectory };
+  }
   return result;
 }
 
+bool ServiceDirectoryProxy::Impl::mirrorDeferredServiceUnsync(const std::string& name)
+{
+  const auto deferredIt = _deferredServices.find(name);
+  if (deferredIt == _deferredServices.end())
+    return false;
+  const auto remoteId = deferredIt->second;
+
+  if (immediateMirroringFailureUnsync(name))
+    return false;
+
+  qiLogVerbose() << "Service '" << name
+                 << "' is being requested for the first time, mirroring it now.";
+  const auto result = mirrorServiceFromSDNowUnsync(remoteId, name);
+  return result.status == MirroringResult::Status::Done;
+}
+
 void ServiceDirectoryProxy::Impl::bindToServiceDirectoryUnsync()
 {
   using ka::scoped;
@@ -792,6 +908,14 @@ void ServiceDirectoryProxy::Impl::unmirrorServiceFromSDUnsync(const std::string&
   if (!_server)
     return;
 
+  // A deferred service that was never used has nothing to unregister.
+  if (_deferredServices.erase(serviceName) > 0)
+  {
+    qiLogVerbose() << "Dropped deferred service '" << serviceName
+                   << "', it was never mirrored.";
+    return;
+  }
+
   try
   {
     const auto serviceIndexIt = _servicesInfo.find(serviceName);
@@ -859,6 +983,17 @@ SessionPtr ServiceDirectoryProxy::Impl::createServerUnsync()
   }
   server->setAuthProviderFactory(placeholderIfNull(_authProviderFactory));
 
+  // Resolve lookups of deferred services by mirroring them on demand (lazy
+  // mirroring). Called from a messaging thread of the server: hop onto the
+  // strand and wait for the mirroring to finish so that the directory can
+  // retry the lookup. Returns false instead of throwing so a failure ends
+  // up as a plain "service not found" on the client side.
+  server->setDirectoryMissingServiceHandler([=](const std::string& name) {
+    return ka::invoke_catch(ka::constant_function(false), [&] {
+      return _strand.async([=] { return mirrorDeferredServiceUnsync(name); }).value();
+    });
+  });
+
   bool connectSucceeded = false;
 
   auto scopedDisconnectServiceRegistered =
@@ -9,7 +9,9 @@
 # pragma warning(disable: 4355)
 #endif
 
+#include <set>
 #include <sstream>
+#include <boost/make_shared.hpp>
 #include <qi/session.hpp>
 #include <ka/scoped.hpp>
 #include "message.hpp"
@@ -28,7 +30,8 @@ qiLogCategory("qimessaging.session");
 namespace qi {
 
   SessionPrivate::SessionPrivate(qi::Session* session, bool enforceAuth)
-    : _sdClient(enforceAuth)
+    : _flightRecorder(boost::make_shared<FlightRecorder>())
+    , _sdClient(enforceAuth)
     , _serverObject(&_sdClient, enforceAuth)
     , _serviceHandler(&_socketsCache, &_sdClient, &_serverObject, enforceAuth)
     , _servicesHandler(&_sdClient, &_serverObject)
@@ -47,6 +50,10 @@ namespace qi {
     _sdClient.serviceRemoved.connect(session->serviceUnregistered);
     setAuthProviderFactory(AuthProviderFactoryPtr(new NullAuthProviderFactory));
     setClientAuthenticatorFactory(ClientAuthenticatorFactoryPtr(new NullClientAuthenticatorFactory));
+
+    _sdClient.setFlightRecorder(_flightRecorder);
+    _serverObject.setFlightRecorder(_flightRecorder);
+    _socketsCache.setFlightRecorder(_flightRecorder);
   }
 
   SessionPrivate::~SessionPrivate()
@@ -66,11 +73,15 @@ namespace qi {
     }
   }
 
-  void SessionPrivate::onServiceDirectoryClientDisconnected(std::string /*error*/)
+  void SessionPrivate::onServiceDirectoryClientDisconnected(std::string error)
   {
     if (_sdClientClosedByThis)
       return;
 
+    // Postmortem material: the recent messaging history usually tells what
+    // the session was doing when the link to the directory broke.
+    _flightRecorder->dump("service directory disconnected: " + error);
+
     /*
      * Remove all proxies to services if the SD is fallen.
      */
@@ -240,6 +251,36 @@ namespace qi {
     return _p->_servicesHandler.services(locality);
   }
 
+  std::vector<SocketStats> Session::socketsStats()
+  {
+    std::vector<SocketStats> stats;
+    // The same socket can be reachable through several paths (e.g. the
+    // service directory socket is also in the cache on a standalone
+    // session): report each one once.
+    std::set<MessageSocket*> seen;
+    const auto add = [&](const MessageSocketPtr& socket) {
+      if (!socket || !seen.insert(socket.get()).second)
+        return;
+      stats.push_back(socket->stats());
+    };
+    add(_p->_sdClient.socket());
+    for (const auto& socket: _p->_socketsCache.connectedSockets())
+      add(socket);
+    for (const auto& socket: _p->_serverObject.sockets())
+      add(socket);
+    return stats;
+  }
+
+  MemoryStats Session::memoryStats()
+  {
+    return qi::memoryStats();
+  }
+
+  void Session::dumpMessageHistory()
+  {
+    _p->_flightRecorder->dump("requested");
+  }
+
   qi::FutureSync< qi::AnyObject > Session::service(
     const std::string& service, const std::string& protocol, qi::MilliSeconds timeout)
   {
@@ -265,6 +306,11 @@ namespace qi {
     return _p->listenStandalone(addresses);
   }
 
+  void Session::setDirectoryMissingServiceHandler(boost::function<bool(const std::string&)> handler)
+  {
+    _p->_sd.setMissingServiceHandler(std::move(handler));
+  }
+
   qi::FutureSync<void> SessionPrivate::listenStandalone(const std::vector<qi::Url>& addresses)
   {
     _serverObject.open();
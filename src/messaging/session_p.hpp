@@ -42,6 +42,11 @@ namespace qi {
     // internal, add sd socket to socket cache
     void addSdSocketToCache(Future<void>, const qi::Url& url, qi::Promise<void> p);
 
+    // Flight recorder shared by every socket of this session: the sd link,
+    // the client connections and the accepted ones. Created first so it
+    // outlives the components that install it on their sockets.
+    FlightRecorderPtr    _flightRecorder;
+
     //ServiceDirectoryClient have a transportsocket not belonging to transportsocketcache
     ServiceDirectoryClient _sdClient;
 
@@ -10,10 +10,12 @@
 #endif
 
 #include <ka/scoped.hpp>
+#include <qi/os.hpp>
 #include "sessionservice.hpp"
 #include "servicedirectoryclient.hpp"
 #include "objectregistrar.hpp"
 #include "remoteobject_p.hpp"
+#include "authresume.hpp"
 
 qiLogCategory("qimessaging.sessionservice");
 
@@ -122,6 +124,18 @@ namespace qi {
     qi::getEventLoop()->post(boost::bind(&deleteLater, remote, sr));
   }
 
+  namespace
+  {
+    // Process-wide on purpose: the situation being diagnosed involves
+    // several sessions of one process, so a per-session count would hide it.
+    qi::Atomic<unsigned int> loopbackSerializationCounter;
+  }
+
+  unsigned int Session_Service::loopbackSerializationCount()
+  {
+    return loopbackSerializationCounter.load();
+  }
+
   namespace session_service_private
   {
     static void sendCapabilities(MessageSocketPtr sock)
@@ -209,6 +223,9 @@ namespace qi {
         socket->socketEvent.disconnect(*old);
       if (_enforceAuth)
       {
+        // A stale resume token may be the reason: drop it so the retry
+        // goes through the full exchange.
+        auth_resume::forgetToken(socket->url().str());
         std::stringstream error;
         if (msg.type() == Message::Type_Error)
           error << "Error while authenticating: " << msg.value("s", socket).to<std::string>();
@@ -253,6 +270,10 @@ namespace qi {
     }
     if (authData[AuthProvider::State_Key].to<unsigned int>() == AuthProvider::State_Done)
     {
+      // Keep the resume token for the next connection to this endpoint.
+      const CapabilityMap::iterator tokenIt = authData.find(auth_resume::TokenKey);
+      if (tokenIt != authData.end())
+        auth_resume::rememberToken(socket->url().str(), tokenIt->second.to<std::string>());
       qi::Future<void> metaObjFut;
       if (old)
         socket->socketEvent.disconnectAsync(*old);
@@ -357,6 +378,11 @@ namespace qi {
       socket->advertiseCapabilities(socketCaps);
     }
     socketCaps.insert(authCaps.begin(), authCaps.end());
+    // Resumable authentication: replay the token from a previous exchange
+    // with this endpoint, so the server can conclude in one round trip.
+    const std::string resumeToken = auth_resume::tokenFor(socket->url().str());
+    if (!resumeToken.empty())
+      socketCaps[auth_resume::TokenKey] = AnyValue::from(resumeToken);
     msgCapabilities.setValue(socketCaps, typeOf<CapabilityMap>()->signature());
     socket->send(std::move(msgCapabilities));
   }
@@ -501,6 +527,34 @@ namespace qi {
         }
         const qi::ServiceInfo& si = fut.value();
         sr->serviceId = si.serviceId();
+
+        // The service may have been registered in our own server while the
+        // directory round trip was in flight. Re-checking here upholds the
+        // guarantee of service(): a locally-registered service is always
+        // returned as its direct object, never through a socket.
+        if (qi::AnyObject local = _server->registeredServiceObject(sr->name))
+        {
+          qiLogVerbose() << "Service '" << sr->name << "' was registered locally "
+            "during resolution, returning the direct object.";
+          sr->promise.setValue(local);
+          removeRequest(requestId);
+          mustSetPromise = false;
+          return;
+        }
+
+        // Past this point, calls will serialize through a socket. If the
+        // service lives in this very process (registered by another
+        // session), every call pays an encode/loopback/decode round trip;
+        // count it so such pipelines can be found.
+        if (si.machineId() == os::getMachineId() &&
+            si.processId() == static_cast<unsigned int>(os::getpid()))
+        {
+          ++loopbackSerializationCounter;
+          qiLogVerbose() << "Service '" << sr->name << "' lives in this process "
+            "(pid " << si.processId() << ") but is not in the local server: "
+            "calls will serialize through a socket loopback.";
+        }
+
         if (_sdClient->isLocal())
         { // Wait! If sd is local, we necessarily have an open socket
           // on which service was registered, whose lifetime is bound
@@ -49,9 +49,26 @@ namespace qi {
 
     void close();
 
+    /** Resolves a service by name.
+
+        Same-process guarantee: a service registered in this session's own
+        server is always returned as its direct AnyObject, so calls on it
+        never serialize. The local table is checked before anything else,
+        and checked again once the service directory answers, so a
+        registration racing with the resolution still yields the direct
+        object instead of a socket-backed proxy.
+    */
     qi::Future<qi::AnyObject> service(const std::string &service,
                                       const std::string &protocol);
 
+    /** Number of times a service living in this process was resolved
+        through a socket anyway (typically: registered by another session
+        of the same process). Such calls pay a full encode/loopback/decode
+        round trip for nothing; the counter is process-wide so these setups
+        can be spotted from diagnostics.
+    */
+    static unsigned int loopbackSerializationCount();
+
     void addService(const std::string& name, const qi::AnyObject &obj);
     void removeService(const std::string &service);
 
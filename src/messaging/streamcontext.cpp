@@ -16,6 +16,16 @@ namespace qi
     char const * const messageFlags          = "MessageFlags";
     char const * const remoteCancelableCalls = "RemoteCancelableCalls";
     char const * const objectPtrUid          = "ObjectPtrUID";
+    char const * const messageCompression    = "MessageCompression";
+    char const * const messageFragmentation  = "MessageFragmentation";
+    char const * const compactHeader         = "CompactHeader";
+    char const * const batchCancel           = "BatchCancel";
+    char const * const deltaEvents           = "DeltaEvents";
+    char const * const callDeadline          = "CallDeadline";
+    char const * const authPipelining        = "AuthPipelining";
+    char const * const compactValues         = "CompactValues";
+    char const * const metaObjectHash        = "MetaObjectHash";
+    char const * const compactValuesActive   = "CompactValuesActive";
   }
 
 
@@ -31,11 +41,54 @@ StreamContext::~StreamContext()
 void StreamContext::advertiseCapability(const std::string& key, const AnyValue& value)
 {
   _localCapabilityMap[key] = value;
+  recomputeSharedCapabilityFlags();
 }
 
 void StreamContext::advertiseCapabilities(const CapabilityMap &map)
 {
   _localCapabilityMap.insert(map.begin(), map.end());
+  recomputeSharedCapabilityFlags();
+}
+
+void StreamContext::recomputeSharedCapabilityFlags()
+{
+  boost::mutex::scoped_lock lock(_contextMutex);
+  // Same semantics as sharedCapability<bool>(name, false): true only when
+  // both ends advertise true, absent or ill-typed entries counting false.
+  const auto enabled = [&](char const* name) -> bool {
+    const auto localIt = _localCapabilityMap.find(name);
+    const auto remoteIt = _remoteCapabilityMap.find(name);
+    if (localIt == _localCapabilityMap.end() || remoteIt == _remoteCapabilityMap.end())
+      return false;
+    try
+    {
+      return localIt->second.to<bool>() && remoteIt->second.to<bool>();
+    }
+    catch (const std::exception&)
+    {
+      return false;
+    }
+  };
+  unsigned int flags = 0;
+  if (enabled(capabilityname::metaObjectCache))
+    flags |= SharedCapability_MetaObjectCache;
+  if (enabled(capabilityname::remoteCancelableCalls))
+    flags |= SharedCapability_RemoteCancelableCalls;
+  if (enabled(capabilityname::objectPtrUid))
+    flags |= SharedCapability_ObjectPtrUid;
+  if (enabled(capabilityname::messageCompression))
+    flags |= SharedCapability_MessageCompression;
+  if (enabled(capabilityname::messageFragmentation))
+    flags |= SharedCapability_MessageFragmentation;
+  if (enabled(capabilityname::compactHeader))
+    flags |= SharedCapability_CompactHeader;
+  if (enabled(capabilityname::batchCancel))
+    flags |= SharedCapability_BatchCancel;
+  if (enabled(capabilityname::deltaEvents))
+    flags |= SharedCapability_DeltaEvents;
+  if (enabled(capabilityname::callDeadline))
+    flags |= SharedCapability_CallDeadline;
+  _sharedCapabilityFlags = flags;
 }
 
 boost::optional<AnyValue> StreamContext::remoteCapability(const std::string& key) const
@@ -54,6 +107,43 @@ bool StreamContext::hasReceivedRemoteCapabilities() const
   return _remoteCapabilityMap.size() != 0;
 }
 
+bool StreamContext::compactValuesSendEnabled()
+{
+  const int state = _compactValuesSend.load();
+  if (state == 1)
+    return true;
+  if (state != 0)
+    return false;
+  if (!hasReceivedRemoteCapabilities())
+    return false; // stay undecided, the capability exchange is in flight
+  if (!sharedCapability<bool>(capabilityname::compactValues, false))
+  {
+    _compactValuesSend.setIfEquals(0, -1);
+    return false;
+  }
+  // Announce the switch before using it. The announcement itself (whose
+  // payload is encoded while the state is 2, also shielding against
+  // recursion) and everything before it stay in the fixed encoding, so the
+  // remote latches at the exact message boundary. A concurrent encoder
+  // losing the race sends its payload fixed one last time.
+  if (!_compactValuesSend.setIfEquals(0, 2))
+    return false;
+  advertiseCapability(capabilityname::compactValuesActive, AnyValue::from(true));
+  _compactValuesSend = 1;
+  return true;
+}
+
+bool StreamContext::compactValuesReceiveEnabled() const
+{
+  if (_compactValuesReceive.load() != 0)
+    return true;
+  if (!remoteCapability<bool>(capabilityname::compactValuesActive, false))
+    return false;
+  // Monotonic: the remote never goes back to the fixed encoding.
+  _compactValuesReceive = 1;
+  return true;
+}
+
 
 const CapabilityMap& StreamContext::remoteCapabilities() const
 {
@@ -93,12 +183,15 @@ void StreamContext::receiveCacheSet(unsigned int uid, const MetaObject& mo)
 
 std::pair<unsigned int, bool> StreamContext::sendCacheSet(const MetaObject& mo)
 {
+  // Compute the hash before taking the lock: it may refresh the MetaObject
+  // cache, which takes the MetaObject's own locks.
+  const ka::sha1_digest_t hash = mo.contentHash();
   boost::mutex::scoped_lock lock(_contextMutex);
-  SendMetaObjectCache::iterator it = _sendMetaObjectCache.find(mo);
+  SendMetaObjectCache::iterator it = _sendMetaObjectCache.find(hash);
   if (it == _sendMetaObjectCache.end())
   {
     unsigned int v = ++_cacheNextId;
-    _sendMetaObjectCache[mo] = v;
+    _sendMetaObjectCache[hash] = v;
     return std::make_pair(v, true);
   }
   else
@@ -113,7 +206,38 @@ static void initCapabilities()
   , { capabilityname::messageFlags         , AnyValue::from(true)  }
   , { capabilityname::metaObjectCache      , AnyValue::from(false) }
   , { capabilityname::remoteCancelableCalls, AnyValue::from(true)  }
+  // On by default: only used when both ends advertise it, so old peers
+  // simply keep receiving one cancel message per call.
+  , { capabilityname::batchCancel          , AnyValue::from(true)  }
   , { capabilityname::objectPtrUid         , AnyValue::from(true)  }
+  // Off by default like metaObjectCache: enable on bandwidth-bound links
+  // with QI_TRANSPORT_CAPABILITIES=+MessageCompression on both ends.
+  , { capabilityname::messageCompression   , AnyValue::from(false) }
+  // Same opt-in scheme: +MessageFragmentation on both ends keeps bulk
+  // transfers from stalling small messages behind them.
+  , { capabilityname::messageFragmentation , AnyValue::from(false) }
+  // Opt-in too: +CompactHeader on both ends shrinks each eligible header
+  // from 28 to 18 bytes, which matters for small messages on radio links.
+  , { capabilityname::compactHeader        , AnyValue::from(false) }
+  // Opt-in too: +DeltaEvents on both ends sends only the changed fields of
+  // high-rate struct event streams (joint states and the like).
+  , { capabilityname::deltaEvents          , AnyValue::from(false) }
+  // On by default: the budget is only appended when both ends advertise
+  // it, so old peers get plain calls and keep the caller-side deadline.
+  , { capabilityname::callDeadline         , AnyValue::from(true)  }
+  // On by default: only changes what a server does with messages received
+  // while the authentication exchange is still running, and only for
+  // clients that advertised it in their authentication message.
+  , { capabilityname::authPipelining       , AnyValue::from(true)  }
+  // Opt-in like the other wire-format toggles: +CompactValues on both ends
+  // varint-encodes integers and length prefixes, which shrinks payloads
+  // full of small counters at some encoding cost. Keep it off on gateways
+  // relaying raw payloads between connections: the encoding is negotiated
+  // per connection and a relayed payload keeps its original one.
+  , { capabilityname::compactValues        , AnyValue::from(false) }
+  // On by default: purely additive, the hash is only requested from ends
+  // that advertise it, old peers simply serve the full fetch.
+  , { capabilityname::metaObjectHash       , AnyValue::from(true)  }
   };
 
   _defaultCapabilities = new CapabilityMap(defaultCaps);
@@ -37,6 +37,70 @@ using CapabilityMap = std::map<std::string, AnyValue>;
 
     // Capability: Objects allow unique identification using Ptruid.
     QI_API extern char const * const objectPtrUid;
+
+    // Capability: remote end understands LZ4-compressed payloads
+    // (TypeFlag_Compressed in the message header flags).
+    // Large payloads are only compressed when both ends advertise it.
+    QI_API extern char const * const messageCompression;
+
+    // Capability: remote end reassembles fragmented payloads
+    // (TypeFlag_MoreFragments in the message header flags).
+    // Large payloads are only fragmented when both ends advertise it.
+    QI_API extern char const * const messageFragmentation;
+
+    // Capability: remote end decodes the 18-byte compact wire header
+    // (Message::CompactHeader) in place of the regular 28-byte one.
+    // Compact headers are only sent when both ends advertise it, and the
+    // receive path only accepts them when this process advertises it, which
+    // must be done process-wide through QI_TRANSPORT_CAPABILITIES (a
+    // per-socket advertiseCapability() is not seen by the receive loop).
+    QI_API extern char const * const compactHeader;
+
+    // Capability: remote end decodes batched cancel messages
+    // (TypeFlag_BatchCancel): one Type_Cancel message carrying the ids of
+    // several calls to cancel. Only sent when both ends advertise it.
+    QI_API extern char const * const batchCancel;
+
+    // Capability: remote end rebuilds delta-encoded event payloads
+    // (TypeFlag_DeltaPayload in the message header flags): single-struct
+    // event streams only carry the fields that changed since the previous
+    // event, with periodic full keyframes.
+    // Deltas are only sent when both ends advertise it.
+    QI_API extern char const * const deltaEvents;
+
+    // Capability: remote end decodes the per-call completion budget
+    // appended to call payloads (TypeFlag_CallDeadline) and skips calls
+    // it dequeues after their budget ran out. Only sent when both ends
+    // advertise it.
+    QI_API extern char const * const callDeadline;
+
+    // Capability: this end may send its first calls right behind its
+    // authentication message instead of waiting for the reply; a server
+    // seeing the capability parks those early messages and replays them
+    // once the exchange concludes, instead of treating them as an error.
+    QI_API extern char const * const authPipelining;
+
+    // Capability: remote end decodes the compact value encoding (binary
+    // protocol change): integers of two bytes and more are zigzag/LEB128
+    // varints instead of fixed-size words, which also shortens string and
+    // container length prefixes. Only used when both ends advertise it,
+    // and only after the sender announced the switch on its stream (see
+    // compactValuesActive), so either end can start mid-stream without
+    // ambiguity.
+    QI_API extern char const * const compactValues;
+
+    // Capability: remote end answers metaObjectHash (bound function 17)
+    // with the content hash of an object's MetaObject, letting a
+    // reconnecting client skip the full MetaObject fetch when its cached
+    // copy has the same hash.
+    QI_API extern char const * const metaObjectHash;
+
+    // Runtime announcement, not a negotiated capability: a peer advertises
+    // it on a stream right before switching its own messages to the
+    // compact value encoding. Everything up to and including the
+    // announcement stays in the fixed encoding, so the receiver latches at
+    // the exact message boundary.
+    QI_API extern char const * const compactValuesActive;
   }
 
 /** Store contextual data associated to one point-to-point point transport.
@@ -90,6 +154,43 @@ public:
   template<typename T>
   T sharedCapability(const std::string& key, const T& defaultValue) const;
 
+  /** Boolean capabilities consulted on per-message paths, resolved once
+   * into a bitfield whenever either capability map changes, so the hot
+   * paths do a single load instead of two string-keyed map lookups.
+   */
+  enum SharedCapability
+  {
+    SharedCapability_MetaObjectCache       = 1 << 0,
+    SharedCapability_RemoteCancelableCalls = 1 << 1,
+    SharedCapability_ObjectPtrUid          = 1 << 2,
+    SharedCapability_MessageCompression    = 1 << 3,
+    SharedCapability_MessageFragmentation  = 1 << 4,
+    SharedCapability_CompactHeader         = 1 << 5,
+    SharedCapability_BatchCancel           = 1 << 6,
+    SharedCapability_DeltaEvents           = 1 << 7,
+    SharedCapability_CallDeadline          = 1 << 8,
+  };
+
+  /// Equivalent to sharedCapability<bool>(name, false) for the names
+  /// listed in SharedCapability, as a single atomic load.
+  bool sharedCapabilityFlag(SharedCapability cap) const
+  {
+    return (_sharedCapabilityFlags.load() & cap) != 0;
+  }
+
+  /** Whether payloads sent on this stream use the compact value encoding.
+   *
+   * Latched per connection: once the capability exchange shows both ends
+   * support it, the switch is announced on the stream (compactValuesActive)
+   * and every later payload is compact. The codec calls this once per
+   * payload; after the first decision it is a single atomic load.
+   */
+  bool compactValuesSendEnabled();
+
+  /// Whether the remote announced the compact value encoding for the
+  /// payloads it sends on this stream. Latched like the send side.
+  bool compactValuesReceiveEnabled() const;
+
   /// Return (cacheUid, wasInserted)
   std::pair<unsigned int, bool> sendCacheSet(const MetaObject& mo);
 
@@ -102,6 +203,13 @@ public:
 
 
 protected:
+  /** Recompute the SharedCapability bitfield from the capability maps.
+   * To call after every change of either map (advertiseCapability* do it
+   * themselves; implementers updating _remoteCapabilityMap directly must
+   * call it once done, outside _contextMutex).
+   */
+  void recomputeSharedCapabilityFlags();
+
   qi::Atomic<int> _cacheNextId;
   // Protects all storage
   mutable boost::mutex  _contextMutex;
@@ -109,7 +217,18 @@ protected:
   CapabilityMap _remoteCapabilityMap; // remote capabilities we received
   CapabilityMap _localCapabilityMap; // memory of what we advertisedk
 
-  using SendMetaObjectCache = std::map<MetaObject, unsigned int>;
+  // Precomputed SharedCapability bits, see sharedCapabilityFlag().
+  qi::Atomic<unsigned int> _sharedCapabilityFlags;
+
+  // Compact value encoding latches, see compactValuesSendEnabled().
+  // Send side: 0 undecided, 1 active, 2 announcement in flight, -1 remote
+  // does not support it. Receive side: 0 not (yet) announced, 1 active.
+  qi::Atomic<int> _compactValuesSend;
+  mutable qi::Atomic<int> _compactValuesReceive;
+
+  // Content-addressed: one entry per distinct interface shape, however many
+  // objects share it, without keeping a MetaObject copy per shape.
+  using SendMetaObjectCache = std::map<ka::sha1_digest_t, unsigned int>;
   using ReceiveMetaObjectCache = std::map<unsigned int, MetaObject>;
   SendMetaObjectCache _sendMetaObjectCache;
   ReceiveMetaObjectCache _receiveMetaObjectCache;
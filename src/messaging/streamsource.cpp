@@ -0,0 +1,64 @@
+/*
+**  Copyright (C) 2018 Aldebaran Robotics
+**  See COPYING for the license
+*/
+
+#include <qi/messaging/streamsource.hpp>
+#include <qi/type/dynamicobjectbuilder.hpp>
+
+namespace qi
+{
+  AnyObject makeStreamSource(boost::function<Future<StreamChunk>()> producer)
+  {
+    DynamicObjectBuilder ob;
+    ob.advertiseMethod("read", producer);
+    return ob.object();
+  }
+
+  StreamReader::StreamReader(AnyObject source)
+    : _source(std::move(source))
+  {
+  }
+
+  Future<StreamChunk> StreamReader::read()
+  {
+    return _source.async<StreamChunk>("read");
+  }
+
+  namespace
+  {
+    void pumpChunk(AnyObject source, boost::function<void(const Buffer&)> consumer,
+                   Promise<void> done)
+    {
+      source.async<StreamChunk>("read").connect(
+          [source, consumer, done](Future<StreamChunk> chunk) mutable {
+            if (chunk.isCanceled())
+            {
+              done.setError("Stream read canceled");
+              return;
+            }
+            if (chunk.hasError())
+            {
+              done.setError(chunk.error());
+              return;
+            }
+            StreamChunk value = chunk.value();
+            if (value.data.size() != 0)
+              consumer(value.data);
+            if (value.last)
+            {
+              done.setValue(0);
+              return;
+            }
+            pumpChunk(source, consumer, done);
+          });
+    }
+  }
+
+  Future<void> StreamReader::readAll(boost::function<void(const Buffer&)> consumer)
+  {
+    Promise<void> done;
+    pumpChunk(_source, consumer, done);
+    return done.future();
+  }
+}
@@ -1,7 +1,10 @@
+#include <map>
 #include <string>
 #include <boost/asio/ip/tcp.hpp>
 #include <boost/lexical_cast.hpp>
 #include <boost/optional.hpp>
+#include <boost/thread/mutex.hpp>
+#include <openssl/ssl.h>
 #include <qi/os.hpp>
 #include <qi/log.hpp>
 #include <qi/messaging/sock/networkasio.hpp>
@@ -129,6 +132,18 @@ namespace qi {
     return l.empty() ? defaultValue : boost::lexical_cast<size_t>(l);
   }
 
+  size_t getCompressionThresholdFromEnv(size_t defaultValue)
+  {
+    std::string l = os::getenv("QI_COMPRESSION_THRESHOLD");
+    return l.empty() ? defaultValue : boost::lexical_cast<size_t>(l);
+  }
+
+  size_t getFragmentSizeFromEnv(size_t defaultValue)
+  {
+    std::string l = os::getenv("QI_FRAGMENT_SIZE");
+    return l.empty() ? defaultValue : boost::lexical_cast<size_t>(l);
+  }
+
 } // namespace qi
 
 namespace qi { namespace sock {
@@ -157,4 +172,114 @@ namespace qi { namespace sock {
   #endif
   }
 
+  namespace
+  {
+    // TLS client session cache.
+    //
+    // OpenSSL only resumes a session if it is explicitly installed on the SSL
+    // handle before the handshake starts, so we keep the last session
+    // negotiated with each endpoint and install it on the next connection to
+    // that endpoint. Sessions are captured through the context new-session
+    // callback, which also works for ticket-based (stateless) resumption.
+    struct ClientSessionCache
+    {
+      boost::mutex mutex;
+      std::map<std::string, SSL_SESSION*> sessions; // endpoint -> last session
+
+      // Takes ownership of the reference handed over by OpenSSL.
+      void put(const std::string& endpoint, SSL_SESSION* session)
+      {
+        boost::mutex::scoped_lock lock(mutex);
+        const auto res = sessions.insert(std::make_pair(endpoint, session));
+        if (!res.second)
+        {
+          SSL_SESSION_free(res.first->second);
+          res.first->second = session;
+        }
+      }
+
+      // Installs the session cached for this endpoint, if any, on the given
+      // handle. SSL_set_session takes its own reference, so the cached one
+      // stays valid. An expired session merely falls back to a full
+      // handshake: no staleness check is needed here.
+      void installTo(SSL* sslHandle, const std::string& endpoint)
+      {
+        boost::mutex::scoped_lock lock(mutex);
+        const auto it = sessions.find(endpoint);
+        if (it != sessions.end())
+          SSL_set_session(sslHandle, it->second);
+      }
+    };
+
+    ClientSessionCache& clientSessionCache()
+    {
+      static ClientSessionCache cache;
+      return cache;
+    }
+
+    // Ex-data slot carrying the endpoint a client SSL handle is connecting
+    // to, so that the new-session callback knows under which key to cache
+    // the negotiated session. The free callback runs at SSL_free time.
+    int clientSessionEndpointIndex()
+    {
+      static const int index = SSL_get_ex_new_index(
+        0, nullptr, nullptr, nullptr,
+        [](void*, void* ptr, CRYPTO_EX_DATA*, int, long, void*) {
+          delete static_cast<std::string*>(ptr);
+        });
+      return index;
+    }
+
+    int onClientSessionNegotiated(SSL* sslHandle, SSL_SESSION* session)
+    {
+      const auto endpoint = static_cast<std::string*>(
+        SSL_get_ex_data(sslHandle, clientSessionEndpointIndex()));
+      if (!endpoint)
+        return 0; // not one of our tagged sockets: let OpenSSL keep the reference
+      clientSessionCache().put(*endpoint, session);
+      return 1; // we took ownership of the reference
+    }
+
+    // Applies the cipher preferences given by QI_SSL_CIPHERS (an OpenSSL
+    // cipher list string), if set. Lets embedded platforms prefer cheap
+    // symmetric ciphers fleet-wide without a rebuild.
+    void applyCipherPreferences(SSL_CTX* nativeContext)
+    {
+      const std::string ciphers = os::getenv("QI_SSL_CIPHERS");
+      if (ciphers.empty())
+        return;
+      if (SSL_CTX_set_cipher_list(nativeContext, ciphers.c_str()) != 1)
+        qiLogWarning() << "QI_SSL_CIPHERS: no usable cipher in '" << ciphers << "'";
+    }
+  } // namespace
+
+  void NetworkAsio::setClientSslContextOptions(ssl_context_type& context)
+  {
+    SSL_CTX* nativeContext = context.native_handle();
+    // The internal cache is useless on the client side (it is indexed for
+    // server-side lookup); we only need the new-session callback to fire so
+    // that sessions and tickets are captured in our own endpoint-keyed cache.
+    SSL_CTX_set_session_cache_mode(
+      nativeContext, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+    SSL_CTX_sess_set_new_cb(nativeContext, onClientSessionNegotiated);
+    applyCipherPreferences(nativeContext);
+  }
+
+  void NetworkAsio::setServerSslContextOptions(ssl_context_type& context)
+  {
+    SSL_CTX* nativeContext = context.native_handle();
+    // Default OpenSSL behavior, made explicit: the server-side session cache
+    // and session tickets are what allow roaming clients to reconnect with
+    // an abbreviated handshake.
+    SSL_CTX_set_session_cache_mode(nativeContext, SSL_SESS_CACHE_SERVER);
+    applyCipherPreferences(nativeContext);
+  }
+
+  void NetworkAsio::clientSessionPrepare(ssl_socket_type::native_handle_type sslHandle,
+                                         const std::string& endpoint)
+  {
+    SSL_set_ex_data(sslHandle, clientSessionEndpointIndex(), new std::string(endpoint));
+    clientSessionCache().installTo(sslHandle, endpoint);
+  }
+
 }} // namespace qi::sock
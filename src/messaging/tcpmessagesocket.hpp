@@ -5,6 +5,8 @@
 
 #include <string>
 #include <functional>
+#include <list>
+#include <map>
 #include <memory>
 #include <mutex>
 #include <boost/make_shared.hpp>
@@ -18,6 +20,7 @@
 #include <ka/macroregular.hpp>
 #include "messagedispatcher.hpp"
 #include "messagesocket.hpp"
+#include "../trace_p.hpp"
 #include <qi/messaging/sock/disconnectedstate.hpp>
 #include <qi/messaging/sock/disconnectingstate.hpp>
 #include <qi/messaging/sock/connectingstate.hpp>
@@ -238,6 +241,16 @@ namespace qi {
       }
       return {};
     }
+
+    size_t sendQueueBytes() const override
+    {
+      boost::recursive_mutex::scoped_lock lock(_stateMutex);
+      if (getStatus() == Status::Connected)
+      {
+        return asConnected(_state).sendQueueBytes();
+      }
+      return 0;
+    }
     bool ensureReading() override;
   private:
     /// Handler called when we transition outside the connected state.
@@ -286,6 +299,12 @@ namespace qi {
     bool handleCapabilityMessage(const Message& msg);
     bool handleNormalMessage(Message& msg);
     bool handleMessage(Message& msg);
+    void sendNextFragment(const boost::shared_ptr<std::list<Message>>& fragments);
+
+    /// Partially received fragmented payloads, by message id.
+    /// Only touched from the read loop, which handles messages one at a
+    /// time, so no synchronization is needed.
+    std::map<unsigned int, Buffer> _reassembly;
 
     ConnectedState& asConnected(State& s)
     {
@@ -331,11 +350,15 @@ namespace qi {
       sock::setSocketOptions<N>(socket, getTcpPingTimeout(Seconds{sock::defaultTimeoutInSeconds}));
       _state = ConnectingState{io, ssl, socket, Handshake::server};
     }
+    detail::registerSocket(this);
   }
 
   template<typename N, typename S>
   TcpMessageSocket<N, S>::~TcpMessageSocket()
   {
+    // First thing: memory-accounting snapshots must not reach a socket whose
+    // derived part is being torn down.
+    detail::unregisterSocket(this);
     // We are in the destructor, so no concurrency problem.
     if (getStatus() == Status::Connected)
     {
@@ -346,6 +369,18 @@ namespace qi {
 
   size_t getMaxPayloadFromEnv(size_t defaultValue = 50000000);
 
+  /// Minimum payload size, in bytes, worth LZ4-compressing when the
+  /// MessageCompression capability is shared with the remote end.
+  /// Overridable with QI_COMPRESSION_THRESHOLD.
+  size_t getCompressionThresholdFromEnv(size_t defaultValue = 2048);
+
+  /// Fragment size, in bytes, used when the MessageFragmentation capability
+  /// is shared with the remote end; payloads above it are split. The default
+  /// keeps the per-frame transmission time - the maximum delay a fragmented
+  /// transfer can add to a small message - around a millisecond on our
+  /// typical links. Overridable with QI_FRAGMENT_SIZE.
+  size_t getFragmentSizeFromEnv(size_t defaultValue = 65536);
+
   /// Start receiving messages. Also allows to send messages.
   ///
   /// The returned value indicates if the operation succeeded.
@@ -397,6 +432,7 @@ namespace qi {
   FutureSync<void> TcpMessageSocket<N, S>::connect(const Url& url)
   {
     static const bool disableIpV6 = os::getenv("QIMESSAGING_ENABLE_IPV6").empty();
+    const auto connectStart = SteadyClock::now();
     Promise<void> connectedPromise;
     boost::recursive_mutex::scoped_lock lock(_stateMutex);
 
@@ -409,9 +445,15 @@ namespace qi {
     using Side = sock::HandshakeSide<S>;
     _state =
         ConnectingState{ _ioService, url, _ssl,
-                         [&] {
-                           return sock::makeSocketWithContextPtr<N>(
-                                 _ioService, sock::makeSslContextPtr<N>(Method::sslv23));
+                         [=] {
+                           // The context is shared between all client sockets
+                           // so that TLS sessions can be resumed from one
+                           // connection to the next (see clientSslContextPtr).
+                           auto socket = sock::makeSocketWithContextPtr<N>(
+                                 _ioService, sock::clientSslContextPtr<N>());
+                           if (*_ssl)
+                             N::prepareClientSession(*socket, url.str());
+                           return socket;
                          },
                          !disableIpV6, Side::client,
                          getTcpPingTimeout(Seconds{ sock::defaultTimeoutInSeconds }) };
@@ -440,6 +482,8 @@ namespace qi {
         }
         // Connecting was successful, so we enter the connected state (to be able
         // send and receive messages).
+        setHandshakeDuration(
+            boost::chrono::duration_cast<MicroSeconds>(SteadyClock::now() - connectStart));
         static const auto maxPayload = getMaxPayloadFromEnv();
         _state = ConnectedState(res.socket, _ssl, maxPayload, sock::HandleMessage<N, S>{self});
         auto& connected = asConnected(_state);
@@ -498,6 +542,9 @@ namespace qi {
         wasConnected = (getStatus() == Status::Connected);
         QI_LOG_DEBUG_SOCKET(socket.get()) << "Entering Disconnecting state";
         _state = disconnect;
+        // The read loop is over: incomplete fragmented payloads will never
+        // complete, even if the socket is connected again.
+        _reassembly.clear();
       }
       disconnect();
       auto self = shared_from_this();
@@ -542,8 +589,11 @@ namespace qi {
       cmRef = msg.value(typeOf<CapabilityMap>()->signature(), shared_from_this());
       CapabilityMap cm = cmRef.to<CapabilityMap>();
       cmRef.destroy();
-      boost::mutex::scoped_lock lock(_contextMutex);
-      _remoteCapabilityMap.insert(cm.begin(), cm.end());
+      {
+        boost::mutex::scoped_lock lock(_contextMutex);
+        _remoteCapabilityMap.insert(cm.begin(), cm.end());
+      }
+      recomputeSharedCapabilityFlags();
     }
     catch (const std::runtime_error& e)
     {
@@ -566,6 +616,45 @@ namespace qi {
   template<typename N, typename S>
   bool TcpMessageSocket<N, S>::handleMessage(Message& msg)
   {
+    static const auto maxPayload = getMaxPayloadFromEnv();
+    // Counted before reassembly and decompression, so that the counters
+    // reflect what actually travelled on the wire.
+    accountReceived(sizeof(Message::Header) + msg.buffer().size());
+    recordMessage(msg, false);
+    if (msg.flags() & Message::TypeFlag_MoreFragments)
+    {
+      // Intermediate fragment: accumulate and wait for the rest.
+      Buffer& pending = _reassembly[msg.id()];
+      if (pending.size() + msg.buffer().size() > maxPayload)
+      {
+        QI_LOG_ERROR_SOCKET(this) << "Fragmented message " << msg.id()
+                                  << " exceeds the maximum payload size.";
+        return false;
+      }
+      pending.write(msg.buffer().data(), msg.buffer().size());
+      return true;
+    }
+    const auto itPending = _reassembly.find(msg.id());
+    if (itPending != _reassembly.end())
+    {
+      // Last fragment: hand the reassembled payload to the usual handling.
+      Buffer whole = std::move(itPending->second);
+      _reassembly.erase(itPending);
+      if (whole.size() + msg.buffer().size() > maxPayload)
+      {
+        QI_LOG_ERROR_SOCKET(this) << "Fragmented message " << msg.id()
+                                  << " exceeds the maximum payload size.";
+        return false;
+      }
+      whole.write(msg.buffer().data(), msg.buffer().size());
+      msg.setBuffer(std::move(whole));
+    }
+    if (!msg.decompressPayload())
+    {
+      // The stream is corrupt: stop reading, which disconnects the socket.
+      QI_LOG_ERROR_SOCKET(this) << "Dropping corrupt compressed message " << msg.id();
+      return false;
+    }
     bool success = false;
     if (mustTreatAsServerAuthentication(msg) || msg.type() == Message::Type_Capability)
     {
@@ -588,18 +677,111 @@ namespace qi {
   template<typename N, typename S>
   bool TcpMessageSocket<N, S>::send(Message msg)
   {
+    static const auto compressionThreshold = getCompressionThresholdFromEnv();
+    static const auto fragmentSize = getFragmentSizeFromEnv();
     boost::recursive_mutex::scoped_lock lock(_stateMutex);
     if (getStatus() != Status::Connected)
     {
       QI_LOG_DEBUG_SOCKET(this) << "Socket must be connected to send().";
       return false;
     }
+    // Cancellations are latency-critical by nature: the later they go out,
+    // the more wasted work on the remote end.
+    if (msg.type() == Message::Type_Cancel)
+      msg.addFlags(Message::TypeFlag_HighPriority);
+    const size_t queuedBytes = asConnected(_state).sendQueueBytes();
+    if (!acceptForSend(msg, queuedBytes))
+    {
+      QI_LOG_DEBUG_SOCKET(this) << "send() rejected a message of type " << msg.type()
+        << " by the send-queue policy.";
+      return false;
+    }
+    if (msg.buffer().totalSize() >= compressionThreshold &&
+        !(msg.flags() & Message::TypeFlag_Compressed) &&
+        sharedCapabilityFlag(SharedCapability_MessageCompression))
+    {
+      // Best effort: an incompressible payload is simply sent as-is.
+      msg.compressPayload();
+    }
+    if (msg.buffer().totalSize() > fragmentSize &&
+        sharedCapabilityFlag(SharedCapability_MessageFragmentation))
+    {
+      sendNextFragment(boost::make_shared<std::list<Message>>(msg.splitPayload(fragmentSize)));
+      return true;
+    }
+    // Last, once the flags and the payload size are final. Fragments keep
+    // the full header: they are large by definition, so the saving would be
+    // noise there.
+    if (sharedCapabilityFlag(SharedCapability_CompactHeader))
+      msg.enableCompactHeader();
+    const size_t wireBytes =
+        (msg.compactOnWire() ? Message::CompactHeader::size : sizeof(Message::Header))
+        + msg.buffer().totalSize();
+    accountSent(wireBytes, queuedBytes + wireBytes);
+    recordMessage(msg, true);
+    QI_TRACE4(message_send, msg.id(), msg.type(), msg.service(), wireBytes);
     // NOTE: Should we specify an `onSent` callback and stop sending if an error
     // occurred?
+    if (sendHighWatermark() != 0)
+    { // Watch the queue draining so that `writable` can be emitted.
+      auto self = shared_from_this();
+      asConnected(_state).send(std::move(msg), _ssl,
+        [=](const sock::ErrorCode<N>&, const std::list<Message>::const_iterator&) {
+          self->updateSendDrain(self->sendQueueBytes());
+          return true;
+        });
+      return true;
+    }
     asConnected(_state).send(std::move(msg), _ssl);
     return true;
   }
 
+  /// Send the front fragment and enqueue the following one only once it has
+  /// been written: messages sent in the meantime slip between fragments
+  /// instead of waiting behind the whole transfer, which bounds the latency
+  /// they can suffer to one fragment's transmission time.
+  ///
+  /// Precondition: _stateMutex is held, the socket is in the connected state
+  ///   and `fragments` is not empty.
+  template<typename N, typename S>
+  void TcpMessageSocket<N, S>::sendNextFragment(const boost::shared_ptr<std::list<Message>>& fragments)
+  {
+    Message fragment = std::move(fragments->front());
+    fragments->pop_front();
+    const size_t wireBytes = sizeof(Message::Header) + fragment.buffer().totalSize();
+    accountSent(wireBytes, asConnected(_state).sendQueueBytes() + wireBytes);
+    recordMessage(fragment, true);
+    QI_TRACE4(message_send, fragment.id(), fragment.type(), fragment.service(), wireBytes);
+    if (fragments->empty())
+    {
+      if (sendHighWatermark() != 0)
+      {
+        auto self = shared_from_this();
+        asConnected(_state).send(std::move(fragment), _ssl,
+          [=](const sock::ErrorCode<N>&, const std::list<Message>::const_iterator&) {
+            self->updateSendDrain(self->sendQueueBytes());
+            return true;
+          });
+      }
+      else
+        asConnected(_state).send(std::move(fragment), _ssl);
+      return;
+    }
+    auto self = shared_from_this();
+    asConnected(_state).send(std::move(fragment), _ssl,
+      [=](const sock::ErrorCode<N>& erc, const std::list<Message>::const_iterator&) {
+        self->updateSendDrain(self->sendQueueBytes());
+        if (!erc)
+        {
+          boost::recursive_mutex::scoped_lock lock(self->_stateMutex);
+          if (self->getStatus() == Status::Connected)
+            self->sendNextFragment(fragments);
+          // Otherwise the remaining fragments are dropped with the connection.
+        }
+        return true; // Errors are handled by the normal send-loop path.
+      });
+  }
+
   /// Network N,
   /// With NetSslSocket S:
   ///   S is compatible with N
@@ -44,13 +44,14 @@ namespace qi
   qi::Future<void> TransportServer::listen(const qi::Url &url, qi::EventLoop* ctx)
   {
     TransportServerImplPtr impl;
-    if (url.protocol() == "tcp" || url.protocol() == "tcps")
+    if (isKnownTransportProtocol(url.protocol()))
     {
       impl = TransportServerAsioPrivate::make(this, ctx);
     }
     else
     {
-      const char* s = "Unrecognized protocol to create the TransportServer.";
+      const std::string s = "Unrecognized protocol '" + url.protocol() +
+        "' to create the TransportServer.";
       qiLogError() << s;
       return qi::makeFutureError<void>(s);
     }
@@ -18,9 +18,11 @@
 #include "messagesocket.hpp"
 #include "tcpmessagesocket.hpp"
 #include <qi/messaging/sock/traits.hpp>
+#include <qi/messaging/sock/option.hpp>
 #include <qi/messaging/sock/sslcontextptr.hpp>
 
 #include <qi/eventloop.hpp>
+#include <qi/os.hpp>
 
 #include "transportserverasio_p.hpp"
 
@@ -31,6 +33,17 @@ namespace qi
   const int ifsMonitoringTimeout = 5 * 1000 * 1000; // in usec
   const int64_t TransportServerAsioPrivate::AcceptDownRetryTimerUs = 60 * 1000 * 1000; // 60 seconds in usec
 
+  // Total number of acceptors sharing the listen port (the main one
+  // included). Values above 1 need SO_REUSEPORT: the kernel then
+  // load-balances incoming connections among the acceptors, which bounds
+  // accept latency during reconnect storms (e.g. a whole fleet coming back
+  // after a directory restart).
+  static int acceptParallelCount()
+  {
+    static const int count = os::getEnvParam<int>("QIMESSAGING_ACCEPT_PARALLEL", 1);
+    return count;
+  }
+
   void _onAccept(TransportServerImplPtr p,
                  const boost::system::error_code& erc,
                  sock::SocketWithContextPtr<sock::NetworkAsio> s
@@ -86,6 +99,8 @@ namespace qi
     else
     {
         auto socket = boost::make_shared<qi::TcpMessageSocket<>>(*asIoServicePtr(context), _ssl, s);
+        // Options carried by the listen URL apply to every accepted socket.
+        sock::applyUrlSocketOptions<sock::NetworkAsio>(s, sock::urlSocketOptions(_listenUrl));
         qiLogDebug() << "New socket accepted: " << socket.get();
 
         self->newConnection(std::pair<MessageSocketPtr, Url>{
@@ -103,6 +118,11 @@ namespace qi
   void TransportServerAsioPrivate::close() {
     qiLogDebug() << this << " close";
     boost::mutex::scoped_lock l(_acceptCloseMutex);
+    if (_hostAddrsObserver != -1)
+    {
+      qi::os::removeHostIPAddrsObserver(_hostAddrsObserver);
+      _hostAddrsObserver = -1;
+    }
     try
     {
       _asyncEndpoints->cancel();
@@ -115,6 +135,12 @@ namespace qi
     _live = false;
     if (_acceptor)
       _acceptor->close();
+    for (auto& extra: _extraAcceptors)
+    {
+      boost::system::error_code erc;
+      if (extra->acceptor)
+        extra->acceptor->close(erc);
+    }
   }
 
   /*
@@ -127,34 +153,32 @@ namespace qi
     ts->updateEndpoints();
   }
 
+  void _checkEndpoints(TransportServerImplPtr p)
+  {
+    boost::shared_ptr<TransportServerAsioPrivate> ts = boost::static_pointer_cast<TransportServerAsioPrivate>(p);
+    ts->checkEndpoints();
+  }
+
   /*
    * This function is used to detect and update endpoints when the transport
-   * server is listening on 0.0.0.0.
+   * server is listening on 0.0.0.0. It does not reschedule anything, so the
+   * address-change observer can trigger it without multiplying the periodic
+   * chain maintained by updateEndpoints().
    */
-  void TransportServerAsioPrivate::updateEndpoints()
+  void TransportServerAsioPrivate::checkEndpoints()
   {
     if (!_live)
     {
       return;
     }
 
-    // TODO: implement OS networking notifications
-
     qiLogDebug() << "Checking endpoints...";
     std::vector<qi::Url> currentEndpoints;
 
-    auto updateEP = [&]
-    {
-      return context->asyncDelay(boost::bind(_updateEndpoints, shared_from_this()),
-                                 qi::MicroSeconds(ifsMonitoringTimeout));
-    };
-
     std::map<std::string, std::vector<std::string> > ifsMap = qi::os::hostIPAddrs();
     if (ifsMap.empty())
     {
-      const char* s = "Cannot get host addresses";
-      qiLogWarning() << s;
-      *_asyncEndpoints = updateEP();
+      qiLogWarning() << "Cannot get host addresses";
       return;
     }
 
@@ -190,8 +214,18 @@ namespace qi
       }
 
     }
+  }
+
+  void TransportServerAsioPrivate::updateEndpoints()
+  {
+    if (!_live)
+    {
+      return;
+    }
 
-    *_asyncEndpoints = updateEP();
+    checkEndpoints();
+    *_asyncEndpoints = context->asyncDelay(boost::bind(_updateEndpoints, shared_from_this()),
+                                           qi::MicroSeconds(ifsMonitoringTimeout));
   }
 
   qi::Future<void> TransportServerAsioPrivate::listen(const qi::Url& url)
@@ -235,6 +269,30 @@ namespace qi
     fcntl(_acceptor->native(), F_SETFD, FD_CLOEXEC);
 #endif
     _acceptor->set_option(option);
+#ifdef SO_REUSEPORT
+    if (acceptParallelCount() > 1)
+    {
+      // Every acceptor (this one included) must set SO_REUSEPORT before
+      // binding for the kernel to share the port among them.
+      boost::asio::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT> reusePort(true);
+      _acceptor->set_option(reusePort);
+    }
+#endif
+#ifdef TCP_FASTOPEN
+    if (sock::tcpFastOpenEnabledFromEnv())
+    {
+      // Let SYNs from clients holding a fast-open cookie deliver their data
+      // before the handshake completes, so a warm reconnect gets its first
+      // message in a single round trip. The value caps pending fast-open
+      // connections, as the backlog does for regular ones.
+      boost::asio::detail::socket_option::integer<IPPROTO_TCP, TCP_FASTOPEN> fastOpen(128);
+      boost::system::error_code fastOpenErc;
+      _acceptor->set_option(fastOpen, fastOpenErc);
+      if (fastOpenErc)
+        qiLogVerbose() << "Could not enable TCP Fast Open on " << ep
+                       << ": " << fastOpenErc.message();
+    }
+#endif
     try
     {
       _acceptor->bind(ep);
@@ -269,6 +327,18 @@ namespace qi
     }
     else
     {
+      // Refresh as soon as the OS reports an address change, on top of the
+      // periodic check (platforms without an address watcher never fire the
+      // observer and rely on the periodic check alone).
+      if (_hostAddrsObserver == -1)
+      {
+        const boost::weak_ptr<TransportServerAsioPrivate> weakThis = shared_from_this();
+        _hostAddrsObserver = qi::os::addHostIPAddrsObserver([weakThis] {
+          boost::shared_ptr<TransportServerAsioPrivate> that = weakThis.lock();
+          if (that && that->_live)
+            that->context->async(boost::bind(_checkEndpoints, that));
+        });
+      }
       updateEndpoints();
     }
 
@@ -294,6 +364,10 @@ namespace qi
       _sslContext->set_options(
         boost::asio::ssl::context::default_workarounds
         | boost::asio::ssl::context::no_sslv2);
+      // Session cache and tickets: reconnecting clients (e.g. after an
+      // access-point roam) resume with an abbreviated handshake instead of
+      // paying the asymmetric crypto of a full one on every reconnection.
+      sock::NetworkAsio::setServerSslContextOptions(*_sslContext);
       _sslContext->use_certificate_chain_file(self->_identityCertificate.c_str());
       _sslContext->use_private_key_file(self->_identityKey.c_str(), boost::asio::ssl::context::pem);
     }
@@ -301,10 +375,120 @@ namespace qi
     _s = sock::makeSocketWithContextPtr<sock::NetworkAsio>(_acceptor->get_io_service(), _sslContext);
     _acceptor->async_accept(_s->lowest_layer(),
       boost::bind(_onAccept, shared_from_this(), _1, _s));
+    if (acceptParallelCount() > 1)
+    {
+#ifdef SO_REUSEPORT
+      setupExtraAcceptors(ip::tcp::endpoint(ep.address(), _port));
+#else
+      qiLogWarning() << "QIMESSAGING_ACCEPT_PARALLEL > 1 requires SO_REUSEPORT,"
+                     << " which is not available on this platform.";
+#endif
+    }
     _connectionPromise.setValue(0);
     return _connectionPromise.future();
   }
 
+  void TransportServerAsioPrivate::setupExtraAcceptors(const boost::asio::ip::tcp::endpoint& endpoint)
+  {
+#ifdef SO_REUSEPORT
+    // listen() may run again when the main acceptor restarts after a fatal
+    // error: the extra acceptors are still up, do not duplicate them.
+    if (!_extraAcceptors.empty())
+      return;
+    const int extraCount = acceptParallelCount() - 1; // the main acceptor counts for one
+    for (int i = 0; i < extraCount; ++i)
+    {
+      auto extra = boost::make_shared<ExtraAcceptor>();
+      extra->eventLoop.reset(new EventLoop("tcpserver-accept", 1, false));
+      auto& io = *static_cast<boost::asio::io_service*>(extra->eventLoop->nativeHandle());
+      extra->acceptor.reset(new boost::asio::ip::tcp::acceptor(io));
+      boost::system::error_code erc;
+      extra->acceptor->open(endpoint.protocol(), erc);
+      if (!erc)
+      {
+#ifndef _WIN32
+        extra->acceptor->set_option(boost::asio::socket_base::reuse_address(true), erc);
+#endif
+        boost::asio::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT> reusePort(true);
+        if (!erc)
+          extra->acceptor->set_option(reusePort, erc);
+#ifdef TCP_FASTOPEN
+        if (!erc && sock::tcpFastOpenEnabledFromEnv())
+        {
+          // Same fast-open setting as the main acceptor; failure is benign.
+          boost::asio::detail::socket_option::integer<IPPROTO_TCP, TCP_FASTOPEN> fastOpen(128);
+          boost::system::error_code fastOpenErc;
+          extra->acceptor->set_option(fastOpen, fastOpenErc);
+        }
+#endif
+        if (!erc)
+          extra->acceptor->bind(endpoint, erc);
+        if (!erc)
+          extra->acceptor->listen(boost::asio::socket_base::max_connections, erc);
+      }
+      if (erc)
+      { // Degraded but functional: fewer acceptors than asked for.
+        qiLogWarning() << "Could not set up extra acceptor #" << i + 1 << " on " << endpoint
+                       << ": " << erc.message();
+        continue;
+      }
+      _extraAcceptors.push_back(extra);
+      startExtraAccept(extra);
+      qiLogVerbose() << "Extra acceptor #" << i + 1 << " sharing port " << endpoint.port();
+    }
+#else
+    (void)endpoint;
+#endif
+  }
+
+  void TransportServerAsioPrivate::startExtraAccept(ExtraAcceptorPtr extra)
+  {
+    // The accepted socket is created on the server context, not on the
+    // acceptor's private loop: asio allows accepting into a socket bound to
+    // another io_service, and this way the socket I/O keeps running after
+    // the extra acceptor (and its loop) are gone. Sharing _sslContext here
+    // is fine, OpenSSL allows concurrent SSL creation on one context.
+    auto s = sock::makeSocketWithContextPtr<sock::NetworkAsio>(*asIoServicePtr(context), _sslContext);
+    auto self = shared_from_this();
+    extra->acceptor->async_accept(s->lowest_layer(),
+      [self, extra, s](const boost::system::error_code& erc) {
+        self->onExtraAccept(extra, erc, s);
+      });
+  }
+
+  void TransportServerAsioPrivate::onExtraAccept(ExtraAcceptorPtr extra,
+                                                 const boost::system::error_code& erc,
+                                                 sock::SocketWithContextPtr<sock::NetworkAsio> s)
+  {
+    qiLogDebug() << this << " onExtraAccept";
+    boost::mutex::scoped_lock lock(_acceptCloseMutex);
+    if (!_live)
+      return;
+    if (erc)
+    {
+      qiLogDebug() << "extra acceptor: accept error " << erc.message();
+      self->acceptError(erc.value());
+      if (isFatalAcceptError(erc.value()))
+      { // The main acceptor has retry logic; an extra one simply stops,
+        // leaving accept capacity degraded but the server functional.
+        qiLogWarning() << "extra acceptor stopped on fatal accept error: " << erc.value();
+        return;
+      }
+    }
+    else
+    {
+      auto socket = boost::make_shared<qi::TcpMessageSocket<>>(*asIoServicePtr(context), _ssl, s);
+      sock::applyUrlSocketOptions<sock::NetworkAsio>(s, sock::urlSocketOptions(_listenUrl));
+      qiLogDebug() << "New socket accepted (extra acceptor): " << socket.get();
+      self->newConnection(std::pair<MessageSocketPtr, Url>{
+        socket, sock::remoteEndpoint(*s, _ssl)});
+      if (socket.unique()) {
+          qiLogError() << "bug: socket not stored by the newConnection handler (usecount:" << socket.use_count() << ")";
+      }
+    }
+    startExtraAccept(extra);
+  }
+
   bool TransportServerAsioPrivate::isFatalAcceptError(int errorCode)
   {
     using namespace boost::system::errc;
@@ -11,6 +11,8 @@
 # include <boost/asio/ssl.hpp>
 #include <boost/thread/synchronized_value.hpp>
 #include <atomic>
+#include <memory>
+#include <vector>
 
 # include <qi/api.hpp>
 # include <qi/url.hpp>
@@ -37,6 +39,9 @@ namespace qi
     virtual qi::Future<void> listen(const qi::Url& listenUrl);
     virtual void close();
     void updateEndpoints();
+    /// One-shot endpoint refresh, without rescheduling the periodic check.
+    /// Triggered by the qi::os host-address observer.
+    void checkEndpoints();
     static bool isFatalAcceptError(int errorCode);
     TransportServer* _self;
     boost::asio::ip::tcp::acceptor* _acceptor;
@@ -50,6 +55,8 @@ namespace qi
     unsigned short _port;
     boost::synchronized_value<qi::Future<void>> _asyncEndpoints;
     Url _listenUrl;
+    // Observer id from qi::os::addHostIPAddrsObserver, -1 when unset.
+    int _hostAddrsObserver = -1;
 
     // The server must avoid being closed while accepting a connection.
     // Typically, the TransportServer this class has a pointer to closes implementations
@@ -59,8 +66,25 @@ namespace qi
 
     static const int64_t AcceptDownRetryTimerUs;
 
+    /// Extra acceptor sharing the listen port with the main one through
+    /// SO_REUSEPORT, on its own event loop, so that accept processing does
+    /// not serialize on a single thread during reconnect storms (see
+    /// QIMESSAGING_ACCEPT_PARALLEL). Accepted sockets still do their I/O on
+    /// the server context, only the accept chain runs on the private loop.
+    struct ExtraAcceptor
+    {
+      std::unique_ptr<EventLoop> eventLoop;
+      std::unique_ptr<boost::asio::ip::tcp::acceptor> acceptor;
+    };
+    using ExtraAcceptorPtr = boost::shared_ptr<ExtraAcceptor>;
+    std::vector<ExtraAcceptorPtr> _extraAcceptors;
+
   private:
     void restartAcceptor();
+    void setupExtraAcceptors(const boost::asio::ip::tcp::endpoint& endpoint);
+    void startExtraAccept(ExtraAcceptorPtr extra);
+    void onExtraAccept(ExtraAcceptorPtr extra, const boost::system::error_code& erc,
+                       sock::SocketWithContextPtr<sock::NetworkAsio> s);
   };
 }
 
@@ -8,8 +8,11 @@
 #include <boost/algorithm/string.hpp>
 #include <boost/range/algorithm/find_if.hpp>
 
+#include <qi/async.hpp>
+#include <qi/clock.hpp>
 #include <qi/log.hpp>
 #include <qi/numeric.hpp>
+#include <qi/os.hpp>
 
 #include "messagesocket.hpp"
 #include "transportsocketcache.hpp"
@@ -18,8 +21,139 @@ qiLogCategory("qimessaging.transportsocketcache");
 
 namespace qi
 {
+namespace
+{
+  // Keep-alive pooling: how long an idle socket (one whose last user called
+  // disconnect()) stays connected in the cache, waiting to be reused by a
+  // later socket() call to the same machine. 0 disables pooling and restores
+  // the disconnect-on-release behavior.
+  Seconds socketCacheIdleTimeout()
+  {
+    static const auto seconds =
+        os::getEnvParam<int64_t>("QIMESSAGING_SOCKET_CACHE_IDLE_TIMEOUT", 30);
+    return Seconds{seconds};
+  }
+
+  // Cap on the number of idle sockets held at the same time; sockets released
+  // beyond that are disconnected immediately.
+  size_t socketCacheMaxIdle()
+  {
+    static const auto count =
+        os::getEnvParam<size_t>("QIMESSAGING_SOCKET_CACHE_MAX_IDLE", 8);
+    return count;
+  }
+
+  // Endpoint scoring: head start granted to the endpoint with the best
+  // recorded connect time before the other candidates are probed. The slower
+  // routes are still attempted (and re-scored) when the delay elapses, so
+  // scores stay fresh without a dedicated probing loop. 0 restores the fully
+  // parallel race.
+  MilliSeconds endpointProbeDelay()
+  {
+    static const auto milliseconds =
+        os::getEnvParam<int64_t>("QIMESSAGING_ENDPOINT_PROBE_DELAY", 250);
+    return MilliSeconds{milliseconds};
+  }
+
+  // Cross-session socket sharing: when enabled, connected client sockets are
+  // pooled process-wide, keyed by endpoint, so that many sessions targeting
+  // the same remote host share one connection (and one TLS context) instead
+  // of one each. Reused sockets skip the authentication round trip: the
+  // session layer already short-circuits sockets that completed their
+  // capability exchange. That means every session of the process reaches the
+  // remote end under the credentials of the first one to connect, so leave
+  // sharing off in processes mixing authentication identities.
+  bool sharedSocketsEnabled()
+  {
+    static const bool enabled = os::getEnvParam<int64_t>("QI_SHARED_SOCKETS", 0) != 0;
+    return enabled;
+  }
+
+  std::string sharedSocketKey(const Url& url)
+  {
+    std::ostringstream key;
+    key << url.protocol() << "://" << url.host() << ":" << url.port();
+    return key.str();
+  }
+
+  /// Process-wide pool of connected client sockets, ref-counted: a shared
+  /// socket is only really disconnected once its last user lets go of it.
+  class SharedSocketRegistry
+  {
+  public:
+    static SharedSocketRegistry& instance()
+    {
+      // Leaked on purpose: caches may still release sockets during static
+      // destruction.
+      static SharedSocketRegistry* registry = new SharedSocketRegistry;
+      return *registry;
+    }
+
+    /// The pooled socket for this endpoint with its use count incremented,
+    /// or null when none is connected.
+    MessageSocketPtr acquire(const std::string& key)
+    {
+      boost::mutex::scoped_lock lock(_mutex);
+      const auto it = _entries.find(key);
+      if (it == _entries.end())
+        return MessageSocketPtr();
+      MessageSocketPtr socket = it->second.socket;
+      if (!socket || !socket->isConnected())
+      { // The socket died without a clean release: drop the stale entry.
+        _entries.erase(it);
+        return MessageSocketPtr();
+      }
+      ++it->second.useCount;
+      return socket;
+    }
+
+    /// Pool a freshly connected socket, unless a concurrent attempt already
+    /// pooled one for the same endpoint (the extra socket then stays private
+    /// to its cache).
+    void add(const std::string& key, const MessageSocketPtr& socket)
+    {
+      boost::mutex::scoped_lock lock(_mutex);
+      Entry& entry = _entries[key];
+      if (entry.socket == socket)
+        return; // Reacquired: the use count was already incremented.
+      if (entry.socket && entry.socket->isConnected())
+        return;
+      entry.socket = socket;
+      entry.useCount = 1;
+    }
+
+    /// Give up one reference on a pooled socket. Returns true when other
+    /// users remain and the socket must be left connected.
+    bool release(const MessageSocketPtr& socket)
+    {
+      boost::mutex::scoped_lock lock(_mutex);
+      for (auto it = _entries.begin(); it != _entries.end(); ++it)
+      {
+        if (it->second.socket != socket)
+          continue;
+        if (--it->second.useCount > 0)
+          return true;
+        _entries.erase(it);
+        return false;
+      }
+      return false; // Not pooled: the caller owns it alone.
+    }
+
+  private:
+    struct Entry
+    {
+      MessageSocketPtr socket;
+      unsigned int useCount = 0;
+    };
+
+    boost::mutex _mutex;
+    std::map<std::string, Entry> _entries;
+  };
+}
+
 TransportSocketCache::TransportSocketCache()
   : _dying(false)
+  , _idleSocketCount(0)
 {
 }
 
@@ -44,6 +178,7 @@ TransportSocketCache::~TransportSocketCache()
 void TransportSocketCache::init()
 {
   _dying = false;
+  _idleSocketCount = 0;
 }
 
 /// Container<DisconnectInfo> C
@@ -65,6 +200,7 @@ void TransportSocketCache::close()
     {
       boost::mutex::scoped_lock lock(_socketMutex);
       _dying = true;
+      _idleSocketCount = 0;
       std::swap(map, _connections);
       std::swap(pending, _allPendingConnections);
     }
@@ -79,7 +215,7 @@ void TransportSocketCache::close()
         // Disconnect any valid socket we were holding.
         if (endpoint)
         {
-          endpoint->disconnect();
+          releaseOrDisconnect(endpoint);
           endpoint->disconnected.disconnect(connectionAttempt.disconnectionTracking);
         }
         else
@@ -91,7 +227,7 @@ void TransportSocketCache::close()
     }
     for (auto& socket: pending)
     {
-      socket->disconnect();
+      releaseOrDisconnect(socket);
     }
   }
 
@@ -159,14 +295,24 @@ Future<MessageSocketPtr> TransportSocketCache::socket(const ServiceInfo& servInf
         if (uIt != vurls.end())
         {
           qiLogDebug() << "Found pending promise.";
-          return b->second->promise.future();
+          auto& attempt = *b->second;
+          if (attempt.idle)
+          { // The socket was parked for keep-alive: it is in use again.
+            attempt.idle = false;
+            ++attempt.idleGeneration; // invalidates the pending expiry
+            --_idleSocketCount;
+          }
+          return attempt.promise.future();
         }
       }
     }
     // Otherwise, we keep track of all those URLs and assign them the same promise in our map.
     // They will all track the same connection.
     couple->attemptCount = qi::numericConvert<int>(connectionCandidates.size());
+    sortEndpointCandidates(connectionCandidates);
     std::map<Url, ConnectionAttemptPtr>& urlMap = _connections[machineId];
+    bool first = true;
+    bool stagger = false;
     for (const auto& url: connectionCandidates)
     {
       if (!url.isValid())
@@ -176,19 +322,135 @@ Future<MessageSocketPtr> TransportSocketCache::socket(const ServiceInfo& servInf
         continue; // Do not try to connect on localhost when it is a remote!
 
       urlMap[url] = couple;
-      MessageSocketPtr socket = makeMessageSocket(url.protocol());
-      _allPendingConnections.push_back(socket);
-      Future<void> sockFuture = socket->connect(url);
-      qiLogDebug() << "Inserted [" << machineId << "][" << url.str() << "]";
-      sockFuture.then(std::bind(&TransportSocketCache::onSocketParallelConnectionAttempt, this,
-                                std::placeholders::_1, socket, url, servInfo));
+      if (first)
+      {
+        // Give the historically fastest endpoint a head start: probing the
+        // other candidates is only worth the traffic if it does not answer
+        // quickly, or to refresh their score. Without history, race them all.
+        stagger = endpointProbeDelay() != MilliSeconds::zero()
+                  && _endpointScores.count(url) != 0;
+        startConnectionAttempt(url, servInfo);
+        first = false;
+      }
+      else if (stagger)
+      {
+        asyncDelay(track([=] { startDelayedAttempt(url, servInfo); }, this),
+                   endpointProbeDelay());
+      }
+      else
+      {
+        startConnectionAttempt(url, servInfo);
+      }
     }
   }
   return couple->promise.future();
 }
 
+void TransportSocketCache::startConnectionAttempt(const Url& url, const ServiceInfo& info)
+{
+  if (sharedSocketsEnabled())
+  {
+    MessageSocketPtr shared = SharedSocketRegistry::instance().acquire(sharedSocketKey(url));
+    if (shared)
+    {
+      qiLogDebug() << "Reusing shared socket " << shared.get() << " for [" << info.machineId()
+                   << "][" << url.str() << "]";
+      _allPendingConnections.push_back(shared);
+      const auto connectStart = SteadyClock::now();
+      // Feed the regular attempt callback an already successful connection,
+      // so that the bookkeeping and the disconnection tracking are wired as
+      // for a socket we connected ourselves.
+      qi::async(track([=] {
+        onSocketParallelConnectionAttempt(futurize(), shared, url, info, connectStart);
+      }, this));
+      return;
+    }
+  }
+  MessageSocketPtr socket = makeMessageSocket(url.protocol());
+  if (_flightRecorder)
+    socket->setFlightRecorder(_flightRecorder);
+  _allPendingConnections.push_back(socket);
+  const auto connectStart = SteadyClock::now();
+  Future<void> sockFuture = socket->connect(url);
+  qiLogDebug() << "Inserted [" << info.machineId() << "][" << url.str() << "]";
+  sockFuture.then(std::bind(&TransportSocketCache::onSocketParallelConnectionAttempt, this,
+                            std::placeholders::_1, socket, url, info, connectStart));
+}
+
+void TransportSocketCache::startDelayedAttempt(const Url& url, const ServiceInfo& info)
+{
+  boost::mutex::scoped_lock lock(_socketMutex);
+  if (_dying)
+    return;
+  ConnectionMap::iterator machineIt = _connections.find(info.machineId());
+  if (machineIt == _connections.end())
+    return; // The attempt completed and was cleared: nothing left to probe.
+  std::map<Url, ConnectionAttemptPtr>::iterator urlIt = machineIt->second.find(url);
+  if (urlIt == machineIt->second.end())
+    return;
+  // Probe even when the preferred endpoint already answered: the connection
+  // attempt callback rejects the extra socket but records its connect time,
+  // which keeps the score of the slower routes up to date.
+  startConnectionAttempt(url, info);
+}
+
+void TransportSocketCache::updateEndpointScore(const Url& url, MicroSeconds connectTime)
+{
+  EndpointScore& score = _endpointScores[url];
+  if (score.sampleCount == 0)
+    score.averageConnectTime = connectTime;
+  else // Weighted average: old observations decay, so route changes show up.
+    score.averageConnectTime = (score.averageConnectTime * 3 + connectTime) / 4;
+  ++score.sampleCount;
+}
+
+void TransportSocketCache::sortEndpointCandidates(UrlVector& urls) const
+{
+  const auto scoreOf = [&](const Url& url) -> const EndpointScore* {
+    const auto it = _endpointScores.find(url);
+    return it != _endpointScores.end() ? &it->second : nullptr;
+  };
+  std::stable_sort(urls.begin(), urls.end(), [&](const Url& a, const Url& b) {
+    const EndpointScore* scoreA = scoreOf(a);
+    const EndpointScore* scoreB = scoreOf(b);
+    if (!scoreA || !scoreB)
+      return scoreA != nullptr; // Scored endpoints before unscored ones.
+    return scoreA->averageConnectTime < scoreB->averageConnectTime;
+  });
+}
+
+std::vector<MessageSocketPtr> TransportSocketCache::connectedSockets()
+{
+  std::vector<MessageSocketPtr> sockets;
+  boost::mutex::scoped_lock lock(_socketMutex);
+  for (const auto& machine: _connections)
+  {
+    for (const auto& connection: machine.second)
+    {
+      const ConnectionAttemptPtr& attempt = connection.second;
+      if (attempt && attempt->state == State_Connected && attempt->endpoint)
+        sockets.push_back(attempt->endpoint);
+    }
+  }
+  return sockets;
+}
+
 FutureSync<void> TransportSocketCache::disconnect(MessageSocketPtr socket)
 {
+  // Keep-alive pooling: parking the socket keeps it connected and cached so
+  // that short-lived sessions to the same machine skip the reconnection.
+  if (socketCacheIdleTimeout() != Seconds::zero() && parkSocket(socket))
+    return futurize();
+
+  // Cross-session sharing: when other sessions of the process still use this
+  // socket, give up our reference and our cache entry but leave it connected
+  // for them.
+  if (sharedSocketsEnabled() && SharedSocketRegistry::instance().release(socket))
+  {
+    forgetSharedSocket(socket);
+    return futurize();
+  }
+
   Promise<void> promiseSocketRemoved;
   {
     auto syncDisconnectInfos = _disconnectInfos.synchronize();
@@ -215,6 +477,112 @@ FutureSync<void> TransportSocketCache::disconnect(MessageSocketPtr socket)
   });
 }
 
+bool TransportSocketCache::parkSocket(const MessageSocketPtr& socket)
+{
+  boost::mutex::scoped_lock lock(_socketMutex);
+  if (_dying || _idleSocketCount >= socketCacheMaxIdle())
+    return false;
+  for (auto& pairMachineIdConnection: _connections)
+  {
+    for (auto& pairUrlConnection: pairMachineIdConnection.second)
+    {
+      auto& attempt = *pairUrlConnection.second;
+      if (attempt.endpoint != socket || attempt.state != State_Connected)
+        continue;
+      if (!attempt.idle)
+      {
+        attempt.idle = true;
+        ++_idleSocketCount;
+      }
+      const auto generation = ++attempt.idleGeneration;
+      const auto machineId = pairMachineIdConnection.first;
+      const auto url = pairUrlConnection.first;
+      asyncDelay(track([=] { expireIdleSocket(machineId, url, generation); }, this),
+                 socketCacheIdleTimeout());
+      qiLogDebug() << "Parked idle socket " << socket.get() << " to [" << machineId << "]["
+                   << url.str() << "]";
+      return true;
+    }
+  }
+  return false;
+}
+
+void TransportSocketCache::expireIdleSocket(const std::string& machineId, const Url& url,
+                                            uint64_t generation)
+{
+  MessageSocketPtr toDisconnect;
+  {
+    boost::mutex::scoped_lock lock(_socketMutex);
+    if (_dying)
+      return;
+    ConnectionMap::iterator machineIt = _connections.find(machineId);
+    if (machineIt == _connections.end())
+      return;
+    std::map<Url, ConnectionAttemptPtr>::iterator urlIt = machineIt->second.find(url);
+    if (urlIt == machineIt->second.end())
+      return;
+    auto& attempt = *urlIt->second;
+    // The socket was reused, or parked again since: this expiry is stale.
+    if (!attempt.idle || attempt.idleGeneration != generation)
+      return;
+    attempt.idle = false;
+    --_idleSocketCount;
+    toDisconnect = attempt.endpoint;
+    if (toDisconnect && sharedSocketsEnabled()
+        && SharedSocketRegistry::instance().release(toDisconnect))
+    {
+      // Other sessions of the process still use this socket: drop our cache
+      // entry but leave it connected for them.
+      qiLogDebug() << "Expired idle socket " << toDisconnect.get()
+                   << " is still shared: left connected";
+      toDisconnect->disconnected.disconnect(attempt.disconnectionTracking);
+      attempt.state = State_Error;
+      checkClear(urlIt->second, machineId);
+      return;
+    }
+  }
+  if (toDisconnect)
+  {
+    qiLogDebug() << "Disconnecting expired idle socket " << toDisconnect.get();
+    // The cache entry is cleaned up by onSocketDisconnected.
+    toDisconnect->disconnect();
+  }
+}
+
+void TransportSocketCache::releaseOrDisconnect(const MessageSocketPtr& socket)
+{
+  if (sharedSocketsEnabled() && SharedSocketRegistry::instance().release(socket))
+  {
+    qiLogDebug() << "Socket " << socket.get()
+                 << " is still shared by other sessions: left connected";
+    return;
+  }
+  socket->disconnect();
+}
+
+void TransportSocketCache::forgetSharedSocket(const MessageSocketPtr& socket)
+{
+  boost::mutex::scoped_lock lock(_socketMutex);
+  for (auto& pairMachineIdConnection: _connections)
+  {
+    for (auto& pairUrlConnection: pairMachineIdConnection.second)
+    {
+      auto attempt = pairUrlConnection.second;
+      if (attempt->endpoint != socket || attempt->state != State_Connected)
+        continue;
+      socket->disconnected.disconnect(attempt->disconnectionTracking);
+      if (attempt->idle)
+      {
+        attempt->idle = false;
+        --_idleSocketCount;
+      }
+      attempt->state = State_Error;
+      checkClear(attempt, pairMachineIdConnection.first);
+      return;
+    }
+  }
+}
+
 void TransportSocketCache::insert(const std::string& machineId, const Url& url, MessageSocketPtr socket)
 {
   // If a connection is pending for this machine / url, terminate the pendage and set the
@@ -276,7 +644,8 @@ void TransportSocketCache::insert(const std::string& machineId, const Url& url,
 void TransportSocketCache::onSocketParallelConnectionAttempt(Future<void> fut,
                                                              MessageSocketPtr socket,
                                                              Url url,
-                                                             const ServiceInfo& info)
+                                                             const ServiceInfo& info,
+                                                             SteadyClock::time_point connectStart)
 {
   boost::mutex::scoped_lock lock(_socketMutex);
 
@@ -286,11 +655,17 @@ void TransportSocketCache::onSocketParallelConnectionAttempt(Future<void> fut,
     if (!fut.hasError())
     {
       _allPendingConnections.remove(socket);
-      socket->disconnect();
+      releaseOrDisconnect(socket);
     }
     return;
   }
 
+  if (!fut.hasError())
+  {
+    updateEndpointScore(url, boost::chrono::duration_cast<MicroSeconds>(
+                                 SteadyClock::now() - connectStart));
+  }
+
   ConnectionMap::iterator machineIt = _connections.find(info.machineId());
   std::map<Url, ConnectionAttemptPtr>::iterator urlIt;
   if (machineIt != _connections.end())
@@ -301,7 +676,7 @@ void TransportSocketCache::onSocketParallelConnectionAttempt(Future<void> fut,
     // The socket was disconnected at some point, and we removed it from our map:
     // return early.
     _allPendingConnections.remove(socket);
-    socket->disconnect();
+    releaseOrDisconnect(socket);
     return;
   }
 
@@ -311,7 +686,7 @@ void TransportSocketCache::onSocketParallelConnectionAttempt(Future<void> fut,
   {
     qiLogDebug() << "Already connected: reject socket " << socket.get() << " endpoint " << url.str();
     _allPendingConnections.remove(socket);
-    socket->disconnect();
+    releaseOrDisconnect(socket);
     checkClear(attempt, info.machineId());
     return;
   }
@@ -338,6 +713,11 @@ void TransportSocketCache::onSocketParallelConnectionAttempt(Future<void> fut,
   attempt->endpoint = socket;
   attempt->promise.setValue(socket);
   attempt->disconnectionTracking = disconnectionTracking;
+  // The socket is tracked through _connections from now on; leaving it in
+  // the pending list would make close() handle it twice.
+  _allPendingConnections.remove(socket);
+  if (sharedSocketsEnabled())
+    SharedSocketRegistry::instance().add(sharedSocketKey(url), socket);
   qiLogDebug() << "Connected to service #" << info.serviceId() << " through url " << url.str() << " and socket "
                << socket.get();
 }
@@ -393,6 +773,11 @@ void TransportSocketCache::onSocketDisconnected(Url url, const ServiceInfo& info
     return;
   qiLogDebug() << "onSocketDisconnected: about to erase socket";
   auto attempt = machineIt->second[url];
+  if (attempt->idle)
+  { // The socket died while parked: fix the idle accounting.
+    attempt->idle = false;
+    --_idleSocketCount;
+  }
   attempt->state = State_Error;
   checkClear(attempt, info.machineId());
   auto syncDisconnectInfos = _disconnectInfos.synchronize();
@@ -13,8 +13,10 @@
 #include <boost/thread/mutex.hpp>
 #include <boost/thread/synchronized_value.hpp>
 
+#include <qi/clock.hpp>
 #include <qi/future.hpp>
 #include <qi/messaging/serviceinfo.hpp>
+#include <qi/types.hpp>
 
 #include <qi/trackable.hpp>
 
@@ -33,6 +35,12 @@ namespace qi
   * -> if the connection is pending wait for the result
   * -> if the socket do not exist, create it, and try to connect it
   * -> if the socket is disconnected try to reconnect it
+  *
+  * When cross-session sharing is enabled (QI_SHARED_SOCKETS, off by
+  * default), connected client sockets are also pooled process-wide, keyed
+  * by endpoint: caches of other sessions targeting the same endpoint reuse
+  * them instead of opening their own connections, and a shared socket is
+  * only disconnected once its last user lets go of it.
   */
 
   class TransportSocketCache : public Trackable<TransportSocketCache>
@@ -53,9 +61,23 @@ namespace qi
     Future<MessageSocketPtr> socket(const ServiceInfo& servInfo, const std::string& sdUrl);
     void insert(const std::string& machineId, const Url& url, MessageSocketPtr socket);
 
+    /// All the sockets currently connected in the cache, idle ones included.
+    std::vector<MessageSocketPtr> connectedSockets();
+
     /// The returned future is set when the socket has been disconnected and
     /// effectively removed from the cache.
+    ///
+    /// When keep-alive pooling is enabled (see
+    /// QIMESSAGING_SOCKET_CACHE_IDLE_TIMEOUT), the socket is not disconnected
+    /// right away: it is parked in the cache for the configured delay so that
+    /// a coming socket() call to the same machine reuses it without paying a
+    /// reconnection, and the returned future is set immediately.
     FutureSync<void> disconnect(MessageSocketPtr socket);
+
+    /// Recorder installed on every socket the cache creates (see
+    /// MessageSocket::setFlightRecorder). To call before the first socket()
+    /// request, typically right after construction.
+    void setFlightRecorder(FlightRecorderPtr recorder) { _flightRecorder = recorder; }
   private:
     enum State
     {
@@ -66,7 +88,7 @@ namespace qi
 
     using UrlVectorPtr = boost::shared_ptr<UrlVector>;
     void onSocketConnectionAttempt(Future<void> fut, Promise<MessageSocketPtr> prom, MessageSocketPtr socket, const ServiceInfo& info, uint32_t currentUrlIdx, UrlVectorPtr urls);
-    void onSocketParallelConnectionAttempt(Future<void> fut, MessageSocketPtr socket, Url url, const ServiceInfo& info);
+    void onSocketParallelConnectionAttempt(Future<void> fut, MessageSocketPtr socket, Url url, const ServiceInfo& info, SteadyClock::time_point connectStart);
     void onSocketDisconnected(Url url, const ServiceInfo& info);
 
 
@@ -78,11 +100,54 @@ namespace qi
       int attemptCount;
       State state;
       SignalLink disconnectionTracking;
+      // Keep-alive pooling: an idle attempt holds a connected socket whose
+      // last user called disconnect(). The generation counter invalidates
+      // pending expiries when the socket is reused or parked again.
+      bool idle = false;
+      uint64_t idleGeneration = 0;
     };
     using ConnectionAttemptPtr = boost::shared_ptr<ConnectionAttempt>;
 
     void checkClear(ConnectionAttemptPtr, const std::string& machineId);
 
+    /// Endpoint scoring: exponentially-weighted average of the connect
+    /// durations observed for an endpoint. Multi-homed machines advertise
+    /// all their interfaces and the advertised order says nothing about
+    /// which route is fast; scores do.
+    struct EndpointScore
+    {
+      MicroSeconds averageConnectTime = MicroSeconds{0};
+      unsigned int sampleCount = 0;
+    };
+
+    /// Record the connect duration observed for an endpoint.
+    /// _socketMutex must be held.
+    void updateEndpointScore(const Url& url, MicroSeconds connectTime);
+    /// Reorder connection candidates so that endpoints with the best (lowest)
+    /// recorded connect time come first; unscored endpoints keep their
+    /// advertised order, after the scored ones. _socketMutex must be held.
+    void sortEndpointCandidates(UrlVector& urls) const;
+    /// Create a socket and start connecting it to the given endpoint.
+    /// _socketMutex must be held.
+    void startConnectionAttempt(const Url& url, const ServiceInfo& info);
+    /// Start a connection attempt that was staggered behind the preferred
+    /// endpoint, unless the attempt already completed in the meantime.
+    void startDelayedAttempt(const Url& url, const ServiceInfo& info);
+
+    /// Park a connected socket instead of disconnecting it, for later reuse.
+    /// Returns false when pooling is not possible (socket not cached, cache
+    /// closing, or too many idle sockets already).
+    bool parkSocket(const MessageSocketPtr& socket);
+    /// Really disconnect a parked socket once its keep-alive delay elapsed.
+    void expireIdleSocket(const std::string& machineId, const Url& url, uint64_t generation);
+
+    /// Give up one process-wide reference on the socket and disconnect it,
+    /// unless other sessions still share it (it is then left connected).
+    void releaseOrDisconnect(const MessageSocketPtr& socket);
+    /// Remove the cache entry of a shared socket that remains in use by
+    /// other sessions, without disconnecting it.
+    void forgetSharedSocket(const MessageSocketPtr& socket);
+
     /// The promise is set when the `disconnected` signal of `socket` has been received.
     struct DisconnectInfo
     {
@@ -93,9 +158,12 @@ namespace qi
     using MachineId = std::string;
     using ConnectionMap = std::map<MachineId, std::map<Url, ConnectionAttemptPtr>>;
     ConnectionMap _connections;
+    std::map<Url, EndpointScore> _endpointScores;
     std::list<MessageSocketPtr> _allPendingConnections;
     boost::synchronized_value<std::vector<DisconnectInfo>> _disconnectInfos;
     bool _dying;
+    size_t _idleSocketCount;
+    FlightRecorderPtr _flightRecorder;
   };
 }
 
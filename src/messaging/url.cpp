@@ -3,6 +3,7 @@
 **  See COPYING for the license
 */
 #include <qi/url.hpp>
+#include <functional>
 #include <sstream>
 #include <qi/type/typeinterface.hpp>
 
@@ -28,6 +29,9 @@ namespace qi {
     std::string    protocol;
     std::string    host;
     unsigned short port;
+    // Raw query string (the part after '?') and its parsed key=value pairs.
+    std::string    query;
+    std::map<std::string, std::string> queryParameters;
 
     enum UrlComponents {
       SCHEME = 2,
@@ -38,58 +42,65 @@ namespace qi {
 
     int components;
 
+    // Hash of the normalized url string, maintained by updateUrl() so
+    // hash-keyed containers never re-hash the string.
+    std::size_t hash;
+
   private:
     // Explodes the url in different part and fill the fields of the class.
     //@return a bitmask of UrlComponents with the elements that were found
     int split_me(const std::string& url);
+    // Fills queryParameters from the raw query string.
+    void parseQuery();
   };
 
   Url::Url()
-    : _p(new UrlPrivate())
+    : _p(std::make_shared<UrlPrivate>())
   {
   }
 
   Url::Url(const std::string &url)
-    : _p(new UrlPrivate(url))
+    : _p(std::make_shared<UrlPrivate>(url))
   {
   }
 
   Url::Url(const std::string &url, unsigned short defaultPort)
-    : _p(new UrlPrivate(url, defaultPort))
+    : _p(std::make_shared<UrlPrivate>(url, defaultPort))
   {
   }
 
   Url::Url(const std::string &url, const std::string &defaultProtocol)
-    : _p(new UrlPrivate(url, defaultProtocol))
+    : _p(std::make_shared<UrlPrivate>(url, defaultProtocol))
   {
   }
 
   Url::Url(const std::string &url, const std::string &defaultProtocol, unsigned short defaultPort)
-    : _p(new UrlPrivate(url, defaultProtocol, defaultPort))
+    : _p(std::make_shared<UrlPrivate>(url, defaultProtocol, defaultPort))
   {
   }
 
   Url::Url(const char *url)
-    : _p(new UrlPrivate(url))
+    : _p(std::make_shared<UrlPrivate>(url))
   {
   }
 
   Url::~Url()
   {
-    delete _p;
   }
 
   Url::Url(const qi::Url& url)
-    : _p(new UrlPrivate(url._p))
+    : _p(url._p) // parsed once, shared: copying is a handle copy
   {
   }
 
   Url& Url::operator= (const Url &rhs) {
-    *_p = *rhs._p;
+    _p = rhs._p;
     return *this;
   }
 
   bool Url::operator< (const Url &rhs) const {
+    if (_p == rhs._p) // same shared representation
+      return false;
     return (this->str() < rhs.str());
   }
 
@@ -109,10 +120,22 @@ namespace qi {
     return (_p->components & UrlPrivate::SCHEME) != 0;
   }
 
+  namespace
+  {
+    // The representation is shared between copies: a setter clones it
+    // first, so the other handles keep what they observed.
+    std::shared_ptr<UrlPrivate> detached(const std::shared_ptr<const UrlPrivate>& p)
+    {
+      return std::make_shared<UrlPrivate>(p.get());
+    }
+  }
+
   void Url::setProtocol(const std::string &protocol) {
-    _p->protocol = protocol;
-    _p->components |= UrlPrivate::SCHEME;
-    _p->updateUrl();
+    const auto p = detached(_p);
+    p->protocol = protocol;
+    p->components |= UrlPrivate::SCHEME;
+    p->updateUrl();
+    _p = p;
   }
 
   const std::string& Url::host() const {
@@ -124,9 +147,11 @@ namespace qi {
   }
 
   void Url::setHost(const std::string &host) {
-    _p->host = host;
-    _p->components |= UrlPrivate::HOST;
-    _p->updateUrl();
+    const auto p = detached(_p);
+    p->host = host;
+    p->components |= UrlPrivate::HOST;
+    p->updateUrl();
+    _p = p;
   }
 
   unsigned short Url::port() const {
@@ -138,9 +163,30 @@ namespace qi {
   }
 
   void Url::setPort(unsigned short port) {
-    _p->port = port;
-    _p->components |= UrlPrivate::PORT;
-    _p->updateUrl();
+    const auto p = detached(_p);
+    p->port = port;
+    p->components |= UrlPrivate::PORT;
+    p->updateUrl();
+    _p = p;
+  }
+
+  const std::map<std::string, std::string>& Url::queryParameters() const {
+    return _p->queryParameters;
+  }
+
+  bool Url::hasQueryParameter(const std::string& key) const {
+    return _p->queryParameters.find(key) != _p->queryParameters.end();
+  }
+
+  std::string Url::queryParameter(const std::string& key) const {
+    std::map<std::string, std::string>::const_iterator it = _p->queryParameters.find(key);
+    if (it == _p->queryParameters.end())
+      return std::string();
+    return it->second;
+  }
+
+  std::size_t Url::hash() const {
+    return _p->hash;
   }
 
   Url specifyUrl(const Url& specification, const Url& baseUrl)
@@ -171,6 +217,7 @@ namespace qi {
     , host()
     , port(0)
     , components(0)
+    , hash(std::hash<std::string>()(std::string()))
   {
   }
 
@@ -179,7 +226,10 @@ namespace qi {
     , protocol(url_p->protocol)
     , host(url_p->host)
     , port(url_p->port)
+    , query(url_p->query)
+    , queryParameters(url_p->queryParameters)
     , components(url_p->components)
+    , hash(url_p->hash)
   {
   }
 
@@ -261,6 +311,9 @@ namespace qi {
       url += host;
     if(components & PORT)
       url += std::string(":") + boost::lexical_cast<std::string>(port);
+    if(!query.empty())
+      url += std::string("?") + query;
+    hash = std::hash<std::string>()(url);
   }
 
   bool UrlPrivate::isValid() const {
@@ -286,10 +339,17 @@ namespace qi {
     unsigned short _port = 0;
     components = 0;
 
-    size_t place = 0;
+    // Strip the query part first, it is not a positional component.
+    size_t place = _url.find('?');
+    if (place != std::string::npos) {
+      query = _url.substr(place + 1);
+      _url = _url.substr(0, place);
+      parseQuery();
+    }
+
     place = _url.find("://");
     if (place != std::string::npos) {
-      _scheme = url.substr(0, place);
+      _scheme = _url.substr(0, place);
       components |= SCHEME;
       place += 3;
     } else
@@ -329,9 +389,30 @@ namespace qi {
     return components;
   }
 
+  void UrlPrivate::parseQuery() {
+    queryParameters.clear();
+    size_t begin = 0;
+    while (begin <= query.size()) {
+      size_t end = query.find('&', begin);
+      if (end == std::string::npos)
+        end = query.size();
+      const std::string pair = query.substr(begin, end - begin);
+      if (!pair.empty()) {
+        const size_t eq = pair.find('=');
+        if (eq == std::string::npos)
+          queryParameters[pair] = std::string();
+        else
+          queryParameters[pair.substr(0, eq)] = pair.substr(eq + 1);
+      }
+      begin = end + 1;
+    }
+  }
+
   bool operator==(const Url& lhs, const Url& rhs)
   {
-    return lhs.str() == rhs.str();
+    // The hashes are precomputed, so mismatches are decided without
+    // touching the strings.
+    return lhs.hash() == rhs.hash() && lhs.str() == rhs.str();
   }
 
 }
@@ -29,6 +29,8 @@
 
 #include <qi/path.hpp>
 #include <qi/os.hpp>
+#include <qi/eventloop.hpp>
+#include <qi/future.hpp>
 #include <qi/log.hpp>
 #include <qi/types.hpp>
 #include <qi/uuid.hpp>
@@ -129,6 +131,22 @@ namespace qi {
       return res;
     }
 
+    qi::Future<int> spawnvpAsync(const std::vector<std::string>& args)
+    {
+      return qi::async([args]() -> int {
+        std::vector<char*> argv;
+        argv.reserve(args.size() + 1);
+        for (const std::string& arg: args)
+          argv.push_back(const_cast<char*>(arg.c_str()));
+        argv.push_back(nullptr);
+        const int pid = spawnvp(argv.data());
+        if (pid == -1)
+          throw std::runtime_error(
+              "failed to spawn '" + (args.empty() ? std::string() : args.front()) + "'");
+        return pid;
+      });
+    }
+
     bool isProcessRunning(int pid, const std::string &fileName)
     {
       if (pid <= 0)
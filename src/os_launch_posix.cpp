@@ -113,7 +113,14 @@ namespace qi
 
 #ifdef __linux__
       posix_spawnattr_t spawnattr;
-      spawnattr.__flags = POSIX_SPAWN_USEVFORK;
+      posix_spawnattr_init(&spawnattr);
+# ifdef POSIX_SPAWN_USEVFORK
+      // vfork semantics: the child borrows the parent's address space until
+      // exec, so spawning from a large process does not pay for a page-table
+      // copy. glibc extension; a glibc recent enough to ignore the flag uses
+      // clone(CLONE_VM|CLONE_VFORK) unconditionally, which is equivalent.
+      posix_spawnattr_setflags(&spawnattr, POSIX_SPAWN_USEVFORK);
+# endif
       pSpawnattr = &spawnattr;
 #endif
 
@@ -143,6 +150,10 @@ namespace qi
                          (char* const*)argv,
                          child_env);
 
+#ifdef __linux__
+      posix_spawnattr_destroy(&spawnattr);
+#endif
+
       if ((err != 0) || errno)
       {
         return -1;
@@ -36,6 +36,8 @@
 #if defined (__linux__)
 # include <sys/prctl.h>
 # include <sys/resource.h>
+# include <linux/netlink.h>
+# include <linux/rtnetlink.h>
 #endif
 
 #if defined (__MACH__)
@@ -54,7 +56,9 @@
 #include <qi/path.hpp>
 #include "utils.hpp"
 
+#include <functional>
 #include <mutex>
+#include <thread>
 
 qiLogCategory("qi.os");
 
@@ -255,6 +259,117 @@ namespace qi {
       return iPort;
     }
 
+    namespace
+    {
+      using IfsMap = std::map<std::string, std::vector<std::string> >;
+
+      /* Cached interface enumeration and its observers. Leaky singleton so
+       * the watcher thread and late observers stay safe during static
+       * destruction, like the registries in qi::log.
+       */
+      struct HostIPAddrsState
+      {
+        std::mutex mutex;
+        bool watching = false;       // netlink watcher alive: caching is safe
+        bool watcherStarted = false;
+        bool valid[2] = { false, false }; // indexed by ipv6Addr
+        IfsMap cached[2];
+        std::map<int, std::function<void()>> observers;
+        int nextObserverId = 0;
+      };
+      HostIPAddrsState& hostIPAddrsState()
+      {
+        static HostIPAddrsState* state = new HostIPAddrsState; // never deleted
+        return *state;
+      }
+
+      /// Drops the cached enumerations and notifies the observers outside
+      /// the lock.
+      void invalidateHostIPAddrs()
+      {
+        HostIPAddrsState& state = hostIPAddrsState();
+        std::vector<std::function<void()>> observers;
+        {
+          std::lock_guard<std::mutex> lock(state.mutex);
+          state.valid[0] = false;
+          state.valid[1] = false;
+          for (const auto& observer: state.observers)
+            observers.push_back(observer.second);
+        }
+        for (const auto& observer: observers)
+          observer();
+      }
+
+#if defined(__linux__) && !defined(ANDROID)
+      /// Blocks on a netlink route socket and invalidates the cache on every
+      /// link or address change. If the socket cannot be set up, caching is
+      /// disabled and every hostIPAddrs() call enumerates as before.
+      void hostIPAddrsWatcher()
+      {
+        const auto disableCaching = []
+        {
+          HostIPAddrsState& state = hostIPAddrsState();
+          std::lock_guard<std::mutex> lock(state.mutex);
+          state.watching = false;
+          state.valid[0] = false;
+          state.valid[1] = false;
+        };
+        const int fd = ::socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+        if (fd < 0)
+        {
+          qiLogVerbose() << "hostIPAddrs: no netlink socket, caching disabled: "
+                         << strerror(errno);
+          disableCaching();
+          return;
+        }
+        struct sockaddr_nl addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.nl_family = AF_NETLINK;
+        addr.nl_groups = RTMGRP_LINK | RTMGRP_IPV4_IFADDR | RTMGRP_IPV6_IFADDR;
+        if (::bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0)
+        {
+          qiLogVerbose() << "hostIPAddrs: cannot bind netlink socket,"
+                            " caching disabled: " << strerror(errno);
+          ::close(fd);
+          disableCaching();
+          return;
+        }
+        char buffer[4096];
+        for (;;)
+        {
+          const ssize_t len = ::recv(fd, buffer, sizeof(buffer), 0);
+          if (len < 0)
+          {
+            if (errno == EINTR)
+              continue;
+            break;
+          }
+          // The payload does not matter: any link or address event may
+          // change the enumeration.
+          invalidateHostIPAddrs();
+        }
+        ::close(fd);
+        disableCaching();
+      }
+#endif
+    }
+
+    int addHostIPAddrsObserver(std::function<void()> callback)
+    {
+      HostIPAddrsState& state = hostIPAddrsState();
+      std::lock_guard<std::mutex> lock(state.mutex);
+      const int id = state.nextObserverId++;
+      state.observers[id] = std::move(callback);
+      return id;
+    }
+
+    void removeHostIPAddrsObserver(int id)
+    {
+      HostIPAddrsState& state = hostIPAddrsState();
+      std::lock_guard<std::mutex> lock(state.mutex);
+      state.observers.erase(id);
+    }
+
 #ifdef ANDROID
     std::map<std::string, std::vector<std::string> > hostIPAddrs(bool ipv6Addr)
     {
@@ -330,8 +445,21 @@ namespace qi {
       void *tmpAddrPtr = nullptr;
       int ret = 0;
 
-      static std::mutex mutex;
-      std::lock_guard<std::mutex> lock(mutex);
+      HostIPAddrsState& state = hostIPAddrsState();
+      const int which = ipv6Addr ? 1 : 0;
+      std::lock_guard<std::mutex> lock(state.mutex);
+#if defined(__linux__)
+      if (!state.watcherStarted)
+      {
+        // Started on first use; optimistic, the watcher disables caching if
+        // netlink turns out to be unavailable.
+        state.watcherStarted = true;
+        state.watching = true;
+        std::thread(&hostIPAddrsWatcher).detach();
+      }
+#endif
+      if (state.watching && state.valid[which])
+        return state.cached[which];
 
       ret = getifaddrs(&ifAddrStruct);
       if (ret == -1) {
@@ -360,6 +488,11 @@ namespace qi {
         }
       }
       freeifaddrs(ifAddrStruct);
+      if (state.watching)
+      {
+        state.cached[which] = ifsMap;
+        state.valid[which] = true;
+      }
       return ifsMap;
      }
 #endif
@@ -412,6 +545,16 @@ namespace qi {
       return false;
     }
 
+    //true on success
+    bool setCurrentThreadRealtimePriority(int priority) {
+      if (priority <= 0)
+        return false;
+      struct sched_param param;
+      memset(&param, 0, sizeof(param));
+      param.sched_priority = priority;
+      return !pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+    }
+
     static std::string readLink(const std::string &link)
     {
       boost::filesystem::path p(link, qi::unicodeFacet());
@@ -10,6 +10,8 @@
 #include <cstdlib>
 #include <cstdarg>
 #include <algorithm>
+#include <functional>
+#include <mutex>
 #include <fcntl.h>
 #include <sys/stat.h>
 #include <sys/timeb.h>
@@ -350,6 +352,40 @@ namespace qi {
       return iPort;
     }
 
+    // No address watcher on this platform: observers are stored so the ids
+    // behave consistently, but they are never invoked and hostIPAddrs()
+    // enumerates on every call (callers keep polling, see qi/os.hpp).
+    namespace
+    {
+      struct HostIPAddrsObservers
+      {
+        std::mutex mutex;
+        std::map<int, std::function<void()>> observers;
+        int nextObserverId = 0;
+      };
+      HostIPAddrsObservers& hostIPAddrsObservers()
+      {
+        static HostIPAddrsObservers* observers = new HostIPAddrsObservers; // never deleted
+        return *observers;
+      }
+    }
+
+    int addHostIPAddrsObserver(std::function<void()> callback)
+    {
+      HostIPAddrsObservers& state = hostIPAddrsObservers();
+      std::lock_guard<std::mutex> lock(state.mutex);
+      const int id = state.nextObserverId++;
+      state.observers[id] = std::move(callback);
+      return id;
+    }
+
+    void removeHostIPAddrsObserver(int id)
+    {
+      HostIPAddrsObservers& state = hostIPAddrsObservers();
+      std::lock_guard<std::mutex> lock(state.mutex);
+      state.observers.erase(id);
+    }
+
     std::map<std::string, std::vector<std::string> > hostIPAddrs(bool ipv6Addr)
     {
       // TODO: replace usage of GetAdaptersInfo by a more "modern" Windows API (or Boost)
@@ -493,6 +529,17 @@ namespace qi {
       return true;
     }
 
+    bool setCurrentThreadRealtimePriority(int priority) {
+      if (priority <= 0)
+        return false;
+      if (!SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL))
+      {
+        qiLogError() << GetLastErrorMessage(GetLastError());
+        return false;
+      }
+      return true;
+    }
+
     std::string timezone()
     {
       TIME_ZONE_INFORMATION tzInfo;
@@ -10,6 +10,7 @@
 
 #include <qi/application.hpp>
 #include <qi/path.hpp>
+#include <qi/path_conf.hpp>
 #include <qi/os.hpp>
 #include <qi/log.hpp>
 #include <qi/atomic.hpp>
@@ -321,6 +322,11 @@ namespace qi
         return getInstance()->clearOptionalSdkPrefix();
       }
 
+      void invalidateSdkLayoutCache()
+      {
+        getInstance()->invalidateCache();
+      }
+
 
       std::vector<std::string> getSdkPrefixes()
       {
@@ -496,9 +502,24 @@ namespace qi
     }
   }
 
+  namespace {
+    // path.conf prefixes used to be pulled in by qi::Application's
+    // constructor; they are now folded in when the layout is first used, so
+    // that constructing an Application does not touch the filesystem.
+    void readPathConf(SDKLayout* layout)
+    {
+      const std::string prefix = layout->sdkPrefix();
+      const std::vector<std::string> toAdd = qi::path::parseQiPathConf(prefix);
+      std::vector<std::string>::const_iterator it;
+      for (it = toAdd.begin(); it != toAdd.end(); ++it)
+        layout->addOptionalSdkPrefix(it->c_str());
+    }
+  }
+
   SDKLayout* getInstance()
   {
     QI_THREADSAFE_NEW(gInstance);
+    QI_ONCE(readPathConf(gInstance));
     return gInstance;
   }
 
@@ -4,9 +4,11 @@
  * found in the COPYING file.
  */
 
-#include <set>
+#include <ctime>
+#include <map>
 #include <boost/filesystem/fstream.hpp>
 #include <boost/filesystem.hpp>
+#include <boost/thread/mutex.hpp>
 
 #include <qi/log.hpp>
 #include <qi/path.hpp>
@@ -17,16 +19,56 @@ qiLogCategory("qi.path");
 namespace qi {
   namespace path {
 
+namespace {
+  /* Cache of fully-resolved parseQiPathConf() results, keyed by prefix and
+   * validated against the modification time of every path.conf read while
+   * resolving that prefix. Launchers resolve the same configuration for each
+   * spawned service; revalidation is a stat per path.conf instead of a
+   * recursive read/parse/probe. The map is heap-allocated and never deleted
+   * so it stays usable during static destruction.
+   */
+  struct ParsedPathConf
+  {
+    std::vector<std::string> result;
+    // path.conf file -> mtime when it was read (-1 when it was absent).
+    std::map<std::string, std::time_t> dependencies;
+  };
+
+  static boost::mutex gPathConfCacheMutex;
+  static std::map<std::string, ParsedPathConf>* gPathConfCache = nullptr;
+
+  static std::time_t pathConfMTime(const std::string &pathConf)
+  {
+    boost::system::error_code ec;
+    const std::time_t mtime = boost::filesystem::last_write_time(
+        boost::filesystem::path(pathConf, qi::unicodeFacet()), ec);
+    return ec ? static_cast<std::time_t>(-1) : mtime;
+  }
+
+  static bool isUpToDate(const ParsedPathConf &parsed)
+  {
+    std::map<std::string, std::time_t>::const_iterator it;
+    for (it = parsed.dependencies.begin(); it != parsed.dependencies.end(); ++it)
+    {
+      if (pathConfMTime(it->first) != it->second)
+        return false;
+    }
+    return true;
+  }
+}
+
 static void recParseQiPathConf(const std::string &prefix, std::vector<std::string>& res,
-                              std::set<std::string>& filesSeen)
+                              std::map<std::string, std::time_t>& filesSeen)
 {
   const qi::Path pathConf = qi::Path(prefix) / "share/qi/path.conf";
-  std::set<std::string>::iterator it;
+  std::map<std::string, std::time_t>::iterator it;
   it = filesSeen.find(pathConf.str());
   if (it != filesSeen.end()) {
     return;
   }
-  filesSeen.insert(pathConf.str());
+  // Record the mtime before reading: a concurrent rewrite then invalidates
+  // the cached entry on the next call.
+  filesSeen[pathConf.str()] = pathConfMTime(pathConf.str());
 
   boost::filesystem::ifstream is(pathConf);
   while (is.good()) {
@@ -57,12 +99,27 @@ static void recParseQiPathConf(const std::string &prefix, std::vector<std::strin
 
 std::vector<std::string> parseQiPathConf(const std::string &prefix)
 {
-  std::vector<std::string> res;
-  std::set<std::string> filesSeen;
-  recParseQiPathConf(prefix, res, filesSeen);
-  return res;
+  {
+    boost::mutex::scoped_lock lock(gPathConfCacheMutex);
+    if (gPathConfCache) {
+      std::map<std::string, ParsedPathConf>::const_iterator it =
+        gPathConfCache->find(prefix);
+      if (it != gPathConfCache->end() && isUpToDate(it->second)) {
+        return it->second.result;
+      }
+    }
+  }
+
+  ParsedPathConf parsed;
+  recParseQiPathConf(prefix, parsed.result, parsed.dependencies);
+
+  boost::mutex::scoped_lock lock(gPathConfCacheMutex);
+  if (!gPathConfCache) {
+    gPathConfCache = new std::map<std::string, ParsedPathConf>();
+  }
+  (*gPathConfCache)[prefix] = parsed;
+  return parsed.result;
 }
 
   } // path
 } // qi
-
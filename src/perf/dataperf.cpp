@@ -7,10 +7,72 @@
 
 #include "dataperf_p.hpp"
 
+#include <algorithm>
+#include <cmath>
+
 namespace qi
 {
+  LatencyHistogram::LatencyHistogram()
+    : _counts(levelCount * subBucketCount, 0)
+  {
+    reset();
+  }
+
+  void LatencyHistogram::reset()
+  {
+    std::fill(_counts.begin(), _counts.end(), 0);
+    _count = 0;
+    _min = ~0ull;
+    _max = 0;
+  }
+
+  void LatencyHistogram::record(qi::uint64_t valueNs)
+  {
+    unsigned int level = 0;
+    qi::uint64_t sub = valueNs;
+    while (sub >= subBucketCount)
+    {
+      sub >>= 1;
+      ++level;
+    }
+    if (level >= levelCount) // ~9 years; clamp rather than overflow
+    {
+      level = levelCount - 1;
+      sub = subBucketCount - 1;
+    }
+    ++_counts[level * subBucketCount + sub];
+    ++_count;
+    if (valueNs < _min)
+      _min = valueNs;
+    if (valueNs > _max)
+      _max = valueNs;
+  }
+
+  qi::uint64_t LatencyHistogram::valueAtPercentile(double percentile) const
+  {
+    if (_count == 0)
+      return 0;
+    const qi::uint64_t target = static_cast<qi::uint64_t>(
+        std::ceil(percentile / 100.0 * static_cast<double>(_count)));
+    qi::uint64_t seen = 0;
+    for (unsigned int i = 0; i < levelCount * subBucketCount; ++i)
+    {
+      seen += _counts[i];
+      if (seen >= target)
+      {
+        const unsigned int level = i / subBucketCount;
+        const qi::uint64_t sub = i % subBucketCount;
+        // highest value mapping to this bucket, clamped to what was observed
+        const qi::uint64_t value = ((sub + 1) << level) - 1;
+        return std::min(std::max(value, _min), _max);
+      }
+    }
+    return _max;
+  }
+
   DataPerfPrivate::DataPerfPrivate()
     : benchmarkName(""), wallClockElapsed(0), cpuElapsed(0), fLoopCount(0), fMsgSize(0), variable("")
+    , warmupCount(0), samplesSeen(0)
   { }
 
   DataPerf::DataPerf()
@@ -28,16 +90,45 @@ namespace qi
     _p->fLoopCount = loopCount;
     _p->fMsgSize = msgSize;
     _p->variable = variable;
+    _p->samplesSeen = 0;
+    _p->histogram.reset();
     _p->cpuTime.restart();
+    _p->counterValues = measure::CounterValues();
+    // Last, so that the counters do not see the bookkeeping above.
+    _p->perfCounters.start();
     _p->fStartTime = qi::SteadyClock::now();
+    _p->lastSampleTime = _p->fStartTime;
+  }
+
+  void DataPerf::recordSample()
+  {
+    const qi::SteadyClock::time_point now = qi::SteadyClock::now();
+    const qi::uint64_t ns = static_cast<qi::uint64_t>(
+        boost::chrono::duration_cast<boost::chrono::nanoseconds>(
+            now - _p->lastSampleTime).count());
+    _p->lastSampleTime = now;
+    if (_p->samplesSeen++ < _p->warmupCount)
+      return;
+    _p->histogram.record(ns);
+  }
+
+  void DataPerf::setWarmupCount(unsigned long count)
+  {
+    _p->warmupCount = count;
   }
 
   void DataPerf::stop() {
+    _p->counterValues = _p->perfCounters.stop();
     _p->cpuElapsed = _p->cpuTime.elapsed();
     using second = boost::chrono::duration<double, boost::ratio<1,1>>;
     _p->wallClockElapsed = qi::durationSince<second>(_p->fStartTime).count();
   }
 
+  measure::CounterValues DataPerf::getCounters() const
+  {
+    return _p->counterValues;
+  }
+
   std::string DataPerf::getBenchmarkName() const
   {
     return _p->benchmarkName;
@@ -68,6 +159,32 @@ namespace qi
     return 1.0 / ((_p->wallClockElapsed) / (1.0 * (_p->fLoopCount)));
   }
 
+  double DataPerf::getPercentile(double percentile) const
+  {
+    if (_p->histogram.count() == 0)
+      return -1;
+    return static_cast<double>(_p->histogram.valueAtPercentile(percentile)) / 1000.0;
+  }
+
+  double DataPerf::getMinSample() const
+  {
+    if (_p->histogram.count() == 0)
+      return -1;
+    return static_cast<double>(_p->histogram.minValue()) / 1000.0;
+  }
+
+  double DataPerf::getMaxSample() const
+  {
+    if (_p->histogram.count() == 0)
+      return -1;
+    return static_cast<double>(_p->histogram.maxValue()) / 1000.0;
+  }
+
+  unsigned long DataPerf::getSampleCount() const
+  {
+    return static_cast<unsigned long>(_p->histogram.count());
+  }
+
   double DataPerf::getMegaBytePerSecond() const
   {
     if (_p->fMsgSize > 0)
@@ -10,12 +10,45 @@
 #define _QI_PERF_DATAPERF_P_HPP_
 
 #include <qi/perf/dataperf.hpp>
+#include <qi/perf/measure.hpp>
 
 #include <qi/os.hpp>
+#include <qi/types.hpp>
 #include <boost/timer.hpp>
 
+#include <vector>
+
 namespace qi
 {
+  //! Log-linear latency histogram in the HdrHistogram style: values are
+  //! nanoseconds, each power of two is split into 64 linear sub-buckets,
+  //! which bounds the relative error of a reported percentile below 2%.
+  //! Recording is a few arithmetic operations on a preallocated array.
+  class LatencyHistogram
+  {
+  public:
+    LatencyHistogram();
+
+    void reset();
+    void record(qi::uint64_t valueNs);
+
+    //! Value at the given percentile (0 < percentile <= 100), or 0 if empty.
+    qi::uint64_t valueAtPercentile(double percentile) const;
+    qi::uint64_t count() const { return _count; }
+    qi::uint64_t minValue() const { return _count ? _min : 0; }
+    qi::uint64_t maxValue() const { return _count ? _max : 0; }
+
+  private:
+    static const unsigned int subBucketBits = 6;
+    static const qi::uint64_t subBucketCount = 1ull << subBucketBits;
+    static const unsigned int levelCount = 58; // covers up to ~9 years in ns
+
+    std::vector<qi::uint64_t> _counts;
+    qi::uint64_t _count;
+    qi::uint64_t _min;
+    qi::uint64_t _max;
+  };
+
   class DataPerfPrivate
   {
   public:
@@ -39,6 +72,20 @@ namespace qi
     unsigned long   fMsgSize;
     //! Variable
     std::string variable;
+
+    //! End of the previously recorded iteration (or start time)
+    qi::SteadyClock::time_point lastSampleTime;
+    //! Number of initial samples to discard as warm-up
+    unsigned long   warmupCount;
+    //! Samples seen so far in this run, warm-up included
+    unsigned long   samplesSeen;
+    //! Distribution of per-iteration latencies, warm-up excluded
+    LatencyHistogram histogram;
+
+    //! perf_event counters sampled around start()/stop()
+    measure::PerfCounters perfCounters;
+    //! Counter values of the last completed run
+    measure::CounterValues counterValues;
   };
 }
 
@@ -7,11 +7,33 @@
 
 #include "dataperfsuite_p.hpp"
 
+#include <cstdlib>
 #include <iostream>
 #include <iomanip>
 
 namespace qi
 {
+  namespace
+  {
+    // Extract one attribute value from a line of XML written by this class.
+    // This only needs to read back our own output, so a full parser would be
+    // overkill (and would add a dependency).
+    bool xmlAttribute(const std::string& line, const std::string& name,
+                      std::string& value)
+    {
+      const std::string pattern = name + "=\"";
+      const size_t begin = line.find(pattern);
+      if (begin == std::string::npos)
+        return false;
+      const size_t valueBegin = begin + pattern.size();
+      const size_t end = line.find('"', valueBegin);
+      if (end == std::string::npos)
+        return false;
+      value = line.substr(valueBegin, end - valueBegin);
+      return true;
+    }
+  }
+
   DataPerfSuite::DataPerfSuite(const std::string& projectName, const std::string& executableName, OutputData outputData, const std::string& filename)
     :_p(new DataPerfSuitePrivate)
   {
@@ -45,29 +67,35 @@ namespace qi
   }
 
   DataPerfSuite& DataPerfSuite::operator<<(const DataPerf& data) {
+    std::string resultType;
+    float resultValue;
+    switch (_p->outputData)
+    {
+    case OutputData_Cpu:
+      resultType = "Cpu";
+      resultValue = static_cast<float>(data.getCpu());
+      break;
+    case OutputData_Period:
+      resultType = "Period";
+      resultValue = static_cast<float>(data.getPeriod());
+      break;
+    case OutputData_MsgPerSecond:
+      resultType = "MsgPerSecond";
+      resultValue = static_cast<float>(data.getMsgPerSecond());
+      break;
+    case OutputData_MsgMBPerSecond:
+    default:
+      resultType = "MsgMBPerSecond";
+      resultValue = static_cast<float>(data.getMegaBytePerSecond());
+      break;
+    }
+
+    // The same variable string that ends up in the result_variable attribute.
+    std::string variable = data.getVariable();
+    if (variable.empty() && data.getMsgSize() != 0)
+      variable = std::to_string(data.getMsgSize());
+
     if (_p->out.is_open()) {
-      std::string resultType;
-      float resultValue;
-      switch (_p->outputData)
-      {
-      case OutputData_Cpu:
-        resultType = "Cpu";
-        resultValue = static_cast<float>(data.getCpu());
-        break;
-      case OutputData_Period:
-        resultType = "Period";
-        resultValue = static_cast<float>(data.getPeriod());
-        break;
-      case OutputData_MsgPerSecond:
-        resultType = "MsgPerSecond";
-        resultValue = static_cast<float>(data.getMsgPerSecond());
-        break;
-      case OutputData_MsgMBPerSecond:
-      default:
-        resultType = "MsgMBPerSecond";
-        resultValue = static_cast<float>(data.getMegaBytePerSecond());
-        break;
-      }
       _p->out << "\t<perf_result "
               << "benchmark=\"" << data.getBenchmarkName() << "_" << resultType << "\" "
               << "result_value=\"" << std::fixed << std::setprecision(6) << resultValue << "\" "
@@ -98,9 +126,56 @@ namespace qi
           << std::endl;
     }
 
+    const auto it =
+        _p->baseline.find(data.getBenchmarkName() + "_" + resultType + "/" + variable);
+    if (it != _p->baseline.end() && it->second != 0) {
+      const double delta =
+          (static_cast<double>(resultValue) - it->second) / it->second * 100.0;
+      const bool lowerIsBetter = _p->outputData == OutputData_Cpu ||
+                                 _p->outputData == OutputData_Period;
+      const bool regressed = lowerIsBetter ? delta > _p->regressionThreshold
+                                           : delta < -_p->regressionThreshold;
+      if (regressed)
+        ++_p->regressionCount;
+      std::cout << "  vs baseline (" << resultType << " "
+                << std::fixed << std::setprecision(6) << it->second << "): "
+                << std::showpos << std::setprecision(1) << delta << " %"
+                << std::noshowpos
+                << (regressed ? "  REGRESSION" : "") << std::endl;
+    }
+
     return *this;
   }
 
+  bool DataPerfSuite::loadBaseline(const std::string& filename)
+  {
+    boost::filesystem::ifstream in(filename.c_str());
+    if (!in.is_open()) {
+      std::cerr << "Can't open baseline file " << filename << "." << std::endl;
+      return false;
+    }
+    std::string line;
+    while (std::getline(in, line)) {
+      std::string benchmark, value, variable;
+      if (!xmlAttribute(line, "benchmark", benchmark) ||
+          !xmlAttribute(line, "result_value", value))
+        continue;
+      xmlAttribute(line, "result_variable", variable);
+      _p->baseline[benchmark + "/" + variable] = strtod(value.c_str(), NULL);
+    }
+    return true;
+  }
+
+  void DataPerfSuite::setRegressionThreshold(double percent)
+  {
+    _p->regressionThreshold = percent;
+  }
+
+  unsigned int DataPerfSuite::regressionCount() const
+  {
+    return _p->regressionCount;
+  }
+
   void DataPerfSuite::flush()
   {
     if (_p->out.is_open())
@@ -13,6 +13,8 @@
 
 #include <boost/filesystem/fstream.hpp>
 
+#include <map>
+
 namespace qi
 {
   class DataPerfSuitePrivate
@@ -31,6 +33,16 @@ namespace qi
 
     //! Name of the executable.
     std::string executableName;
+
+    //! Baseline values loaded from a previous run's XML output,
+    //! keyed by benchmark name and variable.
+    std::map<std::string, double> baseline;
+
+    //! Tolerated degradation (percent of baseline) before counting a regression.
+    double regressionThreshold = 5.0;
+
+    //! Benchmarks seen so far that are worse than the baseline beyond the threshold.
+    unsigned int regressionCount = 0;
   };
 }
 
@@ -8,8 +8,13 @@
 #include <qi/perf/measure.hpp>
 
 #ifdef __linux__
+#include <cstdio>
+#include <cstring>
 #include <dirent.h>
 #include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
 #endif
 
 namespace qi
@@ -32,5 +37,151 @@ namespace qi
 
       return fdCount;
     }
+
+    qi::int64_t getResidentSetSize()
+    {
+#ifdef __linux__
+      FILE* statm = std::fopen("/proc/self/statm", "r");
+      if (statm == NULL)
+        return -1;
+      long long pagesTotal = 0;
+      long long pagesResident = 0;
+      const int matched = std::fscanf(statm, "%lld %lld", &pagesTotal, &pagesResident);
+      std::fclose(statm);
+      if (matched != 2)
+        return -1;
+      return static_cast<qi::int64_t>(pagesResident) * ::sysconf(_SC_PAGESIZE);
+#else
+      return -1;
+#endif
+    }
+
+    class PerfCountersPrivate
+    {
+    public:
+      enum Counter
+      {
+        Counter_Cycles = 0,
+        Counter_Instructions,
+        Counter_CacheMisses,
+        Counter_ContextSwitches,
+
+        Counter_End
+      };
+
+      PerfCountersPrivate()
+      {
+        for (int i = 0; i < Counter_End; ++i)
+          fds[i] = -1;
+#ifdef __linux__
+        fds[Counter_Cycles] =
+            openEvent(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, true);
+        fds[Counter_Instructions] =
+            openEvent(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, true);
+        fds[Counter_CacheMisses] =
+            openEvent(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES, true);
+        // Context switches happen in the kernel: counting them requires not
+        // excluding it, which perf_event_paranoid > 1 refuses. The counter
+        // then degrades to -1 while the hardware ones keep working.
+        fds[Counter_ContextSwitches] =
+            openEvent(PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES, false);
+#endif
+      }
+
+      ~PerfCountersPrivate()
+      {
+#ifdef __linux__
+        for (int i = 0; i < Counter_End; ++i)
+          if (fds[i] != -1)
+            ::close(fds[i]);
+#endif
+      }
+
+#ifdef __linux__
+      static int openEvent(qi::uint32_t type, qi::uint64_t config, bool excludeKernel)
+      {
+        struct perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = config;
+        attr.disabled = 1;
+        attr.exclude_kernel = excludeKernel ? 1 : 0;
+        attr.exclude_hv = 1;
+        // Current thread, any cpu.
+        return static_cast<int>(
+            ::syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0ul));
+      }
+
+      static qi::int64_t readValue(int fd)
+      {
+        qi::uint64_t value = 0;
+        if (::read(fd, &value, sizeof(value)) != sizeof(value))
+          return -1;
+        return static_cast<qi::int64_t>(value);
+      }
+#endif
+
+      int fds[Counter_End];
+      qi::int64_t rssAtStart = -1;
+    };
+
+    PerfCounters::PerfCounters()
+      : _p(new PerfCountersPrivate())
+    {
+    }
+
+    PerfCounters::~PerfCounters()
+    {
+      delete _p;
+    }
+
+    bool PerfCounters::available() const
+    {
+      for (int i = 0; i < PerfCountersPrivate::Counter_End; ++i)
+        if (_p->fds[i] != -1)
+          return true;
+      return false;
+    }
+
+    void PerfCounters::start()
+    {
+      _p->rssAtStart = getResidentSetSize();
+#ifdef __linux__
+      for (int i = 0; i < PerfCountersPrivate::Counter_End; ++i)
+      {
+        if (_p->fds[i] == -1)
+          continue;
+        ::ioctl(_p->fds[i], PERF_EVENT_IOC_RESET, 0);
+        ::ioctl(_p->fds[i], PERF_EVENT_IOC_ENABLE, 0);
+      }
+#endif
+    }
+
+    CounterValues PerfCounters::stop()
+    {
+      CounterValues values;
+#ifdef __linux__
+      for (int i = 0; i < PerfCountersPrivate::Counter_End; ++i)
+        if (_p->fds[i] != -1)
+          ::ioctl(_p->fds[i], PERF_EVENT_IOC_DISABLE, 0);
+      if (_p->fds[PerfCountersPrivate::Counter_Cycles] != -1)
+        values.cycles = PerfCountersPrivate::readValue(
+            _p->fds[PerfCountersPrivate::Counter_Cycles]);
+      if (_p->fds[PerfCountersPrivate::Counter_Instructions] != -1)
+        values.instructions = PerfCountersPrivate::readValue(
+            _p->fds[PerfCountersPrivate::Counter_Instructions]);
+      if (_p->fds[PerfCountersPrivate::Counter_CacheMisses] != -1)
+        values.cacheMisses = PerfCountersPrivate::readValue(
+            _p->fds[PerfCountersPrivate::Counter_CacheMisses]);
+      if (_p->fds[PerfCountersPrivate::Counter_ContextSwitches] != -1)
+        values.contextSwitches = PerfCountersPrivate::readValue(
+            _p->fds[PerfCountersPrivate::Counter_ContextSwitches]);
+#endif
+      const qi::int64_t rssNow = getResidentSetSize();
+      if (_p->rssAtStart != -1 && rssNow != -1)
+        values.residentSetDelta = rssNow - _p->rssAtStart;
+      return values;
+    }
   }
 }
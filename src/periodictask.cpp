@@ -50,6 +50,9 @@ namespace qi
 
     MethodStatistics        _callStats;
     qi::SteadyClockTimePoint _statsDisplayTime;
+    PeriodicTask::Stats     _stats;
+    qi::SteadyClockTimePoint _expectedActivation;
+    bool                    _hasExpectedActivation;
     PeriodicTask::Callback  _callback;
     ScheduleCallback        _scheduleCallback;
     qi::Duration            _period;
@@ -87,6 +90,20 @@ namespace qi
     }
   };
   static const int invalidThreadId = -1;
+
+  // Log-scaled histogram bucket of an activation jitter value: <100us, <1ms,
+  // <10ms, <100ms, <1s, and everything above.
+  static unsigned jitterBucket(qi::Duration jitter)
+  {
+    qi::Duration bound = qi::MicroSeconds(100);
+    for (unsigned i = 0; i + 1 < PeriodicTask::Stats::jitterBucketCount; ++i, bound *= 10)
+    {
+      if (jitter < bound)
+        return i;
+    }
+    return PeriodicTask::Stats::jitterBucketCount - 1;
+  }
+
   PeriodicTask::PeriodicTask() :
     _p(new PeriodicTaskPrivate)
   {
@@ -94,6 +111,7 @@ namespace qi
     _p->_tid = invalidThreadId;
     _p->_compensateCallTime =false;
     _p->_statsDisplayTime = qi::SteadyClock::now();
+    _p->_hasExpectedActivation = false;
     _p->_name = "PeriodicTask_" + boost::lexical_cast<std::string>(this);
     _p->_state = TaskState::Stopped;
   }
@@ -157,6 +175,8 @@ namespace qi
       return; // Already running or being started.
     }
     _p->_taskSynchro.reset(new PeriodicTaskPrivate::TaskSynchronizer);
+    _p->_stats = Stats();
+    _p->_hasExpectedActivation = false;
     _p->_reschedule(immediate ? qi::Duration(0) : _p->_period);
   }
 
@@ -265,6 +285,8 @@ namespace qi
       _task = _scheduleCallback(std::move(task), delay);
     else
       _task = getEventLoop()->asyncDelay(std::move(task), delay);
+    _expectedActivation = qi::SteadyClock::now() + delay;
+    _hasExpectedActivation = true;
     _state = TaskState::Scheduled;
 
     // We track this callback with this object instance just to make sure it won't be called
@@ -281,9 +303,12 @@ namespace qi
   void PeriodicTaskPrivate::_wrap()
   {
     qiLogDebug() << "callback start";
+    qi::Duration jitter(0);
     {
       ScopedLock l(_mutex);
       QI_ASSERT(_state != TaskState::Stopped);
+      if (_hasExpectedActivation)
+        jitter = std::max(qi::Duration(0), qi::SteadyClock::now() - _expectedActivation);
       /* To avoid being stuck because of unhandled transition, the rule is
        * that any other thread playing with our state can only do so
        * to stop us, and must eventualy reach the Stopping state
@@ -346,6 +371,16 @@ namespace qi
     else
     {
       ScopedLock l(_mutex);
+      ++_stats.activations;
+      _stats.totalCallbackTime += delta;
+      if (delta > _stats.maxCallbackTime)
+        _stats.maxCallbackTime = delta;
+      if (delta > _period)
+        ++_stats.overruns;
+      _stats.totalJitter += jitter;
+      if (jitter > _stats.maxJitter)
+        _stats.maxJitter = jitter;
+      ++_stats.jitterBuckets[jitterBucket(jitter)];
       _callStats.push(
           (float)boost::chrono::duration_cast<qi::MicroSeconds>(delta).count() / 1e6f,
           (float)usr / 1e6f,
@@ -406,4 +441,16 @@ namespace qi
     }
     return s == TaskState::Stopped || s == TaskState::Stopping;
   }
+
+  PeriodicTask::Stats PeriodicTask::stats() const
+  {
+    PeriodicTaskPrivate::ScopedLock l(_p->_mutex);
+    return _p->_stats;
+  }
+
+  void PeriodicTask::resetStats()
+  {
+    PeriodicTaskPrivate::ScopedLock l(_p->_mutex);
+    _p->_stats = Stats();
+  }
 }
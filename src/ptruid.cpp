@@ -7,9 +7,9 @@
 #include <atomic>
 #include <iterator>
 #include <iostream>
+#include <stdexcept>
 #include <boost/algorithm/hex.hpp>
 #include <boost/range/algorithm/copy.hpp>
-#include <boost/core/ignore_unused.hpp>
 #include <qi/ptruid.hpp>
 #include <ka/sha1.hpp>
 #include <qi/uuid.hpp>
@@ -22,33 +22,49 @@ namespace qi
     static_assert(sizeof(Uuid) == N, "Uuid must be a byte array.");
   }
 
+  namespace
+  {
+    // SHA1 state already fed with the (machine uuid, process uuid) prefix,
+    // so forming a uid only has to absorb the pointer bytes and finalize.
+    // In practice every uid of a process uses the same prefix; cached per
+    // thread so no locking is needed.
+    struct PrimedSha1Prefix
+    {
+      Uuid machine;
+      Uuid process;
+      SHA_CTX ctx;
+      bool valid = false;
+    };
+  }
+
   PtrUid::PtrUid(const Uuid& machineUuid, const Uuid& processUuid, const void* ptr)
   {
     static_assert(sizeof(uint8_t) == 1, "uint8_t must have a size of 1 "
-                                        "for the array size computation to be valid.");
+                                        "for the hashed sizes to be valid.");
     staticAssertUuidIsByteArray(&Uuid::data);
-    std::array<uint8_t,
-        sizeof(Uuid) // machine uuid
-      + sizeof(Uuid) // process uuid
-      + sizeof(ptr)> // pointer
-        buffer;
 
-    const auto uptr = reinterpret_cast<std::uintptr_t>(ptr);
+    thread_local PrimedSha1Prefix prefix;
+    if (!prefix.valid || prefix.machine != machineUuid || prefix.process != processUuid)
+    {
+      prefix.machine = machineUuid;
+      prefix.process = processUuid;
+      if (!SHA1_Init(&prefix.ctx) ||
+          !SHA1_Update(&prefix.ctx, machineUuid.data, sizeof(Uuid)) ||
+          !SHA1_Update(&prefix.ctx, processUuid.data, sizeof(Uuid)))
+        throw std::runtime_error("PtrUid: can't hash the uuid prefix.");
+      prefix.valid = true;
+    }
 
-    // Copy machine uuid, then process uuid, then pointer.
-    const auto it = std::copy(toUInt8Ptr(&uptr), toUInt8Ptr(&uptr + 1),
-      boost::copy(processUuid,
-        boost::copy(machineUuid, begin(buffer))
-      )
-    );
-    boost::ignore_unused(it);
-
-    // The array size computation use the assumption that
-    // for any Uuid u, u.end() - u.begin() == sizeof(UUid).
-    // Assert that it's really the case.
-    QI_ASSERT(it - begin(buffer) == buffer.size());
-
-    boost::copy(ka::sha1(buffer), begin(*this));
+    // Resume from the primed state: hash the pointer, then finalize.
+    // The digest is the same as hashing machine uuid, process uuid and
+    // pointer in one go.
+    const auto uptr = reinterpret_cast<std::uintptr_t>(ptr);
+    SHA_CTX ctx = prefix.ctx;
+    ka::sha1_digest_t d;
+    if (!SHA1_Update(&ctx, toUInt8Ptr(&uptr), sizeof uptr) ||
+        !SHA1_Final(d.data(), &ctx))
+      throw std::runtime_error("PtrUid: can't compute the sha1 digest.");
+    boost::copy(d, begin(*this));
 #ifdef QI_PTRUID_DEBUG
     // When debugging, the fact that PtrUids have different values at each execution is
     // not desirable (the values are different because the process uuid are different).
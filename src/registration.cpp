@@ -145,15 +145,17 @@ PBOUNCE(MetaMethod, returnDescription, std::string)
 PBOUNCE(MetaMethodParameter, name,        std::string)
 PBOUNCE(MetaMethodParameter, description, std::string)
 
-  static const qi::MetaObject::MethodMap& methodMap(qi::MetaObject* ptr)
+  // The member tables are serialized in their flat storage form; the wire
+  // signature is the same map signature as with the std::map typedefs.
+  static const qi::MetaObject::MethodFlatMap& methodMap(qi::MetaObject* ptr)
   {
     return ptr->_p->_methods;
   }
-  static const qi::MetaObject::SignalMap& signalMap(qi::MetaObject* ptr)
+  static const qi::MetaObject::SignalFlatMap& signalMap(qi::MetaObject* ptr)
   {
     return ptr->_p->_events;
   }
-  static const qi::MetaObject::PropertyMap& propertyMap(qi::MetaObject* ptr)
+  static const qi::MetaObject::PropertyFlatMap& propertyMap(qi::MetaObject* ptr)
   {
     return ptr->_p->_properties;
   }
@@ -22,6 +22,7 @@
 #include "sdklayout.hpp"
 #include "utils.hpp"
 #include <boost/system/error_code.hpp>
+#include <boost/thread/mutex.hpp>
 
 qiLogCategory("qi.path.sdklayout");
 
@@ -90,12 +91,103 @@ namespace detail {
     std::string _mode;
     std::string _writablePath;
 
+    // Listing of one directory: entry name -> is it a directory. Repeated
+    // lookups in the same directory are then map probes instead of a stat
+    // each. A missing or unreadable directory caches as an empty listing.
+    // Filled lazily, cleared by invalidateCache() and when the prefix list
+    // or the writable path changes.
+    using DirListing = std::map<std::string, bool>;
+    std::map<std::string, DirListing> _dirCache;
+    boost::mutex _dirCacheMutex;
+
+    enum EntryKind
+    {
+      Entry_Absent = 0,
+      Entry_File,
+      Entry_Directory
+    };
+
     PrivateSDKLayout()
       : _sdkPrefixes(),
         _mode()
     {
     }
 
+    EntryKind cachedEntryKind(const boost::filesystem::path& dir,
+                              const std::string& name)
+    {
+      const std::string key = dir.string(qi::unicodeFacet());
+      boost::mutex::scoped_lock lock(_dirCacheMutex);
+      std::map<std::string, DirListing>::iterator it = _dirCache.find(key);
+      if (it == _dirCache.end())
+      {
+        DirListing listing;
+        try
+        {
+          boost::filesystem::directory_iterator itD(dir), end;
+          for (; itD != end; ++itD)
+          {
+            bool isDir = false;
+            try
+            {
+              isDir = boost::filesystem::is_directory(itD->path());
+            }
+            catch (const boost::filesystem::filesystem_error&)
+            { // inaccessible entry: treat it as a plain file
+            }
+            listing[itD->path().filename().string(qi::unicodeFacet())] = isDir;
+          }
+        }
+        catch (const boost::filesystem::filesystem_error&)
+        { // missing or unreadable directory: remember it as empty
+        }
+        it = _dirCache.insert(std::make_pair(key, listing)).first;
+      }
+      DirListing::const_iterator entry = it->second.find(name);
+      if (entry == it->second.end())
+        return Entry_Absent;
+      return entry->second ? Entry_Directory : Entry_File;
+    }
+
+    void invalidateCache()
+    {
+      boost::mutex::scoped_lock lock(_dirCacheMutex);
+      _dirCache.clear();
+    }
+
+    std::string existsFile(const boost::filesystem::path& prefix,
+                           const std::string& fileName)
+    {
+      const boost::filesystem::path file(fileName, qi::unicodeFacet());
+
+      try
+      {
+        const boost::filesystem::path pathFile(fsconcat(prefix.string(qi::unicodeFacet()),
+                                                        file.string(qi::unicodeFacet())),
+                                               qi::unicodeFacet());
+        const boost::filesystem::path pathFileSysComplete(boost::filesystem::system_complete(pathFile));
+
+        if (cachedEntryKind(pathFileSysComplete.parent_path(),
+                            pathFileSysComplete.filename().string(qi::unicodeFacet())) == Entry_File)
+          return (pathFileSysComplete.string(qi::unicodeFacet()));
+      }
+      catch (const boost::filesystem::filesystem_error &e)
+      {
+        qiLogError() << e.what();
+      }
+      return {};
+    }
+
+    // Cached equivalent of boost::filesystem::exists, file or directory.
+    bool pathExists(const boost::filesystem::path& p)
+    {
+      const boost::filesystem::path complete(boost::filesystem::system_complete(p));
+      const std::string name = complete.filename().string(qi::unicodeFacet());
+      if (name.empty() || name == "." || name == "..")
+        return boost::filesystem::exists(complete); // rare, not worth caching
+      return cachedEntryKind(complete.parent_path(), name) != Entry_Absent;
+    }
+
     void initSDKlayout()
     {
       std::string prefix = qi::Application::_suggestedSdkPath();
@@ -281,6 +373,7 @@ namespace detail {
       qiLogError() << e.what();
     }
     _p->_sdkPrefixes.push_back(prefixPath.string(qi::unicodeFacet()));
+    _p->invalidateCache();
   }
 
   void SDKLayout::clearOptionalSdkPrefix()
@@ -291,6 +384,12 @@ namespace detail {
       _p->_sdkPrefixes.clear();
       _p->_sdkPrefixes.push_back(sdkPrefixPath);
     }
+    _p->invalidateCache();
+  }
+
+  void SDKLayout::invalidateCache()
+  {
+    _p->invalidateCache();
   }
 
   std::string SDKLayout::sdkPrefix() const
@@ -305,29 +404,6 @@ namespace detail {
     return _p->_sdkPrefixes;
   }
 
-  static std::string existsFile(boost::filesystem::path prefix,
-                               const std::string& fileName)
-  {
-    const boost::filesystem::path file(fileName, qi::unicodeFacet());
-
-    try
-    {
-      const boost::filesystem::path pathFile(fsconcat(prefix.string(qi::unicodeFacet()),
-                                                      file.string(qi::unicodeFacet())),
-                                             qi::unicodeFacet());
-      const boost::filesystem::path pathFileSysComplete(boost::filesystem::system_complete(pathFile));
-
-      if (boost::filesystem::exists(pathFileSysComplete)
-          && !boost::filesystem::is_directory(pathFileSysComplete))
-        return (pathFileSysComplete.string(qi::unicodeFacet()));
-    }
-    catch (const boost::filesystem::filesystem_error &e)
-    {
-      qiLogError() << e.what();
-    }
-    return {};
-  }
-
   std::string SDKLayout::findBin(const std::string &name, bool searchInPath) const
   {
     try
@@ -342,17 +418,17 @@ namespace detail {
       {
         const boost::filesystem::path p(path / "bin");
 
-        std::string res = existsFile(p, name);
+        std::string res = _p->existsFile(p, name);
         if (!res.empty())
           return res;
 #ifdef _WIN32
 //DEBUG
 #ifndef NDEBUG
-        res = existsFile(p, name + "_d.exe");
+        res = _p->existsFile(p, name + "_d.exe");
         if (!res.empty())
           return res;
 #endif
-        res = existsFile(p, name + ".exe");
+        res = _p->existsFile(p, name + ".exe");
         if (!res.empty())
           return res;
 #endif
@@ -410,7 +486,7 @@ namespace detail {
       std::string libName = module.filename().make_preferred().string(qi::unicodeFacet());
       std::string res;
 
-      res = existsFile(prefix.string(qi::unicodeFacet()), libName);
+      res = _p->existsFile(prefix.string(qi::unicodeFacet()), libName);
       if (res != std::string())
         return res;
 
@@ -422,50 +498,50 @@ namespace detail {
         boost::filesystem::path p;
         p = boost::filesystem::path(fsconcat(*it, "lib", prefix.string(qi::unicodeFacet())), qi::unicodeFacet());
 
-        res = existsFile(p, libName);
+        res = _p->existsFile(p, libName);
         if (res != std::string())
           return res;
-        res = existsFile(p, libName + ".so");
+        res = _p->existsFile(p, libName + ".so");
         if (res != std::string())
           return res;
-        res = existsFile(p, "lib" + libName + ".so");
+        res = _p->existsFile(p, "lib" + libName + ".so");
         if (res != std::string())
           return res;
-        res = existsFile(p, "lib" + libName);
+        res = _p->existsFile(p, "lib" + libName);
         if (res != std::string())
           return res;
 #ifdef __APPLE__
-        res = existsFile(p, libName + ".dylib");
+        res = _p->existsFile(p, libName + ".dylib");
         if (res != std::string())
           return res;
-        res = existsFile(p, "lib" + libName + ".dylib");
+        res = _p->existsFile(p, "lib" + libName + ".dylib");
         if (res != std::string())
           return res;
-        res = existsFile(p, "lib" + libName);
+        res = _p->existsFile(p, "lib" + libName);
         if (res != std::string())
           return res;
 #endif
 #ifdef _WIN32
 //DEBUG
 #ifndef NDEBUG
-        res = existsFile(p, libName + "_d.dll");
+        res = _p->existsFile(p, libName + "_d.dll");
         if (res != std::string())
           return res;
-        res = existsFile(p, "lib" + libName + "_d.dll");
+        res = _p->existsFile(p, "lib" + libName + "_d.dll");
         if (res != std::string())
           return res;
-        res = existsFile(p, "lib" + libName);
+        res = _p->existsFile(p, "lib" + libName);
         if (res != std::string())
           return res;
 #endif
 
-        res = existsFile(p, libName + ".dll");
+        res = _p->existsFile(p, libName + ".dll");
         if (res != std::string())
           return res;
-        res = existsFile(p, "lib" + libName + ".dll");
+        res = _p->existsFile(p, "lib" + libName + ".dll");
         if (res != std::string())
           return res;
-        res = existsFile(p, "lib" + libName);
+        res = _p->existsFile(p, "lib" + libName);
         if (res != std::string())
           return res;
 
@@ -473,24 +549,24 @@ namespace detail {
         p = boost::filesystem::path(fsconcat(*it, "bin", prefix.string(qi::unicodeFacet())), qi::unicodeFacet());
 
 #ifndef NDEBUG
-        res = existsFile(p, libName + "_d.dll");
+        res = _p->existsFile(p, libName + "_d.dll");
         if (res != std::string())
           return res;
-        res = existsFile(p, "lib" + libName + "_d.dll");
+        res = _p->existsFile(p, "lib" + libName + "_d.dll");
         if (res != std::string())
           return res;
-        res = existsFile(p, "lib" + libName);
+        res = _p->existsFile(p, "lib" + libName);
         if (res != std::string())
           return res;
 #endif
 
-        res = existsFile(p, libName + ".dll");
+        res = _p->existsFile(p, libName + ".dll");
         if (res != std::string())
           return res;
-        res = existsFile(p, "lib" + libName + ".dll");
+        res = _p->existsFile(p, "lib" + libName + ".dll");
         if (res != std::string())
           return res;
-        res = existsFile(p, "lib" + libName);
+        res = _p->existsFile(p, "lib" + libName);
         if (res != std::string())
           return res;
 #endif
@@ -524,7 +600,7 @@ namespace detail {
         qiLogVerbose() << "Looking conf in " << *it;
         boost::filesystem::path p(fsconcat(*it, filename), qi::unicodeFacet());
 
-        if (boost::filesystem::exists(p))
+        if (_p->pathExists(p))
           return p.string(qi::unicodeFacet());
       }
     }
@@ -547,7 +623,7 @@ namespace detail {
       {
         boost::filesystem::path p(fsconcat(*it, filename), qi::unicodeFacet());
 
-        if (boost::filesystem::exists(p))
+        if (_p->pathExists(p))
           return p.string(qi::unicodeFacet());
       }
     }
@@ -746,6 +822,7 @@ namespace detail {
     qiLogVerbose() << "writable path set to " << path;
     boost::filesystem::path p(path, qi::unicodeFacet());
     _p->_writablePath = p.string(qi::unicodeFacet());
+    _p->invalidateCache();
   }
 
   std::string SDKLayout::userWritableDataPath(const std::string &applicationName,
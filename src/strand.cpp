@@ -3,6 +3,8 @@
 **  See COPYING for the license
 */
 #include <atomic>
+#include <thread>
+#include <vector>
 #include <boost/atomic.hpp>
 
 #include <ka/errorhandling.hpp>
@@ -30,6 +32,7 @@ namespace
   }
 
   static const auto dyingStrandMessage = "The strand is dying.";
+  static const auto mailboxFullMessage = "The strand pending task limit was reached.";
 }
 
 enum class StrandPrivate::State
@@ -41,7 +44,7 @@ enum class StrandPrivate::State
   // we don't care about finished state
 };
 
-struct StrandPrivate::Callback
+struct StrandPrivate::Callback : StrandPrivate::MpscNode
 {
   uint32_t id;
   State state;
@@ -49,8 +52,147 @@ struct StrandPrivate::Callback
   qi::Promise<void> promise;
   qi::Future<void> asyncFuture;
   ExecutionOptions executionOptions;
+  // Keeps the callback alive while it sits in the lock-free incoming queue,
+  // which links raw pointers; the consumer takes the reference back when
+  // draining. Broken by ~StrandPrivate for jobs that are never drained.
+  boost::shared_ptr<Callback> selfRef;
 };
 
+StrandPrivate::~StrandPrivate()
+{
+  // Jobs may remain in the incoming queue when the strand is destroyed
+  // without a full join (e.g. joined from inside its own context): take the
+  // self references out to break the ownership cycles.
+  for (MpscNode* node = _incomingHead; node != nullptr;)
+  {
+    MpscNode* next = node->next.load(std::memory_order_acquire);
+    if (node != &_incomingStub)
+      static_cast<Callback*>(node)->selfRef.reset();
+    node = next;
+  }
+}
+
+void StrandPrivate::pushIncoming(MpscNode* node)
+{
+  node->next.store(nullptr, std::memory_order_relaxed);
+  MpscNode* prev = _incomingTail.exchange(node, std::memory_order_acq_rel);
+  prev->next.store(node, std::memory_order_release);
+}
+
+void StrandPrivate::drainIncoming()
+{
+  for (;;)
+  {
+    MpscNode* head = _incomingHead;
+    MpscNode* next = head->next.load(std::memory_order_acquire);
+    if (head == &_incomingStub)
+    {
+      if (!next) // empty, or a producer is mid-push and will wake us up
+        return;
+      _incomingHead = next;
+      head = next;
+      next = head->next.load(std::memory_order_acquire);
+    }
+    if (!next)
+    {
+      if (head != _incomingTail.load(std::memory_order_acquire))
+        return; // a producer is mid-push right behind head; it will wake us
+      // head is the last node: cycle the stub back in so head becomes
+      // poppable again
+      pushIncoming(&_incomingStub);
+      next = head->next.load(std::memory_order_acquire);
+      if (!next)
+        return; // another push raced with the stub; that producer wakes us
+    }
+    _incomingHead = next;
+    _queue.push_back(std::move(static_cast<Callback*>(head)->selfRef));
+    --_pendingIncoming;
+  }
+}
+
+void StrandPrivate::scheduleProcessIfNeeded()
+{
+  if (!_processing.exchange(true))
+  {
+    qiLogDebug() << "StrandPrivate::process was not scheduled, doing it";
+    _executor.async(boost::bind(&StrandPrivate::process, shared_from_this()));
+  }
+}
+
+StrandPrivate::Admission StrandPrivate::admitTask()
+{
+  const size_t limit = _maxPendingTasks.load();
+  if (limit == 0)
+    return Admission::Accepted;
+  const auto policy = _overflowPolicy.load();
+  boost::recursive_mutex::scoped_lock lock(_mutex);
+  switch (policy)
+  {
+  case StrandOverflowPolicy::DropOldest:
+    while (_aliveCount >= limit && dropOldestTask())
+    {}
+    return Admission::Accepted;
+  case StrandOverflowPolicy::DropNewest:
+    return _aliveCount < limit ? Admission::Accepted : Admission::RejectedCanceled;
+  case StrandOverflowPolicy::Fail:
+    return _aliveCount < limit ? Admission::Accepted : Admission::RejectedError;
+  case StrandOverflowPolicy::Block:
+    // Blocking the strand's own thread would deadlock it: tasks scheduled
+    // from inside the strand are always admitted.
+    if (isInThisContext())
+      return Admission::Accepted;
+    while (_aliveCount >= limit && !_dying)
+      _mailboxFreed.wait(lock);
+    return Admission::Accepted;
+  }
+  return Admission::Accepted;
+}
+
+bool StrandPrivate::dropOldestTask()
+{
+  while (!_submissionOrder.empty())
+  {
+    boost::shared_ptr<Callback> cbStruct = _submissionOrder.front().lock();
+    _submissionOrder.pop_front();
+    if (!cbStruct)
+      continue;
+    // Tasks that must run even when canceled cannot be dropped either.
+    if (cbStruct->executionOptions.onCancelRequested == CancelOption::NeverSkipExecution)
+      continue;
+    switch (cbStruct->state)
+    {
+    case State::None:
+      // Not enqueued yet: also cancel its pending delay timer.
+      cbStruct->asyncFuture.cancel();
+      break;
+    case State::Scheduled:
+      break;
+    default:
+      continue; // running, done or already canceled
+    }
+    qiLogDebug() << "Mailbox full, dropping oldest job id " << cbStruct->id;
+    cbStruct->state = State::Canceled;
+    --_aliveCount;
+    cbStruct->promise.setError(std::string(mailboxFullMessage) + " The oldest task was dropped.");
+    _mailboxFreed.notify_all();
+    return true;
+  }
+  return false;
+}
+
+void StrandPrivate::recordSubmission(const boost::shared_ptr<Callback>& cbStruct)
+{
+  if (_maxPendingTasks.load() == 0
+      || _overflowPolicy.load() != StrandOverflowPolicy::DropOldest)
+    return;
+  boost::recursive_mutex::scoped_lock lock(_mutex);
+  // Entries of executed tasks expire on their own; prune the front so the
+  // deque does not grow forever.
+  while (!_submissionOrder.empty() && _submissionOrder.front().expired())
+    _submissionOrder.pop_front();
+  _submissionOrder.push_back(cbStruct);
+}
+
 boost::shared_ptr<StrandPrivate::Callback> StrandPrivate::createCallback(boost::function<void()> cb, ExecutionOptions options)
 {
   ++_aliveCount;
@@ -79,28 +221,49 @@ Future<void> StrandPrivate::asyncDelayImpl(boost::function<void()> cb, qi::Durat
 
 Future<void> StrandPrivate::deferImpl(boost::function<void()> cb, qi::Duration delay, ExecutionOptions options)
 {
+  switch (admitTask())
+  {
+  case Admission::RejectedError:
+    return makeFutureError<void>(mailboxFullMessage);
+  case Admission::RejectedCanceled:
+  {
+    Promise<void> promise;
+    promise.setCanceled();
+    return promise.future();
+  }
+  case Admission::Accepted:
+    break;
+  }
+
   boost::shared_ptr<Callback> cbStruct = createCallback(std::move(cb), options);
+  recordSubmission(cbStruct);
   cbStruct->promise = qi::Promise<void>(boost::bind(&StrandPrivate::cancel, this, cbStruct));
 
   qiLogDebug() << "Deferring job id " << cbStruct->id << " in " << qi::to_string(delay);
+  qi::Future<void> future = cbStruct->promise.future();
   if (delay.count())
     cbStruct->asyncFuture = _executor.asyncDelay(boost::bind( &StrandPrivate::enqueue, this, cbStruct, options),
                                                   delay, options);
   else
-    enqueue(cbStruct, options);
-  return cbStruct->promise.future();
+    enqueueImmediate(std::move(cbStruct));
+  return future;
 }
 
 void StrandPrivate::enqueue(boost::shared_ptr<Callback> cbStruct, ExecutionOptions options)
 {
-  const bool shouldschedule = [&]()
+  // This is the deferred-job path: the caller already owns the future, so
+  // cancel() may race with us and the state must be inspected under the lock.
+  const bool pushed = [&]()
   {
     boost::recursive_mutex::scoped_lock lock(_mutex);
     qiLogDebug() << "Enqueueing job id " << cbStruct->id;
 
     auto scheduleCallback = [&] {
-      _queue.push_back(cbStruct);
       cbStruct->state = State::Scheduled;
+      Callback* node = cbStruct.get();
+      node->selfRef = cbStruct;
+      ++_pendingIncoming;
+      pushIncoming(node);
     };
 
     // the callback may have been canceled
@@ -130,22 +293,36 @@ void StrandPrivate::enqueue(boost::shared_ptr<Callback> cbStruct, ExecutionOptio
         return false;
       }
     }
-    // if process was not scheduled yet, do it, there is work to do
-    if (!_processing)
-    {
-      qiLogDebug() << "Schedule process on job id " << cbStruct->id;
-      _processing = true;
-      return true;
-    }
-
-    return false;
+    return true;
   }();
 
-  if (shouldschedule)
+  if (pushed)
+    scheduleProcessIfNeeded();
+}
+
+void StrandPrivate::enqueueImmediate(boost::shared_ptr<Callback> cbStruct)
+{
+  qiLogDebug() << "Enqueueing job id " << cbStruct->id;
+
+  // Zero-delay path: the job is not visible to any other thread yet (its
+  // future has not been returned to the caller), so no cancellation can race
+  // with us and no lock is needed; the release in pushIncoming publishes the
+  // state change.
+  ++_inFlightEnqueues;
+  if (_dying.load())
   {
-    qiLogDebug() << "StrandPrivate::process was not scheduled, doing it";
-    _executor.async(boost::bind(&StrandPrivate::process, shared_from_this()), options);
+    --_inFlightEnqueues;
+    cbStruct->promise.setError(dyingStrandMessage);
+    qiLogDebug() << "Strand is dying on job id " << cbStruct->id;
+    return;
   }
+  cbStruct->state = State::Scheduled;
+  Callback* node = cbStruct.get();
+  node->selfRef = std::move(cbStruct);
+  ++_pendingIncoming;
+  pushIncoming(node);
+  scheduleProcessIfNeeded();
+  --_inFlightEnqueues;
 }
 
 void StrandPrivate::stopProcess(boost::recursive_mutex::scoped_lock& lock,
@@ -169,6 +346,13 @@ void StrandPrivate::process()
 {
   static const unsigned int QI_STRAND_QUANTUM_US =
     qi::os::getEnvDefault<unsigned int>("QI_STRAND_QUANTUM_US", 5000);
+  // Jobs popped under a single lock acquisition. Dense bursts of small jobs
+  // used to pay one mutex round trip each; popping them by batches divides
+  // that cost while keeping FIFO order. Jobs in the current batch count as
+  // running: cancellation is too late for them, as it already was for the
+  // job being executed.
+  static const unsigned int QI_STRAND_BATCH_SIZE =
+    qi::os::getEnvDefault<unsigned int>("QI_STRAND_BATCH_SIZE", 16);
 
   qiLogDebug() << "StrandPrivate::process started";
 
@@ -176,9 +360,10 @@ void StrandPrivate::process()
 
   qi::SteadyClockTimePoint start = qi::SteadyClock::now();
 
+  std::vector<boost::shared_ptr<Callback>> batch;
   do
   {
-    boost::shared_ptr<Callback> cbStruct;
+    batch.clear();
     {
       boost::recursive_mutex::scoped_lock lock(_mutex);
       if (_dying)
@@ -188,41 +373,57 @@ void StrandPrivate::process()
       }
 
       QI_ASSERT(_processing);
+      drainIncoming();
       if (_queue.empty())
       {
         qiLogDebug() << "Queue empty, stopping";
         stopProcess(lock, true);
         _processingThread = 0;
+        lock.unlock();
+        // A producer may have pushed between the drain above and _processing
+        // being cleared, and seen it still true: recover its lost wakeup.
+        // _pendingIncoming is counted before the push, so it also covers
+        // jobs that are not poppable yet because their producer is mid-push.
+        if (_pendingIncoming.load() != 0)
+          scheduleProcessIfNeeded();
         return;
       }
-      cbStruct = _queue.front();
-      _queue.pop_front();
-      if (cbStruct->state == State::Scheduled
-      || (cbStruct->state == State::Canceled && cbStruct->executionOptions.onCancelRequested == CancelOption::NeverSkipExecution))
+      while (!_queue.empty() && batch.size() < QI_STRAND_BATCH_SIZE)
       {
-        --_aliveCount;
-        cbStruct->state = State::Running;
+        boost::shared_ptr<Callback> cbStruct = _queue.front();
+        _queue.pop_front();
+        if (cbStruct->state == State::Scheduled
+        || (cbStruct->state == State::Canceled && cbStruct->executionOptions.onCancelRequested == CancelOption::NeverSkipExecution))
+        {
+          --_aliveCount;
+          cbStruct->state = State::Running;
+          batch.push_back(std::move(cbStruct));
+        }
+        else
+        {
+          // Job was canceled, cancel() already has done --_aliveCount
+          qiLogDebug() << "Abandoning job id " << cbStruct->id
+            << ", state: " << static_cast<int>(cbStruct->state);
+        }
       }
-      else
-      {
-        // Job was canceled, cancel() already has done --_aliveCount
-        qiLogDebug() << "Abandoning job id " << cbStruct->id
-          << ", state: " << static_cast<int>(cbStruct->state);
-        continue;
-      }
-    }
-    qiLogDebug() << "Executing job id " << cbStruct->id;
-    try {
-      cbStruct->callback();
-      cbStruct->promise.setValue(0);
+      if (!batch.empty())
+        _mailboxFreed.notify_all();
     }
-    catch (std::exception& e) {
-      cbStruct->promise.setError(e.what());
-    }
-    catch (...) {
-      cbStruct->promise.setError("callback has thrown in strand");
+    for (const auto& cbStruct: batch)
+    {
+      qiLogDebug() << "Executing job id " << cbStruct->id;
+      try {
+        cbStruct->callback();
+        cbStruct->promise.setValue(0);
+      }
+      catch (std::exception& e) {
+        cbStruct->promise.setError(e.what());
+      }
+      catch (...) {
+        cbStruct->promise.setError("callback has thrown in strand");
+      }
+      qiLogDebug() << "Finished job id " << cbStruct->id;
     }
-    qiLogDebug() << "Finished job id " << cbStruct->id;
   } while (qi::SteadyClock::now() - start < qi::MicroSeconds(QI_STRAND_QUANTUM_US));
 
   _processingThread = 0;
@@ -247,31 +448,19 @@ void StrandPrivate::cancel(boost::shared_ptr<Callback> cbStruct)
       {
         --_aliveCount;
         cbStruct->promise.setCanceled();
+        _mailboxFreed.notify_all();
       }
       break;
     case State::Scheduled:
-      qiLogDebug() << "Was scheduled, removing it from queue";
+      // The job may sit in the lock-free incoming queue where we cannot
+      // erase it: mark it canceled and let the processing thread drop it.
+      qiLogDebug() << "Was scheduled, will be dropped by the processing thread";
+      cbStruct->state = State::Canceled;
       if (cbStruct->executionOptions.onCancelRequested != CancelOption::NeverSkipExecution)
       {
-        bool erased = false;
-        for (Queue::iterator iter = _queue.begin(); iter != _queue.end(); ++iter)
-          if ((*iter)->id == cbStruct->id)
-          {
-            _queue.erase(iter);
-            erased = true;
-            break;
-          }
-        // state was scheduled, so the callback must be there
-        QI_ASSERT(erased);
-        // Silence compile warning unused erased
-        (void)erased;
-
         --_aliveCount;
         cbStruct->promise.setCanceled();
-      }
-      else
-      {
-        cbStruct->state = State::Canceled;
+        _mailboxFreed.notify_all();
       }
       break;
     default:
@@ -319,10 +508,12 @@ void Strand::join()
 
   {
     boost::unique_lock<boost::recursive_mutex> lock(_p->_mutex);
-    qiLogVerbose() << this << " joining (processing: " << _p->_processing
+    qiLogVerbose() << this << " joining (processing: " << _p->_processing.load()
       << ", size: " << _p->_aliveCount << ")";
 
     _p->_dying = true;
+    // Release producers blocked by the block-on-overflow policy.
+    _p->_mailboxFreed.notify_all();
 
     if (isInThisContext())
     {
@@ -333,7 +524,15 @@ void Strand::join()
 
     boost::atomic_exchange(&prv, _p);
 
+    // Wait out producers that were already past the dying check in
+    // enqueueImmediate; the window is a handful of instructions.
+    while (prv->_inFlightEnqueues.load() != 0)
+      std::this_thread::yield();
+
     prv->_processFinished.wait(lock, [&]{ return !prv->_processing; });
+    // We are the only consumer left: move what remains of the incoming queue
+    // into _queue so the loop below can resolve the promises.
+    prv->drainIncoming();
     while (!prv->_queue.empty())
     {
       auto task = std::move(prv->_queue.front());
@@ -405,17 +604,42 @@ void Strand::postImpl(boost::function<void()> callback, ExecutionOptions options
   auto prv = boost::atomic_load(&_p);
   if (prv)
   {
+    if (prv->admitTask() != StrandPrivate::Admission::Accepted)
+    {
+      // As no future is returned, rejection can only be reported in the log.
+      qiLogWarning() << "Task posted on a full strand was dropped.";
+      return;
+    }
     // As no future will be returned, we need to at least log the user if a problem occured.
-    prv->enqueue(prv->createCallback([=] {
+    auto cbStruct = prv->createCallback([=] {
       auto errorLogger = ka::compose([](const std::string& msg) {
         qiLogWarning() << "Uncaught error in task posted in a strand: " << msg;
       }, ka::exception_message{});
 
       ka::invoke_catch(std::move(errorLogger), callback);
-    }, options), options);
+    }, options);
+    prv->recordSubmission(cbStruct);
+    prv->enqueue(std::move(cbStruct), options);
   }
 }
 
+void Strand::setMaxPendingTasks(size_t limit, OverflowPolicy policy)
+{
+  auto prv = boost::atomic_load(&_p);
+  if (!prv)
+    return;
+  // Store the policy first so that a producer seeing the new limit also sees
+  // the policy that comes with it.
+  prv->_overflowPolicy.store(policy);
+  prv->_maxPendingTasks.store(limit);
+}
+
+size_t Strand::pendingTaskCount() const
+{
+  auto prv = boost::atomic_load(&_p);
+  return prv ? static_cast<size_t>(prv->_aliveCount.load()) : 0u;
+}
+
 Future<void> Strand::defer(const boost::function<void ()>& cb, MicroSeconds delay, ExecutionOptions options)
 {
   auto prv = boost::atomic_load(&_p);
@@ -86,10 +86,11 @@ namespace log
     {
       fseek(_p->_file, 0, SEEK_END);
 
-      std::string logline =
-          qi::detail::logline(qi::log::context(), date, systemDate, category, msg, file, fct, line, verb);
-      _p->_writeSize += fprintf(_p->_file, "%s", logline.c_str());
+      std::string* logline = detail::acquireLogBuffer();
+      qi::detail::logline(*logline, qi::log::context(), date, systemDate, category, msg, file, fct, line, verb);
+      _p->_writeSize += fprintf(_p->_file, "%s", logline->c_str());
       fflush(_p->_file);
+      detail::releaseLogBuffer(logline);
     }
 
     if (_p->_writeSize > FILESIZEMAX)
@@ -0,0 +1,49 @@
+#pragma once
+/*
+ * Copyright (c) 2018 Softbank Robotics. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the COPYING file.
+ */
+
+#ifndef _SRC_TRACE_P_HPP_
+#define _SRC_TRACE_P_HPP_
+
+/* Static tracepoints for the RPC hot path.
+ *
+ * On Linux with the systemtap headers installed, the QI_TRACEn macros expand
+ * to USDT probes under the "qi" provider: a single nop instruction plus an
+ * ELF note, so they cost nothing until a tracer (perf, bpftrace, systemtap)
+ * attaches to them. Everywhere else they expand to nothing.
+ *
+ * List the probes with:
+ *   readelf -n libqi.so | grep -A2 qi
+ * and attach with e.g.:
+ *   bpftrace -e 'usdt:libqi.so:qi:message_dispatch { @[arg2] = count(); }'
+ *
+ * Probe arguments must stay cheap to evaluate: they are computed even when no
+ * tracer is attached, so only pass values that are already at hand (ids,
+ * sizes, pointers), never anything that formats or allocates.
+ */
+
+#if defined(__linux__) && defined(__has_include)
+#  if __has_include(<sys/sdt.h>)
+#    define QI_HAS_SDT 1
+#  endif
+#endif
+
+#ifdef QI_HAS_SDT
+#  include <sys/sdt.h>
+#  define QI_TRACE0(name)                 DTRACE_PROBE(qi, name)
+#  define QI_TRACE1(name, a)              DTRACE_PROBE1(qi, name, a)
+#  define QI_TRACE2(name, a, b)           DTRACE_PROBE2(qi, name, a, b)
+#  define QI_TRACE3(name, a, b, c)        DTRACE_PROBE3(qi, name, a, b, c)
+#  define QI_TRACE4(name, a, b, c, d)     DTRACE_PROBE4(qi, name, a, b, c, d)
+#else
+#  define QI_TRACE0(name)                 do {} while (false)
+#  define QI_TRACE1(name, a)              do {} while (false)
+#  define QI_TRACE2(name, a, b)           do {} while (false)
+#  define QI_TRACE3(name, a, b, c)        do {} while (false)
+#  define QI_TRACE4(name, a, b, c, d)     do {} while (false)
+#endif
+
+#endif  // _SRC_TRACE_P_HPP_
@@ -4,16 +4,30 @@
  * found in the COPYING file.
  */
 
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <vector>
+
 #include <boost/filesystem/fstream.hpp>
 
 #include <boost/filesystem.hpp>
 #include <boost/locale.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/make_shared.hpp>
 #include <boost/thread/mutex.hpp>
 
 #include <qi/translator.hpp>
 #include <qi/path.hpp>
 #include <qi/log.hpp>
 
+#ifndef _WIN32
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <unistd.h>
+#endif
+
 #include "utils.hpp"
 
 qiLogCategory("qi.translator");
@@ -22,6 +36,135 @@ namespace bfs = boost::filesystem;
 
 namespace qi
 {
+  /* Compiled dictionary format (little-endian):
+   *   Header, then bucketCount Buckets, then a string blob. Buckets form an
+   *   open-addressed hash table (linear probing, power-of-two size, load
+   *   factor <= 0.5); a zero hash marks an empty bucket. Offsets are
+   *   relative to the start of the blob. The file is mapped read-only so
+   *   every process translating from the same catalog shares the pages.
+   */
+  namespace dict
+  {
+    static const uint32_t magicValue = 0x71694454u; // "qiDT"
+    static const uint32_t versionValue = 1u;
+
+    struct Header
+    {
+      uint32_t magic;
+      uint32_t version;
+      uint32_t bucketCount;
+      uint32_t entryCount;
+    };
+
+    struct Bucket
+    {
+      uint64_t hash;
+      uint32_t keyOffset;
+      uint32_t keySize;
+      uint32_t valueOffset;
+      uint32_t valueSize;
+    };
+
+    // FNV-1a; never returns 0, which is reserved for empty buckets.
+    static uint64_t hashKey(const std::string &key)
+    {
+      uint64_t h = 14695981039346656037ull;
+      for (size_t i = 0; i < key.size(); ++i)
+      {
+        h ^= static_cast<unsigned char>(key[i]);
+        h *= 1099511628211ull;
+      }
+      return h ? h : 1u;
+    }
+
+#ifndef _WIN32
+    class MappedDictionary
+    {
+    public:
+      explicit MappedDictionary(const std::string &path)
+      {
+        const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+          return;
+        struct stat st;
+        if (::fstat(fd, &st) != 0 ||
+            static_cast<size_t>(st.st_size) < sizeof(Header))
+        {
+          ::close(fd);
+          return;
+        }
+        const size_t size = static_cast<size_t>(st.st_size);
+        void *map = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (map == MAP_FAILED)
+          return;
+
+        const Header *header = static_cast<const Header*>(map);
+        const size_t tableSize =
+          sizeof(Header) + sizeof(Bucket) * static_cast<size_t>(header->bucketCount);
+        if (header->magic != magicValue || header->version != versionValue ||
+            header->bucketCount == 0 ||
+            (header->bucketCount & (header->bucketCount - 1)) != 0 ||
+            tableSize > size)
+        {
+          qiLogWarning() << "Ignoring invalid compiled dictionary " << path;
+          ::munmap(map, size);
+          return;
+        }
+        _map = map;
+        _size = size;
+        _header = header;
+        _buckets = reinterpret_cast<const Bucket*>(
+            static_cast<const char*>(map) + sizeof(Header));
+        _blob = static_cast<const char*>(map) + tableSize;
+        _blobSize = size - tableSize;
+      }
+
+      ~MappedDictionary()
+      {
+        if (_map)
+          ::munmap(_map, _size);
+      }
+
+      bool valid() const
+      {
+        return _map != nullptr;
+      }
+
+      bool lookup(const std::string &key, std::string &translation) const
+      {
+        const uint64_t h = hashKey(key);
+        const uint32_t mask = _header->bucketCount - 1;
+        uint32_t i = static_cast<uint32_t>(h) & mask;
+        for (uint32_t probes = 0; probes <= mask; ++probes, i = (i + 1) & mask)
+        {
+          const Bucket &b = _buckets[i];
+          if (b.hash == 0)
+            return false;
+          if (b.hash != h || b.keySize != key.size())
+            continue;
+          if (static_cast<size_t>(b.keyOffset) + b.keySize > _blobSize ||
+              static_cast<size_t>(b.valueOffset) + b.valueSize > _blobSize)
+            return false;
+          if (std::memcmp(_blob + b.keyOffset, key.data(), key.size()) != 0)
+            continue;
+          translation.assign(_blob + b.valueOffset, b.valueSize);
+          return true;
+        }
+        return false;
+      }
+
+    private:
+      void *_map = nullptr;
+      size_t _size = 0;
+      const Header *_header = nullptr;
+      const Bucket *_buckets = nullptr;
+      const char *_blob = nullptr;
+      size_t _blobSize = 0;
+    };
+#endif
+  } // !dict
+
   static qi::Translator *globTranslator = nullptr;
 
   Translator &defaultTranslator(const std::string &name)
@@ -118,6 +261,58 @@ namespace qi
         fd << *itPaths << std::endl;
       }
     }
+
+    std::string dictionaryKey(const std::string &context,
+                              const std::string &msg)
+    {
+      if (context.empty())
+        return msg;
+      // Same separator gettext uses between msgctxt and msgid.
+      return context + '\4' + msg;
+    }
+
+    bool compileDictionary(const std::string &path,
+                           const std::map<std::string, std::string> &messages)
+    {
+      uint32_t bucketCount = 8;
+      while (bucketCount < messages.size() * 2)
+        bucketCount *= 2;
+
+      std::vector<dict::Bucket> buckets(bucketCount, dict::Bucket());
+      std::string blob;
+      const uint32_t mask = bucketCount - 1;
+      std::map<std::string, std::string>::const_iterator it;
+      for (it = messages.begin(); it != messages.end(); ++it)
+      {
+        dict::Bucket b;
+        b.hash = dict::hashKey(it->first);
+        b.keyOffset = static_cast<uint32_t>(blob.size());
+        b.keySize = static_cast<uint32_t>(it->first.size());
+        blob += it->first;
+        b.valueOffset = static_cast<uint32_t>(blob.size());
+        b.valueSize = static_cast<uint32_t>(it->second.size());
+        blob += it->second;
+
+        uint32_t i = static_cast<uint32_t>(b.hash) & mask;
+        while (buckets[i].hash != 0)
+          i = (i + 1) & mask;
+        buckets[i] = b;
+      }
+
+      dict::Header header;
+      header.magic = dict::magicValue;
+      header.version = dict::versionValue;
+      header.bucketCount = bucketCount;
+      header.entryCount = static_cast<uint32_t>(messages.size());
+
+      boost::filesystem::ofstream out(bfs::path(path, qi::unicodeFacet()),
+                                      std::ios::binary | std::ios::trunc);
+      out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+      out.write(reinterpret_cast<const char*>(buckets.data()),
+                sizeof(dict::Bucket) * buckets.size());
+      out.write(blob.data(), blob.size());
+      return out.good();
+    }
   } // !detail
 
 
@@ -167,14 +362,60 @@ namespace qi
            ++dPathIt)
       {
         generator.add_messages_path(*dPathIt);
+        messagesPaths.push_back(*dPathIt);
       }
     }
 
+#ifndef _WIN32
+    // Returns the compiled dictionary of this domain and locale, mapping it
+    // on first use, or null when none was compiled. Caller must hold mutex;
+    // absent dictionaries are cached too so each one is probed only once.
+    const dict::MappedDictionary *dictionary(const std::string &domain,
+                                             const std::string &locale)
+    {
+      // Directory layout mirrors the .mo catalogs: the locale directory has
+      // no encoding suffix.
+      std::string localeDir = locale;
+      const size_t dot = localeDir.find('.');
+      if (dot != std::string::npos)
+        localeDir.erase(dot);
+
+      const std::string key = domain + '/' + localeDir;
+      DictionaryMap::const_iterator it = dictionaries.find(key);
+      if (it != dictionaries.end())
+        return it->second.get();
+
+      boost::shared_ptr<dict::MappedDictionary> found;
+      for (std::vector<std::string>::const_iterator pathIt = messagesPaths.begin();
+           pathIt != messagesPaths.end();
+           ++pathIt)
+      {
+        const qi::Path dictPath = qi::Path(*pathIt) / localeDir / "LC_MESSAGES"
+          / (domain + ".qdic");
+        boost::shared_ptr<dict::MappedDictionary> candidate =
+          boost::make_shared<dict::MappedDictionary>(dictPath.str());
+        if (candidate->valid())
+        {
+          found = candidate;
+          break;
+        }
+      }
+      dictionaries[key] = found;
+      return found.get();
+    }
+#endif
+
   public:
     boost::mutex             mutex;
     boost::locale::generator generator;
     std::string              currentLocale;
     std::string              currentDomain;
+    std::vector<std::string> messagesPaths;
+#ifndef _WIN32
+    using DictionaryMap =
+      std::map<std::string, boost::shared_ptr<dict::MappedDictionary>>;
+    DictionaryMap            dictionaries;
+#endif
   };
 
 
@@ -240,6 +481,15 @@ namespace qi
     if (loc.find(".UTF-8") == std::string::npos)
       loc += ".UTF-8";
 
+#ifndef _WIN32
+    if (const dict::MappedDictionary *dict = _p->dictionary(dom, loc))
+    {
+      std::string translation;
+      if (dict->lookup(qi::detail::dictionaryKey(context, msg), translation))
+        return translation;
+    }
+#endif
+
     if (domain.empty())
       return boost::locale::translate(context, msg).str(_p->generator(loc));
     else
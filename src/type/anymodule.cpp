@@ -5,8 +5,10 @@
 #include <qi/path.hpp>
 #include <ka/scoped.hpp>
 #include <boost/algorithm/string/replace.hpp>
+#include <boost/algorithm/string/split.hpp>
 #include <boost/algorithm/cxx11/all_of.hpp>
 #include <boost/filesystem/fstream.hpp>
+#include <boost/thread/thread.hpp>
 
 #ifdef _WIN32
   #include <Windows.h>
@@ -124,8 +126,34 @@ namespace qi
     return true;
   }
 
+  // Name -> info read from the .mod files. Built by a single scan of the
+  // qi/module data directories on the first import, so later imports do not
+  // walk the search paths again.
+  using ModuleInfoMap = std::map<std::string, ModuleInfo>;
+  static ModuleInfoMap* gModuleIndex = NULL;
+
+  static const ModuleInfo* findModuleInIndex(const std::string& name) {
+    boost::recursive_mutex::scoped_lock sl(*gMutexLoading);
+    if (!gModuleIndex)
+    {
+      gModuleIndex = new ModuleInfoMap;
+      const std::vector<ModuleInfo> modules = listModules();
+      for (const ModuleInfo& mi: modules)
+        (*gModuleIndex)[mi.name] = mi;
+      qiLogVerbose() << "indexed " << gModuleIndex->size() << " modules";
+    }
+    ModuleInfoMap::const_iterator it = gModuleIndex->find(name);
+    if (it == gModuleIndex->end())
+      return NULL;
+    return &it->second;
+  }
+
   static ModuleInfo findModuleInFs(const std::string& name) {
-    //lookup for module in
+    if (const ModuleInfo* indexed = findModuleInIndex(name))
+      return *indexed;
+
+    // Not indexed: the module may have been installed after the index was
+    // built, probe the search paths for it directly.
     const qi::Path p(qi::path::findData("qi/module", name + ".mod"));
 
     //TODO: throwing seriously?
@@ -138,6 +166,10 @@ namespace qi
     is >> mi.type;
 
     qiLogVerbose() << "type: '" << mi.type << "'";
+    {
+      boost::recursive_mutex::scoped_lock sl(*gMutexLoading);
+      (*gModuleIndex)[name] = mi;
+    }
     return mi;
   }
 
@@ -220,5 +252,37 @@ namespace qi
     return mb.module();
   }
 
+  // Modules listed in QI_MODULE_PRELOAD (separated by the platform path
+  // separator or commas) are imported from a background thread when the
+  // application starts, so the first user of such a module does not pay the
+  // directory scan, dlopen and registration on its own path.
+  static void preloadModules()
+  {
+    const std::string preload = qi::os::getenv("QI_MODULE_PRELOAD");
+    if (preload.empty())
+      return;
+    std::vector<std::string> names;
+    const char pathSep = qi::os::pathsep()[0];
+    boost::algorithm::split(names, preload,
+                            [&](char c) { return c == pathSep || c == ','; });
+    boost::thread([names] {
+      for (const std::string& name: names)
+      {
+        if (name.empty())
+          continue;
+        try
+        {
+          import(name);
+          qiLogVerbose() << "preloaded module " << name;
+        }
+        catch (const std::exception& e)
+        {
+          qiLogWarning() << "failed to preload module " << name << ": " << e.what();
+        }
+      }
+    }).detach();
+  }
+  QI_AT_ENTER(&preloadModules)
+
 }
 QI_REGISTER_MODULE_FACTORY("cpp", &qi::loadCppModule);
@@ -4,6 +4,8 @@
 */
 
 #include <qi/anyobject.hpp>
+#include <qi/clock.hpp>
+#include <qi/type/detail/tracering.hpp>
 #include <memory>
 
 #ifdef _MSC_VER
@@ -134,6 +136,28 @@ inline void call(qi::Promise<AnyReference>& out,
       0,0, callerContext, qi::os::gettid(), postTimestamp));
   }
 
+  // Always-on binary tracing. Unlike the signal path above it records no
+  // arguments and dispatches nothing, so it is cheap enough to stay enabled
+  // in production (see TraceRing).
+  TraceRing& ring = TraceRing::instance();
+  const bool ringTrace = ring.enabled();
+  uint32_t ringTid = 0;
+  uint32_t calleeTid = 0;
+  if (ringTrace)
+  {
+    ringTid = trace ? static_cast<uint32_t>(tid) : ring.nextId();
+    calleeTid = static_cast<uint32_t>(qi::os::gettid());
+    TraceRecord record;
+    record.id = ringTid;
+    record.kind = EventTrace::Event_Call;
+    record.slotId = methodId;
+    record.callerContext = callerContext;
+    record.calleeContext = calleeTid;
+    record.timestampUs = boost::chrono::duration_cast<MicroSeconds>(
+        SteadyClock::now().time_since_epoch()).count();
+    ring.push(record);
+  }
+
   qi::int64_t time = stats?qi::os::ustime():0;
   std::pair<int64_t, int64_t> cputime, cpuendtime;
   if (stats||trace)
@@ -176,6 +200,25 @@ inline void call(qi::Promise<AnyReference>& out,
                        (float)cpuendtime.second / 1e6f);
 
 
+  if (ringTrace)
+  {
+    TraceRecord record;
+    record.id = ringTid;
+    record.kind = success ? EventTrace::Event_Result : EventTrace::Event_Error;
+    record.slotId = methodId;
+    record.callerContext = callerContext;
+    record.calleeContext = calleeTid;
+    record.timestampUs = boost::chrono::duration_cast<MicroSeconds>(
+        SteadyClock::now().time_since_epoch()).count();
+    if (stats || trace)
+    { // cpu times were only sampled for the heavier paths: do not pay two
+      // extra cputime() syscalls just for the ring.
+      record.userUsTime = cpuendtime.first;
+      record.systemUsTime = cpuendtime.second;
+    }
+    ring.push(record);
+  }
+
   if (trace)
   {
     qi::os::timeval tv(qi::SystemClock::now().time_since_epoch());
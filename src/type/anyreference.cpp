@@ -3,9 +3,13 @@
 **  See COPYING for the license
 */
 
+#include <algorithm>
+#include <map>
+
 #include <boost/lexical_cast.hpp>
 #include <boost/algorithm/string.hpp>
 #include <boost/range/algorithm/transform.hpp>
+#include <boost/thread/mutex.hpp>
 
 #include <qi/type/detail/anyreference.hpp>
 #include <qi/anyobject.hpp>
@@ -369,40 +373,105 @@ namespace detail
     return ret;
   }
 
+  namespace
+  {
+    /// Name-based field mapping between two struct types.
+    ///
+    /// Everything here only depends on the (source, target) type pair, which
+    /// is stable for a given method binding, so plans are computed on the
+    /// first conversion and reused by all subsequent ones: executing a
+    /// memoized plan skips the member name/type enumeration and the
+    /// quadratic name matching.
+    struct StructFieldPlan
+    {
+      bool valid = false; // both structs were fully named
+      std::vector<std::string> srcNames;
+      std::vector<std::string> dstNames;
+      std::vector<TypeInterface*> srcTypes;
+      std::vector<TypeInterface*> dstTypes;
+      std::vector<int> fieldMap; // fieldMap[i] = index of src's field i in dst (-1 for not present)
+      std::vector<std::tuple<std::string, TypeInterface*>> fieldMissing; // unfilled dst fields
+      // True when the structs have the same field count and names (up to
+      // ordering, or when one side is unnamed): such pairs convert field by
+      // field in order, without going through the name-based converter.
+      bool sameShape = false;
+    };
+
+    const StructFieldPlan& structFieldPlan(StructTypeInterface* tsrc, StructTypeInterface* tdst)
+    {
+      static boost::mutex mutex;
+      static std::map<std::pair<TypeInterface*, TypeInterface*>, StructFieldPlan> plans;
+      boost::mutex::scoped_lock lock(mutex);
+      const auto inserted =
+          plans.emplace(std::make_pair(static_cast<TypeInterface*>(tsrc),
+                                       static_cast<TypeInterface*>(tdst)),
+                        StructFieldPlan{});
+      StructFieldPlan& plan = inserted.first->second;
+      if (!inserted.second)
+        return plan; // already compiled
+      plan.srcNames = tsrc->elementsName();
+      plan.dstNames = tdst->elementsName();
+      plan.srcTypes = tsrc->memberTypes();
+      plan.dstTypes = tdst->memberTypes();
+      if (plan.srcTypes.size() == plan.dstTypes.size())
+      {
+        const bool fullyNamed = plan.srcNames.size() == plan.srcTypes.size() &&
+                                plan.dstNames.size() == plan.dstTypes.size();
+        if (!fullyNamed)
+          plan.sameShape = true;
+        else
+        {
+          std::vector<std::string> sortedSrc = plan.srcNames;
+          std::vector<std::string> sortedDst = plan.dstNames;
+          std::sort(sortedSrc.begin(), sortedSrc.end());
+          std::sort(sortedDst.begin(), sortedDst.end());
+          plan.sameShape = (sortedSrc == sortedDst);
+        }
+      }
+      if (plan.srcTypes.size() != plan.srcNames.size() ||
+          plan.dstTypes.size() != plan.dstNames.size())
+        return plan; // stays invalid
+      plan.valid = true;
+      for (unsigned i = 0; i < plan.srcNames.size(); ++i)
+      {
+        const auto it = std::find(plan.dstNames.begin(), plan.dstNames.end(), plan.srcNames[i]);
+        if (it != plan.dstNames.end())
+          plan.fieldMap.push_back(static_cast<int>(it - plan.dstNames.begin()));
+        else
+          plan.fieldMap.push_back(-1);
+      }
+      for (unsigned i = 0; i < plan.dstNames.size(); ++i)
+      {
+        const auto it = std::find(plan.fieldMap.begin(), plan.fieldMap.end(), static_cast<int>(i));
+        if (it == plan.fieldMap.end())
+          plan.fieldMissing.push_back(std::make_tuple(plan.dstNames[i], plan.dstTypes[i]));
+      }
+      return plan;
+    }
+  }
+
   static UniqueAnyReference structConverter(const AnyReferenceBase* src, StructTypeInterface* tdst)
   {
     StructTypeInterface* tsrc = static_cast<StructTypeInterface*>(src->type());
 
-    const std::vector<std::string> srcNames = tsrc->elementsName();
-    const std::vector<std::string> dstNames = tdst->elementsName();
-    const std::vector<TypeInterface*> srcTypes = tsrc->memberTypes();
-    const std::vector<TypeInterface*> dstTypes = tdst->memberTypes();
-    if (srcTypes.size() != srcNames.size() || dstTypes.size() != dstNames.size())
+    const StructFieldPlan& plan = structFieldPlan(tsrc, tdst);
+    if (!plan.valid)
     {
       qiLogVerbose() << "Cannot convert between not fully named mismatching tuples " << tsrc->infoString() << " and "
                      << tdst->infoString();
       return {};
     }
-    // Compute mapping between src and dst fields based on names
-    std::vector<int> fieldMap; // fieldMap[i] = index of src's field i in dst (-1 for not present)
+    const std::vector<std::string>& srcNames = plan.srcNames;
+    const std::vector<std::string>& dstNames = plan.dstNames;
+    const std::vector<TypeInterface*>& srcTypes = plan.srcTypes;
+    const std::vector<TypeInterface*>& dstTypes = plan.dstTypes;
+    const std::vector<int>& fieldMap = plan.fieldMap;
+    const std::vector<std::tuple<std::string, TypeInterface*>>& fieldMissing = plan.fieldMissing;
     std::map<std::string, qi::AnyReference> fieldDrop; // unused src fields
-    for (unsigned i = 0; i < srcNames.size(); ++i)
+    for (unsigned i = 0; i < fieldMap.size(); ++i)
     {
-      std::vector<std::string>::const_iterator it = std::find(dstNames.begin(), dstNames.end(), srcNames[i]);
-      if (it != dstNames.end())
-        fieldMap.push_back(static_cast<int>(it - dstNames.begin()));
-      else
-      {
+      if (fieldMap[i] == -1)
         fieldDrop[srcNames[i]] = AnyReference(srcTypes[i], tsrc->get(src->rawValue(), i));
-        fieldMap.push_back(-1);
-      }
-    }
-    std::vector<std::tuple<std::string, TypeInterface*>> fieldMissing; // unfilled dst fields
-    for (unsigned i = 0; i < dstNames.size(); ++i)
-    {
-      std::vector<int>::iterator it = std::find(fieldMap.begin(), fieldMap.end(), i);
-      if (it == fieldMap.end())
-        fieldMissing.push_back(std::make_tuple(dstNames[i], dstTypes[i]));
     }
     auto vecOfTuplesToStrings = [](const std::vector<std::tuple<std::string, TypeInterface*>>& vec) {
       std::string out;
@@ -498,27 +567,20 @@ namespace detail
     {
       return ka::invoke_catch(DefaultUniqueAnyRef{}, [&] {
         StructTypeInterface* tsrc = static_cast<StructTypeInterface*>(_type);
-        std::vector<void*> sourceData = tsrc->get(_value);
-        std::vector<TypeInterface*> srcTypes = tsrc->memberTypes();
-        std::vector<TypeInterface*> dstTypes = tdst->memberTypes();
-        QI_ASSERT(sourceData.size() == srcTypes.size());
-        if (srcTypes.size() != dstTypes.size())
+        // The compatibility verdict and member metadata only depend on the
+        // type pair: use the memoized plan instead of re-enumerating and
+        // re-sorting member names on every conversion.
+        const StructFieldPlan& plan = structFieldPlan(tsrc, tdst);
+        if (!plan.sameShape)
         {
-          qiLogVerbose() << "Conversion glitch: tuple size mismatch between " << tsrc->infoString() << " and " << tdst->infoString();
+          qiLogVerbose() << "Conversion glitch: tuple size or names mismatch between "
+                         << tsrc->infoString() << " and " << tdst->infoString();
           return structConverter(this, tdst);
         }
-        std::vector<std::string> srcNames = tsrc->elementsName();
-        std::vector<std::string> dstNames = tdst->elementsName();
-        if (srcNames.size() == srcTypes.size() && dstNames.size() == dstTypes.size())
-        {
-          std::sort(srcNames.begin(), srcNames.end());
-          std::sort(dstNames.begin(), dstNames.end());
-          if (srcNames != dstNames)
-          {
-            qiLogVerbose() << "Conversion glitch: names mismatch in named tuple";
-            return structConverter(this, tdst);
-          }
-        }
+        std::vector<void*> sourceData = tsrc->get(_value);
+        const std::vector<TypeInterface*>& srcTypes = plan.srcTypes;
+        const std::vector<TypeInterface*>& dstTypes = plan.dstTypes;
+        QI_ASSERT(sourceData.size() == srcTypes.size());
         // Note: start converting without further check.
         // It means the case where a struct was modified but the
         // field count is unchanged will be badly suboptimal.
@@ -1210,6 +1272,38 @@ namespace detail
     t->insert(&_value, ck->_value, cv->_value);
   }
 
+  void AnyReferenceBase::insertAtEnd(const AnyReference& key, const AnyReference& val)
+  {
+    if (kind() != TypeKind_Map)
+      throw std::runtime_error("Expected a map");
+    MapTypeInterface* t = static_cast<MapTypeInterface*>(_type);
+
+    UniqueAnyReference ck{ key, DeferOwnership{} };
+    UniqueAnyReference cv{ val, DeferOwnership{} };
+
+    if (key._type != t->keyType())
+      ck = key.convert(t->keyType());
+    if (!ck->isValid())
+      throwConversionFailure(key._type, t->keyType(), "(invalid key type)");
+
+    if (val._type != t->elementType())
+      cv = val.convert(t->elementType());
+    if (!cv->isValid())
+      throwConversionFailure(val._type, t->elementType(), "(invalid value type)");
+
+    t->insertAtEnd(&_value, ck->_value, cv->_value);
+  }
+
+  void AnyReferenceBase::reserve(size_t count)
+  {
+    if (kind() == TypeKind_List || kind() == TypeKind_VarArgs)
+      static_cast<ListTypeInterface*>(_type)->reserve(&_value, count);
+    else if (kind() == TypeKind_Map)
+      static_cast<MapTypeInterface*>(_type)->reserve(&_value, count);
+    else
+      throw std::runtime_error("Expected a list or a map");
+  }
+
   void AnyReferenceBase::update(const AutoAnyReference& val)
   {
     switch(val.kind())
@@ -10,6 +10,7 @@
 
 #include "binarycodec_p.hpp"
 #include "src/messaging/streamcontext.hpp"
+#include "src/trace_p.hpp"
 
 #include <qi/log.hpp>
 #include <qi/anyobject.hpp>
@@ -17,6 +18,8 @@
 #include <qi/types.hpp>
 #include <qi/numeric.hpp>
 #include <ka/scoped.hpp>
+#include <limits>
+#include <type_traits>
 #include <vector>
 #include <cstring>
 
@@ -41,6 +44,7 @@ namespace qi {
 
       BinaryDecoder::Status _status;
       BufferReader *_reader;
+      bool _compactValues = false;
   };
 
   class BinaryEncoderPrivate {
@@ -52,12 +56,74 @@ namespace qi {
       Buffer* _buffer;
       std::string _signature;
       unsigned int _innerSerialization;
+      bool _compactValues = false;
   };
 
+  namespace
+  {
+    // Zigzag mapping used by the compact integer encoding: small negative
+    // values become small unsigned ones, so they stay short in LEB128.
+    inline std::uint64_t zigzagEncode(std::int64_t value)
+    {
+      return (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63);
+    }
+
+    inline std::int64_t zigzagDecode(std::uint64_t value)
+    {
+      return static_cast<std::int64_t>(value >> 1) ^ -static_cast<std::int64_t>(value & 1);
+    }
+  }
+
+  // Compact encoding (capabilityname::compactValues): integers of two bytes
+  // and more become varints, signed ones zigzag-mapped first. bool, single
+  // bytes and floats keep their fixed layout. Returns false when the value
+  // must take the fixed path.
+  template <typename T2>
+  static typename std::enable_if<std::is_integral<T2>::value && (sizeof(T2) > 1), bool>::type
+  writeCompact(qi::BinaryEncoder* ds, T2 val)
+  {
+    if (!ds->compactValues())
+      return false;
+    ds->writeVarint(std::is_signed<T2>::value ?
+        zigzagEncode(static_cast<std::int64_t>(val)) : static_cast<std::uint64_t>(val));
+    return true;
+  }
+
+  template <typename T2>
+  static typename std::enable_if<!(std::is_integral<T2>::value && (sizeof(T2) > 1)), bool>::type
+  writeCompact(qi::BinaryEncoder*, T2)
+  {
+    return false;
+  }
+
+  template <typename T2>
+  static typename std::enable_if<std::is_integral<T2>::value && (sizeof(T2) > 1), bool>::type
+  readCompact(qi::BinaryDecoder* ds, T2& val)
+  {
+    if (!ds->compactValues())
+      return false;
+    const std::uint64_t raw = ds->readVarint();
+    val = std::is_signed<T2>::value ?
+        static_cast<T2>(zigzagDecode(raw)) : static_cast<T2>(raw);
+    return true;
+  }
+
+  template <typename T2>
+  static typename std::enable_if<!(std::is_integral<T2>::value && (sizeof(T2) > 1)), bool>::type
+  readCompact(qi::BinaryDecoder*, T2&)
+  {
+    return false;
+  }
+
   template <typename T, typename T2, char S>
   static inline qi::BinaryDecoder& deserialize(qi::BinaryDecoder* ds, T &b)
   {
     T2 res;
+    if (readCompact<T2>(ds, res))
+    {
+      b = static_cast<T>(res);
+      return *ds;
+    }
     auto ret = ds->readRaw(static_cast<void *>(&res), sizeof(res));
     if (ret != sizeof(res))
       ds->setStatus(qi::BinaryDecoder::Status::ReadPastEnd);
@@ -69,7 +135,8 @@ namespace qi {
   static inline qi::BinaryEncoder& serialize(qi::BinaryEncoder* ds, T &b, bool inner)
   {
     T2 val = b;
-    ds->write(reinterpret_cast<const char*>(&val), sizeof(val));
+    if (!writeCompact<T2>(ds, val))
+      ds->write(reinterpret_cast<const char*>(&val), sizeof(val));
     if (!inner)
     {
       ds->signature() += S;
@@ -133,6 +200,38 @@ namespace qi {
     return _p->_reader->read(size);
   }
 
+  void BinaryDecoder::setCompactValues(bool enable)
+  {
+    _p->_compactValues = enable;
+  }
+
+  bool BinaryDecoder::compactValues() const
+  {
+    return _p->_compactValues;
+  }
+
+  std::uint64_t BinaryDecoder::readVarint()
+  {
+    std::uint64_t value = 0;
+    unsigned int shift = 0;
+    // 10 bytes of 7 payload bits cover 64 bits; anything longer is corrupt.
+    while (shift < 70)
+    {
+      unsigned char byte = 0;
+      if (readRaw(&byte, 1) != 1)
+      {
+        setStatus(Status::ReadPastEnd);
+        return 0;
+      }
+      value |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+      if (!(byte & 0x80))
+        return value;
+      shift += 7;
+    }
+    setStatus(Status::ReadPastEnd);
+    return 0;
+  }
+
   BinaryDecoder::Status BinaryDecoder::status() const
   {
     return _p->_status;
@@ -188,7 +287,9 @@ namespace qi {
     BufferReader& reader = bufferReader();
     if (reader.hasSubBuffer())
     {
-      meta = reader.subBuffer();
+      // The sub-buffer belongs to the message being decoded: hand out a view
+      // pinning its storage instead of duplicating a potentially huge payload.
+      meta = Buffer::makeShared(reader.subBuffer());
     }
     else
     {
@@ -368,6 +469,31 @@ namespace qi {
     --_p->_innerSerialization;
   }
 
+  void BinaryEncoder::setCompactValues(bool enable)
+  {
+    _p->_compactValues = enable;
+  }
+
+  bool BinaryEncoder::compactValues() const
+  {
+    return _p->_compactValues;
+  }
+
+  void BinaryEncoder::writeVarint(std::uint64_t value)
+  {
+    unsigned char bytes[10];
+    size_t count = 0;
+    do
+    {
+      unsigned char byte = static_cast<unsigned char>(value & 0x7f);
+      value >>= 7;
+      if (value)
+        byte |= 0x80;
+      bytes[count++] = byte;
+    } while (value);
+    write(reinterpret_cast<const char*>(bytes), count);
+  }
+
   BinaryEncoder::Status BinaryEncoder::status() const
   {
     return _p->_status;
@@ -410,6 +536,189 @@ namespace qi {
 
   namespace detail {
 
+    /// Bulk fast path for contiguous numeric lists.
+    ///
+    /// The wire format of a list of numeric values is the element count
+    /// followed by the packed elements in native byte order, which is exactly
+    /// the in-memory layout of a std::vector of that numeric type. When the
+    /// value is such a vector, the whole payload can therefore be emitted or
+    /// extracted with a single bulk copy instead of one virtual write per
+    /// element.
+    template<typename T>
+    bool trySerializeNumericVector(AnyReference value, BinaryEncoder& out)
+    {
+      // The compact encoding varints integer elements, so their raw memory
+      // image no longer matches the generic path a receiver may take; only
+      // float elements keep a fixed layout. Both ends share the compact
+      // setting, so they skip the bulk path together.
+      if (out.compactValues() && std::is_integral<T>::value)
+        return false;
+      static TypeInterface* vectorType = nullptr;
+      QI_ONCE(vectorType = qi::typeOf<std::vector<T>>());
+      if (value.type() != vectorType && value.type()->info() != vectorType->info())
+        return false;
+      const std::vector<T>& v = value.as<std::vector<T>>();
+      out.beginList(numericConvert<std::uint32_t>(v.size()), qi::typeOf<T>()->signature());
+      if (!v.empty())
+        out.write(reinterpret_cast<const char*>(v.data()), v.size() * sizeof(T));
+      out.endList();
+      return true;
+    }
+
+    inline bool serializeNumericVectorBulk(AnyReference value, BinaryEncoder& out)
+    {
+      return trySerializeNumericVector<int8_t>(value, out)
+          || trySerializeNumericVector<uint8_t>(value, out)
+          || trySerializeNumericVector<int16_t>(value, out)
+          || trySerializeNumericVector<uint16_t>(value, out)
+          || trySerializeNumericVector<int32_t>(value, out)
+          || trySerializeNumericVector<uint32_t>(value, out)
+          || trySerializeNumericVector<int64_t>(value, out)
+          || trySerializeNumericVector<uint64_t>(value, out)
+          || trySerializeNumericVector<float>(value, out)
+          || trySerializeNumericVector<double>(value, out);
+    }
+
+    template<typename T>
+    bool tryDeserializeNumericVector(AnyReference result, BinaryDecoder& in)
+    {
+      // See trySerializeNumericVector: integer elements are varints on
+      // compact streams, the raw bulk image only survives for floats.
+      if (in.compactValues() && std::is_integral<T>::value)
+        return false;
+      static TypeInterface* vectorType = nullptr;
+      QI_ONCE(vectorType = qi::typeOf<std::vector<T>>());
+      if (result.type() != vectorType && result.type()->info() != vectorType->info())
+        return false;
+      std::uint32_t sz = 0;
+      in.read(sz);
+      if (in.status() != BinaryDecoder::Status::Ok)
+        return true;
+      std::vector<T>& v = result.as<std::vector<T>>();
+      v.clear();
+      if (sz)
+      {
+        // Validate the advertised size against the remaining payload before
+        // allocating, so a corrupted count cannot trigger a huge resize.
+        // Computed in 64 bits: on 32-bit targets sz * sizeof(T) can wrap
+        // in size_t and slip a bogus count past the validation.
+        const std::uint64_t byteCount = static_cast<std::uint64_t>(sz) * sizeof(T);
+        if (byteCount > (std::numeric_limits<std::size_t>::max)())
+        {
+          in.setStatus(BinaryDecoder::Status::ReadPastEnd);
+          return true;
+        }
+        const void* src = in.readRaw(static_cast<std::size_t>(byteCount));
+        if (!src)
+        {
+          in.setStatus(BinaryDecoder::Status::ReadPastEnd);
+          return true;
+        }
+        v.resize(sz);
+        memcpy(v.data(), src, static_cast<std::size_t>(byteCount));
+      }
+      return true;
+    }
+
+    /* Flat structs (scalar and std::string members, see
+     * StructTypeInterface::flatLayout) have a wire image fully determined
+     * by their member addresses: scalars are written as host bytes, strings
+     * as a size followed by the bytes, and tuples add no framing. Execute
+     * the precomputed field program instead of walking one visitor dispatch
+     * per member, as a single bulk copy when the members are scalars
+     * contiguous in memory.
+     */
+    inline bool trySerializeFlatStruct(AnyReference value, BinaryEncoder& out)
+    {
+      // Scalar members are varints on compact streams, so the precomputed
+      // raw image no longer matches what a generic receiver reads.
+      if (out.compactValues())
+        return false;
+      StructTypeInterface* type = static_cast<StructTypeInterface*>(value.type());
+      const StructTypeInterface::FlatLayout* layout = type->flatLayout();
+      if (!layout)
+        return false;
+      // beginTuple/endTuple write nothing: they only contribute the
+      // signature of a top-level value, same as the generic path.
+      out.beginTuple(qi::makeTupleSignature(type->memberTypes()));
+      void* storage = value.rawValue();
+      const char* base = static_cast<const char*>(type->ptrFromStorage(&storage));
+      if (layout->contiguousSize)
+        out.write(base, layout->contiguousSize);
+      else
+        for (unsigned int i = 0; i < layout->fields.size(); ++i)
+        {
+          const StructTypeInterface::FlatLayout::Field& field = layout->fields[i];
+          if (field.kind == StructTypeInterface::FlatLayout::Field_String)
+          {
+            const std::string& s =
+                *reinterpret_cast<const std::string*>(base + field.offset);
+            out.writeString(s.data(), s.size());
+          }
+          else
+            out.write(base + field.offset, field.size);
+        }
+      out.endTuple();
+      return true;
+    }
+
+    inline bool tryDeserializeFlatStruct(AnyReference result, BinaryDecoder& in)
+    {
+      // See trySerializeFlatStruct.
+      if (in.compactValues())
+        return false;
+      StructTypeInterface* type = static_cast<StructTypeInterface*>(result.type());
+      const StructTypeInterface::FlatLayout* layout = type->flatLayout();
+      if (!layout)
+        return false;
+      void* storage = result.rawValue();
+      char* base = static_cast<char*>(type->ptrFromStorage(&storage));
+      if (layout->contiguousSize)
+      {
+        const void* src = in.readRaw(layout->contiguousSize);
+        if (!src)
+        {
+          in.setStatus(BinaryDecoder::Status::ReadPastEnd);
+          return true;
+        }
+        memcpy(base, src, layout->contiguousSize);
+        return true;
+      }
+      for (unsigned int i = 0; i < layout->fields.size(); ++i)
+      {
+        const StructTypeInterface::FlatLayout::Field& field = layout->fields[i];
+        if (field.kind == StructTypeInterface::FlatLayout::Field_String)
+        {
+          in.read(*reinterpret_cast<std::string*>(base + field.offset));
+          if (in.status() != BinaryDecoder::Status::Ok)
+            return true;
+          continue;
+        }
+        const void* src = in.readRaw(field.size);
+        if (!src)
+        {
+          in.setStatus(BinaryDecoder::Status::ReadPastEnd);
+          return true;
+        }
+        memcpy(base + field.offset, src, field.size);
+      }
+      return true;
+    }
+
+    inline bool deserializeNumericVectorBulk(AnyReference result, BinaryDecoder& in)
+    {
+      return tryDeserializeNumericVector<int8_t>(result, in)
+          || tryDeserializeNumericVector<uint8_t>(result, in)
+          || tryDeserializeNumericVector<int16_t>(result, in)
+          || tryDeserializeNumericVector<uint16_t>(result, in)
+          || tryDeserializeNumericVector<int32_t>(result, in)
+          || tryDeserializeNumericVector<uint32_t>(result, in)
+          || tryDeserializeNumericVector<int64_t>(result, in)
+          || tryDeserializeNumericVector<uint64_t>(result, in)
+          || tryDeserializeNumericVector<float>(result, in)
+          || tryDeserializeNumericVector<double>(result, in);
+    }
+
     class SerializeTypeVisitor
     {
     public:
@@ -473,6 +782,8 @@ namespace qi {
 
       void visitList(AnyIterator it, AnyIterator end)
       {
+        if (serializeNumericVectorBulk(value, out))
+          return;
         out.beginList(numericConvert<std::uint32_t>(value.size()),
                       static_cast<ListTypeInterface*>(value.type())->elementType()->signature());
         for (; it != end; ++it)
@@ -518,7 +829,7 @@ namespace qi {
         if (!serializeObjectCb || !streamContext)
           throw std::runtime_error("Object serialization callback and stream context required but not provided");
         ObjectSerializationInfo osi = serializeObjectCb(ptr);
-        if (streamContext->sharedCapability<bool>(capabilityname::metaObjectCache, false))
+        if (streamContext->sharedCapabilityFlag(StreamContext::SharedCapability_MetaObjectCache))
         {
           std::pair<unsigned int, bool> c = streamContext->sendCacheSet(osi.metaObject);
           osi.metaObjectCachedId = c.first;
@@ -535,7 +846,7 @@ namespace qi {
         out.write(osi.serviceId);
         out.write(osi.objectId);
 
-        if (streamContext->sharedCapability<bool>(capabilityname::objectPtrUid, false))
+        if (streamContext->sharedCapabilityFlag(StreamContext::SharedCapability_ObjectPtrUid))
         {
           // We serialize the PtrUid because, on the receiver side once
           // deserialized, a new local object will be created.
@@ -547,6 +858,8 @@ namespace qi {
 
       void visitTuple(const std::string& /*name*/, const AnyReferenceVector& vals, const std::vector<std::string>& /*annotations*/)
       {
+        if (trySerializeFlatStruct(value, out))
+          return;
         out.beginTuple(qi::makeTupleSignature(vals));
         for (unsigned i=0; i<vals.size(); ++i)
           serialize(vals[i], out, serializeObjectCb, streamContext);
@@ -687,11 +1000,18 @@ namespace qi {
 
       void visitList(AnyIterator, AnyIterator)
       {
+        if (deserializeNumericVectorBulk(result, in))
+          return;
         TypeInterface* elementType = static_cast<ListTypeInterface*>(result.type())->elementType();
         std::uint32_t sz = 0;
         in.read(sz);
         if (in.status() != BinaryDecoder::Status::Ok)
           return;
+        // Reserve up front, but only if the remaining payload could hold
+        // that many elements (one byte each at least), so a corrupted
+        // count cannot trigger a huge allocation before the loop fails.
+        if (sz && in.bufferReader().peek(sz))
+          result.reserve(sz);
         for (unsigned i = 0; i < sz; ++i)
         {
           AnyReference v = deserialize(elementType, in, context, streamContext);
@@ -713,11 +1033,18 @@ namespace qi {
         in.read(sz);
         if (in.status() != BinaryDecoder::Status::Ok)
           return;
+        // Same corrupted-count guard as visitList, two bytes per entry
+        // (key and value) at least.
+        if (sz && in.bufferReader().peek(static_cast<size_t>(sz) * 2))
+          result.reserve(sz);
+        // Maps are serialized in iteration order, sorted for std::map, so
+        // hinted insertion at the end is amortized constant time on the
+        // common sorted wire order and a plain insert otherwise.
         for (unsigned i = 0; i < sz; ++i)
         {
           AnyReference k = deserialize(keyType, in, context, streamContext);
           AnyReference v = deserialize(elementType, in, context, streamContext);
-          result.insert(k, v);
+          result.insertAtEnd(k, v);
           k.destroy();
           v.destroy();
         }
@@ -727,7 +1054,7 @@ namespace qi {
         if (!streamContext)
           throw std::runtime_error("Stream context required to deserialize object");
         ObjectSerializationInfo osi;
-        if (streamContext->sharedCapability<bool>(capabilityname::metaObjectCache, false))
+        if (streamContext->sharedCapabilityFlag(StreamContext::SharedCapability_MetaObjectCache))
         {
           in.read(osi.transmitMetaObject);
           if (osi.transmitMetaObject)
@@ -740,7 +1067,7 @@ namespace qi {
         }
         in.read(osi.serviceId);
         in.read(osi.objectId);
-        if (streamContext->sharedCapability<bool>(capabilityname::objectPtrUid, false))
+        if (streamContext->sharedCapabilityFlag(StreamContext::SharedCapability_ObjectPtrUid))
         {
           PtrUid ptruid;
           in.read(begin(ptruid), size(ptruid));
@@ -773,6 +1100,8 @@ namespace qi {
 
       void visitTuple(const std::string &, const AnyReferenceVector&, const std::vector<std::string>&)
       {
+        if (tryDeserializeFlatStruct(result, in))
+          return;
         std::vector<TypeInterface*> types = result.membersType();
         AnyReferenceVector   vals;
         vals.resize(types.size());
@@ -824,6 +1153,17 @@ namespace qi {
       {
         Buffer b;
         in.read(b);
+
+        // Optimise when result is of type qi::Buffer: move the decoded buffer
+        // in place instead of copying the payload a second time through
+        // setRaw. Combined with the storage sharing done by read(Buffer&)
+        // this makes the dispatch of big raw values copy-free.
+        static TypeInterface* tbuffer = nullptr;
+        QI_ONCE(tbuffer = qi::typeOf<Buffer>());
+        if ((result.type() == tbuffer) || (result.type()->info() == tbuffer->info())) {
+          result.as<Buffer>() = std::move(b);
+          return;
+        }
         result.setRaw(static_cast<const char*>(b.data()), b.size());
       }
 
@@ -887,10 +1227,23 @@ namespace qi {
 
   } // namespace detail
 
+  namespace detail {
+    bool compactValuesSendEnabled(StreamContext* ctx)
+    {
+      return ctx && ctx->compactValuesSendEnabled();
+    }
+  }
+
   void encodeBinary(qi::Buffer *buf, const qi::AutoAnyReference &gvp, SerializeObjectCallback onObject, StreamContext* sctx) {
+    QI_TRACE1(serialize_start, buf);
     BinaryEncoder be(*buf);
+    // One encoding choice per payload, latched per connection inside the
+    // stream context (capabilityname::compactValues).
+    if (sctx)
+      be.setCompactValues(sctx->compactValuesSendEnabled());
     detail::SerializeTypeVisitor stv(be, onObject, gvp, sctx);
     qi::typeDispatch(stv, gvp);
+    QI_TRACE2(serialize_end, buf, buf->totalSize());
     if (be.status() != BinaryEncoder::Status::Ok) {
       std::stringstream ss;
       ss << "OSerialization error " << BinaryEncoder::statusToStr(be.status());
@@ -901,10 +1254,14 @@ namespace qi {
 
   AnyReference decodeBinary(qi::BufferReader *buf, qi::AnyReference gvp,
     DeserializeObjectCallback onObject, StreamContext* sctx) {
+    QI_TRACE1(deserialize_start, buf);
     BinaryDecoder in(buf);
+    if (sctx)
+      in.setCompactValues(sctx->compactValuesReceiveEnabled());
     detail::DeserializeTypeVisitor dtv(in, onObject, sctx);
     dtv.result = gvp;
     qi::typeDispatch(dtv, dtv.result);
+    QI_TRACE2(deserialize_end, buf, buf->position());
     if (in.status() != BinaryDecoder::Status::Ok) {
       std::stringstream ss;
       ss << "ISerialization error " << BinaryDecoder::statusToStr(in.status());
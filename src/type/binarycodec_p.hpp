@@ -75,6 +75,17 @@ namespace qi {
     size_t read(uint8_t* data, size_t len);
 
     void* readRaw(size_t len);
+
+    /// Select the compact integer encoding negotiated for the stream this
+    /// payload came from (capabilityname::compactValues): integers of two
+    /// bytes and more are read as zigzag/LEB128 varints instead of fixed
+    /// little-endian words. Must match what the encoder side used.
+    void setCompactValues(bool enable);
+    bool compactValues() const;
+    /// Read one LEB128 varint; sets ReadPastEnd on truncation or overlong
+    /// input and returns 0.
+    std::uint64_t readVarint();
+
     Status status() const;
     void setStatus(Status status);
     static const char* statusToStr(Status status);
@@ -153,6 +164,14 @@ namespace qi {
     void beginOptional(bool isSet);
     void endOptional();
 
+    /// See BinaryDecoder::setCompactValues: makes 2+ byte integers go out
+    /// as zigzag/LEB128 varints. Only enable on payloads whose receiver
+    /// decodes with the same setting.
+    void setCompactValues(bool enable);
+    bool compactValues() const;
+    /// Write one LEB128 varint (1 to 10 bytes).
+    void writeVarint(std::uint64_t value);
+
     Status status() const;
     void setStatus(Status status);
     static const char* statusToStr(Status status);
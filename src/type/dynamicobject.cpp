@@ -467,6 +467,16 @@ namespace qi
     return type;
   }
 
+  DynamicObject* dynamicObjectOf(const AnyObject& obj)
+  {
+    if (!obj)
+      return nullptr;
+    GenericObject* go = obj.asGenericObject();
+    if (go->type != getDynamicTypeInterface())
+      return nullptr;
+    return reinterpret_cast<DynamicObject*>(go->value);
+  }
+
   AnyObject makeDynamicSharedAnyObjectImpl(DynamicObject* obj, boost::shared_ptr<Empty> other)
   {
     GenericObject* go = new GenericObject(getDynamicTypeInterface(), obj, obj->ptrUid());
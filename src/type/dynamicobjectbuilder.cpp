@@ -170,10 +170,18 @@ namespace qi
     _p->_object->metaObject()._p->setDescription(desc);
   }
 
+  void DynamicObjectBuilder::reserve(std::size_t methodCount, std::size_t signalCount, std::size_t propertyCount)
+  {
+    _p->_object->metaObject()._p->reserveMembers(methodCount, signalCount, propertyCount);
+  }
+
   AnyObject DynamicObjectBuilder::object(boost::function<void (GenericObject*)> onDelete)
   {
     if (!_p->_objptr)
     {
+      // The interface is complete at this point: swap in the pooled
+      // instance so identically-shaped objects share member payloads.
+      _p->_object->setMetaObject(MetaObject::intern(_p->_object->metaObject()));
       _p->_objptr = makeDynamicAnyObject(_p->_object, _p->_deleteOnDestroy,
                                          boost::optional<PtrUid>{}, onDelete);
       _p->_object->setManageable(_p->_objptr.asGenericObject());
@@ -1,7 +1,13 @@
+#include <boost/make_shared.hpp>
+#include <boost/thread/mutex.hpp>
+
 #include <qi/anyobject.hpp>
+#include <qi/atomic.hpp>
+#include <qi/detail/futurebarrier.hpp>
 #include <qi/log.hpp>
 
 #include "metaobject_p.hpp"
+#include "../trace_p.hpp"
 #include <qi/os.hpp>
 
 qiLogCategory("qitype.genericobject");
@@ -9,6 +15,74 @@ qiLogCategory("qitype.genericobject");
 namespace qi
 {
 
+namespace
+{
+  /// Free list backing GenericObject::operator new/delete. The shells all
+  /// have the same layout, so one process-wide list serves every object
+  /// type; construction still runs on each reuse, only the heap round-trip
+  /// is saved. Leaked on purpose: wrappers may still be deleted during
+  /// static destruction.
+  class GenericObjectPool
+  {
+  public:
+    static GenericObjectPool& instance()
+    {
+      static GenericObjectPool* pool = nullptr;
+      QI_THREADSAFE_NEW(pool);
+      return *pool;
+    }
+
+    void* pop()
+    {
+      {
+        boost::mutex::scoped_lock lock(_mutex);
+        if (!_free.empty())
+        {
+          void* shell = _free.back();
+          _free.pop_back();
+          return shell;
+        }
+      }
+      return ::operator new(sizeof(GenericObject));
+    }
+
+    void push(void* shell)
+    {
+      static const size_t maxPooled = static_cast<size_t>(
+          os::getEnvParam<int64_t>("QI_GENERICOBJECT_POOL_MAX", 1024));
+      {
+        boost::mutex::scoped_lock lock(_mutex);
+        if (_free.size() < maxPooled)
+        {
+          _free.push_back(shell);
+          return;
+        }
+      }
+      ::operator delete(shell);
+    }
+
+  private:
+    boost::mutex _mutex;
+    std::vector<void*> _free;
+  };
+}
+
+void* GenericObject::operator new(std::size_t size)
+{
+  // A derived class (none in-tree) would have a different layout: give it
+  // the global allocator.
+  if (size != sizeof(GenericObject))
+    return ::operator new(size);
+  return GenericObjectPool::instance().pop();
+}
+
+void GenericObject::operator delete(void* p)
+{
+  if (!p)
+    return;
+  GenericObjectPool::instance().push(p);
+}
+
 GenericObject::GenericObject(ObjectTypeInterface *type, void *value, const boost::optional<PtrUid>& maybePtrUid)
   : type(type)
   , value(value)
@@ -18,6 +92,24 @@ GenericObject::GenericObject(ObjectTypeInterface *type, void *value, const boost
 
 GenericObject::~GenericObject() {}
 
+GenericObject::GenericObject(const GenericObject& other)
+  : Manageable(other)
+  , type(other.type)
+  , value(other.value)
+  , ptrUid(other.ptrUid)
+{
+}
+
+GenericObject& GenericObject::operator=(const GenericObject& other)
+{
+  Manageable::operator=(other);
+  type = other.type;
+  value = other.value;
+  ptrUid = other.ptrUid;
+  // The method cache is not carried over: it refills on use.
+  return *this;
+}
+
 const MetaObject &GenericObject::metaObject() {
   if (!type || !value) {
     static qi::MetaObject fail;
@@ -39,7 +131,12 @@ Future<AnyReference> GenericObject::metaCallNoUnwrap(
 
   try
   {
-    return type->metaCall(value, shared_from_this(), method, params, callType, returnSignature);
+    // call_end only marks the end of the dispatch: for queued calls the work
+    // itself finishes later, which the future_finish probe picks up.
+    QI_TRACE3(call_start, this, method, callType);
+    auto result = type->metaCall(value, shared_from_this(), method, params, callType, returnSignature);
+    QI_TRACE2(call_end, this, method);
+    return result;
   }
   catch (const std::exception &e)
   {
@@ -69,9 +166,26 @@ qi::Future<AnyReference> GenericObject::metaCall(
     MetaCallType callType,
     Signature returnSignature)
 {
-  int methodId = findMethod(nameWithOptionalSignature, args);
+  const MethodCacheKey key(nameWithOptionalSignature, args.size());
+  {
+    boost::mutex::scoped_lock lock(_methodCacheMutex);
+    std::map<MethodCacheKey, unsigned int>::const_iterator it = _methodCache.find(key);
+    if (it != _methodCache.end())
+    {
+      unsigned int methodId = it->second;
+      lock.unlock(); // the call may reenter metaCall on this object
+      return metaCall(methodId, args, callType, returnSignature);
+    }
+  }
+  bool canCache = false;
+  int methodId = metaObject().findMethod(nameWithOptionalSignature, args, &canCache);
   if (methodId < 0) // in that case, the method ID is an error number
     return makeFutureError<AnyReference>(makeFindMethodErrorMessage(nameWithOptionalSignature, args, methodId));
+  if (canCache)
+  {
+    boost::mutex::scoped_lock lock(_methodCacheMutex);
+    _methodCache[key] = static_cast<unsigned int>(methodId);
+  }
   return metaCall(methodId, args, callType, returnSignature);
 }
 
@@ -212,4 +326,311 @@ void GenericObject::post(const std::string& nameWithOptionalSignature,
   metaPost(nameWithOptionalSignature, GenericFunctionParameters(params));
 }
 
+ObjectBatch::ObjectBatch(detail::ManagedObjectPtr object)
+  : _object(std::move(object))
+{
+}
+
+ObjectBatch::ObjectBatch(ObjectBatch&& other)
+  : _object(std::move(other._object))
+  , _entries(std::move(other._entries))
+{
+  other._entries.clear();
+}
+
+ObjectBatch::~ObjectBatch()
+{
+  for (unsigned i = 0; i < _entries.size(); ++i)
+  {
+    _entries[i].params.destroy();
+    _entries[i].promise.setError("ObjectBatch destroyed before flush()");
+  }
+}
+
+qi::Future<AnyValue> ObjectBatch::call(unsigned int methodId, const GenericFunctionParameters& params)
+{
+  Entry entry;
+  entry.method = methodId;
+  entry.params = params.copy();
+  _entries.push_back(entry);
+  return _entries.back().promise.future();
+}
+
+qi::Future<AnyValue> ObjectBatch::call(const std::string& name, const GenericFunctionParameters& params)
+{
+  if (!_object || !_object->isValid())
+    return makeFutureError<AnyValue>("Operating on invalid GenericObject..");
+  int methodId = _object->findMethod(name, params);
+  if (methodId < 0)
+    return makeFutureError<AnyValue>("Can't find method: " + name);
+  return call(static_cast<unsigned int>(methodId), params);
+}
+
+qi::Future<void> ObjectBatch::flush()
+{
+  using BatchCalls = std::vector<std::pair<unsigned int, AnyValue>>;
+  using BatchReplies = std::vector<std::pair<std::string, AnyValue>>;
+
+  if (!_object || !_object->isValid())
+    return makeFutureError<void>("Operating on invalid GenericObject..");
+  boost::shared_ptr<std::vector<Entry>> entries =
+      boost::make_shared<std::vector<Entry>>();
+  entries->swap(_entries);
+  if (entries->empty())
+    return qi::Future<void>(0);
+
+  std::vector<qi::Future<AnyValue>> results;
+  results.reserve(entries->size());
+  for (unsigned i = 0; i < entries->size(); ++i)
+    results.push_back((*entries)[i].promise.future());
+
+  // The server merges its bound-object methods into the metaobject we see, so
+  // the presence of callBatch with the bundled signature is the negotiation:
+  // peers that predate it simply do not advertise it.
+  std::vector<MetaMethod> batchMethod = _object->metaObject().findMethod("callBatch");
+  if (!batchMethod.empty() &&
+      batchMethod.front().parametersSignature().toString() == "([(Im)])")
+  {
+    BatchCalls calls;
+    calls.reserve(entries->size());
+    for (unsigned i = 0; i < entries->size(); ++i)
+      calls.push_back(std::make_pair((*entries)[i].method,
+          AnyValue(makeGenericTuple((*entries)[i].params), false, true)));
+    GenericFunctionParameters args;
+    args.push_back(AnyReference::from(calls));
+    qi::Future<AnyReference> reply = _object->metaCall(batchMethod.front().uid(), args);
+    reply.connect([entries](qi::Future<AnyReference> reply) {
+      std::string batchError;
+      BatchReplies replies;
+      if (reply.isCanceled())
+        batchError = "Batched call canceled";
+      else if (reply.hasError())
+        batchError = reply.error();
+      else
+      {
+        AnyReference val = reply.value();
+        try {
+          replies = val.to<BatchReplies>();
+        } catch (const std::exception& e) {
+          batchError = std::string("Invalid batched reply: ") + e.what();
+        }
+        val.destroy();
+        if (batchError.empty() && replies.size() != entries->size())
+          batchError = "Batched reply size mismatch";
+      }
+      for (unsigned i = 0; i < entries->size(); ++i)
+      {
+        Entry& entry = (*entries)[i];
+        entry.params.destroy();
+        if (!batchError.empty())
+          entry.promise.setError(batchError);
+        else if (!replies[i].first.empty())
+          entry.promise.setError(replies[i].first);
+        else
+          entry.promise.setValue(replies[i].second);
+      }
+    });
+  }
+  else
+  { // Peer (or local object) without batching support: plain per-call dispatch.
+    for (unsigned i = 0; i < entries->size(); ++i)
+    {
+      qi::Future<AnyReference> result =
+          _object->metaCall((*entries)[i].method, (*entries)[i].params);
+      result.connect([entries, i](qi::Future<AnyReference> result) {
+        Entry& entry = (*entries)[i];
+        entry.params.destroy();
+        if (result.isCanceled())
+          entry.promise.setError("Call canceled");
+        else if (result.hasError())
+          entry.promise.setError(result.error());
+        else
+          entry.promise.setValue(AnyValue(result.value(), false, true));
+      });
+    }
+  }
+  return qi::waitForAll(results).async().andThen(
+      [](const std::vector<qi::Future<AnyValue>>&) {});
+}
+
+qi::FutureSync<std::vector<std::pair<std::string, AnyValue>>> GenericObject::properties(
+    const std::vector<std::string>& names)
+{
+  using PropReplies = std::vector<std::pair<std::string, AnyValue>>;
+  if (!value || !type)
+    return makeFutureError<PropReplies>("Operating on invalid GenericObject..");
+  const size_t expected = names.size();
+
+  // Like ObjectBatch: the server merges its bound-object methods into the
+  // metaobject we see, so advertising getProperties is the negotiation.
+  std::vector<MetaMethod> bulk = metaObject().findMethod("getProperties");
+  if (!bulk.empty() && bulk.front().parametersSignature().toString() == "([m])")
+  {
+    std::vector<AnyValue> ids;
+    ids.reserve(names.size());
+    for (unsigned i = 0; i < names.size(); ++i)
+      ids.push_back(AnyValue::from(names[i]));
+    GenericFunctionParameters args;
+    args.push_back(AnyReference::from(ids));
+    qi::Promise<PropReplies> result;
+    qi::Future<AnyReference> reply = metaCall(bulk.front().uid(), args);
+    reply.connect([result, expected](qi::Future<AnyReference> reply) mutable {
+      if (reply.isCanceled())
+      {
+        result.setCanceled();
+        return;
+      }
+      if (reply.hasError())
+      {
+        result.setError(reply.error());
+        return;
+      }
+      AnyReference val = reply.value();
+      PropReplies replies;
+      std::string error;
+      try {
+        replies = val.to<PropReplies>();
+      } catch (const std::exception& e) {
+        error = std::string("Invalid bulk property reply: ") + e.what();
+      }
+      val.destroy();
+      if (error.empty() && replies.size() != expected)
+        error = "Bulk property reply size mismatch";
+      if (!error.empty())
+        result.setError(error);
+      else
+        result.setValue(replies);
+    });
+    return result.future();
+  }
+
+  // Peer (or local object) without bulk support: plain per-property reads.
+  std::vector<qi::Future<AnyValue>> results;
+  results.reserve(names.size());
+  for (unsigned i = 0; i < names.size(); ++i)
+  {
+    int pid = metaObject().propertyId(names[i]);
+    if (pid < 0)
+      results.push_back(makeFutureError<AnyValue>("Property not found: " + names[i]));
+    else
+      results.push_back(property(static_cast<unsigned int>(pid)).async());
+  }
+  return qi::waitForAll(results).async().andThen(
+      [](const std::vector<qi::Future<AnyValue>>& done) {
+        PropReplies replies;
+        replies.reserve(done.size());
+        for (unsigned i = 0; i < done.size(); ++i)
+        {
+          qi::Future<AnyValue> result = done[i];
+          if (result.isCanceled())
+            replies.push_back(std::make_pair(std::string("Property read canceled"), AnyValue::makeVoid()));
+          else if (result.hasError())
+            replies.push_back(std::make_pair(result.error(), AnyValue::makeVoid()));
+          else
+            replies.push_back(std::make_pair(std::string(), result.value()));
+        }
+        return replies;
+      });
+}
+
+qi::FutureSync<std::vector<std::string>> GenericObject::setProperties(
+    const std::vector<std::pair<std::string, AnyValue>>& values)
+{
+  using PropErrors = std::vector<std::string>;
+  if (!value || !type)
+    return makeFutureError<PropErrors>("Operating on invalid GenericObject..");
+  const size_t expected = values.size();
+
+  std::vector<MetaMethod> bulk = metaObject().findMethod("setProperties");
+  if (!bulk.empty() && bulk.front().parametersSignature().toString() == "([(mm)])")
+  {
+    std::vector<std::pair<AnyValue, AnyValue>> writes;
+    writes.reserve(values.size());
+    for (unsigned i = 0; i < values.size(); ++i)
+      writes.push_back(std::make_pair(AnyValue::from(values[i].first), values[i].second));
+    GenericFunctionParameters args;
+    args.push_back(AnyReference::from(writes));
+    qi::Promise<PropErrors> result;
+    qi::Future<AnyReference> reply = metaCall(bulk.front().uid(), args);
+    reply.connect([result, expected](qi::Future<AnyReference> reply) mutable {
+      if (reply.isCanceled())
+      {
+        result.setCanceled();
+        return;
+      }
+      if (reply.hasError())
+      {
+        result.setError(reply.error());
+        return;
+      }
+      AnyReference val = reply.value();
+      PropErrors errors;
+      std::string error;
+      try {
+        errors = val.to<PropErrors>();
+      } catch (const std::exception& e) {
+        error = std::string("Invalid bulk property reply: ") + e.what();
+      }
+      val.destroy();
+      if (error.empty() && errors.size() != expected)
+        error = "Bulk property reply size mismatch";
+      if (!error.empty())
+        result.setError(error);
+      else
+        result.setValue(errors);
+    });
+    return result.future();
+  }
+
+  // Peer (or local object) without bulk support: plain per-property writes.
+  std::vector<qi::Future<void>> results;
+  results.reserve(values.size());
+  for (unsigned i = 0; i < values.size(); ++i)
+  {
+    int pid = metaObject().propertyId(values[i].first);
+    if (pid < 0)
+      results.push_back(makeFutureError<void>("Property not found: " + values[i].first));
+    else
+      results.push_back(setProperty(static_cast<unsigned int>(pid), values[i].second).async());
+  }
+  return qi::waitForAll(results).async().andThen(
+      [](const std::vector<qi::Future<void>>& done) {
+        PropErrors errors;
+        errors.reserve(done.size());
+        for (unsigned i = 0; i < done.size(); ++i)
+        {
+          qi::Future<void> result = done[i];
+          if (result.isCanceled())
+            errors.push_back("Property write canceled");
+          else if (result.hasError())
+            errors.push_back(result.error());
+          else
+            errors.push_back(std::string());
+        }
+        return errors;
+      });
+}
+
+void GenericObject::post(unsigned int methodOrSignalId,
+                       qi::AutoAnyReference p1,
+                       qi::AutoAnyReference p2,
+                       qi::AutoAnyReference p3,
+                       qi::AutoAnyReference p4,
+                       qi::AutoAnyReference p5,
+                       qi::AutoAnyReference p6,
+                       qi::AutoAnyReference p7,
+                       qi::AutoAnyReference p8)
+{
+  if (!type || !value) {
+    qiLogWarning() << "Operating on invalid GenericObject..";
+    return;
+  }
+  qi::AutoAnyReference* vals[8]= {&p1, &p2, &p3, &p4, &p5, &p6, &p7, &p8};
+  std::vector<qi::AnyReference> params;
+  for (unsigned i=0; i<8; ++i)
+    if (vals[i]->type())
+      params.push_back(*vals[i]);
+  metaPost(methodOrSignalId, GenericFunctionParameters(params));
+}
+
 }
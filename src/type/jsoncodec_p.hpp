@@ -43,6 +43,41 @@ namespace qi {
     std::string::const_iterator       _it;
   };
 
+  /// Decodes JSON straight into a caller-provided typed value, guided by
+  /// its TypeInterface, without building an intermediate AnyValue tree.
+  /// Numbers and unescaped strings are read in place from the input buffer;
+  /// a single scratch string is reused for keys and escaped strings.
+  /// Errors are reported by throwing std::runtime_error with the offset.
+  class JsonTypedDecoderPrivate
+  {
+  public:
+    JsonTypedDecoderPrivate(const std::string &in);
+    void decode(AnyReference target);
+
+  private:
+    void skipWhiteSpaces();
+    bool match(const char* expected);
+    bool parseString(std::string &result);
+    void skipValue();
+    void decodeValue(AnyReference target);
+    void decodeBool(AnyReference target);
+    void decodeInt(AnyReference target);
+    void decodeFloat(AnyReference target);
+    void decodeString(AnyReference target);
+    void decodeList(AnyReference target);
+    void decodeMap(AnyReference target);
+    void decodeTuple(AnyReference target);
+    void decodeDynamic(AnyReference target);
+    void decodeOptional(AnyReference target);
+    void fail(const std::string &what);
+
+  private:
+    const std::string &_in;
+    const char*        _it;
+    const char*        _end;
+    std::string        _scratch;
+  };
+
 }
 
 #endif  // _JSONPARSER_P_HPP_
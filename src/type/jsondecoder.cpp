@@ -5,7 +5,10 @@
 
 #include <qi/jsoncodec.hpp>
 #include <qi/anyvalue.hpp>
+#include <qi/type/typeinterface.hpp>
+#include <cstdlib>
 #include <iterator>
+#include <sstream>
 #include <boost/lexical_cast.hpp>
 #ifdef WITH_BOOST_LOCALE
 #  include <boost/locale.hpp>
@@ -380,6 +383,384 @@ namespace qi {
     return false;
   }
 
+  JsonTypedDecoderPrivate::JsonTypedDecoderPrivate(const std::string &in)
+    : _in(in),
+      _it(in.data()),
+      _end(in.data() + in.size())
+  {}
+
+  void JsonTypedDecoderPrivate::decode(AnyReference target)
+  {
+    if (!target.type())
+      throw std::runtime_error("decodeJSON: invalid target reference");
+    decodeValue(target);
+  }
+
+  void JsonTypedDecoderPrivate::fail(const std::string &what)
+  {
+    std::stringstream ss;
+    ss << "parse error: " << what << " at offset " << (_it - _in.data());
+    throw std::runtime_error(ss.str());
+  }
+
+  void JsonTypedDecoderPrivate::skipWhiteSpaces()
+  {
+    while (_it != _end && (*_it == ' ' || *_it == '\n'))
+      ++_it;
+  }
+
+  bool JsonTypedDecoderPrivate::match(const char* expected)
+  {
+    const char* save = _it;
+    while (*expected)
+    {
+      if (_it == _end || *_it != *expected)
+      {
+        _it = save;
+        return false;
+      }
+      ++_it;
+      ++expected;
+    }
+    return true;
+  }
+
+  bool JsonTypedDecoderPrivate::parseString(std::string &result)
+  {
+    if (_it == _end || *_it != '"')
+      return false;
+    ++_it;
+    // Fast path: no escape, the string is a single slice of the input.
+    const char* cursor = _it;
+    while (cursor != _end && *cursor != '"' && *cursor != '\\')
+      ++cursor;
+    if (cursor == _end)
+      fail("unterminated string");
+    result.assign(_it, cursor);
+    if (*cursor == '"')
+    {
+      _it = cursor + 1;
+      return true;
+    }
+    _it = cursor;
+    while (_it != _end && *_it != '"')
+    {
+      if (*_it != '\\')
+      {
+        result += *_it;
+        ++_it;
+        continue;
+      }
+      if (_it + 1 == _end)
+        fail("unterminated escape sequence");
+      switch (*(_it + 1))
+      {
+      case '"' : result += '"' ; _it += 2; break;
+      case '\\': result += '\\'; _it += 2; break;
+      case '/' : result += '/' ; _it += 2; break;
+      case 'b' : result += '\b'; _it += 2; break;
+      case 'f' : result += '\f'; _it += 2; break;
+      case 'n' : result += '\n'; _it += 2; break;
+      case 'r' : result += '\r'; _it += 2; break;
+      case 't' : result += '\t'; _it += 2; break;
+#ifdef WITH_BOOST_LOCALE
+      case 'u' :
+      {
+        if (_end - _it < 6)
+          fail("truncated \\u escape");
+        int val = 0;
+        for (int i = 2; i < 6; ++i)
+        {
+          const char c = _it[i];
+          int digit;
+          if (c >= '0' && c <= '9')
+            digit = c - '0';
+          else if (c >= 'a' && c <= 'f')
+            digit = c - 'a' + 10;
+          else if (c >= 'A' && c <= 'F')
+            digit = c - 'A' + 10;
+          else
+          {
+            fail("invalid \\u escape");
+            return false;
+          }
+          val = val * 16 + digit;
+        }
+        result += boost::locale::conv::utf_to_utf<char>(&val, &val + 1);
+        _it += 6;
+        break;
+      }
+#endif
+      default:
+        fail("unknown escape sequence");
+      }
+    }
+    if (_it == _end)
+      fail("unterminated string");
+    ++_it;
+    return true;
+  }
+
+  void JsonTypedDecoderPrivate::skipValue()
+  {
+    // Parse and drop a value of any shape with the dynamic parser, then
+    // resume after it.
+    AnyValue dropped;
+    const std::string::const_iterator next =
+        decodeJSON(_in.begin() + (_it - _in.data()), _in.end(), dropped);
+    _it = _in.data() + (next - _in.begin());
+  }
+
+  void JsonTypedDecoderPrivate::decodeBool(AnyReference target)
+  {
+    if (match("true"))
+      target.setInt(1);
+    else if (match("false"))
+      target.setInt(0);
+    else
+      fail("expected a boolean");
+  }
+
+  void JsonTypedDecoderPrivate::decodeInt(AnyReference target)
+  {
+    IntTypeInterface* type = static_cast<IntTypeInterface*>(target.type());
+    if (type->size() == 0)
+    {
+      decodeBool(target);
+      return;
+    }
+    // _in.data() is NUL-terminated, so strtoll stops inside the buffer.
+    char* numberEnd = 0;
+    if (type->isSigned())
+      target.setInt(std::strtoll(_it, &numberEnd, 10));
+    else
+      target.setUInt(std::strtoull(_it, &numberEnd, 10));
+    if (numberEnd == _it)
+      fail("expected an integer");
+    if (numberEnd != _end &&
+        (*numberEnd == '.' || *numberEnd == 'e' || *numberEnd == 'E'))
+      fail("expected an integer, got a float");
+    _it = numberEnd;
+  }
+
+  void JsonTypedDecoderPrivate::decodeFloat(AnyReference target)
+  {
+    char* numberEnd = 0;
+    const double value = std::strtod(_it, &numberEnd);
+    if (numberEnd == _it)
+      fail("expected a number");
+    target.setDouble(value);
+    _it = numberEnd;
+  }
+
+  void JsonTypedDecoderPrivate::decodeString(AnyReference target)
+  {
+    if (!parseString(_scratch))
+      fail("expected a string");
+    target.setString(_scratch);
+  }
+
+  void JsonTypedDecoderPrivate::decodeList(AnyReference target)
+  {
+    if (_it == _end || *_it != '[')
+      fail("expected '['");
+    ++_it;
+    TypeInterface* elementType =
+        static_cast<ListTypeInterface*>(target.type())->elementType();
+    skipWhiteSpaces();
+    if (_it != _end && *_it == ']')
+    {
+      ++_it;
+      return;
+    }
+    while (true)
+    {
+      AnyValue element(elementType);
+      decodeValue(element.asReference());
+      target.append(element.asReference());
+      if (_it == _end)
+        fail("unterminated array");
+      if (*_it == ']')
+      {
+        ++_it;
+        return;
+      }
+      if (*_it != ',')
+        fail("expected ',' or ']'");
+      ++_it;
+    }
+  }
+
+  void JsonTypedDecoderPrivate::decodeMap(AnyReference target)
+  {
+    if (_it == _end || *_it != '{')
+      fail("expected '{'");
+    ++_it;
+    MapTypeInterface* type = static_cast<MapTypeInterface*>(target.type());
+    TypeInterface* keyType = type->keyType();
+    TypeInterface* elementType = type->elementType();
+    skipWhiteSpaces();
+    if (_it != _end && *_it == '}')
+    {
+      ++_it;
+      return;
+    }
+    while (true)
+    {
+      // Keys follow encodeJSON's convention: strings are quoted, other
+      // key types (integers...) are written bare.
+      AnyValue key(keyType);
+      decodeValue(key.asReference());
+      if (_it == _end || *_it != ':')
+        fail("expected ':'");
+      ++_it;
+      AnyValue element(elementType);
+      decodeValue(element.asReference());
+      target.insert(key.asReference(), element.asReference());
+      if (_it == _end)
+        fail("unterminated object");
+      if (*_it == '}')
+      {
+        ++_it;
+        return;
+      }
+      if (*_it != ',')
+        fail("expected ',' or '}'");
+      ++_it;
+    }
+  }
+
+  void JsonTypedDecoderPrivate::decodeTuple(AnyReference target)
+  {
+    StructTypeInterface* type = static_cast<StructTypeInterface*>(target.type());
+    AnyReferenceVector members = target.asTupleValuePtr();
+    // Unannotated tuples are encoded as arrays: decode members in order.
+    if (_it != _end && *_it == '[')
+    {
+      ++_it;
+      for (size_t i = 0; i < members.size(); ++i)
+      {
+        if (i != 0)
+        {
+          if (_it == _end || *_it != ',')
+            fail("expected ','");
+          ++_it;
+        }
+        decodeValue(members[i]);
+      }
+      skipWhiteSpaces();
+      if (_it == _end || *_it != ']')
+        fail("expected ']'");
+      ++_it;
+      return;
+    }
+    if (_it == _end || *_it != '{')
+      fail("expected '{' or '['");
+    ++_it;
+    const std::vector<std::string> names = type->elementsName();
+    if (names.size() != members.size())
+      fail("unnamed structure members, expected an array");
+    skipWhiteSpaces();
+    if (_it != _end && *_it == '}')
+    {
+      ++_it;
+      return;
+    }
+    while (true)
+    {
+      skipWhiteSpaces();
+      if (!parseString(_scratch))
+        fail("expected a key");
+      skipWhiteSpaces();
+      if (_it == _end || *_it != ':')
+        fail("expected ':'");
+      ++_it;
+      size_t index = 0;
+      while (index < names.size() && names[index] != _scratch)
+        ++index;
+      if (index < members.size())
+        decodeValue(members[index]);
+      else
+        skipValue(); // unknown key: drop its value, members keep defaults
+      if (_it == _end)
+        fail("unterminated object");
+      if (*_it == '}')
+      {
+        ++_it;
+        return;
+      }
+      if (*_it != ',')
+        fail("expected ',' or '}'");
+      ++_it;
+    }
+  }
+
+  void JsonTypedDecoderPrivate::decodeDynamic(AnyReference target)
+  {
+    // Schema-less part of the target: defer to the dynamic parser.
+    AnyValue value;
+    const std::string::const_iterator next =
+        decodeJSON(_in.begin() + (_it - _in.data()), _in.end(), value);
+    _it = _in.data() + (next - _in.begin());
+    target.setDynamic(value.asReference());
+  }
+
+  void JsonTypedDecoderPrivate::decodeOptional(AnyReference target)
+  {
+    if (match("null"))
+    {
+      target.resetOptional();
+      return;
+    }
+    OptionalTypeInterface* type =
+        static_cast<OptionalTypeInterface*>(target.type());
+    AnyValue value(type->valueType());
+    decodeValue(value.asReference());
+    target.setOptional(value.asReference());
+  }
+
+  void JsonTypedDecoderPrivate::decodeValue(AnyReference target)
+  {
+    skipWhiteSpaces();
+    if (_it == _end)
+      fail("unexpected end of input");
+    switch (target.kind())
+    {
+    case TypeKind_Void:
+      if (!match("null"))
+        fail("expected null");
+      break;
+    case TypeKind_Int:
+      decodeInt(target);
+      break;
+    case TypeKind_Float:
+      decodeFloat(target);
+      break;
+    case TypeKind_String:
+      decodeString(target);
+      break;
+    case TypeKind_List:
+    case TypeKind_VarArgs:
+      decodeList(target);
+      break;
+    case TypeKind_Map:
+      decodeMap(target);
+      break;
+    case TypeKind_Tuple:
+      decodeTuple(target);
+      break;
+    case TypeKind_Dynamic:
+      decodeDynamic(target);
+      break;
+    case TypeKind_Optional:
+      decodeOptional(target);
+      break;
+    default:
+      fail("no JSON decoding into type " + target.signature().toString());
+    }
+    skipWhiteSpaces();
+  }
+
   std::string::const_iterator decodeJSON(const std::string::const_iterator &begin,
                                          const std::string::const_iterator &end,
                                          AnyValue &target)
@@ -397,4 +778,10 @@ namespace qi {
     return value;
   }
 
+  void decodeJSON(const std::string &in, AnyReference target)
+  {
+    JsonTypedDecoderPrivate parser(in);
+    parser.decode(target);
+  }
+
 }
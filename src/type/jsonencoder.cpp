@@ -3,22 +3,103 @@
 **  See COPYING for the license
 */
 
-#include <sstream>
+#include <cstdio>
+#include <cstring>
+#include <limits>
 #include <string>
-#include <iomanip>
+#include <vector>
 #ifdef WITH_BOOST_LOCALE
 #  include <boost/locale.hpp>
 #endif
+#ifdef __SSE2__
+#  include <emmintrin.h>
+#endif
 #include <qi/jsoncodec.hpp>
 #include <qi/anyobject.hpp>
 #include <qi/type/typedispatcher.hpp>
 #include <qi/numeric.hpp>
+#include <qi/types.hpp>
 
 qiLogCategory("qitype.jsonencoder");
 
 namespace qi {
 
-  static void serialize(AnyReference val, std::stringstream& out, JsonOption jsonPrintOption, unsigned int indent);
+  /// Growable byte buffer the encoder writes into. Appending is a bounds
+  /// check plus a memcpy with geometric growth, where the std::stringstream
+  /// previously used here paid a virtual streambuf call per insertion.
+  class JsonArena
+  {
+  public:
+    /// Bytes buffered before a chunk is handed to the sink, when there is one.
+    static const size_t defaultChunkSize = 64 * 1024;
+
+    JsonArena()
+    {
+      _data.reserve(256);
+    }
+
+    /// Stream the output to \a sink in chunks of about \a chunkSize bytes
+    /// instead of accumulating the whole document.
+    explicit JsonArena(const JsonSink& sink, size_t chunkSize = defaultChunkSize)
+      : _sink(sink)
+      , _chunkSize(chunkSize ? chunkSize : defaultChunkSize)
+    {
+      _data.reserve(_chunkSize);
+    }
+
+    void write(const char* data, size_t size)
+    {
+      _data.insert(_data.end(), data, data + size);
+      maybeFlush();
+    }
+
+    /// Hand the buffered bytes to the sink, if any.
+    void flush()
+    {
+      if (!_sink || _data.empty())
+        return;
+      _sink(_data.data(), _data.size());
+      _data.clear();
+    }
+
+    JsonArena& operator<<(char c)
+    {
+      _data.push_back(c);
+      maybeFlush();
+      return *this;
+    }
+
+    JsonArena& operator<<(const char* s)
+    {
+      write(s, std::strlen(s));
+      return *this;
+    }
+
+    JsonArena& operator<<(const std::string& s)
+    {
+      write(s.data(), s.size());
+      return *this;
+    }
+
+    /// The whole document; only meaningful without a sink.
+    std::string str() const
+    {
+      return std::string(_data.data(), _data.size());
+    }
+
+  private:
+    void maybeFlush()
+    {
+      if (_sink && _data.size() >= _chunkSize)
+        flush();
+    }
+
+    std::vector<char> _data;
+    JsonSink _sink;
+    size_t _chunkSize = 0;
+  };
+
+  static void serialize(AnyReference val, JsonArena& out, JsonOption jsonPrintOption, unsigned int indent);
 
   //Taken from boost::json
   inline char to_hex_char(unsigned int c)
@@ -95,29 +176,137 @@ namespace qi {
     return result;
   }
 
+  namespace {
+    /// Two-character escape sequence for \a c, or NULL if \a c has none.
+    inline const char* twoCharEscape(unsigned char c)
+    {
+      switch (c)
+      {
+      case '"':  return "\\\"";
+      case '\\': return "\\\\";
+      case '\b': return "\\b";
+      case '\f': return "\\f";
+      case '\n': return "\\n";
+      case '\r': return "\\r";
+      case '\t': return "\\t";
+      }
+      return NULL;
+    }
+
+    /// True for bytes a JSON string can carry verbatim: printable ASCII
+    /// minus the quote and the backslash.
+    inline bool jsonCleanByte(unsigned char c)
+    {
+      return c >= 0x20 && c < 0x7F && c != '"' && c != '\\';
+    }
+
+#ifdef __SSE2__
+    inline unsigned int trailingZeros(unsigned int mask)
+    {
+#  ifdef __GNUC__
+      return static_cast<unsigned int>(__builtin_ctz(mask));
+#  else
+      unsigned int n = 0;
+      while (!(mask & 1u))
+      {
+        mask >>= 1;
+        ++n;
+      }
+      return n;
+#  endif
+    }
+#else
+    /// True if one of the eight bytes packed in \a x equals \a n
+    /// (the classic SWAR "haszero" trick).
+    inline bool swarHasByteEqual(qi::uint64_t x, unsigned char n)
+    {
+      const qi::uint64_t ones = 0x0101010101010101ull;
+      const qi::uint64_t t = x ^ (ones * n);
+      return ((t - ones) & ~t & 0x8080808080808080ull) != 0;
+    }
+#endif
+
+    /// Length of the prefix of [data, data + size) made only of bytes that
+    /// need no escaping, 16 (SSE2) or 8 (portable SWAR) bytes at a time.
+    size_t cleanPrefixSize(const char* data, size_t size)
+    {
+      size_t i = 0;
+#ifdef __SSE2__
+      // A signed compare against 0x20 flags both the control characters and
+      // the bytes >= 0x80 (negative as signed) in one go; 0x7F, the quote
+      // and the backslash are matched separately.
+      const __m128i space = _mm_set1_epi8(0x20);
+      const __m128i del = _mm_set1_epi8(0x7F);
+      const __m128i quote = _mm_set1_epi8('"');
+      const __m128i backslash = _mm_set1_epi8('\\');
+      for (; i + 16 <= size; i += 16)
+      {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        __m128i dirty = _mm_cmplt_epi8(chunk, space);
+        dirty = _mm_or_si128(dirty, _mm_cmpeq_epi8(chunk, del));
+        dirty = _mm_or_si128(dirty, _mm_cmpeq_epi8(chunk, quote));
+        dirty = _mm_or_si128(dirty, _mm_cmpeq_epi8(chunk, backslash));
+        const unsigned int mask =
+            static_cast<unsigned int>(_mm_movemask_epi8(dirty));
+        if (mask)
+          return i + trailingZeros(mask);
+      }
+#else
+      const qi::uint64_t ones = 0x0101010101010101ull;
+      const qi::uint64_t high = 0x8080808080808080ull;
+      for (; i + 8 <= size; i += 8)
+      {
+        qi::uint64_t x;
+        std::memcpy(&x, data + i, sizeof(x));
+        // "hasless(x, 0x20)" flags control characters, the high bit flags
+        // non-ASCII; the word is rescanned bytewise below if anything hit.
+        const qi::uint64_t dirty = (((x - ones * 0x20) & ~x) | x) & high;
+        if (dirty != 0 || swarHasByteEqual(x, 0x7F) ||
+            swarHasByteEqual(x, '"') || swarHasByteEqual(x, '\\'))
+          break;
+      }
+#endif
+      for (; i < size; ++i)
+        if (!jsonCleanByte(static_cast<unsigned char>(data[i])))
+          break;
+      return i;
+    }
+  }
+
   std::string encodeJSON(const qi::AutoAnyReference &value, JsonOption jsonPrintOption) {
-    std::stringstream ss;
-    serialize(value, ss, jsonPrintOption, 0);
-    return ss.str();
+    JsonArena out;
+    serialize(value, out, jsonPrintOption, 0);
+    return out.str();
+  }
+
+  void encodeJSON(const qi::AutoAnyReference &value, const JsonSink& sink, JsonOption jsonPrintOption) {
+    JsonArena out(sink);
+    serialize(value, out, jsonPrintOption, 0);
+    out.flush();
+  }
+
+  void encodeJSON(const qi::AutoAnyReference &value, Buffer& buffer, JsonOption jsonPrintOption) {
+    Buffer* out = &buffer;
+    encodeJSON(value,
+               JsonSink([out](const char* data, size_t size) { out->write(data, size); }),
+               jsonPrintOption);
   }
 
   class SerializeJSONTypeVisitor
   {
   public:
-    SerializeJSONTypeVisitor(std::stringstream& outd, JsonOption jsonPrintOptiond, unsigned int indentd)
+    SerializeJSONTypeVisitor(JsonArena& outd, JsonOption jsonPrintOptiond, unsigned int indentd)
       : out(outd)
       , jsonPrintOption(jsonPrintOptiond)
       , indent(indentd)
     {
-      //force C local, for int and float formatting
-      out.imbue(std::locale("C"));
     }
 
     void printIndent()
     {
       if (jsonPrintOption & qi::JsonOption_PrettyPrint)
       {
-        out << std::endl;
+        out << '\n';
         for (unsigned int i = 0; i < indent; ++i)
           out << "  ";
       }
@@ -144,6 +333,30 @@ namespace qi {
       out << "null";
     }
 
+    void writeUnsigned(uint64_t value)
+    {
+      char buffer[20]; // 2^64 - 1 has 20 digits
+      char* const end = buffer + sizeof(buffer);
+      char* cursor = end;
+      do
+      {
+        *--cursor = static_cast<char>('0' + value % 10);
+        value /= 10;
+      } while (value != 0);
+      out.write(cursor, static_cast<size_t>(end - cursor));
+    }
+
+    void writeSigned(int64_t value)
+    {
+      uint64_t magnitude = static_cast<uint64_t>(value);
+      if (value < 0)
+      {
+        out << '-';
+        magnitude = 0u - magnitude; // two's complement, INT64_MIN included
+      }
+      writeUnsigned(magnitude);
+    }
+
     void visitInt(int64_t value, bool isSigned, int byteSize)
     {
       switch((isSigned ? 1 : -1) * byteSize)
@@ -159,44 +372,93 @@ namespace qi {
       case 1:
       case 2:
       case 4:
-      case 8:  out << ((int64_t)value); break;
+      case 8:  writeSigned(value); break;
       case -1:
       case -2:
       case -4:
-      case -8: out << ((uint64_t)value);break;
+      case -8: writeUnsigned(static_cast<uint64_t>(value)); break;
 
       default:
         qiLogError() << "Unknown integer type " << isSigned << " " << byteSize;
       }
     }
 
+    void writeFloat(double value, int digits)
+    {
+      // %g with max_digits10 significant digits matches what the stream
+      // used to produce (shortest fixed-or-scientific form that round-trips).
+      char buffer[40];
+      const int length =
+          std::snprintf(buffer, sizeof(buffer), "%.*g", digits, value);
+      if (length <= 0 || length >= static_cast<int>(sizeof(buffer)))
+        return;
+      // The stream was imbued with the C locale; snprintf follows the global
+      // one, which may spell the decimal separator as a comma.
+      for (int i = 0; i < length; ++i)
+        if (buffer[i] == ',')
+          buffer[i] = '.';
+      out.write(buffer, static_cast<size_t>(length));
+    }
+
     void visitFloat(double value, int byteSize)
     {
       if (byteSize == 4)
-      {
-        out.precision(std::numeric_limits<float>::max_digits10);
-        out << ((float)value);
-      }
+        writeFloat(static_cast<float>(value), std::numeric_limits<float>::max_digits10);
       else if (byteSize == 8)
-      {
-        out.precision(std::numeric_limits<double>::max_digits10);
-        out << ((double)value);
-      }
+        writeFloat(value, std::numeric_limits<double>::max_digits10);
       else
-      {
         qiLogError() << "serialize on unknown float type " << byteSize;
-      }
     }
 
-    void visitString(const char* data, size_t size)
+    /// Historical escaping path, kept for the bytes the fast path below
+    /// does not handle: other control characters and non-ASCII input
+    /// (which may go through an UTF-8 decoding and \uXXXX escapes).
+    void writeEscapedWide(const char* data, size_t size)
     {
 #ifdef WITH_BOOST_LOCALE
-      out << "\"" << add_esc_chars(boost::locale::conv::to_utf<wchar_t>(std::string(data, size), "UTF-8"), jsonPrintOption) << "\"";
+      out << add_esc_chars(boost::locale::conv::to_utf<wchar_t>(std::string(data, size), "UTF-8"), jsonPrintOption);
 #else
-      out << "\"" << add_esc_chars(std::wstring(data, data+size), jsonPrintOption) << "\"";
+      out << add_esc_chars(std::wstring(data, data + size), jsonPrintOption);
 #endif
     }
 
+    void visitString(const char* data, size_t size)
+    {
+      out << '"';
+      if (jsonPrintOption & JsonOption_Expand)
+      {
+        // Expanded output reproduces most bytes verbatim; this debugging
+        // mode is not worth a second fast path.
+        writeEscapedWide(data, size);
+        out << '"';
+        return;
+      }
+      size_t i = 0;
+      while (i < size)
+      {
+        // Bulk-copy the run of bytes needing no escape, then handle the
+        // byte that stopped the scanner.
+        const size_t clean = cleanPrefixSize(data + i, size - i);
+        out.write(data + i, clean);
+        i += clean;
+        if (i >= size)
+          break;
+        const unsigned char c = static_cast<unsigned char>(data[i]);
+        if (const char* escape = twoCharEscape(c))
+        {
+          out.write(escape, 2);
+          ++i;
+          continue;
+        }
+        // Rare bytes (other controls, DEL, non-ASCII) go through the
+        // historical path. The consumed prefix is pure ASCII, so handing
+        // over mid-string never splits an UTF-8 sequence.
+        writeEscapedWide(data + i, size - i);
+        break;
+      }
+      out << '"';
+    }
+
     void visitList(AnyIterator begin, AnyIterator end)
     {
       out << "[";
@@ -328,12 +590,12 @@ namespace qi {
       }
     }
 
-    std::stringstream& out;
+    JsonArena& out;
     JsonOption jsonPrintOption;
     unsigned int indent;
   };
 
-  static void serialize(AnyReference val, std::stringstream& out, JsonOption jsonPrintOption, unsigned int indent)
+  static void serialize(AnyReference val, JsonArena& out, JsonOption jsonPrintOption, unsigned int indent)
   {
     SerializeJSONTypeVisitor stv(out, jsonPrintOption, indent);
     qi::typeDispatch(stv, val);
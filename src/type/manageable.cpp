@@ -1,9 +1,107 @@
+#include <atomic>
+#include <climits>
+#include <functional>
+#include <thread>
+
 #include <qi/type/detail/manageable.hpp>
 #include <qi/type/objecttypebuilder.hpp>
 #include "../type/signal_p.hpp"
 
 namespace qi
 {
+  namespace
+  {
+    /* Call statistics accumulators. pushStats() is on the path of every
+     * dispatched call once enableStats(true) is set, so values go into
+     * striped atomic counters instead of a mutex-guarded map: threads hash
+     * to a stripe, and each stripe holds a small open-addressed table of
+     * per-slot entries. Times are accumulated as integral microseconds so
+     * the sums are plain fetch_adds. stats() merges the stripes on read.
+     */
+    const unsigned int statsStripeCount = 8; // keep it a power of two
+    const unsigned int statsSlotsPerStripe = 32;
+
+    int64_t statsToUs(float seconds)
+    {
+      return static_cast<int64_t>(seconds * 1e6f);
+    }
+
+    struct AtomicMinMaxSum
+    {
+      std::atomic<int64_t> sumUs{0};
+      std::atomic<int64_t> minUs{INT64_MAX};
+      std::atomic<int64_t> maxUs{INT64_MIN};
+
+      void push(int64_t us)
+      {
+        sumUs.fetch_add(us, std::memory_order_relaxed);
+        int64_t cur = minUs.load(std::memory_order_relaxed);
+        while (us < cur && !minUs.compare_exchange_weak(cur, us, std::memory_order_relaxed))
+        {}
+        cur = maxUs.load(std::memory_order_relaxed);
+        while (us > cur && !maxUs.compare_exchange_weak(cur, us, std::memory_order_relaxed))
+        {}
+      }
+
+      void reset()
+      {
+        sumUs.store(0, std::memory_order_relaxed);
+        minUs.store(INT64_MAX, std::memory_order_relaxed);
+        maxUs.store(INT64_MIN, std::memory_order_relaxed);
+      }
+    };
+
+    struct AtomicMethodStats
+    {
+      std::atomic<int> slotId{-1};
+      std::atomic<unsigned int> count{0};
+      AtomicMinMaxSum wall;
+      AtomicMinMaxSum user;
+      AtomicMinMaxSum system;
+    };
+
+    struct StatsStripe
+    {
+      AtomicMethodStats slots[statsSlotsPerStripe];
+
+      // Find or claim the entry of slotId, NULL when the stripe is full.
+      AtomicMethodStats* entry(int slotId)
+      {
+        const unsigned int start = static_cast<unsigned int>(slotId) % statsSlotsPerStripe;
+        for (unsigned int i = 0; i < statsSlotsPerStripe; ++i)
+        {
+          AtomicMethodStats& candidate = slots[(start + i) % statsSlotsPerStripe];
+          int cur = candidate.slotId.load(std::memory_order_acquire);
+          if (cur == slotId)
+            return &candidate;
+          if (cur == -1)
+          {
+            int expected = -1;
+            if (candidate.slotId.compare_exchange_strong(expected, slotId,
+                                                         std::memory_order_acq_rel))
+              return &candidate;
+            if (expected == slotId) // another thread claimed it for the same slot
+              return &candidate;
+          }
+        }
+        return NULL;
+      }
+    };
+
+    // Merge microsecond aggregates into a MinMaxSum expressed in seconds.
+    MinMaxSum mergeMinMaxSum(const MinMaxSum& base, unsigned int baseCount,
+                             int64_t sumUs, int64_t minUs, int64_t maxUs)
+    {
+      const float sum = sumUs / 1e6f;
+      const float mn = minUs / 1e6f;
+      const float mx = maxUs / 1e6f;
+      if (baseCount == 0)
+        return MinMaxSum(mn, mx, sum);
+      return MinMaxSum((std::min)(base.minValue(), mn),
+                       (std::max)(base.maxValue(), mx),
+                       base.cumulatedValue() + sum);
+    }
+  }
 
   class ManageablePrivate
   {
@@ -20,7 +118,10 @@ namespace qi
 
     bool statsEnabled;
     bool traceEnabled;
+    // Fallback map, fed when the stripes overflow; guarded by registrationsMutex.
     ObjectStatistics stats;
+    // Striped atomic accumulators, allocated on the first enableStats(true).
+    std::atomic<StatsStripe*> statsStripes;
     qi::Atomic<int> traceId;
   };
 
@@ -28,6 +129,7 @@ namespace qi
     : dying(false)
     , statsEnabled(false)
     , traceEnabled(false)
+    , statsStripes(NULL)
   {
   }
 
@@ -44,6 +146,7 @@ namespace qi
       if(auto source = copy[i]._p->source.lock())
         source->disconnect(copy[i]._p->linkId).wait();
     }
+    delete[] statsStripes.load(std::memory_order_acquire);
   }
 
   Manageable::Manageable()
@@ -96,11 +199,35 @@ namespace qi
 
   void Manageable::enableStats(bool state)
   {
+    if (state && !_p->statsStripes.load(std::memory_order_acquire))
+    {
+      StatsStripe* stripes = new StatsStripe[statsStripeCount];
+      StatsStripe* expected = NULL;
+      if (!_p->statsStripes.compare_exchange_strong(expected, stripes,
+                                                    std::memory_order_acq_rel))
+        delete[] stripes; // someone else enabled stats concurrently
+    }
     _p->statsEnabled = state;
   }
 
   void Manageable::pushStats(int slotId, float wallTime, float userTime, float systemTime)
   {
+    StatsStripe* stripes = _p->statsStripes.load(std::memory_order_acquire);
+    if (stripes)
+    {
+      thread_local const unsigned int stripeIndex =
+          std::hash<std::thread::id>()(std::this_thread::get_id()) % statsStripeCount;
+      AtomicMethodStats* entry = stripes[stripeIndex].entry(slotId);
+      if (entry)
+      {
+        entry->count.fetch_add(1, std::memory_order_relaxed);
+        entry->wall.push(statsToUs(wallTime));
+        entry->user.push(statsToUs(userTime));
+        entry->system.push(statsToUs(systemTime));
+        return;
+      }
+    }
+    // Stripe full, or stats pushed without enableStats: mutex-guarded map.
     boost::mutex::scoped_lock l(_p->registrationsMutex);
     MethodStatistics& ms = _p->stats[slotId];
     ms.push(wallTime, userTime, systemTime);
@@ -108,14 +235,65 @@ namespace qi
 
   ObjectStatistics Manageable::stats() const
   {
-    boost::mutex::scoped_lock l(_p->registrationsMutex);
-    return _p->stats;
+    ObjectStatistics result;
+    {
+      boost::mutex::scoped_lock l(_p->registrationsMutex);
+      result = _p->stats;
+    }
+    StatsStripe* stripes = _p->statsStripes.load(std::memory_order_acquire);
+    if (!stripes)
+      return result;
+
+    for (unsigned int s = 0; s < statsStripeCount; ++s)
+    {
+      for (unsigned int i = 0; i < statsSlotsPerStripe; ++i)
+      {
+        const AtomicMethodStats& entry = stripes[s].slots[i];
+        const int slotId = entry.slotId.load(std::memory_order_acquire);
+        const unsigned int count = entry.count.load(std::memory_order_relaxed);
+        if (slotId < 0 || count == 0)
+          continue;
+        const MethodStatistics base = result[slotId];
+        result[slotId] = MethodStatistics(
+            base.count() + count,
+            mergeMinMaxSum(base.wall(), base.count(),
+                           entry.wall.sumUs.load(std::memory_order_relaxed),
+                           entry.wall.minUs.load(std::memory_order_relaxed),
+                           entry.wall.maxUs.load(std::memory_order_relaxed)),
+            mergeMinMaxSum(base.user(), base.count(),
+                           entry.user.sumUs.load(std::memory_order_relaxed),
+                           entry.user.minUs.load(std::memory_order_relaxed),
+                           entry.user.maxUs.load(std::memory_order_relaxed)),
+            mergeMinMaxSum(base.system(), base.count(),
+                           entry.system.sumUs.load(std::memory_order_relaxed),
+                           entry.system.minUs.load(std::memory_order_relaxed),
+                           entry.system.maxUs.load(std::memory_order_relaxed)));
+      }
+    }
+    return result;
   }
 
   void Manageable::clearStats()
   {
-    boost::mutex::scoped_lock l(_p->registrationsMutex);
-    _p->stats.clear();
+    {
+      boost::mutex::scoped_lock l(_p->registrationsMutex);
+      _p->stats.clear();
+    }
+    StatsStripe* stripes = _p->statsStripes.load(std::memory_order_acquire);
+    if (!stripes)
+      return;
+    // Keep the slot claims: a concurrent pusher may be writing the entry.
+    for (unsigned int s = 0; s < statsStripeCount; ++s)
+    {
+      for (unsigned int i = 0; i < statsSlotsPerStripe; ++i)
+      {
+        AtomicMethodStats& entry = stripes[s].slots[i];
+        entry.count.store(0, std::memory_order_relaxed);
+        entry.wall.reset();
+        entry.user.reset();
+        entry.system.reset();
+      }
+    }
   }
 
   bool Manageable::isTraceEnabled() const
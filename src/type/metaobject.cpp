@@ -9,6 +9,7 @@
 #include "metaobject_p.hpp"
 #include "metamethod_p.hpp"
 #include <boost/algorithm/string/predicate.hpp>
+#include <boost/thread/mutex.hpp>
 #include <qi/iocolor.hpp>
 #include <qi/detail/print.hpp>
 #include <iomanip>
@@ -33,19 +34,26 @@ qi::Atomic<int> MetaObjectPrivate::uid{1};
       boost::recursive_mutex::scoped_lock sl(rhs._methodsMutex);
       _objectNameToIdx = rhs._objectNameToIdx;
       _methods          = rhs._methods;
+      // same content, same hash: no need to recompute it
+      _contentSHA1 = rhs._contentSHA1;
+      _dirtyCache = rhs._dirtyCache;
     }
     {
       boost::recursive_mutex::scoped_lock sl(rhs._eventsMutex);
       _events = rhs._events;
+      _eventNameToIdx = rhs._eventNameToIdx;
     }
     {
       boost::recursive_mutex::scoped_lock sl(rhs._propertiesMutex);
       _properties = rhs._properties;
+      _propertyNameToIdx = rhs._propertyNameToIdx;
     }
     _index = rhs._index;
     _description = rhs._description;
-    // cache data uses pointers to map entries and must be refreshed
-    refreshCache();
+    // the overload index points into rhs's method map and cannot be carried
+    // over; rebuild it lazily on the first name lookup
+    _methodNameToOverload.clear();
+    _dirtyOverloadCache = true;
     return (*this);
   }
 
@@ -148,13 +156,13 @@ qi::Atomic<int> MetaObjectPrivate::uid{1};
    */
   int MetaObjectPrivate::findMethod(const std::string& nameWithOptionalSignature, const GenericFunctionParameters& args, bool* canCache) const
   {
-    // We can keep this outside the lock because we assume MetaMethods can't be
-    // removed
-    MetaMethod* firstOverload = nullptr;
+    bool hasOverloads = false;
     {
       boost::recursive_mutex::scoped_lock sl(_methodsMutex);
       if (_dirtyCache)
         const_cast<MetaObjectPrivate*>(this)->refreshCache();
+      else if (_dirtyOverloadCache)
+        const_cast<MetaObjectPrivate*>(this)->refreshOverloadCache();
       if (nameWithOptionalSignature.find(':') != nameWithOptionalSignature.npos)
       { // full name and signature was given, there can be only one match
         if (canCache)
@@ -182,7 +190,7 @@ qi::Atomic<int> MetaObjectPrivate::uid{1};
       MetaMethod* firstMatch = nullptr;
       bool ambiguous = false;
       size_t nargs = args.size();
-      for (MetaMethod* mm = overloadIt->second; mm; mm=mm->_p->next)
+      for (MetaMethod* mm: overloadIt->second)
       {
         QI_ASSERT(mm->name() == nameWithOptionalSignature);
         const Signature& sig = mm->parametersSignature();
@@ -210,12 +218,12 @@ qi::Atomic<int> MetaObjectPrivate::uid{1};
 
         return firstMatch->uid();
       }
-      firstOverload = overloadIt->second;
+      hasOverloads = true;
     }
 
     int retval = -2;
     // resolve ambiguity by using arguments
-    for (unsigned dyn = 0; dyn < 2; ++dyn)
+    for (unsigned dyn = 0; hasOverloads && dyn < 2; ++dyn)
     {
       // DO *NOT* hold the lock while resolving signatures dynamically. This
       // may block (and in case of python need the GIL)
@@ -223,18 +231,28 @@ qi::Atomic<int> MetaObjectPrivate::uid{1};
       {
         boost::recursive_mutex::scoped_lock sl(_methodsMutex);
         std::string resolvedSig = sResolved.toString();
-        std::string fullSig = nameWithOptionalSignature + "::" + resolvedSig;
-        qiLogDebug() << "Finding method for resolved signature " << fullSig;
+        qiLogDebug() << "Finding method for resolved signature "
+                     << nameWithOptionalSignature << "::" << resolvedSig;
         // First try an exact match, which is much faster if we're lucky.
         int idRev = methodId(nameWithOptionalSignature);
         if (idRev != -1)
           return idRev;
 
+        // The lock was released in between and the flat method table
+        // relocates its elements when it grows, so re-fetch the overload
+        // chain instead of keeping pointers across the gap.
+        if (_dirtyCache)
+          const_cast<MetaObjectPrivate*>(this)->refreshCache();
+        else if (_dirtyOverloadCache)
+          const_cast<MetaObjectPrivate*>(this)->refreshOverloadCache();
+        OverloadMap::const_iterator overloadIt = _methodNameToOverload.find(nameWithOptionalSignature);
+        if (overloadIt == _methodNameToOverload.end())
+          break; // methods are never removed, so this cannot happen
         using MethodsPtr = std::vector<std::pair<const MetaMethod*, float>>;
         MethodsPtr mml;
 
         // embed findCompatibleMethod
-        for (MetaMethod* mm = firstOverload; mm; mm=mm->_p->next)
+        for (MetaMethod* mm: overloadIt->second)
         { // still suboptimal, we are rescanning all overloads regardless of arg count
           float score = sResolved.isConvertibleTo(mm->parametersSignature());
           if (score)
@@ -256,7 +274,10 @@ qi::Atomic<int> MetaObjectPrivate::uid{1};
         }
         QI_ASSERT(count);
         if (count > 1) {
-          qiLogVerbose() << generateErrorString(nameWithOptionalSignature, fullSig, const_cast<MetaObjectPrivate*>(this)->findCompatibleMethod(nameWithOptionalSignature), -3, false);
+          qiLogVerbose() << generateErrorString(nameWithOptionalSignature,
+                                                nameWithOptionalSignature + "::" + resolvedSig,
+                                                const_cast<MetaObjectPrivate*>(this)->findCompatibleMethod(nameWithOptionalSignature),
+                                                -3, false);
           retval = -3;
         } else
           return it->first->uid();
@@ -372,6 +393,7 @@ qi::Atomic<int> MetaObjectPrivate::uid{1};
       uid = ++_index;
     const MetaSignal ms(uid, name, signature);
     _events[uid] = ms;
+    _eventNameToIdx[name] = uid;
     if (isSignalProperty)
     {
       _objectNameToIdx[ms.toString()] = MetaObjectIdType(uid, MetaObjectType_Property);
@@ -405,18 +427,19 @@ qi::Atomic<int> MetaObjectPrivate::uid{1};
       }
     }
 
-    for (MetaObject::PropertyMap::iterator it = _properties.begin(); it != _properties.end(); ++it)
     {
-      if (it->second.name() == name)
+      const auto known = _propertyNameToIdx.find(name);
+      if (known != _propertyNameToIdx.end())
       {
         qiLogWarning() << "Property already exists: " << name;
-        return MemberAddInfo(it->second.uid(), false);
+        return MemberAddInfo(known->second, false);
       }
     }
     if (id == -1)
       id = ++_index;
     const MetaProperty mp(id, name, signature);
     _properties[id] = mp;
+    _propertyNameToIdx[name] = id;
     _objectNameToIdx[mp.toString()] = MetaObjectIdType(id, MetaObjectType_Property);
     _dirtyCache = true;
     return MemberAddInfo(id, true);
@@ -428,7 +451,7 @@ qi::Atomic<int> MetaObjectPrivate::uid{1};
 
     for (const auto& method: mms) {
       newUid = method.second.uid();
-      MetaObject::MethodMap::iterator jt = _methods.find(newUid);
+      const auto jt = _methods.find(newUid);
       //same id and same signature: we dont mind.
       if (jt != _methods.end()) {
         if ((jt->second.toString() != method.second.toString()) ||
@@ -449,13 +472,14 @@ qi::Atomic<int> MetaObjectPrivate::uid{1};
 
     for (const auto& signal: mms) {
       newUid = signal.second.uid();
-      MetaObject::SignalMap::iterator jt = _events.find(newUid);
+      const auto jt = _events.find(newUid);
       if (jt != _events.end()) {
         if ((jt->second.toString() != signal.second.toString()))
           return false;
       }
       const qi::MetaSignal ms(newUid, signal.second.name(), signal.second.parametersSignature());
       _events[newUid] = ms;
+      _eventNameToIdx[ms.name()] = newUid;
       _objectNameToIdx[ms.toString()] = MetaObjectIdType(newUid, MetaObjectType_Signal);
     }
     _dirtyCache = true;
@@ -469,13 +493,14 @@ qi::Atomic<int> MetaObjectPrivate::uid{1};
 
     for (const auto& property: mms) {
       newUid = property.second.uid();
-      MetaObject::PropertyMap::iterator jt = _properties.find(newUid);
+      const auto jt = _properties.find(newUid);
       if (jt != _properties.end()) {
         if ((jt->second.toString() != property.second.toString()))
           return false;
       }
       const qi::MetaProperty mp(newUid, property.second.name(), property.second.signature());
       _properties[newUid] = mp;
+      _propertyNameToIdx[mp.name()] = newUid;
       _objectNameToIdx[mp.toString()] = MetaObjectIdType(newUid, MetaObjectType_Property);
     }
     _dirtyCache = true;
@@ -484,55 +509,107 @@ qi::Atomic<int> MetaObjectPrivate::uid{1};
   }
 
 
+  void MetaObjectPrivate::reserveMembers(std::size_t methodCount, std::size_t signalCount, std::size_t propertyCount)
+  {
+    boost::recursive_mutex::scoped_lock ml(_methodsMutex);
+    boost::recursive_mutex::scoped_lock el(_eventsMutex);
+    boost::recursive_mutex::scoped_lock pl(_propertiesMutex);
+    _methods.reserve(methodCount);
+    _events.reserve(signalCount);
+    _properties.reserve(propertyCount);
+    _objectNameToIdx.reserve(methodCount + signalCount + propertyCount);
+    _methodNameToOverload.reserve(methodCount);
+    _eventNameToIdx.reserve(signalCount);
+    _propertyNameToIdx.reserve(propertyCount);
+  }
+
   void MetaObjectPrivate::refreshCache()
   {
     // Both change on property(=event) and method will invalidate the cache.
     boost::recursive_mutex::scoped_lock ml(_methodsMutex);
     boost::recursive_mutex::scoped_lock el(_eventsMutex);
+    boost::recursive_mutex::scoped_lock pl(_propertiesMutex);
     unsigned int idx = 0;
-    std::ostringstream buff;
     {
       _objectNameToIdx.clear();
       _methodNameToOverload.clear();
       for (auto& metaMethodsSlot : _methods)
       {
         auto& metaMethod = metaMethodsSlot.second;
-        const std::string methodNameSignature = metaMethod.toString();
-        _objectNameToIdx[methodNameSignature] = MetaObjectIdType(metaMethod.uid(), MetaObjectType_Method);
+        _objectNameToIdx[metaMethod.toString()] = MetaObjectIdType(metaMethod.uid(), MetaObjectType_Method);
         idx = std::max(idx, metaMethod.uid());
-        buff << methodNameSignature << metaMethod.uid();
-
-        OverloadMap::iterator overloadIt = _methodNameToOverload.find(metaMethod.name());
-        if (overloadIt == _methodNameToOverload.end())
-        {
-          _methodNameToOverload[metaMethod.name()] = &metaMethod;
-          metaMethod._p->next = 0;
-        }
-        else
-        { // push_front
-          metaMethod._p->next =  overloadIt->second;
-          overloadIt->second = &metaMethod;
-        }
+        _methodNameToOverload[metaMethod.name()].push_back(&metaMethod);
       }
     }
     {
+      _eventNameToIdx.clear();
       for (auto& metaSignalSlot : _events)
       {
         auto& metaSignal = metaSignalSlot.second;
-        const auto metaSignalNameSignature = metaSignal.toString();
-        _objectNameToIdx[metaSignalNameSignature] = MetaObjectIdType(metaSignal.uid(), MetaObjectType_Signal);
+        _objectNameToIdx[metaSignal.toString()] = MetaObjectIdType(metaSignal.uid(), MetaObjectType_Signal);
+        _eventNameToIdx[metaSignal.name()] = metaSignal.uid();
         idx = std::max(idx, metaSignal.uid());
-        buff << metaSignalNameSignature << metaSignal.uid();
       }
     }
-    buff << _description;
+    {
+      _propertyNameToIdx.clear();
+      for (auto& metaPropertySlot : _properties)
+      {
+        auto& metaProperty = metaPropertySlot.second;
+        _propertyNameToIdx[metaProperty.name()] = metaProperty.uid();
+        idx = std::max(idx, metaProperty.uid());
+      }
+    }
 
     // never lower index
     _index = std::max(idx, _index.load());
 
-    // update content hash
-    _contentSHA1 = ka::sha1(buff.str());
+    // the content changed: drop the cached hash, contentHash() recomputes
+    // it on demand
+    _contentSHA1 = boost::none;
     _dirtyCache = false;
+    _dirtyOverloadCache = false;
+  }
+
+  void MetaObjectPrivate::refreshOverloadCache()
+  {
+    boost::recursive_mutex::scoped_lock ml(_methodsMutex);
+    _methodNameToOverload.clear();
+    for (auto& metaMethodsSlot : _methods)
+    {
+      auto& metaMethod = metaMethodsSlot.second;
+      _methodNameToOverload[metaMethod.name()].push_back(&metaMethod);
+    }
+    _dirtyOverloadCache = false;
+  }
+
+  void MetaObjectPrivate::computeContentHash()
+  {
+    boost::recursive_mutex::scoped_lock ml(_methodsMutex);
+    boost::recursive_mutex::scoped_lock el(_eventsMutex);
+    std::ostringstream buff;
+    for (const auto& metaMethodsSlot : _methods)
+    {
+      const auto& metaMethod = metaMethodsSlot.second;
+      buff << metaMethod.toString() << metaMethod.uid();
+    }
+    for (const auto& metaSignalSlot : _events)
+    {
+      const auto& metaSignal = metaSignalSlot.second;
+      buff << metaSignal.toString() << metaSignal.uid();
+    }
+    {
+      // Properties take part in the content hash: two interfaces differing
+      // only by a property must not be deduplicated into one.
+      boost::recursive_mutex::scoped_lock pl(_propertiesMutex);
+      for (const auto& metaPropertySlot : _properties)
+      {
+        const auto& metaProperty = metaPropertySlot.second;
+        buff << metaProperty.toString() << metaProperty.uid();
+      }
+    }
+    buff << _description;
+    _contentSHA1 = ka::sha1(buff.str());
   }
 
   void MetaObjectPrivate::setDescription(const std::string &desc) {
@@ -563,7 +640,7 @@ qi::Atomic<int> MetaObjectPrivate::uid{1};
 
   MetaMethod *MetaObject::method(unsigned int id) {
     boost::recursive_mutex::scoped_lock sl(_p->_methodsMutex);
-    MethodMap::iterator i = _p->_methods.find(id);
+    const auto i = _p->_methods.find(id);
     if (i == _p->_methods.end())
       return  nullptr;
     return &i->second;
@@ -571,7 +648,7 @@ qi::Atomic<int> MetaObjectPrivate::uid{1};
 
   const MetaMethod *MetaObject::method(unsigned int id) const {
     boost::recursive_mutex::scoped_lock sl(_p->_methodsMutex);
-    MethodMap::const_iterator i = _p->_methods.find(id);
+    const auto i = _p->_methods.find(id);
     if (i == _p->_methods.end())
       return  nullptr;
     return &i->second;
@@ -579,7 +656,7 @@ qi::Atomic<int> MetaObjectPrivate::uid{1};
 
   MetaSignal *MetaObject::signal(unsigned int id) {
     boost::recursive_mutex::scoped_lock sl(_p->_eventsMutex);
-    SignalMap::iterator i = _p->_events.find(id);
+    const auto i = _p->_events.find(id);
     if (i == _p->_events.end())
       return  nullptr;
     return &i->second;
@@ -587,7 +664,7 @@ qi::Atomic<int> MetaObjectPrivate::uid{1};
 
   const MetaSignal *MetaObject::signal(unsigned int id) const {
     boost::recursive_mutex::scoped_lock sl(_p->_eventsMutex);
-    SignalMap::const_iterator i = _p->_events.find(id);
+    const auto i = _p->_events.find(id);
     if (i == _p->_events.end())
       return  nullptr;
     return &i->second;
@@ -595,7 +672,7 @@ qi::Atomic<int> MetaObjectPrivate::uid{1};
 
   MetaProperty *MetaObject::property(unsigned int id) {
     boost::recursive_mutex::scoped_lock sl(_p->_propertiesMutex);
-    PropertyMap::iterator i = _p->_properties.find(id);
+    const auto i = _p->_properties.find(id);
     if (i == _p->_properties.end())
       return  nullptr;
     return &i->second;
@@ -603,7 +680,7 @@ qi::Atomic<int> MetaObjectPrivate::uid{1};
 
   const MetaProperty *MetaObject::property(unsigned int id) const {
     boost::recursive_mutex::scoped_lock sl(_p->_propertiesMutex);
-    PropertyMap::const_iterator i = _p->_properties.find(id);
+    const auto i = _p->_properties.find(id);
     if (i == _p->_properties.end())
       return  nullptr;
     return &i->second;
@@ -621,23 +698,23 @@ qi::Atomic<int> MetaObjectPrivate::uid{1};
 
   MetaObject::MethodMap MetaObject::methodMap() const {
     boost::recursive_mutex::scoped_lock sl(_p->_methodsMutex);
-    return _p->_methods;
+    return MethodMap(_p->_methods.begin(), _p->_methods.end());
   }
 
   MetaObject::SignalMap MetaObject::signalMap() const {
     boost::recursive_mutex::scoped_lock sl(_p->_eventsMutex);
-    return _p->_events;
+    return SignalMap(_p->_events.begin(), _p->_events.end());
   }
 
   MetaObject::PropertyMap MetaObject::propertyMap() const {
     boost::recursive_mutex::scoped_lock sl(_p->_propertiesMutex);
-    return _p->_properties;
+    return PropertyMap(_p->_properties.begin(), _p->_properties.end());
   }
 
   int MetaObject::propertyId(const std::string& name) const
   {
     boost::recursive_mutex::scoped_lock sl(_p->_propertiesMutex);
-    for (PropertyMap::iterator it = _p->_properties.begin();
+    for (auto it = _p->_properties.begin();
       it != _p->_properties.end(); ++it)
     {
       if (it->second.name() == name)
@@ -695,6 +772,11 @@ qi::Atomic<int> MetaObjectPrivate::uid{1};
   {
   }
 
+  void MetaObjectBuilder::reserve(std::size_t methodCount, std::size_t signalCount, std::size_t propertyCount)
+  {
+    _p->metaObject._p->reserveMembers(methodCount, signalCount, propertyCount);
+  }
+
   MemberAddInfo MetaObjectBuilder::addMethod(const qi::Signature& sigret,
                                             const std::string& name,
                                             const qi::Signature& signature,
@@ -768,6 +850,18 @@ namespace qi {
 
   MetaObject::MetaObject(const MethodMap& methodMap, const SignalMap& signalMap,
     const PropertyMap& propertyMap, const std::string& description)
+  {
+    _p = new MetaObjectPrivate();
+    // the inputs are sorted, so filling the flat tables is a linear append
+    _p->_methods.insert(methodMap.begin(), methodMap.end());
+    _p->_events.insert(signalMap.begin(), signalMap.end());
+    _p->_properties.insert(propertyMap.begin(), propertyMap.end());
+    _p->_description = description;
+    _p->refreshCache();
+  }
+
+  MetaObject::MetaObject(const MethodFlatMap& methodMap, const SignalFlatMap& signalMap,
+    const PropertyFlatMap& propertyMap, const std::string& description)
   {
     _p = new MetaObjectPrivate();
     _p->_methods = methodMap;
@@ -777,8 +871,33 @@ namespace qi {
     _p->refreshCache();
   }
 
+  MetaObject MetaObject::intern(const MetaObject &mo)
+  {
+    using Pool = std::map<ka::sha1_digest_t, MetaObject>;
+    static Pool* pool = nullptr;
+    static boost::mutex* mutex = nullptr;
+    QI_THREADSAFE_NEW(pool, mutex);
+    // hash outside the pool lock, it may refresh the metaobject cache
+    const ka::sha1_digest_t hash = mo.contentHash();
+    boost::mutex::scoped_lock lock(*mutex);
+    Pool::iterator it = pool->find(hash);
+    if (it == pool->end())
+      it = pool->insert(std::make_pair(hash, mo)).first;
+    return it->second;
+  }
+
+  ka::sha1_digest_t MetaObject::contentHash() const
+  {
+    boost::recursive_mutex::scoped_lock sl(_p->_methodsMutex);
+    if (_p->_dirtyCache)
+      _p->refreshCache();
+    if (!_p->_contentSHA1)
+      _p->computeContentHash();
+    return *_p->_contentSHA1;
+  }
+
   bool operator < (const MetaObject& a, const MetaObject& b)
   {
-    return a._p->_contentSHA1 < b._p->_contentSHA1;
+    return a.contentHash() < b.contentHash();
   }
 }
@@ -8,6 +8,7 @@
 #pragma once
 
 #include <array>
+#include <unordered_map>
 #include <boost/optional.hpp>
 #include <boost/thread/recursive_mutex.hpp>
 #include <ka/macroregular.hpp>
@@ -28,6 +29,7 @@ namespace qi {
     MetaObjectPrivate()
       : _index(qiObjectSpecialMemberMaxUid - 1)
       , _dirtyCache(false)
+      , _dirtyOverloadCache(false)
     {
     }
 
@@ -57,7 +59,9 @@ namespace qi {
       MetaObjectType type{MetaObjectType_None};
     };
 
-    using SignatureToIdx = std::map<std::string, MetaObjectIdType>;
+    // Hash-indexed so that the per-call exact "name::(sig)" lookup done by
+    // the dispatcher is O(1) instead of a string-comparing tree walk.
+    using SignatureToIdx = std::unordered_map<std::string, MetaObjectIdType>;
     inline int idFromName(const SignatureToIdx& map, const std::string& sig, MetaObjectType type = MetaObjectType_None) const {
       SignatureToIdx::const_iterator it = map.find(sig);
       if (it != map.end())
@@ -80,10 +84,13 @@ namespace qi {
       int id = idFromName(_objectNameToIdx, signature, MetaObjectType_Signal);
       if (id == -1)
       {
-        // if the name is a name and not a signature search directly inside the signal map
-        for (const auto& ms : _events)
-          if (ms.second.name() == signature)
-            return ms.first;
+        // if the name is a name and not a signature search directly inside
+        // the name index. Kept hash-indexed: this miss path runs for every
+        // member added (duplicate detection), so a linear scan of _events
+        // here would make building an N-member interface quadratic.
+        const auto it = _eventNameToIdx.find(signature);
+        if (it != _eventNameToIdx.end())
+          return it->second;
       }
       return id;
     }
@@ -151,8 +158,24 @@ namespace qi {
     */
     MemberAddInfo addProperty(const std::string& name, const Signature &signature, int id = -1);
 
+    /** Preallocates the member tables for the expected number of members.
+
+        Only a hint: the tables still grow on demand past these counts.
+        Reserving up front avoids repeated rehashing of the name indexes
+        and repeated relocation of the flat member tables while a large
+        interface is being built member by member.
+    */
+    void reserveMembers(std::size_t methodCount, std::size_t signalCount, std::size_t propertyCount);
+
     // Recompute data cached in *ToIdx
     void refreshCache();
+    // Rebuild only the name-to-overloads index; copies cannot carry it over
+    // since it points into the instance's own method map.
+    void refreshOverloadCache();
+    // Hash the interface content into _contentSHA1. Deferred to the first
+    // contentHash() call so building or copying a metaobject does not pay
+    // for it.
+    void computeContentHash();
 
     void setDescription(const std::string& desc);
 
@@ -165,23 +188,38 @@ namespace qi {
     /*
      * When a member is added, serialization and deserialization
      * operators _MUST_ be updated.
+     *
+     * The member tables are sorted flat maps: built once when the interface
+     * is assembled, then read on every dispatch and introspection, so an
+     * object's whole member metadata shares a few contiguous cache lines.
+     * The flip side is that growing a table relocates its elements: any
+     * mutation sets _dirtyCache so the pointer-holding indexes below are
+     * rebuilt before their next use.
      */
     //name::sig() -> Index
-    MetaObject::MethodMap               _methods;
+    MetaObject::MethodFlatMap           _methods;
 
   private:
     mutable boost::recursive_mutex      _methodsMutex;
 
   public:
-    using OverloadMap = std::map<std::string, MetaMethod*>;
+    // Overloads of one name, pointing into _methods. Kept outside
+    // MetaMethodPrivate so pooled metaobjects can share method payloads
+    // without one instance's cache refresh clobbering another's chains.
+    using OverloadMap = std::unordered_map<std::string, std::vector<MetaMethod*>>;
     OverloadMap                         _methodNameToOverload;
 
     //name::sig() -> Index
     SignatureToIdx                      _objectNameToIdx;
-    MetaObject::SignalMap               _events;
+    MetaObject::SignalFlatMap           _events;
+    // Plain signal name -> uid, so signalId()'s by-name fallback (hit once
+    // per member added, for duplicate detection) stays O(1).
+    std::unordered_map<std::string, unsigned int> _eventNameToIdx;
     mutable boost::recursive_mutex      _eventsMutex;
 
-    MetaObject::PropertyMap             _properties;
+    MetaObject::PropertyFlatMap         _properties;
+    // Plain property name -> uid, same role as _eventNameToIdx.
+    std::unordered_map<std::string, unsigned int> _propertyNameToIdx;
     mutable boost::recursive_mutex      _propertiesMutex;
 
     qi::Atomic<unsigned int>            _index;
@@ -191,6 +229,8 @@ namespace qi {
     // true if cache must be refreshed
     mutable bool                        _dirtyCache;
 
+    // true if only _methodNameToOverload is stale (after a copy)
+    mutable bool                        _dirtyOverloadCache;
 
     boost::optional<ka::sha1_digest_t>  _contentSHA1;
 
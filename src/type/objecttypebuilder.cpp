@@ -125,7 +125,7 @@ namespace qi {
     if (!_p->type)
     {
       detail::StaticObjectTypeBase* t = new detail::StaticObjectTypeBase();
-      t->initialize(metaObject(), _p->data);
+      t->initialize(MetaObject::intern(metaObject()), _p->data);
       _p->type = t;
       if (_p->autoRegister)
         registerType();
@@ -32,6 +32,23 @@ namespace qi {
     disconnectAll();
   }
 
+  void SignalBasePrivate::publishSubscriberMap()
+  {
+    boost::atomic_store(&subscriberMapSnapshot,
+                        boost::shared_ptr<const SignalSubscriberMap>(
+                            boost::make_shared<SignalSubscriberMap>(subscriberMap)));
+    snapshotStale.store(false, std::memory_order_release);
+  }
+
+  void SignalBasePrivate::refreshSnapshotIfStale()
+  {
+    if (!snapshotStale.load(std::memory_order_acquire))
+      return;
+    boost::recursive_mutex::scoped_lock lock(mutex);
+    if (snapshotStale.load(std::memory_order_relaxed))
+      publishSubscriberMap();
+  }
+
   Future<bool> SignalBasePrivate::disconnect(const SignalLink& l)
   {
     SignalSubscriber subscriber;
@@ -47,8 +64,16 @@ namespace qi {
         return Future<bool>{false};
       }
       subscriber = it->second;
-      // Remove from map (but SignalSubscriber object still good)
+      // Remove from map (but SignalSubscriber object still good). The
+      // published snapshot keeps the entry as a tombstone, skipped on emit
+      // through `enabled`; rebuilding it is deferred to the next emit or
+      // connect, except when the map just emptied and the rebuild is cheap
+      // and releases the last subscriber handlers.
       subscriberMap.erase(it);
+      if (subscriberMap.empty())
+        publishSubscriberMap();
+      else
+        snapshotStale.store(true, std::memory_order_release);
       if (subscriberMap.empty() && onSubscribers)
         onSubscribersToCall = onSubscribers;
       // Ensure no call on subscriber occurs once this function returns
@@ -62,32 +87,27 @@ namespace qi {
 
   Future<bool> SignalBasePrivate::disconnectAll()
   {
-    return disconnectAllStep(true);
-  }
-
-  Future<bool> SignalBasePrivate::disconnectAllStep(bool overallSuccess)
-  {
-    SignalLink link;
-    FutureBarrier<bool> barrier;
-    while (true)
+    // Drop every subscription in one swap: disable the subscribers so
+    // emits in flight skip them, move the map out and publish the empty
+    // snapshot, instead of one map rebuild per link.
+    SignalSubscriberMap dropped;
+    Future<void> callingOnSubscribers{nullptr};
+    SignalBase::OnSubscribers onSubscribersToCall;
     {
-      {
-        boost::recursive_mutex::scoped_lock sl(mutex);
-        SignalSubscriberMap::iterator it = subscriberMap.begin();
-        if (it == subscriberMap.end())
-          break;
-        link = it->first;
-      }
-      // allow for multiple disconnects to occur at the same time, we must not
-      // keep the lock
-      barrier.addFuture(disconnect(link));
+      boost::recursive_mutex::scoped_lock sigLock(mutex);
+      if (subscriberMap.empty())
+        return Future<bool>{true};
+      dropped.swap(subscriberMap);
+      for (auto& entry: dropped)
+        entry.second._p->enabled = false;
+      publishSubscriberMap();
+      if (onSubscribers)
+        onSubscribersToCall = onSubscribers;
     }
-    return barrier.future().andThen([](const std::vector<Future<bool>>& successes)
-    {
-      for (const auto& success: successes)
-        if (!success.value()) return false;
-      return true;
-    });
+    if (onSubscribersToCall)
+      callingOnSubscribers = onSubscribersToCall(false);
+
+    return callingOnSubscribers.andThen([](void*) { return true; });
   }
 
   SignalSubscriberPrivate::SignalSubscriberPrivate() = default;
@@ -128,6 +148,13 @@ QI_WARNING_POP()
 
   SignalSubscriber::~SignalSubscriber() = default;
 
+  void SignalSubscriber::_setTypedHandler(boost::shared_ptr<void> handler,
+                                          const std::type_info& type)
+  {
+    _p->typedHandlerType = &type;
+    _p->typedHandler = std::move(handler);
+  }
+
   static std::atomic<SignalLink> linkUid{1};
 
   void SignalBase::setCallType(MetaCallType callType)
@@ -163,7 +190,7 @@ QI_WARNING_POP()
                      << signature.toString() << " " << _p->signature.toString();
         return MetaCallType_Auto;
       }
-      return _p->defaultCallType;
+      return _p->defaultCallType.load();
     }();
 
     trigger(params, mct);
@@ -183,6 +210,41 @@ QI_WARNING_POP()
       callSubscribers(params, callType);
   }
 
+  bool SignalBase::_tryTriggerTyped(const std::type_info& type,
+                                    const boost::function<void(void*)>& invoke)
+  {
+    QI_ASSERT(_p);
+    {
+      boost::recursive_mutex::scoped_lock lock(_p->mutex);
+      if (_p->triggerOverride)
+        return false;
+    }
+    _p->refreshSnapshotIfStale();
+    const auto subscribers = boost::atomic_load(&_p->subscriberMapSnapshot);
+    if (!subscribers || subscribers->empty())
+      return true;
+    const MetaCallType mct = _p->defaultCallType;
+    for (const auto& i: *subscribers)
+    {
+      const SignalSubscriber& s = i.second;
+      // A single subscriber needing the type-erased path (no typed handler,
+      // different type, or posted to an execution context and thus outliving
+      // our caller's arguments) means we box once for everyone.
+      if (!s._p->typedHandler || *s._p->typedHandlerType != type ||
+          s.executionContextFor(mct))
+        return false;
+    }
+    for (const auto& i: *subscribers)
+    {
+      SignalSubscriber s = i.second; // holds the subscription alive
+      if (!s._p->enabled)
+        continue;
+      qiLogDebug() << this << " Invoking signal subscriber (typed fast path)";
+      invoke(s._p->typedHandler.get());
+    }
+    return true;
+  }
+
   void SignalBase::setTriggerOverride(Trigger t)
   {
     QI_ASSERT(_p);
@@ -199,10 +261,10 @@ QI_WARNING_POP()
 
   namespace {
     template<typename Params>
-    void callSubscribersImpl(const SignalBase& x, SignalSubscriberMap& subscribers,
+    void callSubscribersImpl(const SignalBase& x, const SignalSubscriberMap& subscribers,
                              const Params& params, MetaCallType callType)
     {
-      for (auto& i: subscribers)
+      for (const auto& i: subscribers)
       {
         qiLogDebug() << &x << " Invoking signal subscriber";
         SignalSubscriber s = i.second; // holds the subscription alive
@@ -216,14 +278,21 @@ QI_WARNING_POP()
     MetaCallType mct = callType;
     QI_ASSERT(_p);
 
-    SignalSubscriberMap copy;
-    {
-      boost::recursive_mutex::scoped_lock lock(_p->mutex);
-      if (mct == qi::MetaCallType_Auto)
-        mct = _p->defaultCallType;
+    if (mct == qi::MetaCallType_Auto)
+      mct = _p->defaultCallType;
 
-      copy = _p->subscriberMap;
+    // Immutable snapshot republished on connect, and lazily here after
+    // disconnects tombstoned entries in it: no lock and no copy of the map
+    // on the steady-state emit path. Subscribers disconnected while we
+    // iterate are skipped through their `enabled` flag, as before.
+    _p->refreshSnapshotIfStale();
+    const auto copyPtr = boost::atomic_load(&_p->subscriberMapSnapshot);
+    if (!copyPtr || copyPtr->empty())
+    {
+      qiLogDebug() << this << " Invoking signal subscribers: 0";
+      return;
     }
+    const SignalSubscriberMap& copy = *copyPtr;
     qiLogDebug() << this << " Invoking signal subscribers: " << copy.size();
 
     // If any subscriber is going to use an execution context, it's going to
@@ -299,6 +368,12 @@ QI_WARNING_POP()
     {
       return {};
     }
+    if (_p->directConnection)
+    {
+      // The subscriber asked to run in the emitter's thread, whatever the
+      // threading model or execution context say.
+      return {};
+    }
     bool async = true;
     if (_p->threadingModel != MetaCallType_Auto)
     {
@@ -377,6 +452,40 @@ QI_WARNING_POP()
     return *this;
   }
 
+  SignalSubscriber SignalSubscriber::setDirectConnection()
+  {
+    _p->directConnection = true;
+    return *this;
+  }
+
+  SignalSubscriber SignalSubscriber::setMaxEventRate(float maxRateHz)
+  {
+    _p->maxEventRate = maxRateHz > 0.0f ? maxRateHz : 0.0f;
+    return *this;
+  }
+
+  float SignalSubscriber::maxEventRate() const
+  {
+    return _p->maxEventRate;
+  }
+
+  SignalSubscriber SignalSubscriber::setAckWindow(int window, bool coalesceLatest)
+  {
+    _p->ackWindow = window > 0 ? window : 0;
+    _p->ackCoalesce = coalesceLatest;
+    return *this;
+  }
+
+  int SignalSubscriber::ackWindow() const
+  {
+    return _p->ackWindow;
+  }
+
+  bool SignalSubscriber::ackCoalesce() const
+  {
+    return _p->ackCoalesce;
+  }
+
   SignalLink SignalSubscriber::link() const
   {
     return _p->linkId;
@@ -461,6 +570,7 @@ QI_WARNING_POP()
     subscriberInMap = src;
     subscriberInMap._p->linkId = res;
     subscriberInMap._p->source = this->_p;
+    _p->publishSubscriberMap();
     Future<void> callingOnSubscribers{nullptr};
     if (first && _p->onSubscribers)
     {
@@ -501,6 +611,10 @@ QI_WARNING_POP()
       return;
 
     _p->subscriberMap.erase(it->second);
+    if (_p->subscriberMap.empty())
+      _p->publishSubscriberMap();
+    else
+      _p->snapshotStale.store(true, std::memory_order_release);
     _p->trackMap.erase(it);
   }
 
@@ -7,7 +7,9 @@
 #ifndef _SRC_SIGNAL_P_HPP_
 #define _SRC_SIGNAL_P_HPP_
 
+#include <atomic>
 #include <qi/signal.hpp>
+#include <boost/shared_ptr.hpp>
 #include <boost/thread/thread.hpp>
 #include <boost/thread/recursive_mutex.hpp>
 
@@ -30,16 +32,31 @@ namespace qi {
 
   private:
     friend class SignalBase;
-    Future<bool> disconnectAllStep(bool overallSuccess);
+
+    /// Republishes subscriberMapSnapshot from subscriberMap. Must be called
+    /// with mutex held, after every mutation of subscriberMap.
+    void publishSubscriberMap();
+
+    /// Republishes the snapshot if disconnects tombstoned entries in it.
+    /// Called from the emit paths, before loading the snapshot.
+    void refreshSnapshotIfStale();
 
     SignalBase::OnSubscribers      onSubscribers;
     ExecutionContext*              execContext;
     SignalSubscriberMap            subscriberMap;
+    // Immutable snapshot of subscriberMap, swapped with boost::atomic_store on
+    // every (rare) connect so that trigger can iterate it with a single
+    // boost::atomic_load - no lock and no per-emit copy. Disconnects do not
+    // pay the rebuild: they disable the subscriber, leave it as a tombstone
+    // in the published snapshot and raise snapshotStale; the next emit (or
+    // map mutation) republishes and reclaims the tombstones.
+    boost::shared_ptr<const SignalSubscriberMap> subscriberMapSnapshot;
+    std::atomic<bool>              snapshotStale{false};
     TrackMap                       trackMap;
     qi::Atomic<int>                trackId;
     qi::Signature                  signature;
     boost::recursive_mutex         mutex;
-    MetaCallType                   defaultCallType;
+    std::atomic<MetaCallType>      defaultCallType;
     SignalBase::Trigger            triggerOverride;
   };
 
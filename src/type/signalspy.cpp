@@ -38,6 +38,69 @@ SignalSpy::SignalSpy(qi::AnyObject& object, const std::string& signalOrPropertyN
   _disconnect = [link, object]{ object.disconnect(link).value(); };
 }
 
+SignalSpy::SignalSpy(qi::AnyObject& object, const std::string& signalOrPropertyName, RingRecording ring)
+  : _records()
+{
+  initRing(ring);
+  // Direct connection: the append happens in the emitter's own context,
+  // lock-free, so spying does not reschedule or slow the signal down.
+  SignalLink link = object.connect(
+    signalOrPropertyName,
+    SignalSubscriber(qi::AnyFunction::fromDynamicFunction(
+        [this](qi::AnyReferenceVector anything) -> AnyReference {
+          std::vector<AnyValue> values;
+          if (_ringKeepValues)
+          {
+            values.reserve(anything.size());
+            for (const auto& arg: anything)
+              values.emplace_back(arg.to<qi::AnyValue>());
+          }
+          this->ringAppend(std::move(values));
+          return AnyReference();
+        })).setCallType(MetaCallType_Direct)).value();
+  _disconnect = [link, object]{ object.disconnect(link).value(); };
+}
+
+void SignalSpy::initRing(const RingRecording& ring)
+{
+  _ringSize = ring.slots ? ring.slots : 1;
+  _ringKeepValues = ring.keepValues;
+  _ring.reset(new RingSlot[_ringSize]);
+}
+
+void SignalSpy::ringAppend(std::vector<AnyValue> values)
+{
+  const uint64_t n = _ringEmissions.fetch_add(1, std::memory_order_relaxed);
+  RingSlot& slot = _ring[n % _ringSize];
+  slot.seq.store(2 * n + 1, std::memory_order_release); // writer in the slot
+  slot.timestamp = SteadyClock::now();
+  slot.args = std::move(values);
+  slot.seq.store(2 * n + 2, std::memory_order_release); // emission n complete
+  recorded();
+}
+
+std::vector<SignalSpy::Record> SignalSpy::ringRecords() const
+{
+  const uint64_t total = _ringEmissions.load(std::memory_order_acquire);
+  const uint64_t first = total > _ringSize ? total - _ringSize : 0;
+  std::vector<Record> records;
+  records.reserve(static_cast<size_t>(total - first));
+  for (uint64_t n = first; n < total; ++n)
+  {
+    RingSlot& slot = _ring[n % _ringSize];
+    const uint64_t seq = slot.seq.load(std::memory_order_acquire);
+    if (seq != 2 * n + 2)
+      continue; // writer in the slot, or already overwritten
+    Record record;
+    record.timestamp = slot.timestamp;
+    record.args = slot.args;
+    if (slot.seq.load(std::memory_order_acquire) != seq)
+      continue; // a writer lapped us meanwhile, the copy may be torn
+    records.emplace_back(std::move(record));
+  }
+  return records;
+}
+
 SignalSpy::~SignalSpy()
 {
   try
@@ -53,6 +116,8 @@ SignalSpy::~SignalSpy()
 
 std::vector<SignalSpy::Record> SignalSpy::allRecords() const
 {
+  if (_ring)
+    return ringRecords();
   return async([this]
   { return _records;
   }).value();
@@ -63,6 +128,20 @@ SignalSpy::Record SignalSpy::record(size_t index) const
   qiLogDebug() << "Getting record #" << index << " "
                << (strand()->isInThisContext() ? "from strand" : "from outside");
 
+  if (_ring)
+  {
+    // Indexing is relative to the retained window, the ring having
+    // overwritten anything older.
+    std::vector<Record> records = ringRecords();
+    if (index >= records.size())
+    {
+      std::stringstream message;
+      message << "index " << index << " is out of range";
+      throw std::runtime_error(message.str());
+    }
+    return records[index];
+  }
+
   return async([this, index]
   {
     if(index >= _records.size())
@@ -77,6 +156,12 @@ SignalSpy::Record SignalSpy::record(size_t index) const
 
 SignalSpy::Record SignalSpy::lastRecord() const
 {
+  if (_ring)
+  {
+    std::vector<Record> records = ringRecords();
+    assert(!records.empty());
+    return records.back();
+  }
   return async([this]
   {
     assert(!_records.empty()); return _records.back();
@@ -86,6 +171,8 @@ size_t SignalSpy::recordCount() const
 {
   qiLogDebug() << "Getting record count "
                << (strand()->isInThisContext() ? "from strand" : "from outside");
+  if (_ring)
+    return currentCount();
   return async([this]
   {
     qiLogDebug() << "Getting record count";
@@ -95,7 +182,7 @@ size_t SignalSpy::recordCount() const
 
 unsigned int SignalSpy::getCounter() const
 {
-  return async([&]{ return static_cast<unsigned int>(_records.size()); }).value();
+  return static_cast<unsigned int>(recordCount());
 }
 
 FutureSync<bool> SignalSpy::waitUntil(size_t nofRecords, const qi::Duration& timeout) const
@@ -103,7 +190,7 @@ FutureSync<bool> SignalSpy::waitUntil(size_t nofRecords, const qi::Duration& tim
   return async([this, nofRecords, timeout]
   {
     // If the target is already reached, return immediately.
-    if(nofRecords <= _records.size())
+    if(nofRecords <= currentCount())
       return Future<bool>{true};
 
     // We will track the list of records.
@@ -133,13 +220,15 @@ FutureSync<bool> SignalSpy::waitUntil(size_t nofRecords, const qi::Duration& tim
     // Tracking the records.
     // Since the record list is only edited from the strand, a direct signal connection
     // will keep us in the strand. So there is no need for stranding the callback.
+    // In ring mode `recorded` fires from the emitter's context instead, and
+    // currentCount() is readable from anywhere.
     waitTracking->signalLink = recorded.connect([waitTracking, this, nofRecords]() mutable
     {
       auto& waiting = waitTracking->waitingPromise;
       if (!waiting.future().isRunning())
         return;
 
-      if (nofRecords <= _records.size())
+      if (nofRecords <= currentCount())
       {
         waiting.setValue(true);
         waitTracking->untrack();
@@ -156,6 +245,7 @@ AnyReference SignalSpy::recordAnyCallback(const qi::AnyReferenceVector& args)
   Record record;
   for (const auto& arg: args)
     record.args.emplace_back(arg.to<qi::AnyValue>());
+  record.timestamp = SteadyClock::now();
   _records.emplace_back(std::move(record));
   recorded();
   return AnyReference();
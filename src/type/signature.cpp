@@ -3,6 +3,8 @@
 **  See COPYING for the license
 */
 #include <cstring>
+#include <map>
+#include <mutex>
 
 #include <qi/assert.hpp>
 #include <qi/signature.hpp>
@@ -108,6 +110,10 @@ namespace qi {
      * - comparison between integral types
      * - Weaker error score for deeper (in containers) struct.
      */
+    // Interned signatures share their parsed tree, so identical signatures
+    // are detected with a pointer comparison.
+    if (_p == b._p)
+      return 1.0f;
     float error = 0.f;
     float childErr = 1.0f;
     const auto calculateFactor = [&] {
@@ -463,29 +469,62 @@ namespace qi {
     _signature.assign(signature, begin, end - begin);
   }
 
+  namespace
+  {
+    /// Process-wide intern cache of parsed signatures.
+    ///
+    /// A SignaturePrivate is immutable once init() has run, so distinct
+    /// Signature instances built from the same string can all share the same
+    /// parsed tree (children included). Call resolution keeps re-parsing a
+    /// small set of method signatures, and with interning those lookups
+    /// become a hash probe instead of a full parse plus one allocation per
+    /// subsignature.
+    boost::shared_ptr<SignaturePrivate> internSignature(const std::string& signature,
+                                                        size_t begin, size_t end)
+    {
+      static std::mutex mutex;
+      static std::map<std::string, boost::shared_ptr<SignaturePrivate>> cache;
+      // Deployments see a finite set of signatures, but guard against
+      // unbounded growth if someone generates them dynamically.
+      static const size_t maxCachedSignatures = 4096;
+
+      std::string key(signature, begin, end - begin);
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        const auto it = cache.find(key);
+        if (it != cache.end())
+          return it->second;
+      }
+      auto p = boost::make_shared<SignaturePrivate>();
+      p->init(key, 0, key.size());
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (cache.size() < maxCachedSignatures)
+          return cache.emplace(std::move(key), std::move(p)).first->second;
+      }
+      return p;
+    }
+  }
+
   Signature::Signature()
     : _p(boost::make_shared<SignaturePrivate>())
   {
   }
 
   Signature::Signature(const char *signature)
-    : _p(boost::make_shared<SignaturePrivate>())
+    : _p(internSignature(signature, 0, strlen(signature)))
   {
-    _p->_signature.assign(signature);
-    _p->init(_p->_signature, 0, _p->_signature.size());
   }
 
 
   Signature::Signature(const std::string &signature)
-    : _p(boost::make_shared<SignaturePrivate>())
+    : _p(internSignature(signature, 0, signature.size()))
   {
-    _p->init(signature, 0, signature.size());
   }
 
   Signature::Signature(const std::string &signature, size_t begin, size_t end)
-    : _p(boost::make_shared<SignaturePrivate>())
+    : _p(internSignature(signature, begin, end))
   {
-    _p->init(signature, begin, end);
   }
 
   bool Signature::isValid() const {
@@ -590,6 +629,8 @@ namespace qi {
   //compare signature without taking annotation into account
   bool operator==(const Signature& lhs, const Signature& rhs)
   {
+    if (lhs._p == rhs._p)
+      return true;
     if (lhs.type() != rhs.type())
       return false;
     if (lhs.children().size() != rhs.children().size())
@@ -42,4 +42,156 @@ namespace qi
     for (unsigned i=0; i<values.size(); ++i)
       set(storage, i, values[i]);
   }
+
+  namespace {
+    // Member address inside a probe instance, or null if the member is not
+    // reachable in place (boxed by-value storage for instance).
+    void* memberAddress(StructTypeInterface* type, void* storage,
+                        TypeInterface* member, unsigned int index)
+    {
+      void* fieldStorage = type->get(storage, index);
+      if (!fieldStorage)
+        return nullptr;
+      return member->ptrFromStorage(&fieldStorage);
+    }
+
+    // Offsets of the leaf members of a probe instance with base address
+    // `base`, appended to `fields`. Returns false on a member the flat
+    // codec cannot handle.
+    bool probeFields(StructTypeInterface* type, void* storage, char* base,
+                     std::vector<StructTypeInterface::FlatLayout::Field>& fields)
+    {
+      std::vector<TypeInterface*> members = type->memberTypes();
+      for (unsigned int i = 0; i < members.size(); ++i)
+      {
+        TypeInterface* member = members[i];
+        size_t size = 0;
+        StructTypeInterface::FlatLayout::FieldKind kind =
+            StructTypeInterface::FlatLayout::Field_Scalar;
+        switch (member->kind())
+        {
+        case TypeKind_Int:
+          // bool reports size 0 and is stored and serialized as one byte
+          size = static_cast<IntTypeInterface*>(member)->size();
+          if (size == 0)
+            size = sizeof(bool);
+          break;
+        case TypeKind_Float:
+          size = static_cast<FloatTypeInterface*>(member)->size();
+          break;
+        case TypeKind_String:
+          // only std::string has a known in-place representation; other
+          // string types go through the generic visitor
+          if (member->info() != typeOf<std::string>()->info())
+            return false;
+          kind = StructTypeInterface::FlatLayout::Field_String;
+          break;
+        case TypeKind_Tuple:
+        {
+          // nested struct: splice its own leaves at our offset
+          char* nestedBase = static_cast<char*>(
+              memberAddress(type, storage, member, i));
+          if (!nestedBase || nestedBase < base)
+            return false;
+          std::vector<StructTypeInterface::FlatLayout::Field> nested;
+          void* nestedStorage = static_cast<void*>(nestedBase);
+          if (!probeFields(static_cast<StructTypeInterface*>(member),
+                           nestedStorage, nestedBase, nested))
+            return false;
+          for (unsigned int n = 0; n < nested.size(); ++n)
+          {
+            StructTypeInterface::FlatLayout::Field field = nested[n];
+            field.offset += static_cast<size_t>(nestedBase - base);
+            fields.push_back(field);
+          }
+          continue;
+        }
+        default:
+          return false;
+        }
+        char* fieldPtr = static_cast<char*>(
+            memberAddress(type, storage, member, i));
+        if (!fieldPtr || fieldPtr < base)
+          return false;
+        StructTypeInterface::FlatLayout::Field field;
+        field.offset = static_cast<size_t>(fieldPtr - base);
+        field.size = size;
+        field.kind = kind;
+        fields.push_back(field);
+      }
+      return true;
+    }
+
+    StructTypeInterface::FlatLayout* computeFlatLayout(StructTypeInterface* type)
+    {
+      StructTypeInterface::FlatLayout* layout = new StructTypeInterface::FlatLayout;
+      layout->contiguousSize = 0;
+      layout->flat = false;
+
+      // Probe two default-constructed instances: the offsets are only
+      // meaningful if they do not depend on the instance, which also
+      // rejects members whose storage is not in place.
+      void* first = type->initializeStorage();
+      void* second = type->initializeStorage();
+      std::vector<StructTypeInterface::FlatLayout::Field> fields;
+      std::vector<StructTypeInterface::FlatLayout::Field> check;
+      bool ok =
+          probeFields(type, first, static_cast<char*>(type->ptrFromStorage(&first)), fields) &&
+          probeFields(type, second, static_cast<char*>(type->ptrFromStorage(&second)), check) &&
+          fields.size() == check.size();
+      if (ok)
+        for (unsigned int i = 0; i < fields.size(); ++i)
+          if (fields[i].offset != check[i].offset || fields[i].size != check[i].size)
+          {
+            ok = false;
+            break;
+          }
+      type->destroy(first);
+      type->destroy(second);
+      if (!ok || fields.empty())
+        return layout;
+
+      layout->flat = true;
+      layout->fields = fields;
+      size_t end = 0;
+      bool contiguous = true;
+      for (unsigned int i = 0; i < fields.size(); ++i)
+      {
+        if (fields[i].kind != StructTypeInterface::FlatLayout::Field_Scalar ||
+            fields[i].offset != end)
+        {
+          contiguous = false;
+          break;
+        }
+        end = fields[i].offset + fields[i].size;
+      }
+      if (contiguous)
+        layout->contiguousSize = end;
+      return layout;
+    }
+  }
+
+  const StructTypeInterface::FlatLayout* StructTypeInterface::flatLayout()
+  {
+    FlatLayout* layout = _flatLayout.load(std::memory_order_acquire);
+    if (!layout)
+    {
+      layout = computeFlatLayout(this);
+      FlatLayout* expected = nullptr;
+      if (!_flatLayout.compare_exchange_strong(expected, layout,
+                                               std::memory_order_release,
+                                               std::memory_order_acquire))
+      {
+        // another thread computed it first
+        delete layout;
+        layout = expected;
+      }
+    }
+    return layout->flat ? layout : nullptr;
+  }
+
+  StructTypeInterface::~StructTypeInterface()
+  {
+    delete _flatLayout.load(std::memory_order_acquire);
+  }
 }
@@ -41,9 +41,18 @@ namespace qi
   class TraceAnalyzerImpl
   {
   public:
+    void pushMethodStats(const CallData& d, const EventTrace& endTrace);
+    void evictOldTraces(qi::int64_t nowUs);
+
     PerContext perContext;
     PerId perId;
     TraceBuffer traceBuffer;
+
+    // Streaming mode (see TraceAnalyzer::setRollingWindow).
+    qi::int64_t windowUs = 0;
+    qi::int64_t latestUs = 0;
+    unsigned tracesSinceSweep = 0;
+    TraceAnalyzer::MethodStatisticsMap methodStats;
   };
 
   struct CompareCallTime
@@ -112,6 +121,52 @@ namespace qi
   {
     tEnd = fromTV(et.timestamp());
   }
+  void TraceAnalyzerImpl::pushMethodStats(const CallData& d, const EventTrace& endTrace)
+  {
+    if (d.tEnd < d.tStart)
+      return; // bogus clock or bogus trace, do not poison the aggregates
+    methodStats[std::make_pair(d.obj, d.fun)].push(
+        static_cast<float>(d.tEnd - d.tStart) / 1e6f,
+        static_cast<float>(endTrace.userUsTime()) / 1e6f,
+        static_cast<float>(endTrace.systemUsTime()) / 1e6f);
+  }
+
+  /* Drop the retained graph older than the rolling window, so that memory
+  * stays bounded on a live stream. The per-context lists are sorted by
+  * start time, so trimming their head is amortized O(1) per trace; the
+  * lookup maps can only be swept linearly, so they are swept once in a
+  * while - they only retain entries for calls still missing their start
+  * or end event, which stay rare.
+  */
+  void TraceAnalyzerImpl::evictOldTraces(qi::int64_t nowUs)
+  {
+    if (nowUs > latestUs)
+      latestUs = nowUs;
+    const qi::int64_t limit = latestUs - windowUs;
+    for (auto& perContextPair : perContext)
+    {
+      CallList& l = perContextPair.second;
+      l.erase(l.begin(), std::upper_bound(l.begin(), l.end(), CompareCallTime(limit)));
+    }
+    if (++tracesSinceSweep < 1024)
+      return;
+    tracesSinceSweep = 0;
+    for (PerId::iterator it = perId.begin(); it != perId.end();)
+    {
+      if (it->second && it->second->tStart < limit)
+        it = perId.erase(it);
+      else
+        ++it;
+    }
+    for (TraceBuffer::iterator it = traceBuffer.begin(); it != traceBuffer.end();)
+    {
+      if (fromTV(it->second.timestamp()) < limit)
+        it = traceBuffer.erase(it);
+      else
+        ++it;
+    }
+  }
+
   /* Events can reach us in basically random orders.
   * Synchronous hierarchy is constructed when an event arrives (it places
   * itself as deep as it can, but only goes as a child if it is sures
@@ -217,6 +272,8 @@ namespace qi
      * trace-start event gets inserted in the graph, and in the
      * per-uid perId map, so that future trace-end message can find it quickly
     */
+    if (_p->windowUs > 0)
+      _p->evictOldTraces(fromTV(trace.timestamp()));
     std::shared_ptr<CallData> d;
     CallList& lc = _p->perContext[trace.calleeContext()];
     EventTrace::EventKind k = trace.kind();
@@ -237,6 +294,7 @@ namespace qi
       if (it != _p->traceBuffer.end())
       { // end already there
         d->complete(it->second);
+        _p->pushMethodStats(*d, it->second);
         _p->traceBuffer.erase(it);
         // ...and go on below
       }
@@ -258,6 +316,7 @@ namespace qi
         return;
       }
       d->complete(trace);
+      _p->pushMethodStats(*d, trace);
       _p->perId.erase(trace.id());
     }
     // look for the list that should contain us
@@ -304,6 +363,21 @@ namespace qi
     }
   }
 
+  void TraceAnalyzer::setRollingWindow(qi::int64_t windowUs)
+  {
+    _p->windowUs = windowUs;
+  }
+
+  TraceAnalyzer::MethodStatisticsMap TraceAnalyzer::methodStatistics() const
+  {
+    return _p->methodStats;
+  }
+
+  void TraceAnalyzer::clearMethodStatistics()
+  {
+    _p->methodStats.clear();
+  }
+
   void TraceAnalyzer::clear()
   {
     _p->perContext.clear();
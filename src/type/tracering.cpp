@@ -0,0 +1,78 @@
+/*
+**  Copyright (C) 2018 Aldebaran Robotics
+**  See COPYING for the license
+*/
+
+#include <qi/os.hpp>
+#include <qi/type/detail/tracering.hpp>
+
+namespace qi
+{
+  namespace
+  {
+    size_t ringCapacityFromEnv()
+    {
+      const size_t wanted = os::getEnvParam<size_t>("QI_TRACE_RING_SIZE", 16384);
+      size_t capacity = 2; // the indexing masks, so a power of two is required
+      while (capacity < wanted)
+        capacity <<= 1;
+      return capacity;
+    }
+  }
+
+  TraceRing::TraceRing()
+    : _enabled(os::getEnvParam<int>("QI_TRACE_RING", 1) != 0)
+    , _capacity(ringCapacityFromEnv())
+    , _slots(new Slot[_capacity])
+  {
+  }
+
+  TraceRing& TraceRing::instance()
+  {
+    static TraceRing ring;
+    return ring;
+  }
+
+  void TraceRing::push(const TraceRecord& record)
+  {
+    const qi::uint64_t ticket = _next.fetch_add(1, std::memory_order_relaxed);
+    Slot& slot = _slots[ticket & (_capacity - 1)];
+    // The odd value tells concurrent readers the slot is torn; the final
+    // even value both publishes the record and identifies which ticket it
+    // belongs to, so a reader can tell a stale record from the one it
+    // expects.
+    slot.seq.store(2 * ticket + 1, std::memory_order_release);
+    slot.record = record;
+    slot.seq.store(2 * ticket + 2, std::memory_order_release);
+  }
+
+  std::vector<TraceRecord> TraceRing::snapshot() const
+  {
+    const qi::uint64_t next = _next.load(std::memory_order_acquire);
+    const qi::uint64_t first = next > _capacity ? next - _capacity : 0;
+    std::vector<TraceRecord> records;
+    records.reserve(static_cast<size_t>(next - first));
+    for (qi::uint64_t ticket = first; ticket != next; ++ticket)
+    {
+      const Slot& slot = _slots[ticket & (_capacity - 1)];
+      const qi::uint64_t published = 2 * ticket + 2;
+      if (slot.seq.load(std::memory_order_acquire) != published)
+        continue; // not written yet, in flight, or already overwritten
+      TraceRecord record = slot.record;
+      if (slot.seq.load(std::memory_order_acquire) != published)
+        continue; // overwritten during the copy
+      records.push_back(record);
+    }
+    return records;
+  }
+
+  EventTrace toEventTrace(const TraceRecord& record)
+  {
+    qi::os::timeval tv;
+    tv.tv_sec = record.timestampUs / 1000000;
+    tv.tv_usec = record.timestampUs % 1000000;
+    return EventTrace(record.id, static_cast<EventTrace::EventKind>(record.kind),
+                      record.slotId, AnyValue(), tv, record.userUsTime,
+                      record.systemUsTime, record.callerContext, record.calleeContext);
+  }
+}
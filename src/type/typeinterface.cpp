@@ -3,6 +3,13 @@
 **  See COPYING for the license
 */
 
+#include <atomic>
+#include <cstdlib>
+#include <set>
+#include <vector>
+
+#include <boost/make_shared.hpp>
+#include <boost/shared_ptr.hpp>
 #include <boost/thread/mutex.hpp>
 #include <boost/algorithm/string.hpp>
 
@@ -113,10 +120,39 @@ namespace qi {
     }
   }
 
+  /* The registry has a lock-free read path: lookups atomically load an
+   * immutable snapshot of the map and search it without taking any lock.
+   * Registration copies the current snapshot, applies the change and
+   * publishes the copy with an atomic store, serialized by a writer mutex
+   * (RCU style); readers holding the old snapshot keep it alive through
+   * its shared_ptr. Registrations happen at startup and on library load,
+   * so copying the map there is cheap compared to locking every lookup
+   * done by AnyValue construction afterwards.
+   */
   using TypeFactory = std::map<TypeInfo, TypeInterface*>;
-  static TypeFactory& typeFactory()
+  using TypeFactoryPtr = boost::shared_ptr<const TypeFactory>;
+
+  static TypeFactoryPtr& typeFactorySnapshot()
+  {
+    static TypeFactoryPtr* res = nullptr;
+    QI_THREADSAFE_NEW(res);
+    return *res;
+  }
+
+  static boost::mutex& typeFactoryMutex()
   {
-    static TypeFactory* res = nullptr;
+    static boost::mutex* res = nullptr;
+    QI_THREADSAFE_NEW(res);
+    return *res;
+  }
+
+  // Types looked up before their registration, for the diagnostic below.
+  // The historical map inserted a null entry on lookup miss for this
+  // purpose; the snapshot is immutable, so misses are recorded aside.
+  using TypeInfoSet = std::set<TypeInfo>;
+  static TypeInfoSet& earlyTypeAccesses()
+  {
+    static TypeInfoSet* res = nullptr;
     QI_THREADSAFE_NEW(res);
     return *res;
   }
@@ -129,41 +165,52 @@ namespace qi {
     return *res;
   }
 
-  QI_API TypeInterface* getType(const std::type_info& type)
+  // Lookup miss: cold path, taken once per unregistered type use.
+  static TypeInterface* getTypeMiss(const std::type_info& type)
   {
-    static boost::mutex* mutex = nullptr;
-    QI_THREADSAFE_NEW(mutex);
-    boost::mutex::scoped_lock sl(*mutex);
+    boost::mutex::scoped_lock sl(typeFactoryMutex());
     static bool fallback = !qi::os::getenv("QI_TYPE_RTTI_FALLBACK").empty();
-
-    // We create-if-not-exist on purpose: to detect access that occur before
-    // registration
-    TypeInterface* result = typeFactory()[TypeInfo(type)];
-    if (result || !fallback)
-      return result;
-    result = fallbackTypeFactory()[type.name()];
+    earlyTypeAccesses().insert(TypeInfo(type));
+    if (!fallback)
+      return nullptr;
+    TypeInterface* result = fallbackTypeFactory()[type.name()];
     if (result)
       qiLogError("qitype.type") << "RTTI failure for " << type.name();
     return result;
   }
 
+  QI_API TypeInterface* getType(const std::type_info& type)
+  {
+    const TypeFactoryPtr snapshot = boost::atomic_load(&typeFactorySnapshot());
+    if (snapshot)
+    {
+      TypeFactory::const_iterator i = snapshot->find(TypeInfo(type));
+      if (i != snapshot->end())
+        return i->second;
+    }
+    return getTypeMiss(type);
+  }
+
   /// Type factory setter
   QI_API bool registerType(const std::type_info& typeId, TypeInterface* type)
   {
     qiLogCategory("qitype.type"); // method can be called at static init
     qiLogDebug() << "registerType "  << typeId.name() << " "
      << type->kind() <<" " << (void*)type << " " << type->signature().toString();
-    TypeFactory::iterator i = typeFactory().find(TypeInfo(typeId));
-    if (i != typeFactory().end())
-    {
-      if (i->second)
-        qiLogVerbose() << "registerType: previous registration present for "
-          << typeId.name()<< " " << (void*)i->second << " " << i->second->kind();
-      else
-        qiLogVerbose() << "registerType: access to type factory before"
-          " registration detected for type " << typeId.name();
-    }
-    typeFactory()[TypeInfo(typeId)] = type;
+    boost::mutex::scoped_lock sl(typeFactoryMutex());
+    const TypeFactoryPtr current = boost::atomic_load(&typeFactorySnapshot());
+    boost::shared_ptr<TypeFactory> next = current
+        ? boost::make_shared<TypeFactory>(*current)
+        : boost::make_shared<TypeFactory>();
+    TypeFactory::iterator i = next->find(TypeInfo(typeId));
+    if (i != next->end())
+      qiLogVerbose() << "registerType: previous registration present for "
+        << typeId.name()<< " " << (void*)i->second << " " << i->second->kind();
+    else if (earlyTypeAccesses().count(TypeInfo(typeId)))
+      qiLogVerbose() << "registerType: access to type factory before"
+        " registration detected for type " << typeId.name();
+    (*next)[TypeInfo(typeId)] = type;
+    boost::atomic_store(&typeFactorySnapshot(), TypeFactoryPtr(next));
     fallbackTypeFactory()[typeId.name()] = type;
     return true;
   }
@@ -1540,8 +1587,136 @@ namespace qi {
     return (*it).rawValue();
   }
 
+  void ListTypeInterface::reserve(void**, size_t)
+  {
+    // Default implementation: not every container can preallocate.
+  }
+
+  void MapTypeInterface::insertAtEnd(void** storage, void* keyStorage, void* valueStorage)
+  {
+    // Default implementation: ignore the hint.
+    insert(storage, keyStorage, valueStorage);
+  }
+
+  void MapTypeInterface::reserve(void**, size_t)
+  {
+    // Default implementation: not every container can preallocate.
+  }
+
   namespace detail
   {
+    namespace
+    {
+      /// Per-thread freelist of the pointer-sized slots backing scalar
+      /// values. Slots are individually allocated so they can be released
+      /// from any thread, wherever the owning AnyValue ends up destroyed.
+      struct SmallStoragePool
+      {
+        std::vector<void*> items;
+        bool alive = true;
+        ~SmallStoragePool()
+        {
+          alive = false;
+          for (auto* p: items)
+            free(p);
+          items.clear();
+        }
+      };
+      thread_local SmallStoragePool smallStoragePool;
+      const size_t smallStoragePoolMaxSize = 1024;
+
+      /* Every slot, pooled or arena-served, is prefixed by one pointer
+       * naming the arena chunk it came from (null for pooled slots), so
+       * freeSmallStorage can route it back without any global lookup.
+       */
+      const size_t slotHeaderSize = sizeof(void*);
+
+      struct ArenaChunk
+      {
+        /// One reference held by the owning scope plus one per live slot;
+        /// the chunk is deleted when the last of them goes away, so slots
+        /// escaping the scope only delay the recycling.
+        std::atomic<size_t> refs{1};
+        size_t used = 0; // slots handed out, touched only by the owner thread
+        static const size_t slotCount = 256;
+        char data[slotCount * (slotHeaderSize + smallStorageSize)];
+      };
+
+      void releaseArenaChunk(ArenaChunk* chunk)
+      {
+        if (chunk->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+          delete chunk;
+      }
+
+      struct StorageArena
+      {
+        std::vector<ArenaChunk*> chunks;
+      };
+      thread_local StorageArena* currentArena = nullptr;
+    }
+
+    void* allocSmallStorage()
+    {
+      char* slot;
+      if (StorageArena* arena = currentArena)
+      {
+        ArenaChunk* chunk = arena->chunks.empty() ? nullptr : arena->chunks.back();
+        if (!chunk || chunk->used == ArenaChunk::slotCount)
+        {
+          chunk = new ArenaChunk;
+          arena->chunks.push_back(chunk);
+        }
+        slot = chunk->data + chunk->used++ * (slotHeaderSize + smallStorageSize);
+        chunk->refs.fetch_add(1, std::memory_order_relaxed);
+        *reinterpret_cast<ArenaChunk**>(slot) = chunk;
+        return slot + slotHeaderSize;
+      }
+      auto& pool = smallStoragePool;
+      if (pool.items.empty())
+        slot = static_cast<char*>(malloc(slotHeaderSize + smallStorageSize));
+      else
+      {
+        slot = static_cast<char*>(pool.items.back());
+        pool.items.pop_back();
+      }
+      *reinterpret_cast<ArenaChunk**>(slot) = nullptr;
+      return slot + slotHeaderSize;
+    }
+
+    void freeSmallStorage(void* storage)
+    {
+      char* slot = static_cast<char*>(storage) - slotHeaderSize;
+      if (ArenaChunk* chunk = *reinterpret_cast<ArenaChunk**>(slot))
+      {
+        releaseArenaChunk(chunk);
+        return;
+      }
+      auto& pool = smallStoragePool;
+      // The pool may already be destroyed if the thread is exiting.
+      if (!pool.alive || pool.items.size() >= smallStoragePoolMaxSize)
+      {
+        free(slot);
+        return;
+      }
+      pool.items.push_back(slot);
+    }
+
+    ScopedStorageArena::ScopedStorageArena()
+      : _arena(new StorageArena)
+      , _previous(currentArena)
+    {
+      currentArena = static_cast<StorageArena*>(_arena);
+    }
+
+    ScopedStorageArena::~ScopedStorageArena()
+    {
+      StorageArena* arena = static_cast<StorageArena*>(_arena);
+      currentArena = static_cast<StorageArena*>(_previous);
+      for (auto* chunk: arena->chunks)
+        releaseArenaChunk(chunk);
+      delete arena;
+    }
+
     void typeFail(const char* typeName, const char* operation)
     {
       /* Use an internal map and be untemplated to avoid generating zillions
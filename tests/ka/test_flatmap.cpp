@@ -0,0 +1,99 @@
+#include <map>
+#include <string>
+#include <gtest/gtest.h>
+#include <ka/conceptpredicate.hpp>
+#include <ka/flatmap.hpp>
+#include <ka/range.hpp>
+
+TEST(FlatMap, Regular) {
+  using namespace ka;
+  using M = flat_map_t<int, std::string>;
+  M m0;
+  M m1;
+  m1.insert(std::make_pair(1, std::string("one")));
+  M m2;
+  m2.insert(std::make_pair(1, std::string("one")));
+  m2.insert(std::make_pair(2, std::string("two")));
+  ASSERT_TRUE(is_regular({m0, m1, m2}));
+}
+
+TEST(FlatMap, InsertFindIterate) {
+  using M = ka::flat_map_t<unsigned int, std::string>;
+  M m;
+  ASSERT_TRUE(m.empty());
+
+  // Out-of-order insertion still yields key-sorted iteration.
+  ASSERT_TRUE(m.insert(std::make_pair(7u, std::string("seven"))).second);
+  ASSERT_TRUE(m.insert(std::make_pair(3u, std::string("three"))).second);
+  ASSERT_TRUE(m.insert(std::make_pair(5u, std::string("five"))).second);
+  ASSERT_EQ(3u, m.size());
+
+  unsigned int previous = 0u;
+  for (const auto& e : m) {
+    ASSERT_LT(previous, e.first);
+    previous = e.first;
+  }
+
+  // An existing key is not overwritten and its position is returned.
+  const auto r = m.insert(std::make_pair(5u, std::string("FIVE")));
+  ASSERT_FALSE(r.second);
+  ASSERT_EQ("five", r.first->second);
+  ASSERT_EQ(3u, m.size());
+
+  ASSERT_NE(m.end(), m.find(3u));
+  ASSERT_EQ("three", m.find(3u)->second);
+  ASSERT_EQ(m.end(), m.find(4u));
+  ASSERT_EQ(1u, m.count(7u));
+  ASSERT_EQ(0u, m.count(0u));
+}
+
+TEST(FlatMap, IndexOperator) {
+  ka::flat_map_t<int, int> m;
+  m[4] = 44;
+  m[2] = 22;
+  ASSERT_EQ(2u, m.size());
+  ASSERT_EQ(44, m[4]);
+  m[4] = 40;
+  ASSERT_EQ(40, m[4]);
+  ASSERT_EQ(0, m[8]); // default-constructed on first access
+  ASSERT_EQ(3u, m.size());
+}
+
+TEST(FlatMap, HintedAndRangedInsert) {
+  using M = ka::flat_map_t<int, int>;
+  M m;
+  // End hints with in-order keys are appends.
+  for (int i = 0; i != 100; ++i)
+    m.insert(m.cend(), std::make_pair(i, i * i));
+  ASSERT_EQ(100u, m.size());
+  ASSERT_EQ(81, m.find(9)->second);
+
+  // A wrong hint degrades to a plain insert.
+  const auto it = m.insert(m.cbegin(), std::make_pair(100, 10000));
+  ASSERT_EQ(10000, it->second);
+  ASSERT_EQ(101u, m.size());
+
+  // Range insertion accepts std::map's const-keyed value type.
+  std::map<int, int> src;
+  src[200] = 1;
+  src[100] = 2; // already present: skipped
+  M m2(src.begin(), src.end());
+  m.insert(src.begin(), src.end());
+  ASSERT_EQ(102u, m.size());
+  ASSERT_EQ(10000, m.find(100)->second);
+  ASSERT_EQ(1, m.find(200)->second);
+  ASSERT_EQ(2u, m2.size());
+}
+
+TEST(FlatMap, Erase) {
+  ka::flat_map_t<int, int> m;
+  m[1] = 10;
+  m[2] = 20;
+  m[3] = 30;
+  ASSERT_EQ(1u, m.erase(2));
+  ASSERT_EQ(0u, m.erase(2));
+  ASSERT_EQ(2u, m.size());
+  const auto it = m.erase(m.find(1));
+  ASSERT_EQ(3, it->first);
+  ASSERT_EQ(1u, m.size());
+}
@@ -391,6 +391,127 @@ TEST(FunctionalCompose, Id) {
   ASSERT_EQ(gf0(0), gf1(0));
 }
 
+TEST(FunctionalCompose, Flattening) {
+// TODO: Remove this define (but keep the content) when get rid of VS2013.
+// VS2013 compiler does not allow to do composition simplifications.
+#if !KA_COMPILER_VS2013_OR_BELOW
+  using namespace ka;
+  using std::string;
+
+  auto half = [](int x) {
+    return x / 2.f;
+  };
+  auto greater_1 = [](float x) {
+    return x > 1.f;
+  };
+  auto str = [](bool x) -> string {
+    return x ? "true" : "false";
+  };
+  {
+    // Composing with a composition splices its stages in, in application
+    // order, instead of nesting.
+    auto f = compose(str, compose(greater_1, half));
+    static_assert(Equal<decltype(f), flat_composition_t<
+      decltype(half), decltype(greater_1), decltype(str)>>::value, "");
+    ASSERT_EQ("true", f(3));
+    ASSERT_EQ("false", f(1));
+  }
+  {
+    auto const f = compose(compose(str, greater_1), half);
+    static_assert(Equal<Decay<decltype(f)>, flat_composition_t<
+      decltype(half), decltype(greater_1), decltype(str)>>::value, "");
+    ASSERT_EQ("true", f(3));
+    ASSERT_EQ("false", f(1));
+  }
+  {
+    auto size = [](string const& x) {
+      return x.size();
+    };
+    auto f = compose(compose(size, str), compose(greater_1, half));
+    static_assert(Equal<decltype(f), flat_composition_t<
+      decltype(half), decltype(greater_1), decltype(str), decltype(size)>>::value, "");
+    ASSERT_EQ(4u, f(3));
+    ASSERT_EQ(5u, f(1));
+  }
+#endif
+}
+
+TEST(FunctionalCompose, FlatteningVoid) {
+// TODO: Remove this define (but keep the content) when get rid of VS2013.
+#if !KA_COMPILER_VS2013_OR_BELOW
+  using namespace ka;
+  int order = 0;
+  int fOrder = -1;
+  int gOrder = -1;
+  auto f = [&](int) {
+    fOrder = order++;
+  };
+  auto g = [&] {
+    gOrder = order++;
+  };
+  auto last = [&] {
+    return order;
+  };
+  auto k = compose(last, compose(g, f));
+  static_assert(Equal<int, decltype(k(3))>::value, "");
+  ASSERT_EQ(2, k(3));
+  ASSERT_EQ(0, fOrder);
+  ASSERT_EQ(1, gOrder);
+#endif
+}
+
+TEST(FunctionalMemoize, Basic) {
+  using namespace ka;
+  int calls = 0;
+  auto twice = [&](int x) {
+    ++calls;
+    return 2 * x;
+  };
+  auto f = memoize<int, int>(twice);
+  ASSERT_EQ(6, f(3));
+  ASSERT_EQ(6, f(3));
+  ASSERT_EQ(1, calls);
+  ASSERT_EQ(8, f(4));
+  ASSERT_EQ(2, calls);
+  ASSERT_EQ(6, f(3));
+  ASSERT_EQ(2, calls);
+}
+
+TEST(FunctionalMemoize, Eviction) {
+  using namespace ka;
+  int calls = 0;
+  auto sq = [&](int x) {
+    ++calls;
+    return x * x;
+  };
+  // Default capacity is 8: a ninth distinct argument evicts the oldest entry.
+  auto f = memoize<int, int>(sq);
+  for (int i = 0; i != 9; ++i)
+    ASSERT_EQ(i * i, f(i));
+  ASSERT_EQ(9, calls);
+  ASSERT_EQ(64, f(8)); // still cached
+  ASSERT_EQ(9, calls);
+  ASSERT_EQ(0, f(0)); // evicted, recomputed
+  ASSERT_EQ(10, calls);
+}
+
+TEST(FunctionalMemoize, CustomCache) {
+  using namespace ka;
+  int calls = 0;
+  auto sq = [&](int x) {
+    ++calls;
+    return x * x;
+  };
+  auto f = memoize(sq, memo_cache_t<int, int, 2>{});
+  ASSERT_EQ(1, f(1));
+  ASSERT_EQ(4, f(2));
+  ASSERT_EQ(1, f(1));
+  ASSERT_EQ(2, calls);
+  ASSERT_EQ(9, f(3)); // evicts the entry for 1
+  ASSERT_EQ(1, f(1));
+  ASSERT_EQ(4, calls);
+}
+
 namespace {
   void remove_n(std::string& s, char c, int n) {
     ka::erase_if(s, [&](char x) {return x == c && --n >= 0;});
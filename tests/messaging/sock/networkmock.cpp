@@ -24,6 +24,7 @@ namespace mock
       N::SocketFunctions<qi::sock::SocketWithContext<N>>::_async_read_socket =
           defaultAsyncReadSocket<qi::sock::SocketWithContext<N>>;
   N::_anyAsyncReaderNextLayer N::_async_read_next_layer = defaultAsyncReadNextLayer;
+  N::_anyAsyncReadSomeNextLayer N::_async_read_some_next_layer = defaultAsyncReadSomeNextLayer;
 
   template <>
   N::_anyAsyncWriterSocket<N::ssl_socket_type>
@@ -6,7 +6,9 @@
 #include <functional>
 #include <thread>
 #include <chrono>
+#include <boost/container/small_vector.hpp>
 #include <boost/shared_ptr.hpp>
+#include <qi/messaging/sock/send.hpp>
 #include <qi/messaging/sock/traits.hpp>
 #include <qi/messaging/sock/error.hpp>
 #include <qi/messaging/sock/common.hpp>
@@ -29,6 +31,14 @@ namespace mock
     {
       bool value;
     };
+    struct socket_option_receive_buffer_size_type
+    {
+      int value;
+    };
+    struct socket_option_send_buffer_size_type
+    {
+      int value;
+    };
     struct accept_option_reuse_address_type
     {
       bool value;
@@ -90,6 +100,12 @@ namespace mock
         // `PolymorphicConstantFunction<void>{}`).
         return ka::compose(ka::constant_function(), _strand.schedulerFor(ka::fwd<Proc>(p)));
       }
+
+      template<typename Proc>
+      void post(Proc&& p) const
+      {
+        _strand.post(ka::fwd<Proc>(p));
+      }
     };
     struct ssl_context_type
     {
@@ -98,6 +114,17 @@ namespace mock
       ssl_context_type() = default;        // The 2 ctors are to avoid the
       ssl_context_type(method m) : m(m) {} // "not initialized" warning about m.
     };
+    // TLS session resumption hooks: nothing to do for the mock.
+    static void setClientSslContextOptions(ssl_context_type&)
+    {
+    }
+    static void setServerSslContextOptions(ssl_context_type&)
+    {
+    }
+    template<typename S>
+    static void prepareClientSession(S&, const std::string&)
+    {
+    }
     struct ssl_verify_mode_type
     {
     };
@@ -139,6 +166,9 @@ namespace mock
         static const int max_connections = 42;
         using endpoint_type = _endpoint;
         void set_option(socket_option_no_delay_type) {}
+        void set_option(socket_option_receive_buffer_size_type) {}
+        void set_option(socket_option_send_buffer_size_type) {}
+        void open(_endpoint::protocol_t, error_code_type&) {}
 
         using _anyAsyncConnecter = std::function<void (_resolver_entry, _anyHandler)>;
         static _anyAsyncConnecter async_connect;
@@ -252,6 +282,13 @@ namespace mock
     using H = ssl_socket_type::lowest_layer_type::_native_handle;
     static void setSocketNativeOptions(H, int) {}
 
+    // Fast open is never available on the mock network.
+    template<typename L>
+    static bool trySetFastOpenConnect(L&)
+    {
+      return false;
+    }
+
     struct _mutable_buffer_sequence
     {
       unsigned char *begin, *end;
@@ -260,6 +297,11 @@ namespace mock
     {
       const unsigned char *begin, *end;
     };
+    /// What `sendMessageBatch` hands to `async_write`: the same type as
+    /// `qi::sock::ConstBufferSequence<Network>`.
+    using _const_buffer_sequences =
+        boost::container::small_vector<_const_buffer_sequence,
+                                       qi::sock::inlineBufferCountHint>;
     static _mutable_buffer_sequence buffer(void* data, std::size_t maxSizeInBytes)
     {
       auto b = (unsigned char*)data;
@@ -278,7 +320,7 @@ namespace mock
     using _anyAsyncReaderSocket = std::function<void (NetSslSocket&, _mutable_buffer_sequence, _anyTransferHandler)>;
 
     template<typename NetSslSocket>
-    using _anyAsyncWriterSocket = std::function<void (NetSslSocket&, const std::vector<_const_buffer_sequence>&, _anyTransferHandler)>;
+    using _anyAsyncWriterSocket = std::function<void (NetSslSocket&, const _const_buffer_sequences&, _anyTransferHandler)>;
 
     template<typename NetSslSocket>
     struct SocketFunctions
@@ -294,7 +336,7 @@ namespace mock
     }
 
     template<typename NetSslSocket, typename NetTransferHandler>
-    static void async_write(NetSslSocket& s, const std::vector<_const_buffer_sequence>& b, NetTransferHandler h)
+    static void async_write(NetSslSocket& s, const _const_buffer_sequences& b, NetTransferHandler h)
     {
       SocketFunctions<NetSslSocket>::_async_write_socket(s, b, h);
     }
@@ -308,11 +350,20 @@ namespace mock
       _async_read_next_layer(s, b, h);
     }
 
-    using _anyAsyncWriterNextLayer = std::function<void (ssl_socket_type::next_layer_type&, const std::vector<_const_buffer_sequence>&, _anyTransferHandler)>;
+    using _anyAsyncReadSomeNextLayer = std::function<void (ssl_socket_type::next_layer_type&, _mutable_buffer_sequence, _anyTransferHandler)>;
+    static _anyAsyncReadSomeNextLayer _async_read_some_next_layer;
+
+    template<typename NetTransferHandler>
+    static void async_read_some(ssl_socket_type::next_layer_type& s, _mutable_buffer_sequence b, NetTransferHandler h)
+    {
+      _async_read_some_next_layer(s, b, h);
+    }
+
+    using _anyAsyncWriterNextLayer = std::function<void (ssl_socket_type::next_layer_type&, const _const_buffer_sequences&, _anyTransferHandler)>;
     static _anyAsyncWriterNextLayer _async_write_next_layer;
 
     template<typename NetTransferHandler>
-    static void async_write(ssl_socket_type::next_layer_type& s, const std::vector<_const_buffer_sequence>& b, NetTransferHandler h)
+    static void async_write(ssl_socket_type::next_layer_type& s, const _const_buffer_sequences& b, NetTransferHandler h)
     {
       _async_write_next_layer(s, b, h);
     }
@@ -449,15 +500,22 @@ namespace mock
     }}.detach();
   }
 
+  inline void defaultAsyncReadSomeNextLayer(N::ssl_socket_type::next_layer_type&, N::_mutable_buffer_sequence b, N::_anyTransferHandler h)
+  {
+    std::thread{[=] {
+      h(N::error_code_type{}, 0u);
+    }}.detach();
+  }
+
   template<typename NetSslSocket>
-  inline void defaultAsyncWriteSocket(NetSslSocket&, const std::vector<N::_const_buffer_sequence>&, N::_anyTransferHandler h)
+  inline void defaultAsyncWriteSocket(NetSslSocket&, const N::_const_buffer_sequences&, N::_anyTransferHandler h)
   {
     std::thread{[=] {
       h(N::error_code_type{}, 0u);
     }}.detach();
   }
 
-  inline void defaultAsyncWriteNextLayer(N::ssl_socket_type::next_layer_type&, const std::vector<N::_const_buffer_sequence>&, N::_anyTransferHandler h)
+  inline void defaultAsyncWriteNextLayer(N::ssl_socket_type::next_layer_type&, const N::_const_buffer_sequences&, N::_anyTransferHandler h)
   {
     std::thread{[=] {
       h(N::error_code_type{}, 0u);
@@ -1,3 +1,4 @@
+#include <atomic>
 #include <thread>
 #include <algorithm>
 #include <numeric>
@@ -52,6 +53,79 @@ TEST(NetReceiveMessage, FailsOnReadNonSsl)
   std::this_thread::sleep_for(defaultPostPauseInMs);
 }
 
+TEST(NetReceiveMessage, ReadAheadServesSeveralMessagesFromOneSocketRead)
+{
+  using namespace qi;
+  using namespace qi::sock;
+  using N = mock::Network;
+  using S = SslSocket<N>;
+
+  // Two messages with a 4-byte payload, laid out back-to-back as on the wire.
+  std::vector<unsigned char> wire;
+  for (unsigned char i = 0u; i != 2u; ++i)
+  {
+    Message::Header header;
+    header.magic = Message::Header::magicCookie;
+    header.size = 4u;
+    auto* p = reinterpret_cast<unsigned char*>(&header);
+    wire.insert(wire.end(), p, p + sizeof(header));
+    const unsigned char payload[] = {'a', 'b', 'c', i};
+    wire.insert(wire.end(), payload, payload + sizeof(payload));
+  }
+
+  auto readSomeCallCount = std::make_shared<std::atomic<int>>(0);
+  auto readCallCount = std::make_shared<std::atomic<int>>(0);
+  auto scopedReadSome = ka::scoped_set_and_restore(
+    N::_async_read_some_next_layer,
+    [&, readSomeCallCount](S::next_layer_type&, N::_mutable_buffer_sequence buf, N::_anyTransferHandler h) {
+      ++*readSomeCallCount;
+      ASSERT_GE(std::distance(buf.begin, buf.end), static_cast<std::ptrdiff_t>(wire.size()));
+      std::copy(wire.begin(), wire.end(), buf.begin);
+      const auto len = wire.size();
+      std::thread{[=] {
+        h(N::error_code_type{}, len);
+      }}.detach();
+    }
+  );
+  // Everything is buffered by the first `async_read_some`, so the exact-size
+  // reads of the historical behavior must not happen.
+  auto scopedRead = ka::scoped_set_and_restore(
+    N::_async_read_next_layer,
+    [=](S::next_layer_type&, N::_mutable_buffer_sequence, N::_anyTransferHandler) {
+      ++*readCallCount;
+    }
+  );
+
+  SslContext<N> context;
+  auto socket = makeSslSocketPtr<N>(N::defaultIoService(), context);
+  const size_t maxPayload = 10000;
+  ReadAhead readAhead;
+  readAhead.reset(1024u);
+  Message msg;
+  auto messageCount = std::make_shared<std::atomic<int>>(0);
+  Promise<void> done;
+  receiveMessage<N>(socket, &msg, SslEnabled{false}, maxPayload,
+    [=](ErrorCode<N> e, Message* m) mutable -> boost::optional<Message*> {
+      if (e)
+      {
+        done.setError(e.message());
+        return {};
+      }
+      EXPECT_EQ(4u, m->header().size);
+      if (++*messageCount == 2)
+      {
+        done.setValue(0);
+        return {};
+      }
+      return {m};
+    },
+    ka::id_transfo_t{}, ka::id_transfo_t{}, &readAhead);
+  done.future().value();
+  ASSERT_EQ(1, readSomeCallCount->load());
+  ASSERT_EQ(0, readCallCount->load());
+  std::this_thread::sleep_for(defaultPostPauseInMs);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 /// NetReceiveMessageContinuous tests:
 ////////////////////////////////////////////////////////////////////////////////
@@ -275,3 +275,73 @@ TEST(NetResolveUrlList, Cancel)
   ASSERT_EQ(operationAborted<ErrorCode<N>>(), futResult.value().first);
   threadResolve.join();
 }
+
+////////////////////////////////////////////////////////////////////////////////
+/// ResolveCache tests:
+////////////////////////////////////////////////////////////////////////////////
+
+TEST(NetResolveCache, FreshEntriesAreServedWithoutRevalidation)
+{
+  using namespace qi;
+  using namespace qi::sock;
+  using N = mock::Network;
+  auto& cache = sock::detail::ResolveCache<N>::instance();
+  ASSERT_FALSE(cache.find("unknown.example:9559", Seconds{60}));
+  cache.store("fresh.example:9559", sock::detail::ResolveCache<N>::Entries(2));
+  const auto hit = cache.find("fresh.example:9559", Seconds{60});
+  ASSERT_TRUE(static_cast<bool>(hit));
+  EXPECT_FALSE(hit->negative);
+  EXPECT_FALSE(hit->revalidate);
+  EXPECT_EQ(2u, hit->entries.size());
+}
+
+TEST(NetResolveCache, StaleEntriesAreServedAndRevalidatedOnce)
+{
+  using namespace qi;
+  using namespace qi::sock;
+  using N = mock::Network;
+  auto& cache = sock::detail::ResolveCache<N>::instance();
+  const std::string key = "stale.example:9559";
+  cache.store(key, sock::detail::ResolveCache<N>::Entries(1));
+  // With a zero TTL the entry is immediately stale: it is still served, and
+  // the first caller - only the first - is asked to revalidate.
+  auto hit = cache.find(key, Seconds{0});
+  ASSERT_TRUE(static_cast<bool>(hit));
+  EXPECT_EQ(1u, hit->entries.size());
+  EXPECT_TRUE(hit->revalidate);
+  hit = cache.find(key, Seconds{0});
+  ASSERT_TRUE(static_cast<bool>(hit));
+  EXPECT_FALSE(hit->revalidate);
+  // A failed revalidation keeps the stale entries and rearms the refresh.
+  cache.endRevalidation(key, ErrorCode<N>{ErrorCode<N>::hostNotFound}, {});
+  hit = cache.find(key, Seconds{0});
+  ASSERT_TRUE(static_cast<bool>(hit));
+  EXPECT_EQ(1u, hit->entries.size());
+  EXPECT_TRUE(hit->revalidate);
+  // A successful one replaces them.
+  cache.endRevalidation(key, ErrorCode<N>{}, sock::detail::ResolveCache<N>::Entries(3));
+  hit = cache.find(key, Seconds{60});
+  ASSERT_TRUE(static_cast<bool>(hit));
+  EXPECT_EQ(3u, hit->entries.size());
+  EXPECT_FALSE(hit->revalidate);
+}
+
+TEST(NetResolveCache, FailuresAreCachedButDoNotReplaceEntries)
+{
+  using namespace qi;
+  using namespace qi::sock;
+  using N = mock::Network;
+  auto& cache = sock::detail::ResolveCache<N>::instance();
+  cache.storeFailure("absent.example:9559", ErrorCode<N>{ErrorCode<N>::hostNotFound});
+  auto hit = cache.find("absent.example:9559", Seconds{60});
+  ASSERT_TRUE(static_cast<bool>(hit));
+  EXPECT_TRUE(hit->negative);
+  EXPECT_EQ(ErrorCode<N>{ErrorCode<N>::hostNotFound}, hit->error);
+  // A resolution failure never evicts endpoints that resolved once.
+  cache.store("flaky.example:9559", sock::detail::ResolveCache<N>::Entries(1));
+  cache.storeFailure("flaky.example:9559", ErrorCode<N>{ErrorCode<N>::hostNotFound});
+  hit = cache.find("flaky.example:9559", Seconds{60});
+  ASSERT_TRUE(static_cast<bool>(hit));
+  EXPECT_FALSE(hit->negative);
+  EXPECT_EQ(1u, hit->entries.size());
+}
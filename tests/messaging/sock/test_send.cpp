@@ -26,7 +26,7 @@ TEST(NetSendMessage, FailsOnWrite)
   using N = mock::Network;
   auto _ = ka::scoped_set_and_restore(
     N::_async_write_next_layer,
-    [](SslSocket<N>::next_layer_type&, const std::vector<N::_const_buffer_sequence>&, N::_anyTransferHandler h) {
+    [](SslSocket<N>::next_layer_type&, const N::_const_buffer_sequences&, N::_anyTransferHandler h) {
       h(ErrorCode<N>{ErrorCode<N>::unknown}, 0u);
     }
   );
@@ -53,7 +53,7 @@ TEST(NetSendMessage, SuccessSingleMessage)
   using N = mock::Network;
   auto _ = ka::scoped_set_and_restore(
     N::_async_write_next_layer,
-    [](SslSocket<N>::next_layer_type&, const std::vector<N::_const_buffer_sequence>&, N::_anyTransferHandler h) {
+    [](SslSocket<N>::next_layer_type&, const N::_const_buffer_sequences&, N::_anyTransferHandler h) {
       h(ErrorCode<N>{ErrorCode<N>::success}, 0u);
     }
   );
@@ -81,7 +81,7 @@ TEST(NetSendMessage, SuccessMultipleMessage)
   std::vector<std::thread> writeThreads;
   auto _ = ka::scoped_set_and_restore(
     N::_async_write_next_layer,
-    [&](SslSocket<N>::next_layer_type&, const std::vector<N::_const_buffer_sequence>&, N::_anyTransferHandler h) {
+    [&](SslSocket<N>::next_layer_type&, const N::_const_buffer_sequences&, N::_anyTransferHandler h) {
       writeThreads.push_back(std::thread([&, h]{
         h(success<ErrorCode<N>>(), 0u);
       }));
@@ -120,7 +120,7 @@ TEST(NetSendMessage, SuccessMultipleMessageRafaleMode)
   std::atomic_bool finished {false};
   auto _ = ka::scoped_set_and_restore(
     N::_async_write_next_layer,
-    [&](SslSocket<N>::next_layer_type&, const std::vector<N::_const_buffer_sequence>&, N::_anyTransferHandler h) {
+    [&](SslSocket<N>::next_layer_type&, const N::_const_buffer_sequences&, N::_anyTransferHandler h) {
       if (!finished)
       {
         auto syncThreads = writeThreads.synchronize();
@@ -217,7 +217,7 @@ TYPED_TEST(NetSendMessageEnqueue, MultipleSendsFromMultipleThreads)
   writeThreads.reserve(maxSentCount);
   auto scopedWrite = ka::scoped_set_and_restore(
     N::_async_write_next_layer,
-    [&](SslSocket<N>::next_layer_type&, const std::vector<N::_const_buffer_sequence>&,
+    [&](SslSocket<N>::next_layer_type&, const N::_const_buffer_sequences&,
           N::_anyTransferHandler writeCont) mutable {
       // We launch the continuation in another thread to avoid recursive calls.
       std::lock_guard<std::mutex> lock(writeThreadMutex);
@@ -275,6 +275,112 @@ TYPED_TEST(NetSendMessageEnqueue, MultipleSendsFromMultipleThreads)
   std::this_thread::sleep_for(defaultPostPauseInMs);
 }
 
+// Regression test: a message enqueued while a write is in flight must be
+// sent once that write completes. The in-flight batch used to be delimited
+// by an end-of-queue sentinel, so messages enqueued behind it during the
+// write were erased along with the batch without ever reaching the wire.
+TEST(NetSendMessageEnqueue, MessageEnqueuedDuringWriteIsSent)
+{
+  using namespace qi;
+  using namespace qi::sock;
+  using N = mock::Network;
+  std::mutex writeMutex;
+  std::vector<N::_anyTransferHandler> pendingWrites;
+  auto scopedWrite = ka::scoped_set_and_restore(
+    N::_async_write_next_layer,
+    [&](SslSocket<N>::next_layer_type&, const N::_const_buffer_sequences&,
+          N::_anyTransferHandler writeCont) {
+      // Hold the write open: the test completes it explicitly.
+      std::lock_guard<std::mutex> lock(writeMutex);
+      pendingWrites.push_back(writeCont);
+    }
+  );
+  SslContext<N> context;
+  auto socket = makeSslSocketPtr<N>(N::defaultIoService(), context);
+  using I = std::list<Message>::const_iterator;
+  int sentCount = 0;
+  SendMessageEnqueue<N, SslSocketPtr<N>> send{socket};
+  auto onSent = [&](ErrorCode<N>, I) {
+    ++sentCount;
+    return true;
+  };
+  auto completeOneWrite = [&] {
+    N::_anyTransferHandler writeCont;
+    {
+      std::lock_guard<std::mutex> lock(writeMutex);
+      ASSERT_EQ(1u, pendingWrites.size());
+      writeCont = pendingWrites.front();
+      pendingWrites.clear();
+    }
+    writeCont(success<ErrorCode<N>>(), 0u);
+  };
+  // The first message starts a write, which stays in flight.
+  send(Message{}, SslEnabled{false}, onSent);
+  // The second message is enqueued behind the in-flight one.
+  send(Message{}, SslEnabled{false}, onSent);
+  // Completing the first write must start a write for the second message.
+  completeOneWrite();
+  completeOneWrite();
+  ASSERT_EQ(2, sentCount);
+  ASSERT_EQ(0u, send.queuedBytes());
+  std::lock_guard<std::mutex> lock(writeMutex);
+  ASSERT_TRUE(pendingWrites.empty());
+}
+
+// A high-priority message enqueued while a write is in flight overtakes the
+// queued normal-priority messages, but not the message being written.
+TEST(NetSendMessageEnqueue, HighPriorityMessageOvertakesQueuedMessages)
+{
+  using namespace qi;
+  using namespace qi::sock;
+  using N = mock::Network;
+  std::mutex writeMutex;
+  std::vector<N::_anyTransferHandler> pendingWrites;
+  auto scopedWrite = ka::scoped_set_and_restore(
+    N::_async_write_next_layer,
+    [&](SslSocket<N>::next_layer_type&, const N::_const_buffer_sequences&,
+          N::_anyTransferHandler writeCont) {
+      // Hold the write open: the test completes it explicitly.
+      std::lock_guard<std::mutex> lock(writeMutex);
+      pendingWrites.push_back(writeCont);
+    }
+  );
+  SslContext<N> context;
+  auto socket = makeSslSocketPtr<N>(N::defaultIoService(), context);
+  using I = std::list<Message>::const_iterator;
+  std::vector<unsigned int> sentFlags;
+  SendMessageEnqueue<N, SslSocketPtr<N>> send{socket};
+  auto onSent = [&](ErrorCode<N>, I itMsg) {
+    sentFlags.push_back(itMsg->flags());
+    return true;
+  };
+  auto completeOneWrite = [&] {
+    N::_anyTransferHandler writeCont;
+    {
+      std::lock_guard<std::mutex> lock(writeMutex);
+      ASSERT_EQ(1u, pendingWrites.size());
+      writeCont = pendingWrites.front();
+      pendingWrites.clear();
+    }
+    writeCont(success<ErrorCode<N>>(), 0u);
+  };
+  // The first message starts a write, which stays in flight.
+  send(Message{}, SslEnabled{false}, onSent);
+  // A normal-priority message is enqueued behind it, then a high-priority
+  // one, which must overtake the normal one but not the in-flight message.
+  send(Message{}, SslEnabled{false}, onSent);
+  Message priorityMsg;
+  priorityMsg.addFlags(Message::TypeFlag_HighPriority);
+  send(std::move(priorityMsg), SslEnabled{false}, onSent);
+  completeOneWrite();
+  completeOneWrite();
+  completeOneWrite();
+  ASSERT_EQ(3u, sentFlags.size());
+  EXPECT_FALSE(sentFlags[0] & Message::TypeFlag_HighPriority);
+  EXPECT_TRUE(sentFlags[1] & Message::TypeFlag_HighPriority);
+  EXPECT_FALSE(sentFlags[2] & Message::TypeFlag_HighPriority);
+}
+
 // Multiple threads send messages with the same send object.
 // The socket is not connected so the send fails but it's not important here.
 // See test_tcpmessagesocket for a similar test on the real socket.
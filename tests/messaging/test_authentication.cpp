@@ -6,6 +6,8 @@
 **
 */
 
+#include <atomic>
+
 #include <gtest/gtest.h>
 
 #include <boost/scoped_ptr.hpp>
@@ -170,6 +172,33 @@ namespace {
     qi::AuthProviderPtr newProvider() { return qi::AuthProviderPtr(new HarshProvider); }
   };
 
+  class CountingUserPassProvider : public UserPassProvider {
+  public:
+    CountingUserPassProvider(boost::shared_ptr<std::atomic<int>> counter)
+      : _counter(counter) {}
+    qi::CapabilityMap _processAuth(const qi::CapabilityMap& ad)
+    {
+      ++*_counter;
+      return UserPassProvider::_processAuth(ad);
+    }
+  private:
+    boost::shared_ptr<std::atomic<int>> _counter;
+  };
+  class CountingUserPassProviderFactory : public qi::AuthProviderFactory {
+  public:
+    qi::AuthProviderPtr newProvider()
+    {
+      boost::shared_ptr<CountingUserPassProvider> prov =
+          boost::make_shared<CountingUserPassProvider>(processCount);
+      prov->user_ = expectedUser_;
+      prov->pass_ = expectedPass_;
+      return prov;
+    }
+    boost::shared_ptr<std::atomic<int>> processCount{ boost::make_shared<std::atomic<int>>(0) };
+    std::string expectedUser_;
+    std::string expectedPass_;
+  };
+
 }
 
 TEST_F(TestAuthentication, AuthErrorDisconnectsClient)
@@ -228,6 +257,37 @@ TEST_F(TestAuthentication, MultiStepAuthenticationTest)
   ASSERT_TRUE(client_->isConnected());
 }
 
+TEST_F(TestAuthentication, ResumeTokenSkipsProviderOnReconnect)
+{
+  std::string user = "Bob_l_eponge";
+  std::string pass = "much_password_many_authentication_wow";
+  boost::shared_ptr<UserPassAuthenticatorFactory> clientFactory =
+      boost::make_shared<UserPassAuthenticatorFactory>();
+  clientFactory->user = user;
+  clientFactory->pass = pass;
+  boost::shared_ptr<CountingUserPassProviderFactory> factory =
+      boost::make_shared<CountingUserPassProviderFactory>();
+  factory->expectedUser_ = user;
+  factory->expectedPass_ = pass;
+  sd_->setAuthProviderFactory(factory);
+  client_->setClientAuthenticatorFactory(clientFactory);
+
+  qi::Future<void> connecting = client_->connect(sd_->url());
+  ASSERT_FALSE(connecting.hasError()) << "Error was: " << connecting.error();
+  ASSERT_TRUE(client_->isConnected());
+  const int afterFirstConnect = factory->processCount->load();
+  ASSERT_GE(afterFirstConnect, 1);
+
+  client_->close();
+
+  // The reconnection replays the resume token handed out with the first
+  // State_Done reply, so the provider is not consulted again.
+  connecting = client_->connect(sd_->url());
+  ASSERT_FALSE(connecting.hasError()) << "Error was: " << connecting.error();
+  ASSERT_TRUE(client_->isConnected());
+  EXPECT_EQ(afterFirstConnect, factory->processCount->load());
+}
+
 TEST_F(TestAuthentication, ConnectionToServiceTest)
 {
   std::string user = "Bob_l_eponge";
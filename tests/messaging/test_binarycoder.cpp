@@ -6,11 +6,15 @@
 */
 
 #include <gtest/gtest.h>
+#include <cstring>
 #include <map>
 #include <qi/buffer.hpp>
 #include <qi/binarycodec.hpp>
 #include <qi/session.hpp>
 #include <limits.h>
+#include <limits>
+
+#include <src/messaging/streamcontext.hpp>
 
 TEST(TestBind, serializeInt)
 {
@@ -649,3 +653,177 @@ TEST(testSerializable, Value) {
   qi::encodeBinary(&buf, gv);
   qi::decodeBinary(&bufr, &gv2);
 }
+
+//(cd) — padding between members exercises the per-field program
+struct Padded {
+  Padded(char c = 0, double d = 0.)
+    : c(c),
+      d(d)
+  {}
+
+  char   c;
+  double d;
+};
+QI_TYPE_STRUCT(Padded, c, d);
+
+TEST(testSerializable, FlatStruct) {
+  Padded in(7, -2.5), out;
+
+  qi::Buffer buf;
+  qi::BufferReader bufr(buf);
+  qi::encodeBinary(&buf, in);
+  qi::decodeBinary(&bufr, &out);
+  EXPECT_EQ(7, out.c);
+  EXPECT_DOUBLE_EQ(-2.5, out.d);
+
+  // the flat encoding must stay readable by the generic decode path
+  // (dynamic tuple types are not flat, their members are boxed)
+  qi::Buffer buf2;
+  qi::BufferReader bufr2(buf2);
+  qi::encodeBinary(&buf2, TimeStamp(5, 6));
+  qi::AnyValue dyn(qi::TypeInterface::fromSignature("(ii)"));
+  qi::AnyReference ref = dyn.asReference();
+  qi::decodeBinary(&bufr2, ref);
+  qi::AnyReferenceVector members = ref.asTupleValuePtr();
+  ASSERT_EQ(2u, members.size());
+  EXPECT_EQ(5, members[0].to<int>());
+  EXPECT_EQ(6, members[1].to<int>());
+}
+
+//(isd) — a string member between scalars exercises the string field kind
+struct Labelled {
+  Labelled(int id = 0, const std::string& name = std::string(), double score = 0.)
+    : id(id),
+      name(name),
+      score(score)
+  {}
+
+  int         id;
+  std::string name;
+  double      score;
+};
+QI_TYPE_STRUCT(Labelled, id, name, score);
+
+TEST(testSerializable, FlatStructWithString) {
+  Labelled in(42, "answer", 1.5), out;
+
+  qi::Buffer buf;
+  qi::BufferReader bufr(buf);
+  qi::encodeBinary(&buf, in);
+  qi::decodeBinary(&bufr, &out);
+  EXPECT_EQ(42, out.id);
+  EXPECT_EQ("answer", out.name);
+  EXPECT_DOUBLE_EQ(1.5, out.score);
+
+  // the flat encoding must stay readable by the generic decode path
+  qi::Buffer buf2;
+  qi::BufferReader bufr2(buf2);
+  qi::encodeBinary(&buf2, in);
+  qi::AnyValue dyn(qi::TypeInterface::fromSignature("(isd)"));
+  qi::AnyReference ref = dyn.asReference();
+  qi::decodeBinary(&bufr2, ref);
+  qi::AnyReferenceVector members = ref.asTupleValuePtr();
+  ASSERT_EQ(3u, members.size());
+  EXPECT_EQ(42, members[0].to<int>());
+  EXPECT_EQ("answer", members[1].to<std::string>());
+  EXPECT_DOUBLE_EQ(1.5, members[2].to<double>());
+}
+
+namespace
+{
+  // StreamContext with a writable remote map, to negotiate the compact
+  // value encoding without a real connection.
+  class CompactTestStreamContext : public qi::StreamContext
+  {
+  public:
+    void setRemoteCapability(const std::string& key, bool value)
+    {
+      _remoteCapabilityMap[key] = qi::AnyValue::from(value);
+    }
+  };
+}
+
+TEST(testSerializable, CompactValuesRoundTrip)
+{
+  CompactTestStreamContext sender, receiver;
+  sender.advertiseCapability(qi::capabilityname::compactValues, qi::AnyValue::from(true));
+  sender.setRemoteCapability(qi::capabilityname::compactValues, true);
+  ASSERT_TRUE(sender.compactValuesSendEnabled());
+  receiver.setRemoteCapability(qi::capabilityname::compactValuesActive, true);
+  ASSERT_TRUE(receiver.compactValuesReceiveEnabled());
+
+  qi::Buffer buf;
+  qi::encodeBinary(&buf, 12, qi::SerializeObjectCallback(), &sender);
+  qi::encodeBinary(&buf, -3, qi::SerializeObjectCallback(), &sender);
+  qi::encodeBinary(&buf, std::numeric_limits<qi::uint64_t>::max(),
+                   qi::SerializeObjectCallback(), &sender);
+  std::string s("plop");
+  qi::encodeBinary(&buf, s, qi::SerializeObjectCallback(), &sender);
+  std::vector<int> v;
+  v.push_back(1);
+  v.push_back(-200);
+  v.push_back(300000);
+  qi::encodeBinary(&buf, v, qi::SerializeObjectCallback(), &sender);
+
+  // small counters shrink: 2 ints + uint64 + "plop" + 3-int vector is
+  // 4+4+8+(4+4)+(4+12) = 40 bytes fixed, well above the compact form
+  EXPECT_LT(buf.totalSize(), 30u);
+
+  qi::BufferReader bufr(buf);
+  int i1, i2;
+  qi::uint64_t u;
+  std::string sOut;
+  std::vector<int> vOut;
+  qi::decodeBinary(&bufr, &i1, qi::DeserializeObjectCallback(), &receiver);
+  qi::decodeBinary(&bufr, &i2, qi::DeserializeObjectCallback(), &receiver);
+  qi::decodeBinary(&bufr, &u, qi::DeserializeObjectCallback(), &receiver);
+  qi::decodeBinary(&bufr, &sOut, qi::DeserializeObjectCallback(), &receiver);
+  qi::decodeBinary(&bufr, &vOut, qi::DeserializeObjectCallback(), &receiver);
+  EXPECT_EQ(12, i1);
+  EXPECT_EQ(-3, i2);
+  EXPECT_EQ(std::numeric_limits<qi::uint64_t>::max(), u);
+  EXPECT_EQ("plop", sOut);
+  ASSERT_EQ(3u, vOut.size());
+  EXPECT_EQ(-200, vOut[1]);
+  EXPECT_EQ(300000, vOut[2]);
+}
+
+TEST(testSerializable, CompactValuesNotUsedBeforeActivation)
+{
+  // A receiver whose remote never announced the switch keeps decoding the
+  // fixed encoding, whatever capabilities were exchanged.
+  CompactTestStreamContext sender, receiver;
+  sender.setRemoteCapability(qi::capabilityname::compactValues, false);
+  EXPECT_FALSE(sender.compactValuesSendEnabled());
+  receiver.setRemoteCapability(qi::capabilityname::compactValues, true);
+  EXPECT_FALSE(receiver.compactValuesReceiveEnabled());
+
+  qi::Buffer buf;
+  qi::encodeBinary(&buf, 1234, qi::SerializeObjectCallback(), &sender);
+  EXPECT_EQ(4u, buf.totalSize());
+  qi::BufferReader bufr(buf);
+  int i = 0;
+  qi::decodeBinary(&bufr, &i, qi::DeserializeObjectCallback(), &receiver);
+  EXPECT_EQ(1234, i);
+}
+
+TEST(testSerializable, StaticEncodeMatchesGenericEncode)
+{
+  // The compile-time path of encodeBinary must produce exactly the wire
+  // image of the generic visitor.
+  std::map<std::string, std::vector<double> > value;
+  value["alpha"] = std::vector<double>{ 1.5, -2.25, 3.0 };
+  value["beta"] = std::vector<double>();
+  qi::Buffer staticBuf;
+  qi::encodeBinary(&staticBuf, value); // compile-time dispatch
+  qi::Buffer genericBuf;
+  qi::encodeBinary(&genericBuf, qi::AutoAnyReference(value)); // runtime visitor
+  ASSERT_EQ(genericBuf.size(), staticBuf.size());
+  EXPECT_EQ(0, memcmp(staticBuf.data(), genericBuf.data(), genericBuf.size()));
+
+  // And it round-trips through the generic decoder.
+  qi::BufferReader reader(staticBuf);
+  std::map<std::string, std::vector<double> > decoded;
+  qi::decodeBinary(&reader, &decoded);
+  EXPECT_EQ(value, decoded);
+}
@@ -5,7 +5,9 @@
  *  Copyright (c) 2012 Aldebaran Robotics. All rights reserved.
  */
 
+#include <cstring>
 #include <list>
+#include <memory>
 #include <thread>
 
 #include <gtest/gtest.h>
@@ -13,11 +15,14 @@
 #include <boost/assign/list_of.hpp>
 
 #include <qi/application.hpp>
+#include <qi/blob.hpp>
 #include <qi/eventloop.hpp>
 #include <qi/anyobject.hpp>
 #include <qi/type/dynamicobject.hpp>
 #include <qi/type/dynamicobjectbuilder.hpp>
 #include <qi/type/objecttypebuilder.hpp>
+#include <qi/messaging/calldeadline.hpp>
+#include <qi/messaging/streamsource.hpp>
 #include <qi/session.hpp>
 #include <qi/testutils/testutils.hpp>
 #include <testsession/testsessionpair.hpp>
@@ -322,6 +327,72 @@ TEST(TestCall, CallVoidErr)
   p.server()->unregisterService(serviceID);
 }
 
+static qi::AnyObject makeThreeChunkStream()
+{
+  auto remaining = std::make_shared<int>(3);
+  return qi::makeStreamSource([remaining]() {
+    qi::StreamChunk chunk;
+    chunk.data.write("x", 1);
+    chunk.last = (--*remaining == 0);
+    return qi::Future<qi::StreamChunk>(chunk);
+  });
+}
+
+TEST(TestCall, StreamingCall)
+{
+  TestSessionPair          p;
+  qi::DynamicObjectBuilder ob;
+
+  ob.advertiseMethod("fetchStream", &makeThreeChunkStream);
+  qi::AnyObject obj(ob.object());
+
+  const auto serviceID = p.server()->registerService("serviceCall", obj).value();
+
+  qi::AnyObject proxy = p.client()->service("serviceCall").value();
+
+  qi::StreamReader reader(proxy.call<qi::AnyObject>("fetchStream"));
+  auto received = std::make_shared<size_t>(0);
+  qi::Future<void> done = reader.readAll([received](const qi::Buffer& chunk) {
+    *received += chunk.size();
+  });
+  ASSERT_TRUE(test::finishesWithValue(done));
+  EXPECT_EQ(3u, *received);
+
+  p.server()->unregisterService(serviceID);
+}
+
+TEST(TestCall, CallBatch)
+{
+  TestSessionPair          p;
+  qi::DynamicObjectBuilder ob;
+
+  ob.advertiseMethod("getint", &getint);
+  ob.advertiseMethod("addOne", &addOne);
+  ob.advertiseMethod("fooerr", &fooerr);
+  qi::AnyObject obj(ob.object());
+
+  const auto serviceID = p.server()->registerService("serviceCall", obj).value();
+
+  qi::AnyObject proxy = p.client()->service("serviceCall").value();
+
+  qi::ObjectBatch batch = proxy.batch();
+  std::vector<qi::AnyReference> noArg;
+  std::vector<qi::AnyReference> oneArg = { qi::AnyReference::from(41) };
+  qi::Future<qi::AnyValue> first = batch.call("getint", noArg);
+  qi::Future<qi::AnyValue> second = batch.call("addOne", oneArg);
+  qi::Future<qi::AnyValue> failing = batch.call("fooerr", noArg);
+
+  qi::Future<void> flushed = batch.flush();
+  ASSERT_TRUE(test::finishesWithValue(flushed));
+  ASSERT_TRUE(test::finishesWithValue(first));
+  ASSERT_TRUE(test::finishesWithValue(second));
+  EXPECT_EQ(42, first.value().toInt());
+  EXPECT_EQ(42, second.value().toInt());
+  EXPECT_TRUE(test::finishesWithError(failing));
+
+  p.server()->unregisterService(serviceID);
+}
+
 TEST(TestCall, TestDoubleToFloatConvertion)
 {
   TestSessionPair p;
@@ -1552,6 +1623,102 @@ TEST(TestCall, TestAsyncFutureIsCancelable)
   ASSERT_TRUE(future.isCanceled());
 }
 
+TEST(TestCall, CancelGroupCancelsWholeBatch)
+{
+  TestSessionPair p;
+
+  // FIXME support cancel in the gateway
+  if (p.mode() == TestMode::Mode_Gateway)
+    return;
+
+  qi::DynamicObjectBuilder ob;
+  ob.advertiseMethod("getCancelable",
+                     boost::function<qi::Future<void>()>([] {
+                       qi::Promise<void> prom(&doCancel);
+                       return prom.future();
+                     }));
+  ob.setThreadingModel(qi::ObjectThreadingModel_MultiThread);
+  p.server()->registerService("test", ob.object());
+  qi::AnyObject proxy = p.client()->service("test").value();
+
+  // A batch of speculative calls dropped at once: the cancels are grouped
+  // client-side and coalesced into batched cancel messages on the wire.
+  static const int batchSize = 16;
+  qi::CancelGroup<void> group(batchSize);
+  std::vector<qi::Future<void>> futures;
+  for (int i = 0; i < batchSize; ++i)
+  {
+    qi::Future<void> future = proxy.async<void>("getCancelable");
+    group.add(future);
+    futures.push_back(future);
+  }
+  group.cancelAll();
+  for (auto& future: futures)
+  {
+    future.wait(usualTimeout);
+    EXPECT_TRUE(future.isCanceled());
+  }
+
+  // Once cancelled, the group cancels later additions immediately.
+  qi::Future<void> late = proxy.async<void>("getCancelable");
+  group.add(late);
+  late.wait(usualTimeout);
+  EXPECT_TRUE(late.isCanceled());
+}
+
+TEST(TestCall, CallDeadlineExpiresPendingCall)
+{
+  TestSessionPair p;
+
+  qi::DynamicObjectBuilder ob;
+  ob.advertiseMethod("getStuck",
+                     boost::function<qi::Future<void>()>([] {
+                       return qi::Promise<void>().future(); // never answered
+                     }));
+  ob.setThreadingModel(qi::ObjectThreadingModel_MultiThread);
+  p.server()->registerService("test", ob.object());
+  qi::AnyObject proxy = p.client()->service("test").value();
+
+  qi::Future<void> bounded;
+  {
+    qi::ScopedCallDeadline deadline{qi::MilliSeconds(100)};
+    bounded = proxy.async<void>("getStuck");
+  }
+  // Calls issued outside the scope get no deadline.
+  qi::Future<void> unbounded = proxy.async<void>("getStuck");
+
+  ASSERT_EQ(qi::FutureState_FinishedWithError, bounded.wait(usualTimeout));
+  EXPECT_EQ("call deadline expired", bounded.error());
+  EXPECT_TRUE(unbounded.isRunning());
+}
+
+TEST(TestCall, BlobHandleFetchesPayloadOutOfBand)
+{
+  TestSessionPair p;
+
+  // Several chunks at the default chunk size.
+  std::vector<unsigned char> pattern(3 * 1024 * 1024);
+  for (size_t i = 0; i < pattern.size(); ++i)
+    pattern[i] = static_cast<unsigned char>(i * 31);
+  qi::Buffer payload;
+  payload.write(pattern.data(), pattern.size());
+
+  qi::DynamicObjectBuilder ob;
+  ob.advertiseMethod("getMap",
+                     boost::function<qi::Object<qi::Blob>()>([payload] {
+                       return qi::makeBlob(payload);
+                     }));
+  ob.setThreadingModel(qi::ObjectThreadingModel_MultiThread);
+  p.server()->registerService("test", ob.object());
+  qi::AnyObject proxy = p.client()->service("test").value();
+
+  // The reply only carries the handle; the bytes come in windowed chunks.
+  qi::AnyObject handle = proxy.call<qi::AnyObject>("getMap");
+  qi::Buffer fetched = qi::fetchBlob(handle).value();
+  ASSERT_EQ(pattern.size(), fetched.size());
+  EXPECT_EQ(0, std::memcmp(fetched.data(), pattern.data(), pattern.size()));
+}
+
 class SimpleClass
 {
 public:
@@ -2,6 +2,7 @@
 ** Copyright (C) 2012 Aldebaran Robotics
 */
 
+#include <atomic>
 #include <map>
 #include <thread>
 #include <chrono>
@@ -145,3 +146,50 @@ TEST(TestSignal, TwoLongPost)
   ASSERT_EQ(42, verifA);
   ASSERT_EQ(43, verifB);
 }
+
+// The messaging layer subscribes to a hosted signal only while at least one
+// remote client is registered to it, so onSubscribers reports a true zero and
+// a publisher can stop producing when nobody, local or remote, is listening.
+TEST(TestSignal, OnSubscribersReportsTrueRemoteZero)
+{
+  qi::DynamicObjectBuilder gob;
+  qi::Signal<int> sig;
+  gob.advertiseSignal("sig1", &sig);
+  qi::AnyObject op = gob.object();
+
+  std::atomic<int> ups(0);
+  std::atomic<int> downs(0);
+  sig.setOnSubscribers([&](bool enabled) {
+    if (enabled)
+      ++ups;
+    else
+      ++downs;
+    return qi::futurize();
+  });
+
+  TestSessionPair p;
+  p.server()->registerService("MyService", op);
+  qi::AnyObject clientOp = p.client()->service("MyService").value();
+  ASSERT_EQ(0, ups.load());
+
+  boost::function<void(int)> doNothing = [](int) {};
+  qi::SignalLink link1 = clientOp.connect("sig1", doNothing).value();
+  for (unsigned int i = 0; i < 100 && ups.load() == 0; ++i)
+    std::this_thread::sleep_for(std::chrono::milliseconds{ 10 });
+  EXPECT_EQ(1, ups.load());
+  EXPECT_EQ(0, downs.load());
+
+  // A second subscriber of the same client does not cross zero again.
+  qi::SignalLink link2 = clientOp.connect("sig1", doNothing).value();
+  EXPECT_EQ(1, ups.load());
+
+  // Neither does removing it, as long as one subscriber remains.
+  clientOp.disconnect(link2).wait();
+  EXPECT_EQ(0, downs.load());
+
+  clientOp.disconnect(link1).wait();
+  for (unsigned int i = 0; i < 100 && downs.load() == 0; ++i)
+    std::this_thread::sleep_for(std::chrono::milliseconds{ 10 });
+  EXPECT_EQ(1, ups.load());
+  EXPECT_EQ(1, downs.load());
+}
@@ -60,3 +60,41 @@ TEST(TestMessage, CopiesAreDistinct)
   ASSERT_NE(buf.totalSize(), bb.totalSize());
 
 }
+
+TEST(TestMessage, CompactHeaderRoundTrip)
+{
+  using namespace qi;
+  Message msg(Message::Type_Event, MessageAddress{509, 2, 3, 105});
+  msg.setFlags(Message::TypeFlag_DynamicPayload);
+  int i = 5;
+  Buffer buf;
+  buf.write(&i, sizeof(int));
+  msg.setBuffer(buf);
+  ASSERT_TRUE(Message::CompactHeader::fits(msg.header()));
+
+  uint8_t wire[Message::CompactHeader::size];
+  Message::CompactHeader::encode(msg.header(), wire);
+  ASSERT_EQ(Message::CompactHeader::marker, wire[0]);
+  // A full header always starts with 0x42 on the wire (the magic cookie
+  // starts and ends with it): the marker must be distinguishable from it.
+  ASSERT_NE(0x42, wire[0]);
+
+  Message::Header decoded;
+  Message::CompactHeader::decode(wire, decoded);
+  ASSERT_EQ(msg.header(), decoded);
+}
+
+TEST(TestMessage, CompactHeaderRejectsWideIds)
+{
+  using namespace qi;
+  Message msg(Message::Type_Call, MessageAddress{1, 2, 3, 4});
+  ASSERT_TRUE(Message::CompactHeader::fits(msg.header()));
+  msg.setService(0x10000u);
+  ASSERT_FALSE(Message::CompactHeader::fits(msg.header()));
+  msg.setService(2);
+  msg.setObject(0x10000u);
+  ASSERT_FALSE(Message::CompactHeader::fits(msg.header()));
+  msg.setObject(3);
+  msg.setFunction(0x10000u);
+  ASSERT_FALSE(Message::CompactHeader::fits(msg.header()));
+}
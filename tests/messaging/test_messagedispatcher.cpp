@@ -0,0 +1,72 @@
+/*
+**  Copyright (C) 2026 Softbank Robotics Europe
+**  See COPYING for the license
+*/
+
+#include <gtest/gtest.h>
+
+#include "../../src/messaging/messagedispatcher.hpp"
+
+namespace {
+
+qi::Message messageFor(unsigned int serviceId, unsigned int objectId)
+{
+  qi::Message msg;
+  msg.setType(qi::Message::Type_Call);
+  msg.setService(serviceId);
+  msg.setObject(objectId);
+  msg.setFunction(42);
+  return msg;
+}
+
+} // namespace
+
+TEST(MessageDispatcher, DeliversToRegisteredHandler)
+{
+  qi::MessageDispatcher dispatcher;
+  int delivered = 0;
+  dispatcher.messagePendingConnect(1, 2,
+    [&](const qi::Message&) { ++delivered; });
+
+  dispatcher.dispatch(messageFor(1, 2));
+  EXPECT_EQ(1, delivered);
+
+  // Another target does not receive it.
+  dispatcher.dispatch(messageFor(1, 3));
+  dispatcher.dispatch(messageFor(4, 2));
+  EXPECT_EQ(1, delivered);
+}
+
+TEST(MessageDispatcher, AllObjectsHandlerSeesEveryObject)
+{
+  qi::MessageDispatcher dispatcher;
+  int delivered = 0;
+  dispatcher.messagePendingConnect(1, qi::MessageDispatcher::ALL_OBJECTS,
+    [&](const qi::Message&) { ++delivered; });
+
+  dispatcher.dispatch(messageFor(1, 2));
+  dispatcher.dispatch(messageFor(1, 3));
+  EXPECT_EQ(2, delivered);
+  dispatcher.dispatch(messageFor(2, 2)); // other service
+  EXPECT_EQ(2, delivered);
+}
+
+TEST(MessageDispatcher, DisconnectRemovesOnlyThatHandler)
+{
+  qi::MessageDispatcher dispatcher;
+  int first = 0;
+  int second = 0;
+  const qi::SignalLink link = dispatcher.messagePendingConnect(1, 2,
+    [&](const qi::Message&) { ++first; });
+  dispatcher.messagePendingConnect(1, 2,
+    [&](const qi::Message&) { ++second; });
+
+  dispatcher.dispatch(messageFor(1, 2));
+  EXPECT_EQ(1, first);
+  EXPECT_EQ(1, second);
+
+  dispatcher.messagePendingDisconnect(1, 2, link);
+  dispatcher.dispatch(messageFor(1, 2));
+  EXPECT_EQ(1, first);
+  EXPECT_EQ(2, second);
+}
@@ -3,6 +3,7 @@
 **  See COPYING for the license
 */
 
+#include <atomic>
 #include <list>
 
 #include <gtest/gtest.h>
@@ -195,9 +196,201 @@ TEST(Proxy, Property)
   PERSIST_ASSERT(, bar3.sum() == 5, 500);
 }
 
+TEST(Proxy, PropertyCache)
+{
+  boost::shared_ptr<Bar> bar(new Bar);
+  qi::AnyObject gbar = qi::AnyReference::from(bar).toObject();
+  TestSessionPair p;
+  p.server()->registerService("bar", gbar);
+  qi::AnyObject client = p.client()->service("bar");
+
+  qi::ProxyProperty<int> pp(client, "prop");
+  bar->set(1);
+  ASSERT_EQ(1, pp.get());
+
+  pp.enableCache();
+  ASSERT_EQ(1, pp.get()); // first cached read seeds the mirror
+  bar->set(2);
+  // change events are asynchronous, the mirror catches up
+  PERSIST_ASSERT(, pp.get() == 2, 500);
+  // writes through the proxy are visible immediately
+  pp.set(3);
+  ASSERT_EQ(3, pp.get());
+  ASSERT_EQ(3, bar->get());
+
+  pp.disableCache();
+  bar->set(4);
+  ASSERT_EQ(4, pp.get()); // straight fetch again
+}
+
+TEST(Proxy, BulkProperties)
+{
+  boost::shared_ptr<Bar> bar(new Bar);
+  qi::AnyObject gbar = qi::AnyReference::from(bar).toObject();
+  TestSessionPair p;
+  p.server()->registerService("bar", gbar);
+  qi::AnyObject client = p.client()->service("bar");
+
+  bar->set(1);
+  std::vector<std::string> names;
+  names.push_back("prop");
+  names.push_back("nosuchprop");
+  auto replies = client.properties(names).value();
+  ASSERT_EQ(2u, replies.size());
+  EXPECT_TRUE(replies[0].first.empty());
+  EXPECT_EQ(1, replies[0].second.to<int>());
+  EXPECT_FALSE(replies[1].first.empty()); // per-entry error, not a failed batch
+
+  std::vector<std::pair<std::string, qi::AnyValue>> writes;
+  writes.push_back(std::make_pair(std::string("prop"), qi::AnyValue::from(7)));
+  writes.push_back(std::make_pair(std::string("nosuchprop"), qi::AnyValue::from(8)));
+  auto errors = client.setProperties(writes).value();
+  ASSERT_EQ(2u, errors.size());
+  EXPECT_TRUE(errors[0].empty());
+  EXPECT_FALSE(errors[1].empty());
+  EXPECT_EQ(7, bar->get());
+
+  // Local objects take the per-property fallback path.
+  auto localReplies = gbar.properties(names).value();
+  ASSERT_EQ(2u, localReplies.size());
+  EXPECT_TRUE(localReplies[0].first.empty());
+  EXPECT_EQ(7, localReplies[0].second.to<int>());
+  EXPECT_FALSE(localReplies[1].first.empty());
+}
+
+
 
+struct JointFrame
+{
+  int id;
+  double position;
+  double velocity;
+  double effort;
+};
+QI_TYPE_STRUCT(JointFrame, id, position, velocity, effort);
+
+class JointPublisher
+{
+public:
+  qi::Signal<JointFrame> frame;
+};
+QI_REGISTER_OBJECT(JointPublisher, frame);
+
+// Single-struct event streams travel delta-encoded when both ends advertise
+// the DeltaEvents capability (enabled for this binary in main), so this
+// exercises the keyframe + delta reassembly path end to end.
+TEST(Proxy, StructEventStream)
+{
+  auto pub = boost::make_shared<JointPublisher>();
+  qi::AnyObject gpub = qi::AnyReference::from(pub).toObject();
+  TestSessionPair p;
+  p.server()->registerService("jointpub", gpub);
+  qi::AnyObject client = p.client()->service("jointpub");
+
+  boost::mutex mutex;
+  std::vector<JointFrame> received;
+  client.connect("frame", boost::function<void(JointFrame)>(
+      [&](JointFrame f) {
+        boost::mutex::scoped_lock lock(mutex);
+        received.push_back(f);
+      })).value();
+
+  JointFrame f;
+  f.id = 1;
+  f.position = 0.5;
+  f.velocity = 0.0;
+  f.effort = 0.25;
+  pub->frame(f);        // keyframe
+  f.position = 0.75;
+  pub->frame(f);        // one field changed
+  f.id = 2;
+  f.velocity = 1.5;
+  pub->frame(f);        // two fields changed
+  pub->frame(f);        // nothing changed
+
+  auto count = [&] { boost::mutex::scoped_lock lock(mutex); return received.size(); };
+  PERSIST_ASSERT(, count() == 4u, 2000);
+  boost::mutex::scoped_lock lock(mutex);
+  EXPECT_EQ(1, received[0].id);
+  EXPECT_DOUBLE_EQ(0.5, received[0].position);
+  EXPECT_DOUBLE_EQ(0.75, received[1].position);
+  EXPECT_DOUBLE_EQ(0.25, received[1].effort);
+  EXPECT_EQ(2, received[2].id);
+  EXPECT_DOUBLE_EQ(1.5, received[2].velocity);
+  EXPECT_EQ(2, received[3].id);
+  EXPECT_DOUBLE_EQ(0.75, received[3].position);
+}
+
+class TickPublisher
+{
+public:
+  qi::Signal<int> tick;
+};
+QI_REGISTER_OBJECT(TickPublisher, tick);
+
+// A subscriber-requested rate ceiling is negotiated at connect
+// (registerEventWithRate) and enforced by the emitter before serialization:
+// within one rate interval only the first event reaches the subscriber.
+TEST(Proxy, SignalRateLimit)
+{
+  auto pub = boost::make_shared<TickPublisher>();
+  qi::AnyObject gpub = qi::AnyReference::from(pub).toObject();
+  TestSessionPair p;
+  p.server()->registerService("tickpub", gpub);
+  qi::AnyObject client = p.client()->service("tickpub");
+
+  std::atomic<int> received(0);
+  qi::SignalSubscriber sub(qi::AnyFunction::from(
+      boost::function<void(int)>([&](int) { ++received; })));
+  client.connect("tick", sub.setMaxEventRate(2.0f)).value(); // 500ms window
+
+  for (int i = 0; i < 10; ++i)
+    pub->tick(i); // burst, well inside one window
+  PERSIST_ASSERT(, received.load() == 1, 500);
+  qi::os::msleep(600); // past the window
+  ASSERT_EQ(1, received.load()); // the rest of the burst was dropped, not delayed
+  pub->tick(10);
+  pub->tick(11);
+  PERSIST_ASSERT(, received.load() == 2, 500);
+}
+
+// Windowed delivery (setAckWindow): the emitter stops serializing after
+// `window` unacknowledged events; with coalescing only the newest held-back
+// event survives, so a fast burst reaches the subscriber as a handful of
+// events ending on the last value instead of the whole backlog.
+TEST(Proxy, SignalAckWindow)
+{
+  auto pub = boost::make_shared<TickPublisher>();
+  qi::AnyObject gpub = qi::AnyReference::from(pub).toObject();
+  TestSessionPair p;
+  p.server()->registerService("tickpub", gpub);
+  qi::AnyObject client = p.client()->service("tickpub");
+
+  boost::mutex mutex;
+  std::vector<int> received;
+  qi::SignalSubscriber sub(qi::AnyFunction::from(
+      boost::function<void(int)>([&](int v) {
+        boost::mutex::scoped_lock lock(mutex);
+        received.push_back(v);
+      })));
+  client.connect("tick", sub.setAckWindow(2)).value();
+
+  const int burst = 100;
+  for (int i = 0; i < burst; ++i)
+    pub->tick(i); // far faster than acks can round-trip
+  auto lastIsFinal = [&] {
+    boost::mutex::scoped_lock lock(mutex);
+    return !received.empty() && received.back() == burst - 1;
+  };
+  PERSIST_ASSERT(, lastIsFinal(), 2000);
+  boost::mutex::scoped_lock lock(mutex);
+  // The window held most of the burst back and coalesced it.
+  EXPECT_LT(received.size(), static_cast<size_t>(burst));
+}
 
 int main(int argc, char **argv) {
+  // Exercise the delta-event path (off by default) across this binary.
+  qi::os::setenv("QI_TRANSPORT_CAPABILITIES", "+DeltaEvents");
   qi::Application app(argc, argv);
   TestMode::initTestMode(argc, argv);
   ::testing::InitGoogleTest(&argc, argv);
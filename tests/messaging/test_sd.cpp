@@ -3,9 +3,13 @@
 ** Copyright (C) 2012 Aldebaran Robotics
 */
 
+#include <atomic>
+
 #include <gtest/gtest.h>
 #include <qi/application.hpp>
 #include <qi/log.hpp>
+#include <qi/messaging/serviceinfo.hpp>
+#include <qi/os.hpp>
 #include <qi/session.hpp>
 #include <qi/testutils/testutils.hpp>
 #include <qi/type/dynamicobjectbuilder.hpp>
@@ -42,6 +46,81 @@ const int Serv::response = 4242;
 
 QI_REGISTER_OBJECT(Serv, f);
 
+TEST(ServiceDirectory, BatchedChangeNotifications)
+{
+  auto sd = qi::makeSession();
+  sd->listenStandalone("tcp://127.0.0.1:0");
+  auto client = qi::makeSession();
+  client->connect(sd->url());
+  qi::AnyObject directory = client->service("ServiceDirectory").value();
+
+  const qi::uint64_t before = directory.call<qi::uint64_t>("currentSequence");
+
+  std::atomic<int> notifiedChanges{0};
+  qi::Promise<void> allNotified;
+  directory.connect(
+      "servicesChanged",
+      boost::function<void(std::vector<qi::ServiceDirectoryChange>)>(
+          [&](const std::vector<qi::ServiceDirectoryChange>& changes) {
+            const int count = static_cast<int>(changes.size());
+            const int total = notifiedChanges += count;
+            if (total - count < 3 && total >= 3)
+              allNotified.setValue(0);
+          }));
+
+  sd->registerService("BatchA", boost::make_shared<Serv>());
+  sd->registerService("BatchB", boost::make_shared<Serv>());
+  sd->registerService("BatchC", boost::make_shared<Serv>());
+
+  ASSERT_EQ(qi::FutureState_FinishedWithValue,
+            allNotified.future().wait(qi::MilliSeconds{2000}));
+
+  // Reconnecting watchers resynchronize with one delta.
+  const auto changes =
+      directory.call<std::vector<qi::ServiceDirectoryChange>>("changesSince", before);
+  ASSERT_EQ(3u, changes.size());
+  for (const auto& change: changes)
+    EXPECT_TRUE(change.added);
+  EXPECT_EQ(before + 3, directory.call<qi::uint64_t>("currentSequence"));
+}
+
+TEST(ServiceDirectory, BulkRegisterAndUnregister)
+{
+  auto sd = qi::makeSession();
+  sd->listenStandalone("tcp://127.0.0.1:0");
+  auto client = qi::makeSession();
+  client->connect(sd->url());
+  qi::AnyObject directory = client->service("ServiceDirectory").value();
+
+  std::vector<qi::ServiceInfo> infos(2);
+  infos[0].setName("BulkA");
+  infos[1].setName("BulkB");
+  for (auto& info: infos)
+  {
+    info.setMachineId(qi::os::getMachineId());
+    info.setProcessId(qi::os::getpid());
+    info.setEndpoints(qi::UrlVector{sd->url()});
+  }
+
+  // The whole batch registers and acks in one exchange each.
+  const auto ids = directory.call<std::vector<unsigned int>>("registerServices", infos);
+  ASSERT_EQ(2u, ids.size());
+  directory.call<void>("servicesReady", ids);
+  EXPECT_EQ("BulkA", directory.call<qi::ServiceInfo>("service", "BulkA").name());
+  EXPECT_EQ("BulkB", directory.call<qi::ServiceInfo>("service", "BulkB").name());
+
+  // A conflicting batch is rejected as a whole: BulkC is not registered.
+  std::vector<qi::ServiceInfo> conflicting(2);
+  conflicting[0].setName("BulkC");
+  conflicting[1].setName("BulkA");
+  EXPECT_ANY_THROW(directory.call<std::vector<unsigned int>>("registerServices", conflicting));
+  EXPECT_ANY_THROW(directory.call<qi::ServiceInfo>("service", "BulkC"));
+
+  directory.call<void>("unregisterServices", ids);
+  EXPECT_ANY_THROW(directory.call<qi::ServiceInfo>("service", "BulkA"));
+  EXPECT_ANY_THROW(directory.call<qi::ServiceInfo>("service", "BulkB"));
+}
+
 TEST(ServiceDirectory, MultiRegister)
 {
   auto sd1 = qi::makeSession();
@@ -269,6 +348,41 @@ TEST(ServiceDirectory, NoThreadSpawnOnClientClose)
   }
 }
 
+TEST(ServiceDirectory, DroppingProxiesReleasesRemoteObjects)
+{
+  const int objectCount = 50;
+  auto server = qi::makeSession();
+  auto client = qi::makeSession();
+  server->listenStandalone("tcp://127.0.0.1:0");
+  client->connect(server->endpoints().back());
+
+  std::vector<qi::Future<void>> futures;
+  qi::DynamicObjectBuilder builder;
+  builder.advertiseMethod("make", [&] {
+    std::vector<qi::AnyObject> objects;
+    for (int i = 0; i < objectCount; ++i)
+    {
+      qi::Promise<void> promise;
+      objects.push_back(boost::make_shared<PromisedObject>(promise));
+      futures.push_back(promise.future());
+    }
+    return objects;
+  });
+  server->registerService("Factory", builder.object());
+
+  auto objects =
+      client->service("Factory").value().call<std::vector<qi::AnyObject>>("make");
+  ASSERT_EQ(static_cast<size_t>(objectCount), objects.size());
+
+  // Dropping the proxies coalesces the terminates into batched messages;
+  // the hosted objects must still all be released.
+  objects.clear();
+  for (auto& future: futures)
+  {
+    ASSERT_TRUE(test::finishesWithValue(future));
+  }
+}
+
 TEST(ServiceDirectory, IsNotConnectedAfterClose)
 {
   auto session = qi::makeSession();
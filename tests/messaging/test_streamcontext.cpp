@@ -38,3 +38,38 @@ TEST(TestStreamContext, sendCacheSetInsertTwoDifferent)
   EXPECT_TRUE(res2.second);
   EXPECT_NE(res1.first, res2.first);
 }
+
+namespace
+{
+  class TestContext : public qi::StreamContext
+  {
+  public:
+    void setRemoteCapability(const std::string& key, bool value)
+    {
+      _remoteCapabilityMap[key] = qi::AnyValue::from(value);
+      recomputeSharedCapabilityFlags();
+    }
+  };
+}
+
+TEST(TestStreamContext, sharedCapabilityFlagTracksMaps)
+{
+  TestContext ctx;
+  // No remote capabilities yet: everything is off, whatever the defaults.
+  EXPECT_FALSE(ctx.sharedCapabilityFlag(qi::StreamContext::SharedCapability_ObjectPtrUid));
+  EXPECT_FALSE(ctx.sharedCapabilityFlag(qi::StreamContext::SharedCapability_MessageCompression));
+
+  ctx.setRemoteCapability(qi::capabilityname::objectPtrUid, true);
+  EXPECT_TRUE(ctx.sharedCapabilityFlag(qi::StreamContext::SharedCapability_ObjectPtrUid));
+  EXPECT_EQ(true, ctx.sharedCapability<bool>(qi::capabilityname::objectPtrUid, false));
+
+  // Off by default locally: the remote side alone is not enough.
+  ctx.setRemoteCapability(qi::capabilityname::messageCompression, true);
+  EXPECT_FALSE(ctx.sharedCapabilityFlag(qi::StreamContext::SharedCapability_MessageCompression));
+  ctx.advertiseCapability(qi::capabilityname::messageCompression, qi::AnyValue::from(true));
+  EXPECT_TRUE(ctx.sharedCapabilityFlag(qi::StreamContext::SharedCapability_MessageCompression));
+
+  // Withdrawing one side turns the flag back off.
+  ctx.setRemoteCapability(qi::capabilityname::objectPtrUid, false);
+  EXPECT_FALSE(ctx.sharedCapabilityFlag(qi::StreamContext::SharedCapability_ObjectPtrUid));
+}
@@ -542,7 +542,7 @@ TYPED_TEST(NetMessageSocket, DisconnectWhileDisconnecting)
   );
   auto scopedWrite = ka::scoped_set_and_restore(
     N::_async_write_next_layer,
-    [=, &writeThreads](SslSocket<N>::next_layer_type&, const std::vector<N::_const_buffer_sequence>&, N::_anyTransferHandler h) {
+    [=, &writeThreads](SslSocket<N>::next_layer_type&, const N::_const_buffer_sequences&, N::_anyTransferHandler h) {
       writeThreads.push_back(std::thread{[=] {
         h(promiseAsyncReadWrite.future().value(), 0);
       }});
@@ -6,6 +6,7 @@
  */
 
 #include <string>
+#include <unordered_map>
 
 #include <gtest/gtest.h>
 
@@ -166,6 +167,34 @@ TEST(TestURL, CopyUrl)
   EXPECT_EQ("tcp://example.com:5", url.str());
 }
 
+TEST(TestURL, CopySharesParseAndDetachesOnSet)
+{
+  qi::Url url("tcp://example.com:5");
+  qi::Url copy(url);
+  // Copies share the parsed representation: no allocation, no re-parse.
+  EXPECT_EQ(&url.str(), &copy.str());
+  // A setter detaches the mutated handle only.
+  copy.setPort(6);
+  EXPECT_EQ("tcp://example.com:5", url.str());
+  EXPECT_EQ("tcp://example.com:6", copy.str());
+}
+
+TEST(TestURL, Hash)
+{
+  qi::Url a("tcp://example.com:5");
+  qi::Url b("tcp://example.com:5");
+  qi::Url c("tcp://example.com:6");
+  EXPECT_EQ(a.hash(), b.hash());
+  EXPECT_EQ(a, b);
+  EXPECT_NE(a, c);
+
+  std::unordered_map<qi::Url, int> endpoints;
+  endpoints[a] = 1;
+  endpoints[c] = 2;
+  EXPECT_EQ(1, endpoints.at(b));
+  EXPECT_EQ(2u, endpoints.size());
+}
+
 std::string urlOut(const qi::Url& u)
 {
   return u.str();
@@ -237,6 +266,30 @@ TEST(TestURL, SetAll)
   EXPECT_TRUE(url.isValid());
 }
 
+TEST(TestURL, QueryParameters)
+{
+  qi::Url url("tcp://127.0.0.1:9559?tcp-nodelay=0&recv-buffer-size=262144&flag");
+  EXPECT_TRUE(url.isValid());
+  EXPECT_EQ("tcp", url.protocol());
+  EXPECT_EQ("127.0.0.1", url.host());
+  EXPECT_EQ(9559, url.port());
+  EXPECT_TRUE(url.hasQueryParameter("tcp-nodelay"));
+  EXPECT_EQ("0", url.queryParameter("tcp-nodelay"));
+  EXPECT_EQ("262144", url.queryParameter("recv-buffer-size"));
+  EXPECT_TRUE(url.hasQueryParameter("flag"));
+  EXPECT_EQ("", url.queryParameter("flag"));
+  EXPECT_FALSE(url.hasQueryParameter("absent"));
+  EXPECT_EQ("", url.queryParameter("absent"));
+  EXPECT_EQ(3u, url.queryParameters().size());
+  // The query is kept in the url string and survives a copy.
+  EXPECT_NE(std::string::npos, url.str().find("?tcp-nodelay=0"));
+  qi::Url copy(url);
+  EXPECT_EQ("262144", copy.queryParameter("recv-buffer-size"));
+
+  qi::Url plain("tcp://127.0.0.1:9559");
+  EXPECT_TRUE(plain.queryParameters().empty());
+}
+
 TEST(TestURL, SpecifyUrl)
 {
   const qi::Url specific("0.0.0.0:0");
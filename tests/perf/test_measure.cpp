@@ -28,3 +28,33 @@ TEST(TestMeasure, DISABLED_TestNumFD)
   ASSERT_EQ(numFD + 1, qi::measure::getNumFD());
 #endif
 }
+
+#ifdef __linux__
+TEST(TestMeasure, TestResidentSetSize)
+#else
+TEST(TestMeasure, DISABLED_TestResidentSetSize)
+#endif
+{
+  ASSERT_GT(qi::measure::getResidentSetSize(), 0);
+}
+
+TEST(TestMeasure, TestPerfCounters)
+{
+  qi::measure::PerfCounters counters;
+  // Opening the counters may legitimately fail (non-Linux platform,
+  // restrictive perf_event_paranoid, missing PMU on a VM): the values must
+  // then simply degrade to -1.
+  counters.start();
+  volatile int sink = 0;
+  for (int i = 0; i < 100000; ++i)
+    sink = sink + i;
+  const qi::measure::CounterValues values = counters.stop();
+  if (values.cycles != -1)
+    EXPECT_GT(values.cycles, 0);
+  if (values.instructions != -1)
+    EXPECT_GT(values.instructions, 0);
+  if (values.cacheMisses != -1)
+    EXPECT_GE(values.cacheMisses, 0);
+  if (values.contextSwitches != -1)
+    EXPECT_GE(values.contextSwitches, 0);
+}
@@ -153,3 +153,31 @@ TEST(TestBuffer, TestAssignmentsAreDistinct)
   *asIntPtr(b0.data()) = 1234;
   ASSERT_EQ(993, *asIntPtr(b1.data()));
 }
+
+TEST(TestBuffer, TestReadBufferView)
+{
+  using namespace qi;
+  std::vector<int> v(100);
+  std::iota(begin(v), end(v), 25);
+  const auto len = v.size() * sizeof(v[0]);
+  Buffer view;
+  {
+    Buffer b;
+    b.write(&v[0], len);
+    BufferReader reader(b);
+    ASSERT_TRUE(reader.seek(sizeof(int)));
+    view = reader.readBufferView(len - 2 * sizeof(int));
+    // The view aliases the source storage instead of copying it.
+    ASSERT_EQ(static_cast<unsigned char*>(b.data()) + sizeof(int),
+              static_cast<unsigned char*>(view.data()));
+    ASSERT_EQ(len - sizeof(int), reader.position());
+    // Not enough bytes left: the reader is left untouched.
+    ASSERT_EQ(0u, reader.readBufferView(2 * sizeof(int)).size());
+    ASSERT_EQ(len - sizeof(int), reader.position());
+  }
+  // The view keeps the storage alive after the source buffer is gone.
+  ASSERT_EQ(len - 2 * sizeof(int), view.size());
+  const auto* data = static_cast<const unsigned char*>(view.data());
+  ASSERT_TRUE(std::equal(data, data + view.size(),
+                         reinterpret_cast<const unsigned char*>(&v[1])));
+}
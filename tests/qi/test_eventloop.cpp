@@ -2,6 +2,7 @@
 #include <mutex>
 #include <gtest/gtest.h>
 #include <qi/eventloop.hpp>
+#include <qi/parallel.hpp>
 #include "test_future.hpp"
 
 int ping(int v)
@@ -110,3 +111,109 @@ TEST(EventLoop, asyncFast)
     f.wait();
   }
 }
+
+TEST(EventLoop, WorkerCount)
+{
+  qi::EventLoop loop{ gEventLoopName, 2 };
+  EXPECT_GE(loop.workerCount(), 2u);
+}
+
+TEST(EventLoop, LagStats)
+{
+  qi::EventLoop loop{ gEventLoopName, 2 };
+  // Post enough tasks to guarantee at least one is sampled, whatever
+  // QI_EVENTLOOP_LAG_SAMPLE_RATE is set to (up to its default of 64).
+  std::vector<qi::Future<void>> futures;
+  for (int i = 0; i < 200; ++i)
+    futures.push_back(loop.async([]{}));
+  for (auto& future: futures)
+    future.wait();
+  const qi::EventLoopLagStats stats = loop.lagStats();
+  EXPECT_GT(stats.samples, 0u);
+  uint64_t bucketSum = 0;
+  for (unsigned i = 0; i < qi::EventLoopLagStats::bucketCount; ++i)
+    bucketSum += stats.buckets[i];
+  EXPECT_EQ(stats.samples, bucketSum);
+  EXPECT_GE(stats.totalLag, stats.maxLag);
+}
+
+TEST(EventLoop, TaskTagStats)
+{
+  qi::EventLoop loop{ gEventLoopName, 2 };
+  const unsigned int tag = qi::registerTaskTag("test.tagged");
+  ASSERT_NE(0u, tag);
+  // Registering the same name again yields the same tag.
+  EXPECT_EQ(tag, qi::registerTaskTag("test.tagged"));
+
+  std::vector<qi::Future<void>> futures;
+  for (int i = 0; i < 10; ++i)
+    futures.push_back(loop.async([]{}, qi::taggedExecutionOptions(tag)));
+  for (auto& future: futures)
+    future.wait();
+
+  bool found = false;
+  for (const qi::TaskTagStats& row: qi::taskTagStats())
+  {
+    if (row.name != "test.tagged")
+      continue;
+    found = true;
+    EXPECT_GE(row.taskCount, 10u);
+  }
+  EXPECT_TRUE(found);
+}
+
+TEST(EventLoop, MonitorEventLoopCancel)
+{
+  qi::EventLoop loop{ gEventLoopName, 2 };
+  qi::Future<void> monitoring = loop.monitorEventLoop(nullptr, 60 * 1000 * 1000);
+  EXPECT_TRUE(monitoring.isRunning());
+  monitoring.cancel();
+  EXPECT_EQ(qi::FutureState_Canceled, monitoring.wait(1000));
+}
+
+TEST(EventLoop, ParallelForCoversTheRange)
+{
+  const size_t n = 10000;
+  std::vector<std::atomic<int>> hits(n);
+  for (auto& hit: hits)
+    hit = 0;
+  qi::parallelFor(0, n, [&](size_t i) { ++hits[i]; }).value(2000);
+  for (size_t i = 0; i < n; ++i)
+    ASSERT_EQ(1, hits[i].load()) << "index " << i;
+}
+
+TEST(EventLoop, ParallelForEmptyRangeFinishesImmediately)
+{
+  auto f = qi::parallelFor(3, 3, [](size_t) { FAIL(); });
+  ASSERT_TRUE(f.isFinished());
+}
+
+TEST(EventLoop, ParallelForReportsTheFirstError)
+{
+  auto f = qi::parallelFor(0, 1000, [](size_t i) {
+    if (i == 500)
+      throw std::runtime_error("broken iteration");
+  });
+  f.wait(2000);
+  ASSERT_TRUE(f.hasError());
+  EXPECT_EQ("broken iteration", f.error());
+}
+
+TEST(EventLoop, ParallelReduceSums)
+{
+  const size_t n = 10000;
+  auto f = qi::parallelReduce<int64_t>(
+      1, n + 1, 0,
+      [](size_t i) { return static_cast<int64_t>(i); },
+      [](int64_t a, int64_t b) { return a + b; });
+  ASSERT_EQ(static_cast<int64_t>(n) * (n + 1) / 2, f.value(2000));
+}
+
+TEST(EventLoop, ParallelReduceEmptyRangeYieldsInit)
+{
+  auto f = qi::parallelReduce<int64_t>(
+      5, 5, 42,
+      [](size_t i) { return static_cast<int64_t>(i); },
+      [](int64_t a, int64_t b) { return a + b; });
+  ASSERT_EQ(42, f.value());
+}
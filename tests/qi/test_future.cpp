@@ -425,6 +425,23 @@ TEST(Future, SyncBasic)
   ASSERT_TRUE(true);
 }
 
+TEST(Future, SyncHandOffOnEventLoopThread)
+{
+  qi::setFutureSyncHandOffEnabled(true);
+  const auto countBefore = qi::futureSyncHandOffCount();
+  qi::Promise<int> promise;
+  qi::Future<void> done = qi::getEventLoop()->async([&] {
+    qi::FutureSync<int> fs;
+    fs = promise.future();
+    // fs is destroyed here, on an event-loop thread: with the hand-off
+    // policy enabled it must not block on the unset promise.
+  });
+  EXPECT_EQ(qi::FutureState_FinishedWithValue, done.wait(3000));
+  EXPECT_GT(qi::futureSyncHandOffCount(), countBefore);
+  promise.setValue(42);
+  qi::setFutureSyncHandOffEnabled(false);
+}
+
 qi::FutureSync<int> getSync(std::atomic<bool>& tag)
 {
   qi::EventLoop* el = qi::getEventLoop();
@@ -772,6 +789,49 @@ TEST(FutureTestThen, ErrorForwardingAndThenThen)
   ASSERT_TRUE(ok.load());
 }
 
+TEST(FutureTestTakeValue, MovesWhenLastReference)
+{
+  qi::Future<std::vector<int>> fut;
+  {
+    qi::Promise<std::vector<int>> p;
+    p.setValue(std::vector<int>(1000, 42));
+    fut = p.future();
+  }
+  const std::vector<int> taken = fut.takeValue();
+  EXPECT_EQ(1000u, taken.size());
+  // The future was the last reference to the state: the value was moved out.
+  EXPECT_TRUE(fut.value().empty());
+}
+
+TEST(FutureTestTakeValue, CopiesWhenShared)
+{
+  qi::Promise<std::vector<int>> p;
+  p.setValue(std::vector<int>(1000, 42));
+  qi::Future<std::vector<int>> fut = p.future();
+  const std::vector<int> taken = fut.takeValue();
+  EXPECT_EQ(1000u, taken.size());
+  // The promise still references the state: the value must stay intact.
+  EXPECT_EQ(1000u, fut.value().size());
+}
+
+TEST(FutureTestThen, AndThenRValueContinuationStealsTheValue)
+{
+  qi::Promise<std::vector<int>> p;
+  auto ff = p.future().andThen([](std::vector<int>&& v) { return v.size(); });
+  p.setValue(std::vector<int>(1000, 42));
+  EXPECT_EQ(1000u, ff.value());
+  EXPECT_TRUE(p.future().value().empty());
+}
+
+TEST(FutureTestThen, AndThenConstRefContinuationKeepsTheValue)
+{
+  qi::Promise<std::vector<int>> p;
+  auto ff = p.future().andThen([](const std::vector<int>& v) { return v.size(); });
+  p.setValue(std::vector<int>(1000, 42));
+  EXPECT_EQ(1000u, ff.value());
+  EXPECT_EQ(1000u, p.future().value().size());
+}
+
 TEST(FutureTestUnwrap, Unwrap)
 {
   qi::Promise<qi::Future<int> > prom;
@@ -1007,6 +1067,32 @@ TEST(FutureBarrier, Cancel)
   fut.value();
 }
 
+TEST(CancelGroup, CancelsEveryLinkedFuture)
+{
+  qi::CancelGroup<int> group(BARRIER_N);
+  std::vector<qi::Future<int> > futures;
+  for (int it = 0; it < BARRIER_N; ++it) {
+    qi::Promise<int> prom(doCancel);
+    group.add(prom.future());
+    futures.push_back(prom.future());
+  }
+  ASSERT_EQ(static_cast<size_t>(BARRIER_N), group.pendingCount());
+
+  group.cancelAll();
+  ASSERT_TRUE(group.cancelled());
+  ASSERT_EQ(0u, group.pendingCount());
+  for (size_t it = 0; it < futures.size(); ++it) {
+    futures[it].wait();
+    EXPECT_TRUE(futures[it].isCanceled());
+  }
+
+  // Futures linked after the sweep are cancelled on the spot.
+  qi::Promise<int> late(doCancel);
+  group.add(late.future());
+  late.future().wait();
+  EXPECT_TRUE(late.future().isCanceled());
+}
+
 TEST(FutureBarrier, ClosedBarrier)
 {
   qi::FutureBarrier<void> barrier;
@@ -1086,6 +1172,41 @@ TEST(FutureTestWaitForAll, SimpleTest) {
   }
 }
 
+TEST(FutureTestWaitForAll, FlatOverloadDeliversFutures) {
+  std::vector< qi::Future<int> > vect;
+  std::vector< qi::Promise<int> > proms(BARRIER_N);
+
+  for (int it = 0; it < BARRIER_N; ++it) {
+    vect.push_back(proms.at(it).future());
+  }
+  qi::Future< std::vector< qi::Future<int> > > all = qi::waitForAll<int>(std::move(vect));
+  ASSERT_TRUE(all.isRunning());
+  for (int it = 0; it < BARRIER_N; ++it) {
+    proms.at(it).setValue(it);
+  }
+  const std::vector< qi::Future<int> > results = all.value();
+  ASSERT_EQ(static_cast<size_t>(BARRIER_N), results.size());
+  for (int it = 0; it < BARRIER_N; ++it) {
+    ASSERT_EQ(it, results.at(it).value());
+  }
+}
+
+TEST(FutureTestWaitForFirst, FlatOverloadReturnsFirstValid) {
+  std::vector< qi::Future<int> > vect;
+
+  for (int it = 0; it < BARRIER_N; ++it) {
+    vect.push_back(emulateSet(it, it != 3));
+  }
+  qi::Future<int> a = qi::waitForFirst<int>(std::move(vect)).value();
+  ASSERT_FALSE(a.hasError());
+  ASSERT_EQ(a.value(), 3);
+}
+
+TEST(FutureTestWaitForFirst, FlatOverloadFailsWhenEmpty) {
+  std::vector< qi::Future<int> > vect;
+  ASSERT_TRUE(qi::waitForFirst<int>(std::move(vect)).hasError());
+}
+
 TEST(FutureTestWaitForFirst, SuccessfulTest) {
   std::vector< qi::Future<int> > vect;
 
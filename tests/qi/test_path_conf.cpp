@@ -1,3 +1,5 @@
+#include <ctime>
+
 #include <gtest/gtest.h>
 #include <boost/filesystem.hpp>
 #include <boost/filesystem/fstream.hpp>
@@ -101,6 +103,34 @@ TEST_F(PathConfTest, CircularTest)
   ASSERT_EQ(actual, expected);
 }
 
+TEST_F(PathConfTest, CacheInvalidationTest)
+{
+  const boost::filesystem::path foo_sdk = _tmp / "foo/sdk";
+  const boost::filesystem::path foo_src = _tmp / "foo/src";
+  boost::filesystem::create_directories(foo_src);
+  boost::filesystem::path foo_path_conf = _tmp / "foo/sdk/share/qi/";
+  boost::filesystem::create_directories(foo_path_conf);
+  foo_path_conf /= "path.conf";
+  boost::filesystem::ofstream ofs(foo_path_conf);
+  ofs << foo_sdk.string() << std::endl;
+  ofs.close();
+  std::vector<std::string> first = qi::path::parseQiPathConf(foo_sdk.string());
+  // Second resolution is served from the cache and must match.
+  ASSERT_EQ(first, qi::path::parseQiPathConf(foo_sdk.string()));
+
+  ofs.open(foo_path_conf, std::ios::app);
+  ofs << foo_src.string() << std::endl;
+  ofs.close();
+  // Bump the mtime explicitly so the rewrite is seen even with one-second
+  // timestamp granularity.
+  boost::filesystem::last_write_time(foo_path_conf, std::time(nullptr) + 2);
+
+  std::vector<std::string> expected;
+  expected.push_back(foo_sdk.string());
+  expected.push_back(foo_src.string());
+  ASSERT_EQ(expected, qi::path::parseQiPathConf(foo_sdk.string()));
+}
+
 TEST_F(PathConfTest, KeepOrderTest)
 {
   const boost::filesystem::path fooPath = _tmp / "foo";
@@ -181,6 +181,28 @@ TEST(TestPeriodicTask, TriggerStartStop)
   }
 }
 
+TEST(TestPeriodicTask, Stats)
+{
+  qi::PeriodicTask pt;
+  qi::Atomic<int> a;
+  pt.setCallback(&inc, std::ref(a));
+  pt.setUsPeriod(1000);
+  pt.start();
+  while (a.load() < 10)
+    std::this_thread::sleep_for(std::chrono::milliseconds{1});
+  pt.stop();
+  const qi::PeriodicTask::Stats stats = pt.stats();
+  EXPECT_GE(stats.activations, 10u);
+  uint64_t bucketSum = 0;
+  for (unsigned i = 0; i < qi::PeriodicTask::Stats::jitterBucketCount; ++i)
+    bucketSum += stats.jitterBuckets[i];
+  EXPECT_EQ(stats.activations, bucketSum);
+  EXPECT_GE(stats.maxCallbackTime, qi::Duration(0));
+  EXPECT_GE(stats.totalJitter, stats.maxJitter);
+  pt.resetStats();
+  EXPECT_EQ(0u, pt.stats().activations);
+}
+
 TEST(TestPeriodicTask, DoesNotDeadlockWhenStartedWithStrandInsideStrandContext)
 {
   qi::Strand strand;
@@ -3,8 +3,11 @@
 */
 
 #include <algorithm>
+#include <array>
 #include <qi/ptruid.hpp>
 #include <qi/os.hpp>
+#include <qi/uuid.hpp>
+#include <ka/sha1.hpp>
 #include <ka/conceptpredicate.hpp>
 #include <qi/application.hpp>
 #include <gtest/gtest.h>
@@ -178,3 +181,35 @@ TEST(PtrUid, StdUnorderedMap)
   EXPECT_EQ("j", map[idJ]);
   EXPECT_EQ("k", map[idK]);
 }
+
+#ifndef QI_PTRUID_DEBUG
+TEST(PtrUid, MatchesSha1OfConcatenation)
+{
+  using namespace qi;
+  const auto& muid = os::getMachineIdAsUuid();
+  const auto& puid = os::getProcessUuid();
+  const int i{0};
+  const int* ptr = &i;
+
+  // The uid must stay the sha1 of machine uuid, process uuid and pointer
+  // bytes, whatever shortcut the implementation takes.
+  std::array<uint8_t, 2 * sizeof(Uuid) + sizeof(ptr)> buffer;
+  const auto uptr = reinterpret_cast<std::uintptr_t>(ptr);
+  auto it = std::copy(muid.begin(), muid.end(), buffer.begin());
+  it = std::copy(puid.begin(), puid.end(), it);
+  const auto* pb = reinterpret_cast<const uint8_t*>(&uptr);
+  std::copy(pb, pb + sizeof(uptr), it);
+  const ka::sha1_digest_t expected = ka::sha1(buffer);
+
+  const PtrUid id(muid, puid, ptr);
+  EXPECT_TRUE(std::equal(expected.begin(), expected.end(), begin(id)));
+
+  // Changing the uuid pair must not reuse the previous prefix.
+  Uuid other = puid;
+  other.data[0] ^= 0xFF;
+  const PtrUid idOther(muid, other, ptr);
+  EXPECT_NE(id, idOther);
+  const PtrUid idBack(muid, puid, ptr);
+  EXPECT_EQ(id, idBack);
+}
+#endif
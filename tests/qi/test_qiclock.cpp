@@ -66,6 +66,23 @@ TEST(QiClock, clock_sleep_our)
 
 using uint32ms = chrono::duration<uint32_t, boost::milli>;
 
+TEST(QiClock, nowCoarse)
+{
+  // The coarse clock may lag the precise one by a kernel tick, but must
+  // share its epoch and never run ahead of a later precise read.
+  const qi::SteadyClock::time_point before = qi::SteadyClock::now();
+  const qi::SteadyClock::time_point coarse = qi::SteadyClock::nowCoarse();
+  qi::os::msleep(50);
+  const qi::SteadyClock::time_point after = qi::SteadyClock::now();
+  EXPECT_LE(coarse, after);
+  EXPECT_LT(before - qi::MilliSeconds(200), coarse);
+
+  const qi::Clock::time_point coarseClock = qi::Clock::nowCoarse();
+  const qi::Clock::time_point afterClock = qi::Clock::now();
+  EXPECT_LE(coarseClock, afterClock);
+  EXPECT_LT(afterClock - qi::MilliSeconds(200), coarseClock);
+}
+
 TEST(QiClock, tofromUint32ms)
 {
   // a test to show how we can convert from 32-bits guess-what-my-epoch-is
@@ -3,6 +3,7 @@
 #include <boost/filesystem.hpp>
 #include <boost/predef/os.h>
 #include <qi/application.hpp>
+#include <qi/future.hpp>
 #include <qi/log.hpp>
 #include <qi/os.hpp>
 #include <qi/path.hpp>
@@ -82,6 +83,24 @@ TEST(spawnvp, InvalidBin)
 }
 
 
+TEST(spawnvpAsync, CmdWithArgs)
+{
+  qi::Future<int> child = qi::os::spawnvpAsync({binDir, "23"});
+
+  int status = 0;
+  int error = qi::os::waitpid(child.value(), &status);
+
+  EXPECT_EQ(0, error) << "error: " << error;
+  EXPECT_EQ(23, status) << "status: " << status;
+}
+
+TEST(spawnvpAsync, InvalidBin)
+{
+  qi::Future<int> child = qi::os::spawnvpAsync({"test42"});
+  child.wait();
+  EXPECT_TRUE(child.hasError());
+}
+
 TEST(spawnlp, CmdWithNoArgs)
 {
   std::string bin = binDir.c_str();
@@ -79,3 +79,22 @@ TEST_F(AsyncLog, cats)
   qiLogCategory("pan");
   qiLogWarningF("canard %s", 12);
 }
+
+// The deferred macros capture the arguments and let the log thread format:
+// the message delivered to the handler must still be the formatted one.
+TEST_F(AsyncLog, deferredFormatting)
+{
+  qiLogCategory("core.log.testdeferred");
+  qi::Promise<std::string> message;
+  LogHandler handler("DeferredHandler",
+    [=](qi::LogLevel, qi::Clock::time_point, qi::SystemClock::time_point,
+        const char* category, const char* msg, const char*, const char*, int) mutable {
+      if (std::string(category) == "core.log.testdeferred")
+        message.setValue(msg);
+    }, qi::LogLevel_Verbose);
+
+  qiLogWarningD("canard %s %s", 12, 2.5);
+  qi::log::flush();
+  ASSERT_TRUE(test::finishesWithValue(message.future()));
+  EXPECT_EQ("canard 12 2.5", message.future().value());
+}
@@ -204,6 +204,33 @@ TEST_F(SyncLog, formatting)
   }
 }
 
+// Deferred statements format immediately in synchronous mode, so the
+// handler must see the same messages as with the F macros.
+TEST_F(SyncLog, deferredFormatting)
+{
+  qiLogCategory("qi.test");
+
+  MockLogHandler handler("scones");
+
+  {
+    const auto _u = scopeMockExpectations(handler);
+    EXPECT_CALL(handler, log(_, _, StrEq("coin")));
+    qiLogErrorD("coin");
+  }
+
+  {
+    const auto _u = scopeMockExpectations(handler);
+    EXPECT_CALL(handler, log(_, _, StrEq("coin 42")));
+    qiLogErrorD("coin %s", 42);
+  }
+
+  {
+    const auto _u = scopeMockExpectations(handler);
+    EXPECT_CALL(handler, log(_, _, StrEq("coin 42 2.5 yes")));
+    qiLogErrorD("coin %s %s %s", 42, 2.5, "yes");
+  }
+}
+
 TEST_F(SyncLog, filteringChange)
 {
   MockLogHandler handler("set");
@@ -573,6 +573,17 @@ TEST(QiOs, sequentialHostIPAddrs)
   }
 }
 
+TEST(QiOs, hostIPAddrsObserver)
+{
+  const int id = qi::os::addHostIPAddrsObserver([]{});
+  const int id2 = qi::os::addHostIPAddrsObserver([]{});
+  EXPECT_NE(id, id2);
+  qi::os::removeHostIPAddrsObserver(id);
+  qi::os::removeHostIPAddrsObserver(id2);
+  // Removing an already removed observer is harmless.
+  qi::os::removeHostIPAddrsObserver(id);
+}
+
 TEST(QiOs, getMachineId)
 {
   int status = 0;
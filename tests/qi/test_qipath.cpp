@@ -652,6 +652,26 @@ TEST_F(qiPathData, findDataDir)
   EXPECT_TRUE(barDirMatches.empty()); // listData discards directories
 }
 
+TEST(qiPath, findDataCacheInvalidation)
+{
+  const char* args = { (char *) "build/sdk/bin/foo" };
+  qi::SDKLayout sdkl(args);
+  bfs::path tmp(qi::os::mktmpdir("qipathcache"), qi::unicodeFacet());
+  sdkl.setWritablePath(tmp.string(qi::unicodeFacet()));
+
+  ASSERT_TRUE(sdkl.findData("foo", "late.dat").empty());
+
+  // The miss above cached the directory listing: a file created afterwards
+  // is not seen until the cache is invalidated.
+  writeData(sdkl.userWritableDataPath("foo", "late.dat"));
+  EXPECT_TRUE(sdkl.findData("foo", "late.dat").empty());
+
+  sdkl.invalidateCache();
+  EXPECT_FALSE(sdkl.findData("foo", "late.dat").empty());
+
+  bfs::remove_all(tmp);
+}
+
 TEST(qiPath, filesystemConcat)
 {
   std::string s0 = fsconcat("/toto", "tata");
@@ -717,3 +717,41 @@ TEST(TestStrand, JoinStrandEndsRunningAsyncFutureInError)
   EXPECT_NE(std::string::npos, fut.error().find("strand is dying"));
   prom.setValue(nullptr);
 }
+
+TEST(TestStrand, MaxPendingTasksFailPolicy)
+{
+  qi::Strand strand;
+  strand.setMaxPendingTasks(2, qi::Strand::OverflowPolicy::Fail);
+  qi::Promise<void> blocker;
+  auto running = strand.async([&]{ blocker.future().wait(); });
+  // Wait until the blocking task occupies the strand and left the queue.
+  while (strand.pendingTaskCount() != 0)
+    std::this_thread::sleep_for(std::chrono::milliseconds{ 1 });
+  auto f1 = strand.async([]{});
+  auto f2 = strand.async([]{});
+  EXPECT_EQ(2u, strand.pendingTaskCount());
+  auto f3 = strand.async([]{});
+  EXPECT_TRUE(f3.hasError());
+  EXPECT_NE(std::string::npos, f3.error().find("task limit"));
+  blocker.setValue(nullptr);
+  EXPECT_EQ(qi::FutureState_FinishedWithValue, f1.wait(usualTimeout));
+  EXPECT_EQ(qi::FutureState_FinishedWithValue, f2.wait(usualTimeout));
+  running.wait();
+}
+
+TEST(TestStrand, MaxPendingTasksDropOldestPolicy)
+{
+  qi::Strand strand;
+  strand.setMaxPendingTasks(1, qi::Strand::OverflowPolicy::DropOldest);
+  qi::Promise<void> blocker;
+  auto running = strand.async([&]{ blocker.future().wait(); });
+  while (strand.pendingTaskCount() != 0)
+    std::this_thread::sleep_for(std::chrono::milliseconds{ 1 });
+  auto oldest = strand.async([]{});
+  auto newest = strand.async([]{});
+  EXPECT_TRUE(oldest.hasError());
+  EXPECT_NE(std::string::npos, oldest.error().find("dropped"));
+  blocker.setValue(nullptr);
+  EXPECT_EQ(qi::FutureState_FinishedWithValue, newest.wait(usualTimeout));
+  running.wait();
+}
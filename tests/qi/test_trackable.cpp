@@ -126,6 +126,24 @@ TEST(FutureTrack, track_actor_build)
   (void) f2;
 }
 
+TEST(Trackable, WrapperOutlivingObjectCallsFallback)
+{
+  std::atomic<int> v{0};
+  int failures = 0;
+  SetValue2* w = new SetValue2(v);
+  auto wrapped = qi::trackWithFallback([&failures]{ ++failures; },
+                                      [w](int value){ w->exchange(value); }, w);
+  wrapped(1);
+  EXPECT_EQ(1, v);
+  EXPECT_EQ(0, failures);
+  delete w;
+  // the wrapper co-owns the tracking state: calling it after the object
+  // died must hit the fallback, not the dead object
+  wrapped(2);
+  EXPECT_EQ(1, v);
+  EXPECT_EQ(1, failures);
+}
+
 TEST(Trackable, CanTrackFunctionWithExplicitDefaultCtorReturnType)
 {
   struct WithExplicitDefaultCtor { explicit WithExplicitDefaultCtor() = default; };
@@ -193,6 +193,41 @@ TEST(TestTraceAnalyzer, AsyncChildren)
 }
 
 
+TEST(TestTraceAnalyzer, RollingWindow)
+{
+  qi::TraceAnalyzer ta;
+  qi::AnyValue noargs;
+  ta.setRollingWindow(50);
+  ta.addTrace(qi::EventTrace(10, EventTrace::Event_Call,   100, noargs, ts(10), 0, 0, 50, 50), 1);
+  ta.addTrace(qi::EventTrace(10, EventTrace::Event_Result, 100, noargs, ts(20), 0, 0, 50, 50), 1);
+  EXPECT_EQ("50 10:1.100\n", ta.dumpTraces());
+  // Call 11 starts more than 50us after call 10 did: 10 gets evicted.
+  ta.addTrace(qi::EventTrace(11, EventTrace::Event_Call,   100, noargs, ts(100), 0, 0, 50, 50), 1);
+  ta.addTrace(qi::EventTrace(11, EventTrace::Event_Result, 100, noargs, ts(110), 0, 0, 50, 50), 1);
+  EXPECT_EQ("50 11:1.100\n", ta.dumpTraces());
+}
+
+TEST(TestTraceAnalyzer, MethodStatistics)
+{
+  qi::TraceAnalyzer ta;
+  qi::AnyValue noargs;
+  ta.addTrace(qi::EventTrace(10, EventTrace::Event_Call,   100, noargs, ts(10), 0, 0, 50, 50), 1);
+  ta.addTrace(qi::EventTrace(10, EventTrace::Event_Result, 100, noargs, ts(30), 4, 2, 50, 50), 1);
+  // Order independence: the end of call 11 arrives first.
+  ta.addTrace(qi::EventTrace(11, EventTrace::Event_Result, 100, noargs, ts(140), 0, 0, 50, 50), 1);
+  ta.addTrace(qi::EventTrace(11, EventTrace::Event_Call,   100, noargs, ts(100), 0, 0, 50, 50), 1);
+  qi::TraceAnalyzer::MethodStatisticsMap stats = ta.methodStatistics();
+  ASSERT_EQ(1u, stats.size());
+  const qi::MethodStatistics& ms = stats[qi::TraceAnalyzer::MethodKey(1u, 100u)];
+  EXPECT_EQ(2u, ms.count());
+  EXPECT_FLOAT_EQ(20e-6f, ms.wall().minValue());
+  EXPECT_FLOAT_EQ(40e-6f, ms.wall().maxValue());
+  EXPECT_FLOAT_EQ(60e-6f, ms.wall().cumulatedValue());
+  EXPECT_FLOAT_EQ(4e-6f, ms.user().maxValue());
+  ta.clearMethodStatistics();
+  EXPECT_TRUE(ta.methodStatistics().empty());
+}
+
 TEST(TestTraceAnalyzer, BogusChildren)
 {
   qi::TraceAnalyzer ta;
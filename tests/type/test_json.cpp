@@ -6,7 +6,9 @@
 #include <float.h>
 #include <cmath>
 #include <gtest/gtest.h>
+#include <cstring>
 #include <map>
+#include <vector>
 #include <qi/anyvalue.hpp>
 #include <qi/application.hpp>
 #include <qi/type/typeinterface.hpp>
@@ -107,6 +109,17 @@ TEST(EncodeJSON, String) {
   EXPECT_EQ("\" \\\" \\u0000 \\u00E9 \"", qi::encodeJSON(" \" \0 é "));
 }
 
+TEST(EncodeJSON, LongString) {
+  // Strings longer than one SIMD chunk, with escapes at chunk boundaries.
+  const std::string clean(100, 'a');
+  EXPECT_EQ("\"" + clean + "\"", qi::encodeJSON(clean));
+  std::string mixed = clean + "\n" + clean + "\"" + clean + "\t";
+  EXPECT_EQ("\"" + clean + "\\n" + clean + "\\\"" + clean + "\\t\"",
+            qi::encodeJSON(mixed));
+  EXPECT_EQ("\"" + clean + "\\u0001" + clean + "\"",
+            qi::encodeJSON(clean + "\x01" + clean));
+}
+
 TEST(EncodeJSON, CharTuple) {
   qi::AnyValue gv(qi::TypeInterface::fromSignature(qi::Signature("(c)")));
   EXPECT_EQ("[0]", qi::encodeJSON(gv));
@@ -138,6 +151,32 @@ TEST(EncodeJSON, OptionalValue)
   EXPECT_EQ("642", qi::encodeJSON(boost::optional<int>(642)));
 }
 
+TEST(EncodeJSON, SinkStreamsTheSameDocument)
+{
+  // A value big enough to be delivered in several chunks.
+  std::map<std::string, std::vector<int> > big;
+  for (int i = 0; i < 1000; ++i)
+  {
+    std::vector<int>& v = big["key" + qi::encodeJSON(i)];
+    v.assign(100, i);
+  }
+  const std::string expected = qi::encodeJSON(big);
+
+  std::string streamed;
+  size_t chunks = 0;
+  qi::encodeJSON(big, qi::JsonSink([&](const char* data, size_t size) {
+    streamed.append(data, size);
+    ++chunks;
+  }));
+  EXPECT_EQ(expected, streamed);
+  EXPECT_GT(chunks, 1u);
+
+  qi::Buffer buffer;
+  qi::encodeJSON(big, buffer);
+  ASSERT_EQ(expected.size(), buffer.size());
+  EXPECT_EQ(0, memcmp(expected.data(), buffer.data(), buffer.size()));
+}
+
 template<class T>
 std::string itoa(T n)
 {
@@ -456,3 +495,35 @@ TEST(DecodeJSON, StructWithDifferentSizedFields)
   EXPECT_EQ(val,
             res) << qi::encodeJSON(val) << "\n" << qi::encodeJSON(res);
 }
+
+TEST(DecodeJSON, TypedTarget)
+{
+  // typed decode: straight into the target, no intermediate dynamic tree
+  std::vector<int> ints;
+  qi::decodeJSON("[1, 2, 3]", &ints);
+  ASSERT_EQ(3u, ints.size());
+  EXPECT_EQ(2, ints[1]);
+
+  std::map<std::string, std::vector<std::string> > dict;
+  qi::decodeJSON("{\"a\":[\"x\"], \"b\":[\"y\", \"z\\n\"]}", &dict);
+  ASSERT_EQ(2u, dict.size());
+  EXPECT_EQ("z\n", dict["b"][1]);
+
+  // objects fill struct members by name, unknown keys are skipped
+  Qiqi val;
+  qi::decodeJSON("{\"fint\":44, \"ignored\":[1, {}], \"fdouble\":5.5555, \"ffloat\":3.14}",
+                 &val);
+  EXPECT_EQ(44, val.fint);
+  EXPECT_DOUBLE_EQ(5.5555, val.fdouble);
+  EXPECT_FLOAT_EQ(3.14f, val.ffloat);
+
+  // round-trip through the encoder (unannotated struct: array form)
+  MPoint point;
+  qi::decodeJSON(qi::encodeJSON(MPoint(3, 4)), &point);
+  EXPECT_EQ(3, point.x);
+  EXPECT_EQ(4, point.y);
+
+  // mismatches throw instead of producing half-converted values
+  EXPECT_ANY_THROW(qi::decodeJSON("{\"a\":1}", &ints));
+  EXPECT_ANY_THROW(qi::decodeJSON("[1, 2.5]", &ints));
+}
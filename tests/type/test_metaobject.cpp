@@ -203,3 +203,85 @@ TEST(MetaObject, independentMosWithTheSameContentAreEqual)
   EXPECT_FALSE(mo1 < mo2);
   EXPECT_FALSE(mo2 < mo1);
 }
+
+TEST(MetaObject, contentHashMatchesForSameContent)
+{
+  qi::MetaObjectBuilder b1;
+  b1.addMethod("i", "f", "(i)");
+  b1.addProperty("p", "s");
+  b1.setDescription("my_mo");
+
+  qi::MetaObjectBuilder b2;
+  b2.addMethod("i", "f", "(i)");
+  b2.addProperty("p", "s");
+  b2.setDescription("my_mo");
+
+  EXPECT_EQ(b1.metaObject().contentHash(), b2.metaObject().contentHash());
+}
+
+TEST(MetaObject, contentHashDiffersOnProperty)
+{
+  qi::MetaObjectBuilder b1;
+  b1.addMethod("i", "f", "(i)");
+
+  qi::MetaObjectBuilder b2;
+  b2.addMethod("i", "f", "(i)");
+  b2.addProperty("p", "s");
+
+  EXPECT_NE(b1.metaObject().contentHash(), b2.metaObject().contentHash());
+}
+
+TEST(MetaObject, internSharesMethodPayloads)
+{
+  qi::MetaObjectBuilder b1;
+  const unsigned int f = b1.addMethod("i", "f", "(i)", 7).id;
+  b1.addMethod("i", "f", "(ii)", 8);
+  b1.setDescription("pooled_mo");
+
+  qi::MetaObjectBuilder b2;
+  b2.addMethod("i", "f", "(i)", 7);
+  b2.addMethod("i", "f", "(ii)", 8);
+  b2.setDescription("pooled_mo");
+
+  qi::MetaObject mo1 = qi::MetaObject::intern(b1.metaObject());
+  qi::MetaObject mo2 = qi::MetaObject::intern(b2.metaObject());
+
+  // same content: both copies share the pooled method payloads
+  EXPECT_EQ(&mo1.method(f)->name(), &mo2.method(f)->name());
+
+  // overload resolution stays per-instance and functional after interning
+  bool canCache = false;
+  EXPECT_EQ((int)f, mo1.findMethod("f", args(1), &canCache));
+  EXPECT_TRUE(canCache);
+  EXPECT_EQ(8, mo2.findMethod("f", args(1, 2), &canCache));
+
+  // different content gets a different pooled instance
+  qi::MetaObjectBuilder b3;
+  b3.addMethod("i", "f", "(i)", 7);
+  qi::MetaObject mo3 = qi::MetaObject::intern(b3.metaObject());
+  EXPECT_TRUE(mo1 < mo3 || mo3 < mo1);
+}
+
+TEST(MetaObject, reserveThenBuildDetectsDuplicates)
+{
+  qi::MetaObjectBuilder b;
+  b.reserve(3, 2, 2);
+  const unsigned int f = b.addMethod("i", "f", "(i)").id;
+  const unsigned int s = b.addSignal("sig", "(i)").id;
+  const unsigned int p = b.addProperty("prop", "s").id;
+
+  // re-adding an existing member hands back its id instead of creating one
+  EXPECT_FALSE(b.addMethod("i", "f", "(i)").isNewMember);
+  EXPECT_EQ(f, b.addMethod("i", "f", "(i)").id);
+  EXPECT_FALSE(b.addSignal("sig", "(i)").isNewMember);
+  EXPECT_EQ(s, b.addSignal("sig", "(i)").id);
+  EXPECT_FALSE(b.addProperty("prop", "s").isNewMember);
+  EXPECT_EQ(p, b.addProperty("prop", "s").id);
+
+  // a method clashing with an existing signal is rejected
+  EXPECT_THROW(b.addMethod("i", "sig", "(i)"), std::runtime_error);
+
+  qi::MetaObject mo = b.metaObject();
+  EXPECT_EQ((int)s, mo.signalId("sig")); // by-name lookup, not full signature
+  EXPECT_EQ((int)p, mo.propertyId("prop::(s)"));
+}
@@ -13,6 +13,7 @@
 #include <boost/bind.hpp>
 #include <boost/function.hpp>
 #include <boost/assign/list_of.hpp>
+#include <boost/optional.hpp>
 
 #include "test_object.hpp"
 
@@ -22,6 +23,7 @@
 #include <qi/anyobject.hpp>
 #include <qi/type/dynamicobjectbuilder.hpp>
 #include <qi/type/objecttypebuilder.hpp>
+#include <qi/type/detail/tracering.hpp>
 #include <qi/anymodule.hpp>
 #include <random>
 #include <boost/container/flat_map.hpp>
@@ -404,6 +406,34 @@ TEST(TestObject, Methods) {
   EXPECT_EQ(f, obj.call<C>("valuetest", f));
 }
 
+static int overInt(int a)                { return a; }
+static std::string overStr(std::string s){ return s; }
+static int overTwo(int a, int b)         { return a + b; }
+
+TEST(TestObject, RepeatedNameCalls) {
+  // Repeated name-based calls take the trusted resolution cache in
+  // GenericObject after the first call; results must not change and
+  // overloads with the same argument count must still resolve per call.
+  qi::DynamicObjectBuilder ob;
+  ob.advertiseMethod("over", &overInt);
+  ob.advertiseMethod("over", &overStr);
+  ob.advertiseMethod("twoArgs", &overTwo);
+  qi::AnyObject obj(ob.object());
+
+  for (int i = 0; i < 3; ++i)
+  {
+    // unique match on argument count: cacheable
+    EXPECT_EQ(i, obj.call<int>("twoArgs", i, 0));
+    // ambiguous on argument count, resolved from the argument types: not cached
+    EXPECT_EQ(i, obj.call<int>("over", i));
+    EXPECT_EQ("s", obj.call<std::string>("over", std::string("s")));
+    // exact signature form: cacheable
+    EXPECT_EQ(i, obj.call<int>("over::(i)", i));
+    EXPECT_ANY_THROW(obj.call<int>("twoArgs", i));
+    EXPECT_ANY_THROW(obj.call<int>("nosuchmethod", i));
+  }
+}
+
 struct YetAnotherPoint
 {
   bool operator == (const YetAnotherPoint& b) const { return x==b.x && y==b.y;}
@@ -1011,6 +1041,36 @@ TEST(TestObject, traceType)
   ASSERT_TRUE(!oa1.call<bool>("isTraceEnabled"));
 }
 
+TEST(TestObject, traceRing)
+{
+  qi::TraceRing& ring = qi::TraceRing::instance();
+  ring.setEnabled(true);
+  qi::DynamicObjectBuilder gob;
+  const auto mid = gob.advertiseMethod("add", [](int a, int b) { return a + b; });
+  qi::AnyObject obj = gob.object();
+
+  const qi::uint64_t before = ring.pushed();
+  EXPECT_EQ(5, obj.call<int>("add", 2, 3));
+  // No subscriber needed: the ring records every call.
+  EXPECT_GE(ring.pushed(), before + 2);
+  std::vector<qi::TraceRecord> records = ring.snapshot();
+  boost::optional<qi::TraceRecord> callRec;
+  boost::optional<qi::TraceRecord> resultRec;
+  for (const auto& record: records)
+  {
+    if (record.slotId != mid)
+      continue;
+    if (record.kind == qi::EventTrace::Event_Call)
+      callRec = record;
+    else if (record.kind == qi::EventTrace::Event_Result && callRec &&
+             record.id == callRec->id)
+      resultRec = record;
+  }
+  ASSERT_TRUE(callRec);
+  ASSERT_TRUE(resultRec);
+  EXPECT_LE(callRec->timestampUs, resultRec->timestampUs);
+}
+
 static void bim(int i, qi::Promise<void>& p, const std::string &name) {
   qiLogInfo() << "Bim le callback:" << name << " ,i:" << i;
   if (i == 42)
@@ -63,6 +63,7 @@ qi::AnyObject makeDynamicObjWithThreadModel(qi::ObjectThreadingModel model)
   ob.advertiseMethod("sameThread", &sameThread);
   ob.advertiseMethod("delayms", sleep);
   ob.advertiseMethod("delaymsThreadSafe", sleep, "", qi::MetaCallType_Queued);
+  ob.advertiseMethod("delaymsConcurrent", sleep, "", qi::MetaCallType_Concurrent);
   ob.advertiseMethod("delaymsFast", sleep, "", qi::MetaCallType_Direct);
   ob.advertiseSignal<RawTID>("fire");
   ob.setThreadingModel(model);
@@ -92,6 +93,7 @@ qi::AnyObject makeStaticObjWithThreadModel(EventObject &obj, qi::ObjectThreading
   ob.advertiseMethod("sameThread", &EventObject::sameThread);
   ob.advertiseMethod("delayms", &EventObject::delayms);
   ob.advertiseMethod("delaymsThreadSafe", &EventObject::delayms, qi::MetaCallType_Queued);
+  ob.advertiseMethod("delaymsConcurrent", &EventObject::delayms, qi::MetaCallType_Concurrent);
   ob.advertiseMethod("delaymsFast", &EventObject::delayms, qi::MetaCallType_Direct);
   ob.advertiseSignal("fire", &EventObject::fire);
   ob.setThreadingModel(model);
@@ -153,6 +155,29 @@ TEST(TestThreadModel, MethodModel)
   ASSERT_LT(qi::os::ustime() - start, 270000);
 }
 
+TEST(TestThreadModel, ConcurrentMethodRunsOutsideTheStrand)
+{
+  // A method tagged parallel-safe escapes the ordering of its
+  // single-threaded object: two calls overlap.
+  qi::AnyObject o1 = makeDynamicObjWithThreadModel(qi::ObjectThreadingModel_SingleThread);
+  qi::int64_t start = qi::os::ustime();
+  qi::Future<void> f1 = o1.async<void>("delaymsConcurrent", qi::MilliSeconds{ 150 });
+  o1.async<void>("delaymsConcurrent", qi::MilliSeconds{ 150 }).wait();
+  f1.wait();
+  ASSERT_LT(qi::os::ustime() - start, 270000);
+}
+
+TEST(TestThreadModelStatic, ConcurrentMethodRunsOutsideTheStrand)
+{
+  EventObject e;
+  qi::AnyObject o1 = makeStaticObjWithThreadModel(e, qi::ObjectThreadingModel_SingleThread);
+  qi::int64_t start = qi::os::ustime();
+  qi::Future<void> f1 = o1.async<void>("delaymsConcurrent", qi::MilliSeconds{ 150 });
+  o1.async<void>("delaymsConcurrent", qi::MilliSeconds{ 150 }).wait();
+  f1.wait();
+  ASSERT_LT(qi::os::ustime() - start, 270000);
+}
+
 TEST(TestThreadModelStatic, notThreadSafeObjectStatic)
 {
   new TID(boost::this_thread::get_id());
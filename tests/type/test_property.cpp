@@ -142,6 +142,30 @@ TEST(TestProperty, dispatchAssignedValue)
   test::dispatchAssignedValue<qi::Property>();
 }
 
+TEST(TestProperty, getNowServesLocalReadsSynchronously)
+{
+  qi::Property<int> property;
+  property.set(42).wait();
+  EXPECT_EQ(42, property.getNow());
+  property.set(43).wait();
+  EXPECT_EQ(43, property.getNow());
+  int seen = 0;
+  property.readNow([&seen](const int& value) { seen = value; });
+  EXPECT_EQ(43, seen);
+}
+
+TEST(TestProperty, getNowRunsTheCustomGetter)
+{
+  qi::Property<int> property{12, [](const int& storage)
+  {
+    return storage + 1;
+  }};
+  EXPECT_EQ(13, property.getNow());
+  int seen = 0;
+  property.readNow([&seen](const int& value) { seen = value; });
+  EXPECT_EQ(13, seen);
+}
+
 TEST(TestProperty, customSetter)
 {
   qi::Property<int> property{12, qi::Property<int>::Getter{}, [](int& storage, const int& value)
@@ -0,0 +1,46 @@
+#include <gtest/gtest.h>
+#include <qi/type/proxymethod.hpp>
+#include <qi/type/dynamicobjectbuilder.hpp>
+
+struct ObjectWithMethods
+{
+  int add(int a, int b)
+  {
+    return a + b;
+  }
+
+  std::string repeat(const std::string& word)
+  {
+    return word + word;
+  }
+};
+
+QI_REGISTER_OBJECT(ObjectWithMethods, add, repeat)
+
+TEST(TestProxyMethod, ResolvesAtSetupAndCalls)
+{
+  auto object = boost::make_shared<ObjectWithMethods>();
+  qi::AnyObject anyObject{object};
+  qi::ProxyMethod<int(int, int)> add{anyObject, "add"};
+  EXPECT_TRUE(add.isResolved());
+  EXPECT_EQ(5, add(2, 3));
+}
+
+TEST(TestProxyMethod, AsyncCall)
+{
+  auto object = boost::make_shared<ObjectWithMethods>();
+  qi::AnyObject anyObject{object};
+  qi::ProxyMethod<std::string(std::string)> repeat{anyObject, "repeat"};
+  EXPECT_EQ("abab", repeat.async("ab").value());
+}
+
+TEST(TestProxyMethod, UnresolvedFallsBackToNameLookup)
+{
+  auto object = boost::make_shared<ObjectWithMethods>();
+  qi::AnyObject anyObject{object};
+  // float does not match the registered int overload exactly, so the proxy
+  // falls back to per-call resolution by name, which converts the arguments.
+  qi::ProxyMethod<int(float, float)> add{anyObject, "add"};
+  EXPECT_FALSE(add.isResolved());
+  EXPECT_EQ(5, add(2.f, 3.f));
+}
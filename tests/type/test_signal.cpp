@@ -14,6 +14,7 @@
 #include <qi/application.hpp>
 #include <qi/type/objecttypebuilder.hpp>
 #include <qi/type/dynamicobjectbuilder.hpp>
+#include <atomic>
 #include <future>
 
 qiLogCategory("test");
@@ -221,6 +222,24 @@ TEST(TestSignal, FunctionDestroyedOnDisconnection)
 }
 
 
+TEST(TestSignal, TombstonedSubscriberSkippedAndReclaimedOnEmit)
+{
+  // With several subscribers, disconnection leaves a disabled tombstone in
+  // the emit snapshot; the next emit must skip it and release its handler.
+  std::atomic<int> calls{0};
+  std::atomic<bool> destroyed{false};
+  std::shared_ptr<int> sharedInt{new int{42}, [&](int* i){ delete i; destroyed = true; }};
+  qi::Signal<void> signal;
+  signal.connect([&]{ ++calls; }).setCallType(qi::MetaCallType_Direct);
+  qi::SignalLink link =
+      signal.connect([sharedInt]{ ADD_FAILURE() << "disconnected subscriber called"; });
+  sharedInt.reset();
+  signal.disconnect(link);
+  QI_EMIT signal();
+  EXPECT_EQ(1, calls);
+  EXPECT_TRUE(destroyed);
+}
+
 TEST(TestSignal, DisconnectLinkRegistrationCheck)
 {
   qi::Signal<void> signal1;
@@ -555,6 +574,60 @@ TEST(TestSignal, WithExecutionContext)
   ASSERT_TRUE(prom.future().value());
 }
 
+namespace
+{
+std::atomic<int> copyTallyCopies{0};
+
+struct CopyTally
+{
+  CopyTally() = default;
+  CopyTally(const CopyTally& o)
+    : value(o.value)
+  {
+    ++copyTallyCopies;
+  }
+  CopyTally& operator=(const CopyTally& o)
+  {
+    value = o.value;
+    ++copyTallyCopies;
+    return *this;
+  }
+  int value = 0;
+};
+} // anonymous
+
+QI_TYPE_STRUCT_REGISTER(CopyTally, value);
+
+namespace
+{
+int copiesPerEmit(int subscriberCount)
+{
+  qi::Signal<CopyTally> sig;
+  std::vector<qi::Promise<void>> delivered(subscriberCount);
+  for (int i = 0; i != subscriberCount; ++i)
+  {
+    qi::Promise<void> done = delivered[i];
+    sig.connect([done](const CopyTally&) mutable { done.setValue(0); })
+       .setCallType(qi::MetaCallType_Queued);
+  }
+  copyTallyCopies = 0;
+  QI_EMIT sig(CopyTally{});
+  for (int i = 0; i != subscriberCount; ++i)
+    EXPECT_EQ(qi::FutureState_FinishedWithValue, delivered[i].future().wait(usualTimeout));
+  return copyTallyCopies.load();
+}
+} // anonymous
+
+TEST(TestSignal, QueuedSubscribersShareOneArgumentCopy)
+{
+  // Queued delivery snapshots the arguments into a single shared immutable
+  // pack that every posted invocation references, so fanning out to more
+  // subscribers must not add copies of the arguments.
+  const int forOne = copiesPerEmit(1);
+  const int forMany = copiesPerEmit(8);
+  EXPECT_EQ(forOne, forMany);
+}
+
 // ===========================================================
 // Signal Spy
 // -----------------------------------------------------------
@@ -639,6 +712,52 @@ TEST(TestSignalSpy, StoringTypedValueRecords)
   }
 }
 
+TEST(TestSignalSpy, RingRecording)
+{
+  qi::Signal<int> sig;
+  qi::SignalSpy spy(sig, qi::SignalSpy::RingRecording{4});
+
+  // Emissions are recorded synchronously from the emitter's context.
+  for (int i = 0; i < 10; ++i)
+    QI_EMIT sig(i);
+  ASSERT_EQ(10u, spy.recordCount());
+
+  // Only the last `slots` emissions are retained, oldest first.
+  auto records = spy.allRecords();
+  ASSERT_EQ(4u, records.size());
+  for (auto i = 0u; i < records.size(); ++i)
+    EXPECT_EQ(6 + static_cast<int>(i), records[i].arg<int>(0));
+  EXPECT_EQ(9, spy.lastRecord().arg<int>(0));
+  EXPECT_EQ(7, spy.record(1).arg<int>(0));
+  EXPECT_LE(records.front().timestamp, records.back().timestamp);
+}
+
+TEST(TestSignalSpy, RingRecordingDroppingValues)
+{
+  qi::Signal<int> sig;
+  qi::SignalSpy spy(sig, qi::SignalSpy::RingRecording{8, false});
+  for (int i = 0; i < 5; ++i)
+    QI_EMIT sig(i);
+  ASSERT_EQ(5u, spy.recordCount());
+  auto records = spy.allRecords();
+  ASSERT_EQ(5u, records.size());
+  // Count and timestamps only: the arguments were never copied.
+  for (const auto& record: records)
+    EXPECT_TRUE(record.args.empty());
+}
+
+TEST(TestSignalSpy, RingRecordingTypeErased)
+{
+  qi::Signal<int> sig;
+  qi::DynamicObjectBuilder ob;
+  ob.advertiseSignal("signal", &sig);
+  qi::AnyObject obj(ob.object());
+  qi::SignalSpy spy(obj, "signal", qi::SignalSpy::RingRecording{4});
+  QI_EMIT sig(42);
+  ASSERT_TRUE(spy.waitUntil(1, usualTimeout).value());
+  EXPECT_EQ(42, spy.lastRecord().arg<int>(0));
+}
+
 TEST(TestSignalSpy, WaitUntilCanBeCancelled)
 {
   qi::Signal<bool> sig;
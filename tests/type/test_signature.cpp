@@ -18,6 +18,7 @@
 #include <qi/signature.hpp>
 #include <qi/anyvalue.hpp>
 #include <qi/jsoncodec.hpp>
+#include <qi/type/detail/staticsignature.hpp>
 
 #include <vector>
 #include <map>
@@ -738,3 +739,28 @@ TEST(TestSignatureIterator, Empty) {
 
 
 //#endif
+
+TEST(TestSignature, StaticSignature) {
+  using qi::detail::staticSignature;
+  using qi::detail::HasStaticSignature;
+
+  // compile-time strings match what the runtime type system computes
+  EXPECT_STREQ("i", staticSignature<qi::int32_t>());
+  EXPECT_STREQ("b", staticSignature<bool>());
+  using ComplexType = std::map<std::string, std::vector<std::pair<qi::uint64_t, double> > >;
+  EXPECT_STREQ("{s[(Ld)]}", staticSignature<ComplexType>());
+  EXPECT_EQ(qi::typeOf<ComplexType>()->signature().toString(),
+            staticSignature<ComplexType>());
+  EXPECT_STREQ("+[s]", staticSignature<boost::optional<std::vector<std::string> > >());
+  EXPECT_STREQ("m", staticSignature<qi::AnyValue>());
+
+  // static storage: the same pointer on every call
+  EXPECT_EQ(staticSignature<ComplexType>(), staticSignature<ComplexType>());
+
+  // unregistered types keep the runtime path
+  struct NotInTheTypeSystem {};
+  static_assert(!qi::detail::HasStaticSignature<NotInTheTypeSystem>::value,
+                "unregistered structs have no compile-time signature");
+  static_assert(qi::detail::HasStaticSignature<std::vector<float> >::value,
+                "vector of float has a compile-time signature");
+}
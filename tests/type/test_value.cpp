@@ -197,6 +197,46 @@ TEST(Value, Map)
   ASSERT_ANY_THROW(v.append("foo"));
 }
 
+TEST(Value, MapInsertAtEnd)
+{
+  std::map<std::string, double> map;
+  AutoAnyReference v(map);
+  // in key order, the common case (deserializing a sorted wire image)
+  v.insertAtEnd(AnyValue::from("aaa").asReference(), AnyValue::from(1).asReference());
+  v.insertAtEnd(AnyValue::from("bbb").asReference(), AnyValue::from(2).asReference());
+  v.insertAtEnd(AnyValue::from("ccc").asReference(), AnyValue::from(3).asReference());
+  // wrong hint: still lands at the right place
+  v.insertAtEnd(AnyValue::from("abc").asReference(), AnyValue::from(4).asReference());
+  // existing key: overwrites, like insert()
+  v.insertAtEnd(AnyValue::from("bbb").asReference(), AnyValue::from(5).asReference());
+  ASSERT_EQ(4u, v.size());
+  ASSERT_EQ(1, v["aaa"].toInt());
+  ASSERT_EQ(4, v["abc"].toInt());
+  ASSERT_EQ(5, v["bbb"].toInt());
+  ASSERT_EQ(3, v["ccc"].toInt());
+  ASSERT_EQ(4u, map.size());
+  ASSERT_EQ(5, map["bbb"]);
+}
+
+TEST(Value, Reserve)
+{
+  std::vector<int> vec;
+  AutoAnyReference v(vec);
+  v.reserve(100);
+  ASSERT_LE(100u, vec.capacity());
+  v.append(42);
+  ASSERT_EQ(1u, v.size());
+
+  // only a hint: containers without reserve() accept it silently
+  std::map<std::string, double> map;
+  AutoAnyReference m(map);
+  m.reserve(100);
+  ASSERT_EQ(0u, m.size());
+
+  AutoAnyReference i(42);
+  ASSERT_ANY_THROW(i.reserve(10));
+}
+
 TEST(Value, Map_at)
 {
   std::map<std::string, double> map;
@@ -1220,3 +1260,31 @@ TYPED_TEST(TypedAutoAnyReference, AutoAnyReferenceFromValueSharesItsType)
   AutoAnyReference autoRef{ TypeParam{} };
   EXPECT_EQ(typeOf<TypeParam>()->kind(), autoRef.kind());
 }
+
+TEST(Value, StorageArenaScopedValuesMayOutliveTheScope)
+{
+  qi::AnyValue escaped;
+  {
+    qi::detail::ScopedStorageArena arena;
+    qi::AnyValue inside = qi::AnyValue::from(42);
+    EXPECT_EQ(42, inside.to<int>());
+    // Copies made inside the scope draw from the same arena and may
+    // legitimately escape it, as queued call arguments do.
+    escaped = inside;
+  }
+  EXPECT_EQ(42, escaped.to<int>());
+  escaped.reset();
+
+  { // Nested scopes restore the outer arena on exit.
+    qi::detail::ScopedStorageArena outer;
+    qi::AnyValue a = qi::AnyValue::from(1);
+    {
+      qi::detail::ScopedStorageArena inner;
+      qi::AnyValue b = qi::AnyValue::from(2);
+      EXPECT_EQ(2, b.to<int>());
+    }
+    qi::AnyValue c = qi::AnyValue::from(3);
+    EXPECT_EQ(1, a.to<int>());
+    EXPECT_EQ(3, c.to<int>());
+  }
+}
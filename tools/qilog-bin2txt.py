@@ -0,0 +1,102 @@
+#!/usr/bin/env python
+"""Render a qi::log::BinaryLogHandler file as text.
+
+The input is a stream of fixed-layout binary records written in the
+producer's byte order (see src/binaryloghandler.cpp):
+
+  File header:   char[4] magic "QILG", uint16 version (1), uint16 reserved.
+  Category def:  uint8 type (0), uint32 id, uint16 nameLen, name bytes.
+  Log record:    uint8 type (1), uint8 level, uint32 categoryId,
+                 uint32 threadId, int32 line, int64 dateNs,
+                 int64 systemDateNs, uint32 msgLen, msg bytes.
+
+Usage: qilog-bin2txt.py [--big-endian] file.qilog [...]
+"""
+
+from __future__ import print_function
+
+import datetime
+import struct
+import sys
+
+MAGIC = b"QILG"
+VERSION = 1
+
+LEVELS = ["silent", "fatal", "error", "warning", "info", "verbose", "debug"]
+
+
+def level_name(level):
+    if 0 <= level < len(LEVELS):
+        return LEVELS[level]
+    return str(level)
+
+
+def read_exactly(f, n):
+    data = f.read(n)
+    if len(data) != n:
+        raise EOFError("truncated record")
+    return data
+
+
+def dump(path, endian):
+    categories = {}
+    with open(path, "rb") as f:
+        header = read_exactly(f, 8)
+        if header[:4] != MAGIC:
+            raise ValueError("%s: not a qilog binary file" % path)
+        version = struct.unpack(endian + "H", header[4:6])[0]
+        if version != VERSION:
+            raise ValueError("%s: unsupported version %d" % (path, version))
+        while True:
+            rtype = f.read(1)
+            if not rtype:
+                return  # clean end of file
+            rtype = ord(rtype)
+            if rtype == 0:  # category definition
+                cat_id, name_len = struct.unpack(
+                    endian + "IH", read_exactly(f, 6))
+                categories[cat_id] = read_exactly(f, name_len).decode(
+                    "utf-8", "replace")
+            elif rtype == 1:  # log record
+                (level, cat_id, tid, line, date_ns, system_ns,
+                 msg_len) = struct.unpack(
+                    endian + "BIIiqqI", read_exactly(f, 33))
+                msg = read_exactly(f, msg_len).decode("utf-8", "replace")
+                date = datetime.datetime.fromtimestamp(system_ns / 1e9)
+                print("%s %s.%06d %d %s: %s" % (
+                    level_name(level).ljust(7),
+                    date.strftime("%Y-%m-%d %H:%M:%S"),
+                    date.microsecond,
+                    tid,
+                    categories.get(cat_id, "category#%d" % cat_id),
+                    msg.rstrip("\n")))
+            else:
+                raise ValueError("%s: unknown record type %d (corrupt file?)"
+                                 % (path, rtype))
+
+
+def main(argv):
+    endian = "<"
+    args = []
+    for arg in argv[1:]:
+        if arg == "--big-endian":
+            endian = ">"
+        elif arg in ("-h", "--help"):
+            print(__doc__)
+            return 0
+        else:
+            args.append(arg)
+    if not args:
+        print(__doc__, file=sys.stderr)
+        return 1
+    for path in args:
+        try:
+            dump(path, endian)
+        except (ValueError, EOFError) as e:
+            print("error: %s" % e, file=sys.stderr)
+            return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
@@ -0,0 +1,177 @@
+/*
+**  Copyright (C) 2026 Softbank Robotics
+**  See COPYING for the license
+*/
+
+/* qitop: live per-method statistics for a running session.
+ *
+ * Attaches to a service directory, enables the Manageable statistics
+ * gathering on every service, then periodically polls stats() and
+ * clearStats() to render a top-style view: calls per second, mean/max
+ * wall time, and CPU usage per method, sorted by the wall time spent in
+ * the last interval. Services appearing or vanishing while the tool runs
+ * are picked up on the next refresh.
+ *
+ * Usage: qitop [--qi-url tcp://host:port] [interval-seconds]
+ */
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <qi/anyobject.hpp>
+#include <qi/applicationsession.hpp>
+#include <qi/log.hpp>
+#include <qi/session.hpp>
+
+qiLogCategory("qitop");
+
+namespace
+{
+  struct Row
+  {
+    std::string method;    // "Service.method"
+    float       callsPerSec;
+    float       wallMeanMs;
+    float       wallMaxMs;
+    float       cpuPercent; // (user + system) time over the interval
+    float       wallSum;    // sort key: wall time spent in the interval
+  };
+
+  bool byTimeSpent(const Row& a, const Row& b)
+  {
+    return a.wallSum > b.wallSum;
+  }
+
+  std::string methodName(const qi::AnyObject& obj, unsigned int slotId)
+  {
+    const qi::MetaMethod* mm = obj.metaObject().method(slotId);
+    if (mm)
+      return mm->name();
+    std::ostringstream ss;
+    ss << '#' << slotId;
+    return ss.str();
+  }
+
+  void render(const std::vector<Row>& rows, unsigned int serviceCount)
+  {
+    // Home the cursor and clear to the end so the table repaints in place.
+    std::cout << "\x1b[H\x1b[J";
+    std::cout << "qitop - " << serviceCount << " services, "
+              << rows.size() << " active methods\n\n";
+    std::cout << std::left << std::setw(48) << "METHOD"
+              << std::right << std::setw(10) << "CALLS/S"
+              << std::setw(12) << "MEAN(ms)"
+              << std::setw(12) << "MAX(ms)"
+              << std::setw(8) << "CPU%" << '\n';
+    const size_t maxRows = 40;
+    for (size_t i = 0; i < rows.size() && i < maxRows; ++i)
+    {
+      const Row& r = rows[i];
+      std::cout << std::left << std::setw(48) << r.method
+                << std::right << std::fixed
+                << std::setprecision(1) << std::setw(10) << r.callsPerSec
+                << std::setprecision(3) << std::setw(12) << r.wallMeanMs
+                << std::setw(12) << r.wallMaxMs
+                << std::setprecision(1) << std::setw(8) << r.cpuPercent
+                << '\n';
+    }
+    std::cout.flush();
+  }
+}
+
+int main(int argc, char** argv)
+{
+  qi::ApplicationSession app(argc, argv);
+
+  float interval = 1.0f;
+  if (argc > 1)
+  {
+    interval = strtof(argv[1], NULL);
+    if (interval <= 0.0f)
+    {
+      std::cerr << "Usage: qitop [--qi-url tcp://host:port] [interval-seconds]" << std::endl;
+      return 1;
+    }
+  }
+
+  try
+  {
+    app.startSession();
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << "Could not connect to " << app.url().str() << ": " << e.what() << std::endl;
+    return 1;
+  }
+  qi::SessionPtr session = app.session();
+
+  // Services we already switched to stats mode; newcomers get enabled as
+  // they appear, so restarting services keep being profiled.
+  std::set<std::string> profiled;
+
+  while (true)
+  {
+    std::vector<qi::ServiceInfo> services;
+    try
+    {
+      services = session->services().value();
+    }
+    catch (const std::exception& e)
+    {
+      std::cerr << "Lost the service directory: " << e.what() << std::endl;
+      return 1;
+    }
+
+    std::vector<Row> rows;
+    for (const auto& info: services)
+    {
+      qi::AnyObject obj;
+      try
+      {
+        obj = session->service(info.name()).value();
+        if (profiled.find(info.name()) == profiled.end())
+        {
+          obj.call<void>("enableStats", true);
+          obj.call<void>("clearStats");
+          profiled.insert(info.name());
+          continue; // first full interval starts now
+        }
+        auto stats = obj.call<qi::ObjectStatistics>("stats");
+        obj.call<void>("clearStats");
+        for (const auto& slot: stats)
+        {
+          const qi::MethodStatistics& ms = slot.second;
+          if (ms.count() == 0)
+            continue;
+          Row row;
+          row.method = info.name() + "." + methodName(obj, slot.first);
+          row.callsPerSec = ms.count() / interval;
+          row.wallSum = ms.wall().cumulatedValue();
+          row.wallMeanMs = row.wallSum / ms.count() * 1000.0f;
+          row.wallMaxMs = ms.wall().maxValue() * 1000.0f;
+          row.cpuPercent = (ms.user().cumulatedValue() + ms.system().cumulatedValue())
+            / interval * 100.0f;
+          rows.push_back(row);
+        }
+      }
+      catch (const std::exception& e)
+      {
+        // The service went away or does not expose stats; drop it and
+        // retry the activation if it comes back.
+        qiLogVerbose() << "Skipping " << info.name() << ": " << e.what();
+        profiled.erase(info.name());
+      }
+    }
+
+    std::sort(rows.begin(), rows.end(), &byTimeSpent);
+    render(rows, static_cast<unsigned int>(services.size()));
+    std::this_thread::sleep_for(
+      std::chrono::milliseconds(static_cast<int>(interval * 1000.0f)));
+  }
+}